@@ -0,0 +1,28 @@
+// Alignment helpers
+
+#pragma once
+
+#include <cstdint>
+
+template<typename T>
+inline bool IsPowerOfTwo(T value)
+{
+	return value != 0 && (value & (value - 1)) == 0;
+}
+
+// Rounds value up to a multiple of alignment, which must be a power of two
+// e.g. AlignUp(300, 256)
+// = (300 + 255) & ~255
+// = 0x022B & 0xFF00
+// = 0x0200 = 512 (the smallest multiple of 256 above 300)
+template<typename T>
+inline T AlignUp(T value, T alignment)
+{
+	return (value + (alignment - 1)) & ~(alignment - 1);
+}
+
+template<typename T>
+inline T AlignDown(T value, T alignment)
+{
+	return value & ~(alignment - 1);
+}
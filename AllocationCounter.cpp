@@ -0,0 +1,84 @@
+#include "AllocationCounter.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+	std::atomic<uint64_t> gAllocations(0);
+	std::atomic<uint64_t> gAllocatedBytes(0);
+
+	void* CountedAllocate(size_t size)
+	{
+		gAllocations.fetch_add(1, std::memory_order_relaxed);
+		gAllocatedBytes.fetch_add(size, std::memory_order_relaxed);
+
+		// malloc(0) may return null, but new must return a unique pointer
+		return malloc(size > 0 ? size : 1);
+	}
+}
+
+// Totals since the program started
+AllocationCounts GetAllocationCounts()
+{
+	AllocationCounts counts;
+	counts.allocations = gAllocations.load(std::memory_order_relaxed);
+	counts.bytes = gAllocatedBytes.load(std::memory_order_relaxed);
+	return counts;
+}
+
+void* operator new(size_t size)
+{
+	void* memory = CountedAllocate(size);
+	if (memory == nullptr)
+	{
+		throw std::bad_alloc();
+	}
+	return memory;
+}
+
+void* operator new[](size_t size)
+{
+	return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+	return CountedAllocate(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+	return CountedAllocate(size);
+}
+
+void operator delete(void* memory) noexcept
+{
+	free(memory);
+}
+
+void operator delete[](void* memory) noexcept
+{
+	free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept
+{
+	free(memory);
+}
+
+void operator delete[](void* memory, size_t) noexcept
+{
+	free(memory);
+}
+
+void operator delete(void* memory, const std::nothrow_t&) noexcept
+{
+	free(memory);
+}
+
+void operator delete[](void* memory, const std::nothrow_t&) noexcept
+{
+	free(memory);
+}
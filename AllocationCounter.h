@@ -0,0 +1,16 @@
+// Heap allocation counting
+// The global operator new and delete are replaced (in AllocationCounter.cpp) so every heap
+// allocation made through them is counted. Used to track allocations per frame.
+
+#pragma once
+
+#include <cstdint>
+
+struct AllocationCounts
+{
+	uint64_t allocations;
+	uint64_t bytes;
+};
+
+// Totals since the program started
+AllocationCounts GetAllocationCounts();
@@ -0,0 +1,277 @@
+#include "AssetArchive.h"
+#include "Compression.h"
+
+#if defined(_WIN32)
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <Windows.h>
+#else
+#include "NativePath.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <cstring>
+
+namespace
+{
+	// mFile when no file is open
+#if defined(_WIN32)
+	void* const NoFile = INVALID_HANDLE_VALUE;
+#else
+	void* const NoFile = nullptr;
+#endif
+
+	// The archive the loose-file loaders look in first, and the normalised directory its paths
+	// are relative to
+	const AssetArchive* gMountedArchive = nullptr;
+	std::string gMountedRoot;
+}
+
+AssetArchive::AssetArchive() :
+	mFile(NoFile),
+	mMapping(nullptr),
+	mView(nullptr),
+	mViewSize(0),
+	mHeader(nullptr),
+	mSlots(nullptr),
+	mStrings(nullptr)
+{
+}
+
+AssetArchive::~AssetArchive()
+{
+	Close();
+}
+
+// Maps an archive. Returns false if it doesn't exist or isn't a valid archive.
+bool AssetArchive::Open(const std::wstring& path)
+{
+	Close();
+
+#if defined(_WIN32)
+	CREATEFILE2_EXTENDED_PARAMETERS extendedParams = {};
+	extendedParams.dwSize = sizeof(CREATEFILE2_EXTENDED_PARAMETERS);
+	extendedParams.dwFileAttributes = FILE_ATTRIBUTE_NORMAL;
+	extendedParams.dwFileFlags = FILE_FLAG_RANDOM_ACCESS;
+	extendedParams.dwSecurityQosFlags = SECURITY_ANONYMOUS;
+
+	mFile = CreateFile2(path.c_str(), GENERIC_READ, FILE_SHARE_READ, OPEN_EXISTING, &extendedParams);
+	if (mFile == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(mFile, &fileSize) || static_cast<uint64_t>(fileSize.QuadPart) < sizeof(ArchiveHeader))
+	{
+		Close();
+		return false;
+	}
+
+	mMapping = CreateFileMappingW(mFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mMapping == nullptr)
+	{
+		Close();
+		return false;
+	}
+
+	mView = static_cast<const uint8_t*>(MapViewOfFile(mMapping, FILE_MAP_READ, 0, 0, 0));
+	mViewSize = static_cast<uint64_t>(fileSize.QuadPart);
+	if (mView == nullptr)
+	{
+		Close();
+		return false;
+	}
+#else
+	const int file = open(ToNativePath(path).c_str(), O_RDONLY | O_CLOEXEC);
+	if (file < 0)
+	{
+		return false;
+	}
+
+	struct stat status;
+	if (fstat(file, &status) != 0 || static_cast<uint64_t>(status.st_size) < sizeof(ArchiveHeader))
+	{
+		close(file);
+		return false;
+	}
+
+	void* view = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+	close(file);
+	if (view == MAP_FAILED)
+	{
+		return false;
+	}
+
+	mView = static_cast<const uint8_t*>(view);
+	mViewSize = static_cast<uint64_t>(status.st_size);
+#endif
+
+	// Validate the header and that the tables lie within the file
+	mHeader = reinterpret_cast<const ArchiveHeader*>(mView);
+	const uint64_t tocSize = static_cast<uint64_t>(mHeader->tocSlotCount) * sizeof(ArchiveEntry);
+	const bool slotCountValid = mHeader->tocSlotCount != 0 && (mHeader->tocSlotCount & (mHeader->tocSlotCount - 1)) == 0;
+
+	if (mHeader->magic != ArchiveMagic || mHeader->version != ArchiveVersion || !slotCountValid ||
+		mHeader->tocOffset + tocSize > mViewSize ||
+		mHeader->stringsOffset + mHeader->stringsSize > mViewSize)
+	{
+		Close();
+		return false;
+	}
+
+	mSlots = reinterpret_cast<const ArchiveEntry*>(mView + mHeader->tocOffset);
+	mStrings = reinterpret_cast<const char*>(mView + mHeader->stringsOffset);
+	return true;
+}
+
+void AssetArchive::Close()
+{
+#if defined(_WIN32)
+	if (mView != nullptr)
+	{
+		UnmapViewOfFile(mView);
+	}
+	if (mMapping != nullptr)
+	{
+		CloseHandle(mMapping);
+	}
+	if (mFile != INVALID_HANDLE_VALUE)
+	{
+		CloseHandle(mFile);
+	}
+#else
+	if (mView != nullptr)
+	{
+		munmap(const_cast<uint8_t*>(mView), static_cast<size_t>(mViewSize));
+	}
+#endif
+
+	mFile = NoFile;
+	mMapping = nullptr;
+	mView = nullptr;
+	mViewSize = 0;
+	mHeader = nullptr;
+	mSlots = nullptr;
+	mStrings = nullptr;
+}
+
+// Finds an entry by path, returns nullptr if it isn't in the archive
+const ArchiveEntry* AssetArchive::Find(const std::wstring& path) const
+{
+	return FindNormalised(NormaliseArchivePath(path));
+}
+
+const ArchiveEntry* AssetArchive::FindNormalised(const std::string& normalisedPath) const
+{
+	if (!IsOpen())
+	{
+		return nullptr;
+	}
+
+	const uint64_t hash = HashArchivePath(normalisedPath);
+	const uint32_t mask = mHeader->tocSlotCount - 1;
+
+	// Linear probing - the table is at most half full so an empty slot is always reached
+	for (uint32_t slot = static_cast<uint32_t>(hash) & mask, probes = 0;
+		probes <= mask;
+		slot = (slot + 1) & mask, probes++)
+	{
+		const ArchiveEntry& entry = mSlots[slot];
+		if ((entry.flags & ArchiveEntry_Used) == 0)
+		{
+			return nullptr;
+		}
+
+		// Compare the path too in case two paths share a hash
+		if (entry.pathHash == hash &&
+			entry.pathLength == normalisedPath.size() &&
+			entry.pathOffset + static_cast<uint64_t>(entry.pathLength) <= mHeader->stringsSize &&
+			memcmp(mStrings + entry.pathOffset, normalisedPath.data(), entry.pathLength) == 0)
+		{
+			return &entry;
+		}
+	}
+
+	return nullptr;
+}
+
+// Returns the entry's data in the mapped view, or nullptr if the entry is compressed
+const uint8_t* AssetArchive::GetMappedData(const ArchiveEntry& entry) const
+{
+	if ((entry.flags & ArchiveEntry_Compressed) != 0 || entry.offset + entry.storedSize > mViewSize)
+	{
+		return nullptr;
+	}
+
+	return mView + entry.offset;
+}
+
+// Copies or decompresses an entry's data
+bool AssetArchive::Read(const ArchiveEntry& entry, std::vector<uint8_t>& data) const
+{
+	data.resize(static_cast<size_t>(entry.size));
+	return Read(entry, data.data(), data.size());
+}
+
+// As above, into a buffer of the entry's size
+bool AssetArchive::Read(const ArchiveEntry& entry, uint8_t* data, size_t size) const
+{
+	if (!IsOpen() || entry.offset + entry.storedSize > mViewSize || size != entry.size)
+	{
+		return false;
+	}
+
+	const uint8_t* stored = mView + entry.offset;
+	if ((entry.flags & ArchiveEntry_Compressed) == 0)
+	{
+		if (entry.storedSize != entry.size)
+		{
+			return false;
+		}
+		if (size > 0)
+		{
+			memcpy(data, stored, size);
+		}
+		return true;
+	}
+
+	return DecompressLZ(stored, static_cast<size_t>(entry.storedSize), data, size);
+}
+
+// Mounts an archive over the directory its paths are relative to (or unmounts with null).
+// Must be done before any loading starts, and the archive must stay open while mounted.
+void MountAssetArchive(const AssetArchive* archive, const std::wstring& root)
+{
+	gMountedArchive = archive;
+	gMountedRoot = archive != nullptr ? NormaliseArchivePath(root) : std::string();
+	if (!gMountedRoot.empty() && gMountedRoot.back() != '/')
+	{
+		gMountedRoot += '/';
+	}
+}
+
+// Finds a file by its full path in the mounted archive. Returns nullptr if nothing is mounted,
+// the path isn't under the archive's root or the archive doesn't hold it.
+const ArchiveEntry* FindMountedAsset(const std::wstring& path, const AssetArchive** archive)
+{
+	if (gMountedArchive == nullptr || !gMountedArchive->IsOpen())
+	{
+		return nullptr;
+	}
+
+	// Compared normalised, so differences in case and slashes don't matter
+	const std::string normalisedPath = NormaliseArchivePath(path);
+	if (normalisedPath.compare(0, gMountedRoot.size(), gMountedRoot) != 0)
+	{
+		return nullptr;
+	}
+
+	*archive = gMountedArchive;
+	return gMountedArchive->FindNormalised(normalisedPath.substr(gMountedRoot.size()));
+}
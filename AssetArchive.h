@@ -0,0 +1,69 @@
+// Read-only access to a packed asset archive
+// The archive is memory mapped (a Win32 file mapping on Windows, mmap elsewhere), lookups go
+// through the hashed table of contents, and uncompressed entries can be used in place without
+// copying.
+//
+// An archive can be mounted over a directory, so the loose-file loaders (ReadDataFromFile and
+// those built on it) read anything it holds from it instead, without their callers changing.
+
+#pragma once
+
+#include "AssetArchiveFormat.h"
+
+#include <string>
+#include <vector>
+
+class AssetArchive
+{
+public:
+	// Constructor
+	AssetArchive();
+
+	// Prohibit copying
+	AssetArchive(const AssetArchive& rhs) = delete;
+	AssetArchive& operator=(const AssetArchive& rhs) = delete;
+
+	// Destructor
+	~AssetArchive();
+
+	// Maps an archive. Returns false if it doesn't exist or isn't a valid archive.
+	bool Open(const std::wstring& path);
+	void Close();
+
+	bool IsOpen() const { return mView != nullptr; }
+
+	// Finds an entry by path, returns nullptr if it isn't in the archive
+	const ArchiveEntry* Find(const std::wstring& path) const;
+	const ArchiveEntry* FindNormalised(const std::string& normalisedPath) const;
+
+	// Returns the entry's data in the mapped view, or nullptr if the entry is compressed.
+	// Valid until the archive is closed.
+	const uint8_t* GetMappedData(const ArchiveEntry& entry) const;
+
+	// Copies or decompresses an entry's data
+	bool Read(const ArchiveEntry& entry, std::vector<uint8_t>& data) const;
+
+	// As above, into a buffer of the entry's size
+	bool Read(const ArchiveEntry& entry, uint8_t* data, size_t size) const;
+
+	// Getters
+	uint32_t GetEntryCount() const { return IsOpen() ? mHeader->entryCount : 0; }
+
+private:
+	void* mFile;	// HANDLEs on Windows, kept as void* so this header doesn't need Windows.h.
+	void* mMapping;	// Unused elsewhere, as mmap keeps its own reference to the file.
+	const uint8_t* mView;
+	uint64_t mViewSize;
+
+	const ArchiveHeader* mHeader;
+	const ArchiveEntry* mSlots;
+	const char* mStrings;
+};
+
+// Mounts an archive over the directory its paths are relative to (or unmounts with null).
+// Must be done before any loading starts, and the archive must stay open while mounted.
+void MountAssetArchive(const AssetArchive* archive, const std::wstring& root);
+
+// Finds a file by its full path in the mounted archive. Returns nullptr if nothing is mounted,
+// the path isn't under the archive's root or the archive doesn't hold it.
+const ArchiveEntry* FindMountedAsset(const std::wstring& path, const AssetArchive** archive);
@@ -0,0 +1,101 @@
+// On-disk layout of packed asset archives (.pak), shared by the reader and the packer tool
+//
+// [ArchiveHeader]
+// [ArchiveEntry x tocSlotCount]	Open-addressed hash table keyed on the normalised path
+// [Path strings]					UTF-8, not null terminated
+// [Entry data...]					Each entry starts on a DataAlignment boundary
+
+#pragma once
+
+#include "Align.h"
+#include "Hash.h"
+
+#include <cstdint>
+#include <string>
+
+static const uint32_t ArchiveMagic = 0x4B41504D; // "MPAK"
+static const uint32_t ArchiveVersion = 1;
+
+// Entry data is page aligned so uncompressed entries can be used straight from a mapped view
+static const uint64_t ArchiveDataAlignment = 4096;
+
+enum EArchiveEntryFlags
+{
+	ArchiveEntry_Used = 0x1,		// Slot holds an entry
+	ArchiveEntry_Compressed = 0x2	// Data is LZ compressed, otherwise stored as is
+};
+
+struct ArchiveHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t entryCount;
+	uint32_t tocSlotCount;		// Always a power of two
+	uint64_t tocOffset;
+	uint64_t stringsOffset;
+	uint64_t stringsSize;
+	uint64_t dataOffset;
+};
+
+struct ArchiveEntry
+{
+	uint64_t pathHash;
+	uint64_t offset;			// From the start of the archive
+	uint64_t storedSize;		// Size in the archive
+	uint64_t size;				// Uncompressed size
+	uint32_t pathOffset;		// Into the string table
+	uint32_t pathLength;
+	uint32_t flags;
+	uint32_t reserved;
+};
+
+static_assert(sizeof(ArchiveHeader) == 48, "ArchiveHeader layout changed");
+static_assert(sizeof(ArchiveEntry) == 48, "ArchiveEntry layout changed");
+
+// Archive paths are lowercase UTF-8 with forward slashes, so lookups don't depend on
+// how the caller spelt the path
+inline std::string NormaliseArchivePath(const std::wstring& path)
+{
+	std::string result;
+	result.reserve(path.size());
+
+	for (wchar_t c : path)
+	{
+		const uint32_t code = static_cast<uint32_t>(c);
+		if (c == L'\\')
+		{
+			result += '/';
+		}
+		else if (code < 0x80)
+		{
+			result += static_cast<char>(c >= L'A' && c <= L'Z' ? c - L'A' + L'a' : c);
+		}
+		else if (code < 0x800)
+		{
+			result += static_cast<char>(0xC0 | (code >> 6));
+			result += static_cast<char>(0x80 | (code & 0x3F));
+		}
+		else
+		{
+			result += static_cast<char>(0xE0 | ((code >> 12) & 0x0F));
+			result += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+			result += static_cast<char>(0x80 | (code & 0x3F));
+		}
+	}
+
+	// Leading slashes would make the same file hash differently
+	const size_t firstChar = result.find_first_not_of('/');
+	return firstChar == std::string::npos ? std::string() : result.substr(firstChar);
+}
+
+// Hash used for the table of contents. Never returns 0 so it can't be mistaken for an empty slot.
+inline uint64_t HashArchivePath(const std::string& normalisedPath)
+{
+	const uint64_t hash = HashBytes(normalisedPath.data(), normalisedPath.size());
+	return hash != 0 ? hash : 1;
+}
+
+inline uint64_t AlignArchiveOffset(uint64_t offset)
+{
+	return AlignUp(offset, ArchiveDataAlignment);
+}
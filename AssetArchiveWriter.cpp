@@ -0,0 +1,128 @@
+#include "AssetArchiveWriter.h"
+#include "Compression.h"
+
+#include <cstring>
+
+const float AssetArchiveWriter::MinCompressionRatio = 0.9f;
+
+AssetArchiveWriter::AssetArchiveWriter() :
+	mUncompressedBytes(0),
+	mStoredBytes(0)
+{
+}
+
+// Adds a file to the archive. Returns false if the path is already in the archive.
+bool AssetArchiveWriter::AddFile(const std::wstring& archivePath, const std::vector<uint8_t>& data, bool allowCompression)
+{
+	PendingFile file;
+	file.path = NormaliseArchivePath(archivePath);
+	file.pathHash = HashArchivePath(file.path);
+	file.size = data.size();
+	file.compressed = false;
+
+	for (const auto& existing : mFiles)
+	{
+		if (existing.pathHash == file.pathHash && existing.path == file.path)
+		{
+			return false;
+		}
+	}
+
+	if (allowCompression && !data.empty())
+	{
+		file.storedData.resize(CompressBound(data.size()));
+		const size_t compressedSize = CompressLZ(data.data(), data.size(), file.storedData.data(), file.storedData.size());
+
+		if (compressedSize > 0 && compressedSize < data.size() * MinCompressionRatio)
+		{
+			file.storedData.resize(compressedSize);
+			file.compressed = true;
+		}
+	}
+
+	if (!file.compressed)
+	{
+		file.storedData = data;
+	}
+
+	mUncompressedBytes += file.size;
+	mStoredBytes += file.storedData.size();
+	mFiles.push_back(std::move(file));
+	return true;
+}
+
+// Lays out the archive into memory, ready to be written to disk
+void AssetArchiveWriter::Build(std::vector<uint8_t>& archive) const
+{
+	// Keep the table at most half full so probe sequences stay short
+	uint32_t slotCount = 16;
+	while (slotCount < mFiles.size() * 2)
+	{
+		slotCount *= 2;
+	}
+
+	ArchiveHeader header = {};
+	header.magic = ArchiveMagic;
+	header.version = ArchiveVersion;
+	header.entryCount = static_cast<uint32_t>(mFiles.size());
+	header.tocSlotCount = slotCount;
+	header.tocOffset = sizeof(ArchiveHeader);
+	header.stringsOffset = header.tocOffset + slotCount * sizeof(ArchiveEntry);
+
+	std::vector<ArchiveEntry> slots(slotCount);
+	memset(slots.data(), 0, slots.size() * sizeof(ArchiveEntry));
+
+	std::string strings;
+	std::vector<uint64_t> dataOffsets(mFiles.size());
+
+	// Work out where everything goes
+	for (const auto& file : mFiles)
+	{
+		strings += file.path;
+	}
+	header.stringsSize = strings.size();
+	header.dataOffset = AlignArchiveOffset(header.stringsOffset + header.stringsSize);
+
+	uint64_t offset = header.dataOffset;
+	uint32_t pathOffset = 0;
+	for (size_t i = 0; i < mFiles.size(); i++)
+	{
+		const PendingFile& file = mFiles[i];
+		dataOffsets[i] = offset;
+
+		ArchiveEntry entry = {};
+		entry.pathHash = file.pathHash;
+		entry.offset = offset;
+		entry.storedSize = file.storedData.size();
+		entry.size = file.size;
+		entry.pathOffset = pathOffset;
+		entry.pathLength = static_cast<uint32_t>(file.path.size());
+		entry.flags = ArchiveEntry_Used | (file.compressed ? ArchiveEntry_Compressed : 0);
+
+		// Linear probing from the hash's home slot
+		uint32_t slot = static_cast<uint32_t>(file.pathHash) & (slotCount - 1);
+		while (slots[slot].flags & ArchiveEntry_Used)
+		{
+			slot = (slot + 1) & (slotCount - 1);
+		}
+		slots[slot] = entry;
+
+		pathOffset += entry.pathLength;
+		offset = AlignArchiveOffset(offset + entry.storedSize);
+	}
+
+	// Write it all out
+	archive.assign(static_cast<size_t>(offset), 0);
+	memcpy(archive.data(), &header, sizeof(header));
+	memcpy(archive.data() + header.tocOffset, slots.data(), slots.size() * sizeof(ArchiveEntry));
+	memcpy(archive.data() + header.stringsOffset, strings.data(), strings.size());
+
+	for (size_t i = 0; i < mFiles.size(); i++)
+	{
+		const std::vector<uint8_t>& data = mFiles[i].storedData;
+		if (!data.empty())
+		{
+			memcpy(archive.data() + dataOffsets[i], data.data(), data.size());
+		}
+	}
+}
@@ -0,0 +1,42 @@
+// Builds packed asset archives - used by the AssetPacker tool
+
+#pragma once
+
+#include "AssetArchiveFormat.h"
+
+#include <vector>
+
+class AssetArchiveWriter
+{
+public:
+	// Entries that don't compress to at least this fraction of their size are stored as is,
+	// as reading them back is then a straight copy or a pointer into the mapped file
+	static const float MinCompressionRatio;
+
+	AssetArchiveWriter();
+
+	// Adds a file to the archive. Returns false if the path is already in the archive.
+	bool AddFile(const std::wstring& archivePath, const std::vector<uint8_t>& data, bool allowCompression = true);
+
+	// Lays out the archive into memory, ready to be written to disk
+	void Build(std::vector<uint8_t>& archive) const;
+
+	// Getters
+	size_t GetEntryCount() const { return mFiles.size(); }
+	uint64_t GetUncompressedBytes() const { return mUncompressedBytes; }
+	uint64_t GetStoredBytes() const { return mStoredBytes; }
+
+private:
+	struct PendingFile
+	{
+		std::string path;
+		uint64_t pathHash;
+		uint64_t size;
+		bool compressed;
+		std::vector<uint8_t> storedData;
+	};
+
+	std::vector<PendingFile> mFiles;
+	uint64_t mUncompressedBytes;
+	uint64_t mStoredBytes;
+};
@@ -0,0 +1,113 @@
+// AssetPacker - packs a directory of assets into a single archive the app can load from
+//
+// Usage: AssetPacker <input directory> <output archive> [-store]
+//   -store	Store every file uncompressed
+
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <Windows.h>
+
+#include "AssetArchiveWriter.h"
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+
+namespace
+{
+	bool ReadWholeFile(const std::wstring& path, std::vector<uint8_t>& data)
+	{
+		std::ifstream file(path, std::ios::binary);
+		if (!file)
+		{
+			return false;
+		}
+
+		data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+		return !file.bad();
+	}
+
+	// Adds every file under directory to the archive, named relative to the input root
+	bool AddDirectory(AssetArchiveWriter& writer, const std::wstring& root, const std::wstring& relativePath, bool allowCompression)
+	{
+		WIN32_FIND_DATAW findData;
+		HANDLE find = FindFirstFileW((root + relativePath + L"*").c_str(), &findData);
+		if (find == INVALID_HANDLE_VALUE)
+		{
+			return false;
+		}
+
+		bool success = true;
+		do
+		{
+			const std::wstring name = findData.cFileName;
+			if (name == L"." || name == L"..")
+			{
+				continue;
+			}
+
+			if (findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+			{
+				success = AddDirectory(writer, root, relativePath + name + L"\\", allowCompression);
+				continue;
+			}
+
+			std::vector<uint8_t> data;
+			if (!ReadWholeFile(root + relativePath + name, data))
+			{
+				fwprintf(stderr, L"Failed to read %ls\n", (relativePath + name).c_str());
+				success = false;
+				continue;
+			}
+
+			writer.AddFile(relativePath + name, data, allowCompression);
+			wprintf(L"  %ls (%zu bytes)\n", (relativePath + name).c_str(), data.size());
+		} while (success && FindNextFileW(find, &findData));
+
+		FindClose(find);
+		return success;
+	}
+}
+
+int wmain(int argc, wchar_t* argv[])
+{
+	if (argc < 3)
+	{
+		wprintf(L"Usage: AssetPacker <input directory> <output archive> [-store]\n");
+		return 1;
+	}
+
+	std::wstring inputDirectory = argv[1];
+	if (inputDirectory.back() != L'\\' && inputDirectory.back() != L'/')
+	{
+		inputDirectory += L'\\';
+	}
+
+	const bool allowCompression = !(argc > 3 && _wcsicmp(argv[3], L"-store") == 0);
+
+	AssetArchiveWriter writer;
+	if (!AddDirectory(writer, inputDirectory, L"", allowCompression))
+	{
+		return 1;
+	}
+
+	std::vector<uint8_t> archive;
+	writer.Build(archive);
+
+	std::ofstream output(argv[2], std::ios::binary);
+	output.write(reinterpret_cast<const char*>(archive.data()), archive.size());
+	if (!output)
+	{
+		fwprintf(stderr, L"Failed to write %ls\n", argv[2]);
+		return 1;
+	}
+
+	wprintf(L"Packed %zu files, %llu bytes stored as %llu (archive is %zu bytes)\n",
+		writer.GetEntryCount(),
+		static_cast<unsigned long long>(writer.GetUncompressedBytes()),
+		static_cast<unsigned long long>(writer.GetStoredBytes()),
+		archive.size());
+
+	return 0;
+}
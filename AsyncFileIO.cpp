@@ -0,0 +1,719 @@
+#include "AsyncFileIO.h"
+#include "JobSystem.h"
+
+#if defined(_WIN32)
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <Windows.h>
+#else
+#include "NativePath.h"
+
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <deque>
+#include <stdexcept>
+#include <thread>
+
+namespace
+{
+#if defined(_WIN32)
+	// A read that came back shorter than the requests it covered, as the file was truncated
+	const uint32_t ShortReadError = ERROR_HANDLE_EOF;
+
+	// Opens a file for reading, returns INVALID_HANDLE_VALUE on failure
+	HANDLE OpenFileForRead(const std::wstring& path, DWORD flags)
+	{
+		CREATEFILE2_EXTENDED_PARAMETERS extendedParams = {};
+		extendedParams.dwSize = sizeof(CREATEFILE2_EXTENDED_PARAMETERS);
+		extendedParams.dwFileAttributes = FILE_ATTRIBUTE_NORMAL;
+		extendedParams.dwFileFlags = flags;
+		extendedParams.dwSecurityQosFlags = SECURITY_ANONYMOUS;
+		extendedParams.lpSecurityAttributes = nullptr;
+		extendedParams.hTemplateFile = nullptr;
+
+		return CreateFile2(path.c_str(), GENERIC_READ, FILE_SHARE_READ, OPEN_EXISTING, &extendedParams);
+	}
+
+	// Works out how many bytes a read should cover, clamping it to the end of the file.
+	// Returns ERROR_SUCCESS, or why the read can't be made.
+	DWORD GetReadSize(HANDLE file, uint64_t offset, uint64_t size, uint64_t* readSize)
+	{
+		LARGE_INTEGER fileSize;
+		if (!GetFileSizeEx(file, &fileSize))
+		{
+			return GetLastError();
+		}
+
+		const uint64_t endOfFile = static_cast<uint64_t>(fileSize.QuadPart);
+		if (offset > endOfFile)
+		{
+			return ERROR_HANDLE_EOF;
+		}
+
+		const uint64_t available = endOfFile - offset;
+		*readSize = (size == 0 || size > available) ? available : size;
+
+		// A single ReadFile call is limited to a DWORD's worth of bytes
+		return *readSize <= MAXDWORD ? ERROR_SUCCESS : ERROR_FILE_TOO_LARGE;
+	}
+
+	bool QueryFileSize(const std::wstring& path, uint64_t* size)
+	{
+		WIN32_FILE_ATTRIBUTE_DATA attributes;
+		if (!GetFileAttributesExW(path.c_str(), GetFileExInfoStandard, &attributes))
+		{
+			return false;
+		}
+
+		*size = (static_cast<uint64_t>(attributes.nFileSizeHigh) << 32) | attributes.nFileSizeLow;
+		return true;
+	}
+
+	// Returns ERROR_SUCCESS, or the error the read failed with
+	DWORD BlockingRead(const std::wstring& path, uint64_t offset, uint64_t size, std::vector<uint8_t>& data)
+	{
+		HANDLE file = OpenFileForRead(path, FILE_FLAG_SEQUENTIAL_SCAN);
+		if (file == INVALID_HANDLE_VALUE)
+		{
+			return GetLastError();
+		}
+
+		uint64_t readSize = 0;
+		DWORD error = GetReadSize(file, offset, size, &readSize);
+
+		if (error == ERROR_SUCCESS)
+		{
+			LARGE_INTEGER position;
+			position.QuadPart = static_cast<LONGLONG>(offset);
+			if (!SetFilePointerEx(file, position, nullptr, FILE_BEGIN))
+			{
+				error = GetLastError();
+			}
+		}
+
+		if (error == ERROR_SUCCESS)
+		{
+			data.resize(static_cast<size_t>(readSize));
+
+			DWORD bytesRead = 0;
+			if (!ReadFile(file, data.data(), static_cast<DWORD>(readSize), &bytesRead, nullptr))
+			{
+				error = GetLastError();
+			}
+			data.resize(bytesRead);
+		}
+
+		CloseHandle(file);
+		return error;
+	}
+#else
+	// A read that came back shorter than the requests it covered, as the file was truncated
+	const uint32_t ShortReadError = EIO;
+
+	bool QueryFileSize(const std::wstring& path, uint64_t* size)
+	{
+		struct stat status;
+		if (stat(ToNativePath(path).c_str(), &status) != 0)
+		{
+			return false;
+		}
+
+		*size = static_cast<uint64_t>(status.st_size);
+		return true;
+	}
+
+	// pread may return fewer bytes than asked for, so it's called until the range is read.
+	// Returns 0, or the errno the read failed with.
+	int BlockingRead(const std::wstring& path, uint64_t offset, uint64_t size, std::vector<uint8_t>& data)
+	{
+		const int file = open(ToNativePath(path).c_str(), O_RDONLY | O_CLOEXEC);
+		if (file < 0)
+		{
+			return errno;
+		}
+
+		struct stat status;
+		int error = 0;
+		if (fstat(file, &status) != 0)
+		{
+			error = errno;
+		}
+		else if (offset > static_cast<uint64_t>(status.st_size))
+		{
+			error = EINVAL;
+		}
+
+		if (error == 0)
+		{
+			const uint64_t available = static_cast<uint64_t>(status.st_size) - offset;
+			data.resize(static_cast<size_t>((size == 0 || size > available) ? available : size));
+
+			size_t bytesRead = 0;
+			while (bytesRead < data.size())
+			{
+				const ssize_t result = pread(file, data.data() + bytesRead, data.size() - bytesRead, static_cast<off_t>(offset + bytesRead));
+				if (result <= 0)
+				{
+					error = result < 0 ? errno : 0;
+					break;
+				}
+				bytesRead += static_cast<size_t>(result);
+			}
+			data.resize(bytesRead);
+		}
+
+		close(file);
+		return error;
+	}
+#endif
+
+	// Performs blocking reads on a small pool of dedicated I/O threads.
+	// These are kept apart from the job system so slow reads can't starve other jobs.
+	class ThreadPoolFileIOBackend : public IFileIOBackend
+	{
+	public:
+		explicit ThreadPoolFileIOBackend(unsigned int threadCount) :
+			mShuttingDown(false)
+		{
+			for (unsigned int i = 0; i < threadCount; i++)
+			{
+				mThreads.emplace_back(&ThreadPoolFileIOBackend::ThreadLoop, this);
+			}
+		}
+
+		~ThreadPoolFileIOBackend()
+		{
+			{
+				std::lock_guard<std::mutex> lock(mMutex);
+				mShuttingDown = true;
+			}
+			mWorkAvailable.notify_all();
+
+			for (auto& thread : mThreads)
+			{
+				thread.join();
+			}
+		}
+
+		void Read(const std::wstring& path, uint64_t offset, uint64_t size, Completion completion) override
+		{
+			{
+				std::lock_guard<std::mutex> lock(mMutex);
+				mQueue.push_back({ path, offset, size, std::move(completion) });
+			}
+			mWorkAvailable.notify_one();
+		}
+
+	private:
+		struct QueuedRead
+		{
+			std::wstring path;
+			uint64_t offset;
+			uint64_t size;
+			Completion completion;
+		};
+
+		void ThreadLoop()
+		{
+			while (true)
+			{
+				QueuedRead read;
+				{
+					std::unique_lock<std::mutex> lock(mMutex);
+					mWorkAvailable.wait(lock, [this] { return mShuttingDown || !mQueue.empty(); });
+					if (mQueue.empty())
+					{
+						return;
+					}
+
+					read = std::move(mQueue.front());
+					mQueue.pop_front();
+				}
+
+				std::vector<uint8_t> data;
+				const uint32_t error = static_cast<uint32_t>(BlockingRead(read.path, read.offset, read.size, data));
+				read.completion(error, data);
+			}
+		}
+
+		std::vector<std::thread> mThreads;
+		std::deque<QueuedRead> mQueue;
+		std::mutex mMutex;
+		std::condition_variable mWorkAvailable;
+		bool mShuttingDown;
+	};
+
+#if defined(_WIN32)
+	// Issues overlapped reads and picks up their completions on a thread waiting on an
+	// I/O completion port, so any number of reads can be queued in the OS at once.
+	class OverlappedFileIOBackend : public IFileIOBackend
+	{
+	public:
+		OverlappedFileIOBackend()
+		{
+			mCompletionPort = CreateIoCompletionPort(INVALID_HANDLE_VALUE, nullptr, 0, 1);
+			if (mCompletionPort == nullptr)
+			{
+				throw std::exception();
+			}
+
+			mCompletionThread = std::thread(&OverlappedFileIOBackend::CompletionLoop, this);
+		}
+
+		~OverlappedFileIOBackend()
+		{
+			// A packet with no OVERLAPPED tells the completion thread to exit
+			PostQueuedCompletionStatus(mCompletionPort, 0, 0, nullptr);
+			mCompletionThread.join();
+			CloseHandle(mCompletionPort);
+		}
+
+		void Read(const std::wstring& path, uint64_t offset, uint64_t size, Completion completion) override
+		{
+			std::vector<uint8_t> noData;
+
+			HANDLE file = OpenFileForRead(path, FILE_FLAG_OVERLAPPED);
+			if (file == INVALID_HANDLE_VALUE)
+			{
+				completion(GetLastError(), noData);
+				return;
+			}
+
+			uint64_t readSize = 0;
+			DWORD error = GetReadSize(file, offset, size, &readSize);
+			if (error == ERROR_SUCCESS && CreateIoCompletionPort(file, mCompletionPort, CompletionKey_Read, 0) == nullptr)
+			{
+				error = GetLastError();
+			}
+
+			if (error != ERROR_SUCCESS)
+			{
+				CloseHandle(file);
+				completion(error, noData);
+				return;
+			}
+
+			// Owned by the completion port until the read completes
+			OverlappedRead* read = new OverlappedRead();
+			read->overlapped.Offset = static_cast<DWORD>(offset);
+			read->overlapped.OffsetHigh = static_cast<DWORD>(offset >> 32);
+			read->file = file;
+			read->data.resize(static_cast<size_t>(readSize));
+			read->completion = std::move(completion);
+
+			if (!ReadFile(file, read->data.data(), static_cast<DWORD>(readSize), nullptr, &read->overlapped))
+			{
+				error = GetLastError();
+				if (error != ERROR_IO_PENDING)
+				{
+					Finish(read, error == ERROR_HANDLE_EOF ? ERROR_SUCCESS : error, 0);
+				}
+			}
+		}
+
+	private:
+		static const ULONG_PTR CompletionKey_Read = 1;
+
+		struct OverlappedRead
+		{
+			OVERLAPPED overlapped = {}; // Must be first, the completion port hands this pointer back
+			HANDLE file = INVALID_HANDLE_VALUE;
+			std::vector<uint8_t> data;
+			Completion completion;
+		};
+
+		void CompletionLoop()
+		{
+			while (true)
+			{
+				DWORD bytesTransferred = 0;
+				ULONG_PTR key = 0;
+				OVERLAPPED* overlapped = nullptr;
+				const BOOL result = GetQueuedCompletionStatus(mCompletionPort, &bytesTransferred, &key, &overlapped, INFINITE);
+
+				if (overlapped == nullptr)
+				{
+					// Either the shutdown packet or the port itself failed
+					return;
+				}
+
+				OverlappedRead* read = reinterpret_cast<OverlappedRead*>(overlapped);
+				const DWORD error = result != FALSE ? ERROR_SUCCESS : GetLastError();
+				Finish(read, error == ERROR_HANDLE_EOF ? ERROR_SUCCESS : error, bytesTransferred);
+			}
+		}
+
+		static void Finish(OverlappedRead* read, DWORD error, DWORD bytesTransferred)
+		{
+			CloseHandle(read->file);
+			read->data.resize(bytesTransferred);
+			read->completion(error, read->data);
+			delete read;
+		}
+
+		HANDLE mCompletionPort;
+		std::thread mCompletionThread;
+	};
+#endif
+}
+
+AsyncFileIO::AsyncFileIO(JobSystem* jobSystem, EIOBackend backend, uint64_t maxBytesInFlight, unsigned int maxReadsInFlight) :
+	mJobSystem(jobSystem),
+	mMaxBytesInFlight(maxBytesInFlight),
+	mMaxReadsInFlight(maxReadsInFlight > 0 ? maxReadsInFlight : 1),
+	mBytesInFlight(0),
+	mCompleting(0),
+	mNextRequestId(InvalidRequest + 1),
+	mStats()
+{
+#if defined(_WIN32)
+	if (backend == IOBackend_Overlapped)
+	{
+		mBackend.reset(new OverlappedFileIOBackend());
+	}
+#else
+	// Overlapped reads are Windows only, so other platforms always use the thread pool
+	(void)backend;
+#endif
+	if (mBackend == nullptr)
+	{
+		mBackend.reset(new ThreadPoolFileIOBackend(2));
+	}
+}
+
+AsyncFileIO::~AsyncFileIO()
+{
+	// Drop anything that hasn't started yet, then let the in-flight reads finish
+	// as their completions reference this object
+	std::vector<Request> dropped;
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		for (auto& pending : mPending)
+		{
+			for (auto& request : pending)
+			{
+				dropped.push_back(std::move(request));
+			}
+			pending.clear();
+		}
+	}
+
+	for (auto& request : dropped)
+	{
+		IOResult result = { request.id, IOStatus_Cancelled };
+		Deliver(request.callback, result);
+	}
+
+	WaitIdle();
+	mBackend.reset();
+}
+
+// Queue a read of size bytes from offset. A size of 0 reads the whole file from offset.
+AsyncFileIO::RequestId AsyncFileIO::Read(const std::wstring& path, uint64_t offset, uint64_t size, EIOPriority priority, Callback callback)
+{
+	// Whole-file reads are charged against the in-flight budget at the file's current size.
+	// If it can't be found the read will fail straight away, so costs nothing.
+	uint64_t budgetBytes = size;
+	uint64_t fileSize = 0;
+	if (size == 0 && QueryFileSize(path, &fileSize))
+	{
+		budgetBytes = fileSize > offset ? fileSize - offset : 0;
+	}
+
+	RequestId id;
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		id = mNextRequestId++;
+		mPending[priority].push_back({ id, path, offset, size, budgetBytes, std::move(callback), false });
+		mStats.requestsSubmitted++;
+	}
+
+	IssueReads();
+	return id;
+}
+
+// Cancel a request. Returns false if the request has already completed.
+bool AsyncFileIO::Cancel(RequestId id)
+{
+	Request cancelled;
+	bool wasPending = false;
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+
+		for (auto& pending : mPending)
+		{
+			for (auto it = pending.begin(); it != pending.end(); ++it)
+			{
+				if (it->id == id)
+				{
+					cancelled = std::move(*it);
+					pending.erase(it);
+					wasPending = true;
+					break;
+				}
+			}
+		}
+
+		if (!wasPending)
+		{
+			// In-flight requests are flagged, and reported as cancelled when the read completes
+			for (auto& read : mInFlight)
+			{
+				for (auto& request : read->requests)
+				{
+					if (request.id == id && !request.cancelled)
+					{
+						request.cancelled = true;
+						mStats.requestsCancelled++;
+						return true;
+					}
+				}
+			}
+			return false;
+		}
+
+		mStats.requestsCancelled++;
+	}
+
+	IOResult result = { cancelled.id, IOStatus_Cancelled };
+	Deliver(cancelled.callback, result);
+	return true;
+}
+
+// Blocks until there are no queued or in-flight requests, and no completion is still using
+// this object. Callbacks that have been handed to the job system may still be running.
+void AsyncFileIO::WaitIdle()
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+	mIdle.wait(lock, [this]
+	{
+		if (!mInFlight.empty() || mCompleting > 0)
+		{
+			return false;
+		}
+		for (const auto& pending : mPending)
+		{
+			if (!pending.empty())
+			{
+				return false;
+			}
+		}
+		return true;
+	});
+}
+
+AsyncFileIO::Stats AsyncFileIO::GetStats() const
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	return mStats;
+}
+
+// Moves as many queued requests as the in-flight budget allows to the backend.
+// Reads are issued outside the lock as the backend may complete them immediately.
+void AsyncFileIO::IssueReads()
+{
+	std::vector<InFlightReadPtr> reads;
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		SelectReads(reads);
+	}
+
+	for (auto& read : reads)
+	{
+		InFlightReadPtr readRef = read;
+		mBackend->Read(read->path, read->offset, read->size,
+			[this, readRef](uint32_t error, std::vector<uint8_t>& data)
+			{
+				OnReadComplete(readRef, error, data);
+			});
+	}
+}
+
+// Must be called with the lock held
+void AsyncFileIO::SelectReads(std::vector<InFlightReadPtr>& reads)
+{
+	while (mInFlight.size() < mMaxReadsInFlight)
+	{
+		// Requests are issued strictly in priority order, so stop at the first one
+		// that doesn't fit rather than letting smaller, lower priority reads jump ahead.
+		// One read is always allowed so that a request bigger than the budget can't stall.
+		const std::list<Request>* next = nullptr;
+		for (int priority = NumIOPriorities - 1; priority >= 0 && next == nullptr; priority--)
+		{
+			if (!mPending[priority].empty())
+			{
+				next = &mPending[priority];
+			}
+		}
+
+		if (next == nullptr ||
+			(!mInFlight.empty() && mBytesInFlight + next->front().budgetBytes > mMaxBytesInFlight))
+		{
+			break;
+		}
+
+		InFlightReadPtr read = std::make_shared<InFlightRead>();
+		read->requests.emplace_back();
+		PopHighestPriority(read->requests.back());
+		read->path = read->requests.back().path;
+		read->offset = read->requests.back().offset;
+		read->size = read->requests.back().size;
+
+		// Whole-file reads have an unknown size so are never merged
+		if (read->size > 0)
+		{
+			CoalesceInto(*read);
+			read->budgetBytes = read->size;
+		}
+		else
+		{
+			read->budgetBytes = read->requests.back().budgetBytes;
+		}
+
+		mBytesInFlight += read->budgetBytes;
+		mInFlight.push_back(read);
+		mStats.readsIssued++;
+		reads.push_back(read);
+	}
+}
+
+// Must be called with the lock held
+bool AsyncFileIO::PopHighestPriority(Request& request)
+{
+	for (int priority = NumIOPriorities - 1; priority >= 0; priority--)
+	{
+		if (!mPending[priority].empty())
+		{
+			request = std::move(mPending[priority].front());
+			mPending[priority].pop_front();
+			return true;
+		}
+	}
+	return false;
+}
+
+// Merges any queued requests that overlap or touch the read's range into it.
+// Must be called with the lock held.
+void AsyncFileIO::CoalesceInto(InFlightRead& read)
+{
+	bool merged = true;
+	while (merged)
+	{
+		merged = false;
+
+		for (auto& pending : mPending)
+		{
+			for (auto it = pending.begin(); it != pending.end();)
+			{
+				const uint64_t readEnd = read.offset + read.size;
+				const uint64_t requestEnd = it->offset + it->size;
+
+				const bool touches = it->size > 0 && it->path == read.path &&
+					it->offset <= readEnd && requestEnd >= read.offset;
+
+				const uint64_t newOffset = it->offset < read.offset ? it->offset : read.offset;
+				const uint64_t newEnd = requestEnd > readEnd ? requestEnd : readEnd;
+
+				if (touches && newEnd - newOffset <= MaxCoalescedReadSize)
+				{
+					read.offset = newOffset;
+					read.size = newEnd - newOffset;
+					read.requests.push_back(std::move(*it));
+					it = pending.erase(it);
+					mStats.requestsCoalesced++;
+					merged = true;
+				}
+				else
+				{
+					++it;
+				}
+			}
+		}
+	}
+}
+
+// Splits a finished read back into its requests and hands each one to its callback
+void AsyncFileIO::OnReadComplete(const InFlightReadPtr& read, uint32_t error, std::vector<uint8_t>& data)
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mInFlight.remove(read);
+		mBytesInFlight -= read->budgetBytes;
+
+		// Idle waits must also wait for this function to finish with the object
+		mCompleting++;
+		if (error == 0)
+		{
+			mStats.bytesRead += data.size();
+		}
+	}
+
+	for (auto& request : read->requests)
+	{
+		IOResult result = { request.id, IOStatus_Completed };
+
+		if (request.cancelled)
+		{
+			result.status = IOStatus_Cancelled;
+		}
+		else if (error != 0)
+		{
+			result.status = IOStatus_Failed;
+			result.error = error;
+		}
+		else if (read->requests.size() == 1)
+		{
+			// Only one request so it can take the buffer as is
+			result.data = std::move(data);
+		}
+		else
+		{
+			const size_t begin = static_cast<size_t>(request.offset - read->offset);
+			const size_t end = static_cast<size_t>(request.offset - read->offset + request.size);
+
+			// The file was shorter than expected
+			if (end > data.size())
+			{
+				result.status = IOStatus_Failed;
+				result.error = ShortReadError;
+			}
+			else
+			{
+				result.data.assign(data.begin() + begin, data.begin() + end);
+			}
+		}
+
+		Deliver(request.callback, result);
+	}
+
+	// Finishing this read has freed up some of the budget
+	IssueReads();
+
+	// The last use of this object. Notified under the lock, as the destructor may be waiting
+	// to destroy it.
+	std::lock_guard<std::mutex> lock(mMutex);
+	mCompleting--;
+	mIdle.notify_all();
+}
+
+void AsyncFileIO::Deliver(const Callback& callback, IOResult& result)
+{
+	if (mJobSystem == nullptr)
+	{
+		callback(result);
+		return;
+	}
+
+	// std::function needs a copyable target, so share the result rather than copying the data
+	std::shared_ptr<IOResult> sharedResult = std::make_shared<IOResult>(std::move(result));
+	Callback jobCallback = callback;
+	mJobSystem->Submit([jobCallback, sharedResult]()
+	{
+		jobCallback(*sharedResult);
+	});
+}
@@ -0,0 +1,166 @@
+// Asynchronous file I/O service
+// Reads are queued by priority, reads of adjacent ranges of the same file are merged
+// into a single read, and completion callbacks are delivered on the job system.
+
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+class JobSystem;
+
+// Request priorities - higher priority requests are always issued first
+enum EIOPriority
+{
+	IOPriority_Low,
+	IOPriority_Normal,
+	IOPriority_High,
+	IOPriority_Critical,
+
+	NumIOPriorities
+};
+
+// Final state of a request, passed to its callback
+enum EIOStatus
+{
+	IOStatus_Completed,
+	IOStatus_Failed,
+	IOStatus_Cancelled
+};
+
+// Which backend performs the reads
+enum EIOBackend
+{
+	IOBackend_ThreadPool,	// Blocking reads on dedicated I/O threads
+	IOBackend_Overlapped	// Overlapped reads completed through an I/O completion port (Windows only,
+							// other platforms use the thread pool)
+};
+
+struct IOResult
+{
+	uint64_t requestId;
+	EIOStatus status;
+	uint32_t error;		// Why a failed read failed: a Win32 error code, or errno on other platforms
+	std::vector<uint8_t> data;
+};
+
+// Interface for the code that performs the actual reads
+class IFileIOBackend
+{
+public:
+	// error is 0 if the read succeeded, otherwise a Win32 error code or errno
+	typedef std::function<void(uint32_t error, std::vector<uint8_t>& data)> Completion;
+
+	virtual ~IFileIOBackend() {}
+
+	// Reads size bytes starting at offset (a size of 0 reads to the end of the file).
+	// The completion may be called on any thread, including the calling thread.
+	// Reads that run past the end of the file complete with fewer bytes.
+	virtual void Read(const std::wstring& path, uint64_t offset, uint64_t size, Completion completion) = 0;
+};
+
+class AsyncFileIO
+{
+public:
+	typedef uint64_t RequestId;
+	typedef std::function<void(IOResult& result)> Callback;
+
+	static const RequestId InvalidRequest = 0;
+
+	// Largest read that requests will be merged into
+	static const uint64_t MaxCoalescedReadSize = 4 * 1024 * 1024;
+
+	struct Stats
+	{
+		uint64_t requestsSubmitted;
+		uint64_t requestsCoalesced;	// Requests that were merged into another request's read
+		uint64_t requestsCancelled;
+		uint64_t readsIssued;		// Reads issued to the backend
+		uint64_t bytesRead;
+	};
+
+	// Constructor
+	// Callbacks are run on jobSystem if one is given, otherwise on the thread that completed the read.
+	AsyncFileIO(JobSystem* jobSystem,
+		EIOBackend backend = IOBackend_Overlapped,
+		uint64_t maxBytesInFlight = 64 * 1024 * 1024,
+		unsigned int maxReadsInFlight = 16);
+
+	// Prohibit copying
+	AsyncFileIO(const AsyncFileIO& rhs) = delete;
+	AsyncFileIO& operator=(const AsyncFileIO& rhs) = delete;
+
+	// Destructor - waits for any in-flight reads to finish
+	~AsyncFileIO();
+
+	// Queue a read of size bytes from offset. A size of 0 reads the whole file from offset, and
+	// counts against the in-flight budget at the file's size when it's queued.
+	// The callback is always called exactly once, including when the request is cancelled.
+	RequestId Read(const std::wstring& path, uint64_t offset, uint64_t size, EIOPriority priority, Callback callback);
+
+	// Cancel a request. Returns false if the request has already completed.
+	// A read that is already in flight still finishes, but its data is discarded.
+	bool Cancel(RequestId id);
+
+	// Blocks until there are no queued or in-flight requests, and no completions still running
+	void WaitIdle();
+
+	Stats GetStats() const;
+
+private:
+	struct Request
+	{
+		RequestId id;
+		std::wstring path;
+		uint64_t offset;
+		uint64_t size;
+		uint64_t budgetBytes;		// Counted against the in-flight budget, the file's size for whole-file reads
+		Callback callback;
+		bool cancelled;
+	};
+
+	// One backend read, covering one or more merged requests
+	struct InFlightRead
+	{
+		std::wstring path;
+		uint64_t offset;
+		uint64_t size;
+		uint64_t budgetBytes;
+		std::vector<Request> requests;
+	};
+
+	typedef std::shared_ptr<InFlightRead> InFlightReadPtr;
+
+	void IssueReads();
+	void SelectReads(std::vector<InFlightReadPtr>& reads);
+	bool PopHighestPriority(Request& request);
+	void CoalesceInto(InFlightRead& read);
+	void OnReadComplete(const InFlightReadPtr& read, uint32_t error, std::vector<uint8_t>& data);
+	void Deliver(const Callback& callback, IOResult& result);
+
+	JobSystem* mJobSystem;
+	std::unique_ptr<IFileIOBackend> mBackend;
+
+	const uint64_t mMaxBytesInFlight;
+	const unsigned int mMaxReadsInFlight;
+
+	mutable std::mutex mMutex;
+	std::condition_variable mIdle;
+
+	// Queued requests, one FIFO list per priority
+	std::list<Request> mPending[NumIOPriorities];
+	std::list<InFlightReadPtr> mInFlight;
+	uint64_t mBytesInFlight;
+
+	// Reads that have left mInFlight but whose completions are still running
+	unsigned int mCompleting;
+
+	RequestId mNextRequestId;
+	Stats mStats;
+};
@@ -0,0 +1,372 @@
+#include "Benchmark.h"
+#include "Profiler.h"
+
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+namespace
+{
+	const BenchmarkScenario Scenarios[] =
+	{
+		// name, seed, objects, lights, warm-up, frames, scene radius, camera radius, camera height, orbits
+		{ "triangle", 1, 1, 0, 60, 600, 0.0f, 3.0f, 1.0f, 1.0f },
+		{ "field", 1234, 2000, 500, 60, 1200, 50.0f, 60.0f, 20.0f, 2.0f },
+		{ "stress", 99, 20000, 10000, 30, 600, 150.0f, 170.0f, 40.0f, 1.0f },
+	};
+
+	const float Pi = 3.14159265f;
+
+	// Which report values are compared, by the end of their path
+	bool IsComparedTime(const std::string& key)
+	{
+		const char* suffixes[] = { ".p50_ms", ".p90_ms", ".p99_ms", ".mean_ms" };
+		for (const char* suffix : suffixes)
+		{
+			const size_t length = strlen(suffix);
+			if (key.size() > length && key.compare(key.size() - length, length, suffix) == 0)
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	bool IsComparedAllocation(const std::string& key)
+	{
+		return key.compare(0, 12, "allocations.") == 0;
+	}
+
+	void WriteSummary(FILE* file, const FrameStatsSummary& summary)
+	{
+		fprintf(file, "{ \"count\": %llu, \"p50_ms\": %.4f, \"p90_ms\": %.4f, \"p99_ms\": %.4f, \"p99.9_ms\": %.4f, \"max_ms\": %.4f }",
+			static_cast<unsigned long long>(summary.count), summary.p50, summary.p90, summary.p99, summary.p999, summary.max);
+	}
+
+	// Minimal JSON reader that keeps only the numbers
+	class JsonFlattener
+	{
+	public:
+		JsonFlattener(const std::string& text, std::map<std::string, double>& values) :
+			mText(text.c_str()), mValues(values) {}
+
+		bool Parse()
+		{
+			if (!ParseValue(""))
+			{
+				return false;
+			}
+			SkipWhitespace();
+			return *mText == '\0';
+		}
+
+	private:
+		void SkipWhitespace()
+		{
+			while (*mText != '\0' && isspace(static_cast<unsigned char>(*mText)))
+			{
+				mText++;
+			}
+		}
+
+		bool ParseString(std::string& result)
+		{
+			if (*mText != '"')
+			{
+				return false;
+			}
+			mText++;
+
+			result.clear();
+			while (*mText != '"')
+			{
+				if (*mText == '\0')
+				{
+					return false;
+				}
+
+				// Escapes are kept as the escaped character, which is enough for key names
+				if (*mText == '\\' && mText[1] != '\0')
+				{
+					mText++;
+				}
+				result += *mText++;
+			}
+			mText++;
+			return true;
+		}
+
+		bool ParseValue(const std::string& path)
+		{
+			SkipWhitespace();
+			if (*mText == '{')
+			{
+				mText++;
+				SkipWhitespace();
+				if (*mText == '}')
+				{
+					mText++;
+					return true;
+				}
+
+				while (true)
+				{
+					SkipWhitespace();
+					std::string key;
+					if (!ParseString(key))
+					{
+						return false;
+					}
+
+					SkipWhitespace();
+					if (*mText++ != ':' || !ParseValue(path.empty() ? key : path + "." + key))
+					{
+						return false;
+					}
+
+					SkipWhitespace();
+					if (*mText == ',')
+					{
+						mText++;
+					}
+					else
+					{
+						return *mText++ == '}';
+					}
+				}
+			}
+			else if (*mText == '[')
+			{
+				mText++;
+				SkipWhitespace();
+				if (*mText == ']')
+				{
+					mText++;
+					return true;
+				}
+
+				for (unsigned int index = 0; ; index++)
+				{
+					if (!ParseValue(path + "[" + std::to_string(index) + "]"))
+					{
+						return false;
+					}
+
+					SkipWhitespace();
+					if (*mText == ',')
+					{
+						mText++;
+					}
+					else
+					{
+						return *mText++ == ']';
+					}
+				}
+			}
+			else if (*mText == '"')
+			{
+				std::string ignored;
+				return ParseString(ignored);
+			}
+			else if (strncmp(mText, "true", 4) == 0 || strncmp(mText, "null", 4) == 0)
+			{
+				mText += 4;
+				return true;
+			}
+			else if (strncmp(mText, "false", 5) == 0)
+			{
+				mText += 5;
+				return true;
+			}
+
+			char* end;
+			const double value = strtod(mText, &end);
+			if (end == mText)
+			{
+				return false;
+			}
+			mText = end;
+			mValues[path] = value;
+			return true;
+		}
+
+		const char* mText;
+		std::map<std::string, double>& mValues;
+	};
+}
+
+// Returns null if there's no scenario with the name
+const BenchmarkScenario* FindBenchmarkScenario(const char* name)
+{
+	for (const BenchmarkScenario& scenario : Scenarios)
+	{
+		if (strcmp(scenario.name, name) == 0)
+		{
+			return &scenario;
+		}
+	}
+	return nullptr;
+}
+
+unsigned int GetBenchmarkScenarioCount()
+{
+	return sizeof(Scenarios) / sizeof(Scenarios[0]);
+}
+
+const BenchmarkScenario& GetBenchmarkScenario(unsigned int index)
+{
+	return Scenarios[index];
+}
+
+void GenerateBenchmarkScene(const BenchmarkScenario& scenario, std::vector<BenchmarkObject>& objects)
+{
+	SeededRandom random(scenario.seed);
+	objects.resize(scenario.objectCount);
+
+	for (BenchmarkObject& object : objects)
+	{
+		// Uniform over the disc
+		const float radius = scenario.sceneRadius * sqrtf(random.NextFloat(0.0f, 1.0f));
+		const float angle = random.NextFloat(0.0f, 2.0f * Pi);
+		object.position[0] = radius * cosf(angle);
+		object.position[1] = random.NextFloat(0.0f, scenario.sceneRadius * 0.1f);
+		object.position[2] = radius * sinf(angle);
+		object.scale = random.NextFloat(0.5f, 2.0f);
+		object.rotationY = random.NextFloat(0.0f, 2.0f * Pi);
+	}
+}
+
+// Point and spot lights scattered over the scene, just above the objects
+void GenerateBenchmarkLights(const BenchmarkScenario& scenario, std::vector<BenchmarkLight>& lights)
+{
+	// Seeded apart from the objects, so adding lights doesn't move them
+	SeededRandom random(scenario.seed ^ 0x5BD1E995u);
+	lights.resize(scenario.lightCount);
+
+	for (BenchmarkLight& light : lights)
+	{
+		const float radius = scenario.sceneRadius * sqrtf(random.NextFloat(0.0f, 1.0f));
+		const float angle = random.NextFloat(0.0f, 2.0f * Pi);
+		light.position[0] = radius * cosf(angle);
+		light.position[1] = random.NextFloat(1.0f, 2.0f + scenario.sceneRadius * 0.1f);
+		light.position[2] = radius * sinf(angle);
+		light.range = random.NextFloat(2.0f, 8.0f);
+		for (unsigned int channel = 0; channel < 3; channel++)
+		{
+			light.colour[channel] = random.NextFloat(0.2f, 1.0f);
+		}
+
+		// One in four is a spot light, pointing down and out
+		light.spot = random.Next() % 4 == 0;
+		const float tilt = random.NextFloat(0.0f, 0.8f);
+		const float heading = random.NextFloat(0.0f, 2.0f * Pi);
+		light.direction[0] = sinf(tilt) * cosf(heading);
+		light.direction[1] = -cosf(tilt);
+		light.direction[2] = sinf(tilt) * sinf(heading);
+		light.cosOuterAngle = cosf(random.NextFloat(0.3f, 0.8f));
+	}
+}
+
+// Frame counts from the start of the run, including the warm-up
+BenchmarkCamera GetBenchmarkCamera(const BenchmarkScenario& scenario, unsigned int frame)
+{
+	const unsigned int totalFrames = scenario.warmupFrames + scenario.frameCount;
+	const float t = static_cast<float>(frame) / static_cast<float>(totalFrames > 0 ? totalFrames : 1);
+	const float angle = t * scenario.orbits * 2.0f * Pi;
+
+	// Circle the scene, bobbing up and down a little
+	BenchmarkCamera camera;
+	camera.eye[0] = scenario.cameraRadius * cosf(angle);
+	camera.eye[1] = scenario.cameraHeight * (1.0f + 0.25f * sinf(angle * 3.0f));
+	camera.eye[2] = scenario.cameraRadius * sinf(angle);
+	camera.target[0] = 0.0f;
+	camera.target[1] = 0.0f;
+	camera.target[2] = 0.0f;
+	return camera;
+}
+
+bool WriteBenchmarkReport(FILE* file, const BenchmarkScenario& scenario, const FrameStats& frameStats, const AllocationCounts& allocations)
+{
+	const uint64_t frames = frameStats.GetFrameCount();
+	const double perFrame = frames > 0 ? 1.0 / static_cast<double>(frames) : 0.0;
+
+	fprintf(file, "{\n  \"scenario\": \"%s\",\n  \"seed\": %u,\n  \"objects\": %u,\n  \"lights\": %u,\n  \"frames\": %llu,\n",
+		scenario.name, scenario.seed, scenario.objectCount, scenario.lightCount, static_cast<unsigned long long>(frames));
+
+	fprintf(file, "  \"frame_ms\": {");
+	for (unsigned int stat = 0; stat < NumFrameStats; stat++)
+	{
+		fprintf(file, "%s\n    \"%s\": ", stat == 0 ? "" : ",", FrameStats::GetStatName(static_cast<EFrameStat>(stat)));
+		WriteSummary(file, frameStats.GetTotalSummary(static_cast<EFrameStat>(stat)));
+	}
+	fprintf(file, "\n  },\n");
+
+	fprintf(file, "  \"zones\": {");
+	bool first = true;
+	for (unsigned int i = 0; i < GetProfileZoneCount(); i++)
+	{
+		const ProfileZoneStats* zone = GetProfileZone(i);
+		const uint64_t zoneFrames = zone->frameTimes.GetCount();
+		if (zoneFrames == 0)
+		{
+			continue;
+		}
+
+		fprintf(file, "%s\n    \"%s\": { \"frames\": %llu, \"calls_per_frame\": %.2f, \"mean_ms\": %.4f, \"p50_ms\": %.4f, \"p99_ms\": %.4f, \"max_ms\": %.4f }",
+			first ? "" : ",", zone->name, static_cast<unsigned long long>(zoneFrames),
+			static_cast<double>(zone->totalCalls) / zoneFrames,
+			static_cast<double>(zone->totalTime) / zoneFrames / 1000000.0,
+			zone->frameTimes.GetValueAtPercentile(50.0) / 1000000.0,
+			zone->frameTimes.GetValueAtPercentile(99.0) / 1000000.0,
+			zone->frameTimes.GetMax() / 1000000.0);
+		first = false;
+	}
+	fprintf(file, "\n  },\n");
+
+	fprintf(file, "  \"allocations\": { \"per_frame\": %.2f, \"bytes_per_frame\": %.1f }\n}\n",
+		allocations.allocations * perFrame, allocations.bytes * perFrame);
+	return ferror(file) == 0;
+}
+
+// Reads a JSON document into a map of its numbers, keyed by their path (e.g. "frame_ms.cpu.p99_ms")
+bool FlattenJson(const std::string& text, std::map<std::string, double>& values)
+{
+	JsonFlattener flattener(text, values);
+	return flattener.Parse();
+}
+
+// Compares the percentiles, zone times and allocations in two reports, printing each regression
+// to the log. Returns the number of regressions.
+unsigned int CompareBenchmarkReports(const std::map<std::string, double>& baseline, const std::map<std::string, double>& current,
+	const BenchmarkTolerances& tolerances, FILE* log)
+{
+	unsigned int regressions = 0;
+	for (const auto& entry : baseline)
+	{
+		const bool isTime = IsComparedTime(entry.first);
+		const bool isAllocation = IsComparedAllocation(entry.first);
+		if (!isTime && !isAllocation)
+		{
+			continue;
+		}
+
+		auto it = current.find(entry.first);
+		if (it == current.end())
+		{
+			fprintf(log, "  missing  %s (baseline %.4f)\n", entry.first.c_str(), entry.second);
+			continue;
+		}
+
+		const double limit = isTime ?
+			entry.second * (1.0 + tolerances.time) + tolerances.timeSlackMs :
+			entry.second * (1.0 + tolerances.allocations);
+
+		if (it->second > limit)
+		{
+			fprintf(log, "  REGRESSED %s: %.4f -> %.4f (limit %.4f)\n", entry.first.c_str(), entry.second, it->second, limit);
+			regressions++;
+		}
+	}
+	return regressions;
+}
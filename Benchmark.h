@@ -0,0 +1,109 @@
+// Benchmark mode
+// A scenario is a seeded scene and a scripted camera path that depends only on the frame number,
+// so every run draws exactly the same frames. After some warm-up frames, a fixed number of frames
+// are measured and written as a JSON report: frame time percentiles, CPU profiler zones and heap
+// allocations per frame. A report can be compared against a stored baseline to find regressions.
+
+#pragma once
+
+#include "AllocationCounter.h"
+#include "FrameStats.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <string>
+#include <vector>
+
+struct BenchmarkScenario
+{
+	const char* name;
+	uint32_t seed;
+	unsigned int objectCount;
+	unsigned int lightCount;
+	unsigned int warmupFrames;
+	unsigned int frameCount;	// Measured frames, after the warm-up
+	float sceneRadius;			// Objects are scattered over a disc this size
+	float cameraRadius;
+	float cameraHeight;
+	float orbits;				// Times the camera circles the scene over the whole run
+};
+
+// Returns null if there's no scenario with the name
+const BenchmarkScenario* FindBenchmarkScenario(const char* name);
+unsigned int GetBenchmarkScenarioCount();
+const BenchmarkScenario& GetBenchmarkScenario(unsigned int index);
+
+// xorshift32 - the same sequence for a seed on every platform, unlike rand()
+class SeededRandom
+{
+public:
+	explicit SeededRandom(uint32_t seed) : mState(seed != 0 ? seed : 0x9E3779B9u) {}
+
+	uint32_t Next()
+	{
+		mState ^= mState << 13;
+		mState ^= mState >> 17;
+		mState ^= mState << 5;
+		return mState;
+	}
+
+	// Returns a float in [a, b)
+	float NextFloat(float a, float b)
+	{
+		return a + (b - a) * static_cast<float>(Next() >> 8) / 16777216.0f;
+	}
+
+private:
+	uint32_t mState;
+};
+
+struct BenchmarkObject
+{
+	float position[3];
+	float scale;
+	float rotationY;
+};
+
+struct BenchmarkLight
+{
+	float position[3];
+	float range;
+	float direction[3];		// Spot lights only
+	float cosOuterAngle;	// Spot lights only
+	float colour[3];
+	bool spot;
+};
+
+struct BenchmarkCamera
+{
+	float eye[3];
+	float target[3];
+};
+
+void GenerateBenchmarkScene(const BenchmarkScenario& scenario, std::vector<BenchmarkObject>& objects);
+
+// Point and spot lights scattered over the scene, just above the objects
+void GenerateBenchmarkLights(const BenchmarkScenario& scenario, std::vector<BenchmarkLight>& lights);
+
+// Frame counts from the start of the run, including the warm-up
+BenchmarkCamera GetBenchmarkCamera(const BenchmarkScenario& scenario, unsigned int frame);
+
+// How far a value can rise over the baseline before it's a regression. Times must exceed
+// both the relative tolerance and the absolute slack, so tiny zones don't trip on noise.
+struct BenchmarkTolerances
+{
+	double time = 0.10;
+	double timeSlackMs = 0.05;
+	double allocations = 0.05;
+};
+
+bool WriteBenchmarkReport(FILE* file, const BenchmarkScenario& scenario, const FrameStats& frameStats, const AllocationCounts& allocations);
+
+// Reads a JSON document into a map of its numbers, keyed by their path (e.g. "frame_ms.cpu.p99_ms")
+bool FlattenJson(const std::string& text, std::map<std::string, double>& values);
+
+// Compares the percentiles, zone times and allocations in two reports, printing each regression
+// to the log. Returns the number of regressions.
+unsigned int CompareBenchmarkReports(const std::map<std::string, double>& baseline, const std::map<std::string, double>& current,
+	const BenchmarkTolerances& tolerances, FILE* log);
@@ -0,0 +1,738 @@
+#include "BlockCompression.h"
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+
+namespace
+{
+	const unsigned int BlockPixels = 16;
+	const unsigned int RefineIterations = 3;
+
+	// BC7 4-bit index interpolation weights, out of 64
+	const int BC7Weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+	inline float Clamp255(float value)
+	{
+		return (std::min)((std::max)(value, 0.0f), 255.0f);
+	}
+
+	// Mean and principal axis of the block's pixels over the first channelCount channels.
+	// The axis is the direction the colours vary most in, found by power iteration.
+	void ComputePrincipalAxis(const float points[BlockPixels][4], unsigned int channelCount, float mean[4], float axis[4])
+	{
+		for (unsigned int c = 0; c < 4; c++)
+		{
+			mean[c] = 0.0f;
+			axis[c] = 0.0f;
+		}
+		for (unsigned int i = 0; i < BlockPixels; i++)
+		{
+			for (unsigned int c = 0; c < channelCount; c++)
+			{
+				mean[c] += points[i][c] / BlockPixels;
+			}
+		}
+
+		float covariance[4][4] = {};
+		for (unsigned int i = 0; i < BlockPixels; i++)
+		{
+			for (unsigned int a = 0; a < channelCount; a++)
+			{
+				for (unsigned int b = 0; b < channelCount; b++)
+				{
+					covariance[a][b] += (points[i][a] - mean[a]) * (points[i][b] - mean[b]);
+				}
+			}
+		}
+
+		for (unsigned int c = 0; c < channelCount; c++)
+		{
+			axis[c] = 1.0f;
+		}
+		for (unsigned int iteration = 0; iteration < 8; iteration++)
+		{
+			float next[4] = {};
+			float length = 0.0f;
+			for (unsigned int a = 0; a < channelCount; a++)
+			{
+				for (unsigned int b = 0; b < channelCount; b++)
+				{
+					next[a] += covariance[a][b] * axis[b];
+				}
+				length += next[a] * next[a];
+			}
+
+			// A flat block has no main direction, any will do
+			if (length < 1e-8f)
+			{
+				break;
+			}
+
+			length = std::sqrt(length);
+			for (unsigned int c = 0; c < channelCount; c++)
+			{
+				axis[c] = next[c] / length;
+			}
+		}
+	}
+
+	// Endpoints at the extremes of the pixels projected onto the principal axis
+	void ComputeAxisEndpoints(const float points[BlockPixels][4], unsigned int channelCount, float low[4], float high[4])
+	{
+		float mean[4];
+		float axis[4];
+		ComputePrincipalAxis(points, channelCount, mean, axis);
+
+		float minT = 0.0f;
+		float maxT = 0.0f;
+		for (unsigned int i = 0; i < BlockPixels; i++)
+		{
+			float t = 0.0f;
+			for (unsigned int c = 0; c < channelCount; c++)
+			{
+				t += (points[i][c] - mean[c]) * axis[c];
+			}
+			minT = (std::min)(minT, t);
+			maxT = (std::max)(maxT, t);
+		}
+
+		for (unsigned int c = 0; c < 4; c++)
+		{
+			low[c] = c < channelCount ? Clamp255(mean[c] + axis[c] * minT) : 0.0f;
+			high[c] = c < channelCount ? Clamp255(mean[c] + axis[c] * maxT) : 0.0f;
+		}
+	}
+
+	// Least squares endpoints for the given indices, where each pixel is weights[i] of the way
+	// from the first endpoint to the second. Returns false if the indices don't pin them down.
+	bool RefineEndpoints(const float points[BlockPixels][4], unsigned int channelCount, const float weights[BlockPixels], float first[4], float second[4])
+	{
+		float aa = 0.0f;
+		float ab = 0.0f;
+		float bb = 0.0f;
+		float ax[4] = {};
+		float bx[4] = {};
+		for (unsigned int i = 0; i < BlockPixels; i++)
+		{
+			const float b = weights[i];
+			const float a = 1.0f - b;
+			aa += a * a;
+			ab += a * b;
+			bb += b * b;
+			for (unsigned int c = 0; c < channelCount; c++)
+			{
+				ax[c] += a * points[i][c];
+				bx[c] += b * points[i][c];
+			}
+		}
+
+		const float determinant = aa * bb - ab * ab;
+		if (std::fabs(determinant) < 1e-6f)
+		{
+			return false;
+		}
+
+		for (unsigned int c = 0; c < channelCount; c++)
+		{
+			first[c] = Clamp255((bb * ax[c] - ab * bx[c]) / determinant);
+			second[c] = Clamp255((aa * bx[c] - ab * ax[c]) / determinant);
+		}
+		return true;
+	}
+
+	void ToPoints(const uint8_t pixels[BlockPixels * 4], float points[BlockPixels][4])
+	{
+		for (unsigned int i = 0; i < BlockPixels; i++)
+		{
+			for (unsigned int c = 0; c < 4; c++)
+			{
+				points[i][c] = pixels[i * 4 + c];
+			}
+		}
+	}
+
+	inline int SquaredDistance(const int a[4], const int b[4], unsigned int channelCount)
+	{
+		int distance = 0;
+		for (unsigned int c = 0; c < channelCount; c++)
+		{
+			distance += (a[c] - b[c]) * (a[c] - b[c]);
+		}
+		return distance;
+	}
+
+	// Bits written and read least significant first, as the BC7 layout is defined
+	class BitWriter
+	{
+	public:
+		explicit BitWriter(uint8_t* data) : mData(data), mPosition(0) { memset(data, 0, 16); }
+
+		void Write(uint32_t value, unsigned int bitCount)
+		{
+			for (unsigned int i = 0; i < bitCount; i++, mPosition++)
+			{
+				mData[mPosition / 8] |= static_cast<uint8_t>(((value >> i) & 1) << (mPosition % 8));
+			}
+		}
+
+	private:
+		uint8_t* mData;
+		unsigned int mPosition;
+	};
+
+	class BitReader
+	{
+	public:
+		explicit BitReader(const uint8_t* data) : mData(data), mPosition(0) {}
+
+		uint32_t Read(unsigned int bitCount)
+		{
+			uint32_t value = 0;
+			for (unsigned int i = 0; i < bitCount; i++, mPosition++)
+			{
+				value |= static_cast<uint32_t>((mData[mPosition / 8] >> (mPosition % 8)) & 1) << i;
+			}
+			return value;
+		}
+
+	private:
+		const uint8_t* mData;
+		unsigned int mPosition;
+	};
+
+	// BC1
+
+	uint16_t PackRgb565(const float colour[4])
+	{
+		const uint32_t r = static_cast<uint32_t>(colour[0] * 31.0f / 255.0f + 0.5f);
+		const uint32_t g = static_cast<uint32_t>(colour[1] * 63.0f / 255.0f + 0.5f);
+		const uint32_t b = static_cast<uint32_t>(colour[2] * 31.0f / 255.0f + 0.5f);
+		return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+	}
+
+	void UnpackRgb565(uint16_t packed, int colour[4])
+	{
+		const int r = (packed >> 11) & 31;
+		const int g = (packed >> 5) & 63;
+		const int b = packed & 31;
+		colour[0] = (r << 3) | (r >> 2);
+		colour[1] = (g << 2) | (g >> 4);
+		colour[2] = (b << 3) | (b >> 2);
+		colour[3] = 255;
+	}
+
+	// The four colour palette, for colour0 > colour1
+	void MakeBC1Palette(uint16_t colour0, uint16_t colour1, int palette[4][4])
+	{
+		UnpackRgb565(colour0, palette[0]);
+		UnpackRgb565(colour1, palette[1]);
+		for (unsigned int c = 0; c < 4; c++)
+		{
+			palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+			palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+		}
+	}
+
+	void EncodeBC1(const uint8_t pixels[BlockPixels * 4], uint8_t* block)
+	{
+		float points[BlockPixels][4];
+		ToPoints(pixels, points);
+
+		float first[4];
+		float second[4];
+		ComputeAxisEndpoints(points, 3, second, first);
+
+		// Interpolation weight of each index, from colour0 towards colour1
+		const float indexWeights[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+
+		int bestError = -1;
+		for (unsigned int iteration = 0; iteration < RefineIterations; iteration++)
+		{
+			uint16_t colour0 = PackRgb565(first);
+			uint16_t colour1 = PackRgb565(second);
+			if (colour0 < colour1)
+			{
+				std::swap(colour0, colour1);
+				std::swap(first, second);
+			}
+
+			int palette[4][4];
+			MakeBC1Palette(colour0, colour1, palette);
+
+			// Equal endpoints would select the three colour mode, but with every index 0 it doesn't matter
+			uint32_t indices = 0;
+			int error = 0;
+			float weights[BlockPixels];
+			for (unsigned int i = 0; i < BlockPixels; i++)
+			{
+				const int pixel[4] = { pixels[i * 4], pixels[i * 4 + 1], pixels[i * 4 + 2], 255 };
+				unsigned int bestIndex = 0;
+				int bestDistance = SquaredDistance(pixel, palette[0], 3);
+				for (unsigned int index = 1; index < 4 && colour0 != colour1; index++)
+				{
+					const int distance = SquaredDistance(pixel, palette[index], 3);
+					if (distance < bestDistance)
+					{
+						bestDistance = distance;
+						bestIndex = index;
+					}
+				}
+				indices |= bestIndex << (i * 2);
+				weights[i] = indexWeights[bestIndex];
+				error += bestDistance;
+			}
+
+			if (bestError < 0 || error < bestError)
+			{
+				bestError = error;
+				block[0] = static_cast<uint8_t>(colour0);
+				block[1] = static_cast<uint8_t>(colour0 >> 8);
+				block[2] = static_cast<uint8_t>(colour1);
+				block[3] = static_cast<uint8_t>(colour1 >> 8);
+				memcpy(block + 4, &indices, 4);
+			}
+
+			if (error == 0 || !RefineEndpoints(points, 3, weights, first, second))
+			{
+				break;
+			}
+		}
+	}
+
+	void DecodeBC1(const uint8_t* block, uint8_t pixels[BlockPixels * 4])
+	{
+		const uint16_t colour0 = static_cast<uint16_t>(block[0] | (block[1] << 8));
+		const uint16_t colour1 = static_cast<uint16_t>(block[2] | (block[3] << 8));
+		uint32_t indices;
+		memcpy(&indices, block + 4, 4);
+
+		int palette[4][4];
+		MakeBC1Palette(colour0, colour1, palette);
+		if (colour0 <= colour1)
+		{
+			// Three colours plus transparent black
+			for (unsigned int c = 0; c < 3; c++)
+			{
+				palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+				palette[3][c] = 0;
+			}
+			palette[3][3] = 0;
+		}
+
+		for (unsigned int i = 0; i < BlockPixels; i++)
+		{
+			const int* colour = palette[(indices >> (i * 2)) & 3];
+			for (unsigned int c = 0; c < 4; c++)
+			{
+				pixels[i * 4 + c] = static_cast<uint8_t>(colour[c]);
+			}
+		}
+	}
+
+	// BC4, one channel. BC5 is two of these.
+
+	void MakeBC4Palette(int value0, int value1, int palette[8])
+	{
+		palette[0] = value0;
+		palette[1] = value1;
+		if (value0 > value1)
+		{
+			for (int k = 1; k < 7; k++)
+			{
+				palette[k + 1] = ((7 - k) * value0 + k * value1 + 3) / 7;
+			}
+		}
+		else
+		{
+			for (int k = 1; k < 5; k++)
+			{
+				palette[k + 1] = ((5 - k) * value0 + k * value1 + 2) / 5;
+			}
+			palette[6] = 0;
+			palette[7] = 255;
+		}
+	}
+
+	void EncodeBC4Channel(const uint8_t pixels[BlockPixels * 4], unsigned int channel, uint8_t* block)
+	{
+		int low = 255;
+		int high = 0;
+		for (unsigned int i = 0; i < BlockPixels; i++)
+		{
+			low = (std::min)(low, static_cast<int>(pixels[i * 4 + channel]));
+			high = (std::max)(high, static_cast<int>(pixels[i * 4 + channel]));
+		}
+
+		// The eight value mode, which needs value0 > value1. A flat block uses index 0 throughout.
+		int palette[8];
+		MakeBC4Palette(high, low, palette);
+
+		uint64_t indices = 0;
+		for (unsigned int i = 0; i < BlockPixels && high != low; i++)
+		{
+			const int value = pixels[i * 4 + channel];
+			uint64_t bestIndex = 0;
+			int bestDistance = 256;
+			for (unsigned int index = 0; index < 8; index++)
+			{
+				const int distance = std::abs(value - palette[index]);
+				if (distance < bestDistance)
+				{
+					bestDistance = distance;
+					bestIndex = index;
+				}
+			}
+			indices |= bestIndex << (i * 3);
+		}
+
+		block[0] = static_cast<uint8_t>(high);
+		block[1] = static_cast<uint8_t>(low);
+		for (unsigned int i = 0; i < 6; i++)
+		{
+			block[2 + i] = static_cast<uint8_t>(indices >> (i * 8));
+		}
+	}
+
+	void DecodeBC4Channel(const uint8_t* block, unsigned int channel, uint8_t pixels[BlockPixels * 4])
+	{
+		int palette[8];
+		MakeBC4Palette(block[0], block[1], palette);
+
+		uint64_t indices = 0;
+		for (unsigned int i = 0; i < 6; i++)
+		{
+			indices |= static_cast<uint64_t>(block[2 + i]) << (i * 8);
+		}
+
+		for (unsigned int i = 0; i < BlockPixels; i++)
+		{
+			pixels[i * 4 + channel] = static_cast<uint8_t>(palette[(indices >> (i * 3)) & 7]);
+		}
+	}
+
+	// BC7 mode 6
+
+	// Splits an endpoint into 7-bit components and the shared low bit that fits it best
+	void QuantizeBC7Endpoint(const float endpoint[4], uint32_t quantized[4], uint32_t& pBit)
+	{
+		float bestError = -1.0f;
+		for (uint32_t p = 0; p < 2; p++)
+		{
+			uint32_t candidate[4];
+			float error = 0.0f;
+			for (unsigned int c = 0; c < 4; c++)
+			{
+				const float value = (endpoint[c] - p) * 0.5f;
+				candidate[c] = static_cast<uint32_t>((std::min)((std::max)(value + 0.5f, 0.0f), 127.0f));
+				const float difference = static_cast<float>(candidate[c] * 2 + p) - endpoint[c];
+				error += difference * difference;
+			}
+
+			if (bestError < 0.0f || error < bestError)
+			{
+				bestError = error;
+				pBit = p;
+				memcpy(quantized, candidate, sizeof(candidate));
+			}
+		}
+	}
+
+	void MakeBC7Palette(const uint32_t quantized0[4], uint32_t pBit0, const uint32_t quantized1[4], uint32_t pBit1, int palette[16][4])
+	{
+		for (unsigned int c = 0; c < 4; c++)
+		{
+			const int endpoint0 = static_cast<int>(quantized0[c] * 2 + pBit0);
+			const int endpoint1 = static_cast<int>(quantized1[c] * 2 + pBit1);
+			for (unsigned int index = 0; index < 16; index++)
+			{
+				palette[index][c] = ((64 - BC7Weights[index]) * endpoint0 + BC7Weights[index] * endpoint1 + 32) >> 6;
+			}
+		}
+	}
+
+	void EncodeBC7(const uint8_t pixels[BlockPixels * 4], uint8_t* block)
+	{
+		float points[BlockPixels][4];
+		ToPoints(pixels, points);
+
+		float first[4];
+		float second[4];
+		ComputeAxisEndpoints(points, 4, first, second);
+
+		int bestError = -1;
+		uint32_t bestQuantized[2][4] = {};
+		uint32_t bestPBits[2] = {};
+		unsigned int bestIndices[BlockPixels] = {};
+
+		for (unsigned int iteration = 0; iteration < RefineIterations; iteration++)
+		{
+			uint32_t quantized[2][4];
+			uint32_t pBits[2];
+			QuantizeBC7Endpoint(first, quantized[0], pBits[0]);
+			QuantizeBC7Endpoint(second, quantized[1], pBits[1]);
+
+			int palette[16][4];
+			MakeBC7Palette(quantized[0], pBits[0], quantized[1], pBits[1], palette);
+
+			unsigned int indices[BlockPixels];
+			float weights[BlockPixels];
+			int error = 0;
+			for (unsigned int i = 0; i < BlockPixels; i++)
+			{
+				const int pixel[4] = { pixels[i * 4], pixels[i * 4 + 1], pixels[i * 4 + 2], pixels[i * 4 + 3] };
+				unsigned int bestIndex = 0;
+				int bestDistance = SquaredDistance(pixel, palette[0], 4);
+				for (unsigned int index = 1; index < 16; index++)
+				{
+					const int distance = SquaredDistance(pixel, palette[index], 4);
+					if (distance < bestDistance)
+					{
+						bestDistance = distance;
+						bestIndex = index;
+					}
+				}
+				indices[i] = bestIndex;
+				weights[i] = BC7Weights[bestIndex] / 64.0f;
+				error += bestDistance;
+			}
+
+			if (bestError < 0 || error < bestError)
+			{
+				bestError = error;
+				memcpy(bestQuantized, quantized, sizeof(quantized));
+				memcpy(bestPBits, pBits, sizeof(pBits));
+				memcpy(bestIndices, indices, sizeof(indices));
+			}
+
+			if (error == 0 || !RefineEndpoints(points, 4, weights, first, second))
+			{
+				break;
+			}
+		}
+
+		// The first pixel's index is stored without its top bit, so it must be under 8
+		if (bestIndices[0] >= 8)
+		{
+			std::swap(bestQuantized[0], bestQuantized[1]);
+			std::swap(bestPBits[0], bestPBits[1]);
+			for (unsigned int& index : bestIndices)
+			{
+				index = 15 - index;
+			}
+		}
+
+		BitWriter writer(block);
+		writer.Write(1 << 6, 7);
+		for (unsigned int c = 0; c < 4; c++)
+		{
+			writer.Write(bestQuantized[0][c], 7);
+			writer.Write(bestQuantized[1][c], 7);
+		}
+		writer.Write(bestPBits[0], 1);
+		writer.Write(bestPBits[1], 1);
+		for (unsigned int i = 0; i < BlockPixels; i++)
+		{
+			writer.Write(bestIndices[i], i == 0 ? 3 : 4);
+		}
+	}
+
+	void DecodeBC7(const uint8_t* block, uint8_t pixels[BlockPixels * 4])
+	{
+		BitReader reader(block);
+		if (reader.Read(7) != (1 << 6))
+		{
+			// Not mode 6, which is all this decodes
+			memset(pixels, 0, BlockPixels * 4);
+			return;
+		}
+
+		uint32_t quantized[2][4];
+		for (unsigned int c = 0; c < 4; c++)
+		{
+			quantized[0][c] = reader.Read(7);
+			quantized[1][c] = reader.Read(7);
+		}
+		const uint32_t pBit0 = reader.Read(1);
+		const uint32_t pBit1 = reader.Read(1);
+
+		int palette[16][4];
+		MakeBC7Palette(quantized[0], pBit0, quantized[1], pBit1, palette);
+
+		for (unsigned int i = 0; i < BlockPixels; i++)
+		{
+			const int* colour = palette[reader.Read(i == 0 ? 3 : 4)];
+			for (unsigned int c = 0; c < 4; c++)
+			{
+				pixels[i * 4 + c] = static_cast<uint8_t>(colour[c]);
+			}
+		}
+	}
+
+	// Copies out the block at (blockX, blockY), repeating edge pixels past the image's edges
+	void ReadBlock(const TextureImage& image, uint32_t blockX, uint32_t blockY, uint8_t pixels[BlockPixels * 4])
+	{
+		for (uint32_t y = 0; y < 4; y++)
+		{
+			const uint32_t sourceY = (std::min)(blockY * 4 + y, image.height - 1);
+			for (uint32_t x = 0; x < 4; x++)
+			{
+				const uint32_t sourceX = (std::min)(blockX * 4 + x, image.width - 1);
+				memcpy(pixels + (y * 4 + x) * 4, &image.rgba[(static_cast<size_t>(sourceY) * image.width + sourceX) * 4], 4);
+			}
+		}
+	}
+}
+
+// Bytes per 4x4 block
+size_t GetBlockSize(EBlockFormat format)
+{
+	return format == BlockFormat_BC1 ? 8 : 16;
+}
+
+// Number of channels the format keeps, counting from red, for comparing quality
+unsigned int GetBlockChannelCount(EBlockFormat format)
+{
+	switch (format)
+	{
+	case BlockFormat_BC1:
+		return 3;
+	case BlockFormat_BC5:
+		return 2;
+	default:
+		return 4;
+	}
+}
+
+// Bytes for a whole image in the format
+size_t GetCompressedSize(EBlockFormat format, uint32_t width, uint32_t height)
+{
+	return static_cast<size_t>((width + 3) / 4) * ((height + 3) / 4) * GetBlockSize(format);
+}
+
+// Encodes one block of 16 RGBA pixels, in rows
+void EncodeBlock(EBlockFormat format, const uint8_t pixels[16 * 4], uint8_t* block)
+{
+	switch (format)
+	{
+	case BlockFormat_BC1:
+		EncodeBC1(pixels, block);
+		break;
+	case BlockFormat_BC5:
+		EncodeBC4Channel(pixels, 0, block);
+		EncodeBC4Channel(pixels, 1, block + 8);
+		break;
+	case BlockFormat_BC7:
+		EncodeBC7(pixels, block);
+		break;
+	}
+}
+
+void DecodeBlock(EBlockFormat format, const uint8_t* block, uint8_t pixels[16 * 4])
+{
+	switch (format)
+	{
+	case BlockFormat_BC1:
+		DecodeBC1(block, pixels);
+		break;
+	case BlockFormat_BC5:
+		for (unsigned int i = 0; i < BlockPixels; i++)
+		{
+			pixels[i * 4 + 2] = 0;
+			pixels[i * 4 + 3] = 255;
+		}
+		DecodeBC4Channel(block, 0, pixels);
+		DecodeBC4Channel(block + 8, 1, pixels);
+		break;
+	case BlockFormat_BC7:
+		DecodeBC7(block, pixels);
+		break;
+	}
+}
+
+// Compresses a whole image. Blocks hanging over the edge repeat the edge pixels. Rows of
+// blocks are shared out over the job system's workers, and the calling thread, if there
+// is one. Returns once every row is done.
+void CompressImage(const TextureImage& image, EBlockFormat format, JobSystem* jobSystem, std::vector<uint8_t>& output)
+{
+	const uint32_t blocksX = (image.width + 3) / 4;
+	const uint32_t blocksY = (image.height + 3) / 4;
+	const size_t blockSize = GetBlockSize(format);
+	output.resize(static_cast<size_t>(blocksX) * blocksY * blockSize);
+
+	// Rows are handed out one at a time, so faster threads take more of them
+	std::atomic<uint32_t> nextRow(0);
+	uint8_t* blocks = output.data();
+	auto compressRows = [&image, format, blocksX, blocksY, blockSize, blocks, &nextRow]()
+	{
+		uint8_t pixels[BlockPixels * 4];
+		for (uint32_t blockY = nextRow++; blockY < blocksY; blockY = nextRow++)
+		{
+			for (uint32_t blockX = 0; blockX < blocksX; blockX++)
+			{
+				ReadBlock(image, blockX, blockY, pixels);
+				EncodeBlock(format, pixels, blocks + (static_cast<size_t>(blockY) * blocksX + blockX) * blockSize);
+			}
+		}
+	};
+
+	const unsigned int helperCount = jobSystem != nullptr ? (std::min)(jobSystem->GetThreadCount(), blocksY - 1) : 0;
+	if (helperCount == 0)
+	{
+		compressRows();
+		return;
+	}
+
+	std::mutex mutex;
+	std::condition_variable finished;
+	unsigned int running = helperCount;
+	for (unsigned int i = 0; i < helperCount; i++)
+	{
+		jobSystem->Submit([&compressRows, &mutex, &finished, &running]()
+		{
+			compressRows();
+
+			std::lock_guard<std::mutex> lock(mutex);
+			if (--running == 0)
+			{
+				finished.notify_one();
+			}
+		});
+	}
+
+	compressRows();
+
+	std::unique_lock<std::mutex> lock(mutex);
+	finished.wait(lock, [&running]() { return running == 0; });
+}
+
+// Decompresses a whole image, e.g. to compare with the original
+void DecompressImage(const uint8_t* blocks, uint32_t width, uint32_t height, EBlockFormat format, TextureImage& image)
+{
+	const uint32_t blocksX = (width + 3) / 4;
+	const uint32_t blocksY = (height + 3) / 4;
+	const size_t blockSize = GetBlockSize(format);
+	image.Resize(width, height);
+
+	uint8_t pixels[BlockPixels * 4];
+	for (uint32_t blockY = 0; blockY < blocksY; blockY++)
+	{
+		for (uint32_t blockX = 0; blockX < blocksX; blockX++)
+		{
+			DecodeBlock(format, blocks + (static_cast<size_t>(blockY) * blocksX + blockX) * blockSize, pixels);
+
+			// Pixels past the image's edges are dropped
+			for (uint32_t y = 0; y < 4 && blockY * 4 + y < height; y++)
+			{
+				for (uint32_t x = 0; x < 4 && blockX * 4 + x < width; x++)
+				{
+					memcpy(&image.rgba[(static_cast<size_t>(blockY * 4 + y) * width + blockX * 4 + x) * 4], pixels + (y * 4 + x) * 4, 4);
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,51 @@
+// BC block compression
+// Encodes 4x4 pixel blocks to the BC formats GPUs sample directly, and decodes them again
+// for measuring quality. Images are split into rows of blocks compressed in parallel on the
+// job system.
+//
+//   BC1	RGB, 8 bytes a block (8:1 against RGBA8). Alpha is dropped.
+//   BC5	Two channels from red and green, 16 bytes a block (4:1). For normal maps.
+//   BC7	RGBA, 16 bytes a block (4:1). Only mode 6 (one subset, 7-bit endpoints with a
+//			shared bit, 4-bit indices) is produced, which does well on most content and
+//			keeps the encoder simple. The decoder only handles that mode too.
+//
+// Endpoints come from the block's principal axis, then are refined by least squares against
+// the chosen indices.
+
+#pragma once
+
+#include "TextureImage.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class JobSystem;
+
+enum EBlockFormat
+{
+	BlockFormat_BC1,
+	BlockFormat_BC5,
+	BlockFormat_BC7
+};
+
+// Bytes per 4x4 block
+size_t GetBlockSize(EBlockFormat format);
+
+// Number of channels the format keeps, counting from red, for comparing quality
+unsigned int GetBlockChannelCount(EBlockFormat format);
+
+// Bytes for a whole image in the format
+size_t GetCompressedSize(EBlockFormat format, uint32_t width, uint32_t height);
+
+// Encodes one block of 16 RGBA pixels, in rows
+void EncodeBlock(EBlockFormat format, const uint8_t pixels[16 * 4], uint8_t* block);
+void DecodeBlock(EBlockFormat format, const uint8_t* block, uint8_t pixels[16 * 4]);
+
+// Compresses a whole image. Blocks hanging over the edge repeat the edge pixels. Rows of
+// blocks are shared out over the job system's workers, and the calling thread, if there
+// is one. Returns once every row is done.
+void CompressImage(const TextureImage& image, EBlockFormat format, JobSystem* jobSystem, std::vector<uint8_t>& output);
+
+// Decompresses a whole image, e.g. to compare with the original
+void DecompressImage(const uint8_t* blocks, uint32_t width, uint32_t height, EBlockFormat format, TextureImage& image);
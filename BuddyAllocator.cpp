@@ -0,0 +1,159 @@
+#include "BuddyAllocator.h"
+#include "Align.h"
+
+#include <stdexcept>
+
+const uint64_t BuddyAllocator::InvalidOffset;
+
+// Capacity and minimum block size must both be powers of two
+BuddyAllocator::BuddyAllocator(uint64_t capacity, uint64_t minBlockSize) :
+	mCapacity(capacity),
+	mMinBlockSize(minBlockSize),
+	mMaxOrder(0),
+	mAllocatedBytes(0)
+{
+	if (!IsPowerOfTwo(capacity) || !IsPowerOfTwo(minBlockSize) || minBlockSize > capacity)
+	{
+		throw std::invalid_argument("BuddyAllocator sizes must be powers of two");
+	}
+
+	while (BlockSize(mMaxOrder) < capacity)
+	{
+		mMaxOrder++;
+	}
+
+	// Everything starts as one free block
+	mFreeBlocks.resize(mMaxOrder + 1);
+	mFreeBlocks[mMaxOrder].insert(0);
+}
+
+// Returns the offset of a block of at least size bytes, or InvalidOffset if there is no room
+uint64_t BuddyAllocator::Allocate(uint64_t size)
+{
+	if (size == 0 || size > mCapacity)
+	{
+		return InvalidOffset;
+	}
+
+	const uint32_t order = OrderFor(size);
+
+	// Find the smallest free block that is big enough
+	uint32_t foundOrder = order;
+	while (foundOrder <= mMaxOrder && mFreeBlocks[foundOrder].empty())
+	{
+		foundOrder++;
+	}
+
+	if (foundOrder > mMaxOrder)
+	{
+		return InvalidOffset;
+	}
+
+	const uint64_t offset = *mFreeBlocks[foundOrder].begin();
+	mFreeBlocks[foundOrder].erase(mFreeBlocks[foundOrder].begin());
+
+	// Split it down to size, keeping the lower half each time and freeing the upper half
+	while (foundOrder > order)
+	{
+		foundOrder--;
+		mFreeBlocks[foundOrder].insert(offset + BlockSize(foundOrder));
+	}
+
+	mAllocatedOrders[offset] = order;
+	mAllocatedBytes += BlockSize(order);
+	return offset;
+}
+
+// Frees a block returned by Allocate
+void BuddyAllocator::Free(uint64_t offset)
+{
+	auto it = mAllocatedOrders.find(offset);
+	if (it == mAllocatedOrders.end())
+	{
+		return;
+	}
+
+	uint32_t order = it->second;
+	mAllocatedOrders.erase(it);
+	mAllocatedBytes -= BlockSize(order);
+
+	// Merge with the buddy for as long as it is free too
+	while (order < mMaxOrder)
+	{
+		const uint64_t buddy = offset ^ BlockSize(order);
+		auto buddyIt = mFreeBlocks[order].find(buddy);
+		if (buddyIt == mFreeBlocks[order].end())
+		{
+			break;
+		}
+
+		mFreeBlocks[order].erase(buddyIt);
+		offset = offset < buddy ? offset : buddy;
+		order++;
+	}
+
+	mFreeBlocks[order].insert(offset);
+}
+
+// Returns the size of the block a size request would use
+uint64_t BuddyAllocator::GetBlockSizeFor(uint64_t size) const
+{
+	return BlockSize(OrderFor(size));
+}
+
+// Returns the size of an allocated block, or 0 if offset isn't allocated
+uint64_t BuddyAllocator::GetAllocatedBlockSize(uint64_t offset) const
+{
+	auto it = mAllocatedOrders.find(offset);
+	return it != mAllocatedOrders.end() ? BlockSize(it->second) : 0;
+}
+
+// Returns true if a block for size bytes could currently be allocated
+bool BuddyAllocator::CanAllocate(uint64_t size) const
+{
+	if (size == 0 || size > mCapacity)
+	{
+		return false;
+	}
+
+	for (uint32_t order = OrderFor(size); order <= mMaxOrder; order++)
+	{
+		if (!mFreeBlocks[order].empty())
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+BuddyAllocator::Stats BuddyAllocator::GetStats() const
+{
+	Stats stats = {};
+	stats.capacity = mCapacity;
+	stats.allocatedBytes = mAllocatedBytes;
+	stats.freeBytes = mCapacity - mAllocatedBytes;
+	stats.allocationCount = static_cast<uint32_t>(mAllocatedOrders.size());
+
+	for (uint32_t order = 0; order <= mMaxOrder; order++)
+	{
+		stats.freeBlockCount += static_cast<uint32_t>(mFreeBlocks[order].size());
+		if (!mFreeBlocks[order].empty())
+		{
+			stats.largestFreeBlock = BlockSize(order);
+		}
+	}
+
+	stats.fragmentation = stats.freeBytes > 0 ?
+		1.0f - static_cast<float>(stats.largestFreeBlock) / static_cast<float>(stats.freeBytes) : 0.0f;
+	return stats;
+}
+
+uint32_t BuddyAllocator::OrderFor(uint64_t size) const
+{
+	uint32_t order = 0;
+	while (BlockSize(order) < size)
+	{
+		order++;
+	}
+	return order;
+}
@@ -0,0 +1,65 @@
+// Buddy allocator
+// Hands out power-of-two sized blocks from a power-of-two sized range. Freed blocks are merged
+// with their buddy whenever both halves are free, which keeps external fragmentation low.
+// Only offsets are managed, so it can sit on top of any memory (e.g. GPU heaps).
+
+#pragma once
+
+#include <cstdint>
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+class BuddyAllocator
+{
+public:
+	static const uint64_t InvalidOffset = ~0ull;
+
+	struct Stats
+	{
+		uint64_t capacity;
+		uint64_t allocatedBytes;	// Sum of allocated block sizes
+		uint64_t freeBytes;
+		uint64_t largestFreeBlock;
+		uint32_t allocationCount;
+		uint32_t freeBlockCount;
+
+		// 0 when all free memory is one block, approaching 1 as it is split into small pieces
+		float fragmentation;
+	};
+
+	// Capacity and minimum block size must both be powers of two
+	BuddyAllocator(uint64_t capacity, uint64_t minBlockSize);
+
+	// Returns the offset of a block of at least size bytes, or InvalidOffset if there is no room
+	uint64_t Allocate(uint64_t size);
+
+	// Frees a block returned by Allocate
+	void Free(uint64_t offset);
+
+	// Returns the size of the block a size request would use
+	uint64_t GetBlockSizeFor(uint64_t size) const;
+
+	// Returns the size of an allocated block, or 0 if offset isn't allocated
+	uint64_t GetAllocatedBlockSize(uint64_t offset) const;
+
+	// Returns true if a block for size bytes could currently be allocated
+	bool CanAllocate(uint64_t size) const;
+
+	bool IsEmpty() const { return mAllocatedOrders.empty(); }
+	uint64_t GetCapacity() const { return mCapacity; }
+	Stats GetStats() const;
+
+private:
+	uint32_t OrderFor(uint64_t size) const;
+	uint64_t BlockSize(uint32_t order) const { return mMinBlockSize << order; }
+
+	uint64_t mCapacity;
+	uint64_t mMinBlockSize;
+	uint32_t mMaxOrder;
+
+	// Free blocks for each order, sorted so allocations favour low offsets
+	std::vector<std::set<uint64_t>> mFreeBlocks;
+	std::unordered_map<uint64_t, uint32_t> mAllocatedOrders;
+	uint64_t mAllocatedBytes;
+};
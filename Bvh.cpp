@@ -0,0 +1,1217 @@
+#include "Bvh.h"
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+#if BVH_SIMD
+#include <emmintrin.h>
+#endif
+
+const uint32_t Bvh::MaxLeafSize;
+const uint32_t Bvh::BinCount;
+const uint32_t Bvh::EmptyChild;
+const uint32_t BvhHit::NoTriangle;
+
+namespace
+{
+	// Cost of visiting a node, relative to testing a primitive
+	const float TraversalCost = 1.0f;
+
+	// Past this depth in the binary tree, nodes are split in half rather than by cost, so the
+	// depth, and the traversal stack, stay bounded whatever the input
+	const uint32_t MaxSahDepth = 48;
+	const uint32_t TraversalStackSize = 256;
+
+	// Splitting for parallel builds: subtrees are made small enough for each thread to get a few
+	const uint32_t SubtreesPerThread = 4;
+	const uint32_t MinSubtreeSize = 1024;
+	const uint32_t ParallelBinningMinCount = 64 * 1024;
+	const uint32_t BinningChunkSize = 16 * 1024;
+
+	// Stands in for zero direction components, so their inverse is large but finite
+	const float MinDirection = 1e-20f;
+
+	inline float Cross(const float a[3], const float b[3], unsigned int axis)
+	{
+		const unsigned int i = (axis + 1) % 3;
+		const unsigned int j = (axis + 2) % 3;
+		return a[i] * b[j] - a[j] * b[i];
+	}
+
+	inline float Dot(const float a[3], const float b[3])
+	{
+		return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+	}
+
+	// Affine transforms as four rows of three, for row vectors
+	void TransformPoint(const float m[12], const float p[3], float result[3])
+	{
+		for (unsigned int axis = 0; axis < 3; axis++)
+		{
+			result[axis] = p[0] * m[axis] + p[1] * m[3 + axis] + p[2] * m[6 + axis] + m[9 + axis];
+		}
+	}
+
+	void TransformDirection(const float m[12], const float d[3], float result[3])
+	{
+		for (unsigned int axis = 0; axis < 3; axis++)
+		{
+			result[axis] = d[0] * m[axis] + d[1] * m[3 + axis] + d[2] * m[6 + axis];
+		}
+	}
+
+	// The nearest point along the ray inside the box, which is 0 if the ray starts inside it
+	bool IntersectBox(const BvhRay& ray, const BvhBounds& bounds, float maxDistance, float& distance)
+	{
+		float nearest = 0.0f;
+		float furthest = maxDistance;
+		for (unsigned int axis = 0; axis < 3; axis++)
+		{
+			const float inverse = 1.0f / (std::fabs(ray.direction[axis]) < MinDirection ? MinDirection : ray.direction[axis]);
+			float t0 = (bounds.min[axis] - ray.origin[axis]) * inverse;
+			float t1 = (bounds.max[axis] - ray.origin[axis]) * inverse;
+			if (t0 > t1)
+			{
+				std::swap(t0, t1);
+			}
+			nearest = (std::max)(nearest, t0);
+			furthest = (std::min)(furthest, t1);
+		}
+		distance = nearest;
+		return nearest <= furthest;
+	}
+}
+
+BvhBounds BvhBounds::Empty()
+{
+	BvhBounds bounds;
+	for (unsigned int axis = 0; axis < 3; axis++)
+	{
+		bounds.min[axis] = FLT_MAX;
+		bounds.max[axis] = -FLT_MAX;
+	}
+	return bounds;
+}
+
+void BvhBounds::Grow(const float point[3])
+{
+	for (unsigned int axis = 0; axis < 3; axis++)
+	{
+		min[axis] = (std::min)(min[axis], point[axis]);
+		max[axis] = (std::max)(max[axis], point[axis]);
+	}
+}
+
+void BvhBounds::Grow(const BvhBounds& other)
+{
+	for (unsigned int axis = 0; axis < 3; axis++)
+	{
+		min[axis] = (std::min)(min[axis], other.min[axis]);
+		max[axis] = (std::max)(max[axis], other.max[axis]);
+	}
+}
+
+float BvhBounds::GetSurfaceArea() const
+{
+	const float x = max[0] - min[0];
+	const float y = max[1] - min[1];
+	const float z = max[2] - min[2];
+	return x < 0.0f || y < 0.0f || z < 0.0f ? 0.0f : 2.0f * (x * y + y * z + z * x);
+}
+
+// A node of the binary tree made while building, before it's collapsed
+struct Bvh::BuildNode
+{
+	BvhBounds bounds;
+	uint32_t first;		// Leaves only
+	uint32_t count;		// 0 for inner nodes
+	uint32_t left;		// Inner nodes only
+	uint32_t right;
+};
+
+// Primitives still to be split, and the build node they'll become
+struct Bvh::BuildRange
+{
+	uint32_t node;
+	uint32_t first;
+	uint32_t count;
+	uint32_t depth;
+	BvhBounds bounds;
+	BvhBounds centroidBounds;
+};
+
+// Splits ranges of primitives. Ranges that don't overlap can be split on different threads at once.
+// Each primitive's bounds are copied next to its index and moved with it, so binning reads them
+// in order, and with SSE a whole corner at a time.
+class Bvh::Builder
+{
+public:
+	struct Split
+	{
+		unsigned int axis;
+		uint32_t bin;		// Primitives in lower bins go left
+		bool half;			// Split by position in the range instead, when centres can't be told apart
+	};
+
+	Builder(const BvhBounds* bounds, uint32_t count, JobSystem* jobSystem) :
+		mJobSystem(jobSystem),
+		mReferences(count)
+	{
+		for (uint32_t i = 0; i < count; i++)
+		{
+			Reference& reference = mReferences[i];
+			for (unsigned int axis = 0; axis < 3; axis++)
+			{
+				reference.min[axis] = bounds[i].min[axis];
+				reference.max[axis] = bounds[i].max[axis];
+			}
+			reference.unused = 0.0f;
+			reference.primitive = i;
+		}
+	}
+
+	// The primitives in the order the leaves refer to them
+	void GetPrimitives(uint32_t* primitives) const
+	{
+		for (size_t i = 0; i < mReferences.size(); i++)
+		{
+			primitives[i] = mReferences[i].primitive;
+		}
+	}
+
+	BuildRange MakeRange(uint32_t node, uint32_t first, uint32_t count, uint32_t depth) const
+	{
+		BuildRange range;
+		range.node = node;
+		range.first = first;
+		range.count = count;
+		range.depth = depth;
+		range.bounds = BvhBounds::Empty();
+		range.centroidBounds = BvhBounds::Empty();
+		for (uint32_t i = first; i < first + count; i++)
+		{
+			const Reference& reference = mReferences[i];
+			range.bounds.Grow(reference.min);
+			range.bounds.Grow(reference.max);
+
+			float centroid[3];
+			GetCentroid(reference, centroid);
+			range.centroidBounds.Grow(centroid);
+		}
+		return range;
+	}
+
+	// Finds the split with the lowest cost, returning false if the range is better as a leaf.
+	// Binning is spread over the job system for large ranges.
+	bool FindSplit(const BuildRange& range, Split& split) const
+	{
+		split.axis = 0;
+		split.bin = 0;
+		split.half = false;
+
+		float extent[3];
+		bool canBin = false;
+		for (unsigned int axis = 0; axis < 3; axis++)
+		{
+			extent[axis] = range.centroidBounds.max[axis] - range.centroidBounds.min[axis];
+			canBin = canBin || extent[axis] > 0.0f;
+		}
+
+		if (!canBin || range.depth >= MaxSahDepth)
+		{
+			split.half = true;
+			return range.count > MaxLeafSize;
+		}
+
+		// Bins for each axis. Large ranges are binned in chunks over the job system, then summed.
+		Bin allBins[3 * BinCount];
+		const uint32_t chunkCount = mJobSystem != nullptr && range.count >= ParallelBinningMinCount ? (range.count + BinningChunkSize - 1) / BinningChunkSize : 1;
+		if (chunkCount == 1)
+		{
+			FillBins(range, range.first, range.first + range.count, allBins);
+		}
+		else
+		{
+			std::vector<Bin> chunkBins(static_cast<size_t>(chunkCount) * 3 * BinCount);
+			RunTasks(mJobSystem, chunkCount, [this, &range, &chunkBins, chunkCount](unsigned int chunk)
+			{
+				const uint32_t chunkSize = (range.count + chunkCount - 1) / chunkCount;
+				const uint32_t begin = range.first + chunk * chunkSize;
+				const uint32_t end = (std::min)(begin + chunkSize, range.first + range.count);
+				FillBins(range, begin, end, &chunkBins[static_cast<size_t>(chunk) * 3 * BinCount]);
+			});
+			for (uint32_t chunk = 0; chunk < chunkCount; chunk++)
+			{
+				for (uint32_t bin = 0; bin < 3 * BinCount; bin++)
+				{
+					allBins[bin].Grow(chunkBins[chunk * 3 * BinCount + bin]);
+				}
+			}
+		}
+
+		// Costs are left scaled by the node's surface area, which every term shares
+		float bestCost = FLT_MAX;
+		for (unsigned int axis = 0; axis < 3; axis++)
+		{
+			if (extent[axis] <= 0.0f)
+			{
+				continue;
+			}
+
+			// Sweep from the right to find the cost of everything above each split, then from the left
+			const Bin* bins = &allBins[axis * BinCount];
+			float rightCosts[BinCount];
+			Bin right;
+			for (uint32_t bin = BinCount - 1; bin > 0; bin--)
+			{
+				right.Grow(bins[bin]);
+				rightCosts[bin] = right.count > 0 ? right.count * right.GetSurfaceArea() : -1.0f;
+			}
+
+			// Splits next to an empty bin cost the same as the one before it, so aren't tried
+			Bin left;
+			for (uint32_t bin = 1; bin < BinCount; bin++)
+			{
+				if (bins[bin - 1].count == 0)
+				{
+					continue;
+				}
+				left.Grow(bins[bin - 1]);
+				if (rightCosts[bin] < 0.0f)
+				{
+					continue;
+				}
+
+				const float cost = left.count * left.GetSurfaceArea() + rightCosts[bin];
+				if (cost < bestCost)
+				{
+					bestCost = cost;
+					split.axis = axis;
+					split.bin = bin;
+				}
+			}
+		}
+
+		if (bestCost == FLT_MAX)
+		{
+			split.half = true;
+			return range.count > MaxLeafSize;
+		}
+
+		const float area = range.bounds.GetSurfaceArea();
+		const float splitCost = TraversalCost * area + bestCost;
+		const float leafCost = range.count * area;
+		return range.count > MaxLeafSize || splitCost < leafCost;
+	}
+
+	// Moves the range's primitives to either side of the split, filling in the two halves
+	void Partition(const BuildRange& range, const Split& split, uint32_t leftNode, BuildRange& left, BuildRange& right)
+	{
+		uint32_t leftCount = range.count / 2;
+		if (!split.half)
+		{
+			const float minCentroid = range.centroidBounds.min[split.axis];
+			const float scale = BinCount / (range.centroidBounds.max[split.axis] - minCentroid);
+			const auto first = mReferences.begin() + range.first;
+			const auto middle = std::partition(first, first + range.count, [&split, minCentroid, scale](const Reference& reference)
+			{
+				float centroid[3];
+				GetCentroid(reference, centroid);
+				return GetBin(centroid[split.axis], minCentroid, scale) < split.bin;
+			});
+			leftCount = static_cast<uint32_t>(middle - first);
+		}
+
+		left = MakeRange(leftNode, range.first, leftCount, range.depth + 1);
+		right = MakeRange(leftNode + 1, range.first + leftCount, range.count - leftCount, range.depth + 1);
+	}
+
+	// Builds the whole tree below the range's node into nodes
+	void BuildSubtree(std::vector<BuildNode>& nodes, const BuildRange& subtree)
+	{
+		std::vector<BuildRange> stack(1, subtree);
+		while (!stack.empty())
+		{
+			const BuildRange range = stack.back();
+			stack.pop_back();
+
+			Split split;
+			if (!FindSplit(range, split))
+			{
+				SetLeaf(nodes[range.node], range);
+				continue;
+			}
+
+			const uint32_t leftNode = static_cast<uint32_t>(nodes.size());
+			nodes.resize(nodes.size() + 2);
+			BuildRange left;
+			BuildRange right;
+			Partition(range, split, leftNode, left, right);
+			SetInner(nodes[range.node], range, leftNode);
+			stack.push_back(right);
+			stack.push_back(left);
+		}
+	}
+
+	static void SetLeaf(BuildNode& node, const BuildRange& range)
+	{
+		node.bounds = range.bounds;
+		node.first = range.first;
+		node.count = range.count;
+		node.left = 0;
+		node.right = 0;
+	}
+
+	static void SetInner(BuildNode& node, const BuildRange& range, uint32_t leftNode)
+	{
+		node.bounds = range.bounds;
+		node.first = 0;
+		node.count = 0;
+		node.left = leftNode;
+		node.right = leftNode + 1;
+	}
+
+private:
+	// Laid out so each corner loads as four floats, the fourth of which is ignored
+	struct Reference
+	{
+		float min[3];
+		float unused;
+		float max[3];
+		uint32_t primitive;
+	};
+
+	struct Bin
+	{
+		float min[4];
+		float max[4];
+		uint32_t count;
+
+		Bin() :
+			count(0)
+		{
+			for (unsigned int axis = 0; axis < 4; axis++)
+			{
+				min[axis] = FLT_MAX;
+				max[axis] = -FLT_MAX;
+			}
+		}
+
+		void Grow(const Bin& other)
+		{
+			for (unsigned int axis = 0; axis < 3; axis++)
+			{
+				min[axis] = (std::min)(min[axis], other.min[axis]);
+				max[axis] = (std::max)(max[axis], other.max[axis]);
+			}
+			count += other.count;
+		}
+
+		float GetSurfaceArea() const
+		{
+			BvhBounds bounds;
+			for (unsigned int axis = 0; axis < 3; axis++)
+			{
+				bounds.min[axis] = min[axis];
+				bounds.max[axis] = max[axis];
+			}
+			return bounds.GetSurfaceArea();
+		}
+	};
+
+	static void GetCentroid(const Reference& reference, float centroid[3])
+	{
+		for (unsigned int axis = 0; axis < 3; axis++)
+		{
+			centroid[axis] = (reference.min[axis] + reference.max[axis]) * 0.5f;
+		}
+	}
+
+	// The SSE binning below works this out in the same steps, so primitives are always
+	// partitioned into the bins they were counted in
+	static uint32_t GetBin(float centroid, float minCentroid, float scale)
+	{
+		return static_cast<uint32_t>((std::min)((centroid - minCentroid) * scale, BinCount - 1.0f));
+	}
+
+	// bins is BinCount per axis
+	void FillBins(const BuildRange& range, uint32_t begin, uint32_t end, Bin* bins) const
+	{
+		float scale[3];
+		for (unsigned int axis = 0; axis < 3; axis++)
+		{
+			const float extent = range.centroidBounds.max[axis] - range.centroidBounds.min[axis];
+			scale[axis] = extent > 0.0f ? BinCount / extent : 0.0f;
+		}
+
+#if BVH_SIMD
+		// The primitive index in the fourth float of max is masked off before any arithmetic,
+		// as it would be a denormal
+		const __m128 minCentroid = _mm_setr_ps(range.centroidBounds.min[0], range.centroidBounds.min[1], range.centroidBounds.min[2], 0.0f);
+		const __m128 scales = _mm_setr_ps(scale[0], scale[1], scale[2], 0.0f);
+		const __m128 lastBin = _mm_set1_ps(BinCount - 1.0f);
+		const __m128 half = _mm_set1_ps(0.5f);
+		const __m128 xyzMask = _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0));
+		for (uint32_t i = begin; i < end; i++)
+		{
+			const Reference& reference = mReferences[i];
+			const __m128 lower = _mm_loadu_ps(reference.min);
+			const __m128 upper = _mm_and_ps(_mm_loadu_ps(reference.max), xyzMask);
+			const __m128 centroid = _mm_mul_ps(_mm_add_ps(lower, upper), half);
+			const __m128i binIndices = _mm_cvttps_epi32(_mm_min_ps(_mm_mul_ps(_mm_sub_ps(centroid, minCentroid), scales), lastBin));
+
+			int32_t indices[4];
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(indices), binIndices);
+			for (unsigned int axis = 0; axis < 3; axis++)
+			{
+				Bin& bin = bins[axis * BinCount + indices[axis]];
+				_mm_storeu_ps(bin.min, _mm_min_ps(_mm_loadu_ps(bin.min), lower));
+				_mm_storeu_ps(bin.max, _mm_max_ps(_mm_loadu_ps(bin.max), upper));
+				bin.count++;
+			}
+		}
+#else
+		for (uint32_t i = begin; i < end; i++)
+		{
+			const Reference& reference = mReferences[i];
+			float centroid[3];
+			GetCentroid(reference, centroid);
+			for (unsigned int axis = 0; axis < 3; axis++)
+			{
+				Bin& bin = bins[axis * BinCount + GetBin(centroid[axis], range.centroidBounds.min[axis], scale[axis])];
+				for (unsigned int corner = 0; corner < 3; corner++)
+				{
+					bin.min[corner] = (std::min)(bin.min[corner], reference.min[corner]);
+					bin.max[corner] = (std::max)(bin.max[corner], reference.max[corner]);
+				}
+				bin.count++;
+			}
+		}
+#endif
+	}
+
+	JobSystem* mJobSystem;
+	std::vector<Reference> mReferences;
+};
+
+
+Bvh::Bvh() :
+	mBounds(BvhBounds::Empty())
+{
+}
+
+// Builds the tree over the primitives' bounds. The job system's workers help with large trees.
+void Bvh::Build(const BvhBounds* bounds, uint32_t count, JobSystem* jobSystem)
+{
+	mNodes.clear();
+	mPrimitives.resize(count);
+	mBounds = BvhBounds::Empty();
+	if (count == 0)
+	{
+		return;
+	}
+
+	Builder builder(bounds, count, jobSystem);
+	std::vector<BuildNode> buildNodes(1);
+	const BuildRange root = builder.MakeRange(0, 0, count, 0);
+	mBounds = root.bounds;
+
+	// Split the top of the tree here until the pieces are small enough to share out
+	const uint32_t threadCount = jobSystem != nullptr ? jobSystem->GetThreadCount() + 1 : 1;
+	const uint32_t subtreeSize = threadCount > 1 ? (std::max)(count / (threadCount * SubtreesPerThread), MinSubtreeSize) : count;
+
+	std::vector<BuildRange> pending(1, root);
+	std::vector<BuildRange> subtrees;
+	while (!pending.empty())
+	{
+		const BuildRange range = pending.back();
+		pending.pop_back();
+
+		Builder::Split split;
+		if (range.count <= subtreeSize || !builder.FindSplit(range, split))
+		{
+			subtrees.push_back(range);
+			continue;
+		}
+
+		const uint32_t leftNode = static_cast<uint32_t>(buildNodes.size());
+		buildNodes.resize(buildNodes.size() + 2);
+		BuildRange left;
+		BuildRange right;
+		builder.Partition(range, split, leftNode, left, right);
+		Builder::SetInner(buildNodes[range.node], range, leftNode);
+		pending.push_back(right);
+		pending.push_back(left);
+	}
+
+	// Each subtree is built into its own nodes, with its root first
+	std::vector<std::vector<BuildNode>> subtreeNodes(subtrees.size());
+	RunTasks(jobSystem, static_cast<unsigned int>(subtrees.size()), [&builder, &subtrees, &subtreeNodes](unsigned int index)
+	{
+		BuildRange subtree = subtrees[index];
+		subtree.node = 0;
+		subtreeNodes[index].resize(1);
+		builder.BuildSubtree(subtreeNodes[index], subtree);
+	});
+
+	// Then moved into the tree, the root taking the place the subtree was split off at
+	for (size_t i = 0; i < subtrees.size(); i++)
+	{
+		const std::vector<BuildNode>& nodes = subtreeNodes[i];
+		const uint32_t offset = static_cast<uint32_t>(buildNodes.size()) - 1;
+		for (size_t n = 0; n < nodes.size(); n++)
+		{
+			BuildNode node = nodes[n];
+			if (node.count == 0)
+			{
+				node.left += offset;
+				node.right += offset;
+			}
+
+			if (n == 0)
+			{
+				buildNodes[subtrees[i].node] = node;
+			}
+			else
+			{
+				buildNodes.push_back(node);
+			}
+		}
+	}
+
+	builder.GetPrimitives(mPrimitives.data());
+	Collapse(buildNodes);
+}
+
+// Turns the binary tree into a 4-wide one. Each node takes its binary node's two children, then
+// opens the largest of its children that aren't leaves until it has four.
+void Bvh::Collapse(const std::vector<BuildNode>& buildNodes)
+{
+	struct Pending
+	{
+		uint32_t buildIndex;
+		uint32_t node;
+	};
+
+	mNodes.reserve(buildNodes.size() / 2 + 1);
+	mNodes.resize(1);
+	std::vector<Pending> stack;
+	const Pending root = { 0, 0 };
+	stack.push_back(root);
+
+	while (!stack.empty())
+	{
+		const Pending pending = stack.back();
+		stack.pop_back();
+
+		// A lone leaf at the root becomes the node's only child
+		uint32_t children[4];
+		uint32_t childCount = 0;
+		const BuildNode& buildNode = buildNodes[pending.buildIndex];
+		if (buildNode.count > 0)
+		{
+			children[childCount++] = pending.buildIndex;
+		}
+		else
+		{
+			children[childCount++] = buildNode.left;
+			children[childCount++] = buildNode.right;
+		}
+
+		while (childCount < 4)
+		{
+			int largest = -1;
+			float largestArea = -1.0f;
+			for (uint32_t c = 0; c < childCount; c++)
+			{
+				const BuildNode& child = buildNodes[children[c]];
+				const float area = child.bounds.GetSurfaceArea();
+				if (child.count == 0 && area > largestArea)
+				{
+					largest = static_cast<int>(c);
+					largestArea = area;
+				}
+			}
+			if (largest < 0)
+			{
+				break;
+			}
+
+			const BuildNode& opened = buildNodes[children[largest]];
+			children[largest] = opened.left;
+			children[childCount++] = opened.right;
+		}
+
+		for (uint32_t slot = 0; slot < 4; slot++)
+		{
+			uint32_t child = EmptyChild;
+			uint32_t count = 0;
+			BvhBounds bounds = BvhBounds::Empty();
+			if (slot < childCount)
+			{
+				const BuildNode& childNode = buildNodes[children[slot]];
+				bounds = childNode.bounds;
+				if (childNode.count > 0)
+				{
+					child = childNode.first;
+					count = childNode.count;
+				}
+				else
+				{
+					child = static_cast<uint32_t>(mNodes.size());
+					mNodes.resize(mNodes.size() + 1);
+					const Pending next = { children[slot], child };
+					stack.push_back(next);
+				}
+			}
+
+			Node& node = mNodes[pending.node];
+			node.child[slot] = child;
+			node.count[slot] = count;
+			for (unsigned int axis = 0; axis < 3; axis++)
+			{
+				node.bounds[axis * 2][slot] = bounds.min[axis];
+				node.bounds[axis * 2 + 1][slot] = bounds.max[axis];
+			}
+		}
+	}
+}
+
+// Updates the tree for primitives that have moved. There must be as many as it was built with.
+void Bvh::Refit(const BvhBounds* bounds)
+{
+	// Children come after their parents, so going backwards updates them first
+	auto getNodeBounds = [this](const Node& node)
+	{
+		BvhBounds result = BvhBounds::Empty();
+		for (uint32_t slot = 0; slot < 4; slot++)
+		{
+			for (unsigned int axis = 0; axis < 3; axis++)
+			{
+				result.min[axis] = (std::min)(result.min[axis], node.bounds[axis * 2][slot]);
+				result.max[axis] = (std::max)(result.max[axis], node.bounds[axis * 2 + 1][slot]);
+			}
+		}
+		return result;
+	};
+
+	for (size_t n = mNodes.size(); n-- > 0;)
+	{
+		Node& node = mNodes[n];
+		for (uint32_t slot = 0; slot < 4; slot++)
+		{
+			if (node.child[slot] == EmptyChild)
+			{
+				continue;
+			}
+
+			BvhBounds childBounds = BvhBounds::Empty();
+			if (node.count[slot] > 0)
+			{
+				for (uint32_t i = node.child[slot]; i < node.child[slot] + node.count[slot]; i++)
+				{
+					childBounds.Grow(bounds[mPrimitives[i]]);
+				}
+			}
+			else
+			{
+				childBounds = getNodeBounds(mNodes[node.child[slot]]);
+			}
+
+			for (unsigned int axis = 0; axis < 3; axis++)
+			{
+				node.bounds[axis * 2][slot] = childBounds.min[axis];
+				node.bounds[axis * 2 + 1][slot] = childBounds.max[axis];
+			}
+		}
+	}
+
+	mBounds = mNodes.empty() ? BvhBounds::Empty() : getNodeBounds(mNodes[0]);
+}
+
+Bvh::Stats Bvh::GetStats() const
+{
+	Stats stats = {};
+	stats.nodeCount = static_cast<uint32_t>(mNodes.size());
+	if (mNodes.empty())
+	{
+		return stats;
+	}
+
+	// Each node's cost is weighted by the chance a ray through the root passes through it
+	const float rootArea = mBounds.GetSurfaceArea();
+	std::vector<uint32_t> depths(mNodes.size(), 1);
+	stats.sahCost = TraversalCost;
+	for (size_t n = 0; n < mNodes.size(); n++)
+	{
+		const Node& node = mNodes[n];
+		stats.depth = (std::max)(stats.depth, depths[n]);
+		for (uint32_t slot = 0; slot < 4; slot++)
+		{
+			if (node.child[slot] == EmptyChild)
+			{
+				continue;
+			}
+
+			BvhBounds bounds;
+			for (unsigned int axis = 0; axis < 3; axis++)
+			{
+				bounds.min[axis] = node.bounds[axis * 2][slot];
+				bounds.max[axis] = node.bounds[axis * 2 + 1][slot];
+			}
+			const float probability = rootArea > 0.0f ? bounds.GetSurfaceArea() / rootArea : 1.0f;
+
+			if (node.count[slot] > 0)
+			{
+				stats.leafCount++;
+				stats.sahCost += probability * node.count[slot];
+			}
+			else
+			{
+				depths[node.child[slot]] = depths[n] + 1;
+				stats.sahCost += probability * TraversalCost;
+			}
+		}
+	}
+	return stats;
+}
+
+// Tests leaves in order along the ray, calling test(first, count, maxDistance) for each one
+// the ray reaches before maxDistance. The test checks the primitives at GetPrimitive(first) to
+// GetPrimitive(first + count - 1) and lowers maxDistance to the nearest hit, returning true if
+// there was one. For any-hit traversal, the first hit ends the search.
+template<bool AnyHit, typename LeafTest>
+bool Bvh::Traverse(const BvhRay& ray, float& maxDistance, LeafTest& test) const
+{
+	if (mNodes.empty())
+	{
+		return false;
+	}
+
+	// Each axis's near plane is the min if the ray heads towards +ve, otherwise the max
+	float inverseDirection[3];
+	unsigned int nearRow[3];
+	for (unsigned int axis = 0; axis < 3; axis++)
+	{
+		const float direction = ray.direction[axis];
+		inverseDirection[axis] = 1.0f / (std::fabs(direction) < MinDirection ? (direction < 0.0f ? -MinDirection : MinDirection) : direction);
+		nearRow[axis] = axis * 2 + (inverseDirection[axis] < 0.0f ? 1 : 0);
+	}
+
+#if BVH_SIMD
+	const __m128 originX = _mm_set1_ps(ray.origin[0]);
+	const __m128 originY = _mm_set1_ps(ray.origin[1]);
+	const __m128 originZ = _mm_set1_ps(ray.origin[2]);
+	const __m128 inverseX = _mm_set1_ps(inverseDirection[0]);
+	const __m128 inverseY = _mm_set1_ps(inverseDirection[1]);
+	const __m128 inverseZ = _mm_set1_ps(inverseDirection[2]);
+#endif
+
+	struct StackEntry
+	{
+		uint32_t child;
+		uint32_t count;
+		float distance;
+	};
+	StackEntry stack[TraversalStackSize];
+	uint32_t stackSize = 0;
+	const StackEntry root = { 0, 0, 0.0f };
+	stack[stackSize++] = root;
+
+	bool hit = false;
+	while (stackSize > 0)
+	{
+		const StackEntry entry = stack[--stackSize];
+		if (entry.distance > maxDistance)
+		{
+			continue;
+		}
+
+		if (entry.count > 0)
+		{
+			if (test(entry.child, entry.count, maxDistance))
+			{
+				hit = true;
+				if (AnyHit)
+				{
+					return true;
+				}
+			}
+			continue;
+		}
+
+		// Slab test against all four children at once
+		const Node& node = mNodes[entry.child];
+		float distances[4];
+		unsigned int hitMask = 0;
+#if BVH_SIMD
+		const __m128 nearX = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node.bounds[nearRow[0]]), originX), inverseX);
+		const __m128 nearY = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node.bounds[nearRow[1]]), originY), inverseY);
+		const __m128 nearZ = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node.bounds[nearRow[2]]), originZ), inverseZ);
+		const __m128 farX = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node.bounds[nearRow[0] ^ 1]), originX), inverseX);
+		const __m128 farY = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node.bounds[nearRow[1] ^ 1]), originY), inverseY);
+		const __m128 farZ = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node.bounds[nearRow[2] ^ 1]), originZ), inverseZ);
+		const __m128 nearest = _mm_max_ps(_mm_max_ps(nearX, nearY), _mm_max_ps(nearZ, _mm_setzero_ps()));
+		const __m128 furthest = _mm_min_ps(_mm_min_ps(farX, farY), _mm_min_ps(farZ, _mm_set1_ps(maxDistance)));
+		hitMask = static_cast<unsigned int>(_mm_movemask_ps(_mm_cmple_ps(nearest, furthest)));
+		_mm_storeu_ps(distances, nearest);
+#else
+		for (unsigned int slot = 0; slot < 4; slot++)
+		{
+			float nearest = 0.0f;
+			float furthest = maxDistance;
+			for (unsigned int axis = 0; axis < 3; axis++)
+			{
+				nearest = (std::max)(nearest, (node.bounds[nearRow[axis]][slot] - ray.origin[axis]) * inverseDirection[axis]);
+				furthest = (std::min)(furthest, (node.bounds[nearRow[axis] ^ 1][slot] - ray.origin[axis]) * inverseDirection[axis]);
+			}
+			distances[slot] = nearest;
+			hitMask |= nearest <= furthest ? 1u << slot : 0u;
+		}
+#endif
+
+		// Push the furthest first, so the nearest is visited next
+		unsigned int order[4];
+		unsigned int hitCount = 0;
+		for (unsigned int slot = 0; slot < 4; slot++)
+		{
+			if ((hitMask & (1u << slot)) == 0)
+			{
+				continue;
+			}
+
+			unsigned int position = hitCount++;
+			while (position > 0 && distances[order[position - 1]] < distances[slot])
+			{
+				order[position] = order[position - 1];
+				position--;
+			}
+			order[position] = slot;
+		}
+
+		for (unsigned int i = 0; i < hitCount; i++)
+		{
+			const unsigned int slot = order[i];
+			const StackEntry child = { node.child[slot], node.count[slot], distances[slot] };
+			stack[stackSize++] = child;
+		}
+	}
+	return hit;
+}
+
+// Positions are 3 floats per vertex and indices 3 per triangle
+void TriangleBvh::Build(const float* positions, const uint32_t* indices, uint32_t triangleCount, JobSystem* jobSystem)
+{
+	std::vector<BvhBounds> bounds(triangleCount);
+	for (uint32_t t = 0; t < triangleCount; t++)
+	{
+		bounds[t] = BvhBounds::Empty();
+		for (unsigned int corner = 0; corner < 3; corner++)
+		{
+			bounds[t].Grow(&positions[indices[t * 3 + corner] * 3]);
+		}
+	}
+
+	mBvh.Build(bounds.data(), triangleCount, jobSystem);
+
+	// Stored in leaf order, so each leaf's triangles are together
+	mTriangles.resize(triangleCount);
+	for (uint32_t i = 0; i < triangleCount; i++)
+	{
+		const uint32_t* triangle = &indices[mBvh.GetPrimitive(i) * 3];
+		const float* corner0 = &positions[triangle[0] * 3];
+		const float* corner1 = &positions[triangle[1] * 3];
+		const float* corner2 = &positions[triangle[2] * 3];
+		for (unsigned int axis = 0; axis < 3; axis++)
+		{
+			mTriangles[i].corner[axis] = corner0[axis];
+			mTriangles[i].edge1[axis] = corner1[axis] - corner0[axis];
+			mTriangles[i].edge2[axis] = corner2[axis] - corner0[axis];
+		}
+	}
+}
+
+namespace
+{
+	// Moller-Trumbore, from either side
+	template<typename Triangle>
+	bool IntersectTriangle(const BvhRay& ray, const Triangle& triangle, float maxDistance, float& distance, float& u, float& v)
+	{
+		float p[3];
+		for (unsigned int axis = 0; axis < 3; axis++)
+		{
+			p[axis] = Cross(ray.direction, triangle.edge2, axis);
+		}
+
+		const float determinant = Dot(triangle.edge1, p);
+		if (determinant == 0.0f)
+		{
+			return false;
+		}
+		const float inverseDeterminant = 1.0f / determinant;
+
+		float s[3];
+		for (unsigned int axis = 0; axis < 3; axis++)
+		{
+			s[axis] = ray.origin[axis] - triangle.corner[axis];
+		}
+		u = Dot(s, p) * inverseDeterminant;
+		if (u < 0.0f || u > 1.0f)
+		{
+			return false;
+		}
+
+		float q[3];
+		for (unsigned int axis = 0; axis < 3; axis++)
+		{
+			q[axis] = Cross(s, triangle.edge1, axis);
+		}
+		v = Dot(ray.direction, q) * inverseDeterminant;
+		if (v < 0.0f || u + v > 1.0f)
+		{
+			return false;
+		}
+
+		distance = Dot(triangle.edge2, q) * inverseDeterminant;
+		return distance >= 0.0f && distance < maxDistance;
+	}
+}
+
+// The nearest hit within the ray's max distance. Triangles are hit from either side.
+bool TriangleBvh::Intersect(const BvhRay& ray, BvhHit& hit) const
+{
+	auto test = [this, &ray, &hit](uint32_t first, uint32_t count, float& maxDistance)
+	{
+		bool found = false;
+		for (uint32_t i = first; i < first + count; i++)
+		{
+			float distance;
+			float u;
+			float v;
+			if (IntersectTriangle(ray, mTriangles[i], maxDistance, distance, u, v))
+			{
+				maxDistance = distance;
+				hit.triangle = mBvh.GetPrimitive(i);
+				hit.barycentrics[0] = u;
+				hit.barycentrics[1] = v;
+				found = true;
+			}
+		}
+		return found;
+	};
+
+	float maxDistance = ray.maxDistance;
+	if (!mBvh.Traverse<false>(ray, maxDistance, test))
+	{
+		return false;
+	}
+	hit.distance = maxDistance;
+	hit.instance = 0;
+	return true;
+}
+
+// Whether anything is hit within the ray's max distance, stopping at the first hit found
+bool TriangleBvh::Occluded(const BvhRay& ray) const
+{
+	auto test = [this, &ray](uint32_t first, uint32_t count, float& maxDistance)
+	{
+		for (uint32_t i = first; i < first + count; i++)
+		{
+			float distance;
+			float u;
+			float v;
+			if (IntersectTriangle(ray, mTriangles[i], maxDistance, distance, u, v))
+			{
+				return true;
+			}
+		}
+		return false;
+	};
+
+	float maxDistance = ray.maxDistance;
+	return mBvh.Traverse<true>(ray, maxDistance, test);
+}
+
+SceneBvh::SceneBvh()
+{
+}
+
+// World transforms are 4x4 row-major matrices for row vectors (as DirectXMath uses), and must be
+// invertible. Meshes must outlive the scene. Instances are numbered in the order they're added.
+uint32_t SceneBvh::AddInstance(const TriangleBvh* mesh, const float world[16])
+{
+	return AddInstance(mesh, mesh->GetBounds(), world);
+}
+
+uint32_t SceneBvh::AddBoxInstance(const BvhBounds& localBounds, const float world[16])
+{
+	return AddInstance(nullptr, localBounds, world);
+}
+
+uint32_t SceneBvh::AddInstance(const TriangleBvh* mesh, const BvhBounds& localBounds, const float world[16])
+{
+	Instance instance;
+	instance.mesh = mesh;
+	instance.localBounds = localBounds;
+	mInstances.push_back(instance);
+	mWorldBounds.push_back(BvhBounds::Empty());
+	UpdateInstance(mInstances.back(), mWorldBounds.back(), world);
+	return static_cast<uint32_t>(mInstances.size() - 1);
+}
+
+void SceneBvh::SetTransform(uint32_t instance, const float world[16])
+{
+	UpdateInstance(mInstances[instance], mWorldBounds[instance], world);
+}
+
+void SceneBvh::Clear()
+{
+	mInstances.clear();
+	mWorldBounds.clear();
+	mBvh.Build(nullptr, 0);
+}
+
+// Build after adding instances. After moving them, either build again or refit.
+void SceneBvh::Build(JobSystem* jobSystem)
+{
+	mBvh.Build(mWorldBounds.data(), static_cast<uint32_t>(mWorldBounds.size()), jobSystem);
+}
+
+void SceneBvh::Refit()
+{
+	mBvh.Refit(mWorldBounds.data());
+}
+
+void SceneBvh::UpdateInstance(Instance& instance, BvhBounds& worldBounds, const float world[16])
+{
+	// The top three columns of each row
+	for (unsigned int row = 0; row < 4; row++)
+	{
+		for (unsigned int column = 0; column < 3; column++)
+		{
+			instance.toWorld[row * 3 + column] = world[row * 4 + column];
+		}
+	}
+
+	// Invert the 3x3 part with its cofactors, then take the translation back through it
+	const float* m = instance.toWorld;
+	float* inverse = instance.toLocal;
+	inverse[0] = m[4] * m[8] - m[5] * m[7];
+	inverse[1] = m[2] * m[7] - m[1] * m[8];
+	inverse[2] = m[1] * m[5] - m[2] * m[4];
+	inverse[3] = m[5] * m[6] - m[3] * m[8];
+	inverse[4] = m[0] * m[8] - m[2] * m[6];
+	inverse[5] = m[2] * m[3] - m[0] * m[5];
+	inverse[6] = m[3] * m[7] - m[4] * m[6];
+	inverse[7] = m[1] * m[6] - m[0] * m[7];
+	inverse[8] = m[0] * m[4] - m[1] * m[3];
+	const float inverseDeterminant = 1.0f / (m[0] * inverse[0] + m[1] * inverse[3] + m[2] * inverse[6]);
+	for (unsigned int i = 0; i < 9; i++)
+	{
+		inverse[i] *= inverseDeterminant;
+	}
+	for (unsigned int column = 0; column < 3; column++)
+	{
+		inverse[9 + column] = -(m[9] * inverse[column] + m[10] * inverse[3 + column] + m[11] * inverse[6 + column]);
+	}
+
+	// Each world axis's extent is the sum of each local axis's contribution to it
+	for (unsigned int column = 0; column < 3; column++)
+	{
+		worldBounds.min[column] = m[9 + column];
+		worldBounds.max[column] = m[9 + column];
+		for (unsigned int row = 0; row < 3; row++)
+		{
+			const float a = m[row * 3 + column] * instance.localBounds.min[row];
+			const float b = m[row * 3 + column] * instance.localBounds.max[row];
+			worldBounds.min[column] += (std::min)(a, b);
+			worldBounds.max[column] += (std::max)(a, b);
+		}
+	}
+}
+
+// Tests the instances in a leaf, returning true if any were hit nearer than maxDistance
+template<bool AnyHit>
+bool SceneBvh::IntersectInstances(const BvhRay& ray, uint32_t first, uint32_t count, float& maxDistance, BvhHit* hit) const
+{
+	bool found = false;
+	for (uint32_t i = first; i < first + count; i++)
+	{
+		const uint32_t index = mBvh.GetPrimitive(i);
+		const Instance& instance = mInstances[index];
+
+		// Distances along the ray are the same in local space, as the direction is transformed too
+		BvhRay localRay;
+		TransformPoint(instance.toLocal, ray.origin, localRay.origin);
+		TransformDirection(instance.toLocal, ray.direction, localRay.direction);
+		localRay.maxDistance = maxDistance;
+
+		if (instance.mesh != nullptr)
+		{
+			if (AnyHit)
+			{
+				if (instance.mesh->Occluded(localRay))
+				{
+					return true;
+				}
+				continue;
+			}
+
+			BvhHit meshHit;
+			if (instance.mesh->Intersect(localRay, meshHit))
+			{
+				maxDistance = meshHit.distance;
+				*hit = meshHit;
+				hit->instance = index;
+				found = true;
+			}
+		}
+		else
+		{
+			float distance;
+			if (IntersectBox(localRay, instance.localBounds, maxDistance, distance) && distance < maxDistance)
+			{
+				if (AnyHit)
+				{
+					return true;
+				}
+
+				maxDistance = distance;
+				hit->distance = distance;
+				hit->instance = index;
+				hit->triangle = BvhHit::NoTriangle;
+				hit->barycentrics[0] = 0.0f;
+				hit->barycentrics[1] = 0.0f;
+				found = true;
+			}
+		}
+	}
+	return found;
+}
+
+// The nearest hit within the ray's max distance
+bool SceneBvh::Intersect(const BvhRay& ray, BvhHit& hit) const
+{
+	auto test = [this, &ray, &hit](uint32_t first, uint32_t count, float& maxDistance)
+	{
+		return IntersectInstances<false>(ray, first, count, maxDistance, &hit);
+	};
+
+	float maxDistance = ray.maxDistance;
+	return mBvh.Traverse<false>(ray, maxDistance, test);
+}
+
+// Whether anything is hit within the ray's max distance, stopping at the first hit found
+bool SceneBvh::Occluded(const BvhRay& ray) const
+{
+	auto test = [this, &ray](uint32_t first, uint32_t count, float& maxDistance)
+	{
+		return IntersectInstances<true>(ray, first, count, maxDistance, nullptr);
+	};
+
+	float maxDistance = ray.maxDistance;
+	return mBvh.Traverse<true>(ray, maxDistance, test);
+}
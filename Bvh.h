@@ -0,0 +1,214 @@
+// Bounding volume hierarchies for raycasts
+// Bvh is a 4-wide tree over any set of primitives' bounds. It's built as a binary tree with the
+// binned surface area heuristic: each node's primitives are sorted into bins by their centres
+// along each axis, and the split between bins with the lowest expected cost of tracing a ray
+// through the two halves is used. The binary tree is then collapsed so each node holds up to
+// four children, whose bounds are tested against a ray together with SSE where it's available.
+//
+// Building is spread over the job system: the top of the tree is split on the calling thread,
+// binning the largest nodes in parallel, until there are enough subtrees to go round, then the
+// subtrees are built at once. Refitting recomputes the bounds for moved primitives while keeping
+// the tree's shape, which is much cheaper than a rebuild but slows raycasts as things move further.
+//
+// TriangleBvh is a tree over a mesh's triangles. SceneBvh is a tree over instances, each either a
+// TriangleBvh with a world transform or just a box, for picking and gameplay raycasts.
+//
+// Rays are a start point and a direction, which needn't be normalised, with hits reported as the
+// distance along it in multiples of the direction.
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#if !defined(BVH_SIMD) && (defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__))
+#define BVH_SIMD 1
+#endif
+
+class JobSystem;
+
+struct BvhBounds
+{
+	float min[3];
+	float max[3];
+
+	// Contains nothing, so growing it to fit anything gives that thing's bounds
+	static BvhBounds Empty();
+
+	void Grow(const float point[3]);
+	void Grow(const BvhBounds& other);
+	float GetSurfaceArea() const;
+};
+
+struct BvhRay
+{
+	float origin[3];
+	float direction[3];
+	float maxDistance;		// Hits beyond this are ignored
+};
+
+struct BvhHit
+{
+	static const uint32_t NoTriangle = 0xFFFFFFFF;
+
+	float distance;
+	uint32_t instance;		// For SceneBvh hits
+	uint32_t triangle;		// NoTriangle for instances that are boxes
+	float barycentrics[2];	// Weights of the triangle's second and third corners
+};
+
+class Bvh
+{
+public:
+	static const uint32_t MaxLeafSize = 4;
+	static const uint32_t BinCount = 16;
+
+	struct Stats
+	{
+		uint32_t nodeCount;
+		uint32_t leafCount;
+		uint32_t depth;
+		float sahCost;			// Expected cost of a ray through the tree, relative to testing one primitive
+	};
+
+	Bvh();
+
+	// Prohibit copying
+	Bvh(const Bvh& rhs) = delete;
+	Bvh& operator=(const Bvh& rhs) = delete;
+
+	// Builds the tree over the primitives' bounds. The job system's workers help with large trees.
+	void Build(const BvhBounds* bounds, uint32_t count, JobSystem* jobSystem = nullptr);
+
+	// Updates the tree for primitives that have moved. There must be as many as it was built with.
+	void Refit(const BvhBounds* bounds);
+
+	// Getters
+	bool IsEmpty() const { return mNodes.empty(); }
+	uint32_t GetPrimitiveCount() const { return static_cast<uint32_t>(mPrimitives.size()); }
+	uint32_t GetPrimitive(uint32_t leafIndex) const { return mPrimitives[leafIndex]; }
+	const BvhBounds& GetBounds() const { return mBounds; }
+	Stats GetStats() const;
+
+private:
+	friend class TriangleBvh;
+	friend class SceneBvh;
+
+	struct BuildNode;
+	struct BuildRange;
+	class Builder;
+
+	// Children's bounds are kept by axis, min then max, four at a time so they load straight into
+	// SSE registers. Children are other nodes, leaves, or empty, whose bounds are inside out so
+	// rays never hit them.
+	struct Node
+	{
+		float bounds[6][4];		// minX, maxX, minY, maxY, minZ, maxZ
+		uint32_t child[4];		// Node index, or first primitive of a leaf
+		uint32_t count[4];		// Primitives in a leaf, 0 for nodes and empty children
+	};
+
+	static const uint32_t EmptyChild = 0xFFFFFFFF;
+
+	void Collapse(const std::vector<BuildNode>& buildNodes);
+
+	// Tests leaves in order along the ray, calling test(first, count, maxDistance) for each one
+	// the ray reaches before maxDistance. The test checks the primitives at GetPrimitive(first) to
+	// GetPrimitive(first + count - 1) and lowers maxDistance to the nearest hit, returning true if
+	// there was one. For any-hit traversal, the first hit ends the search.
+	template<bool AnyHit, typename LeafTest>
+	bool Traverse(const BvhRay& ray, float& maxDistance, LeafTest& test) const;
+
+	std::vector<Node> mNodes;				// Parents before their children
+	std::vector<uint32_t> mPrimitives;		// Primitive indices in leaf order
+	BvhBounds mBounds;
+};
+
+class TriangleBvh
+{
+public:
+	TriangleBvh() {}
+
+	// Prohibit copying
+	TriangleBvh(const TriangleBvh& rhs) = delete;
+	TriangleBvh& operator=(const TriangleBvh& rhs) = delete;
+
+	// Positions are 3 floats per vertex and indices 3 per triangle
+	void Build(const float* positions, const uint32_t* indices, uint32_t triangleCount, JobSystem* jobSystem = nullptr);
+
+	// The nearest hit within the ray's max distance. Triangles are hit from either side.
+	bool Intersect(const BvhRay& ray, BvhHit& hit) const;
+
+	// Whether anything is hit within the ray's max distance, stopping at the first hit found
+	bool Occluded(const BvhRay& ray) const;
+
+	// Getters
+	const BvhBounds& GetBounds() const { return mBvh.GetBounds(); }
+	const Bvh& GetBvh() const { return mBvh; }
+
+private:
+	// Each triangle as its first corner and the edges from it to the other two, in leaf order
+	struct Triangle
+	{
+		float corner[3];
+		float edge1[3];
+		float edge2[3];
+	};
+
+	Bvh mBvh;
+	std::vector<Triangle> mTriangles;
+};
+
+class SceneBvh
+{
+public:
+	SceneBvh();
+
+	// Prohibit copying
+	SceneBvh(const SceneBvh& rhs) = delete;
+	SceneBvh& operator=(const SceneBvh& rhs) = delete;
+
+	// World transforms are 4x4 row-major matrices for row vectors (as DirectXMath uses), and must be
+	// invertible. Meshes must outlive the scene. Instances are numbered in the order they're added.
+	uint32_t AddInstance(const TriangleBvh* mesh, const float world[16]);
+	uint32_t AddBoxInstance(const BvhBounds& localBounds, const float world[16]);
+	void SetTransform(uint32_t instance, const float world[16]);
+	void Clear();
+
+	// Build after adding instances. After moving them, either build again or refit.
+	void Build(JobSystem* jobSystem = nullptr);
+	void Refit();
+
+	// The nearest hit within the ray's max distance
+	bool Intersect(const BvhRay& ray, BvhHit& hit) const;
+
+	// Whether anything is hit within the ray's max distance, stopping at the first hit found
+	bool Occluded(const BvhRay& ray) const;
+
+	// Getters
+	uint32_t GetInstanceCount() const { return static_cast<uint32_t>(mInstances.size()); }
+	const BvhBounds& GetWorldBounds(uint32_t instance) const { return mWorldBounds[instance]; }
+	const BvhBounds* GetWorldBounds() const { return mWorldBounds.data(); }		// Every instance's, in order
+	const Bvh& GetBvh() const { return mBvh; }
+
+private:
+	// Transforms are the top three columns of the matrix, so a point is [x y z 1] times them
+	struct Instance
+	{
+		const TriangleBvh* mesh;	// Null for boxes
+		BvhBounds localBounds;
+		float toWorld[12];
+		float toLocal[12];
+	};
+
+	uint32_t AddInstance(const TriangleBvh* mesh, const BvhBounds& localBounds, const float world[16]);
+	void UpdateInstance(Instance& instance, BvhBounds& worldBounds, const float world[16]);
+
+	// Tests the instances in a leaf, returning true if any were hit nearer than maxDistance
+	template<bool AnyHit>
+	bool IntersectInstances(const BvhRay& ray, uint32_t first, uint32_t count, float& maxDistance, BvhHit* hit) const;
+
+	std::vector<Instance> mInstances;
+	std::vector<BvhBounds> mWorldBounds;
+	Bvh mBvh;
+};
@@ -0,0 +1,89 @@
+// Clocks
+// Code that needs the time takes an IClock so it can be driven by a simulated clock instead
+// of the system one. Times are integer nanoseconds, which don't lose precision as they grow.
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+class IClock
+{
+public:
+	virtual ~IClock() {}
+
+	// Monotonic time in nanoseconds, from an arbitrary starting point
+	virtual int64_t Now() const = 0;
+
+	// Blocks the calling thread until Now() reaches the given time
+	virtual void SleepUntil(int64_t time) = 0;
+
+	void Sleep(int64_t nanoseconds) { SleepUntil(Now() + nanoseconds); }
+};
+
+// Nanosecond conversions
+static const int64_t NanosecondsPerMillisecond = 1000000;
+static const int64_t NanosecondsPerSecond = 1000000000;
+
+inline double NanosecondsToSeconds(int64_t nanoseconds)
+{
+	return static_cast<double>(nanoseconds) / NanosecondsPerSecond;
+}
+
+inline double NanosecondsToMilliseconds(int64_t nanoseconds)
+{
+	return static_cast<double>(nanoseconds) / NanosecondsPerMillisecond;
+}
+
+inline int64_t SecondsToNanoseconds(double seconds)
+{
+	return static_cast<int64_t>(seconds * NanosecondsPerSecond);
+}
+
+// The system's steady clock
+class SystemClock : public IClock
+{
+public:
+	virtual int64_t Now() const override
+	{
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	// OS sleeps can overshoot by a scheduler tick, so the last stretch is spent yielding
+	virtual void SleepUntil(int64_t time) override
+	{
+		const int64_t spinTime = 2 * NanosecondsPerMillisecond;
+		const int64_t remaining = time - Now();
+		if (remaining > spinTime)
+		{
+			std::this_thread::sleep_for(std::chrono::nanoseconds(remaining - spinTime));
+		}
+
+		while (Now() < time)
+		{
+			std::this_thread::yield();
+		}
+	}
+};
+
+// A clock that only moves when told to. Sleeping advances it by the time slept.
+class ManualClock : public IClock
+{
+public:
+	explicit ManualClock(int64_t start = 0) : mNow(start) {}
+
+	virtual int64_t Now() const override { return mNow; }
+	virtual void SleepUntil(int64_t time) override { Advance(time - mNow); }
+
+	void Advance(int64_t nanoseconds)
+	{
+		if (nanoseconds > 0)
+		{
+			mNow += nanoseconds;
+		}
+	}
+
+private:
+	int64_t mNow;
+};
@@ -0,0 +1,85 @@
+#include "CommandListPacketSink.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+const UINT CommandListPacketSink::MaxPassViews;
+
+CommandListPacketSink::CommandListPacketSink(ID3D12GraphicsCommandList* commandList) :
+	mCommandList(commandList),
+	mPassRootParameter(0),
+	mPassConstantCount(0),
+	mPassViewCount(0)
+{
+}
+
+// The constants are copied, up to DrawPacketList::MaxRootConstants of them
+void CommandListPacketSink::SetPassConstants(UINT rootParameter, UINT count, const void* constants)
+{
+	assert(count <= DrawPacketList::MaxRootConstants);
+	mPassRootParameter = rootParameter;
+	mPassConstantCount = count;
+	memcpy(mPassConstants, constants, count * sizeof(uint32_t));
+}
+
+// Up to MaxPassViews root parameters, each set again if it's called for the same one
+void CommandListPacketSink::SetPassShaderResourceView(UINT rootParameter, D3D12_GPU_VIRTUAL_ADDRESS address)
+{
+	UINT view = 0;
+	while (view < mPassViewCount && mPassViewRootParameters[view] != rootParameter)
+	{
+		view++;
+	}
+
+	assert(view < MaxPassViews);
+	mPassViewRootParameters[view] = rootParameter;
+	mPassViews[view] = address;
+	mPassViewCount = (std::max)(mPassViewCount, view + 1);
+}
+
+DrawPacketVertexBuffer CommandListPacketSink::GetVertexBuffer(const D3D12_VERTEX_BUFFER_VIEW& view)
+{
+	DrawPacketVertexBuffer vertexBuffer;
+	vertexBuffer.gpuAddress = view.BufferLocation;
+	vertexBuffer.sizeInBytes = view.SizeInBytes;
+	vertexBuffer.strideInBytes = view.StrideInBytes;
+	return vertexBuffer;
+}
+
+void CommandListPacketSink::SetRootSignature(uint64_t rootSignature)
+{
+	mCommandList->SetGraphicsRootSignature(reinterpret_cast<ID3D12RootSignature*>(static_cast<uintptr_t>(rootSignature)));
+	if (mPassConstantCount > 0)
+	{
+		mCommandList->SetGraphicsRoot32BitConstants(mPassRootParameter, mPassConstantCount, mPassConstants, 0);
+	}
+	for (UINT view = 0; view < mPassViewCount; view++)
+	{
+		mCommandList->SetGraphicsRootShaderResourceView(mPassViewRootParameters[view], mPassViews[view]);
+	}
+}
+
+void CommandListPacketSink::SetPipelineState(uint64_t pipelineState)
+{
+	mCommandList->SetPipelineState(reinterpret_cast<ID3D12PipelineState*>(static_cast<uintptr_t>(pipelineState)));
+}
+
+void CommandListPacketSink::SetVertexBuffer(const DrawPacketVertexBuffer& vertexBuffer)
+{
+	D3D12_VERTEX_BUFFER_VIEW view;
+	view.BufferLocation = vertexBuffer.gpuAddress;
+	view.SizeInBytes = vertexBuffer.sizeInBytes;
+	view.StrideInBytes = vertexBuffer.strideInBytes;
+	mCommandList->IASetVertexBuffers(0, 1, &view);
+}
+
+void CommandListPacketSink::SetRootConstants(uint32_t rootParameter, uint32_t count, const uint32_t* constants)
+{
+	mCommandList->SetGraphicsRoot32BitConstants(rootParameter, count, constants, 0);
+}
+
+void CommandListPacketSink::Draw(uint32_t vertexCount, uint32_t instanceCount, uint32_t startVertex, uint32_t startInstance)
+{
+	mCommandList->DrawInstanced(vertexCount, instanceCount, startVertex, startInstance);
+}
@@ -0,0 +1,50 @@
+// Command list packet sink
+// Records replayed draw packets into a graphics command list, or a bundle. Packets hold the
+// root signature and pipeline state as their pointers, and vertex buffer views as they are.
+//
+// Root constants and views shared by every draw in a pass, like the camera's constants, are
+// set by the sink rather than stored in each packet, so packets don't change when they do.
+// They're set again each time the root signature is, as setting it loses the root arguments.
+
+#pragma once
+
+#include "DXSampleHelper.h"
+#include "DrawPacket.h"
+
+class CommandListPacketSink : public DrawPacketSink
+{
+public:
+	explicit CommandListPacketSink(ID3D12GraphicsCommandList* commandList);
+
+	// Prohibit copying
+	CommandListPacketSink(const CommandListPacketSink& rhs) = delete;
+	CommandListPacketSink& operator=(const CommandListPacketSink& rhs) = delete;
+
+	static const UINT MaxPassViews = 4;
+
+	// The constants are copied, up to DrawPacketList::MaxRootConstants of them
+	void SetPassConstants(UINT rootParameter, UINT count, const void* constants);
+
+	// Up to MaxPassViews root parameters, each set again if it's called for the same one
+	void SetPassShaderResourceView(UINT rootParameter, D3D12_GPU_VIRTUAL_ADDRESS address);
+
+	// Packet IDs for the objects
+	static uint64_t GetId(ID3D12RootSignature* rootSignature) { return reinterpret_cast<uintptr_t>(rootSignature); }
+	static uint64_t GetId(ID3D12PipelineState* pipelineState) { return reinterpret_cast<uintptr_t>(pipelineState); }
+	static DrawPacketVertexBuffer GetVertexBuffer(const D3D12_VERTEX_BUFFER_VIEW& view);
+
+	virtual void SetRootSignature(uint64_t rootSignature) override;
+	virtual void SetPipelineState(uint64_t pipelineState) override;
+	virtual void SetVertexBuffer(const DrawPacketVertexBuffer& vertexBuffer) override;
+	virtual void SetRootConstants(uint32_t rootParameter, uint32_t count, const uint32_t* constants) override;
+	virtual void Draw(uint32_t vertexCount, uint32_t instanceCount, uint32_t startVertex, uint32_t startInstance) override;
+
+private:
+	ID3D12GraphicsCommandList* mCommandList;
+	UINT mPassRootParameter;
+	UINT mPassConstantCount;
+	uint32_t mPassConstants[DrawPacketList::MaxRootConstants];
+	UINT mPassViewCount;
+	UINT mPassViewRootParameters[MaxPassViews];
+	D3D12_GPU_VIRTUAL_ADDRESS mPassViews[MaxPassViews];
+};
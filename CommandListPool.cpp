@@ -0,0 +1,92 @@
+#include "CommandListPool.h"
+
+#include <cstdio>
+
+const UINT CommandListPool::NumQueueTypes;
+
+namespace
+{
+	const char* const QueueTypeNames[] = { "Direct", "Compute", "Copy" };
+}
+
+CommandListPool::CommandListPool(ID3D12Device* device) :
+	mDevice(device)
+{
+}
+
+// Returns a pair whose list is open for recording. completedFenceValue is the queue's
+// fence's completed value.
+CommandListPool::CommandList CommandListPool::Acquire(D3D12_COMMAND_LIST_TYPE type, UINT64 completedFenceValue, ID3D12PipelineState* initialState)
+{
+	ID3D12Device* device = mDevice;
+	bool created = false;
+	CommandList commandList = mPools[GetQueueIndex(type)].Acquire(completedFenceValue, [device, type, initialState, &created]()
+	{
+		// New lists are created open
+		CommandList newList;
+		ThrowIfFailed(device->CreateCommandAllocator(type, IID_PPV_ARGS(&newList.allocator)));
+		ThrowIfFailed(device->CreateCommandList(0, type, newList.allocator.Get(), initialState, IID_PPV_ARGS(&newList.list)));
+		created = true;
+		return newList;
+	});
+
+	if (!created)
+	{
+		ThrowIfFailed(commandList.allocator->Reset());
+		ThrowIfFailed(commandList.list->Reset(commandList.allocator.Get(), initialState));
+	}
+	return commandList;
+}
+
+// Hands back a pair whose list has been submitted. fenceValue is the value the queue
+// signals after it.
+void CommandListPool::Release(D3D12_COMMAND_LIST_TYPE type, CommandList commandList, UINT64 fenceValue)
+{
+	mPools[GetQueueIndex(type)].Release(std::move(commandList), fenceValue);
+}
+
+FencedPool<CommandListPool::CommandList>::Stats CommandListPool::GetStats(D3D12_COMMAND_LIST_TYPE type) const
+{
+	return mPools[GetQueueIndex(type)].GetStats();
+}
+
+// One line per queue type that has been used, for the debug output
+void CommandListPool::FormatReport(char* buffer, size_t bufferSize) const
+{
+	if (bufferSize == 0)
+	{
+		return;
+	}
+	buffer[0] = '\0';
+
+	size_t length = 0;
+	for (UINT i = 0; i < NumQueueTypes && length < bufferSize; i++)
+	{
+		const FencedPool<CommandList>::Stats stats = mPools[i].GetStats();
+		if (stats.createdCount == 0)
+		{
+			continue;
+		}
+
+		const int written = snprintf(buffer + length, bufferSize - length, "%s command lists: %zu created, %zu most in use at once, %llu reused\n",
+			QueueTypeNames[i], stats.createdCount, stats.highWaterMark, static_cast<unsigned long long>(stats.reuseCount));
+		if (written < 0)
+		{
+			break;
+		}
+		length += static_cast<size_t>(written);
+	}
+}
+
+UINT CommandListPool::GetQueueIndex(D3D12_COMMAND_LIST_TYPE type)
+{
+	switch (type)
+	{
+	case D3D12_COMMAND_LIST_TYPE_COMPUTE:
+		return 1;
+	case D3D12_COMMAND_LIST_TYPE_COPY:
+		return 2;
+	default:
+		return 0;
+	}
+}
@@ -0,0 +1,49 @@
+// Command list pool
+// Hands out command allocator and command list pairs for each queue type. A pair handed back
+// after submission is only reused once the fence value signalled after that submission has
+// completed, as resetting an allocator the GPU is still reading from is invalid. The pool
+// grows when every pair is still in flight.
+//
+// Safe to use from any number of recording threads at once.
+
+#pragma once
+
+#include "DXSampleHelper.h"
+#include "FencedPool.h"
+
+class CommandListPool
+{
+public:
+	struct CommandList
+	{
+		ComPtr<ID3D12CommandAllocator> allocator;
+		ComPtr<ID3D12GraphicsCommandList> list;
+	};
+
+	explicit CommandListPool(ID3D12Device* device);
+
+	// Prohibit copying
+	CommandListPool(const CommandListPool& rhs) = delete;
+	CommandListPool& operator=(const CommandListPool& rhs) = delete;
+
+	// Returns a pair whose list is open for recording. completedFenceValue is the queue's
+	// fence's completed value.
+	CommandList Acquire(D3D12_COMMAND_LIST_TYPE type, UINT64 completedFenceValue, ID3D12PipelineState* initialState = nullptr);
+
+	// Hands back a pair whose list has been submitted. fenceValue is the value the queue
+	// signals after it.
+	void Release(D3D12_COMMAND_LIST_TYPE type, CommandList commandList, UINT64 fenceValue);
+
+	FencedPool<CommandList>::Stats GetStats(D3D12_COMMAND_LIST_TYPE type) const;
+
+	// One line per queue type that has been used, for the debug output
+	void FormatReport(char* buffer, size_t bufferSize) const;
+
+private:
+	static const UINT NumQueueTypes = 3;	// Direct, compute, copy
+
+	static UINT GetQueueIndex(D3D12_COMMAND_LIST_TYPE type);
+
+	ID3D12Device* mDevice;
+	FencedPool<CommandList> mPools[NumQueueTypes];
+};
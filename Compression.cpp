@@ -0,0 +1,264 @@
+#include "Compression.h"
+
+#include <cstring>
+#include <vector>
+
+namespace
+{
+	const size_t MinMatch = 4;
+	const size_t LastLiterals = 5;		// The last 5 bytes are always literals
+	const size_t MatchFindLimit = 12;	// No match may start within 12 bytes of the end
+	const size_t MaxOffset = 65535;
+	const unsigned int HashBits = 16;
+
+	inline uint32_t Read32(const uint8_t* p)
+	{
+		uint32_t value;
+		memcpy(&value, p, sizeof(value));
+		return value;
+	}
+
+	inline uint32_t HashSequence(uint32_t sequence)
+	{
+		return (sequence * 2654435761u) >> (32 - HashBits);
+	}
+
+	// Writes a length that didn't fit in the token's 4 bits as a run of 255s plus a remainder
+	inline bool WriteLength(size_t length, uint8_t*& op, const uint8_t* opEnd)
+	{
+		while (length >= 255)
+		{
+			if (op >= opEnd)
+			{
+				return false;
+			}
+			*op++ = 255;
+			length -= 255;
+		}
+
+		if (op >= opEnd)
+		{
+			return false;
+		}
+		*op++ = static_cast<uint8_t>(length);
+		return true;
+	}
+
+	// Reads an extended length, adding it to length
+	inline bool ReadLength(const uint8_t*& ip, const uint8_t* ipEnd, size_t& length)
+	{
+		uint8_t byte;
+		do
+		{
+			if (ip >= ipEnd)
+			{
+				return false;
+			}
+			byte = *ip++;
+			length += byte;
+		} while (byte == 255);
+
+		return true;
+	}
+
+	// Emits one sequence: a token, the literals, and (if matchLength is non-zero) the match
+	bool WriteSequence(const uint8_t* literals, size_t literalLength, size_t offset, size_t matchLength,
+		uint8_t*& op, const uint8_t* opEnd)
+	{
+		if (op >= opEnd)
+		{
+			return false;
+		}
+
+		uint8_t* token = op++;
+		*token = 0;
+
+		if (literalLength >= 15)
+		{
+			*token = 15 << 4;
+			if (!WriteLength(literalLength - 15, op, opEnd))
+			{
+				return false;
+			}
+		}
+		else
+		{
+			*token = static_cast<uint8_t>(literalLength << 4);
+		}
+
+		if (static_cast<size_t>(opEnd - op) < literalLength)
+		{
+			return false;
+		}
+		memcpy(op, literals, literalLength);
+		op += literalLength;
+
+		// The final sequence is literals only
+		if (matchLength == 0)
+		{
+			return true;
+		}
+
+		if (opEnd - op < 2)
+		{
+			return false;
+		}
+		*op++ = static_cast<uint8_t>(offset & 0xFF);
+		*op++ = static_cast<uint8_t>(offset >> 8);
+
+		const size_t extraMatch = matchLength - MinMatch;
+		if (extraMatch >= 15)
+		{
+			*token |= 15;
+			return WriteLength(extraMatch - 15, op, opEnd);
+		}
+
+		*token |= static_cast<uint8_t>(extraMatch);
+		return true;
+	}
+}
+
+// Compresses src into dst using a greedy single-probe hash search.
+// Returns the compressed size, or 0 if dst is too small.
+size_t CompressLZ(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstCapacity)
+{
+	// Nothing is a lone empty token. Handled here as src may be null, which memcpy can't take.
+	if (srcSize == 0)
+	{
+		if (dstCapacity == 0)
+		{
+			return 0;
+		}
+		dst[0] = 0;
+		return 1;
+	}
+
+	uint8_t* op = dst;
+	const uint8_t* opEnd = dst + dstCapacity;
+
+	size_t anchor = 0;
+
+	if (srcSize >= MatchFindLimit)
+	{
+		// Positions are stored plus one so that zero means empty
+		std::vector<uint32_t> table(static_cast<size_t>(1) << HashBits, 0);
+
+		const size_t matchLimit = srcSize - LastLiterals;
+		const size_t searchLimit = srcSize - MatchFindLimit;
+
+		size_t ip = 0;
+		while (ip <= searchLimit)
+		{
+			const uint32_t sequence = Read32(src + ip);
+			const uint32_t hash = HashSequence(sequence);
+			const size_t candidate = table[hash];
+			table[hash] = static_cast<uint32_t>(ip + 1);
+
+			if (candidate == 0 || ip - (candidate - 1) > MaxOffset || Read32(src + candidate - 1) != sequence)
+			{
+				ip++;
+				continue;
+			}
+
+			const size_t reference = candidate - 1;
+			size_t matchLength = MinMatch;
+			while (ip + matchLength < matchLimit && src[reference + matchLength] == src[ip + matchLength])
+			{
+				matchLength++;
+			}
+
+			if (!WriteSequence(src + anchor, ip - anchor, ip - reference, matchLength, op, opEnd))
+			{
+				return 0;
+			}
+
+			ip += matchLength;
+			anchor = ip;
+		}
+	}
+
+	if (!WriteSequence(src + anchor, srcSize - anchor, 0, 0, op, opEnd))
+	{
+		return 0;
+	}
+
+	return static_cast<size_t>(op - dst);
+}
+
+// Decompresses src into dst, which must be exactly the uncompressed size
+bool DecompressLZ(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstSize)
+{
+	// dst may be null when there's nothing to decompress, so don't go on to memcpy into it
+	if (dstSize == 0)
+	{
+		return srcSize == 0 || (srcSize == 1 && src[0] == 0);
+	}
+
+	const uint8_t* ip = src;
+	const uint8_t* ipEnd = src + srcSize;
+	uint8_t* op = dst;
+	uint8_t* opEnd = dst + dstSize;
+
+	while (ip < ipEnd)
+	{
+		const uint8_t token = *ip++;
+
+		// Literals
+		size_t literalLength = token >> 4;
+		if (literalLength == 15 && !ReadLength(ip, ipEnd, literalLength))
+		{
+			return false;
+		}
+
+		if (static_cast<size_t>(ipEnd - ip) < literalLength || static_cast<size_t>(opEnd - op) < literalLength)
+		{
+			return false;
+		}
+		memcpy(op, ip, literalLength);
+		ip += literalLength;
+		op += literalLength;
+
+		// The last sequence has no match
+		if (ip == ipEnd)
+		{
+			break;
+		}
+
+		// Match
+		if (ipEnd - ip < 2)
+		{
+			return false;
+		}
+		const size_t offset = ip[0] | (static_cast<size_t>(ip[1]) << 8);
+		ip += 2;
+
+		size_t matchLength = token & 15;
+		if (matchLength == 15 && !ReadLength(ip, ipEnd, matchLength))
+		{
+			return false;
+		}
+		matchLength += MinMatch;
+
+		if (offset == 0 || offset > static_cast<size_t>(op - dst) || static_cast<size_t>(opEnd - op) < matchLength)
+		{
+			return false;
+		}
+
+		const uint8_t* match = op - offset;
+		if (offset >= matchLength)
+		{
+			memcpy(op, match, matchLength);
+			op += matchLength;
+		}
+		else
+		{
+			// Overlapping match - repeats the last offset bytes, so must go byte by byte
+			for (size_t i = 0; i < matchLength; i++)
+			{
+				*op++ = *match++;
+			}
+		}
+	}
+
+	return op == opEnd;
+}
@@ -0,0 +1,21 @@
+// LZ4-style block compression
+// Produces the LZ4 block format (no frame header), so data can also be inspected with
+// standard LZ4 tools. Favours decompression speed over compression ratio.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Largest size compressing srcSize bytes can produce
+inline size_t CompressBound(size_t srcSize)
+{
+	return srcSize + srcSize / 255 + 16;
+}
+
+// Compresses src into dst. Returns the compressed size, or 0 if dst is too small.
+size_t CompressLZ(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstCapacity);
+
+// Decompresses src into dst, which must be exactly the uncompressed size.
+// Returns false if the data is corrupt or doesn't decompress to exactly dstSize bytes.
+bool DecompressLZ(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstSize);
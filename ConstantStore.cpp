@@ -0,0 +1,133 @@
+#include "ConstantStore.h"
+
+#include <cstring>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace
+{
+	// Index of the lowest set bit. Value must not be 0.
+	unsigned int LowestBit(uint64_t value)
+	{
+#if defined(_MSC_VER)
+		unsigned long index;
+		_BitScanForward64(&index, value);
+		return static_cast<unsigned int>(index);
+#else
+		return static_cast<unsigned int>(__builtin_ctzll(value));
+#endif
+	}
+}
+
+// Runs of dirty objects with up to maxMergeGap clean objects between them are copied as one range
+ConstantStore::ConstantStore(uint32_t objectSize, uint32_t maxMergeGap) :
+	mObjectSize(objectSize),
+	mMaxMergeGap(maxMergeGap),
+	mObjectCount(0),
+	mDirtyCount(0)
+{
+}
+
+// New objects are zeroed and dirty
+void ConstantStore::Resize(uint32_t objectCount)
+{
+	const uint32_t oldCount = mObjectCount;
+	mObjectCount = objectCount;
+	mData.resize(static_cast<size_t>(objectCount) * mObjectSize);
+	mDirtyBits.resize((objectCount + 63) / 64);
+
+	if (objectCount < oldCount)
+	{
+		// Recount, and clear the bits past the end so they aren't collected if the store grows again
+		if (objectCount % 64 != 0)
+		{
+			mDirtyBits.back() &= (1ull << (objectCount % 64)) - 1;
+		}
+		mDirtyCount = 0;
+		for (uint64_t bits : mDirtyBits)
+		{
+			for (; bits != 0; bits &= bits - 1)
+			{
+				mDirtyCount++;
+			}
+		}
+		return;
+	}
+
+	for (uint32_t i = oldCount; i < objectCount; i++)
+	{
+		mDirtyBits[i / 64] |= 1ull << (i % 64);
+	}
+	mDirtyCount += objectCount - oldCount;
+}
+
+// Copies objectSize bytes, marking the object dirty if they differ from its current constants
+void ConstantStore::Set(uint32_t index, const void* constants)
+{
+	uint8_t* object = &mData[static_cast<size_t>(index) * mObjectSize];
+	if (memcmp(object, constants, mObjectSize) == 0)
+	{
+		return;
+	}
+	memcpy(object, constants, mObjectSize);
+
+	uint64_t& word = mDirtyBits[index / 64];
+	const uint64_t bit = 1ull << (index % 64);
+	if ((word & bit) == 0)
+	{
+		word |= bit;
+		mDirtyCount++;
+	}
+}
+
+// Marks every object dirty, e.g. when the GPU copy has been recreated
+void ConstantStore::MarkAllDirty()
+{
+	for (uint64_t& word : mDirtyBits)
+	{
+		word = ~0ull;
+	}
+	if (mObjectCount % 64 != 0)
+	{
+		mDirtyBits.back() = (1ull << (mObjectCount % 64)) - 1;
+	}
+	mDirtyCount = mObjectCount;
+}
+
+// Replaces ranges with the dirty ones, coalesced, and clears the dirty bits. Returns the
+// number of bytes the ranges cover, including any clean objects merged into them.
+uint64_t ConstantStore::CollectDirtyRanges(std::vector<Range>& ranges)
+{
+	ranges.clear();
+	if (mDirtyCount == 0)
+	{
+		return 0;
+	}
+
+	uint64_t objectsCovered = 0;
+	for (size_t w = 0; w < mDirtyBits.size(); w++)
+	{
+		for (uint64_t bits = mDirtyBits[w]; bits != 0; bits &= bits - 1)
+		{
+			const uint32_t index = static_cast<uint32_t>(w * 64 + LowestBit(bits));
+			if (!ranges.empty() && index - (ranges.back().first + ranges.back().count) <= mMaxMergeGap)
+			{
+				const uint32_t newCount = index + 1 - ranges.back().first;
+				objectsCovered += newCount - ranges.back().count;
+				ranges.back().count = newCount;
+			}
+			else
+			{
+				const Range range = { index, 1 };
+				ranges.push_back(range);
+				objectsCovered++;
+			}
+		}
+		mDirtyBits[w] = 0;
+	}
+
+	mDirtyCount = 0;
+	return objectsCovered * mObjectSize;
+}
@@ -0,0 +1,60 @@
+// Constant store
+// CPU copies of per-object constants, all the same size, with a dirty bit per object. Setting an
+// object's constants marks it dirty only if they differ from what it already holds, so objects
+// that don't change cost nothing beyond the comparison, and nothing at all if they aren't set.
+//
+// Each frame the dirty objects are gathered into ranges to copy to the GPU. Runs of dirty objects
+// separated by only a few clean ones are merged, as copying a few unchanged objects is cheaper
+// than starting another copy. The bits are kept 64 to a word, so clean stretches are skipped
+// a word at a time.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class ConstantStore
+{
+public:
+	struct Range
+	{
+		uint32_t first;		// Objects, not bytes
+		uint32_t count;
+	};
+
+	// Runs of dirty objects with up to maxMergeGap clean objects between them are copied as one range
+	explicit ConstantStore(uint32_t objectSize, uint32_t maxMergeGap = 4);
+
+	// Prohibit copying
+	ConstantStore(const ConstantStore& rhs) = delete;
+	ConstantStore& operator=(const ConstantStore& rhs) = delete;
+
+	// New objects are zeroed and dirty
+	void Resize(uint32_t objectCount);
+
+	// Copies objectSize bytes, marking the object dirty if they differ from its current constants
+	void Set(uint32_t index, const void* constants);
+
+	// Marks every object dirty, e.g. when the GPU copy has been recreated
+	void MarkAllDirty();
+
+	// Replaces ranges with the dirty ones, coalesced, and clears the dirty bits. Returns the
+	// number of bytes the ranges cover, including any clean objects merged into them.
+	uint64_t CollectDirtyRanges(std::vector<Range>& ranges);
+
+	// Getters
+	uint32_t GetObjectSize() const { return mObjectSize; }
+	uint32_t GetObjectCount() const { return mObjectCount; }
+	uint32_t GetDirtyCount() const { return mDirtyCount; }
+	const void* GetObject(uint32_t index) const { return &mData[static_cast<size_t>(index) * mObjectSize]; }
+	const uint8_t* GetData() const { return mData.data(); }
+
+private:
+	uint32_t mObjectSize;
+	uint32_t mMaxMergeGap;
+	uint32_t mObjectCount;
+	uint32_t mDirtyCount;
+	std::vector<uint8_t> mData;
+	std::vector<uint64_t> mDirtyBits;
+};
@@ -3,24 +3,111 @@
 
 #include "DXSample.h"
 #include "Win32Application.h"
+#include "Profiler.h"
 
 using namespace Microsoft::WRL;
 
+namespace
+{
+	// Simulation steps per second, and the most that will be run to catch up in one frame
+	const int64_t SimulationRate = 60;
+	const unsigned int MaxSimulationStepsPerFrame = 4;
+
+	// How often the frame stats in the title bar are refreshed
+	const int64_t StatsTitleInterval = NanosecondsPerSecond / 2;
+
+	// Exit codes for benchmark runs
+	const int BenchmarkRegressedExitCode = 1;
+	const int BenchmarkFailedExitCode = 2;
+
+	bool ReadTextFile(const std::wstring& path, std::string& text)
+	{
+		FILE* file = nullptr;
+		if (_wfopen_s(&file, path.c_str(), L"rb") != 0 || file == nullptr)
+		{
+			return false;
+		}
+
+		char buffer[4096];
+		size_t bytesRead;
+		text.clear();
+		while ((bytesRead = fread(buffer, 1, sizeof(buffer), file)) > 0)
+		{
+			text.append(buffer, bytesRead);
+		}
+
+		const bool succeeded = ferror(file) == 0;
+		fclose(file);
+		return succeeded;
+	}
+}
+
 DXSample::DXSample(UINT width, UINT height, std::wstring name) :
 	mWidth(width),
 	mHeight(height),
 	mTitle(name),
-	mUseWarpDevice(false)
+	mUseWarpDevice(false),
+	mSimulation(NanosecondsPerSecond / SimulationRate, MaxSimulationStepsPerFrame),
+	mFramePacer(&mClock),
+	mBenchmark(nullptr),
+	mBenchmarkFrame(0),
+	mFrameNumber(0),
+	mLastStatsTitleTime(0),
+	mStartTime(mClock.Now()),
+	mFirstFrameRecorded(false),
+	mBenchmarkStartAllocations(),
+	mSteadyCheckStart(),
+	mSteadyAllocations(0),
+	mExitCode(0)
 {
 	WCHAR assetsPath[512];
 	GetAssetsPath(assetsPath, _countof(assetsPath));
 	mAssetsPath = assetsPath;
 
+	// Loose files are used for anything the archive doesn't contain (or if there is no archive).
+	// Mounting it sends loads through ReadDataFromFile to it too.
+	if (mAssetArchive.Open(mAssetsPath + L"assets.pak"))
+	{
+		MountAssetArchive(&mAssetArchive, mAssetsPath);
+	}
+
 	mAspectRatio = static_cast<float>(width) / static_cast<float>(height);
+
+	mJobSystem.reset(new JobSystem());
+	mFileIO.reset(new AsyncFileIO(mJobSystem.get()));
+	mFrameArenas.reset(new FrameArenas(mJobSystem->GetThreadCount()));
 }
 
 DXSample::~DXSample()
 {
+	// The file service delivers callbacks on the job system, so must go first
+	mFileIO.reset();
+	mJobSystem.reset();
+
+	MountAssetArchive(nullptr, std::wstring());
+}
+
+// Called at the start of each frame, before input is handled. Waits for the frame pacer,
+// then resets the frame arenas for the new frame.
+void DXSample::OnBeginFrame()
+{
+	PROFILE_ZONE("FrameWait");
+	mFramePacer.BeginFrame();
+
+	// Nothing from two frames ago is still in use
+	mFrameArenas->BeginFrame();
+}
+
+// Runs the fixed simulation steps owed for the elapsed time (in nanoseconds), then OnUpdate
+void DXSample::UpdateFrame(int64_t elapsed)
+{
+	const unsigned int steps = mSimulation.Advance(elapsed);
+	for (unsigned int i = 0; i < steps; i++)
+	{
+		OnFixedUpdate(mSimulation.GetStepSeconds());
+	}
+
+	OnUpdate(static_cast<float>(NanosecondsToSeconds(elapsed)));
 }
 
 // Helper function to get full path of assets
@@ -29,6 +116,31 @@ std::wstring DXSample::GetAssetFullPath(LPCWSTR assetName)
 	return mAssetsPath + assetName;
 }
 
+// Reads an asset from the mounted archive if it holds it, otherwise from the loose file.
+// The callback is run on the job system either way.
+void DXSample::ReadAssetAsync(LPCWSTR assetName, EIOPriority priority, AsyncFileIO::Callback callback)
+{
+	const ArchiveEntry* entry = mAssetArchive.Find(assetName);
+	if (entry == nullptr)
+	{
+		mFileIO->Read(GetAssetFullPath(assetName), 0, 0, priority, std::move(callback));
+		return;
+	}
+
+	// The archive is already mapped, so only decompression is left to do off this thread
+	const AssetArchive* archive = &mAssetArchive;
+	mJobSystem->Submit([archive, entry, callback]()
+	{
+		IOResult result = { AsyncFileIO::InvalidRequest, IOStatus_Completed };
+		if (!archive->Read(*entry, result.data))
+		{
+			result.status = IOStatus_Failed;
+			result.error = ERROR_INVALID_DATA;
+		}
+		callback(result);
+	});
+}
+
 // Helper function to find the first available hardware adapter that supports Direct3D 12.
 // If none are found then *ppAdapter is set to nullptr.
 _Use_decl_annotations_	// Makes sure the same annotation are used as in the header
@@ -93,17 +205,191 @@ void DXSample::GetHardwareAdapter(
 	*ppAdapter = adapter.Detach();
 }
 
-// Helper function for setting the window's title text
+// Helper function for setting the window's title text. Formatted into a fixed buffer, so it can
+// be called every frame without allocating.
 void DXSample::SetCustomWindowText(LPCWSTR text)
 {
-	std::wstring windowText = mTitle + L": " + text;
-	SetWindowText(Win32Application::GetHwnd(), windowText.c_str());
+	WCHAR windowText[256];
+	swprintf_s(windowText, L"%ls: %ls", mTitle.c_str(), text);
+	SetWindowText(Win32Application::GetHwnd(), windowText);
+}
+
+// Records this frame's times from the frame pacer, plus the GPU time if known (-1 if not),
+// and refreshes the title bar summary every so often. Ends the frame for the profiler and
+// moves any benchmark on.
+void DXSample::RecordFrameStats(int64_t gpuTime)
+{
+	EndProfileFrame();
+
+	const FrameTiming& timing = mFramePacer.GetLastFrame();
+	mFrameStats.Record(FrameStat_Cpu, timing.cpuTime);
+	if (timing.presentInterval > 0)
+	{
+		mFrameStats.Record(FrameStat_Present, timing.presentInterval);
+	}
+	if (gpuTime >= 0)
+	{
+		mFrameStats.Record(FrameStat_Gpu, gpuTime);
+	}
+	mFrameStats.EndFrame();
+	mFrameNumber++;
+
+	const int64_t now = mClock.Now();
+	if (!mFirstFrameRecorded)
+	{
+		mFirstFrameRecorded = true;
+		char message[128];
+		sprintf_s(message, "Time to first frame: %.2f ms\n", NanosecondsToMilliseconds(now - mStartTime));
+		OutputDebugStringA(message);
+	}
+
+	if (now - mLastStatsTitleTime >= StatsTitleInterval)
+	{
+		mLastStatsTitleTime = now;
+		char summary[256];
+		mFrameStats.FormatWindowSummary(summary, sizeof(summary));
+
+		WCHAR text[256];
+		swprintf_s(text, L"%hs", summary);
+		SetCustomWindowText(text);
+	}
+
+	if (mBenchmark == nullptr)
+	{
+		return;
+	}
+
+	// Measurement starts once the warm-up is over, so loading and first use costs aren't counted
+	mBenchmarkFrame++;
+	if (mBenchmarkFrame == mBenchmark->warmupFrames)
+	{
+		mFrameStats.Reset();
+		ResetProfileZones();
+		mBenchmarkStartAllocations = GetAllocationCounts();
+	}
+	else if (mBenchmarkFrame == mBenchmark->warmupFrames + mBenchmark->frameCount)
+	{
+		FinishBenchmark();
+	}
+}
+
+// Brackets recording and submitting a frame. In a benchmark's measured frames, any heap
+// allocations made in between fail the benchmark.
+void DXSample::BeginSteadyAllocationCheck()
+{
+	mSteadyCheckStart = GetAllocationCounts();
+}
+
+void DXSample::EndSteadyAllocationCheck()
+{
+	if (mBenchmark != nullptr && mBenchmarkFrame >= mBenchmark->warmupFrames)
+	{
+		mSteadyAllocations += GetAllocationCounts().allocations - mSteadyCheckStart.allocations;
+	}
+}
+
+// Writes the report, compares it with the baseline and closes the window
+void DXSample::FinishBenchmark()
+{
+	AllocationCounts allocations = GetAllocationCounts();
+	allocations.allocations -= mBenchmarkStartAllocations.allocations;
+	allocations.bytes -= mBenchmarkStartAllocations.bytes;
+
+	FILE* file = nullptr;
+	if (_wfopen_s(&file, mBenchmarkReportPath.c_str(), L"w") != 0 || file == nullptr)
+	{
+		OutputDebugStringW((L"Failed to open " + mBenchmarkReportPath + L"\n").c_str());
+		mExitCode = BenchmarkFailedExitCode;
+	}
+	else
+	{
+		if (!WriteBenchmarkReport(file, *mBenchmark, mFrameStats, allocations))
+		{
+			mExitCode = BenchmarkFailedExitCode;
+		}
+		fclose(file);
+	}
+
+	if (mExitCode == 0 && !mBenchmarkBaselinePath.empty())
+	{
+		// Read back what was written, so both sides of the comparison go through the same parsing
+		std::string baselineText;
+		std::string reportText;
+		std::map<std::string, double> baseline;
+		std::map<std::string, double> report;
+		if (!ReadTextFile(mBenchmarkBaselinePath, baselineText) || !FlattenJson(baselineText, baseline) ||
+			!ReadTextFile(mBenchmarkReportPath, reportText) || !FlattenJson(reportText, report))
+		{
+			OutputDebugStringW((L"Failed to read benchmark baseline " + mBenchmarkBaselinePath + L"\n").c_str());
+			mExitCode = BenchmarkFailedExitCode;
+		}
+		else
+		{
+			// Printed for scripts, which can redirect stderr even though this is a windowed app
+			fprintf(stderr, "Benchmark %s against %ls:\n", mBenchmark->name, mBenchmarkBaselinePath.c_str());
+			const unsigned int regressions = CompareBenchmarkReports(baseline, report, mBenchmarkTolerances, stderr);
+			fprintf(stderr, "%u regression(s)\n", regressions);
+
+			char message[128];
+			sprintf_s(message, "Benchmark %s: %u regression(s)\n", mBenchmark->name, regressions);
+			OutputDebugStringA(message);
+
+			if (regressions > 0)
+			{
+				mExitCode = BenchmarkRegressedExitCode;
+			}
+		}
+	}
+
+	// Recording a frame after the warm-up should be served entirely by the frame arenas and pools
+	if (mSteadyAllocations > 0)
+	{
+		fprintf(stderr, "Benchmark %s: %llu heap allocation(s) recording frames after the warm-up\n", mBenchmark->name, mSteadyAllocations);
+
+		char message[160];
+		sprintf_s(message, "Benchmark %s: %llu heap allocation(s) recording frames after the warm-up\n", mBenchmark->name, mSteadyAllocations);
+		OutputDebugStringA(message);
+
+		mExitCode = BenchmarkFailedExitCode;
+	}
+
+	DestroyWindow(Win32Application::GetHwnd());
+}
+
+// Writes the frame stats to the file given with -framestats (CSV if it ends in .csv, otherwise JSON)
+void DXSample::WriteFrameStats()
+{
+	if (mFrameStatsPath.empty())
+	{
+		return;
+	}
+
+	FILE* file = nullptr;
+	if (_wfopen_s(&file, mFrameStatsPath.c_str(), L"w") != 0 || file == nullptr)
+	{
+		OutputDebugStringW((L"Failed to open " + mFrameStatsPath + L"\n").c_str());
+		return;
+	}
+
+	const size_t length = mFrameStatsPath.length();
+	const bool csv = length >= 4 && _wcsicmp(mFrameStatsPath.c_str() + length - 4, L".csv") == 0;
+	if (csv)
+	{
+		mFrameStats.WriteCsv(file);
+	}
+	else
+	{
+		mFrameStats.WriteJson(file);
+	}
+	fclose(file);
 }
 
 // Helper function for parsing command line args
 _Use_decl_annotations_
 	void DXSample::ParseCommandLineArgs(WCHAR* argv[], int argc)
 {
+	FramePacerSettings pacerSettings = mFramePacer.GetSettings();
+
 	for (int i = 0; i < argc; i++)
 	{
 		if (_wcsnicmp(argv[i], L"-warp", wcslen(argv[i])) == 0 ||
@@ -112,6 +398,80 @@ _Use_decl_annotations_
 			mUseWarpDevice = true;
 			mTitle = mTitle + L" (WARP)";
 		}
+		else if (_wcsicmp(argv[i], L"-uncapped") == 0)
+		{
+			pacerSettings.vsync = false;
+		}
+		else if (_wcsicmp(argv[i], L"-maxlatency") == 0 && i + 1 < argc)
+		{
+			pacerSettings.maxFrameLatency = static_cast<unsigned int>(_wtoi(argv[++i]));
+		}
+		else if (_wcsicmp(argv[i], L"-fpslimit") == 0 && i + 1 < argc)
+		{
+			pacerSettings.frameLimitHz = _wtof(argv[++i]);
+		}
+		else if (_wcsicmp(argv[i], L"-framestats") == 0 && i + 1 < argc)
+		{
+			mFrameStatsPath = argv[++i];
+		}
+		else if (_wcsicmp(argv[i], L"-benchmark") == 0 && i + 1 < argc)
+		{
+			// Scenario names are plain ASCII
+			const std::wstring name = argv[++i];
+			mBenchmark = FindBenchmarkScenario(std::string(name.begin(), name.end()).c_str());
+			if (mBenchmark == nullptr)
+			{
+				// Printed for scripts, like the regression output. The app exits before creating its window.
+				fprintf(stderr, "Unknown benchmark scenario %ls. Scenarios are:", name.c_str());
+				for (unsigned int scenario = 0; scenario < GetBenchmarkScenarioCount(); scenario++)
+				{
+					fprintf(stderr, " %s", GetBenchmarkScenario(scenario).name);
+				}
+				fprintf(stderr, "\n");
+				OutputDebugStringW((L"Unknown benchmark scenario " + name + L"\n").c_str());
+				mExitCode = BenchmarkFailedExitCode;
+			}
+		}
+		else if (_wcsicmp(argv[i], L"-benchreport") == 0 && i + 1 < argc)
+		{
+			mBenchmarkReportPath = argv[++i];
+		}
+		else if (_wcsicmp(argv[i], L"-baseline") == 0 && i + 1 < argc)
+		{
+			mBenchmarkBaselinePath = argv[++i];
+		}
+		else if (_wcsicmp(argv[i], L"-tolerance") == 0 && i + 1 < argc)
+		{
+			mBenchmarkTolerances.time = _wtof(argv[++i]);
+		}
+		else if (_wcsicmp(argv[i], L"-alloctolerance") == 0 && i + 1 < argc)
+		{
+			mBenchmarkTolerances.allocations = _wtof(argv[++i]);
+		}
+		else if (_wcsicmp(argv[i], L"-timeslack") == 0 && i + 1 < argc)
+		{
+			mBenchmarkTolerances.timeSlackMs = _wtof(argv[++i]);
+		}
+		else if (_wcsicmp(argv[i], L"-capture") == 0 && i + 1 < argc)
+		{
+			mCaptureFrames.push_back(static_cast<unsigned int>(_wtoi(argv[++i])));
+		}
+	}
+
+	if (mBenchmark != nullptr)
+	{
+		// Run as fast as possible, so the display's refresh rate doesn't hide the frame times
+		pacerSettings.vsync = false;
+		pacerSettings.frameLimitHz = 0.0;
+
+		if (mBenchmarkReportPath.empty())
+		{
+			const std::string name = mBenchmark->name;
+			mBenchmarkReportPath = L"benchmark_" + std::wstring(name.begin(), name.end()) + L".json";
+		}
+		mTitle = mTitle + L" (Benchmark)";
 	}
+
+	mFramePacer.SetSettings(pacerSettings);
 }
 
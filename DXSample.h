@@ -5,6 +5,17 @@
 
 #include "DXSampleHelper.h"
 #include "Win32Application.h"
+#include "JobSystem.h"
+#include "AsyncFileIO.h"
+#include "AssetArchive.h"
+#include "Clock.h"
+#include "FramePacer.h"
+#include "FixedStepScheduler.h"
+#include "FrameStats.h"
+#include "Benchmark.h"
+#include "FrameArena.h"
+
+#include <memory>
 
 // Abstract class that holds base functionality for DX12 Apps.
 class DXSample
@@ -21,7 +32,13 @@ public:
 	virtual ~DXSample();
 
 	virtual void OnInit() = 0;
+
+	// Called at the start of each frame, before input is handled. Waits for the frame pacer,
+	// then resets the frame arenas for the new frame.
+	virtual void OnBeginFrame();
+
 	virtual void OnUpdate(const float deltaTime) = 0;
+	virtual void OnFixedUpdate(const float /*stepTime*/) {}
 	virtual void OnRender() = 0;
 	virtual void OnDestroy() = 0;
 
@@ -29,12 +46,19 @@ public:
 	UINT GetWidth() const { return mWidth; }
 	UINT GetHeight() const { return mHeight; }
 	const WCHAR* GetTitle() const { return mTitle.c_str(); }
+	int GetExitCode() const { return mExitCode; }
+
+	// Runs the fixed simulation steps owed for the elapsed time (in nanoseconds), then OnUpdate
+	void UpdateFrame(int64_t elapsed);
 
 	void ParseCommandLineArgs(_In_reads_(argc) WCHAR* argv[], int argc);
 
 protected:
 	std::wstring GetAssetFullPath(LPCWSTR assetName);
 
+	// Reads an asset from the mounted archive if it holds it, otherwise from the loose file
+	void ReadAssetAsync(LPCWSTR assetName, EIOPriority priority, AsyncFileIO::Callback callback);
+
 	void GetHardwareAdapter(
 		_In_ IDXGIFactory1* pFactory,
 		_Outptr_result_maybenull_ IDXGIAdapter1** ppAdapter,
@@ -42,6 +66,19 @@ protected:
 
 	void SetCustomWindowText(LPCWSTR text);
 
+	// Records this frame's times from the frame pacer, plus the GPU time if known (-1 if not),
+	// and refreshes the title bar summary every so often. Ends the frame for the profiler and
+	// moves any benchmark on.
+	void RecordFrameStats(int64_t gpuTime);
+
+	// Writes the frame stats to the file given with -framestats (CSV if it ends in .csv, otherwise JSON)
+	void WriteFrameStats();
+
+	// Brackets recording and submitting a frame. In a benchmark's measured frames, any heap
+	// allocations made in between fail the benchmark, as a warmed up frame shouldn't make any.
+	void BeginSteadyAllocationCheck();
+	void EndSteadyAllocationCheck();
+
 	// Viewport dimensions
 	UINT mWidth;
 	UINT mHeight;
@@ -50,11 +87,66 @@ protected:
 	// Adapter info
 	bool mUseWarpDevice;
 
+	// Fixed rate simulation. Rendering can use its alpha to interpolate between steps.
+	FixedStepScheduler mSimulation;
+
+	// Frame pacing, set up from the command line (-uncapped, -maxlatency <n>, -fpslimit <hz>)
+	SystemClock mClock;
+	FramePacer mFramePacer;
+
+	// Frame time histograms
+	FrameStats mFrameStats;
+
+	// Benchmark run from the command line (-benchmark <scenario>), or null. Frames count from
+	// the start of the run, including the warm-up.
+	const BenchmarkScenario* mBenchmark;
+	unsigned int mBenchmarkFrame;
+
+	// Frames recorded so far, and the frame numbers to capture to images (-capture <frame>,
+	// which can be given more than once)
+	unsigned int mFrameNumber;
+	std::vector<unsigned int> mCaptureFrames;
+
+	// Worker threads and asynchronous file loading shared by the app
+	std::unique_ptr<JobSystem> mJobSystem;
+	std::unique_ptr<AsyncFileIO> mFileIO;
+
+	// Per thread arenas for transient data that only lasts the frame
+	std::unique_ptr<FrameArenas> mFrameArenas;
+
 private:
 	// Root assets path
 	std::wstring mAssetsPath;
 
+	// Packed assets, mounted from the assets path if present
+	AssetArchive mAssetArchive;
+
 	// Window title
 	std::wstring mTitle;
+
+	std::wstring mFrameStatsPath;
+	int64_t mLastStatsTitleTime;
+
+	// From construction to the end of the first frame, reported to the debug output
+	int64_t mStartTime;
+	bool mFirstFrameRecorded;
+
+	// Benchmark report and the baseline to compare it with (-benchreport <path>, -baseline <path>).
+	// The tolerances are set with -tolerance <time fraction>, -alloctolerance <fraction> and
+	// -timeslack <ms>.
+	std::wstring mBenchmarkReportPath;
+	std::wstring mBenchmarkBaselinePath;
+	BenchmarkTolerances mBenchmarkTolerances;
+	AllocationCounts mBenchmarkStartAllocations;
+
+	// Allocations made while recording measured frames, which should stay at zero
+	AllocationCounts mSteadyCheckStart;
+	uint64_t mSteadyAllocations;
+
+	// Returned from the program: non-zero if a benchmark failed or regressed
+	int mExitCode;
+
+	// Writes the report, compares it with the baseline and closes the window
+	void FinishBenchmark();
 };
 
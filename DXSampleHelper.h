@@ -4,6 +4,9 @@
 #pragma once
 
 #include "Includes.h"
+#include "Align.h"
+#include "AssetArchive.h"
+#include "DdsFormat.h"
 #include <stdexcept>
 
 //// Link d3d12 libraries
@@ -64,6 +67,26 @@ inline HRESULT ReadDataFromFile(LPCWSTR filename, byte** data, UINT* size)
 {
 	using namespace Microsoft::WRL;
 
+	// Files in the mounted asset archive are read from it rather than from disk
+	const AssetArchive* archive = nullptr;
+	const ArchiveEntry* entry = FindMountedAsset(filename, &archive);
+	if (entry != nullptr)
+	{
+		if (entry->size > MAXDWORD)
+		{
+			throw std::exception();
+		}
+
+		*data = reinterpret_cast<byte*>(malloc(static_cast<size_t>(entry->size)));
+		*size = static_cast<UINT>(entry->size);
+		if ((*data == nullptr && *size > 0) || !archive->Read(*entry, *data, *size))
+		{
+			free(*data);
+			throw std::exception();
+		}
+		return S_OK;
+	}
+
 #if WINVER >= _WIN32_WINNT_WIN8
 	CREATEFILE2_EXTENDED_PARAMETERS extendedParams = {};
 	extendedParams.dwSize = sizeof(CREATEFILE2_EXTENDED_PARAMETERS);
@@ -118,52 +141,30 @@ inline HRESULT ReadDataFromDDSFile(LPCWSTR filename, byte** data, UINT* offset,
 	}
 
 	// DDS files always start with the same magic number
-	static const UINT DDS_MAGIC = 0x20534444;
-	UINT magicNumber = *reinterpret_cast<const UINT*>(*data);
-	if (magicNumber != DDS_MAGIC)
+	if (*size < sizeof(UINT) + sizeof(DdsHeader) || *reinterpret_cast<const UINT*>(*data) != DdsMagic)
 	{
 		return E_FAIL;
 	}
 
-	struct DDS_PIXELFORMAT
-	{
-		UINT size;
-		UINT flags;
-		UINT fourCC;
-		UINT rgbBitCount;
-		UINT rBitMask;
-		UINT gBitMask;
-		UINT bBitMask;
-		UINT aBitMask;
-	};
-
-	struct DDS_HEADER
-	{
-		UINT size;
-		UINT flags;
-		UINT height;
-		UINT width;
-		UINT pitchOrLinearSize;
-		UINT depth;
-		UINT mipMapCount;
-		UINT reserved1[11];
-		DDS_PIXELFORMAT ddsPixelFormat;
-		UINT caps;
-		UINT caps2;
-		UINT caps3;
-		UINT caps4;
-		UINT reserved2;
-	};
-
-	auto ddsHeader = reinterpret_cast<const DDS_HEADER*>(*data + sizeof(UINT));
-	if (ddsHeader->size != sizeof(DDS_HEADER) || ddsHeader->ddsPixelFormat.size != sizeof(DDS_PIXELFORMAT))
+	auto ddsHeader = reinterpret_cast<const DdsHeader*>(*data + sizeof(UINT));
+	if (ddsHeader->size != sizeof(DdsHeader) || ddsHeader->pixelFormat.size != sizeof(DdsPixelFormat))
 	{
 		return E_FAIL;
 	}
 
-	const ptrdiff_t ddsDataOffset = sizeof(UINT) + sizeof(DDS_HEADER);
-	*offset = ddsDataOffset;
-	*size = *size - ddsDataOffset;
+	// Files written with a DXGI format (like the texture cooker's) have an extra header
+	ptrdiff_t ddsDataOffset = sizeof(UINT) + sizeof(DdsHeader);
+	if ((ddsHeader->pixelFormat.flags & DdsPixelFormat_FourCC) && ddsHeader->pixelFormat.fourCC == DdsFourCC_Dx10)
+	{
+		ddsDataOffset += sizeof(DdsHeaderDx10);
+		if (*size < static_cast<UINT>(ddsDataOffset))
+		{
+			return E_FAIL;
+		}
+	}
+
+	*offset = static_cast<UINT>(ddsDataOffset);
+	*size = *size - static_cast<UINT>(ddsDataOffset);
 
 	return S_OK;
 }
@@ -199,18 +200,10 @@ inline void SetNameIndexed(ID3D12Object*, LPCWSTR, UINT)
 #define NAME_D3D12_OBJECT_INDEXED(x, n) SetNameIndexed((x)[n].Get(), L#x, n)
 
 // Calculates size of constant buffers. The constant buffer must be a multiple of the
-// minimum hardware allocation size
+// minimum hardware allocation size (D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT = 256)
 inline UINT CalculateConstantBufferByteSize(UINT byteSize)
 {
-	// e.g. in the case D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT = 256
-	// Say byteSize = 300
-	// (300 + 256 - 1) & ~(256 - 1)
-	// = 555 & ~255
-	// = 0x022B & ~0x00FF
-	// = 0x022B & 0xFF00
-	// = 0x0200
-	// = 512 (which is the smallest multiple of 256 above 300)
-	return (byteSize + (D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT - 1)) & ~(D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT - 1);
+	return AlignUp<UINT>(byteSize, D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT);
 }
 
 #ifdef D3D_COMPILE_STANDARD_FILE_INCLUDE
@@ -227,10 +220,18 @@ inline Microsoft::WRL::ComPtr<ID3DBlob> CompileShader(
 
 	HRESULT hr;
 
+	// The source is read through ReadDataFromFile so it can come from the mounted asset archive.
+	// Includes are still found on disk, relative to the file.
+	byte* source = nullptr;
+	UINT sourceSize = 0;
+	ReadDataFromFile(filename.c_str(), &source, &sourceSize);
+	const std::string sourceName(filename.begin(), filename.end());
+
 	Microsoft::WRL::ComPtr<ID3DBlob> byteCode = nullptr;
 	Microsoft::WRL::ComPtr<ID3DBlob> errors;
-	hr = D3DCompileFromFile(filename.c_str(), defines, D3D_COMPILE_STANDARD_FILE_INCLUDE,
+	hr = D3DCompile(source, sourceSize, sourceName.c_str(), defines, D3D_COMPILE_STANDARD_FILE_INCLUDE,
 		entrypoint.c_str(), target.c_str(), compileFlags, 0, &byteCode, &errors);
+	free(source);
 
 	if (errors != nullptr)
 	{
@@ -0,0 +1,94 @@
+// On-disk layout of DDS (DirectDraw Surface) texture files, shared by the reader and the texture cooker
+//
+// [DdsMagic]
+// [DdsHeader]
+// [DdsHeaderDx10]		Only if the pixel format's fourCC is DdsFourCC_Dx10
+// [Surface data...]	Each mip in turn, largest first
+
+#pragma once
+
+#include <cstdint>
+
+static const uint32_t DdsMagic = 0x20534444; // "DDS "
+
+static const uint32_t DdsFourCC_Dx10 = 0x30315844; // "DX10"
+
+enum EDdsHeaderFlags
+{
+	DdsHeader_Caps = 0x1,
+	DdsHeader_Height = 0x2,
+	DdsHeader_Width = 0x4,
+	DdsHeader_Pitch = 0x8,
+	DdsHeader_PixelFormat = 0x1000,
+	DdsHeader_MipMapCount = 0x20000,
+	DdsHeader_LinearSize = 0x80000
+};
+
+enum EDdsPixelFormatFlags
+{
+	DdsPixelFormat_FourCC = 0x4
+};
+
+enum EDdsCaps
+{
+	DdsCaps_Complex = 0x8,
+	DdsCaps_Texture = 0x1000,
+	DdsCaps_MipMap = 0x400000
+};
+
+// The DXGI_FORMAT values the cooker writes, so this header doesn't need dxgi
+enum EDdsDxgiFormat
+{
+	DdsDxgiFormat_R8G8B8A8_UNorm = 28,
+	DdsDxgiFormat_R8G8B8A8_UNorm_sRGB = 29,
+	DdsDxgiFormat_BC1_UNorm = 71,
+	DdsDxgiFormat_BC1_UNorm_sRGB = 72,
+	DdsDxgiFormat_BC5_UNorm = 83,
+	DdsDxgiFormat_BC7_UNorm = 98,
+	DdsDxgiFormat_BC7_UNorm_sRGB = 99
+};
+
+static const uint32_t DdsResourceDimension_Texture2D = 3;
+
+struct DdsPixelFormat
+{
+	uint32_t size;
+	uint32_t flags;
+	uint32_t fourCC;
+	uint32_t rgbBitCount;
+	uint32_t rBitMask;
+	uint32_t gBitMask;
+	uint32_t bBitMask;
+	uint32_t aBitMask;
+};
+
+struct DdsHeader
+{
+	uint32_t size;
+	uint32_t flags;
+	uint32_t height;
+	uint32_t width;
+	uint32_t pitchOrLinearSize;	// Bytes in the top mip, for compressed formats
+	uint32_t depth;
+	uint32_t mipMapCount;
+	uint32_t reserved1[11];
+	DdsPixelFormat pixelFormat;
+	uint32_t caps;
+	uint32_t caps2;
+	uint32_t caps3;
+	uint32_t caps4;
+	uint32_t reserved2;
+};
+
+struct DdsHeaderDx10
+{
+	uint32_t dxgiFormat;
+	uint32_t resourceDimension;
+	uint32_t miscFlag;
+	uint32_t arraySize;
+	uint32_t miscFlags2;
+};
+
+static_assert(sizeof(DdsPixelFormat) == 32, "DdsPixelFormat layout changed");
+static_assert(sizeof(DdsHeader) == 124, "DdsHeader layout changed");
+static_assert(sizeof(DdsHeaderDx10) == 20, "DdsHeaderDx10 layout changed");
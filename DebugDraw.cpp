@@ -0,0 +1,196 @@
+#include "DebugDraw.h"
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+const uint32_t DebugDraw::SphereSegments;
+
+namespace
+{
+	// The box corner pairs joined by its edges: those differing in one bit of the index
+	const uint8_t BoxEdges[12][2] =
+	{
+		{ 0, 1 }, { 2, 3 }, { 4, 5 }, { 6, 7 },	// Along x
+		{ 0, 2 }, { 1, 3 }, { 4, 6 }, { 5, 7 },	// Along y
+		{ 0, 4 }, { 1, 5 }, { 2, 6 }, { 3, 7 }	// Along z
+	};
+
+	// Points around the unit circle, worked out once rather than for every sphere
+	struct UnitCircle
+	{
+		float cosine[DebugDraw::SphereSegments + 1];
+		float sine[DebugDraw::SphereSegments + 1];
+
+		UnitCircle()
+		{
+			for (uint32_t i = 0; i <= DebugDraw::SphereSegments; i++)
+			{
+				const double angle = 2.0 * 3.14159265358979323846 * (i % DebugDraw::SphereSegments) / DebugDraw::SphereSegments;
+				cosine[i] = static_cast<float>(cos(angle));
+				sine[i] = static_cast<float>(sin(angle));
+			}
+		}
+	};
+
+	const UnitCircle sUnitCircle;
+
+	inline void WriteVertex(DebugLineVertex* vertex, float x, float y, float z, uint32_t colour)
+	{
+		vertex->position[0] = x;
+		vertex->position[1] = y;
+		vertex->position[2] = z;
+		vertex->colour = colour;
+	}
+}
+
+// A vertex list for the main thread and each of the given number of workers
+DebugDraw::DebugDraw(unsigned int workerCount)
+{
+	for (unsigned int thread = 0; thread < workerCount + 1; thread++)
+	{
+		mThreads.emplace_back(new ThreadVertices());
+		mThreads.back()->count = 0;
+	}
+}
+
+// Clears the last frame's shapes. Nothing may be adding shapes at the time.
+void DebugDraw::Reset()
+{
+	for (const std::unique_ptr<ThreadVertices>& thread : mThreads)
+	{
+		thread->count = 0;
+	}
+}
+
+void DebugDraw::AddLine(const float a[3], const float b[3], uint32_t colour)
+{
+	ThreadVertices& thread = GetThreadVertices();
+	DebugLineVertex* vertex = ReserveVertices(thread, 2);
+	WriteVertex(&vertex[0], a[0], a[1], a[2], colour);
+	WriteVertex(&vertex[1], b[0], b[1], b[2], colour);
+	thread.count += 2;
+}
+
+// Axis aligned, from its minimum and maximum corners
+void DebugDraw::AddAabb(const float minimum[3], const float maximum[3], uint32_t colour)
+{
+	float corners[8][3];
+	for (int corner = 0; corner < 8; corner++)
+	{
+		corners[corner][0] = (corner & 1) ? maximum[0] : minimum[0];
+		corners[corner][1] = (corner & 2) ? maximum[1] : minimum[1];
+		corners[corner][2] = (corner & 4) ? maximum[2] : minimum[2];
+	}
+	AddBox(corners, colour);
+}
+
+// Any box, from its corners. Corner i is at the maximum on x if bit 0 is set, on y if bit 1
+// is and on z if bit 2 is, as AddAabb would place them before transforming.
+void DebugDraw::AddBox(const float corners[8][3], uint32_t colour)
+{
+	ThreadVertices& thread = GetThreadVertices();
+	DebugLineVertex* vertex = ReserveVertices(thread, 24);
+	for (const uint8_t* edge : BoxEdges)
+	{
+		const float* a = corners[edge[0]];
+		const float* b = corners[edge[1]];
+		WriteVertex(vertex++, a[0], a[1], a[2], colour);
+		WriteVertex(vertex++, b[0], b[1], b[2], colour);
+	}
+	thread.count += 24;
+}
+
+// A circle around each axis
+void DebugDraw::AddSphere(const float centre[3], float radius, uint32_t colour)
+{
+	const uint32_t vertexCount = SphereSegments * 2 * 3;
+	ThreadVertices& thread = GetThreadVertices();
+	DebugLineVertex* vertex = ReserveVertices(thread, vertexCount);
+
+	const float x = centre[0];
+	const float y = centre[1];
+	const float z = centre[2];
+	for (uint32_t i = 0; i < SphereSegments; i++)
+	{
+		const float c0 = sUnitCircle.cosine[i] * radius;
+		const float s0 = sUnitCircle.sine[i] * radius;
+		const float c1 = sUnitCircle.cosine[i + 1] * radius;
+		const float s1 = sUnitCircle.sine[i + 1] * radius;
+
+		// Around z, then y, then x
+		WriteVertex(vertex++, x + c0, y + s0, z, colour);
+		WriteVertex(vertex++, x + c1, y + s1, z, colour);
+		WriteVertex(vertex++, x + c0, y, z + s0, colour);
+		WriteVertex(vertex++, x + c1, y, z + s1, colour);
+		WriteVertex(vertex++, x, y + c0, z + s0, colour);
+		WriteVertex(vertex++, x, y + c1, z + s1, colour);
+	}
+	thread.count += vertexCount;
+}
+
+// The frustum of a view projection matrix, from its inverse. Matrices are row major and
+// transform row vectors, as DirectXMath's do, with depth from 0 at the near plane to 1 at the far.
+void DebugDraw::AddFrustum(const float inverseViewProj[16], uint32_t colour)
+{
+	// The corners of clip space back in world space, in the same order as a box's
+	const float* m = inverseViewProj;
+	float corners[8][3];
+	for (int corner = 0; corner < 8; corner++)
+	{
+		const float x = (corner & 1) ? 1.0f : -1.0f;
+		const float y = (corner & 2) ? 1.0f : -1.0f;
+		const float z = (corner & 4) ? 1.0f : 0.0f;
+		const float w = x * m[3] + y * m[7] + z * m[11] + m[15];
+		const float scale = w != 0.0f ? 1.0f / w : 0.0f;
+		for (int axis = 0; axis < 3; axis++)
+		{
+			corners[corner][axis] = (x * m[axis] + y * m[4 + axis] + z * m[8 + axis] + m[12 + axis]) * scale;
+		}
+	}
+	AddBox(corners, colour);
+}
+
+// This frame's vertices over all threads
+size_t DebugDraw::GetVertexCount() const
+{
+	size_t count = 0;
+	for (const std::unique_ptr<ThreadVertices>& thread : mThreads)
+	{
+		count += thread->count;
+	}
+	return count;
+}
+
+// Copies every thread's vertices into one list, which must have room for GetVertexCount().
+// Nothing may be adding shapes at the time.
+void DebugDraw::CopyVertices(DebugLineVertex* destination) const
+{
+	for (const std::unique_ptr<ThreadVertices>& thread : mThreads)
+	{
+		if (thread->count > 0)
+		{
+			memcpy(destination, thread->vertices.data(), thread->count * sizeof(DebugLineVertex));
+			destination += thread->count;
+		}
+	}
+}
+
+// Workers use their own list, anything else the main thread's
+DebugDraw::ThreadVertices& DebugDraw::GetThreadVertices()
+{
+	const int worker = JobSystem::GetWorkerIndex();
+	return *mThreads[worker >= 0 ? static_cast<size_t>(worker) + 1 : 0];
+}
+
+// Returns room for count more vertices after the thread's current ones. Callers move the
+// thread's count on by as many as they write.
+DebugLineVertex* DebugDraw::ReserveVertices(ThreadVertices& thread, size_t count)
+{
+	if (thread.count + count > thread.vertices.size())
+	{
+		thread.vertices.resize((std::max)(thread.count + count, thread.vertices.size() * 2));
+	}
+	return thread.vertices.data() + thread.count;
+}
@@ -0,0 +1,85 @@
+// Debug drawing
+// Lines, boxes, spheres and frusta in world space, for seeing bounds, cameras and the like.
+// Shapes only last the frame they're added in, and are turned into a line list, two vertices
+// per line, to be drawn in one call.
+//
+// Can be called from the main thread and from the job system's workers at the same time.
+// Each thread adds to its own vertex list, so there's no locking; the lists are only merged
+// when the frame's vertices are copied out for drawing. The lists are kept between frames, so
+// once they've grown to fit a frame, adding shapes doesn't allocate.
+//
+// Only builds vertices, so can be run and timed without a device.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+struct DebugLineVertex
+{
+	float position[3];
+	uint32_t colour;	// RGBA8, red in the low byte
+};
+
+inline uint32_t DebugColour(uint8_t r, uint8_t g, uint8_t b, uint8_t a = 255)
+{
+	return static_cast<uint32_t>(r) | (static_cast<uint32_t>(g) << 8) | (static_cast<uint32_t>(b) << 16) | (static_cast<uint32_t>(a) << 24);
+}
+
+class DebugDraw
+{
+public:
+	static const uint32_t SphereSegments = 16;	// Lines per circle, three circles per sphere
+
+	// A vertex list for the main thread and each of the given number of workers
+	explicit DebugDraw(unsigned int workerCount);
+
+	// Prohibit copying
+	DebugDraw(const DebugDraw& rhs) = delete;
+	DebugDraw& operator=(const DebugDraw& rhs) = delete;
+
+	// Clears the last frame's shapes. Nothing may be adding shapes at the time.
+	void Reset();
+
+	void AddLine(const float a[3], const float b[3], uint32_t colour);
+
+	// Axis aligned, from its minimum and maximum corners
+	void AddAabb(const float minimum[3], const float maximum[3], uint32_t colour);
+
+	// Any box, from its corners. Corner i is at the maximum on x if bit 0 is set, on y if bit 1
+	// is and on z if bit 2 is, as AddAabb would place them before transforming.
+	void AddBox(const float corners[8][3], uint32_t colour);
+
+	// A circle around each axis
+	void AddSphere(const float centre[3], float radius, uint32_t colour);
+
+	// The frustum of a view projection matrix, from its inverse. Matrices are row major and
+	// transform row vectors, as DirectXMath's do, with depth from 0 at the near plane to 1 at the far.
+	void AddFrustum(const float inverseViewProj[16], uint32_t colour);
+
+	// This frame's vertices over all threads
+	size_t GetVertexCount() const;
+	size_t GetVertexDataSize() const { return GetVertexCount() * sizeof(DebugLineVertex); }
+
+	// Copies every thread's vertices into one list, which must have room for GetVertexCount().
+	// Nothing may be adding shapes at the time.
+	void CopyVertices(DebugLineVertex* destination) const;
+
+	// Getters
+	unsigned int GetThreadCount() const { return static_cast<unsigned int>(mThreads.size()); }
+
+private:
+	struct ThreadVertices
+	{
+		std::vector<DebugLineVertex> vertices;	// Only grows; the first count are this frame's
+		size_t count;
+	};
+
+	ThreadVertices& GetThreadVertices();
+	static DebugLineVertex* ReserveVertices(ThreadVertices& thread, size_t count);
+
+	// Separate allocations, so threads adding at the same time don't share cache lines
+	std::vector<std::unique_ptr<ThreadVertices>> mThreads;
+};
@@ -0,0 +1,121 @@
+#include "DebugDrawRenderer.h"
+
+#include <cstring>
+
+using namespace DirectX;
+
+const UINT64 DebugDrawRenderer::MinVertexBufferSize;
+
+DebugDrawRenderer::DebugDrawRenderer(ID3D12Device* device, GpuMemoryAllocator* uploadAllocator) :
+	mDevice(device),
+	mUploadAllocator(uploadAllocator),
+	mPsoCache(nullptr),
+	mPso(PsoCache::InvalidHandle)
+{
+	// Just the view projection matrix, as root constants for the vertex shader
+	CD3DX12_ROOT_PARAMETER rootParameters[1];
+	rootParameters[0].InitAsConstants(sizeof(XMFLOAT4X4) / 4, 2, 0, D3D12_SHADER_VISIBILITY_VERTEX);
+
+	CD3DX12_ROOT_SIGNATURE_DESC rootSignatureDesc;
+	rootSignatureDesc.Init(_countof(rootParameters), rootParameters, 0, nullptr,
+		D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT);
+
+	ComPtr<ID3DBlob> signature;
+	ComPtr<ID3DBlob> error;
+	ThrowIfFailed(D3D12SerializeRootSignature(&rootSignatureDesc, D3D_ROOT_SIGNATURE_VERSION_1, &signature, &error));
+	ThrowIfFailed(mDevice->CreateRootSignature(0, signature->GetBufferPointer(), signature->GetBufferSize(), IID_PPV_ARGS(&mRootSignature)));
+}
+
+// The GPU must have finished with the lines
+DebugDrawRenderer::~DebugDrawRenderer()
+{
+	GpuMemoryAllocator* uploadAllocator = mUploadAllocator;
+	mVertexBuffers.Clear([uploadAllocator](GpuMemoryAllocator::Handle handle)
+	{
+		uploadAllocator->Free(handle);
+	});
+}
+
+// Requests the pipeline state from the cache. Nothing is drawn until it's ready.
+void DebugDrawRenderer::CreatePipeline(PsoCache* psoCache, ID3DBlob* vertexShader, ID3DBlob* pixelShader)
+{
+	D3D12_INPUT_ELEMENT_DESC inputElementDescs[] =
+	{
+		{ "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+		{ "COLOR", 0, DXGI_FORMAT_R8G8B8A8_UNORM, 0, 12, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 }
+	};
+
+	// Drawn over the frame without depth testing, as there's no depth buffer
+	D3D12_GRAPHICS_PIPELINE_STATE_DESC psoDesc = {};
+	psoDesc.InputLayout = { inputElementDescs, _countof(inputElementDescs) };
+	psoDesc.pRootSignature = mRootSignature.Get();
+	psoDesc.VS = CD3DX12_SHADER_BYTECODE(vertexShader);
+	psoDesc.PS = CD3DX12_SHADER_BYTECODE(pixelShader);
+	psoDesc.RasterizerState = CD3DX12_RASTERIZER_DESC(D3D12_DEFAULT);
+	psoDesc.RasterizerState.CullMode = D3D12_CULL_MODE_NONE;
+	psoDesc.BlendState = CD3DX12_BLEND_DESC(D3D12_DEFAULT);
+	psoDesc.DepthStencilState.DepthEnable = FALSE;
+	psoDesc.DepthStencilState.StencilEnable = FALSE;
+	psoDesc.SampleMask = UINT_MAX;
+	psoDesc.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_LINE;
+	psoDesc.NumRenderTargets = 1;
+	psoDesc.RTVFormats[0] = DXGI_FORMAT_R8G8B8A8_UNORM;
+	psoDesc.SampleDesc.Count = 1;
+
+	mPsoCache = psoCache;
+	mPso = mPsoCache->Request(psoDesc);
+}
+
+// Copies the frame's lines to an upload buffer and draws them with the view projection
+// matrix. Nothing may be adding lines at the time. fenceValue is the value the queue signals
+// after the list is submitted.
+void DebugDrawRenderer::Record(ID3D12GraphicsCommandList* commandList, const DebugDraw& debugDraw, const XMFLOAT4X4& viewProj, UINT64 fenceValue, UINT64 completedFenceValue)
+{
+	ID3D12PipelineState* pipelineState = mPsoCache != nullptr ? mPsoCache->Get(mPso) : nullptr;
+	const size_t vertexCount = debugDraw.GetVertexCount();
+	const UINT64 vertexDataSize = vertexCount * sizeof(DebugLineVertex);
+	if (pipelineState == nullptr || vertexCount == 0)
+	{
+		return;
+	}
+
+	// A buffer whose last frame has finished, swapped for a bigger one if this frame's lines don't fit
+	GpuMemoryAllocator* uploadAllocator = mUploadAllocator;
+	auto allocate = [uploadAllocator, vertexDataSize]()
+	{
+		UINT64 size = MinVertexBufferSize;
+		while (size < vertexDataSize)
+		{
+			size *= 2;
+		}
+		return uploadAllocator->Allocate(size, D3D12_RESOURCE_STATE_GENERIC_READ);
+	};
+
+	GpuMemoryAllocator::Handle vertexBuffer = mVertexBuffers.Acquire(completedFenceValue, allocate);
+	if (mUploadAllocator->GetSize(vertexBuffer) < vertexDataSize)
+	{
+		mUploadAllocator->Free(vertexBuffer);
+		vertexBuffer = allocate();
+	}
+
+	// The threads' lists are merged as they're copied, with no list in between
+	debugDraw.CopyVertices(static_cast<DebugLineVertex*>(mUploadAllocator->GetCpuAddress(vertexBuffer)));
+
+	D3D12_VERTEX_BUFFER_VIEW vertexBufferView;
+	vertexBufferView.BufferLocation = mUploadAllocator->GetGpuAddress(vertexBuffer);
+	vertexBufferView.StrideInBytes = sizeof(DebugLineVertex);
+	vertexBufferView.SizeInBytes = static_cast<UINT>(vertexDataSize);
+
+	// HLSL matrices are column major
+	XMFLOAT4X4 constants;
+	XMStoreFloat4x4(&constants, XMMatrixTranspose(XMLoadFloat4x4(&viewProj)));
+
+	commandList->SetGraphicsRootSignature(mRootSignature.Get());
+	commandList->SetGraphicsRoot32BitConstants(0, sizeof(XMFLOAT4X4) / 4, &constants, 0);
+	commandList->SetPipelineState(pipelineState);
+	commandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_LINELIST);
+	commandList->IASetVertexBuffers(0, 1, &vertexBufferView);
+	commandList->DrawInstanced(static_cast<UINT>(vertexCount), 1, 0, 0);
+
+	mVertexBuffers.Release(vertexBuffer, fenceValue);
+}
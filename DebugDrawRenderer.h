@@ -0,0 +1,48 @@
+// Debug draw renderer
+// Draws a frame's DebugDraw lines in one call, as a line list over the bound render target.
+// Every thread's lines are copied straight into an upload buffer, which is recycled once the
+// GPU has finished the frame using it.
+
+#pragma once
+
+#include "DXSampleHelper.h"
+#include "DebugDraw.h"
+#include "FencedPool.h"
+#include "GpuMemoryAllocator.h"
+#include "PsoCache.h"
+
+#include <DirectXMath.h>
+
+class DebugDrawRenderer
+{
+public:
+	DebugDrawRenderer(ID3D12Device* device, GpuMemoryAllocator* uploadAllocator);
+
+	// Prohibit copying
+	DebugDrawRenderer(const DebugDrawRenderer& rhs) = delete;
+	DebugDrawRenderer& operator=(const DebugDrawRenderer& rhs) = delete;
+
+	// The GPU must have finished with the lines
+	~DebugDrawRenderer();
+
+	// Requests the pipeline state from the cache. Nothing is drawn until it's ready.
+	void CreatePipeline(PsoCache* psoCache, ID3DBlob* vertexShader, ID3DBlob* pixelShader);
+
+	// Copies the frame's lines to an upload buffer and draws them with the view projection
+	// matrix. Nothing may be adding lines at the time. fenceValue is the value the queue signals
+	// after the list is submitted.
+	void Record(ID3D12GraphicsCommandList* commandList, const DebugDraw& debugDraw, const DirectX::XMFLOAT4X4& viewProj, UINT64 fenceValue, UINT64 completedFenceValue);
+
+private:
+	static const UINT64 MinVertexBufferSize = 64 * 1024;
+
+	ComPtr<ID3D12Device> mDevice;
+	GpuMemoryAllocator* mUploadAllocator;
+
+	ComPtr<ID3D12RootSignature> mRootSignature;
+	PsoCache* mPsoCache;
+	PsoCache::Handle mPso;
+
+	// Upload buffers for the vertices, each reused once the frame it was used in has finished
+	FencedPool<GpuMemoryAllocator::Handle> mVertexBuffers;
+};
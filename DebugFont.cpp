@@ -0,0 +1,136 @@
+#include "DebugFont.h"
+
+namespace
+{
+	const uint32_t GlyphCount = DebugFontLastChar - DebugFontFirstChar + 1;
+
+	// Two pixels a byte, the left in the high nibble, rows top to bottom. The baseline is row 12.
+	const uint8_t Glyphs[GlyphCount][DebugFontGlyphWidth * DebugFontGlyphHeight / 2] =
+	{
+		{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },	// ' '
+		{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x07, 0x70, 0x00, 0x00, 0x0A, 0xA0, 0x00, 0x00, 0x0A, 0xA0, 0x00, 0x00, 0x0A, 0xA0, 0x00, 0x00, 0x0A, 0xA0, 0x00, 0x00, 0x09, 0xA0, 0x00, 0x00, 0x06, 0x60, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x07, 0x70, 0x00, 0x00, 0x0A, 0xA0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },	// '!'
+		{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x83, 0x38, 0x00, 0x00, 0xD5, 0x5D, 0x00, 0x00, 0xD5, 0x5D, 0x00, 0x00, 0xA4, 0x4A, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },	// '"'
+		{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x05, 0x30, 0x80, 0x00, 0x0D, 0x33, 0xC0, 0x00, 0x2E, 0x08, 0x80, 0x2D, 0xDF, 0xDE, 0xDD, 0x03, 0xA8, 0x3F, 0x33, 0x00, 0xD3, 0x3C, 0x00, 0xAA, 0xFA, 0xCD, 0xA2, 0x59, 0xB5, 0xD8, 0x51, 0x09, 0x60, 0xE1, 0x00, 0x0D, 0x34, 0xC0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },	// '#'
+		{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x10, 0x00, 0x00, 0x03, 0x80, 0x00, 0x00, 0x39, 0xB7, 0x30, 0x05, 0xE8, 0xA8, 0x80, 0x0B, 0x73, 0x80, 0x00, 0x09, 0xB4, 0x80, 0x00, 0x01, 0xAF, 0xE9, 0x20, 0x00, 0x03, 0xAA, 0xD0, 0x00, 0x03, 0x80, 0xF3, 0x07, 0x33, 0x85, 0xE1, 0x07, 0xCF, 0xFC, 0x40, 0x00, 0x03, 0x80, 0x00, 0x00, 0x03, 0x80, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },	// '$'
+		{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x40, 0x00, 0x00, 0x5D, 0xAC, 0x10, 0x00, 0xC3, 0x08, 0x50, 0x00, 0xA6, 0x1C, 0x30, 0x12, 0x1A, 0xD6, 0x3A, 0xA3, 0x01, 0x7B, 0x84, 0x00, 0x4A, 0x50, 0xBB, 0xD3, 0x00, 0x05, 0x90, 0x4B, 0x00, 0x04, 0xA0, 0x5A, 0x00, 0x00, 0x9D, 0xD3, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },	// '%'
+		{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x7D, 0xD7, 0x00, 0x05, 0xD3, 0x34, 0x00, 0x07, 0xB0, 0x00, 0x00, 0x03, 0xF2, 0x00, 0x00, 0x06, 0xEC, 0x00, 0x00, 0x3E, 0x2C, 0x90, 0x5D, 0x98, 0x02, 0xE5, 0x5A, 0x99, 0x00, 0x5E, 0xB6, 0x5E, 0x30, 0x0B, 0xE1, 0x08, 0xFD, 0xEA, 0xC8, 0x00, 0x13, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },	// '&'
+		{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x05, 0x50, 0x00, 0x00, 0x08, 0x80, 0x00, 0x00, 0x08, 0x80, 0x00, 0x00, 0x06, 0x60, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },	// '''
+		{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xA6, 0x00, 0x00, 0x03, 0xE0, 0x00, 0x00, 0x09, 0x90, 0x00, 0x00, 0x0E, 0x40, 0x00, 0x00, 0x2F, 0x20, 0x00, 0x00, 0x3F, 0x00, 0x00, 0x00, 0x3F, 0x00, 0x00, 0x00, 0x1F, 0x30, 0x00, 0x00, 0x0D, 0x60, 0x00, 0x00, 0x07, 0xA0, 0x00, 0x00, 0x01, 0xE2, 0x00, 0x00, 0x00, 0x67, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },	// '('
+		{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x6A, 0x00, 0x00, 0x00, 0x0E, 0x30, 0x00, 0x00, 0x09, 0x90, 0x00, 0x00, 0x04, 0xE0, 0x00, 0x00, 0x02, 0xF2, 0x00, 0x00, 0x00, 0xF3, 0x00, 0x00, 0x00, 0xF3, 0x00, 0x00, 0x03, 0xF1, 0x00, 0x00, 0x06, 0xD0, 0x00, 0x00, 0x0A, 0x70, 0x00, 0x00, 0x2E, 0x10, 0x00, 0x00, 0x76, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },	// ')'
+		{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x04, 0x40, 0x00, 0x07, 0x25, 0x52, 0x70, 0x03, 0xAB, 0xBA, 0x30, 0x00, 0x5D, 0xD5, 0x00, 0x09, 0x75, 0x57, 0x90, 0x00, 0x05, 0x50, 0x00, 0x00, 0x01, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },	// '*'
+		{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x05, 0x50, 0x00, 0x00, 0x08, 0x80, 0x00, 0x00, 0x08, 0x80, 0x00, 0x5A, 0xAD, 0xDA, 0xA5, 0x35, 0x5A, 0xA5, 0x53, 0x00, 0x08, 0x80, 0x00, 0x00, 0x08, 0x80, 0x00, 0x00, 0x03, 0x30, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },	// '+'
+		{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0A, 0xD0, 0x00, 0x00, 0x0C, 0xC0, 0x00, 0x00, 0x1F, 0x50, 0x00, 0x00, 0x3B, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },	// ','
+		{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x23, 0x32, 0x00, 0x00, 0x8D, 0xD8, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },	// '-'
+		{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0D, 0xD0, 0x00, 0x00, 0x0D, 0xD0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },	// '.'
+		{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x04, 0x80, 0x00, 0x00, 0x0C, 0x70, 0x00, 0x00, 0x4E, 0x10, 0x00, 0x00, 0xB8, 0x00, 0x00, 0x03, 0xF1, 0x00, 0x00, 0x0A, 0x90, 0x00, 0x00, 0x2F, 0x20, 0x00, 0x00, 0x9A, 0x00, 0x00, 0x02, 0xF3, 0x00, 0x00, 0x08, 0xA0, 0x00, 0x00, 0x1E, 0x40, 0x00, 0x00, 0x13, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },	// '/'
+		{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x7C, 0xC7, 0x00, 0x06, 0xE4, 0x4E, 0x60, 0x0C, 0x80, 0x08, 0xC0, 0x0F, 0x40, 0x04, 0xF0, 0x3F, 0x37, 0x73, 0xF3, 0x3F, 0x3B, 0xA3, 0xF3, 0x1F, 0x40, 0x04, 0xF1, 0x0E, 0x60, 0x06, 0xE0, 0x08, 0xD0, 0x0D, 0x80, 0x01, 0xCE, 0xEC, 0x10, 0x00, 0x02, 0x20, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },	// '0'
+		{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x69, 0xA2, 0x00, 0x05, 0xCA, 0xF3, 0x00, 0x00, 0x03, 0xF3, 0x00, 0x00, 0x03, 0xF3, 0x00, 0x00, 0x03, 0xF3, 0x00, 0x00, 0x03, 0xF3, 0x00, 0x00, 0x03, 0xF3, 0x00, 0x00, 0x03, 0xF3, 0x00, 0x00, 0x35, 0xF5, 0x30, 0x03, 0xFF, 0xFF, 0xF3, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },	// '1'
+		{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x06, 0xBD, 0xC6, 0x00, 0x0D, 0x74, 0x7F, 0x60, 0x00, 0x00, 0x09, 0xC0, 0x00, 0x00, 0x09, 0xB0, 0x00, 0x00, 0x2E, 0x50, 0x00, 0x00, 0xD8, 0x00, 0x00, 0x0B, 0xA0, 0x00, 0x00, 0xBB, 0x00, 0x00, 0x09, 0xD3, 0x33, 0x20, 0x0F, 0xFF, 0xFF, 0xD0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },	// '2'
+		{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x07, 0xBD, 0xC6, 0x00, 0x08, 0x64, 0x6E, 0x70, 0x00, 0x00, 0x08, 0xC0, 0x00, 0x00, 0x0B, 0x90, 0x00, 0x5A, 0xDB, 0x10, 0x00, 0x35, 0x8E, 0x40, 0x00, 0x00, 0x07, 0xD0, 0x00, 0x00, 0x05, 0xF0, 0x15, 0x00, 0x2B, 0xB0, 0x2E, 0xFF, 0xFC, 0x30, 0x00, 0x23, 0x20, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },	// '3'
+		{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x7A, 0x00, 0x00, 0x03, 0xDF, 0x00, 0x00, 0x0C, 0x5F, 0x00, 0x00, 0x79, 0x3F, 0x00, 0x02, 0xD1, 0x3F, 0x00, 0x0B, 0x60, 0x3F, 0x00, 0x4E, 0x55, 0x7F, 0x52, 0x3A, 0xAA, 0xBF, 0xA3, 0x00, 0x00, 0x3F, 0x00, 0x00, 0x00, 0x3F, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },	// '4'
+		{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x07, 0xAA, 0xAA, 0x20, 0x0A, 0xA5, 0x55, 0x10, 0x0A, 0x80, 0x00, 0x00, 0x0A, 0xA5, 0x50, 0x00, 0x0A, 0xCA, 0xED, 0x20, 0x00, 0x00, 0x0C, 0xA0, 0x00, 0x00, 0x06, 0xE0, 0x00, 0x00, 0x07, 0xD0, 0x05, 0x00, 0x3D, 0x90, 0x0E, 0xFF, 0xFA, 0x00, 0x00, 0x33, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },	// '5'
+		{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x4B, 0xDB, 0x40, 0x03, 0xF8, 0x46, 0x50, 0x0B, 0x80, 0x00, 0x00, 0x0F, 0x34, 0x53, 0x00, 0x3F, 0xBB, 0xAF, 0x60, 0x3F, 0xA0, 0x07, 0xE0, 0x1F, 0x50, 0x03, 0xF2, 0x0E, 0x50, 0x03, 0xF2, 0x09, 0xB0, 0x09, 0xD0, 0x01, 0xCE, 0xDD, 0x30, 0x00, 0x02, 0x30, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },	// '6'
+		{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x2A, 0xAA, 0xAA, 0xA0, 0x15, 0x55, 0x5B, 0xC0, 0x00, 0x00, 0x0D, 0x50, 0x00, 0x00, 0x4E, 0x10, 0x00, 0x00, 0xAA, 0x00, 0x00, 0x01, 0xF4, 0x00, 0x00, 0x07, 0xD0, 0x00, 0x00, 0x0D, 0x70, 0x00, 0x00, 0x3F, 0x20, 0x00, 0x00, 0xAB, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },	// '7'
+		{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x8D, 0xD8, 0x00, 0x0A, 0xD3, 0x3D, 0xA0, 0x0D, 0x60, 0x06, 0xD0, 0x0B, 0x80, 0x08, 0xB0, 0x02, 0xCB, 0xBC, 0x20, 0x06, 0xD7, 0x7D, 0x60, 0x1F, 0x50, 0x05, 0xF1, 0x3F, 0x30, 0x03, 0xF3, 0x0E, 0x80, 0x08, 0xE0, 0x04, 0xDD, 0xDD, 0x40, 0x00, 0x03, 0x30, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },	// '8'
+		{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x9D, 0xC6, 0x00, 0x0B, 0xB3, 0x4E, 0x60, 0x1F, 0x30, 0x07, 0xC0, 0x3F, 0x30, 0x05, 0xF0, 0x1F, 0x40, 0x08, 0xF1, 0x0A, 0xD5, 0x7D, 0xF2, 0x00, 0x8A, 0x94, 0xF0, 0x00, 0x00, 0x07, 0xC0, 0x02, 0x10, 0x3E, 0x60, 0x07, 0xFF, 0xF8, 0x00, 0x00, 0x13, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },	// '9'
+		{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0A, 0xA0, 0x00, 0x00, 0x0D, 0xD0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0D, 0xD0, 0x00, 0x00, 0x0D, 0xD0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },	// ':'
+		{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0A, 0xA0, 0x00, 0x00, 0x0D, 0xD0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0A, 0xD0, 0x00, 0x00, 0x0C, 0xC0, 0x00, 0x00, 0x1F, 0x50, 0x00, 0x00, 0x3B, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },	// ';'
+		{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x13, 0x00, 0x00, 0x4A, 0xF6, 0x01, 0x7D, 0xD8, 0x20, 0x6F, 0xA4, 0x00, 0x00, 0x3B, 0xE8, 0x30, 0x00, 0x00, 0x28, 0xEC, 0x71, 0x00, 0x00, 0x05, 0xB8, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },	// '<'
+		{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x8F, 0xFF, 0xFF, 0xF8, 0x00, 0x00, 0x00, 0x00, 0x35, 0x55, 0x55, 0x53, 0x5A, 0xAA, 0xAA, 0xA5, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },	// '='
+		{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x31, 0x00, 0x00, 0x00, 0x6F, 0xA4, 0x00, 0x00, 0x02, 0x8D, 0xD7, 0x10, 0x00, 0x00, 0x4A, 0xF6, 0x00, 0x03, 0x8E, 0xB3, 0x17, 0xCE, 0x82, 0x00, 0x8B, 0x50, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },	// '>'
+		{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x8C, 0xD8, 0x00, 0x07, 0x93, 0x5E, 0x80, 0x00, 0x00, 0x09, 0xA0, 0x00, 0x00, 0x3E, 0x60, 0x00, 0x02, 0xE9, 0x00, 0x00, 0x0A, 0xA0, 0x00, 0x00, 0x0D, 0x80, 0x00, 0x00, 0x04, 0x30, 0x00, 0x00, 0x08, 0x50, 0x00, 0x00, 0x0D, 0x80, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },	// '?'
+		{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x7E, 0xDE, 0x70, 0x0A, 0xA1, 0x01, 0xD4, 0x4D, 0x00, 0x44, 0x69, 0x96, 0x0A, 0xCA, 0xDA, 0xC3, 0x3D, 0x00, 0x7A, 0xD3, 0x5A, 0x00, 0x5A, 0xC3, 0x3D, 0x00, 0x8A, 0x97, 0x09, 0xDB, 0xDA, 0x3D, 0x10, 0x23, 0x12, 0x08, 0xC3, 0x00, 0x00, 0x00, 0x5C, 0xDD, 0x90, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },	// '@'
+		{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x09, 0x90, 0x00, 0x00, 0x2F, 0xF2, 0x00, 0x00, 0x7B, 0xB7, 0x00, 0x00, 0xB6, 0x6B, 0x00, 0x01, 0xF2, 0x3F, 0x10, 0x06, 0xD0, 0x0D, 0x60, 0x0A, 0xD8, 0x8D, 0xA0, 0x0F, 0x98, 0x89, 0xF0, 0x5F, 0x00, 0x01, 0xF5, 0x9B, 0x00, 0x00, 0xB9, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },	// 'A'
+		{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0A, 0xAA, 0xA6, 0x00, 0x0F, 0x85, 0x7D, 0xA0, 0x0F, 0x50, 0x05, 0xF0, 0x0F, 0x50, 0x07, 0xE0, 0x0F, 0xCA, 0xBD, 0x40, 0x0F, 0x85, 0x6C, 0xA0, 0x0F, 0x50, 0x01, 0xF4, 0x0F, 0x50, 0x00, 0xF5, 0x0F, 0x50, 0x28, 0xF3, 0x0F, 0xFF, 0xFC, 0x50, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },	// 'B'
+		{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x2A, 0xDC, 0x80, 0x02, 0xEA, 0x34, 0xA0, 0x0A, 0xB0, 0x00, 0x00, 0x0E, 0x60, 0x00, 0x00, 0x1F, 0x50, 0x00, 0x00, 0x2F, 0x50, 0x00, 0x00, 0x0F, 0x50, 0x00, 0x00, 0x0B, 0x90, 0x00, 0x00, 0x05, 0xF5, 0x00, 0x50, 0x00, 0x6E, 0xDE, 0xD0, 0x00, 0x00, 0x32, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },	// 'C'
+		{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x2A, 0xAA, 0x72, 0x00, 0x3F, 0x77, 0xBE, 0x30, 0x3F, 0x30, 0x0A, 0xB0, 0x3F, 0x30, 0x05, 0xF0, 0x3F, 0x30, 0x03, 0xF3, 0x3F, 0x30, 0x03, 0xF3, 0x3F, 0x30, 0x05, 0xF1, 0x3F, 0x30, 0x08, 0xD0, 0x3F, 0x33, 0x6F, 0x50, 0x3F, 0xFF, 0xC5, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },	// 'D'
+		{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x07, 0xAA, 0xAA, 0xA0, 0x0A, 0xC5, 0x55, 0x50, 0x0A, 0xA0, 0x00, 0x00, 0x0A, 0xA0, 0x00, 0x00, 0x0A, 0xDA, 0xAA, 0x80, 0x0A, 0xC5, 0x55, 0x40, 0x0A, 0xA0, 0x00, 0x00, 0x0A, 0xA0, 0x00, 0x00, 0x0A, 0xB3, 0x33, 0x30, 0x0A, 0xFF, 0xFF, 0xF3, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },	// 'E'
+		{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x05, 0xAA, 0xAA, 0xA2, 0x08, 0xD5, 0x55, 0x51, 0x08, 0xD0, 0x00, 0x00, 0x08, 0xD0, 0x00, 0x00, 0x08, 0xEA, 0xAA, 0x80, 0x08, 0xD5, 0x55, 0x40, 0x08, 0xD0, 0x00, 0x00, 0x08, 0xD0, 0x00, 0x00, 0x08, 0xD0, 0x00, 0x00, 0x08, 0xD0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },	// 'F'
+		{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x4B, 0xDB, 0x50, 0x05, 0xF7, 0x35, 0xA0, 0x0D, 0x80, 0x00, 0x00, 0x3F, 0x30, 0x00, 0x00, 0x5F, 0x00, 0x00, 0x00, 0x5F, 0x00, 0x8F, 0xF3, 0x4F, 0x20, 0x15, 0xF3, 0x1F, 0x50, 0x03, 0xF3, 0x08, 0xD2, 0x03, 0xF3, 0x00, 0x9F, 0xDF, 0xA1, 0x00, 0x01, 0x31, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },	// 'G'
+		{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x2A, 0x20, 0x02, 0xA2, 0x3F, 0x30, 0x03, 0xF3, 0x3F, 0x30, 0x03, 0xF3, 0x3F, 0x30, 0x03, 0xF3, 0x3F, 0xBA, 0xAB, 0xF3, 0x3F, 0x75, 0x57, 0xF3, 0x3F, 0x30, 0x03, 0xF3, 0x3F, 0x30, 0x03, 0xF3, 0x3F, 0x30, 0x03, 0xF3, 0x3F, 0x30, 0x03, 0xF3, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },	// 'H'
+		{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x07, 0xAA, 0xAA, 0x70, 0x03, 0x5C, 0xC5, 0x30, 0x00, 0x0A, 0xA0, 0x00, 0x00, 0x0A, 0xA0, 0x00, 0x00, 0x0A, 0xA0, 0x00, 0x00, 0x0A, 0xA0, 0x00, 0x00, 0x0A, 0xA0, 0x00, 0x00, 0x0A, 0xA0, 0x00, 0x02, 0x3B, 0xB3, 0x20, 0x0A, 0xFF, 0xFF, 0xA0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },	// 'I'
+		{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x5A, 0xAA, 0x20, 0x00, 0x35, 0x7F, 0x30, 0x00, 0x00, 0x3F, 0x30, 0x00, 0x00, 0x3F, 0x30, 0x00, 0x00, 0x3F, 0x30, 0x00, 0x00, 0x3F, 0x30, 0x00, 0x00, 0x3F, 0x30, 0x00, 0x00, 0x3F, 0x30, 0x45, 0x00, 0x7F, 0x00, 0x3E, 0xED, 0xF6, 0x00, 0x00, 0x23, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },	// 'J'
+		{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x2A, 0x20, 0x01, 0xA5, 0x3F, 0x30, 0x0C, 0xB0, 0x3F, 0x30, 0xBB, 0x00, 0x3F, 0x3B, 0xB0, 0x00, 0x3F, 0xDF, 0x40, 0x00, 0x3F, 0xD9, 0xD0, 0x00, 0x3F, 0x30, 0xD8, 0x00, 0x3F, 0x30, 0x4F, 0x40, 0x3F, 0x30, 0x09, 0xD1, 0x3F, 0x30, 0x01, 0xD9, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },	// 'K'
+		{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x07, 0x70, 0x00, 0x00, 0x0A, 0xA0, 0x00, 0x00, 0x0A, 0xA0, 0x00, 0x00, 0x0A, 0xA0, 0x00, 0x00, 0x0A, 0xA0, 0x00, 0x00, 0x0A, 0xA0, 0x00, 0x00, 0x0A, 0xA0, 0x00, 0x00, 0x0A, 0xA0, 0x00, 0x00, 0x0A, 0xB3, 0x33, 0x31, 0x0A, 0xFF, 0xFF, 0xF5, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },	// 'L'
+		{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x5A, 0x40, 0x05, 0xA5, 0x8F, 0xA0, 0x0B, 0xF8, 0x8D, 0xD1, 0x1D, 0xD8, 0x8D, 0x86, 0x68, 0xD8, 0x8D, 0x3B, 0xB3, 0xD8, 0x8D, 0x0D, 0xD0, 0xD8, 0x8D, 0x05, 0x50, 0xD8, 0x8D, 0x00, 0x00, 0xD8, 0x8D, 0x00, 0x00, 0xD8, 0x8D, 0x00, 0x00, 0xD8, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },	// 'M'
+		{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x2A, 0x70, 0x02, 0xA2, 0x3F, 0xF1, 0x03, 0xF3, 0x3F, 0xC7, 0x03, 0xF3, 0x3F, 0x6D, 0x03, 0xF3, 0x3F, 0x3D, 0x43, 0xF3, 0x3F, 0x36, 0xA3, 0xF3, 0x3F, 0x31, 0xE4, 0xF3, 0x3F, 0x30, 0x9A, 0xF3, 0x3F, 0x30, 0x3F, 0xF3, 0x3F, 0x30, 0x0C, 0xF3, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },	// 'N'
+		{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x7C, 0xC7, 0x00, 0x07, 0xE4, 0x5E, 0x70, 0x0E, 0x70, 0x07, 0xE0, 0x2F, 0x30, 0x03, 0xF2, 0x3F, 0x30, 0x03, 0xF3, 0x3F, 0x30, 0x03, 0xF3, 0x3F, 0x30, 0x03, 0xF3, 0x0F, 0x50, 0x05, 0xF0, 0x0A, 0xC0, 0x0C, 0xA0, 0x01, 0xCE, 0xEC, 0x10, 0x00, 0x02, 0x20, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },	// 'O'
+		{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x07, 0xAA, 0xA8, 0x10, 0x0A, 0xC5, 0x6D, 0xD1, 0x0A, 0xA0, 0x02, 0xF5, 0x0A, 0xA0, 0x00, 0xF5, 0x0A, 0xA0, 0x07, 0xF3, 0x0A, 0xFF, 0xFE, 0x60, 0x0A, 0xB3, 0x20, 0x00, 0x0A, 0xA0, 0x00, 0x00, 0x0A, 0xA0, 0x00, 0x00, 0x0A, 0xA0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },	// 'P'
+		{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x7C, 0xC7, 0x00, 0x07, 0xE4, 0x5E, 0x70, 0x0E, 0x70, 0x07, 0xE0, 0x2F, 0x30, 0x03, 0xF2, 0x3F, 0x30, 0x03, 0xF3, 0x3F, 0x30, 0x03, 0xF3, 0x3F, 0x30, 0x03, 0xF3, 0x0F, 0x50, 0x05, 0xF0, 0x0A, 0xC0, 0x0C, 0xA0, 0x01, 0xCE, 0xED, 0x10, 0x00, 0x02, 0x7E, 0x30, 0x00, 0x00, 0x06, 0x40, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },	// 'Q'
+		{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0A, 0xAA, 0x95, 0x00, 0x0F, 0x75, 0x8F, 0x70, 0x0F, 0x30, 0x08, 0xD0, 0x0F, 0x30, 0x08, 0xD0, 0x0F, 0x53, 0x5E, 0x80, 0x0F, 0xDD, 0xF9, 0x00, 0x0F, 0x30, 0x3F, 0x30, 0x0F, 0x30, 0x09, 0xB0, 0x0F, 0x30, 0x02, 0xF4, 0x0F, 0x30, 0x00, 0xAB, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },	// 'R'
+		{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x8D, 0xDA, 0x30, 0x0A, 0xC4, 0x37, 0x60, 0x1F, 0x30, 0x00, 0x00, 0x1F, 0x50, 0x00, 0x00, 0x08, 0xFB, 0x83, 0x00, 0x00, 0x49, 0xDF, 0x70, 0x00, 0x00, 0x07, 0xF0, 0x00, 0x00, 0x03, 0xF2, 0x08, 0x10, 0x08, 0xD0, 0x0C, 0xFD, 0xED, 0x40, 0x00, 0x13, 0x20, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },	// 'S'
+		{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x7A, 0xAA, 0xAA, 0xA7, 0x35, 0x5C, 0xC5, 0x53, 0x00, 0x0A, 0xA0, 0x00, 0x00, 0x0A, 0xA0, 0x00, 0x00, 0x0A, 0xA0, 0x00, 0x00, 0x0A, 0xA0, 0x00, 0x00, 0x0A, 0xA0, 0x00, 0x00, 0x0A, 0xA0, 0x00, 0x00, 0x0A, 0xA0, 0x00, 0x00, 0x0A, 0xA0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },	// 'T'
+		{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0A, 0x30, 0x03, 0xA0, 0x0F, 0x50, 0x05, 0xF0, 0x0F, 0x50, 0x05, 0xF0, 0x0F, 0x50, 0x05, 0xF0, 0x0F, 0x50, 0x05, 0xF0, 0x0F, 0x50, 0x05, 0xF0, 0x0F, 0x50, 0x05, 0xF0, 0x0F, 0x50, 0x05, 0xF0, 0x0C, 0x90, 0x09, 0xC0, 0x03, 0xDE, 0xED, 0x30, 0x00, 0x03, 0x30, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },	// 'U'
+		{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x58, 0x00, 0x00, 0x85, 0x4F, 0x10, 0x01, 0xF4, 0x0F, 0x40, 0x04, 0xF0, 0x0A, 0x90, 0x09, 0xA0, 0x06, 0xD0, 0x0D, 0x60, 0x02, 0xF1, 0x1F, 0x20, 0x00, 0xC6, 0x6C, 0x00, 0x00, 0x89, 0x98, 0x00, 0x00, 0x4D, 0xE4, 0x00, 0x00, 0x0E, 0xE0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },	// 'V'
+		{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xA3, 0x00, 0x00, 0x3A, 0xD6, 0x00, 0x00, 0x6D, 0xA8, 0x00, 0x00, 0x8A, 0x8A, 0x0C, 0xC0, 0xA8, 0x5C, 0x0E, 0xE0, 0xC5, 0x3D, 0x3B, 0xB3, 0xD3, 0x1F, 0x77, 0x76, 0xF1, 0x0E, 0xC4, 0x4C, 0xE0, 0x0C, 0xF1, 0x1F, 0xC0, 0x0A, 0xC0, 0x0C, 0xA0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },	// 'W'
+		{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x2A, 0x20, 0x00, 0x95, 0x0B, 0xA0, 0x07, 0xD0, 0x02, 0xF4, 0x2E, 0x40, 0x00, 0x7C, 0x9A, 0x00, 0x00, 0x0D, 0xE1, 0x00, 0x00, 0x2E, 0xE3, 0x00, 0x00, 0xAA, 0x8B, 0x00, 0x05, 0xE2, 0x1D, 0x50, 0x1D, 0x70, 0x06, 0xE1, 0x8C, 0x00, 0x00, 0xC9, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },	// 'X'
+		{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x58, 0x00, 0x00, 0x85, 0x2F, 0x40, 0x05, 0xF2, 0x08, 0xD0, 0x0D, 0x70, 0x00, 0xD6, 0x6D, 0x00, 0x00, 0x5D, 0xD5, 0x00, 0x00, 0x0C, 0xC0, 0x00, 0x00, 0x0A, 0xA0, 0x00, 0x00, 0x0A, 0xA0, 0x00, 0x00, 0x0A, 0xA0, 0x00, 0x00, 0x0A, 0xA0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },	// 'Y'
+		{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x08, 0xAA, 0xAA, 0xA5, 0x04, 0x55, 0x57, 0xF5, 0x00, 0x00, 0x0C, 0xA0, 0x00, 0x00, 0x6E, 0x10, 0x00, 0x02, 0xE5, 0x00, 0x00, 0x0B, 0xA0, 0x00, 0x00, 0x6E, 0x10, 0x00, 0x01, 0xE5, 0x00, 0x00, 0x0A, 0xC3, 0x33, 0x32, 0x0F, 0xFF, 0xFF, 0xFA, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },	// 'Z'
+		{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x03, 0x32, 0x00, 0x00, 0x0F, 0xDA, 0x00, 0x00, 0x0F, 0x30, 0x00, 0x00, 0x0F, 0x30, 0x00, 0x00, 0x0F, 0x30, 0x00, 0x00, 0x0F, 0x30, 0x00, 0x00, 0x0F, 0x30, 0x00, 0x00, 0x0F, 0x30, 0x00, 0x00, 0x0F, 0x30, 0x00, 0x00, 0x0F, 0x30, 0x00, 0x00, 0x0F, 0x30, 0x00, 0x00, 0x0F, 0x52, 0x00, 0x00, 0x0D, 0xDA, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },	// '['
+		{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x2A, 0x10, 0x00, 0x00, 0x0C, 0x70, 0x00, 0x00, 0x05, 0xD0, 0x00, 0x00, 0x00, 0xD6, 0x00, 0x00, 0x00, 0x6D, 0x00, 0x00, 0x00, 0x0D, 0x50, 0x00, 0x00, 0x07, 0xC0, 0x00, 0x00, 0x01, 0xE4, 0x00, 0x00, 0x00, 0x8B, 0x00, 0x00, 0x00, 0x1F, 0x30, 0x00, 0x00, 0x09, 0xA0, 0x00, 0x00, 0x01, 0x30, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },	// backslash
+		{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x23, 0x30, 0x00, 0x00, 0xAD, 0xF0, 0x00, 0x00, 0x03, 0xF0, 0x00, 0x00, 0x03, 0xF0, 0x00, 0x00, 0x03, 0xF0, 0x00, 0x00, 0x03, 0xF0, 0x00, 0x00, 0x03, 0xF0, 0x00, 0x00, 0x03, 0xF0, 0x00, 0x00, 0x03, 0xF0, 0x00, 0x00, 0x03, 0xF0, 0x00, 0x00, 0x03, 0xF0, 0x00, 0x00, 0x25, 0xF0, 0x00, 0x00, 0xAD, 0xD0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },	// ']'
+		{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x09, 0x90, 0x00, 0x00, 0x8D, 0xD8, 0x00, 0x05, 0xD1, 0x1D, 0x50, 0x3D, 0x20, 0x02, 0xD3, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },	// '^'
+		{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x55, 0x55, 0x55, 0x55, 0x33, 0x33, 0x33, 0x33 },	// '_'
+		{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x93, 0x00, 0x00, 0x00, 0x4D, 0x10, 0x00, 0x00, 0x05, 0x80, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },	// '`'
+		{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x47, 0x62, 0x00, 0x0A, 0xC9, 0xAE, 0x40, 0x01, 0x00, 0x07, 0xC0, 0x00, 0x58, 0xAC, 0xD0, 0x0A, 0xC6, 0x58, 0xD0, 0x2F, 0x10, 0x06, 0xD0, 0x1F, 0x40, 0x1D, 0xD0, 0x07, 0xFD, 0xD9, 0xD0, 0x00, 0x13, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },	// 'a'
+		{ 0x00, 0x00, 0x00, 0x00, 0x02, 0x10, 0x00, 0x00, 0x0A, 0x80, 0x00, 0x00, 0x0A, 0x80, 0x00, 0x00, 0x0A, 0x83, 0x73, 0x00, 0x0A, 0xDC, 0x9F, 0x60, 0x0A, 0xC0, 0x06, 0xE0, 0x0A, 0x80, 0x02, 0xF3, 0x0A, 0x80, 0x00, 0xF3, 0x0A, 0x80, 0x02, 0xF2, 0x0A, 0xD1, 0x08, 0xD0, 0x0A, 0xBD, 0xDE, 0x30, 0x00, 0x01, 0x30, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },	// 'b'
+		{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x03, 0x76, 0x10, 0x00, 0xAD, 0x9A, 0xC0, 0x06, 0xE1, 0x00, 0x10, 0x0A, 0x90, 0x00, 0x00, 0x0A, 0x80, 0x00, 0x00, 0x09, 0xA0, 0x00, 0x00, 0x04, 0xF4, 0x00, 0x30, 0x00, 0x6E, 0xDD, 0xB0, 0x00, 0x00, 0x32, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },	// 'c'
+		{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x20, 0x00, 0x00, 0x08, 0xD0, 0x00, 0x00, 0x08, 0xD0, 0x00, 0x37, 0x48, 0xD0, 0x05, 0xF9, 0xCE, 0xD0, 0x0E, 0x60, 0x0C, 0xD0, 0x3F, 0x20, 0x08, 0xD0, 0x3F, 0x00, 0x08, 0xD0, 0x2F, 0x30, 0x08, 0xD0, 0x0D, 0x80, 0x1D, 0xD0, 0x03, 0xDD, 0xEB, 0xD0, 0x00, 0x03, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },	// 'd'
+		{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x15, 0x73, 0x00, 0x03, 0xEB, 0x9E, 0x60, 0x0D, 0x80, 0x04, 0xE0, 0x2F, 0x75, 0x55, 0xF3, 0x3F, 0xAA, 0xAA, 0xA2, 0x1F, 0x20, 0x00, 0x00, 0x0A, 0xA0, 0x00, 0x50, 0x01, 0xBE, 0xDE, 0xC0, 0x00, 0x02, 0x31, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },	// 'e'
+		{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x20, 0x00, 0x04, 0xED, 0xA0, 0x00, 0x0B, 0x80, 0x00, 0x03, 0x5D, 0x85, 0x40, 0x07, 0xAE, 0xCA, 0x80, 0x00, 0x0D, 0x50, 0x00, 0x00, 0x0D, 0x50, 0x00, 0x00, 0x0D, 0x50, 0x00, 0x00, 0x0D, 0x50, 0x00, 0x00, 0x0D, 0x50, 0x00, 0x00, 0x0D, 0x50, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },	// 'f'
+		{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x37, 0x41, 0x20, 0x05, 0xF9, 0xBD, 0xD0, 0x0E, 0x60, 0x0C, 0xD0, 0x3F, 0x20, 0x08, 0xD0, 0x3F, 0x00, 0x08, 0xD0, 0x1F, 0x30, 0x08, 0xD0, 0x0B, 0xA0, 0x2D, 0xD0, 0x02, 0xCF, 0xDA, 0xC0, 0x00, 0x00, 0x08, 0xA0, 0x03, 0x53, 0x4D, 0x50, 0x03, 0xBD, 0xC5, 0x00, 0x00, 0x00, 0x00, 0x00 },	// 'g'
+		{ 0x00, 0x00, 0x00, 0x00, 0x02, 0x10, 0x00, 0x00, 0x0A, 0x80, 0x00, 0x00, 0x0A, 0x80, 0x00, 0x00, 0x0A, 0x83, 0x74, 0x00, 0x0A, 0xCC, 0xAF, 0x60, 0x0A, 0xB0, 0x08, 0xB0, 0x0A, 0x80, 0x05, 0xD0, 0x0A, 0x80, 0x05, 0xD0, 0x0A, 0x80, 0x05, 0xD0, 0x0A, 0x80, 0x05, 0xD0, 0x0A, 0x80, 0x05, 0xD0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },	// 'h'
+		{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x20, 0x00, 0x00, 0x08, 0xA0, 0x00, 0x00, 0x03, 0x30, 0x00, 0x02, 0x55, 0x30, 0x00, 0x03, 0xAD, 0xA0, 0x00, 0x00, 0x08, 0xA0, 0x00, 0x00, 0x08, 0xA0, 0x00, 0x00, 0x08, 0xA0, 0x00, 0x00, 0x08, 0xA0, 0x00, 0x00, 0x08, 0xA0, 0x00, 0x0D, 0xFF, 0xFF, 0xF3, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },	// 'i'
+		{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x30, 0x00, 0x00, 0x03, 0xF3, 0x00, 0x00, 0x01, 0x51, 0x00, 0x01, 0x55, 0x51, 0x00, 0x02, 0xAB, 0xF3, 0x00, 0x00, 0x03, 0xF3, 0x00, 0x00, 0x03, 0xF3, 0x00, 0x00, 0x03, 0xF3, 0x00, 0x00, 0x03, 0xF3, 0x00, 0x00, 0x03, 0xF3, 0x00, 0x00, 0x03, 0xF3, 0x00, 0x00, 0x03, 0xF0, 0x00, 0x02, 0x3A, 0xD0, 0x00, 0x0A, 0xDA, 0x30, 0x00, 0x00, 0x00, 0x00, 0x00 },	// 'j'
+		{ 0x00, 0x00, 0x00, 0x00, 0x01, 0x20, 0x00, 0x00, 0x08, 0xD0, 0x00, 0x00, 0x08, 0xD0, 0x00, 0x00, 0x08, 0xD0, 0x01, 0x51, 0x08, 0xD0, 0x1D, 0x90, 0x08, 0xD1, 0xD8, 0x00, 0x08, 0xDD, 0xA0, 0x00, 0x08, 0xF8, 0xF4, 0x00, 0x08, 0xD0, 0x7D, 0x10, 0x08, 0xD0, 0x0B, 0xA0, 0x08, 0xD0, 0x01, 0xE7, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },	// 'k'
+		{ 0x00, 0x00, 0x00, 0x00, 0x03, 0x33, 0x00, 0x00, 0x0D, 0xDF, 0x30, 0x00, 0x00, 0x0F, 0x30, 0x00, 0x00, 0x0F, 0x30, 0x00, 0x00, 0x0F, 0x30, 0x00, 0x00, 0x0F, 0x30, 0x00, 0x00, 0x0F, 0x30, 0x00, 0x00, 0x0F, 0x30, 0x00, 0x00, 0x0F, 0x30, 0x00, 0x00, 0x0D, 0x70, 0x00, 0x00, 0x04, 0xDF, 0xA0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },	// 'l'
+		{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x24, 0x45, 0x06, 0x30, 0x5F, 0x9E, 0xD9, 0xE2, 0x5D, 0x08, 0xA0, 0xC5, 0x5D, 0x08, 0x80, 0xA5, 0x5D, 0x08, 0x80, 0xA5, 0x5D, 0x08, 0x80, 0xA5, 0x5D, 0x08, 0x80, 0xA5, 0x5D, 0x08, 0x80, 0xA5, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },	// 'm'
+		{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x03, 0x33, 0x74, 0x00, 0x0A, 0xCC, 0xAF, 0x60, 0x0A, 0xB0, 0x08, 0xB0, 0x0A, 0x80, 0x05, 0xD0, 0x0A, 0x80, 0x05, 0xD0, 0x0A, 0x80, 0x05, 0xD0, 0x0A, 0x80, 0x05, 0xD0, 0x0A, 0x80, 0x05, 0xD0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },	// 'n'
+		{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x26, 0x62, 0x00, 0x04, 0xFA, 0xAF, 0x40, 0x0C, 0x80, 0x08, 0xC0, 0x1F, 0x30, 0x03, 0xF0, 0x3F, 0x30, 0x03, 0xF3, 0x0F, 0x40, 0x04, 0xF0, 0x0B, 0xA0, 0x0A, 0xB0, 0x02, 0xDD, 0xDD, 0x20, 0x00, 0x02, 0x20, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },	// 'o'
+		{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x04, 0x34, 0x73, 0x00, 0x0D, 0xDC, 0x9F, 0x50, 0x0D, 0xC0, 0x06, 0xD0, 0x0D, 0x80, 0x02, 0xF2, 0x0D, 0x80, 0x00, 0xF3, 0x0D, 0x80, 0x03, 0xF2, 0x0D, 0xD1, 0x08, 0xC0, 0x0D, 0xBE, 0xDD, 0x30, 0x0D, 0x81, 0x30, 0x00, 0x0D, 0x80, 0x00, 0x00, 0x0A, 0x60, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },	// 'p'
+		{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x35, 0x41, 0x20, 0x04, 0xFA, 0xBC, 0xD0, 0x0C, 0x80, 0x0B, 0xD0, 0x0F, 0x30, 0x06, 0xD0, 0x3F, 0x30, 0x05, 0xD0, 0x0F, 0x40, 0x07, 0xD0, 0x0B, 0xA0, 0x0D, 0xD0, 0x03, 0xDD, 0xDA, 0xD0, 0x00, 0x03, 0x15, 0xD0, 0x00, 0x00, 0x05, 0xD0, 0x00, 0x00, 0x04, 0xA0, 0x00, 0x00, 0x00, 0x00 },	// 'q'
+		{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x33, 0x26, 0x61, 0x00, 0xAA, 0xDA, 0xB8, 0x00, 0xAE, 0x20, 0x00, 0x00, 0xAA, 0x00, 0x00, 0x00, 0xA8, 0x00, 0x00, 0x00, 0xA8, 0x00, 0x00, 0x00, 0xA8, 0x00, 0x00, 0x00, 0xA8, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },	// 'r'
+		{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x26, 0x74, 0x00, 0x03, 0xEA, 0x8C, 0x50, 0x09, 0xA0, 0x00, 0x00, 0x06, 0xE6, 0x30, 0x00, 0x00, 0x6B, 0xED, 0x30, 0x00, 0x00, 0x1B, 0xA0, 0x03, 0x10, 0x0A, 0x90, 0x08, 0xFD, 0xDC, 0x20, 0x00, 0x13, 0x20, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },	// 's'
+		{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x15, 0x00, 0x00, 0x00, 0x3F, 0x00, 0x00, 0x15, 0x7F, 0x55, 0x30, 0x2A, 0xBF, 0xAA, 0x70, 0x00, 0x3F, 0x00, 0x00, 0x00, 0x3F, 0x00, 0x00, 0x00, 0x3F, 0x00, 0x00, 0x00, 0x3F, 0x00, 0x00, 0x00, 0x2F, 0x30, 0x00, 0x00, 0x08, 0xEF, 0xA0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },	// 't'
+		{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x03, 0x30, 0x02, 0x40, 0x0A, 0x80, 0x05, 0xD0, 0x0A, 0x80, 0x05, 0xD0, 0x0A, 0x80, 0x05, 0xD0, 0x0A, 0x80, 0x05, 0xD0, 0x0A, 0x80, 0x06, 0xD0, 0x09, 0xB0, 0x0C, 0xD0, 0x03, 0xED, 0xD8, 0xD0, 0x00, 0x13, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },	// 'u'
+		{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x25, 0x00, 0x00, 0x52, 0x1F, 0x20, 0x02, 0xF1, 0x0B, 0x80, 0x08, 0xB0, 0x05, 0xD0, 0x0D, 0x50, 0x01, 0xF3, 0x3F, 0x10, 0x00, 0xA8, 0x8A, 0x00, 0x00, 0x5D, 0xD5, 0x00, 0x00, 0x0E, 0xE0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },	// 'v'
+		{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x51, 0x00, 0x00, 0x15, 0xD5, 0x00, 0x00, 0x5D, 0x98, 0x01, 0x10, 0x89, 0x5C, 0x0A, 0xA0, 0xC5, 0x2F, 0x0C, 0xC0, 0xF2, 0x0D, 0x79, 0x97, 0xD0, 0x0A, 0xD4, 0x4D, 0xA0, 0x06, 0xE0, 0x0E, 0x60, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },	// 'w'
+		{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x15, 0x00, 0x01, 0x51, 0x0A, 0xA0, 0x0A, 0xA0, 0x01, 0xD5, 0x5D, 0x10, 0x00, 0x3E, 0xE3, 0x00, 0x00, 0x0D, 0xD0, 0x00, 0x00, 0xAA, 0xAA, 0x00, 0x05, 0xD1, 0x1D, 0x50, 0x3F, 0x40, 0x04, 0xF3, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },	// 'x'
+		{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x25, 0x00, 0x00, 0x42, 0x1F, 0x30, 0x01, 0xF3, 0x0A, 0x90, 0x07, 0xC0, 0x03, 0xE1, 0x0C, 0x60, 0x00, 0xD5, 0x3F, 0x10, 0x00, 0x7B, 0x8A, 0x00, 0x00, 0x1F, 0xE4, 0x00, 0x00, 0x0A, 0xD0, 0x00, 0x00, 0x0C, 0x80, 0x00, 0x02, 0x7F, 0x20, 0x00, 0x0A, 0xB4, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },	// 'y'
+		{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x03, 0x55, 0x55, 0x30, 0x05, 0xAA, 0xAD, 0xA0, 0x00, 0x00, 0x3E, 0x30, 0x00, 0x01, 0xD6, 0x00, 0x00, 0x0B, 0x90, 0x00, 0x00, 0x8C, 0x00, 0x00, 0x05, 0xE1, 0x00, 0x00, 0x0A, 0xFF, 0xFF, 0xA0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },	// 'z'
+		{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x10, 0x00, 0x02, 0xDD, 0x60, 0x00, 0x08, 0xC0, 0x00, 0x00, 0x08, 0xA0, 0x00, 0x00, 0x08, 0xA0, 0x00, 0x00, 0x09, 0xA0, 0x00, 0x04, 0x8E, 0x40, 0x00, 0x04, 0x8D, 0x30, 0x00, 0x00, 0x0A, 0x90, 0x00, 0x00, 0x08, 0xA0, 0x00, 0x00, 0x08, 0xA0, 0x00, 0x00, 0x08, 0xB0, 0x00, 0x00, 0x03, 0xED, 0x60, 0x00, 0x00, 0x03, 0x10, 0x00, 0x00, 0x00, 0x00 },	// '{'
+		{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x10, 0x00, 0x00, 0x08, 0x80, 0x00, 0x00, 0x08, 0x80, 0x00, 0x00, 0x08, 0x80, 0x00, 0x00, 0x08, 0x80, 0x00, 0x00, 0x08, 0x80, 0x00, 0x00, 0x08, 0x80, 0x00, 0x00, 0x08, 0x80, 0x00, 0x00, 0x08, 0x80, 0x00, 0x00, 0x08, 0x80, 0x00, 0x00, 0x08, 0x80, 0x00, 0x00, 0x08, 0x80, 0x00, 0x00, 0x08, 0x80, 0x00, 0x00, 0x08, 0x80, 0x00, 0x00, 0x01, 0x10, 0x00 },	// '|'
+		{ 0x00, 0x00, 0x00, 0x00, 0x01, 0x10, 0x00, 0x00, 0x06, 0xDD, 0x20, 0x00, 0x00, 0x0C, 0x70, 0x00, 0x00, 0x0A, 0x80, 0x00, 0x00, 0x0A, 0x80, 0x00, 0x00, 0x0A, 0x90, 0x00, 0x00, 0x04, 0xE8, 0x40, 0x00, 0x03, 0xD8, 0x40, 0x00, 0x09, 0x90, 0x00, 0x00, 0x0A, 0x80, 0x00, 0x00, 0x0A, 0x80, 0x00, 0x00, 0x0B, 0x80, 0x00, 0x06, 0xDE, 0x30, 0x00, 0x01, 0x30, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },	// '}'
+		{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x3D, 0xFE, 0x85, 0x87, 0x53, 0x03, 0x9D, 0x91, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },	// '~'
+	};
+}
+
+// Fills pixels with the atlas, one byte per texel, rows top to bottom
+void BuildDebugFontAtlas(std::vector<uint8_t>& pixels)
+{
+	pixels.assign(DebugFontAtlasWidth * DebugFontAtlasHeight, 0);
+
+	for (uint32_t cell = 0; cell <= DebugFontSolidCell; cell++)
+	{
+		const uint32_t cellX = (cell % DebugFontAtlasColumns) * DebugFontGlyphWidth;
+		const uint32_t cellY = (cell / DebugFontAtlasColumns) * DebugFontGlyphHeight;
+
+		for (uint32_t y = 0; y < DebugFontGlyphHeight; y++)
+		{
+			uint8_t* row = &pixels[(cellY + y) * DebugFontAtlasWidth + cellX];
+			for (uint32_t x = 0; x < DebugFontGlyphWidth; x++)
+			{
+				if (cell == DebugFontSolidCell)
+				{
+					row[x] = 0xFF;
+					continue;
+				}
+
+				// Widen the 4-bit coverage to 8 bits (0xF -> 0xFF)
+				const uint8_t packed = Glyphs[cell][(y * DebugFontGlyphWidth + x) / 2];
+				const uint8_t coverage = (x & 1) ? (packed & 0x0F) : (packed >> 4);
+				row[x] = static_cast<uint8_t>(coverage * 17);
+			}
+		}
+	}
+}
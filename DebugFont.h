@@ -0,0 +1,32 @@
+// Debug font
+// A fixed width 8x16 font covering printable ASCII, for the debug HUD. The glyphs were
+// rasterised from DejaVu Sans Mono (Bitstream Vera licence) at 4 bits of coverage per pixel
+// and baked in, so no font files or font libraries are needed at runtime.
+//
+// The atlas lays the glyphs out in a grid in a single channel texture, followed by one solid
+// cell that untextured quads sample, so text and shapes can share a draw.
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+const uint32_t DebugFontGlyphWidth = 8;
+const uint32_t DebugFontGlyphHeight = 16;
+const char DebugFontFirstChar = ' ';
+const char DebugFontLastChar = '~';
+
+// Grid of 16 x 6 cells: the 95 glyphs then the solid cell
+const uint32_t DebugFontAtlasColumns = 16;
+const uint32_t DebugFontAtlasWidth = DebugFontAtlasColumns * DebugFontGlyphWidth;
+const uint32_t DebugFontAtlasHeight = 6 * DebugFontGlyphHeight;
+const uint32_t DebugFontSolidCell = DebugFontLastChar - DebugFontFirstChar + 1;
+
+// Fills pixels with the atlas, one byte per texel, rows top to bottom
+void BuildDebugFontAtlas(std::vector<uint8_t>& pixels);
+
+// Returns the atlas cell for a character. Characters outside printable ASCII get '?'.
+inline uint32_t GetDebugFontCell(char c)
+{
+	return (c >= DebugFontFirstChar && c <= DebugFontLastChar) ? static_cast<uint32_t>(c - DebugFontFirstChar) : static_cast<uint32_t>('?' - DebugFontFirstChar);
+}
@@ -0,0 +1,154 @@
+#include "DebugHud.h"
+#include "DebugFont.h"
+
+#include <algorithm>
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+
+const uint32_t DebugHud::VerticesPerQuad;
+const float DebugHud::LineHeight = static_cast<float>(DebugFontGlyphHeight);
+const float DebugHud::CharacterWidth = static_cast<float>(DebugFontGlyphWidth);
+
+namespace
+{
+	const size_t MaxFormattedLength = 512;
+
+	const float TexelWidth = 1.0f / DebugFontAtlasWidth;
+	const float TexelHeight = 1.0f / DebugFontAtlasHeight;
+
+	// Shapes sample the middle of the solid cell, well away from its neighbours
+	const float SolidU = ((DebugFontSolidCell % DebugFontAtlasColumns) * DebugFontGlyphWidth + DebugFontGlyphWidth * 0.5f) * TexelWidth;
+	const float SolidV = ((DebugFontSolidCell / DebugFontAtlasColumns) * DebugFontGlyphHeight + DebugFontGlyphHeight * 0.5f) * TexelHeight;
+}
+
+DebugHud::DebugHud() :
+	mVertexCount(0)
+{
+}
+
+// Clears the last frame's quads
+void DebugHud::Reset()
+{
+	mVertexCount = 0;
+}
+
+// Adds a line of text with its top left at x, y. '\n' starts a new line.
+void DebugHud::AddText(float x, float y, uint32_t colour, const char* text)
+{
+	// Room for a quad per character, though spaces and newlines don't get one
+	HudVertex* vertex = ReserveVertices(strlen(text) * VerticesPerQuad);
+
+	float penX = x;
+	for (const char* c = text; *c != '\0'; c++)
+	{
+		if (*c == '\n')
+		{
+			penX = x;
+			y += LineHeight;
+			continue;
+		}
+
+		if (*c != ' ')
+		{
+			const uint32_t cell = GetDebugFontCell(*c);
+			const float u = (cell % DebugFontAtlasColumns) * DebugFontGlyphWidth * TexelWidth;
+			const float v = (cell / DebugFontAtlasColumns) * DebugFontGlyphHeight * TexelHeight;
+			WriteQuad(vertex, penX, y, penX + CharacterWidth, y + LineHeight,
+				u, v, u + DebugFontGlyphWidth * TexelWidth, v + DebugFontGlyphHeight * TexelHeight, colour);
+			vertex += VerticesPerQuad;
+		}
+		penX += CharacterWidth;
+	}
+
+	mVertexCount = vertex - mVertices.data();
+}
+
+// printf style. Text longer than a few hundred characters is cut short.
+void DebugHud::AddTextf(float x, float y, uint32_t colour, const char* format, ...)
+{
+	char text[MaxFormattedLength];
+	va_list args;
+	va_start(args, format);
+	vsnprintf(text, sizeof(text), format, args);
+	va_end(args);
+
+	AddText(x, y, colour, text);
+}
+
+void DebugHud::AddRect(float x, float y, float width, float height, uint32_t colour)
+{
+	WriteQuad(ReserveVertices(VerticesPerQuad), x, y, x + width, y + height, SolidU, SolidV, SolidU, SolidV, colour);
+	mVertexCount += VerticesPerQuad;
+}
+
+// A bar per value, oldest on the left. values is a ring of count values with the oldest at
+// start. Bars are scaled so maxValue fills the height, and clamped to it.
+void DebugHud::AddGraph(float x, float y, float width, float height, const float* values, uint32_t count, uint32_t start, float maxValue, uint32_t colour)
+{
+	if (count == 0 || maxValue <= 0.0f)
+	{
+		return;
+	}
+
+	HudVertex* vertex = ReserveVertices(count * VerticesPerQuad);
+
+	const float barWidth = width / count;
+	const float bottom = y + height;
+	for (uint32_t i = 0; i < count; i++)
+	{
+		const float value = values[(start + i) % count];
+		const float barHeight = (std::min)((std::max)(value / maxValue, 0.0f), 1.0f) * height;
+		if (barHeight > 0.0f)
+		{
+			const float barX = x + i * barWidth;
+			WriteQuad(vertex, barX, bottom - barHeight, barX + barWidth, bottom, SolidU, SolidV, SolidU, SolidV, colour);
+			vertex += VerticesPerQuad;
+		}
+	}
+
+	mVertexCount = vertex - mVertices.data();
+}
+
+// Returns room for count more vertices after the current ones. Callers move mVertexCount on
+// by as many as they write. The storage only grows, so after the first few frames this is
+// just a bounds check, and vertices are never cleared before being written.
+HudVertex* DebugHud::ReserveVertices(size_t count)
+{
+	if (mVertexCount + count > mVertices.size())
+	{
+		mVertices.resize((std::max)(mVertexCount + count, mVertices.size() * 2));
+	}
+	return mVertices.data() + mVertexCount;
+}
+
+// Two clockwise triangles: top left, top right, bottom left, then bottom left, top right, bottom right
+void DebugHud::WriteQuad(HudVertex* vertex, float x0, float y0, float x1, float y1, float u0, float v0, float u1, float v1, uint32_t colour)
+{
+	vertex[0].position[0] = x0;
+	vertex[0].position[1] = y0;
+	vertex[0].uv[0] = u0;
+	vertex[0].uv[1] = v0;
+	vertex[0].colour = colour;
+
+	vertex[1].position[0] = x1;
+	vertex[1].position[1] = y0;
+	vertex[1].uv[0] = u1;
+	vertex[1].uv[1] = v0;
+	vertex[1].colour = colour;
+
+	vertex[2].position[0] = x0;
+	vertex[2].position[1] = y1;
+	vertex[2].uv[0] = u0;
+	vertex[2].uv[1] = v1;
+	vertex[2].colour = colour;
+
+	vertex[3] = vertex[2];
+	vertex[4] = vertex[1];
+
+	vertex[5].position[0] = x1;
+	vertex[5].position[1] = y1;
+	vertex[5].uv[0] = u1;
+	vertex[5].uv[1] = v1;
+	vertex[5].colour = colour;
+}
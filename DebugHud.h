@@ -0,0 +1,67 @@
+// Debug HUD
+// Builds the quads for a frame's text and graphs into one vertex list, to be drawn in a single
+// call. Everything samples the debug font atlas: glyphs their cell and shapes its solid cell,
+// so text and shapes need no state changes between them. Positions are in pixels from the top
+// left of the screen, and quads are two triangles each, so no index buffer is needed.
+//
+// Only builds vertices, so can be run and timed without a device. The vertex list is kept
+// between frames, so once it has grown to fit a frame's HUD, building one doesn't allocate.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct HudVertex
+{
+	float position[2];
+	float uv[2];
+	uint32_t colour;	// RGBA8, red in the low byte
+};
+
+inline uint32_t HudColour(uint8_t r, uint8_t g, uint8_t b, uint8_t a = 255)
+{
+	return static_cast<uint32_t>(r) | (static_cast<uint32_t>(g) << 8) | (static_cast<uint32_t>(b) << 16) | (static_cast<uint32_t>(a) << 24);
+}
+
+class DebugHud
+{
+public:
+	static const uint32_t VerticesPerQuad = 6;
+	static const float LineHeight;
+	static const float CharacterWidth;
+
+	DebugHud();
+
+	// Prohibit copying
+	DebugHud(const DebugHud& rhs) = delete;
+	DebugHud& operator=(const DebugHud& rhs) = delete;
+
+	// Clears the last frame's quads
+	void Reset();
+
+	// Adds a line of text with its top left at x, y. '\n' starts a new line.
+	void AddText(float x, float y, uint32_t colour, const char* text);
+
+	// printf style. Text longer than a few hundred characters is cut short.
+	void AddTextf(float x, float y, uint32_t colour, const char* format, ...);
+
+	void AddRect(float x, float y, float width, float height, uint32_t colour);
+
+	// A bar per value, oldest on the left. values is a ring of count values with the oldest at
+	// start. Bars are scaled so maxValue fills the height, and clamped to it.
+	void AddGraph(float x, float y, float width, float height, const float* values, uint32_t count, uint32_t start, float maxValue, uint32_t colour);
+
+	// Getters
+	const HudVertex* GetVertices() const { return mVertices.data(); }
+	uint32_t GetVertexCount() const { return static_cast<uint32_t>(mVertexCount); }
+	size_t GetVertexDataSize() const { return mVertexCount * sizeof(HudVertex); }
+
+private:
+	HudVertex* ReserveVertices(size_t count);
+	static void WriteQuad(HudVertex* vertex, float x0, float y0, float x1, float y1, float u0, float v0, float u1, float v1, uint32_t colour);
+
+	std::vector<HudVertex> mVertices;	// Only grows; the first mVertexCount are this frame's
+	size_t mVertexCount;
+};
@@ -0,0 +1,105 @@
+#include "DebugHudPanels.h"
+#include "Profiler.h"
+
+#include <algorithm>
+
+const uint32_t FrameTimeHistory::Length;
+
+namespace
+{
+	const float PanelPadding = 4.0f;
+	const float PanelColumns = 64.0f;	// Characters across
+	const float GraphHeight = 64.0f;
+	const float GraphMinScale = 1000.0f / 60.0f;	// The graph's top is at least a 60Hz frame
+
+	const uint32_t BackgroundColour = HudColour(0, 0, 0, 160);
+	const uint32_t TextColour = HudColour(255, 255, 255);
+	const uint32_t HeadingColour = HudColour(255, 220, 100);
+	const uint32_t CpuColour = HudColour(90, 200, 90);
+	const uint32_t GpuColour = HudColour(240, 140, 50, 200);
+
+	// Draws the panel's background, returning the position of its first line
+	float AddBackground(DebugHud& hud, float x, float y, uint32_t lineCount, float extraHeight)
+	{
+		hud.AddRect(x, y, PanelColumns * DebugHud::CharacterWidth + PanelPadding * 2,
+			lineCount * DebugHud::LineHeight + extraHeight + PanelPadding * 2, BackgroundColour);
+		return y + PanelPadding;
+	}
+}
+
+FrameTimeHistory::FrameTimeHistory() :
+	next(0)
+{
+	std::fill(cpu, cpu + Length, 0.0f);
+	std::fill(gpu, gpu + Length, 0.0f);
+}
+
+// A negative time is left out of the graph
+void FrameTimeHistory::Add(float cpuTime, float gpuTime)
+{
+	cpu[next] = cpuTime;
+	gpu[next] = gpuTime;
+	next = (next + 1) % Length;
+}
+
+// Percentiles over the stats' window, and the history graph with the GPU drawn over the CPU.
+// Returns the panel's height.
+float AddFrameStatsPanel(DebugHud& hud, float x, float y, const FrameStats& stats, const FrameTimeHistory& history)
+{
+	const uint32_t lineCount = NumFrameStats + 2;
+	float lineY = AddBackground(hud, x, y, lineCount, GraphHeight);
+	const float textX = x + PanelPadding;
+
+	hud.AddText(textX, lineY, HeadingColour, "Frame (ms)     p50     p99   p99.9     max");
+	lineY += DebugHud::LineHeight;
+
+	for (unsigned int stat = 0; stat < NumFrameStats; stat++)
+	{
+		const FrameStatsSummary summary = stats.GetWindowSummary(static_cast<EFrameStat>(stat));
+		if (summary.count > 0)
+		{
+			hud.AddTextf(textX, lineY, TextColour, "%-10s %7.2f %7.2f %7.2f %7.2f",
+				FrameStats::GetStatName(static_cast<EFrameStat>(stat)), summary.p50, summary.p99, summary.p999, summary.max);
+		}
+		lineY += DebugHud::LineHeight;
+	}
+
+	// Scaled to the slowest frame shown, so spikes stay on the graph
+	float scale = GraphMinScale;
+	for (uint32_t i = 0; i < FrameTimeHistory::Length; i++)
+	{
+		scale = (std::max)(scale, (std::max)(history.cpu[i], history.gpu[i]));
+	}
+
+	const float graphWidth = PanelColumns * DebugHud::CharacterWidth;
+	hud.AddGraph(textX, lineY, graphWidth, GraphHeight, history.cpu, FrameTimeHistory::Length, history.next, scale, CpuColour);
+	hud.AddGraph(textX, lineY, graphWidth, GraphHeight, history.gpu, FrameTimeHistory::Length, history.next, scale, GpuColour);
+	lineY += GraphHeight;
+
+	hud.AddTextf(textX, lineY, TextColour, "CPU / GPU, top %.1f ms", scale);
+
+	return lineCount * DebugHud::LineHeight + GraphHeight + PanelPadding * 2;
+}
+
+// Each profiler zone's time for the last frame and its average. Returns the panel's height.
+float AddProfilerPanel(DebugHud& hud, float x, float y)
+{
+	const unsigned int zoneCount = GetProfileZoneCount();
+	const uint32_t lineCount = zoneCount + 1;
+	float lineY = AddBackground(hud, x, y, lineCount, 0.0f);
+	const float textX = x + PanelPadding;
+
+	hud.AddText(textX, lineY, HeadingColour, "Zone (ms)                         last    mean");
+	lineY += DebugHud::LineHeight;
+
+	for (unsigned int i = 0; i < zoneCount; i++)
+	{
+		const ProfileZoneStats* zone = GetProfileZone(i);
+		const uint64_t frames = zone->frameTimes.GetCount();
+		const double mean = frames > 0 ? NanosecondsToMilliseconds(zone->totalTime) / frames : 0.0;
+		hud.AddTextf(textX, lineY, TextColour, "%-32.32s %7.3f %7.3f", zone->name, NanosecondsToMilliseconds(zone->lastFrameTime), mean);
+		lineY += DebugHud::LineHeight;
+	}
+
+	return lineCount * DebugHud::LineHeight + PanelPadding * 2;
+}
@@ -0,0 +1,30 @@
+// Debug HUD panels
+// The app's standard HUD contents: live frame stats with a frame time graph, and the
+// profiler zones' times for the last frame.
+
+#pragma once
+
+#include "DebugHud.h"
+#include "FrameStats.h"
+
+// The last couple of seconds of frame times for the graph, in milliseconds
+struct FrameTimeHistory
+{
+	static const uint32_t Length = 120;
+
+	float cpu[Length];
+	float gpu[Length];
+	uint32_t next;	// Where the next frame goes, which is also the oldest
+
+	FrameTimeHistory();
+
+	// A negative time is left out of the graph
+	void Add(float cpuTime, float gpuTime);
+};
+
+// Percentiles over the stats' window, and the history graph with the GPU drawn over the CPU.
+// Returns the panel's height.
+float AddFrameStatsPanel(DebugHud& hud, float x, float y, const FrameStats& stats, const FrameTimeHistory& history);
+
+// Each profiler zone's time for the last frame and its average. Returns the panel's height.
+float AddProfilerPanel(DebugHud& hud, float x, float y);
@@ -0,0 +1,223 @@
+#include "DebugHudRenderer.h"
+#include "DebugFont.h"
+
+#include <algorithm>
+#include <cstring>
+
+const UINT64 DebugHudRenderer::MinVertexBufferSize;
+
+namespace
+{
+	// Root parameters
+	const UINT RootParameter_Constants = 0;
+	const UINT RootParameter_Atlas = 1;
+
+	struct HudConstants
+	{
+		float scale[2];		// Pixels to clip space
+		float offset[2];
+	};
+}
+
+DebugHudRenderer::DebugHudRenderer(ID3D12Device* device, GpuMemoryAllocator* uploadAllocator) :
+	mDevice(device),
+	mUploadAllocator(uploadAllocator),
+	mPsoCache(nullptr),
+	mPso(PsoCache::InvalidHandle),
+	mAtlasUpload(GpuMemoryAllocator::InvalidHandle),
+	mAtlasFootprint(),
+	mAtlasUploadFenceValue(0),
+	mAtlasUploaded(false)
+{
+	// Root constants for the vertex shader, and the atlas, sampled without filtering as glyphs
+	// are drawn at their baked size
+	CD3DX12_DESCRIPTOR_RANGE atlasRange;
+	atlasRange.Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 1, 0);
+
+	CD3DX12_ROOT_PARAMETER rootParameters[2];
+	rootParameters[RootParameter_Constants].InitAsConstants(sizeof(HudConstants) / 4, 1, 0, D3D12_SHADER_VISIBILITY_VERTEX);
+	rootParameters[RootParameter_Atlas].InitAsDescriptorTable(1, &atlasRange, D3D12_SHADER_VISIBILITY_PIXEL);
+
+	CD3DX12_STATIC_SAMPLER_DESC pointSampler(0, D3D12_FILTER_MIN_MAG_MIP_POINT,
+		D3D12_TEXTURE_ADDRESS_MODE_CLAMP, D3D12_TEXTURE_ADDRESS_MODE_CLAMP, D3D12_TEXTURE_ADDRESS_MODE_CLAMP);
+	pointSampler.ShaderVisibility = D3D12_SHADER_VISIBILITY_PIXEL;
+
+	CD3DX12_ROOT_SIGNATURE_DESC rootSignatureDesc;
+	rootSignatureDesc.Init(_countof(rootParameters), rootParameters, 1, &pointSampler,
+		D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT);
+
+	ComPtr<ID3DBlob> signature;
+	ComPtr<ID3DBlob> error;
+	ThrowIfFailed(D3D12SerializeRootSignature(&rootSignatureDesc, D3D_ROOT_SIGNATURE_VERSION_1, &signature, &error));
+	ThrowIfFailed(mDevice->CreateRootSignature(0, signature->GetBufferPointer(), signature->GetBufferSize(), IID_PPV_ARGS(&mRootSignature)));
+
+	// Create the atlas, and fill its upload buffer now so the first frame only has to copy it
+	const CD3DX12_RESOURCE_DESC atlasDesc = CD3DX12_RESOURCE_DESC::Tex2D(DXGI_FORMAT_R8_UNORM, DebugFontAtlasWidth, DebugFontAtlasHeight, 1, 1);
+	const CD3DX12_HEAP_PROPERTIES defaultHeap(D3D12_HEAP_TYPE_DEFAULT);
+	ThrowIfFailed(mDevice->CreateCommittedResource(&defaultHeap, D3D12_HEAP_FLAG_NONE, &atlasDesc,
+		D3D12_RESOURCE_STATE_COPY_DEST, nullptr, IID_PPV_ARGS(&mAtlas)));
+	mAtlas->SetName(L"DebugFontAtlas");
+
+	UINT64 uploadSize = 0;
+	mDevice->GetCopyableFootprints(&atlasDesc, 0, 1, 0, &mAtlasFootprint, nullptr, nullptr, &uploadSize);
+
+	// At least a slab's worth, so the buffer gets its own resource and meets the texture copy placement alignment
+	mAtlasUpload = mUploadAllocator->Allocate((std::max)(uploadSize, GpuMemoryAllocator::SlabSize), D3D12_RESOURCE_STATE_GENERIC_READ);
+	mAtlasFootprint.Offset = mUploadAllocator->GetOffset(mAtlasUpload);
+
+	WriteAtlasUpload(static_cast<UINT8*>(mUploadAllocator->GetCpuAddress(mAtlasUpload)));
+
+	D3D12_DESCRIPTOR_HEAP_DESC srvHeapDesc = {};
+	srvHeapDesc.NumDescriptors = 1;
+	srvHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
+	srvHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
+	ThrowIfFailed(mDevice->CreateDescriptorHeap(&srvHeapDesc, IID_PPV_ARGS(&mSrvHeap)));
+	mDevice->CreateShaderResourceView(mAtlas.Get(), nullptr, mSrvHeap->GetCPUDescriptorHandleForHeapStart());
+}
+
+// The GPU must have finished with the HUD
+DebugHudRenderer::~DebugHudRenderer()
+{
+	if (mAtlasUpload != GpuMemoryAllocator::InvalidHandle)
+	{
+		mUploadAllocator->Free(mAtlasUpload);
+	}
+
+	GpuMemoryAllocator* uploadAllocator = mUploadAllocator;
+	mVertexBuffers.Clear([uploadAllocator](GpuMemoryAllocator::Handle handle)
+	{
+		uploadAllocator->Free(handle);
+	});
+}
+
+// Requests the pipeline state from the cache. Nothing is drawn until it's ready.
+void DebugHudRenderer::CreatePipeline(PsoCache* psoCache, ID3DBlob* vertexShader, ID3DBlob* pixelShader)
+{
+	D3D12_INPUT_ELEMENT_DESC inputElementDescs[] =
+	{
+		{ "POSITION", 0, DXGI_FORMAT_R32G32_FLOAT, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+		{ "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, 8, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+		{ "COLOR", 0, DXGI_FORMAT_R8G8B8A8_UNORM, 0, 16, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 }
+	};
+
+	// Alpha blended over the frame, with the atlas's coverage scaling the alpha
+	D3D12_GRAPHICS_PIPELINE_STATE_DESC psoDesc = {};
+	psoDesc.InputLayout = { inputElementDescs, _countof(inputElementDescs) };
+	psoDesc.pRootSignature = mRootSignature.Get();
+	psoDesc.VS = CD3DX12_SHADER_BYTECODE(vertexShader);
+	psoDesc.PS = CD3DX12_SHADER_BYTECODE(pixelShader);
+	psoDesc.RasterizerState = CD3DX12_RASTERIZER_DESC(D3D12_DEFAULT);
+	psoDesc.RasterizerState.CullMode = D3D12_CULL_MODE_NONE;
+	psoDesc.BlendState = CD3DX12_BLEND_DESC(D3D12_DEFAULT);
+	psoDesc.BlendState.RenderTarget[0].BlendEnable = TRUE;
+	psoDesc.BlendState.RenderTarget[0].SrcBlend = D3D12_BLEND_SRC_ALPHA;
+	psoDesc.BlendState.RenderTarget[0].DestBlend = D3D12_BLEND_INV_SRC_ALPHA;
+	psoDesc.BlendState.RenderTarget[0].SrcBlendAlpha = D3D12_BLEND_ONE;
+	psoDesc.BlendState.RenderTarget[0].DestBlendAlpha = D3D12_BLEND_INV_SRC_ALPHA;
+	psoDesc.DepthStencilState.DepthEnable = FALSE;
+	psoDesc.DepthStencilState.StencilEnable = FALSE;
+	psoDesc.SampleMask = UINT_MAX;
+	psoDesc.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
+	psoDesc.NumRenderTargets = 1;
+	psoDesc.RTVFormats[0] = DXGI_FORMAT_R8G8B8A8_UNORM;
+	psoDesc.SampleDesc.Count = 1;
+
+	mPsoCache = psoCache;
+	mPso = mPsoCache->Request(psoDesc);
+}
+
+// Writes an upload allocation of the HUD's again after a defragment moved it. Only the atlas's
+// upload buffer has to be kept, until its copy has been recorded; vertices are written each frame.
+void DebugHudRenderer::RewriteUpload(GpuMemoryAllocator::Handle handle, void* data)
+{
+	if (handle == mAtlasUpload && !mAtlasUploaded)
+	{
+		WriteAtlasUpload(static_cast<UINT8*>(data));
+	}
+}
+
+// Records the copy of the atlas from its upload buffer. fenceValue is the value the queue
+// signals after the list is submitted.
+void DebugHudRenderer::RecordAtlasUpload(ID3D12GraphicsCommandList* commandList, UINT64 fenceValue)
+{
+	const CD3DX12_TEXTURE_COPY_LOCATION destination(mAtlas.Get(), 0);
+	const CD3DX12_TEXTURE_COPY_LOCATION source(mUploadAllocator->GetResource(mAtlasUpload), mAtlasFootprint);
+	commandList->CopyTextureRegion(&destination, 0, 0, 0, &source, nullptr);
+
+	mAtlasUploaded = true;
+	mAtlasUploadFenceValue = fenceValue;
+}
+
+// Copies the HUD's vertices to an upload buffer and draws them over the bound render target,
+// which is width x height pixels. The atlas must be in the PIXEL_SHADER_RESOURCE state.
+void DebugHudRenderer::Record(ID3D12GraphicsCommandList* commandList, const DebugHud& hud, UINT width, UINT height, UINT64 fenceValue, UINT64 completedFenceValue)
+{
+	// The atlas's upload buffer is only needed until its copy has run
+	if (mAtlasUpload != GpuMemoryAllocator::InvalidHandle && mAtlasUploaded && completedFenceValue >= mAtlasUploadFenceValue)
+	{
+		mUploadAllocator->Free(mAtlasUpload);
+		mAtlasUpload = GpuMemoryAllocator::InvalidHandle;
+	}
+
+	ID3D12PipelineState* pipelineState = mPsoCache != nullptr ? mPsoCache->Get(mPso) : nullptr;
+	const UINT64 vertexDataSize = hud.GetVertexDataSize();
+	if (pipelineState == nullptr || vertexDataSize == 0)
+	{
+		return;
+	}
+
+	// A buffer whose last frame has finished, swapped for a bigger one if this frame's HUD doesn't fit
+	GpuMemoryAllocator* uploadAllocator = mUploadAllocator;
+	auto allocate = [uploadAllocator, vertexDataSize]()
+	{
+		UINT64 size = MinVertexBufferSize;
+		while (size < vertexDataSize)
+		{
+			size *= 2;
+		}
+		return uploadAllocator->Allocate(size, D3D12_RESOURCE_STATE_GENERIC_READ);
+	};
+
+	GpuMemoryAllocator::Handle vertexBuffer = mVertexBuffers.Acquire(completedFenceValue, allocate);
+	if (mUploadAllocator->GetSize(vertexBuffer) < vertexDataSize)
+	{
+		mUploadAllocator->Free(vertexBuffer);
+		vertexBuffer = allocate();
+	}
+	memcpy(mUploadAllocator->GetCpuAddress(vertexBuffer), hud.GetVertices(), static_cast<size_t>(vertexDataSize));
+
+	D3D12_VERTEX_BUFFER_VIEW vertexBufferView;
+	vertexBufferView.BufferLocation = mUploadAllocator->GetGpuAddress(vertexBuffer);
+	vertexBufferView.StrideInBytes = sizeof(HudVertex);
+	vertexBufferView.SizeInBytes = static_cast<UINT>(vertexDataSize);
+
+	// Pixels from the top left to clip space
+	HudConstants constants;
+	constants.scale[0] = 2.0f / width;
+	constants.scale[1] = -2.0f / height;
+	constants.offset[0] = -1.0f;
+	constants.offset[1] = 1.0f;
+
+	ID3D12DescriptorHeap* heaps[] = { mSrvHeap.Get() };
+	commandList->SetDescriptorHeaps(_countof(heaps), heaps);
+	commandList->SetGraphicsRootSignature(mRootSignature.Get());
+	commandList->SetGraphicsRoot32BitConstants(RootParameter_Constants, sizeof(HudConstants) / 4, &constants, 0);
+	commandList->SetGraphicsRootDescriptorTable(RootParameter_Atlas, mSrvHeap->GetGPUDescriptorHandleForHeapStart());
+	commandList->SetPipelineState(pipelineState);
+	commandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+	commandList->IASetVertexBuffers(0, 1, &vertexBufferView);
+	commandList->DrawInstanced(hud.GetVertexCount(), 1, 0, 0);
+
+	mVertexBuffers.Release(vertexBuffer, fenceValue);
+}
+
+// Fills the atlas's upload buffer with the font, laid out as its footprint describes
+void DebugHudRenderer::WriteAtlasUpload(UINT8* upload) const
+{
+	std::vector<uint8_t> atlasPixels;
+	BuildDebugFontAtlas(atlasPixels);
+	for (UINT y = 0; y < DebugFontAtlasHeight; y++)
+	{
+		memcpy(upload + y * mAtlasFootprint.Footprint.RowPitch, &atlasPixels[y * DebugFontAtlasWidth], DebugFontAtlasWidth);
+	}
+}
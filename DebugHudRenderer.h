@@ -0,0 +1,66 @@
+// Debug HUD renderer
+// Draws a DebugHud's quads in one call with its own root signature and pipeline state. Each
+// frame's vertices are copied into an upload buffer that is recycled once the GPU has finished
+// the frame using it. The font atlas is uploaded by the first frame that draws the HUD.
+
+#pragma once
+
+#include "DXSampleHelper.h"
+#include "DebugHud.h"
+#include "FencedPool.h"
+#include "GpuMemoryAllocator.h"
+#include "PsoCache.h"
+
+class DebugHudRenderer
+{
+public:
+	DebugHudRenderer(ID3D12Device* device, GpuMemoryAllocator* uploadAllocator);
+
+	// Prohibit copying
+	DebugHudRenderer(const DebugHudRenderer& rhs) = delete;
+	DebugHudRenderer& operator=(const DebugHudRenderer& rhs) = delete;
+
+	// The GPU must have finished with the HUD
+	~DebugHudRenderer();
+
+	// Requests the pipeline state from the cache. Nothing is drawn until it's ready.
+	void CreatePipeline(PsoCache* psoCache, ID3DBlob* vertexShader, ID3DBlob* pixelShader);
+
+	// The atlas is created in the COPY_DEST state
+	ID3D12Resource* GetAtlas() const { return mAtlas.Get(); }
+	bool IsAtlasUploaded() const { return mAtlasUploaded; }
+
+	// Writes an upload allocation of the HUD's again after a defragment moved it
+	void RewriteUpload(GpuMemoryAllocator::Handle handle, void* data);
+
+	// Records the copy of the atlas from its upload buffer. fenceValue is the value the queue
+	// signals after the list is submitted.
+	void RecordAtlasUpload(ID3D12GraphicsCommandList* commandList, UINT64 fenceValue);
+
+	// Copies the HUD's vertices to an upload buffer and draws them over the bound render target,
+	// which is width x height pixels. The atlas must be in the PIXEL_SHADER_RESOURCE state.
+	void Record(ID3D12GraphicsCommandList* commandList, const DebugHud& hud, UINT width, UINT height, UINT64 fenceValue, UINT64 completedFenceValue);
+
+private:
+	static const UINT64 MinVertexBufferSize = 64 * 1024;
+
+	void WriteAtlasUpload(UINT8* upload) const;
+
+	ComPtr<ID3D12Device> mDevice;
+	GpuMemoryAllocator* mUploadAllocator;
+
+	ComPtr<ID3D12RootSignature> mRootSignature;
+	PsoCache* mPsoCache;
+	PsoCache::Handle mPso;
+
+	// The atlas and the descriptor heap holding its view
+	ComPtr<ID3D12Resource> mAtlas;
+	ComPtr<ID3D12DescriptorHeap> mSrvHeap;
+	GpuMemoryAllocator::Handle mAtlasUpload;
+	D3D12_PLACED_SUBRESOURCE_FOOTPRINT mAtlasFootprint;
+	UINT64 mAtlasUploadFenceValue;
+	bool mAtlasUploaded;
+
+	// Upload buffers for the vertices, each reused once the frame it was used in has finished
+	FencedPool<GpuMemoryAllocator::Handle> mVertexBuffers;
+};
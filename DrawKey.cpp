@@ -0,0 +1,130 @@
+#include "DrawKey.h"
+
+namespace
+{
+	inline uint64_t Mask(unsigned int bits)
+	{
+		return (1ull << bits) - 1;
+	}
+
+	// Shifts of the fields below the translucency bit, which are laid out differently for each
+	const unsigned int MeshShift = 0;
+	const unsigned int MaterialShift = MeshShift + DrawKeyMeshBits;
+	const unsigned int PsoShift = MaterialShift + DrawKeyMaterialBits;
+
+	const unsigned int OpaqueDepthShift = 0;
+	const unsigned int OpaqueMeshShift = OpaqueDepthShift + DrawKeyDepthBits;
+	const unsigned int OpaqueMaterialShift = OpaqueMeshShift + DrawKeyMeshBits;
+	const unsigned int OpaquePsoShift = OpaqueMaterialShift + DrawKeyMaterialBits;
+
+	const unsigned int TranslucentDepthShift = PsoShift + DrawKeyPsoBits;
+	const unsigned int TranslucentShift = TranslucentDepthShift + DrawKeyDepthBits;
+	const unsigned int LayerShift = TranslucentShift + 1;
+
+	static_assert(LayerShift + DrawKeyLayerBits == 64, "Draw key fields must fill 64 bits");
+	static_assert(OpaquePsoShift + DrawKeyPsoBits == TranslucentShift, "Opaque and translucent keys must be the same size");
+}
+
+// Values wider than their fields are cut to fit
+uint64_t EncodeDrawKey(const DrawKeyFields& fields)
+{
+	uint64_t key = (fields.layer & Mask(DrawKeyLayerBits)) << LayerShift;
+	const uint64_t pso = fields.pso & Mask(DrawKeyPsoBits);
+	const uint64_t material = fields.material & Mask(DrawKeyMaterialBits);
+	const uint64_t mesh = fields.mesh & Mask(DrawKeyMeshBits);
+	const uint64_t depth = fields.depth & Mask(DrawKeyDepthBits);
+
+	if (fields.translucent)
+	{
+		// Furthest first
+		key |= 1ull << TranslucentShift;
+		key |= (Mask(DrawKeyDepthBits) - depth) << TranslucentDepthShift;
+		key |= (pso << PsoShift) | (material << MaterialShift) | (mesh << MeshShift);
+	}
+	else
+	{
+		key |= (pso << OpaquePsoShift) | (material << OpaqueMaterialShift) | (mesh << OpaqueMeshShift) | (depth << OpaqueDepthShift);
+	}
+	return key;
+}
+
+DrawKeyFields DecodeDrawKey(uint64_t key)
+{
+	DrawKeyFields fields;
+	fields.layer = static_cast<uint32_t>((key >> LayerShift) & Mask(DrawKeyLayerBits));
+	fields.translucent = ((key >> TranslucentShift) & 1) != 0;
+
+	if (fields.translucent)
+	{
+		fields.depth = static_cast<uint32_t>(Mask(DrawKeyDepthBits) - ((key >> TranslucentDepthShift) & Mask(DrawKeyDepthBits)));
+		fields.pso = static_cast<uint32_t>((key >> PsoShift) & Mask(DrawKeyPsoBits));
+		fields.material = static_cast<uint32_t>((key >> MaterialShift) & Mask(DrawKeyMaterialBits));
+		fields.mesh = static_cast<uint32_t>((key >> MeshShift) & Mask(DrawKeyMeshBits));
+	}
+	else
+	{
+		fields.depth = static_cast<uint32_t>((key >> OpaqueDepthShift) & Mask(DrawKeyDepthBits));
+		fields.pso = static_cast<uint32_t>((key >> OpaquePsoShift) & Mask(DrawKeyPsoBits));
+		fields.material = static_cast<uint32_t>((key >> OpaqueMaterialShift) & Mask(DrawKeyMaterialBits));
+		fields.mesh = static_cast<uint32_t>((key >> OpaqueMeshShift) & Mask(DrawKeyMeshBits));
+	}
+	return fields;
+}
+
+// Distance from the camera, between the near and far planes, as the key's depth field.
+// Spaced evenly, as sorting only needs the order to be roughly right.
+uint32_t QuantizeDrawDepth(float viewDepth, float nearZ, float farZ)
+{
+	const float t = (viewDepth - nearZ) / (farZ - nearZ);
+	if (!(t > 0.0f))
+	{
+		return 0;
+	}
+	if (t >= 1.0f)
+	{
+		return static_cast<uint32_t>(Mask(DrawKeyDepthBits));
+	}
+	return static_cast<uint32_t>(t * static_cast<float>(Mask(DrawKeyDepthBits)));
+}
+
+// Forgets the bound state, e.g. at the start of a command list, and clears the stats
+void DrawStateCache::Reset()
+{
+	mPso = 0;
+	mMaterial = 0;
+	mMesh = 0;
+	mBound = false;
+	mStats = Stats();
+}
+
+// Returns the EDrawStateChange flags for what must be set before the draw with the key.
+// A new pipeline state may bring a new root signature, so the material is set again with it.
+uint32_t DrawStateCache::Apply(uint64_t key)
+{
+	const DrawKeyFields fields = DecodeDrawKey(key);
+
+	uint32_t changes = 0;
+	if (!mBound || fields.pso != mPso)
+	{
+		changes |= DrawStateChange_Pso | DrawStateChange_Material;
+	}
+	if (!mBound || fields.material != mMaterial)
+	{
+		changes |= DrawStateChange_Material;
+	}
+	if (!mBound || fields.mesh != mMesh)
+	{
+		changes |= DrawStateChange_Mesh;
+	}
+
+	mPso = fields.pso;
+	mMaterial = fields.material;
+	mMesh = fields.mesh;
+	mBound = true;
+
+	mStats.drawCount++;
+	mStats.psoChanges += (changes & DrawStateChange_Pso) != 0;
+	mStats.materialChanges += (changes & DrawStateChange_Material) != 0;
+	mStats.meshChanges += (changes & DrawStateChange_Mesh) != 0;
+	return changes;
+}
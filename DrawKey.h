@@ -0,0 +1,81 @@
+// Draw sort keys
+// Each draw is given a 64-bit key so that sorting the keys puts draws in the order they should
+// be submitted. Most significant first:
+//
+//   Opaque		layer (4) | 0 | PSO (11) | material (16) | mesh (12) | depth (20), front to back
+//   Translucent	layer (4) | 1 | depth (20), back to front | PSO (11) | material (16) | mesh (12)
+//
+// Layers are drawn in order, and opaque draws before translucent ones in each layer. Opaque
+// draws are grouped by pipeline state, then material, then mesh, so sorted draws change as
+// little state as possible, with the nearest first in each group to make the most of early
+// depth rejection. Translucent draws must blend back to front, so depth comes first for them.
+//
+// DrawStateCache follows the state bound as sorted draws are recorded, so only what changes
+// between draws is set.
+
+#pragma once
+
+#include <cstdint>
+
+const unsigned int DrawKeyLayerBits = 4;
+const unsigned int DrawKeyPsoBits = 11;
+const unsigned int DrawKeyMaterialBits = 16;
+const unsigned int DrawKeyMeshBits = 12;
+const unsigned int DrawKeyDepthBits = 20;
+
+struct DrawKeyFields
+{
+	uint32_t layer;
+	bool translucent;
+	uint32_t pso;		// Pipeline state ID
+	uint32_t material;
+	uint32_t mesh;
+	uint32_t depth;		// From QuantizeDrawDepth, nearest 0
+};
+
+// Values wider than their fields are cut to fit
+uint64_t EncodeDrawKey(const DrawKeyFields& fields);
+DrawKeyFields DecodeDrawKey(uint64_t key);
+
+// Distance from the camera, between the near and far planes, as the key's depth field.
+// Spaced evenly, as sorting only needs the order to be roughly right.
+uint32_t QuantizeDrawDepth(float viewDepth, float nearZ, float farZ);
+
+enum EDrawStateChange
+{
+	DrawStateChange_Pso = 1 << 0,
+	DrawStateChange_Material = 1 << 1,
+	DrawStateChange_Mesh = 1 << 2
+};
+
+class DrawStateCache
+{
+public:
+	struct Stats
+	{
+		uint32_t drawCount;
+		uint32_t psoChanges;
+		uint32_t materialChanges;
+		uint32_t meshChanges;
+	};
+
+	DrawStateCache() { Reset(); }
+
+	// Forgets the bound state, e.g. at the start of a command list, and clears the stats
+	void Reset();
+
+	// Returns the EDrawStateChange flags for what must be set before the draw with the key.
+	// A new pipeline state may bring a new root signature, so the material is set again with it.
+	uint32_t Apply(uint64_t key);
+
+	// Getters
+	const Stats& GetStats() const { return mStats; }
+	uint32_t GetStateChangeCount() const { return mStats.psoChanges + mStats.materialChanges + mStats.meshChanges; }
+
+private:
+	uint32_t mPso;
+	uint32_t mMaterial;
+	uint32_t mMesh;
+	bool mBound;
+	Stats mStats;
+};
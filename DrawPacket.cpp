@@ -0,0 +1,263 @@
+#include "DrawPacket.h"
+
+#include <cstring>
+
+const DrawPacketList::Handle DrawPacketList::InvalidHandle;
+const uint32_t DrawPacketList::MaxRootConstants;
+
+namespace
+{
+	// A packet in the buffer: this header, then the root constants padded to 64 bits
+	struct PacketHeader
+	{
+		uint64_t rootSignature;
+		uint64_t pipelineState;
+		DrawPacketVertexBuffer vertexBuffer;
+		uint32_t vertexCount;
+		uint32_t instanceCount;
+		uint32_t startVertex;
+		uint32_t startInstance;
+		uint32_t rootParameter;
+		uint32_t constantCount;
+		uint32_t visibilityIndex;
+		uint32_t unused;
+	};
+
+	const uint32_t HeaderWords = sizeof(PacketHeader) / sizeof(uint64_t);
+	const uint32_t MaxPacketWords = HeaderWords + (DrawPacketList::MaxRootConstants + 1) / 2;
+
+	static_assert(sizeof(PacketHeader) % sizeof(uint64_t) == 0, "Packet headers must keep the constants after them aligned");
+
+	inline uint32_t GetPacketWords(uint32_t constantCount)
+	{
+		return HeaderWords + (constantCount + 1) / 2;
+	}
+}
+
+DrawPacketList::DrawPacketList() :
+	mNeedsRepack(false),
+	mRebuiltCount(0)
+{
+}
+
+// Returns InvalidHandle if the description isn't one that can be drawn: it must have a root
+// signature and pipeline state, no more than MaxRootConstants, and something to draw.
+DrawPacketList::Handle DrawPacketList::Add(const DrawPacketDesc& desc)
+{
+	if (!IsValid(desc))
+	{
+		return InvalidHandle;
+	}
+
+	Packet packet = { desc.sortKey, 0, 0 };
+	const Handle handle = mPackets.Insert(packet);
+	if (handle == InvalidHandle)
+	{
+		return InvalidHandle;
+	}
+
+	uint64_t encoded[MaxPacketWords];
+	Encode(desc, encoded);
+	Append(*mPackets.Get(handle), encoded, GetEncodedSize(desc));
+	mNeedsRepack = true;
+	return handle;
+}
+
+// Re-encodes the packet if the description differs from the one it was built from. Returns
+// false, leaving the packet as it was, if the handle is stale or the description is invalid.
+bool DrawPacketList::Update(Handle handle, const DrawPacketDesc& desc)
+{
+	Packet* packet = mPackets.Get(handle);
+	if (packet == nullptr || !IsValid(desc))
+	{
+		return false;
+	}
+
+	// Encoding is cheap next to what replaying a changed packet costs, so the new packet is
+	// compared with the old rather than the descriptions being hashed
+	uint64_t encoded[MaxPacketWords];
+	Encode(desc, encoded);
+	const uint32_t size = GetEncodedSize(desc);
+
+	if (desc.sortKey != packet->sortKey)
+	{
+		packet->sortKey = desc.sortKey;
+		mNeedsRepack = true;
+	}
+
+	if (size == packet->size)
+	{
+		uint64_t* current = mBuffer.data() + packet->offset;
+		if (memcmp(current, encoded, size * sizeof(uint64_t)) != 0)
+		{
+			memcpy(current, encoded, size * sizeof(uint64_t));
+			mRebuiltCount++;
+		}
+	}
+	else
+	{
+		// The old packet is left where it is until the buffer is repacked
+		Append(*packet, encoded, size);
+		mNeedsRepack = true;
+	}
+	return true;
+}
+
+void DrawPacketList::Remove(Handle handle)
+{
+	if (mPackets.Erase(handle))
+	{
+		mNeedsRepack = true;
+	}
+}
+
+void DrawPacketList::Clear()
+{
+	mPackets.Clear();
+	mBuffer.clear();
+	mNeedsRepack = false;
+	mRebuiltCount = 0;
+}
+
+// Replays every packet in sort key order, repacking them first if they've changed order.
+// With visibility, packets whose flag is 0 are skipped.
+DrawPacketList::ReplayStats DrawPacketList::Replay(DrawPacketSink& sink, const uint8_t* visibility)
+{
+	ReplayStats stats = {};
+	stats.rebuiltCount = mRebuiltCount;
+	stats.repacked = mNeedsRepack;
+	mRebuiltCount = 0;
+
+	if (mNeedsRepack)
+	{
+		Repack();
+	}
+
+	// Nothing is bound to start with, as the sink may be a new command list
+	uint64_t rootSignature = 0;
+	uint64_t pipelineState = 0;
+	DrawPacketVertexBuffer vertexBuffer = {};
+
+	const uint64_t* words = mBuffer.data();
+	const uint64_t* end = words + mBuffer.size();
+	while (words < end)
+	{
+		const PacketHeader& packet = *reinterpret_cast<const PacketHeader*>(words);
+		const uint32_t* constants = reinterpret_cast<const uint32_t*>(words + HeaderWords);
+		words += GetPacketWords(packet.constantCount);
+
+		if (visibility != nullptr && visibility[packet.visibilityIndex] == 0)
+		{
+			stats.hiddenCount++;
+			continue;
+		}
+
+		// A new root signature loses the root arguments, so the pipeline state is set with it
+		if (packet.rootSignature != rootSignature)
+		{
+			sink.SetRootSignature(packet.rootSignature);
+			rootSignature = packet.rootSignature;
+			pipelineState = 0;
+			stats.stateChangeCount++;
+		}
+		if (packet.pipelineState != pipelineState)
+		{
+			sink.SetPipelineState(packet.pipelineState);
+			pipelineState = packet.pipelineState;
+			stats.stateChangeCount++;
+		}
+		if (memcmp(&packet.vertexBuffer, &vertexBuffer, sizeof(vertexBuffer)) != 0)
+		{
+			sink.SetVertexBuffer(packet.vertexBuffer);
+			vertexBuffer = packet.vertexBuffer;
+			stats.stateChangeCount++;
+		}
+
+		if (packet.constantCount > 0)
+		{
+			sink.SetRootConstants(packet.rootParameter, packet.constantCount, constants);
+		}
+		sink.Draw(packet.vertexCount, packet.instanceCount, packet.startVertex, packet.startInstance);
+		stats.drawCount++;
+	}
+	return stats;
+}
+
+bool DrawPacketList::IsValid(const DrawPacketDesc& desc)
+{
+	return desc.rootSignature != 0 && desc.pipelineState != 0 &&
+		desc.constantCount <= MaxRootConstants && (desc.constantCount == 0 || desc.constants != nullptr) &&
+		desc.vertexCount > 0 && desc.instanceCount > 0;
+}
+
+// In 64-bit words
+uint32_t DrawPacketList::GetEncodedSize(const DrawPacketDesc& desc)
+{
+	return GetPacketWords(desc.constantCount);
+}
+
+void DrawPacketList::Encode(const DrawPacketDesc& desc, uint64_t* destination)
+{
+	PacketHeader header;
+	header.rootSignature = desc.rootSignature;
+	header.pipelineState = desc.pipelineState;
+	header.vertexBuffer = desc.vertexBuffer;
+	header.vertexCount = desc.vertexCount;
+	header.instanceCount = desc.instanceCount;
+	header.startVertex = desc.startVertex;
+	header.startInstance = desc.startInstance;
+	header.rootParameter = desc.rootParameter;
+	header.constantCount = desc.constantCount;
+	header.visibilityIndex = desc.visibilityIndex;
+	header.unused = 0;
+	memcpy(destination, &header, sizeof(header));
+
+	// The padding is cleared so packets can be compared whole
+	const uint32_t constantWords = GetPacketWords(desc.constantCount) - HeaderWords;
+	if (constantWords > 0)
+	{
+		destination[HeaderWords + constantWords - 1] = 0;
+		memcpy(destination + HeaderWords, desc.constants, desc.constantCount * sizeof(uint32_t));
+	}
+}
+
+// Adds the packet to the end of the buffer, wherever it was before
+void DrawPacketList::Append(Packet& packet, const uint64_t* encoded, uint32_t size)
+{
+	packet.offset = static_cast<uint32_t>(mBuffer.size());
+	packet.size = size;
+	mBuffer.insert(mBuffer.end(), encoded, encoded + size);
+	mRebuiltCount++;
+}
+
+// Copies the live packets into a new buffer in sort key order, leaving out any that were
+// removed or replaced
+void DrawPacketList::Repack()
+{
+	const uint32_t packetCount = static_cast<uint32_t>(mPackets.Size());
+	mSortKeys.resize(packetCount);
+	mSortPackets.resize(packetCount);
+
+	Packet* packets = mPackets.begin();
+	size_t liveSize = 0;
+	for (uint32_t i = 0; i < packetCount; i++)
+	{
+		mSortKeys[i] = packets[i].sortKey;
+		mSortPackets[i] = i;
+		liveSize += packets[i].size;
+	}
+	mSorter.Sort(mSortKeys.data(), mSortPackets.data(), packetCount);
+
+	mRepackBuffer.resize(liveSize);
+	uint32_t offset = 0;
+	for (uint32_t i = 0; i < packetCount; i++)
+	{
+		Packet& packet = packets[mSortPackets[i]];
+		memcpy(mRepackBuffer.data() + offset, mBuffer.data() + packet.offset, packet.size * sizeof(uint64_t));
+		packet.offset = offset;
+		offset += packet.size;
+	}
+
+	mBuffer.swap(mRepackBuffer);
+	mNeedsRepack = false;
+}
@@ -0,0 +1,166 @@
+// Draw packets
+// Static draws are baked once into packets holding everything needed to record them, already
+// resolved: the root signature and pipeline state, the vertex buffer view, the root constants
+// and the draw arguments. Packets are checked as they're built, so replaying them is a walk
+// through one packed buffer issuing commands, with nothing looked up or validated on the way.
+// Consecutive packets sharing a root signature, pipeline state or vertex buffer only set it once.
+//
+// A packet is only re-encoded when it's updated with a description that differs from what it
+// holds; everything else is replayed as it was. A packet that keeps its size and sort key is
+// rewritten where it is. Adding, removing or reordering packets has the buffer repacked at the
+// next replay, in sort key order, so replay stays a linear walk with draws sharing state together.
+// Replay can be given a visibility flag per object, e.g. from culling, and skips the packets of
+// hidden objects without them being changed.
+//
+// Packets don't depend on D3D12. Objects are held as IDs (e.g. their pointers) and views as
+// plain values, and packets are replayed into a DrawPacketSink. CommandListPacketSink records
+// them into a command list, or a bundle; NullDrawPacketSink only counts what it's given, so
+// packets can be built and replayed without a device.
+
+#pragma once
+
+#include "RadixSort.h"
+#include "SlotMap.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Laid out like D3D12_VERTEX_BUFFER_VIEW
+struct DrawPacketVertexBuffer
+{
+	uint64_t gpuAddress;
+	uint32_t sizeInBytes;
+	uint32_t strideInBytes;
+};
+
+struct DrawPacketDesc
+{
+	uint64_t sortKey;			// Replay order, e.g. from EncodeDrawKey
+	uint64_t rootSignature;		// Non-zero IDs, e.g. the objects' pointers
+	uint64_t pipelineState;
+	DrawPacketVertexBuffer vertexBuffer;
+	uint32_t rootParameter;		// Where the constants go
+	uint32_t constantCount;		// Up to DrawPacketList::MaxRootConstants 32-bit values
+	const uint32_t* constants;
+	uint32_t vertexCount;
+	uint32_t instanceCount;
+	uint32_t startVertex;
+	uint32_t startInstance;
+	uint32_t visibilityIndex;	// Which of Replay's visibility flags hides it, if it's given any
+};
+
+// Where packets are replayed to. Calls come in the order the commands should be recorded.
+class DrawPacketSink
+{
+public:
+	virtual ~DrawPacketSink() {}
+
+	virtual void SetRootSignature(uint64_t rootSignature) = 0;
+	virtual void SetPipelineState(uint64_t pipelineState) = 0;
+	virtual void SetVertexBuffer(const DrawPacketVertexBuffer& vertexBuffer) = 0;
+	virtual void SetRootConstants(uint32_t rootParameter, uint32_t count, const uint32_t* constants) = 0;
+	virtual void Draw(uint32_t vertexCount, uint32_t instanceCount, uint32_t startVertex, uint32_t startInstance) = 0;
+};
+
+// Records nothing, only counts the commands
+class NullDrawPacketSink : public DrawPacketSink
+{
+public:
+	struct Counts
+	{
+		uint32_t rootSignatures;
+		uint32_t pipelineStates;
+		uint32_t vertexBuffers;
+		uint32_t rootConstants;		// Values, not calls
+		uint32_t draws;
+		uint64_t vertices;
+	};
+
+	NullDrawPacketSink() : mCounts() {}
+
+	virtual void SetRootSignature(uint64_t) override { mCounts.rootSignatures++; }
+	virtual void SetPipelineState(uint64_t) override { mCounts.pipelineStates++; }
+	virtual void SetVertexBuffer(const DrawPacketVertexBuffer&) override { mCounts.vertexBuffers++; }
+	virtual void SetRootConstants(uint32_t, uint32_t count, const uint32_t*) override { mCounts.rootConstants += count; }
+	virtual void Draw(uint32_t vertexCount, uint32_t instanceCount, uint32_t, uint32_t) override
+	{
+		mCounts.draws++;
+		mCounts.vertices += static_cast<uint64_t>(vertexCount) * instanceCount;
+	}
+
+	void Reset() { mCounts = Counts(); }
+	const Counts& GetCounts() const { return mCounts; }
+
+private:
+	Counts mCounts;
+};
+
+class DrawPacketList
+{
+private:
+	// Where a packet is in the buffer
+	struct Packet
+	{
+		uint64_t sortKey;
+		uint32_t offset;	// In 64-bit words
+		uint32_t size;		// Ditto
+	};
+
+public:
+	typedef SlotMap<Packet>::Handle Handle;
+	static const Handle InvalidHandle = SlotMap<Packet>::InvalidHandle;
+
+	static const uint32_t MaxRootConstants = 32;
+
+	struct ReplayStats
+	{
+		uint32_t drawCount;
+		uint32_t hiddenCount;		// Packets skipped as their visibility flag was 0
+		uint32_t stateChangeCount;	// Root signatures, pipeline states and vertex buffers set
+		uint32_t rebuiltCount;		// Packets encoded since the last replay
+		bool repacked;
+	};
+
+	DrawPacketList();
+
+	// Prohibit copying
+	DrawPacketList(const DrawPacketList& rhs) = delete;
+	DrawPacketList& operator=(const DrawPacketList& rhs) = delete;
+
+	// Returns InvalidHandle if the description isn't one that can be drawn: it must have a root
+	// signature and pipeline state, no more than MaxRootConstants, and something to draw.
+	Handle Add(const DrawPacketDesc& desc);
+
+	// Re-encodes the packet if the description differs from the one it was built from. Returns
+	// false, leaving the packet as it was, if the handle is stale or the description is invalid.
+	bool Update(Handle handle, const DrawPacketDesc& desc);
+
+	void Remove(Handle handle);
+	void Clear();
+
+	// Replays every packet in sort key order, repacking them first if they've changed order.
+	// With visibility, packets whose flag is 0 are skipped.
+	ReplayStats Replay(DrawPacketSink& sink, const uint8_t* visibility = nullptr);
+
+	// Getters
+	size_t GetPacketCount() const { return mPackets.Size(); }
+	size_t GetBufferSize() const { return mBuffer.size() * sizeof(uint64_t); }
+
+private:
+	static bool IsValid(const DrawPacketDesc& desc);
+	static uint32_t GetEncodedSize(const DrawPacketDesc& desc);
+	static void Encode(const DrawPacketDesc& desc, uint64_t* destination);
+
+	void Append(Packet& packet, const uint64_t* encoded, uint32_t size);
+	void Repack();
+
+	SlotMap<Packet> mPackets;
+	std::vector<uint64_t> mBuffer;			// Packets, in sort key order unless waiting to be repacked
+	std::vector<uint64_t> mRepackBuffer;
+	std::vector<uint64_t> mSortKeys;
+	std::vector<uint32_t> mSortPackets;
+	RadixSorter mSorter;
+	bool mNeedsRepack;
+	uint32_t mRebuiltCount;
+};
@@ -0,0 +1,115 @@
+// Fenced pool
+// Recycles objects the GPU uses until a fence value completes, like command allocators. An
+// object handed back is tagged with the fence value of the submission using it, and is only
+// handed out again once the fence has reached that value. When nothing is ready a new object
+// is created, so the pool grows to fit however many the GPU has in flight at once.
+//
+// Only deals in fence values, not fences, so it can be driven by a simulated fence.
+// Safe to use from any number of threads at once.
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <utility>
+
+template<typename T>
+class FencedPool
+{
+public:
+	struct Stats
+	{
+		size_t createdCount;	// Objects the pool has made, in use or not
+		size_t inUseCount;		// Handed out and not yet handed back
+		size_t pendingCount;	// Handed back, waiting for their fence
+		size_t highWaterMark;	// Most objects in use at once
+		uint64_t reuseCount;	// Times an object was handed out again rather than created
+	};
+
+	FencedPool() : mCreatedCount(0), mHighWaterMark(0), mReuseCount(0) {}
+
+	// Prohibit copying
+	FencedPool(const FencedPool& rhs) = delete;
+	FencedPool& operator=(const FencedPool& rhs) = delete;
+
+	// Hands out the object retired longest ago if its fence has completed, otherwise one from
+	// create(). Only the oldest is checked, as submissions on one queue complete in order.
+	// create is called outside the lock, so other threads aren't held up while it runs.
+	template<typename Create>
+	T Acquire(uint64_t completedFenceValue, Create create)
+	{
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			if (!mRetired.empty() && mRetired.front().fenceValue <= completedFenceValue)
+			{
+				T object = std::move(mRetired.front().object);
+				mRetired.pop_front();
+				mReuseCount++;
+				UpdateHighWaterMark();
+				return object;
+			}
+
+			mCreatedCount++;
+			UpdateHighWaterMark();
+		}
+
+		return create();
+	}
+
+	// Hands an object back. fenceValue is the value signalled after the last submission using it.
+	void Release(T object, uint64_t fenceValue)
+	{
+		Retired retired = { std::move(object), fenceValue };
+
+		std::lock_guard<std::mutex> lock(mMutex);
+		mRetired.push_back(std::move(retired));
+	}
+
+	// Empties the pool, passing each object waiting in it to destroy, e.g. at shutdown once the
+	// GPU is idle. Objects still handed out aren't affected.
+	template<typename Destroy>
+	void Clear(Destroy destroy)
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		for (Retired& retired : mRetired)
+		{
+			destroy(retired.object);
+		}
+		mCreatedCount -= mRetired.size();
+		mRetired.clear();
+	}
+
+	Stats GetStats() const
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		Stats stats;
+		stats.createdCount = mCreatedCount;
+		stats.pendingCount = mRetired.size();
+		stats.inUseCount = mCreatedCount - mRetired.size();
+		stats.highWaterMark = mHighWaterMark;
+		stats.reuseCount = mReuseCount;
+		return stats;
+	}
+
+private:
+	struct Retired
+	{
+		T object;
+		uint64_t fenceValue;
+	};
+
+	// Call with the lock held
+	void UpdateHighWaterMark()
+	{
+		mHighWaterMark = (std::max)(mHighWaterMark, mCreatedCount - mRetired.size());
+	}
+
+	mutable std::mutex mMutex;
+	std::deque<Retired> mRetired;	// Oldest first
+	size_t mCreatedCount;
+	size_t mHighWaterMark;
+	uint64_t mReuseCount;
+};
@@ -0,0 +1,52 @@
+#include "FixedStepScheduler.h"
+#include "Clock.h"
+
+FixedStepScheduler::FixedStepScheduler(int64_t stepTime, unsigned int maxStepsPerFrame) :
+	mStepTime(stepTime > 0 ? stepTime : 1),
+	mMaxStepsPerFrame(maxStepsPerFrame > 0 ? maxStepsPerFrame : 1),
+	mAccumulator(0),
+	mStepCount(0),
+	mDroppedSteps(0),
+	mLastDroppedSteps(0)
+{
+}
+
+// Adds a frame's elapsed time (in nanoseconds) and returns the number of steps to run
+unsigned int FixedStepScheduler::Advance(int64_t elapsed)
+{
+	if (elapsed > 0)
+	{
+		mAccumulator += elapsed;
+	}
+
+	const int64_t stepsOwed = mAccumulator / mStepTime;
+	unsigned int steps = static_cast<unsigned int>(stepsOwed < mMaxStepsPerFrame ? stepsOwed : mMaxStepsPerFrame);
+
+	// Drop the time for any steps we won't run, keeping the fraction for interpolation
+	mLastDroppedSteps = static_cast<unsigned int>(stepsOwed - steps);
+	mDroppedSteps += mLastDroppedSteps;
+	mAccumulator -= stepsOwed * mStepTime;
+
+	mStepCount += steps;
+	return steps;
+}
+
+// Between 0 and 1, how far real time is past the last step towards the next
+float FixedStepScheduler::GetAlpha() const
+{
+	return static_cast<float>(static_cast<double>(mAccumulator) / static_cast<double>(mStepTime));
+}
+
+float FixedStepScheduler::GetStepSeconds() const
+{
+	return static_cast<float>(NanosecondsToSeconds(mStepTime));
+}
+
+// Clears the accumulator and counts
+void FixedStepScheduler::Reset()
+{
+	mAccumulator = 0;
+	mStepCount = 0;
+	mDroppedSteps = 0;
+	mLastDroppedSteps = 0;
+}
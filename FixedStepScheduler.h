@@ -0,0 +1,43 @@
+// Fixed timestep scheduler
+// Splits real time into simulation steps of a fixed length, so the simulation behaves the same
+// at any frame rate. Each frame's time is added to an accumulator and whole steps are taken out
+// of it. The leftover fraction of a step is the interpolation alpha for rendering between the
+// previous and current simulation states.
+//
+// To stop a slow frame causing more steps, which make the next frame slower still, at most
+// maxStepsPerFrame steps are run per frame and any further time owed is dropped.
+
+#pragma once
+
+#include <cstdint>
+
+class FixedStepScheduler
+{
+public:
+	FixedStepScheduler(int64_t stepTime, unsigned int maxStepsPerFrame);
+
+	// Adds a frame's elapsed time (in nanoseconds) and returns the number of steps to run
+	unsigned int Advance(int64_t elapsed);
+
+	// Between 0 and 1, how far real time is past the last step towards the next
+	float GetAlpha() const;
+
+	// Getters
+	int64_t GetStepTime() const { return mStepTime; }
+	float GetStepSeconds() const;
+	uint64_t GetStepCount() const { return mStepCount; }
+	uint64_t GetDroppedSteps() const { return mDroppedSteps; }
+	unsigned int GetLastDroppedSteps() const { return mLastDroppedSteps; }
+
+	// Clears the accumulator and counts
+	void Reset();
+
+private:
+	int64_t mStepTime;
+	unsigned int mMaxStepsPerFrame;
+
+	int64_t mAccumulator;
+	uint64_t mStepCount;
+	uint64_t mDroppedSteps;
+	unsigned int mLastDroppedSteps;
+};
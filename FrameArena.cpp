@@ -0,0 +1,161 @@
+#include "FrameArena.h"
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+	// Filled into reset memory in debug builds, so stale reads stand out
+	const uint8_t ResetFillPattern = 0xDD;
+}
+
+const size_t LinearArena::DefaultBlockSize;
+const unsigned int FrameArenas::FrameCount;
+
+LinearArena::LinearArena(size_t blockSize) :
+	mDefaultBlockSize(blockSize),
+	mCurrentBlock(0),
+	mBlock(nullptr),
+	mBlockSize(0),
+	mOffset(0),
+	mUsedInPreviousBlocks(0),
+	mPeakBytesUsed(0),
+	mGeneration(0)
+{
+}
+
+LinearArena::~LinearArena()
+{
+	for (Block& block : mBlocks)
+	{
+		delete[] block.memory;
+	}
+}
+
+// Moves on to the next block that fits, adding one if there isn't one
+void* LinearArena::AllocateFromNextBlock(size_t size, size_t alignment)
+{
+	const size_t needed = size + alignment;
+
+	if (mBlock != nullptr)
+	{
+		mUsedInPreviousBlocks += mOffset;
+		mCurrentBlock++;
+	}
+
+	// Blocks kept from earlier frames too small for this allocation are skipped over
+	while (mCurrentBlock < mBlocks.size() && mBlocks[mCurrentBlock].size < needed)
+	{
+		mCurrentBlock++;
+	}
+
+	if (mCurrentBlock == mBlocks.size())
+	{
+		Block block;
+		block.size = (std::max)(mDefaultBlockSize, needed);
+		block.memory = new uint8_t[block.size];
+		mBlocks.push_back(block);
+	}
+
+	mBlock = mBlocks[mCurrentBlock].memory;
+	mBlockSize = mBlocks[mCurrentBlock].size;
+	mOffset = 0;
+	return Allocate(size, alignment);
+}
+
+// Releases everything allocated, keeping the blocks for reuse
+void LinearArena::Reset()
+{
+	mPeakBytesUsed = (std::max)(mPeakBytesUsed, GetBytesUsed());
+
+#if FRAME_ARENA_DEBUG
+	for (size_t i = 0; i < mBlocks.size() && i <= mCurrentBlock; i++)
+	{
+		memset(mBlocks[i].memory, ResetFillPattern, i < mCurrentBlock ? mBlocks[i].size : mOffset);
+	}
+#endif
+
+	mCurrentBlock = 0;
+	mBlock = mBlocks.empty() ? nullptr : mBlocks[0].memory;
+	mBlockSize = mBlocks.empty() ? 0 : mBlocks[0].size;
+	mOffset = 0;
+	mUsedInPreviousBlocks = 0;
+	mGeneration++;
+}
+
+size_t LinearArena::GetBytesUsed() const
+{
+	return mUsedInPreviousBlocks + mOffset;
+}
+
+size_t LinearArena::GetPeakBytesUsed() const
+{
+	return (std::max)(mPeakBytesUsed, GetBytesUsed());
+}
+
+size_t LinearArena::GetCapacity() const
+{
+	size_t capacity = 0;
+	for (const Block& block : mBlocks)
+	{
+		capacity += block.size;
+	}
+	return capacity;
+}
+
+// One arena per thread for the main thread and the given number of workers
+FrameArenas::FrameArenas(unsigned int workerCount, size_t blockSize) :
+	mThreadCount(workerCount + 1),
+	mFrame(0)
+{
+	mArenas.resize(FrameCount * mThreadCount);
+	for (auto& arena : mArenas)
+	{
+		arena.reset(new LinearArena(blockSize));
+	}
+}
+
+// Moves on to the next frame, resetting its arenas. No jobs may be using them.
+void FrameArenas::BeginFrame()
+{
+	mFrame = (mFrame + 1) % FrameCount;
+	for (unsigned int thread = 0; thread < mThreadCount; thread++)
+	{
+		mArenas[mFrame * mThreadCount + thread]->Reset();
+	}
+}
+
+// The calling thread's arena for the current frame. Workers use their own, anything else the main thread's.
+LinearArena& FrameArenas::GetThreadArena()
+{
+	const int worker = JobSystem::GetWorkerIndex();
+	return GetArena(worker >= 0 ? static_cast<unsigned int>(worker) + 1 : 0);
+}
+
+LinearArena& FrameArenas::GetArena(unsigned int thread)
+{
+	return *mArenas[mFrame * mThreadCount + thread];
+}
+
+// This frame, over all threads
+size_t FrameArenas::GetBytesUsed() const
+{
+	size_t bytes = 0;
+	for (unsigned int thread = 0; thread < mThreadCount; thread++)
+	{
+		bytes += mArenas[mFrame * mThreadCount + thread]->GetBytesUsed();
+	}
+	return bytes;
+}
+
+// Largest single arena
+size_t FrameArenas::GetPeakBytesUsed() const
+{
+	size_t peak = 0;
+	for (const auto& arena : mArenas)
+	{
+		peak = (std::max)(peak, arena->GetPeakBytesUsed());
+	}
+	return peak;
+}
@@ -0,0 +1,212 @@
+// Per-frame arena allocation
+// Transient CPU data (barrier lists, draw lists, visible object lists, ...) is bump allocated
+// from a linear arena instead of the heap. Nothing is freed individually: the whole arena is
+// reset in one go once the frame that used it has retired. Blocks are kept across resets, so
+// once the arenas have grown to fit a frame, steady state frames make no heap allocations.
+//
+// FrameArenas holds an arena per thread (the main thread plus each job system worker) for each
+// of a small ring of frames. ArenaAllocator adapts an arena for the standard containers, and
+// ScratchVector etc. are the containers using it.
+//
+// In debug builds, reset memory is filled with a pattern and allocators remember the arena's
+// generation, so a container still used after its arena was reset is caught.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#if defined(_DEBUG) && !defined(FRAME_ARENA_DEBUG)
+#define FRAME_ARENA_DEBUG 1
+#endif
+
+#if FRAME_ARENA_DEBUG
+#include <cassert>
+#endif
+
+class LinearArena
+{
+public:
+	static const size_t DefaultBlockSize = 256 * 1024;
+
+	explicit LinearArena(size_t blockSize = DefaultBlockSize);
+	~LinearArena();
+
+	// Prohibit copying
+	LinearArena(const LinearArena& rhs) = delete;
+	LinearArena& operator=(const LinearArena& rhs) = delete;
+
+	// Alignment must be a power of two. Only touches the heap when a new block is needed.
+	void* Allocate(size_t size, size_t alignment = alignof(std::max_align_t))
+	{
+		const uintptr_t base = reinterpret_cast<uintptr_t>(mBlock);
+		const uintptr_t aligned = (base + mOffset + (alignment - 1)) & ~static_cast<uintptr_t>(alignment - 1);
+		const size_t end = static_cast<size_t>(aligned - base) + size;
+		if (mBlock == nullptr || end > mBlockSize)
+		{
+			return AllocateFromNextBlock(size, alignment);
+		}
+
+		mOffset = end;
+		return reinterpret_cast<void*>(aligned);
+	}
+
+	// Uninitialised space for count objects
+	template<typename T>
+	T* AllocateArray(size_t count)
+	{
+		return static_cast<T*>(Allocate(sizeof(T) * count, alignof(T)));
+	}
+
+	// Releases everything allocated, keeping the blocks for reuse. Constant time, other than
+	// filling the used memory in debug builds.
+	void Reset();
+
+	// Getters
+	uint32_t GetGeneration() const { return mGeneration; }	// Changes on every reset
+	size_t GetBytesUsed() const;
+	size_t GetPeakBytesUsed() const;
+	size_t GetCapacity() const;
+
+private:
+	struct Block
+	{
+		uint8_t* memory;
+		size_t size;
+	};
+
+	void* AllocateFromNextBlock(size_t size, size_t alignment);
+
+	const size_t mDefaultBlockSize;
+	std::vector<Block> mBlocks;
+
+	// Current block, cached for the fast path
+	size_t mCurrentBlock;
+	uint8_t* mBlock;
+	size_t mBlockSize;
+	size_t mOffset;
+
+	size_t mUsedInPreviousBlocks;
+	size_t mPeakBytesUsed;
+	uint32_t mGeneration;
+};
+
+// Standard library allocator using an arena. With no arena it uses the heap, so containers
+// can be default constructed and bound to an arena later by assigning one that has.
+template<typename T>
+class ArenaAllocator
+{
+public:
+	typedef T value_type;
+
+	// Assigning a container takes the other container's arena with it
+	typedef std::true_type propagate_on_container_copy_assignment;
+	typedef std::true_type propagate_on_container_move_assignment;
+	typedef std::true_type propagate_on_container_swap;
+
+	ArenaAllocator() noexcept : mArena(nullptr), mGeneration(0) {}
+	explicit ArenaAllocator(LinearArena* arena) noexcept : mArena(arena), mGeneration(arena ? arena->GetGeneration() : 0) {}
+
+	template<typename U>
+	ArenaAllocator(const ArenaAllocator<U>& other) noexcept : mArena(other.mArena), mGeneration(other.mGeneration) {}
+
+	T* allocate(size_t count)
+	{
+		if (mArena == nullptr)
+		{
+			return static_cast<T*>(::operator new(count * sizeof(T)));
+		}
+
+		CheckGeneration();
+		return mArena->AllocateArray<T>(count);
+	}
+
+	// Arena memory is only released when the arena is reset
+	void deallocate(T* memory, size_t) noexcept
+	{
+		if (mArena == nullptr)
+		{
+			::operator delete(memory);
+			return;
+		}
+
+		CheckGeneration();
+	}
+
+	// Getters
+	LinearArena* GetArena() const { return mArena; }
+
+private:
+	template<typename U> friend class ArenaAllocator;
+	template<typename A, typename B> friend bool operator==(const ArenaAllocator<A>& a, const ArenaAllocator<B>& b) noexcept;
+
+	void CheckGeneration() const
+	{
+#if FRAME_ARENA_DEBUG
+		assert(mArena->GetGeneration() == mGeneration && "Arena memory used after the arena was reset");
+#endif
+	}
+
+	LinearArena* mArena;
+	uint32_t mGeneration;
+};
+
+template<typename A, typename B>
+inline bool operator==(const ArenaAllocator<A>& a, const ArenaAllocator<B>& b) noexcept
+{
+	return a.mArena == b.mArena;
+}
+
+template<typename A, typename B>
+inline bool operator!=(const ArenaAllocator<A>& a, const ArenaAllocator<B>& b) noexcept
+{
+	return !(a == b);
+}
+
+// Containers for transient data, e.g. ScratchVector<UINT> visible((ArenaAllocator<UINT>(&arena)))
+template<typename T>
+using ScratchVector = std::vector<T, ArenaAllocator<T>>;
+
+template<typename Key, typename Value, typename Hash = std::hash<Key>, typename Equal = std::equal_to<Key>>
+using ScratchUnorderedMap = std::unordered_map<Key, Value, Hash, Equal, ArenaAllocator<std::pair<const Key, Value>>>;
+
+typedef std::basic_string<char, std::char_traits<char>, ArenaAllocator<char>> ScratchString;
+typedef std::basic_string<wchar_t, std::char_traits<wchar_t>, ArenaAllocator<wchar_t>> ScratchWString;
+
+// An arena per thread for each frame in a small ring. Memory from a frame's arenas lasts until
+// the ring comes back round to it, so anything made one frame can still be destroyed the next.
+// Only the main thread and the job system's workers may use it.
+class FrameArenas
+{
+public:
+	static const unsigned int FrameCount = 2;
+
+	// One arena per thread for the main thread and the given number of workers
+	FrameArenas(unsigned int workerCount, size_t blockSize = LinearArena::DefaultBlockSize);
+
+	// Prohibit copying
+	FrameArenas(const FrameArenas& rhs) = delete;
+	FrameArenas& operator=(const FrameArenas& rhs) = delete;
+
+	// Moves on to the next frame, resetting its arenas. No jobs may be using them.
+	void BeginFrame();
+
+	// The calling thread's arena for the current frame
+	LinearArena& GetThreadArena();
+	LinearArena& GetArena(unsigned int thread);
+
+	// Getters
+	unsigned int GetThreadCount() const { return mThreadCount; }
+	size_t GetBytesUsed() const;		// This frame, over all threads
+	size_t GetPeakBytesUsed() const;	// Largest single arena
+
+private:
+	std::vector<std::unique_ptr<LinearArena>> mArenas;	// [frame * threads + thread]
+	unsigned int mThreadCount;
+	unsigned int mFrame;
+};
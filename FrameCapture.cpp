@@ -0,0 +1,164 @@
+#include "FrameCapture.h"
+#include "Clock.h"
+#include "JobSystem.h"
+#include "QoiCodec.h"
+
+#include <algorithm>
+#include <cstdio>
+
+const UINT FrameCapture::SlotCount;
+
+FrameCapture::FrameCapture(ID3D12Device* device, GpuMemoryAllocator* readbackAllocator, JobSystem* jobSystem) :
+	mDevice(device),
+	mReadbackAllocator(readbackAllocator),
+	mJobSystem(jobSystem),
+	mRing(SlotCount),
+	mWrittenCount(0),
+	mFailedCount(0),
+	mEncodeTime(0)
+{
+	for (Slot& slot : mSlots)
+	{
+		slot.readback = GpuMemoryAllocator::InvalidHandle;
+		slot.footprint = {};
+	}
+}
+
+// Waits for captures being written. The GPU must have finished any copies still in flight.
+FrameCapture::~FrameCapture()
+{
+	mRing.WaitForReads();
+
+	for (Slot& slot : mSlots)
+	{
+		if (slot.readback != GpuMemoryAllocator::InvalidHandle)
+		{
+			mReadbackAllocator->Free(slot.readback);
+		}
+	}
+}
+
+// Asks for the next frame recorded to be captured to the file
+void FrameCapture::Request(const std::wstring& path)
+{
+	mRequests.push_back(path);
+}
+
+// Records a copy of the source (an R8G8B8A8 texture in the COPY_SOURCE state) for the
+// oldest request. fenceValue is the value the queue signals after the list is submitted.
+void FrameCapture::RecordCopy(ID3D12GraphicsCommandList* commandList, ID3D12Resource* source, UINT64 fenceValue)
+{
+	if (mRequests.empty())
+	{
+		return;
+	}
+
+	const std::wstring path = mRequests.front();
+	mRequests.pop_front();
+
+	const D3D12_RESOURCE_DESC desc = source->GetDesc();
+	if (desc.Format != DXGI_FORMAT_R8G8B8A8_UNORM && desc.Format != DXGI_FORMAT_R8G8B8A8_UNORM_SRGB)
+	{
+		OutputDebugStringW((L"Frame capture skipped, unsupported format: " + path + L"\n").c_str());
+		return;
+	}
+
+	const UINT slotIndex = mRing.Acquire(fenceValue);
+	if (slotIndex == ReadbackRing::InvalidSlot)
+	{
+		OutputDebugStringW((L"Frame capture dropped, all readback buffers busy: " + path + L"\n").c_str());
+		return;
+	}
+
+	Slot& slot = mSlots[slotIndex];
+	slot.path = path;
+
+	UINT64 totalBytes = 0;
+	mDevice->GetCopyableFootprints(&desc, 0, 1, 0, &slot.footprint, nullptr, nullptr, &totalBytes);
+
+	// The slot is free, so the GPU has finished with its buffer and it can be swapped for a
+	// bigger one. At least a slab's worth is asked for, so the buffer gets its own resource and
+	// meets the texture copy placement alignment.
+	const UINT64 readbackSize = (std::max)(totalBytes, GpuMemoryAllocator::SlabSize);
+	if (slot.readback != GpuMemoryAllocator::InvalidHandle && mReadbackAllocator->GetSize(slot.readback) < readbackSize)
+	{
+		mReadbackAllocator->Free(slot.readback);
+		slot.readback = GpuMemoryAllocator::InvalidHandle;
+	}
+	if (slot.readback == GpuMemoryAllocator::InvalidHandle)
+	{
+		slot.readback = mReadbackAllocator->Allocate(readbackSize, D3D12_RESOURCE_STATE_COPY_DEST);
+	}
+	slot.footprint.Offset = mReadbackAllocator->GetOffset(slot.readback);
+
+	const CD3DX12_TEXTURE_COPY_LOCATION destination(mReadbackAllocator->GetResource(slot.readback), slot.footprint);
+	const CD3DX12_TEXTURE_COPY_LOCATION sourceLocation(source, 0);
+	commandList->CopyTextureRegion(&destination, 0, 0, 0, &sourceLocation, nullptr);
+
+	mRing.Submit(slotIndex, fenceValue);
+}
+
+// Hands copies whose fence has completed to the job system to be written
+void FrameCapture::ProcessCompleted(UINT64 completedFenceValue)
+{
+	for (;;)
+	{
+		const UINT slotIndex = mRing.PopCompleted(completedFenceValue);
+		if (slotIndex == ReadbackRing::InvalidSlot)
+		{
+			return;
+		}
+
+		// The allocator isn't thread safe, so look up the address here. Readback buffers stay mapped.
+		const uint8_t* pixels = static_cast<const uint8_t*>(mReadbackAllocator->GetCpuAddress(mSlots[slotIndex].readback));
+		mJobSystem->Submit([this, slotIndex, pixels]()
+		{
+			WriteCapture(slotIndex, pixels);
+		});
+	}
+}
+
+// Encodes a slot's copy and writes it out. Runs on a worker thread.
+void FrameCapture::WriteCapture(UINT slotIndex, const uint8_t* pixels)
+{
+	Slot& slot = mSlots[slotIndex];
+	const D3D12_SUBRESOURCE_FOOTPRINT& footprint = slot.footprint.Footprint;
+
+	// The back buffer's alpha isn't meaningful, so it's left out
+	SystemClock clock;
+	const int64_t start = clock.Now();
+	const size_t size = EncodeQoi(pixels, footprint.Width, footprint.Height, footprint.RowPitch, 3, slot.encodeBuffer);
+	mEncodeTime += clock.Now() - start;
+
+	FILE* file = nullptr;
+	bool written = _wfopen_s(&file, slot.path.c_str(), L"wb") == 0;
+	if (written)
+	{
+		written = fwrite(slot.encodeBuffer.data(), 1, size, file) == size;
+		written = fclose(file) == 0 && written;
+	}
+
+	if (written)
+	{
+		mWrittenCount++;
+	}
+	else
+	{
+		mFailedCount++;
+		OutputDebugStringW((L"Failed to write frame capture " + slot.path + L"\n").c_str());
+	}
+
+	mRing.Release(slotIndex);
+}
+
+// One line summary, for the debug output
+void FrameCapture::FormatReport(char* buffer, size_t bufferSize) const
+{
+	const ReadbackRing::Stats stats = mRing.GetStats();
+	const uint64_t written = mWrittenCount;
+	snprintf(buffer, bufferSize, "Frame captures: %llu written, %llu failed, %llu dropped, %.2f ms average encode\n",
+		static_cast<unsigned long long>(written),
+		static_cast<unsigned long long>(mFailedCount.load()),
+		static_cast<unsigned long long>(stats.droppedCount),
+		written > 0 ? NanosecondsToMilliseconds(mEncodeTime.load()) / written : 0.0);
+}
@@ -0,0 +1,73 @@
+// Frame capture
+// Copies the back buffer into a ring of readback buffers and writes it out as a QOI image,
+// without ever waiting on the GPU. A copy is only read once the fence signalled after its
+// frame has completed, which with frames in flight is a few frames later, and is then encoded
+// and written on a worker thread straight from the readback buffer. Each slot keeps its
+// readback buffer and encode buffer between captures.
+//
+// Captures asked for while every slot is still busy are dropped rather than stalling.
+
+#pragma once
+
+#include "DXSampleHelper.h"
+#include "GpuMemoryAllocator.h"
+#include "ReadbackRing.h"
+
+#include <atomic>
+#include <deque>
+#include <string>
+#include <vector>
+
+class JobSystem;
+
+class FrameCapture
+{
+public:
+	static const UINT SlotCount = 3;
+
+	FrameCapture(ID3D12Device* device, GpuMemoryAllocator* readbackAllocator, JobSystem* jobSystem);
+
+	// Prohibit copying
+	FrameCapture(const FrameCapture& rhs) = delete;
+	FrameCapture& operator=(const FrameCapture& rhs) = delete;
+
+	// Waits for captures being written. The GPU must have finished any copies still in flight.
+	~FrameCapture();
+
+	// Asks for the next frame recorded to be captured to the file
+	void Request(const std::wstring& path);
+	bool HasRequest() const { return !mRequests.empty(); }
+
+	// Records a copy of the source (an R8G8B8A8 texture in the COPY_SOURCE state) for the
+	// oldest request. fenceValue is the value the queue signals after the list is submitted.
+	void RecordCopy(ID3D12GraphicsCommandList* commandList, ID3D12Resource* source, UINT64 fenceValue);
+
+	// Hands copies whose fence has completed to the job system to be written
+	void ProcessCompleted(UINT64 completedFenceValue);
+
+	// One line summary, for the debug output
+	void FormatReport(char* buffer, size_t bufferSize) const;
+
+private:
+	struct Slot
+	{
+		GpuMemoryAllocator::Handle readback;
+		D3D12_PLACED_SUBRESOURCE_FOOTPRINT footprint;
+		std::wstring path;
+		std::vector<uint8_t> encodeBuffer;
+	};
+
+	void WriteCapture(UINT slotIndex, const uint8_t* pixels);
+
+	ComPtr<ID3D12Device> mDevice;
+	GpuMemoryAllocator* mReadbackAllocator;
+	JobSystem* mJobSystem;
+
+	ReadbackRing mRing;
+	Slot mSlots[SlotCount];
+	std::deque<std::wstring> mRequests;
+
+	std::atomic<uint64_t> mWrittenCount;
+	std::atomic<uint64_t> mFailedCount;
+	std::atomic<int64_t> mEncodeTime;	// Total nanoseconds spent encoding
+};
@@ -0,0 +1,92 @@
+#include "FramePacer.h"
+
+namespace
+{
+	// Weight of the newest frame in the moving averages
+	const int64_t AverageWeightShift = 4;
+
+	int64_t UpdateAverage(int64_t average, int64_t value)
+	{
+		return average == 0 ? value : average + ((value - average) >> AverageWeightShift);
+	}
+}
+
+FramePacer::FramePacer(IClock* clock) :
+	mClock(clock),
+	mFrameIndex(0),
+	mNextFrameTime(0),
+	mLastPresentTime(0),
+	mCurrentFrame(),
+	mLastFrame(),
+	mAverageInputLatency(0),
+	mAveragePresentInterval(0)
+{
+}
+
+void FramePacer::SetSettings(const FramePacerSettings& settings)
+{
+	mSettings = settings;
+	if (mSettings.maxFrameLatency < 1)
+	{
+		mSettings.maxFrameLatency = 1;
+	}
+
+	// Restart the limiter's schedule so a change takes effect straight away
+	mNextFrameTime = 0;
+}
+
+// Call before sampling input for the frame. Waits for the swap chain and the frame limiter.
+void FramePacer::BeginFrame()
+{
+	mCurrentFrame = FrameTiming();
+	mCurrentFrame.frameIndex = mFrameIndex++;
+
+	const int64_t waitStart = mClock->Now();
+	if (mLatencyWait)
+	{
+		mLatencyWait();
+	}
+	const int64_t waitEnd = mClock->Now();
+	mCurrentFrame.latencyWait = waitEnd - waitStart;
+
+	if (mSettings.frameLimitHz > 0.0)
+	{
+		const int64_t interval = SecondsToNanoseconds(1.0 / mSettings.frameLimitHz);
+
+		// If we've fallen more than a frame behind, start the schedule again from now rather
+		// than running frames back to back to catch up
+		if (mNextFrameTime == 0 || waitEnd - mNextFrameTime > interval)
+		{
+			mNextFrameTime = waitEnd;
+		}
+
+		mClock->SleepUntil(mNextFrameTime);
+		mNextFrameTime += interval;
+	}
+
+	mCurrentFrame.frameStart = mClock->Now();
+	mCurrentFrame.limiterWait = mCurrentFrame.frameStart - waitEnd;
+}
+
+// Call straight after presenting, with the number of frames queued ahead of this one
+// on the GPU (including this one)
+void FramePacer::EndFrame(unsigned int queuedFrames)
+{
+	const int64_t presentTime = mClock->Now();
+	mCurrentFrame.cpuTime = presentTime - mCurrentFrame.frameStart;
+	mCurrentFrame.presentInterval = mLastPresentTime != 0 ? presentTime - mLastPresentTime : 0;
+	mLastPresentTime = presentTime;
+
+	if (mCurrentFrame.presentInterval > 0)
+	{
+		mAveragePresentInterval = UpdateAverage(mAveragePresentInterval, mCurrentFrame.presentInterval);
+	}
+
+	// Each frame queued ahead of this one (up to the latency limit) is shown for about one
+	// present interval before this one can be
+	const unsigned int queueDepth = queuedFrames < mSettings.maxFrameLatency ? queuedFrames : mSettings.maxFrameLatency;
+	mCurrentFrame.inputLatency = mCurrentFrame.cpuTime + static_cast<int64_t>(queueDepth) * mAveragePresentInterval;
+	mAverageInputLatency = UpdateAverage(mAverageInputLatency, mCurrentFrame.inputLatency);
+
+	mLastFrame = mCurrentFrame;
+}
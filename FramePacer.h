@@ -0,0 +1,80 @@
+// Frame pacing
+// Decides when each frame starts and how it is presented. At the start of a frame it waits
+// until the swap chain can take another frame (keeping the queue at most maxFrameLatency
+// frames deep), then applies an optional CPU frame rate limit. Timings for each frame are
+// recorded, including an estimate of the time from input being sampled to it being shown.
+//
+// The pacer only deals with times, so it runs on any clock. The platform wait is passed in.
+
+#pragma once
+
+#include "Clock.h"
+
+#include <cstdint>
+#include <functional>
+
+struct FramePacerSettings
+{
+	unsigned int maxFrameLatency = 2;	// Frames that can be queued for presentation
+	bool vsync = true;
+	bool allowTearing = true;			// Used when vsync is off, if the display supports it
+	double frameLimitHz = 0.0;			// CPU frame limit, 0 for none
+};
+
+// Timings for one frame, in nanoseconds
+struct FrameTiming
+{
+	uint64_t frameIndex;
+	int64_t frameStart;			// When the wait and limiter finished and input was sampled
+	int64_t latencyWait;		// Spent waiting for the swap chain
+	int64_t limiterWait;		// Spent in the frame limiter
+	int64_t cpuTime;			// Frame start to present
+	int64_t presentInterval;	// Since the previous present
+	int64_t inputLatency;		// Estimated input sample to display
+};
+
+class FramePacer
+{
+public:
+	// Blocks until the swap chain is ready for another frame
+	typedef std::function<void()> WaitFunc;
+
+	explicit FramePacer(IClock* clock);
+
+	void SetSettings(const FramePacerSettings& settings);
+	const FramePacerSettings& GetSettings() const { return mSettings; }
+
+	// Used at the start of each frame. Without one the pacer only applies the frame limit.
+	void SetLatencyWait(WaitFunc wait) { mLatencyWait = wait; }
+
+	// Call before sampling input for the frame. Waits for the swap chain and the frame limiter.
+	void BeginFrame();
+
+	// Call straight after presenting, with the number of frames queued ahead of this one
+	// on the GPU (including this one)
+	void EndFrame(unsigned int queuedFrames);
+
+	// Present parameters for the settings. Tearing also needs the display to support it.
+	unsigned int GetSyncInterval() const { return mSettings.vsync ? 1 : 0; }
+	bool ShouldAllowTearing(bool tearingSupported) const { return !mSettings.vsync && mSettings.allowTearing && tearingSupported; }
+
+	// Getters
+	const FrameTiming& GetLastFrame() const { return mLastFrame; }
+	int64_t GetAverageInputLatency() const { return mAverageInputLatency; }
+	int64_t GetAveragePresentInterval() const { return mAveragePresentInterval; }
+
+private:
+	IClock* mClock;
+	FramePacerSettings mSettings;
+	WaitFunc mLatencyWait;
+
+	uint64_t mFrameIndex;
+	int64_t mNextFrameTime;		// Earliest the next frame may start, with the limiter on
+	int64_t mLastPresentTime;
+	FrameTiming mCurrentFrame;
+	FrameTiming mLastFrame;
+
+	// Exponential moving averages
+	int64_t mAverageInputLatency;
+	int64_t mAveragePresentInterval;
+};
@@ -0,0 +1,313 @@
+#include "FrameStats.h"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace
+{
+	// Index of the highest set bit. Value must not be 0.
+	unsigned int HighestBit(uint64_t value)
+	{
+#if defined(_MSC_VER)
+		unsigned long index;
+		_BitScanReverse64(&index, value);
+		return static_cast<unsigned int>(index);
+#else
+		return 63 - static_cast<unsigned int>(__builtin_clzll(value));
+#endif
+	}
+
+	double ToMilliseconds(uint64_t nanoseconds)
+	{
+		return static_cast<double>(nanoseconds) / 1000000.0;
+	}
+
+	const double SummaryPercentiles[] = { 50.0, 90.0, 99.0, 99.9 };
+}
+
+const unsigned int LogHistogram::SubBucketBits;
+const unsigned int LogHistogram::SubBucketCount;
+const unsigned int LogHistogram::BucketCount;
+const unsigned int FrameStats::FramesPerSlice;
+const unsigned int FrameStats::SliceCount;
+
+LogHistogram::LogHistogram()
+{
+	Clear();
+}
+
+void LogHistogram::Record(uint64_t value)
+{
+	mBuckets[GetBucketIndex(value)]++;
+	mCount++;
+	if (value > mMax)
+	{
+		mMax = value;
+	}
+}
+
+void LogHistogram::Add(const LogHistogram& other)
+{
+	for (unsigned int i = 0; i < BucketCount; i++)
+	{
+		mBuckets[i] += other.mBuckets[i];
+	}
+	mCount += other.mCount;
+	if (other.mMax > mMax)
+	{
+		mMax = other.mMax;
+	}
+}
+
+void LogHistogram::Clear()
+{
+	memset(mBuckets, 0, sizeof(mBuckets));
+	mCount = 0;
+	mMax = 0;
+}
+
+// Returns the upper bound of the bucket holding the given percentile (0-100), capped at the max
+uint64_t LogHistogram::GetValueAtPercentile(double percentile) const
+{
+	if (mCount == 0)
+	{
+		return 0;
+	}
+
+	// The rank of the value we want, counting from 1
+	uint64_t rank = static_cast<uint64_t>(percentile / 100.0 * static_cast<double>(mCount) + 0.5);
+	if (rank < 1)
+	{
+		rank = 1;
+	}
+
+	uint64_t seen = 0;
+	for (unsigned int i = 0; i < BucketCount; i++)
+	{
+		seen += mBuckets[i];
+		if (seen >= rank)
+		{
+			const uint64_t upper = GetBucketUpperBound(i);
+			return upper < mMax ? upper : mMax;
+		}
+	}
+	return mMax;
+}
+
+// Values below SubBucketCount get a bucket each. Above that, each power of two is split into
+// SubBucketCount buckets using the bits below the highest set bit.
+unsigned int LogHistogram::GetBucketIndex(uint64_t value)
+{
+	if (value < SubBucketCount)
+	{
+		return static_cast<unsigned int>(value);
+	}
+
+	const unsigned int shift = HighestBit(value) - SubBucketBits;
+	const unsigned int subBucket = static_cast<unsigned int>(value >> shift) - SubBucketCount;
+	return SubBucketCount + shift * SubBucketCount + subBucket;
+}
+
+uint64_t LogHistogram::GetBucketLowerBound(unsigned int bucket)
+{
+	if (bucket < SubBucketCount)
+	{
+		return bucket;
+	}
+
+	const unsigned int shift = (bucket - SubBucketCount) / SubBucketCount;
+	const uint64_t subBucket = (bucket - SubBucketCount) % SubBucketCount;
+	return (SubBucketCount + subBucket) << shift;
+}
+
+// Inclusive
+uint64_t LogHistogram::GetBucketUpperBound(unsigned int bucket)
+{
+	if (bucket < SubBucketCount)
+	{
+		return bucket;
+	}
+
+	const unsigned int shift = (bucket - SubBucketCount) / SubBucketCount;
+	return GetBucketLowerBound(bucket) + ((1ull << shift) - 1);
+}
+
+FrameStats::FrameStats() :
+	mCurrentSlice(0),
+	mFramesInSlice(0),
+	mFrameCount(0)
+{
+}
+
+// Times are in nanoseconds. Stats without a time this frame can be skipped.
+void FrameStats::Record(EFrameStat stat, int64_t time)
+{
+	const uint64_t value = time > 0 ? static_cast<uint64_t>(time) : 0;
+	mSlices[stat][mCurrentSlice].Record(value);
+	mTotals[stat].Record(value);
+}
+
+// Moves the sliding window on once enough frames have ended
+void FrameStats::EndFrame()
+{
+	mFrameCount++;
+	mFramesInSlice++;
+	if (mFramesInSlice < FramesPerSlice)
+	{
+		return;
+	}
+
+	// Reuse the oldest slice
+	mFramesInSlice = 0;
+	mCurrentSlice = (mCurrentSlice + 1) % SliceCount;
+	for (unsigned int stat = 0; stat < NumFrameStats; stat++)
+	{
+		mSlices[stat][mCurrentSlice].Clear();
+	}
+}
+
+// Clears all recorded frames, e.g. after a warm-up
+void FrameStats::Reset()
+{
+	for (unsigned int stat = 0; stat < NumFrameStats; stat++)
+	{
+		for (unsigned int slice = 0; slice < SliceCount; slice++)
+		{
+			mSlices[stat][slice].Clear();
+		}
+		mTotals[stat].Clear();
+	}
+	mCurrentSlice = 0;
+	mFramesInSlice = 0;
+	mFrameCount = 0;
+}
+
+FrameStatsSummary FrameStats::GetWindowSummary(EFrameStat stat) const
+{
+	LogHistogram window;
+	for (unsigned int slice = 0; slice < SliceCount; slice++)
+	{
+		window.Add(mSlices[stat][slice]);
+	}
+	return Summarise(window);
+}
+
+// Since the start
+FrameStatsSummary FrameStats::GetTotalSummary(EFrameStat stat) const
+{
+	return Summarise(mTotals[stat]);
+}
+
+// One line summary of the window, for the title bar. Written into the buffer, so it can be
+// called every frame without allocating.
+void FrameStats::FormatWindowSummary(char* buffer, size_t bufferSize) const
+{
+	size_t length = 0;
+	buffer[0] = '\0';
+	for (unsigned int stat = 0; stat < NumFrameStats && length < bufferSize; stat++)
+	{
+		const FrameStatsSummary summary = GetWindowSummary(static_cast<EFrameStat>(stat));
+		if (summary.count == 0)
+		{
+			continue;
+		}
+
+		const int written = snprintf(buffer + length, bufferSize - length, "%s%s %.2f/%.2f/%.2f/%.2f max %.2f",
+			length == 0 ? "" : " | ", GetStatName(static_cast<EFrameStat>(stat)),
+			summary.p50, summary.p90, summary.p99, summary.p999, summary.max);
+		length = written > 0 ? (std::min)(length + written, bufferSize - 1) : length;
+	}
+
+	if (length > 0 && length < bufferSize - 1)
+	{
+		snprintf(buffer + length, bufferSize - length, " ms (p50/p90/p99/p99.9)");
+	}
+}
+
+// Writes totals for the whole run: the percentiles and the non-empty histogram buckets
+bool FrameStats::WriteCsv(FILE* file) const
+{
+	fprintf(file, "stat,count,p50_ms,p90_ms,p99_ms,p99.9_ms,max_ms\n");
+	for (unsigned int stat = 0; stat < NumFrameStats; stat++)
+	{
+		const FrameStatsSummary summary = GetTotalSummary(static_cast<EFrameStat>(stat));
+		fprintf(file, "%s,%llu,%.4f,%.4f,%.4f,%.4f,%.4f\n", GetStatName(static_cast<EFrameStat>(stat)),
+			static_cast<unsigned long long>(summary.count), summary.p50, summary.p90, summary.p99, summary.p999, summary.max);
+	}
+
+	fprintf(file, "\nstat,bucket_min_ms,bucket_max_ms,count\n");
+	for (unsigned int stat = 0; stat < NumFrameStats; stat++)
+	{
+		const LogHistogram& histogram = mTotals[stat];
+		for (unsigned int bucket = 0; bucket < LogHistogram::BucketCount; bucket++)
+		{
+			if (histogram.GetBucketCount(bucket) > 0)
+			{
+				fprintf(file, "%s,%.4f,%.4f,%u\n", GetStatName(static_cast<EFrameStat>(stat)),
+					ToMilliseconds(LogHistogram::GetBucketLowerBound(bucket)),
+					ToMilliseconds(LogHistogram::GetBucketUpperBound(bucket)),
+					histogram.GetBucketCount(bucket));
+			}
+		}
+	}
+	return ferror(file) == 0;
+}
+
+bool FrameStats::WriteJson(FILE* file) const
+{
+	fprintf(file, "{\n  \"frames\": %llu,\n  \"stats\": {", static_cast<unsigned long long>(mFrameCount));
+	for (unsigned int stat = 0; stat < NumFrameStats; stat++)
+	{
+		const FrameStatsSummary summary = GetTotalSummary(static_cast<EFrameStat>(stat));
+		fprintf(file, "%s\n    \"%s\": {\n", stat == 0 ? "" : ",", GetStatName(static_cast<EFrameStat>(stat)));
+		fprintf(file, "      \"count\": %llu,\n", static_cast<unsigned long long>(summary.count));
+		fprintf(file, "      \"p50_ms\": %.4f, \"p90_ms\": %.4f, \"p99_ms\": %.4f, \"p99.9_ms\": %.4f, \"max_ms\": %.4f,\n",
+			summary.p50, summary.p90, summary.p99, summary.p999, summary.max);
+
+		// Buckets as [min ms, max ms, count]
+		fprintf(file, "      \"buckets\": [");
+		const LogHistogram& histogram = mTotals[stat];
+		bool first = true;
+		for (unsigned int bucket = 0; bucket < LogHistogram::BucketCount; bucket++)
+		{
+			if (histogram.GetBucketCount(bucket) > 0)
+			{
+				fprintf(file, "%s[%.4f, %.4f, %u]", first ? "" : ", ",
+					ToMilliseconds(LogHistogram::GetBucketLowerBound(bucket)),
+					ToMilliseconds(LogHistogram::GetBucketUpperBound(bucket)),
+					histogram.GetBucketCount(bucket));
+				first = false;
+			}
+		}
+		fprintf(file, "]\n    }");
+	}
+	fprintf(file, "\n  }\n}\n");
+	return ferror(file) == 0;
+}
+
+const char* FrameStats::GetStatName(EFrameStat stat)
+{
+	switch (stat)
+	{
+	case FrameStat_Cpu: return "cpu";
+	case FrameStat_Gpu: return "gpu";
+	case FrameStat_Present: return "present";
+	default: return "unknown";
+	}
+}
+
+FrameStatsSummary FrameStats::Summarise(const LogHistogram& histogram)
+{
+	FrameStatsSummary summary = {};
+	summary.count = histogram.GetCount();
+	summary.p50 = ToMilliseconds(histogram.GetValueAtPercentile(SummaryPercentiles[0]));
+	summary.p90 = ToMilliseconds(histogram.GetValueAtPercentile(SummaryPercentiles[1]));
+	summary.p99 = ToMilliseconds(histogram.GetValueAtPercentile(SummaryPercentiles[2]));
+	summary.p999 = ToMilliseconds(histogram.GetValueAtPercentile(SummaryPercentiles[3]));
+	summary.max = ToMilliseconds(histogram.GetMax());
+	return summary;
+}
@@ -0,0 +1,104 @@
+// Frame statistics
+// Frame times go into log-bucketed histograms (in the style of HdrHistogram): each power of two
+// range is split into 16 linear buckets, so any value is stored to within about 6% using a
+// fixed amount of memory. Recording a time is a bucket lookup and an increment.
+//
+// For a sliding window, each stat has a ring of histograms that each cover a slice of frames.
+// Percentiles for the window are read from the sum of the slices.
+
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+
+class LogHistogram
+{
+public:
+	static const unsigned int SubBucketBits = 4;
+	static const unsigned int SubBucketCount = 1 << SubBucketBits;
+	static const unsigned int BucketCount = SubBucketCount + (64 - SubBucketBits) * SubBucketCount;
+
+	LogHistogram();
+
+	void Record(uint64_t value);
+	void Add(const LogHistogram& other);
+	void Clear();
+
+	// Returns the upper bound of the bucket holding the given percentile (0-100), capped at the max
+	uint64_t GetValueAtPercentile(double percentile) const;
+
+	// Getters
+	uint64_t GetCount() const { return mCount; }
+	uint64_t GetMax() const { return mMax; }
+	uint32_t GetBucketCount(unsigned int bucket) const { return mBuckets[bucket]; }
+
+	// Bucket layout
+	static unsigned int GetBucketIndex(uint64_t value);
+	static uint64_t GetBucketLowerBound(unsigned int bucket);
+	static uint64_t GetBucketUpperBound(unsigned int bucket);	// Inclusive
+
+private:
+	uint32_t mBuckets[BucketCount];
+	uint64_t mCount;
+	uint64_t mMax;
+};
+
+enum EFrameStat
+{
+	FrameStat_Cpu,			// CPU time from frame start to present
+	FrameStat_Gpu,			// GPU time for the frame's command lists
+	FrameStat_Present,		// Time between presents
+	NumFrameStats
+};
+
+// Percentiles of a stat, in milliseconds
+struct FrameStatsSummary
+{
+	uint64_t count;
+	double p50;
+	double p90;
+	double p99;
+	double p999;
+	double max;
+};
+
+class FrameStats
+{
+public:
+	static const unsigned int FramesPerSlice = 120;
+	static const unsigned int SliceCount = 8;	// Window of about 1000 frames
+
+	FrameStats();
+
+	// Times are in nanoseconds. Stats without a time this frame can be skipped.
+	void Record(EFrameStat stat, int64_t time);
+
+	// Moves the sliding window on once enough frames have ended
+	void EndFrame();
+
+	// Clears all recorded frames, e.g. after a warm-up
+	void Reset();
+
+	FrameStatsSummary GetWindowSummary(EFrameStat stat) const;
+	FrameStatsSummary GetTotalSummary(EFrameStat stat) const;	// Since the start
+	uint64_t GetFrameCount() const { return mFrameCount; }
+
+	// One line summary of the window, for the title bar. Written into the buffer, so it can be
+	// called every frame without allocating.
+	void FormatWindowSummary(char* buffer, size_t bufferSize) const;
+
+	// Writes totals for the whole run: the percentiles and the non-empty histogram buckets
+	bool WriteCsv(FILE* file) const;
+	bool WriteJson(FILE* file) const;
+
+	static const char* GetStatName(EFrameStat stat);
+
+private:
+	static FrameStatsSummary Summarise(const LogHistogram& histogram);
+
+	LogHistogram mSlices[NumFrameStats][SliceCount];
+	LogHistogram mTotals[NumFrameStats];
+	unsigned int mCurrentSlice;
+	unsigned int mFramesInSlice;
+	uint64_t mFrameCount;
+};
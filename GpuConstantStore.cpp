@@ -0,0 +1,153 @@
+#include "GpuConstantStore.h"
+
+#include <cstring>
+
+const UINT64 GpuConstantStore::MinBufferSize;
+const UINT64 GpuConstantStore::MinUploadSize;
+
+// The buffer is allocated from bufferAllocator, which must be for the default heap and not be
+// defragmented, and its state tracked in resourceStates
+GpuConstantStore::GpuConstantStore(GpuMemoryAllocator* bufferAllocator, GpuMemoryAllocator* uploadAllocator, GlobalResourceStates* resourceStates) :
+	mBufferAllocator(bufferAllocator),
+	mUploadAllocator(uploadAllocator),
+	mResourceStates(resourceStates),
+	mBuffer(GpuMemoryAllocator::InvalidHandle),
+	mBufferSize(0),
+	mBufferLastUsed(0),
+	mLastStats(),
+	mTotalUploadedBytes(0)
+{
+}
+
+// The GPU must have finished with the buffer and the uploads
+GpuConstantStore::~GpuConstantStore()
+{
+	GpuMemoryAllocator* uploadAllocator = mUploadAllocator;
+	mUploadBuffers.Clear([uploadAllocator](GpuMemoryAllocator::Handle handle)
+	{
+		uploadAllocator->Free(handle);
+	});
+
+	for (const RetiredBuffer& retired : mRetiredBuffers)
+	{
+		mBufferAllocator->Free(retired.buffer);
+	}
+
+	if (mBuffer != GpuMemoryAllocator::InvalidHandle)
+	{
+		mResourceStates->Unregister(GetBuffer());
+		mBufferAllocator->Free(mBuffer);
+	}
+}
+
+// Call once each frame the buffer is used, before recording. Grows the buffer to fit the store,
+// marking the whole store dirty if it's recreated, and records that fenceValue's frame uses it.
+// Buffers it has outgrown are freed once completedFenceValue passes their last frame.
+void GpuConstantStore::Prepare(ConstantStore& store, UINT64 fenceValue, UINT64 completedFenceValue)
+{
+	mLastStats = Stats();
+
+	// Buffers are retired in fence order
+	size_t freed = 0;
+	while (freed < mRetiredBuffers.size() && mRetiredBuffers[freed].fenceValue <= completedFenceValue)
+	{
+		mBufferAllocator->Free(mRetiredBuffers[freed].buffer);
+		freed++;
+	}
+	mRetiredBuffers.erase(mRetiredBuffers.begin(), mRetiredBuffers.begin() + freed);
+
+	const UINT64 requiredSize = static_cast<UINT64>(store.GetObjectCount()) * store.GetObjectSize();
+	if (requiredSize > mBufferSize)
+	{
+		// The old buffer is kept until frames still using it have finished. Its state is no
+		// longer tracked, as its placed memory may be reused by a new resource.
+		if (mBuffer != GpuMemoryAllocator::InvalidHandle)
+		{
+			mResourceStates->Unregister(GetBuffer());
+			RetiredBuffer retired = { mBufferLastUsed, mBuffer };
+			mRetiredBuffers.push_back(retired);
+		}
+
+		UINT64 size = MinBufferSize;
+		while (size < requiredSize)
+		{
+			size *= 2;
+		}
+
+		mBuffer = mBufferAllocator->Allocate(size, D3D12_RESOURCE_STATE_COPY_DEST);
+		mBufferSize = size;
+		GetBuffer()->SetName(L"ConstantStore");
+		mResourceStates->Register(GetBuffer(), D3D12_RESOURCE_STATE_COPY_DEST);
+
+		store.MarkAllDirty();
+	}
+
+	if (mBuffer != GpuMemoryAllocator::InvalidHandle)
+	{
+		mBufferLastUsed = fenceValue;
+	}
+}
+
+// Records the copies of the store's dirty ranges, and clears them. The buffer must be in the
+// COPY_DEST state. fenceValue is the value the queue signals after the list is submitted.
+void GpuConstantStore::RecordUpload(ID3D12GraphicsCommandList* commandList, ConstantStore& store, UINT64 fenceValue, UINT64 completedFenceValue)
+{
+	mLastStats.dirtyObjectCount = store.GetDirtyCount();
+
+	const UINT64 uploadSize = store.CollectDirtyRanges(mRanges);
+	if (uploadSize == 0)
+	{
+		return;
+	}
+
+	// An upload buffer whose last frame has finished, swapped for a bigger one if this frame's ranges don't fit
+	GpuMemoryAllocator* uploadAllocator = mUploadAllocator;
+	auto allocate = [uploadAllocator, uploadSize]()
+	{
+		UINT64 size = MinUploadSize;
+		while (size < uploadSize)
+		{
+			size *= 2;
+		}
+		return uploadAllocator->Allocate(size, D3D12_RESOURCE_STATE_GENERIC_READ);
+	};
+
+	GpuMemoryAllocator::Handle upload = mUploadBuffers.Acquire(completedFenceValue, allocate);
+	if (mUploadAllocator->GetSize(upload) < uploadSize)
+	{
+		mUploadAllocator->Free(upload);
+		upload = allocate();
+	}
+
+	// Ranges are packed one after another in the upload buffer
+	ID3D12Resource* buffer = GetBuffer();
+	ID3D12Resource* uploadResource = mUploadAllocator->GetResource(upload);
+	const UINT64 uploadBase = mUploadAllocator->GetOffset(upload);
+	UINT8* uploadData = static_cast<UINT8*>(mUploadAllocator->GetCpuAddress(upload));
+	const UINT64 objectSize = store.GetObjectSize();
+
+	UINT64 uploadOffset = 0;
+	for (const ConstantStore::Range& range : mRanges)
+	{
+		const UINT64 rangeSize = range.count * objectSize;
+		memcpy(uploadData + uploadOffset, store.GetObject(range.first), static_cast<size_t>(rangeSize));
+		commandList->CopyBufferRegion(buffer, range.first * objectSize, uploadResource, uploadBase + uploadOffset, rangeSize);
+		uploadOffset += rangeSize;
+	}
+
+	mUploadBuffers.Release(upload, fenceValue);
+
+	mLastStats.uploadedBytes = uploadSize;
+	mLastStats.copyCount = static_cast<UINT>(mRanges.size());
+	mTotalUploadedBytes += uploadSize;
+}
+
+ID3D12Resource* GpuConstantStore::GetBuffer() const
+{
+	return mBuffer != GpuMemoryAllocator::InvalidHandle ? mBufferAllocator->GetResource(mBuffer) : nullptr;
+}
+
+D3D12_GPU_VIRTUAL_ADDRESS GpuConstantStore::GetGpuAddress() const
+{
+	return mBuffer != GpuMemoryAllocator::InvalidHandle ? mBufferAllocator->GetGpuAddress(mBuffer) : 0;
+}
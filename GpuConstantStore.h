@@ -0,0 +1,78 @@
+// GPU constant store
+// The GPU copy of a ConstantStore: a default heap buffer, placed by a GpuMemoryAllocator, that
+// shaders read as a structured buffer of the store's objects. Each frame only the dirty ranges
+// are written, packed together, to an upload buffer and copied across with one CopyBufferRegion
+// each, so a frame where nothing changed uploads nothing. Upload buffers are recycled once the
+// GPU has finished the frame using them.
+
+#pragma once
+
+#include "DXSampleHelper.h"
+#include "ConstantStore.h"
+#include "FencedPool.h"
+#include "GpuMemoryAllocator.h"
+#include "ResourceStateTracker.h"
+
+#include <vector>
+
+class GpuConstantStore
+{
+public:
+	struct Stats
+	{
+		UINT64 uploadedBytes;
+		UINT copyCount;				// One per coalesced range
+		UINT dirtyObjectCount;
+	};
+
+	// The buffer is allocated from bufferAllocator, which must be for the default heap and not be
+	// defragmented, and its state tracked in resourceStates
+	GpuConstantStore(GpuMemoryAllocator* bufferAllocator, GpuMemoryAllocator* uploadAllocator, GlobalResourceStates* resourceStates);
+
+	// Prohibit copying
+	GpuConstantStore(const GpuConstantStore& rhs) = delete;
+	GpuConstantStore& operator=(const GpuConstantStore& rhs) = delete;
+
+	// The GPU must have finished with the buffer and the uploads
+	~GpuConstantStore();
+
+	// Call once each frame the buffer is used, before recording. Grows the buffer to fit the store,
+	// marking the whole store dirty if it's recreated, and records that fenceValue's frame uses it.
+	// Buffers it has outgrown are freed once completedFenceValue passes their last frame.
+	void Prepare(ConstantStore& store, UINT64 fenceValue, UINT64 completedFenceValue);
+
+	// Records the copies of the store's dirty ranges, and clears them. The buffer must be in the
+	// COPY_DEST state. fenceValue is the value the queue signals after the list is submitted.
+	void RecordUpload(ID3D12GraphicsCommandList* commandList, ConstantStore& store, UINT64 fenceValue, UINT64 completedFenceValue);
+
+	// Getters
+	ID3D12Resource* GetBuffer() const;
+	D3D12_GPU_VIRTUAL_ADDRESS GetGpuAddress() const;
+	const Stats& GetLastStats() const { return mLastStats; }
+	UINT64 GetTotalUploadedBytes() const { return mTotalUploadedBytes; }
+
+private:
+	static const UINT64 MinBufferSize = 64 * 1024;
+	static const UINT64 MinUploadSize = 64 * 1024;
+
+	// A buffer that has been outgrown, waiting for the GPU to finish its last frame
+	struct RetiredBuffer
+	{
+		UINT64 fenceValue;
+		GpuMemoryAllocator::Handle buffer;
+	};
+
+	GpuMemoryAllocator* mBufferAllocator;
+	GpuMemoryAllocator* mUploadAllocator;
+	GlobalResourceStates* mResourceStates;
+
+	GpuMemoryAllocator::Handle mBuffer;
+	UINT64 mBufferSize;
+	UINT64 mBufferLastUsed;
+	std::vector<RetiredBuffer> mRetiredBuffers;
+
+	FencedPool<GpuMemoryAllocator::Handle> mUploadBuffers;
+	std::vector<ConstantStore::Range> mRanges;
+	Stats mLastStats;
+	UINT64 mTotalUploadedBytes;
+};
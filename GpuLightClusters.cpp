@@ -0,0 +1,96 @@
+#include "GpuLightClusters.h"
+
+#include <algorithm>
+#include <cstring>
+
+const UINT64 GpuLightClusters::MinBufferSize;
+const UINT64 GpuLightClusters::SectionAlignment;
+
+namespace
+{
+	UINT64 AlignUp(UINT64 value, UINT64 alignment)
+	{
+		return (value + alignment - 1) & ~(alignment - 1);
+	}
+}
+
+GpuLightClusters::GpuLightClusters(GpuMemoryAllocator* uploadAllocator) :
+	mUploadAllocator(uploadAllocator),
+	mBuffer(GpuMemoryAllocator::InvalidHandle),
+	mClusterRangesOffset(0),
+	mLightIndicesOffset(0)
+{
+}
+
+// The GPU must have finished with the uploads
+GpuLightClusters::~GpuLightClusters()
+{
+	GpuMemoryAllocator* uploadAllocator = mUploadAllocator;
+	mUploadBuffers.Clear([uploadAllocator](GpuMemoryAllocator::Handle handle)
+	{
+		uploadAllocator->Free(handle);
+	});
+}
+
+// Copies the lights, then the clusters' ranges and light indices, to an upload buffer for the
+// frame that signals fenceValue. The addresses are valid until the next upload.
+void GpuLightClusters::Upload(const ClusteredLight* lights, uint32_t lightCount, const LightClusters& clusters, UINT64 fenceValue, UINT64 completedFenceValue)
+{
+	// Each part starts aligned, and is at least one element long so there's always something to bind
+	const UINT64 lightsSize = static_cast<UINT64>((std::max)(lightCount, 1u)) * sizeof(ClusteredLight);
+	const UINT64 rangesSize = static_cast<UINT64>(clusters.GetClusterCount()) * 2 * sizeof(uint32_t);
+	const UINT64 indicesSize = static_cast<UINT64>((std::max)(clusters.GetLightIndexCount(), 1u)) * sizeof(uint32_t);
+	const UINT64 rangesOffset = AlignUp(lightsSize, SectionAlignment);
+	const UINT64 indicesOffset = AlignUp(rangesOffset + rangesSize, SectionAlignment);
+	const UINT64 uploadSize = indicesOffset + indicesSize;
+
+	// A buffer whose last frame has finished, swapped for a bigger one if this frame's lights don't fit
+	GpuMemoryAllocator* uploadAllocator = mUploadAllocator;
+	auto allocate = [uploadAllocator, uploadSize]()
+	{
+		UINT64 size = MinBufferSize;
+		while (size < uploadSize)
+		{
+			size *= 2;
+		}
+		return uploadAllocator->Allocate(size, D3D12_RESOURCE_STATE_GENERIC_READ);
+	};
+
+	GpuMemoryAllocator::Handle upload = mUploadBuffers.Acquire(completedFenceValue, allocate);
+	if (mUploadAllocator->GetSize(upload) < uploadSize)
+	{
+		mUploadAllocator->Free(upload);
+		upload = allocate();
+	}
+
+	UINT8* uploadData = static_cast<UINT8*>(mUploadAllocator->GetCpuAddress(upload));
+	if (lightCount > 0)
+	{
+		memcpy(uploadData, lights, lightCount * sizeof(ClusteredLight));
+	}
+	memcpy(uploadData + rangesOffset, clusters.GetClusterRanges(), static_cast<size_t>(rangesSize));
+	if (clusters.GetLightIndexCount() > 0)
+	{
+		memcpy(uploadData + indicesOffset, clusters.GetLightIndices(), clusters.GetLightIndexCount() * sizeof(uint32_t));
+	}
+
+	mBuffer = upload;
+	mClusterRangesOffset = rangesOffset;
+	mLightIndicesOffset = indicesOffset;
+	mUploadBuffers.Release(upload, fenceValue);
+}
+
+D3D12_GPU_VIRTUAL_ADDRESS GpuLightClusters::GetLightsAddress() const
+{
+	return mBuffer != GpuMemoryAllocator::InvalidHandle ? mUploadAllocator->GetGpuAddress(mBuffer) : 0;
+}
+
+D3D12_GPU_VIRTUAL_ADDRESS GpuLightClusters::GetClusterRangesAddress() const
+{
+	return mBuffer != GpuMemoryAllocator::InvalidHandle ? mUploadAllocator->GetGpuAddress(mBuffer) + mClusterRangesOffset : 0;
+}
+
+D3D12_GPU_VIRTUAL_ADDRESS GpuLightClusters::GetLightIndicesAddress() const
+{
+	return mBuffer != GpuMemoryAllocator::InvalidHandle ? mUploadAllocator->GetGpuAddress(mBuffer) + mLightIndicesOffset : 0;
+}
@@ -0,0 +1,46 @@
+// GPU light clusters
+// Each frame's lights and cluster light lists, written to an upload buffer for shaders to read as
+// structured buffers. Everything changes with the camera, so nothing is worth keeping in a default
+// heap buffer: the shader reads upload memory directly, once per lit pixel. Upload buffers are
+// recycled once the GPU has finished the frame using them.
+
+#pragma once
+
+#include "DXSampleHelper.h"
+#include "FencedPool.h"
+#include "GpuMemoryAllocator.h"
+#include "LightClusters.h"
+
+class GpuLightClusters
+{
+public:
+	explicit GpuLightClusters(GpuMemoryAllocator* uploadAllocator);
+
+	// Prohibit copying
+	GpuLightClusters(const GpuLightClusters& rhs) = delete;
+	GpuLightClusters& operator=(const GpuLightClusters& rhs) = delete;
+
+	// The GPU must have finished with the uploads
+	~GpuLightClusters();
+
+	// Copies the lights, then the clusters' ranges and light indices, to an upload buffer for the
+	// frame that signals fenceValue. The addresses are valid until the next upload.
+	void Upload(const ClusteredLight* lights, uint32_t lightCount, const LightClusters& clusters, UINT64 fenceValue, UINT64 completedFenceValue);
+
+	// Getters
+	D3D12_GPU_VIRTUAL_ADDRESS GetLightsAddress() const;
+	D3D12_GPU_VIRTUAL_ADDRESS GetClusterRangesAddress() const;
+	D3D12_GPU_VIRTUAL_ADDRESS GetLightIndicesAddress() const;
+
+private:
+	static const UINT64 MinBufferSize = 64 * 1024;
+	static const UINT64 SectionAlignment = 256;
+
+	GpuMemoryAllocator* mUploadAllocator;
+	FencedPool<GpuMemoryAllocator::Handle> mUploadBuffers;
+
+	// The last upload, with each part's offset into it
+	GpuMemoryAllocator::Handle mBuffer;
+	UINT64 mClusterRangesOffset;
+	UINT64 mLightIndicesOffset;
+};
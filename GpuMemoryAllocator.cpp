@@ -0,0 +1,509 @@
+#include "Includes.h"
+#include "GpuMemoryAllocator.h"
+
+#include <algorithm>
+
+const GpuMemoryAllocator::Handle GpuMemoryAllocator::InvalidHandle;
+
+namespace
+{
+	const UINT NoHeap = 0xFFFFFFFF;
+
+	UINT64 NextPowerOfTwo(UINT64 value)
+	{
+		UINT64 result = 1;
+		while (result < value)
+		{
+			result <<= 1;
+		}
+		return result;
+	}
+}
+
+GpuMemoryAllocator::GpuMemoryAllocator(ID3D12Device* device, D3D12_HEAP_TYPE heapType, UINT64 heapSize) :
+	mDevice(device),
+	mHeapType(heapType),
+	mHeapSize(NextPowerOfTwo(heapSize < SlabSize ? SlabSize : heapSize)),
+	mCpuVisible(heapType == D3D12_HEAP_TYPE_UPLOAD || heapType == D3D12_HEAP_TYPE_READBACK),
+	mDefragScheduled(false),
+	mRequestedBytes(0),
+	mSmallAllocationCount(0),
+	mDefragMoves(0),
+	mDefragBytesMoved(0),
+	mHeapsReleased(0)
+{
+}
+
+GpuMemoryAllocator::~GpuMemoryAllocator()
+{
+}
+
+// Upload heaps must use GENERIC_READ and readback heaps COPY_DEST
+GpuMemoryAllocator::Handle GpuMemoryAllocator::Allocate(UINT64 size, D3D12_RESOURCE_STATES initialState)
+{
+	if (size == 0)
+	{
+		return InvalidHandle;
+	}
+
+	Allocation allocation = {};
+	allocation.used = true;
+	allocation.size = size;
+
+	if (mCpuVisible && size <= (MinSmallSize << (NumSizeClasses - 1)))
+	{
+		// Take a slot from a slab of this size class, making a new slab if they're all full
+		int sizeClass = 0;
+		UINT64 classSize = MinSmallSize;
+		while (classSize < size)
+		{
+			classSize <<= 1;
+			sizeClass++;
+		}
+
+		std::vector<UINT>& partialSlabs = mPartialSlabs[sizeClass];
+		if (partialSlabs.empty())
+		{
+			partialSlabs.push_back(AllocateBlock(SlabSize, initialState, sizeClass));
+		}
+
+		const UINT blockIndex = partialSlabs.back();
+		Block& slab = mBlocks[blockIndex];
+		const UINT slot = slab.freeSlots.back();
+		slab.freeSlots.pop_back();
+		slab.usedSlots++;
+		if (slab.freeSlots.empty())
+		{
+			partialSlabs.pop_back();
+		}
+
+		allocation.block = blockIndex;
+		allocation.offset = slot * classSize;
+		mSmallAllocationCount++;
+	}
+	else
+	{
+		allocation.block = AllocateBlock(size, initialState, -1);
+		allocation.offset = 0;
+	}
+
+	mRequestedBytes += size;
+
+	Handle handle;
+	if (!mFreeHandles.empty())
+	{
+		handle = mFreeHandles.back();
+		mFreeHandles.pop_back();
+		mAllocations[handle] = allocation;
+	}
+	else
+	{
+		handle = static_cast<Handle>(mAllocations.size());
+		mAllocations.push_back(allocation);
+	}
+	return handle;
+}
+
+// The memory is reused straight away, so the GPU must have finished with the allocation
+void GpuMemoryAllocator::Free(Handle handle)
+{
+	if (handle >= mAllocations.size() || !mAllocations[handle].used)
+	{
+		return;
+	}
+
+	Allocation& allocation = mAllocations[handle];
+	Block& block = mBlocks[allocation.block];
+
+	if (block.sizeClass >= 0)
+	{
+		// Return the slot, and the slab itself once it's empty
+		std::vector<UINT>& partialSlabs = mPartialSlabs[block.sizeClass];
+		if (block.freeSlots.empty())
+		{
+			partialSlabs.push_back(allocation.block);
+		}
+
+		block.freeSlots.push_back(static_cast<UINT>(allocation.offset / (MinSmallSize << block.sizeClass)));
+		block.usedSlots--;
+		if (block.usedSlots == 0)
+		{
+			partialSlabs.erase(std::find(partialSlabs.begin(), partialSlabs.end(), allocation.block));
+			FreeBlock(allocation.block);
+		}
+		mSmallAllocationCount--;
+	}
+	else
+	{
+		FreeBlock(allocation.block);
+	}
+
+	mRequestedBytes -= allocation.size;
+	allocation.used = false;
+	mFreeHandles.push_back(handle);
+}
+
+ID3D12Resource* GpuMemoryAllocator::GetResource(Handle handle) const
+{
+	return mBlocks[mAllocations[handle].block].resource.Get();
+}
+
+// Offset of the allocation within its resource
+UINT64 GpuMemoryAllocator::GetOffset(Handle handle) const
+{
+	return mAllocations[handle].offset;
+}
+
+UINT64 GpuMemoryAllocator::GetSize(Handle handle) const
+{
+	return mAllocations[handle].size;
+}
+
+D3D12_GPU_VIRTUAL_ADDRESS GpuMemoryAllocator::GetGpuAddress(Handle handle) const
+{
+	const Allocation& allocation = mAllocations[handle];
+	return mBlocks[allocation.block].resource->GetGPUVirtualAddress() + allocation.offset;
+}
+
+// CPU pointer to the allocation, for upload and readback heaps (which are kept mapped)
+void* GpuMemoryAllocator::GetCpuAddress(Handle handle) const
+{
+	const Allocation& allocation = mAllocations[handle];
+	UINT8* mapped = mBlocks[allocation.block].mapped;
+	return mapped ? mapped + allocation.offset : nullptr;
+}
+
+GpuMemoryAllocator::Stats GpuMemoryAllocator::GetStats() const
+{
+	Stats stats = {};
+	UINT64 freeBytes = 0;
+
+	for (const Heap& heap : mHeaps)
+	{
+		if (!heap.heap)
+		{
+			continue;
+		}
+
+		const BuddyAllocator::Stats heapStats = heap.buddy->GetStats();
+		stats.heapCount++;
+		stats.heapBytes += heapStats.capacity;
+		stats.blockBytes += heapStats.allocatedBytes;
+		freeBytes += heapStats.freeBytes;
+		stats.largestFreeBlock = std::max(stats.largestFreeBlock, heapStats.largestFreeBlock);
+	}
+
+	for (const Block& block : mBlocks)
+	{
+		if (block.used && block.sizeClass >= 0)
+		{
+			stats.slabCount++;
+		}
+	}
+
+	stats.requestedBytes = mRequestedBytes;
+	stats.allocationCount = static_cast<UINT>(mAllocations.size() - mFreeHandles.size());
+	stats.smallAllocationCount = mSmallAllocationCount;
+	stats.fragmentation = freeBytes > 0 ?
+		1.0f - static_cast<float>(stats.largestFreeBlock) / static_cast<float>(freeBytes) : 0.0f;
+	stats.defragMoves = mDefragMoves;
+	stats.defragBytesMoved = mDefragBytesMoved;
+	stats.heapsReleased = mHeapsReleased;
+	return stats;
+}
+
+// Runs a scheduled defragment, recording any GPU copies on the command list. For upload heaps,
+// rewrite is called for each allocation that moved.
+// Moved-from resources and released heaps are kept until the fence reaches fenceValue.
+// Returns the number of resources moved.
+UINT GpuMemoryAllocator::RunScheduledDefragment(ID3D12GraphicsCommandList* commandList, UINT64 fenceValue, const RewriteFunc& rewrite)
+{
+	if (!mDefragScheduled)
+	{
+		return 0;
+	}
+	mDefragScheduled = false;
+
+	// Empty the least used heap, if the others have room for everything in it
+	UINT source = NoHeap;
+	UINT heapCount = 0;
+	UINT64 leastUsed = ~0ull;
+	for (UINT i = 0; i < mHeaps.size(); i++)
+	{
+		if (!mHeaps[i].heap)
+		{
+			continue;
+		}
+
+		heapCount++;
+		const UINT64 used = mHeaps[i].buddy->GetStats().allocatedBytes;
+		if (used < leastUsed)
+		{
+			leastUsed = used;
+			source = i;
+		}
+	}
+
+	if (heapCount < 2)
+	{
+		return 0;
+	}
+
+	std::vector<UINT> blocks;
+	for (UINT i = 0; i < mBlocks.size(); i++)
+	{
+		if (mBlocks[i].used && mBlocks[i].heap == source)
+		{
+			blocks.push_back(i);
+		}
+	}
+
+	// Place the largest blocks first so they pack best
+	std::sort(blocks.begin(), blocks.end(), [this](UINT a, UINT b) { return mBlocks[a].size > mBlocks[b].size; });
+
+	struct Move
+	{
+		UINT block;
+		UINT heap;
+		UINT64 heapOffset;
+	};
+	std::vector<Move> moves;
+
+	for (UINT blockIndex : blocks)
+	{
+		Move move = { blockIndex, NoHeap, 0 };
+		if (!PlaceBlock(mBlocks[blockIndex].size, source, &move.heap, &move.heapOffset))
+		{
+			// Doesn't all fit, so undo the placements and leave things as they are
+			for (const Move& placed : moves)
+			{
+				mHeaps[placed.heap].buddy->Free(placed.heapOffset);
+			}
+			return 0;
+		}
+		moves.push_back(move);
+	}
+
+	// Create the new resources and copy the contents across. Readback memory is cached, so is
+	// copied directly; default heap buffers are copied on the GPU. Upload memory is rewritten below.
+	std::vector<D3D12_RESOURCE_BARRIER> barriers;
+	std::vector<ComPtr<ID3D12Resource>> oldResources;
+	for (const Move& move : moves)
+	{
+		Block& block = mBlocks[move.block];
+		UINT8* mapped = nullptr;
+		ComPtr<ID3D12Resource> resource = CreatePlacedResource(move.heap, move.heapOffset, block.size,
+			mCpuVisible ? block.state : D3D12_RESOURCE_STATE_COPY_DEST, &mapped);
+
+		if (!mCpuVisible)
+		{
+			if (block.state != D3D12_RESOURCE_STATE_COPY_SOURCE)
+			{
+				barriers.push_back(CD3DX12_RESOURCE_BARRIER::Transition(block.resource.Get(), block.state, D3D12_RESOURCE_STATE_COPY_SOURCE));
+			}
+		}
+		else if (mHeapType == D3D12_HEAP_TYPE_READBACK)
+		{
+			memcpy(mapped, block.mapped, static_cast<size_t>(block.size));
+		}
+
+		oldResources.push_back(block.resource);
+		block.resource = resource;
+		block.mapped = mapped;
+		block.heap = move.heap;
+		block.heapOffset = move.heapOffset;
+
+		mDefragMoves++;
+		mDefragBytesMoved += block.size;
+	}
+
+	if (!mCpuVisible)
+	{
+		if (!barriers.empty())
+		{
+			commandList->ResourceBarrier(static_cast<UINT>(barriers.size()), barriers.data());
+			barriers.clear();
+		}
+
+		for (size_t i = 0; i < moves.size(); i++)
+		{
+			const Block& block = mBlocks[moves[i].block];
+			commandList->CopyBufferRegion(block.resource.Get(), 0, oldResources[i].Get(), 0, block.size);
+			if (block.state != D3D12_RESOURCE_STATE_COPY_DEST)
+			{
+				barriers.push_back(CD3DX12_RESOURCE_BARRIER::Transition(block.resource.Get(), D3D12_RESOURCE_STATE_COPY_DEST, block.state));
+			}
+		}
+
+		if (!barriers.empty())
+		{
+			commandList->ResourceBarrier(static_cast<UINT>(barriers.size()), barriers.data());
+		}
+	}
+	else if (mHeapType == D3D12_HEAP_TYPE_UPLOAD && rewrite)
+	{
+		std::vector<bool> moved(mBlocks.size(), false);
+		for (const Move& move : moves)
+		{
+			moved[move.block] = true;
+		}
+
+		for (Handle handle = 0; handle < mAllocations.size(); handle++)
+		{
+			const Allocation& allocation = mAllocations[handle];
+			if (allocation.used && moved[allocation.block])
+			{
+				rewrite(handle, mBlocks[allocation.block].mapped + allocation.offset);
+			}
+		}
+	}
+
+	// The GPU may still be using the old memory, so hold on to it until the fence passes
+	for (ComPtr<ID3D12Resource>& resource : oldResources)
+	{
+		PendingRelease release = { fenceValue, resource, nullptr };
+		mPendingReleases.push_back(release);
+	}
+
+	PendingRelease heapRelease = { fenceValue, nullptr, mHeaps[source].heap };
+	mPendingReleases.push_back(heapRelease);
+	mHeaps[source].heap.Reset();
+	mHeaps[source].buddy.reset();
+	mHeapsReleased++;
+
+	return static_cast<UINT>(moves.size());
+}
+
+// Releases memory kept alive by defragmenting once the GPU has passed its fence value
+void GpuMemoryAllocator::ReleaseCompleted(UINT64 completedFenceValue)
+{
+	mPendingReleases.erase(std::remove_if(mPendingReleases.begin(), mPendingReleases.end(),
+		[completedFenceValue](const PendingRelease& release) { return release.fenceValue <= completedFenceValue; }),
+		mPendingReleases.end());
+}
+
+UINT GpuMemoryAllocator::AllocateBlock(UINT64 size, D3D12_RESOURCE_STATES state, int sizeClass)
+{
+	UINT heapIndex;
+	UINT64 heapOffset;
+	if (!PlaceBlock(size, NoHeap, &heapIndex, &heapOffset))
+	{
+		heapIndex = CreateHeap(size);
+		heapOffset = mHeaps[heapIndex].buddy->Allocate(size);
+	}
+
+	Block block = {};
+	block.used = true;
+	block.heap = heapIndex;
+	block.heapOffset = heapOffset;
+	block.size = size;
+	block.state = state;
+	block.sizeClass = sizeClass;
+	block.resource = CreatePlacedResource(heapIndex, heapOffset, size, state, &block.mapped);
+
+	if (sizeClass >= 0)
+	{
+		// Slots are handed out from the start of the slab
+		const UINT slotCount = static_cast<UINT>(SlabSize / (MinSmallSize << sizeClass));
+		block.freeSlots.reserve(slotCount);
+		for (UINT slot = slotCount; slot > 0; slot--)
+		{
+			block.freeSlots.push_back(slot - 1);
+		}
+	}
+
+	UINT blockIndex;
+	if (!mFreeBlocks.empty())
+	{
+		blockIndex = mFreeBlocks.back();
+		mFreeBlocks.pop_back();
+		mBlocks[blockIndex] = std::move(block);
+	}
+	else
+	{
+		blockIndex = static_cast<UINT>(mBlocks.size());
+		mBlocks.push_back(std::move(block));
+	}
+	return blockIndex;
+}
+
+void GpuMemoryAllocator::FreeBlock(UINT blockIndex)
+{
+	Block& block = mBlocks[blockIndex];
+	mHeaps[block.heap].buddy->Free(block.heapOffset);
+	block.resource.Reset();
+	block.mapped = nullptr;
+	block.freeSlots.clear();
+	block.used = false;
+	mFreeBlocks.push_back(blockIndex);
+}
+
+// Finds room in an existing heap, favouring the earliest heaps so later ones can empty out
+bool GpuMemoryAllocator::PlaceBlock(UINT64 size, UINT excludeHeap, UINT* heapIndex, UINT64* heapOffset)
+{
+	for (UINT i = 0; i < mHeaps.size(); i++)
+	{
+		if (i == excludeHeap || !mHeaps[i].heap)
+		{
+			continue;
+		}
+
+		const UINT64 offset = mHeaps[i].buddy->Allocate(size);
+		if (offset != BuddyAllocator::InvalidOffset)
+		{
+			*heapIndex = i;
+			*heapOffset = offset;
+			return true;
+		}
+	}
+	return false;
+}
+
+UINT GpuMemoryAllocator::CreateHeap(UINT64 minSize)
+{
+	const UINT64 size = std::max(mHeapSize, NextPowerOfTwo(minSize));
+
+	D3D12_HEAP_DESC heapDesc = {};
+	heapDesc.SizeInBytes = size;
+	heapDesc.Properties = CD3DX12_HEAP_PROPERTIES(mHeapType);
+	heapDesc.Alignment = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+	heapDesc.Flags = D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS;
+
+	Heap heap;
+	ThrowIfFailed(mDevice->CreateHeap(&heapDesc, IID_PPV_ARGS(&heap.heap)));
+	heap.buddy.reset(new BuddyAllocator(size, SlabSize));
+
+	// Reuse the slot of a released heap if there is one
+	for (UINT i = 0; i < mHeaps.size(); i++)
+	{
+		if (!mHeaps[i].heap)
+		{
+			mHeaps[i] = std::move(heap);
+			return i;
+		}
+	}
+
+	mHeaps.push_back(std::move(heap));
+	return static_cast<UINT>(mHeaps.size() - 1);
+}
+
+ComPtr<ID3D12Resource> GpuMemoryAllocator::CreatePlacedResource(UINT heapIndex, UINT64 heapOffset, UINT64 size, D3D12_RESOURCE_STATES state, UINT8** mapped)
+{
+	ComPtr<ID3D12Resource> resource;
+	ThrowIfFailed(mDevice->CreatePlacedResource(
+		mHeaps[heapIndex].heap.Get(),
+		heapOffset,
+		&CD3DX12_RESOURCE_DESC::Buffer(size),
+		state,
+		nullptr,
+		IID_PPV_ARGS(&resource)));
+
+	*mapped = nullptr;
+	if (mCpuVisible)
+	{
+		// Kept mapped for the resource's lifetime. Upload memory is never read on the CPU.
+		CD3DX12_RANGE readRange(0, 0);
+		ThrowIfFailed(resource->Map(0, mHeapType == D3D12_HEAP_TYPE_UPLOAD ? &readRange : nullptr, reinterpret_cast<void**>(mapped)));
+	}
+	return resource;
+}
@@ -0,0 +1,160 @@
+// GPU memory allocator
+// Buffers are placed in large ID3D12Heaps rather than each getting a committed resource.
+// Space in each heap is handed out by a buddy allocator at the 64KB placement alignment.
+// Buffers smaller than that are grouped by power-of-two size class into 64KB slabs, each
+// slab being one placed resource shared by all its sub-allocations.
+//
+// Allocations are referred to by handle, as defragmenting can move them to a different
+// resource. Look up the resource or GPU address through the handle when recording.
+//
+// Upload memory is write-combined, so reading it back on the CPU is very slow, and the GPU
+// can't write to it. Defragmenting an upload heap therefore doesn't copy the moved allocations;
+// their owners write them again from their own copy of the data.
+
+#pragma once
+
+#include "DXSampleHelper.h"
+#include "BuddyAllocator.h"
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+class GpuMemoryAllocator
+{
+public:
+	typedef UINT Handle;
+	static const Handle InvalidHandle = 0xFFFFFFFF;
+
+	static const UINT64 DefaultHeapSize = 16 * 1024 * 1024;
+	static const UINT64 SlabSize = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+	static const UINT64 MinSmallSize = 256;
+	static const UINT NumSizeClasses = 8;	// 256 bytes to 32KB
+
+	// Writes the contents of a moved upload allocation at its new CPU address
+	typedef std::function<void(Handle handle, void* data)> RewriteFunc;
+
+	struct Stats
+	{
+		UINT heapCount;
+		UINT64 heapBytes;
+		UINT64 blockBytes;			// Heap space used by placed resources
+		UINT64 requestedBytes;		// Sum of the sizes asked for
+		UINT allocationCount;
+		UINT smallAllocationCount;
+		UINT slabCount;
+		UINT64 largestFreeBlock;
+		float fragmentation;		// Free space not in the largest free block, across all heaps
+
+		// Totals from defragmenting
+		UINT defragMoves;
+		UINT64 defragBytesMoved;
+		UINT heapsReleased;
+	};
+
+	// Small allocations are only made for upload and readback heaps, where every resource
+	// stays in one state. Default heap buffers each get their own placed resource.
+	GpuMemoryAllocator(ID3D12Device* device, D3D12_HEAP_TYPE heapType, UINT64 heapSize = DefaultHeapSize);
+
+	// Prohibit copying
+	GpuMemoryAllocator(const GpuMemoryAllocator& rhs) = delete;
+	GpuMemoryAllocator& operator=(const GpuMemoryAllocator& rhs) = delete;
+
+	~GpuMemoryAllocator();
+
+	// Upload heaps must use GENERIC_READ and readback heaps COPY_DEST
+	Handle Allocate(UINT64 size, D3D12_RESOURCE_STATES initialState);
+
+	// The memory is reused straight away, so the GPU must have finished with the allocation
+	void Free(Handle handle);
+
+	// Getters
+	ID3D12Resource* GetResource(Handle handle) const;
+	UINT64 GetOffset(Handle handle) const;	// Offset of the allocation within its resource
+	UINT64 GetSize(Handle handle) const;
+	D3D12_GPU_VIRTUAL_ADDRESS GetGpuAddress(Handle handle) const;
+
+	// CPU pointer to the allocation, for upload and readback heaps (which are kept mapped)
+	void* GetCpuAddress(Handle handle) const;
+
+	Stats GetStats() const;
+
+	// Ask for the least used heap to be emptied into the others, at the next safe point
+	void ScheduleDefragment() { mDefragScheduled = true; }
+	bool IsDefragmentScheduled() const { return mDefragScheduled; }
+
+	// Runs a scheduled defragment, recording any GPU copies on the command list. For upload heaps,
+	// rewrite is called for each allocation that moved, and only those still needed need writing.
+	// Moved-from resources and released heaps are kept until the fence reaches fenceValue.
+	// Returns the number of resources moved.
+	UINT RunScheduledDefragment(ID3D12GraphicsCommandList* commandList, UINT64 fenceValue, const RewriteFunc& rewrite = RewriteFunc());
+
+	// Releases memory kept alive by defragmenting once the GPU has passed its fence value
+	void ReleaseCompleted(UINT64 completedFenceValue);
+
+private:
+	struct Heap
+	{
+		ComPtr<ID3D12Heap> heap;
+		std::unique_ptr<BuddyAllocator> buddy;
+	};
+
+	// A placed resource taking a buddy block: either one large allocation or a slab
+	struct Block
+	{
+		bool used;
+		UINT heap;
+		UINT64 heapOffset;
+		UINT64 size;
+		ComPtr<ID3D12Resource> resource;
+		UINT8* mapped;
+		D3D12_RESOURCE_STATES state;
+		int sizeClass;				// -1 for large allocations
+		std::vector<UINT> freeSlots;
+		UINT usedSlots;
+	};
+
+	struct Allocation
+	{
+		bool used;
+		UINT block;
+		UINT64 offset;
+		UINT64 size;
+	};
+
+	// Memory waiting for the GPU to finish with it
+	struct PendingRelease
+	{
+		UINT64 fenceValue;
+		ComPtr<ID3D12Resource> resource;
+		ComPtr<ID3D12Heap> heap;
+	};
+
+	UINT AllocateBlock(UINT64 size, D3D12_RESOURCE_STATES state, int sizeClass);
+	void FreeBlock(UINT blockIndex);
+	bool PlaceBlock(UINT64 size, UINT excludeHeap, UINT* heapIndex, UINT64* heapOffset);
+	UINT CreateHeap(UINT64 minSize);
+	ComPtr<ID3D12Resource> CreatePlacedResource(UINT heapIndex, UINT64 heapOffset, UINT64 size, D3D12_RESOURCE_STATES state, UINT8** mapped);
+
+	ComPtr<ID3D12Device> mDevice;
+	D3D12_HEAP_TYPE mHeapType;
+	UINT64 mHeapSize;
+	bool mCpuVisible;
+
+	std::vector<Heap> mHeaps;			// Released heaps are left empty so indices stay valid
+	std::vector<Block> mBlocks;
+	std::vector<UINT> mFreeBlocks;
+	std::vector<Allocation> mAllocations;
+	std::vector<Handle> mFreeHandles;
+
+	// Slabs with free slots, for each size class
+	std::vector<UINT> mPartialSlabs[NumSizeClasses];
+
+	bool mDefragScheduled;
+	std::vector<PendingRelease> mPendingReleases;
+	UINT64 mRequestedBytes;
+	UINT mSmallAllocationCount;
+	UINT mDefragMoves;
+	UINT64 mDefragBytesMoved;
+	UINT mHeapsReleased;
+};
@@ -0,0 +1,29 @@
+// Hashing helpers
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// 64-bit FNV-1a hash - fast and good enough for lookups and deduplication
+static const uint64_t FNV1aOffsetBasis = 0xcbf29ce484222325ull;
+static const uint64_t FNV1aPrime = 0x100000001b3ull;
+
+inline uint64_t HashBytes(const void* data, size_t size, uint64_t hash = FNV1aOffsetBasis)
+{
+	const uint8_t* bytes = static_cast<const uint8_t*>(data);
+	for (size_t i = 0; i < size; i++)
+	{
+		hash ^= bytes[i];
+		hash *= FNV1aPrime;
+	}
+	return hash;
+}
+
+// Hashes the bytes that make up a value. Only use on types without padding or pointers
+// that shouldn't be compared by address.
+template<typename T>
+uint64_t HashValue(const T& value, uint64_t hash = FNV1aOffsetBasis)
+{
+	return HashBytes(&value, sizeof(T), hash);
+}
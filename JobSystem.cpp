@@ -0,0 +1,95 @@
+#include "JobSystem.h"
+
+// Index of the worker running on this thread (-1 for non-worker threads)
+static thread_local int tWorkerIndex = -1;
+
+JobSystem::JobSystem(unsigned int threadCount) :
+	mOutstandingJobs(0),
+	mShuttingDown(false)
+{
+	if (threadCount == 0)
+	{
+		// hardware_concurrency can return 0 if it is unable to tell
+		const unsigned int hardwareThreads = std::thread::hardware_concurrency();
+		threadCount = hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+	}
+
+	mThreads.reserve(threadCount);
+	for (unsigned int i = 0; i < threadCount; i++)
+	{
+		mThreads.emplace_back(&JobSystem::WorkerLoop, this, i);
+	}
+}
+
+JobSystem::~JobSystem()
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mShuttingDown = true;
+	}
+	mJobAvailable.notify_all();
+
+	for (auto& thread : mThreads)
+	{
+		thread.join();
+	}
+}
+
+// Queue a job to be run on one of the worker threads
+void JobSystem::Submit(Job job)
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mJobs.push_back(std::move(job));
+		mOutstandingJobs++;
+	}
+	mJobAvailable.notify_one();
+}
+
+// Blocks the calling thread until every submitted job has finished
+// Must not be called from a worker thread, as it would wait on itself
+void JobSystem::WaitIdle()
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+	mIdle.wait(lock, [this] { return mOutstandingJobs == 0; });
+}
+
+// Returns the index of the calling worker thread, or -1 if not called from a worker
+int JobSystem::GetWorkerIndex()
+{
+	return tWorkerIndex;
+}
+
+void JobSystem::WorkerLoop(unsigned int index)
+{
+	tWorkerIndex = static_cast<int>(index);
+
+	while (true)
+	{
+		Job job;
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+			mJobAvailable.wait(lock, [this] { return mShuttingDown || !mJobs.empty(); });
+
+			// Only exit once the queue has been drained
+			if (mJobs.empty())
+			{
+				return;
+			}
+
+			job = std::move(mJobs.front());
+			mJobs.pop_front();
+		}
+
+		job();
+
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			mOutstandingJobs--;
+			if (mOutstandingJobs == 0)
+			{
+				mIdle.notify_all();
+			}
+		}
+	}
+}
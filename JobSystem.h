@@ -0,0 +1,101 @@
+// Job system - a pool of worker threads that run queued jobs
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class JobSystem
+{
+public:
+	typedef std::function<void()> Job;
+
+	// Constructor - a thread count of 0 uses one thread per hardware thread, minus the main thread
+	explicit JobSystem(unsigned int threadCount = 0);
+
+	// Prohibit copying
+	JobSystem(const JobSystem& rhs) = delete;
+	JobSystem& operator=(const JobSystem& rhs) = delete;
+
+	// Destructor - finishes any queued jobs then joins the worker threads
+	~JobSystem();
+
+	// Queue a job to be run on one of the worker threads
+	void Submit(Job job);
+
+	// Blocks the calling thread until every submitted job has finished
+	void WaitIdle();
+
+	// Getters
+	unsigned int GetThreadCount() const { return static_cast<unsigned int>(mThreads.size()); }
+
+	// Returns the index of the calling worker thread, or -1 if not called from a worker
+	static int GetWorkerIndex();
+
+private:
+	void WorkerLoop(unsigned int index);
+
+	std::vector<std::thread> mThreads;
+	std::deque<Job> mJobs;
+
+	std::mutex mMutex;
+	std::condition_variable mJobAvailable;
+	std::condition_variable mIdle;
+
+	// Number of jobs that are queued or running
+	unsigned int mOutstandingJobs;
+	bool mShuttingDown;
+};
+
+// Runs task(0) .. task(count - 1) over the job system's workers and the calling thread,
+// returning once all have finished. Tasks are handed out one at a time. With no job system,
+// or when called from a worker, they're all run on the calling thread, as a worker waiting
+// for other jobs could leave none free to run them.
+template<typename Task>
+void RunTasks(JobSystem* jobSystem, unsigned int count, const Task& task)
+{
+	std::atomic<unsigned int> next(0);
+	auto runTasks = [&task, &next, count]()
+	{
+		for (unsigned int index = next++; index < count; index = next++)
+		{
+			task(index);
+		}
+	};
+
+	const bool canHelp = jobSystem != nullptr && count > 0 && JobSystem::GetWorkerIndex() < 0;
+	const unsigned int helperCount = canHelp ? (std::min)(jobSystem->GetThreadCount(), count - 1) : 0;
+	if (helperCount == 0)
+	{
+		runTasks();
+		return;
+	}
+
+	std::mutex mutex;
+	std::condition_variable finished;
+	unsigned int running = helperCount;
+	for (unsigned int i = 0; i < helperCount; i++)
+	{
+		jobSystem->Submit([&runTasks, &mutex, &finished, &running]()
+		{
+			runTasks();
+
+			std::lock_guard<std::mutex> lock(mutex);
+			if (--running == 0)
+			{
+				finished.notify_one();
+			}
+		});
+	}
+
+	runTasks();
+
+	std::unique_lock<std::mutex> lock(mutex);
+	finished.wait(lock, [&running]() { return running == 0; });
+}
@@ -0,0 +1,423 @@
+#include "LightClusters.h"
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+#if LIGHT_CLUSTERS_SIMD
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+	// Lights are moved into view space in batches of this many per task
+	const uint32_t LightsPerTask = 256;
+
+	// Spot lights wider than this are bounded by the sphere around the cone's cap, and narrower
+	// ones by the sphere through its tip and the cap's rim
+	const float WideSpotCosAngle = 0.70710678f;
+
+	// [x y z w] * m, for the first three columns
+	void Transform(const float m[16], const float* vector, float w, float result[3])
+	{
+		for (unsigned int column = 0; column < 3; column++)
+		{
+			result[column] = vector[0] * m[column] + vector[1] * m[4 + column] + vector[2] * m[8 + column] + w * m[12 + column];
+		}
+	}
+
+	// The cluster a position along one axis falls in, out of count, clamped to the grid
+	uint32_t ClampCluster(float cluster, uint32_t count)
+	{
+		if (!(cluster > 0.0f))
+		{
+			return 0;
+		}
+		if (cluster >= static_cast<float>(count))
+		{
+			return count - 1;
+		}
+		return static_cast<uint32_t>(cluster);
+	}
+}
+
+LightClusters::LightClusters(uint32_t clustersX, uint32_t clustersY, uint32_t clustersZ) :
+	mClustersX((std::max)(clustersX, 1u)),
+	mClustersY((std::max)(clustersY, 1u)),
+	mClustersZ((std::max)(clustersZ, 1u)),
+	mScaleX(1.0f),
+	mScaleY(1.0f),
+	mNearZ(0.1f),
+	mFarZ(1000.0f),
+	mSliceScale(0.0f),
+	mSliceBias(0.0f),
+	mStats()
+{
+	mBlocksX = (mClustersX + 3) / 4;
+	mBlocks.resize(mBlocksX * mClustersY * mClustersZ);
+	mSlices.resize(mClustersZ);
+	mClusterRanges.assign(GetClusterCount() * 2, 0);
+	SetProjection(0.785398f, 1.0f, mNearZ, mFarZ);
+}
+
+// Sets the frustum the clusters divide, as XMMatrixPerspectiveFovLH takes it, and works out
+// the clusters' bounds. Must be called before assigning lights.
+void LightClusters::SetProjection(float fovY, float aspectRatio, float nearZ, float farZ)
+{
+	mScaleY = 1.0f / tanf(fovY * 0.5f);
+	mScaleX = mScaleY / aspectRatio;
+	mNearZ = nearZ;
+	mFarZ = farZ;
+
+	const float logDepthRange = logf(farZ / nearZ);
+	mSliceScale = static_cast<float>(mClustersZ) / logDepthRange;
+	mSliceBias = -mSliceScale * logf(nearZ);
+
+	for (uint32_t z = 0; z < mClustersZ; z++)
+	{
+		const float nearDepth = nearZ * powf(farZ / nearZ, static_cast<float>(z) / mClustersZ);
+		const float farDepth = nearZ * powf(farZ / nearZ, static_cast<float>(z + 1) / mClustersZ);
+		for (uint32_t y = 0; y < mClustersY; y++)
+		{
+			// Tiles are numbered from the top of the screen, where y is 1
+			const float topY = 1.0f - 2.0f * y / mClustersY;
+			const float bottomY = 1.0f - 2.0f * (y + 1) / mClustersY;
+			for (uint32_t blockX = 0; blockX < mBlocksX; blockX++)
+			{
+				ClusterBlock& block = mBlocks[(z * mClustersY + y) * mBlocksX + blockX];
+				for (uint32_t lane = 0; lane < 4; lane++)
+				{
+					const uint32_t x = blockX * 4 + lane;
+					if (x >= mClustersX)
+					{
+						for (unsigned int axis = 0; axis < 3; axis++)
+						{
+							block.min[axis][lane] = FLT_MAX;
+							block.max[axis][lane] = -FLT_MAX;
+							block.centre[axis][lane] = 0.0f;
+						}
+						block.radius[lane] = 0.0f;
+						continue;
+					}
+
+					// The tile's edges at both ends of the slice, which the box spans
+					const float leftX = -1.0f + 2.0f * x / mClustersX;
+					const float rightX = -1.0f + 2.0f * (x + 1) / mClustersX;
+					block.min[0][lane] = (std::min)(leftX * nearDepth, leftX * farDepth) / mScaleX;
+					block.max[0][lane] = (std::max)(rightX * nearDepth, rightX * farDepth) / mScaleX;
+					block.min[1][lane] = (std::min)(bottomY * nearDepth, bottomY * farDepth) / mScaleY;
+					block.max[1][lane] = (std::max)(topY * nearDepth, topY * farDepth) / mScaleY;
+					block.min[2][lane] = nearDepth;
+					block.max[2][lane] = farDepth;
+
+					float radiusSquared = 0.0f;
+					for (unsigned int axis = 0; axis < 3; axis++)
+					{
+						const float halfSize = 0.5f * (block.max[axis][lane] - block.min[axis][lane]);
+						block.centre[axis][lane] = block.min[axis][lane] + halfSize;
+						radiusSquared += halfSize * halfSize;
+					}
+					block.radius[lane] = sqrtf(radiusSquared);
+				}
+			}
+		}
+	}
+}
+
+// Builds each cluster's list of lights from the camera's view matrix, splitting the slices
+// over the job system's workers
+void LightClusters::Assign(const ClusteredLight* lights, uint32_t count, const float view[16], JobSystem* jobSystem)
+{
+	mStats = Stats();
+	mStats.lightCount = count;
+
+	mViewLights.resize(count);
+	RunTasks(jobSystem, (count + LightsPerTask - 1) / LightsPerTask, [this, lights, count, view](unsigned int task)
+	{
+		const uint32_t end = (std::min)((task + 1) * LightsPerTask, count);
+		for (uint32_t i = task * LightsPerTask; i < end; i++)
+		{
+			UpdateViewLight(lights[i], view, mViewLights[i]);
+		}
+	});
+
+	// Most lights only reach a slice or two, so each slice is only given the lights it needs
+	for (Slice& slice : mSlices)
+	{
+		slice.lights.clear();
+	}
+	for (uint32_t i = 0; i < count; i++)
+	{
+		const ViewLight& light = mViewLights[i];
+		if (light.minX > light.maxX)
+		{
+			continue;
+		}
+		mStats.visibleLightCount++;
+		for (uint32_t z = light.minZ; z <= light.maxZ; z++)
+		{
+			mSlices[z].lights.push_back(i);
+		}
+	}
+
+	RunTasks(jobSystem, mClustersZ, [this](unsigned int slice)
+	{
+		FillSlice(slice);
+	});
+
+	// Each slice's ranges start from its own first index, so offset them into one list
+	const uint32_t clustersPerSlice = mClustersX * mClustersY;
+	uint32_t firstIndex = 0;
+	for (uint32_t z = 0; z < mClustersZ; z++)
+	{
+		const Slice& slice = mSlices[z];
+		uint32_t* ranges = &mClusterRanges[z * clustersPerSlice * 2];
+		for (uint32_t cluster = 0; cluster < clustersPerSlice; cluster++)
+		{
+			ranges[cluster * 2] += firstIndex;
+		}
+		firstIndex += static_cast<uint32_t>(slice.indices.size());
+		mStats.maxClusterLightCount = (std::max)(mStats.maxClusterLightCount, slice.maxClusterLightCount);
+	}
+
+	mLightIndices.resize(firstIndex);
+	uint32_t* indices = mLightIndices.data();
+	for (const Slice& slice : mSlices)
+	{
+		if (!slice.indices.empty())
+		{
+			memcpy(indices, slice.indices.data(), slice.indices.size() * sizeof(uint32_t));
+			indices += slice.indices.size();
+		}
+	}
+	mStats.indexCount = firstIndex;
+}
+
+// Moves a light into view space, bounds it with a sphere, and finds the clusters the sphere
+// might reach from its extent on screen and in depth
+void LightClusters::UpdateViewLight(const ClusteredLight& light, const float view[16], ViewLight& viewLight) const
+{
+	Transform(view, light.position, 1.0f, viewLight.position);
+	Transform(view, light.direction, 0.0f, viewLight.direction);
+	viewLight.range = light.range;
+	viewLight.isSpot = light.type == LightType_Spot ? 1 : 0;
+
+	if (viewLight.isSpot)
+	{
+		const float cosAngle = (std::min)((std::max)(light.cosOuterAngle, 0.0f), 1.0f);
+		const float sinAngle = sqrtf(1.0f - cosAngle * cosAngle);
+		viewLight.cosOuterAngle = cosAngle;
+		viewLight.sinOuterAngle = sinAngle;
+
+		float distance;
+		if (cosAngle < WideSpotCosAngle)
+		{
+			distance = cosAngle * light.range;
+			viewLight.radius = sinAngle * light.range;
+		}
+		else
+		{
+			distance = light.range / (2.0f * cosAngle);
+			viewLight.radius = distance;
+		}
+		for (unsigned int axis = 0; axis < 3; axis++)
+		{
+			viewLight.centre[axis] = viewLight.position[axis] + viewLight.direction[axis] * distance;
+		}
+	}
+	else
+	{
+		viewLight.cosOuterAngle = -1.0f;
+		viewLight.sinOuterAngle = 0.0f;
+		viewLight.radius = light.range;
+		for (unsigned int axis = 0; axis < 3; axis++)
+		{
+			viewLight.centre[axis] = viewLight.position[axis];
+		}
+	}
+
+	viewLight.minX = 1;
+	viewLight.maxX = 0;
+	const float radius = viewLight.radius;
+	const float nearDepth = viewLight.centre[2] - radius;
+	const float farDepth = viewLight.centre[2] + radius;
+	if (farDepth <= mNearZ || nearDepth >= mFarZ)
+	{
+		return;
+	}
+	viewLight.minZ = GetSlice(nearDepth);
+	viewLight.maxZ = GetSlice(farDepth);
+
+	// A sphere reaching the camera's plane could cover any of the screen
+	if (nearDepth <= mNearZ)
+	{
+		viewLight.minX = 0;
+		viewLight.maxX = mClustersX - 1;
+		viewLight.minY = 0;
+		viewLight.maxY = mClustersY - 1;
+		return;
+	}
+
+	// Otherwise its box's furthest reach on screen is at one of its corners, as x / z only
+	// grows or shrinks with each of x and z
+	const float minX = mScaleX * (std::min)((viewLight.centre[0] - radius) / nearDepth, (viewLight.centre[0] - radius) / farDepth);
+	const float maxX = mScaleX * (std::max)((viewLight.centre[0] + radius) / nearDepth, (viewLight.centre[0] + radius) / farDepth);
+	const float minY = mScaleY * (std::min)((viewLight.centre[1] - radius) / nearDepth, (viewLight.centre[1] - radius) / farDepth);
+	const float maxY = mScaleY * (std::max)((viewLight.centre[1] + radius) / nearDepth, (viewLight.centre[1] + radius) / farDepth);
+	if (maxX < -1.0f || minX > 1.0f || maxY < -1.0f || minY > 1.0f)
+	{
+		return;
+	}
+
+	viewLight.minX = ClampCluster((minX + 1.0f) * 0.5f * mClustersX, mClustersX);
+	viewLight.maxX = ClampCluster((maxX + 1.0f) * 0.5f * mClustersX, mClustersX);
+	viewLight.minY = ClampCluster((1.0f - maxY) * 0.5f * mClustersY, mClustersY);
+	viewLight.maxY = ClampCluster((1.0f - minY) * 0.5f * mClustersY, mClustersY);
+}
+
+// Tests each of the slice's lights against the clusters it might reach, then sorts the hits
+// into lists by cluster. Each cluster's list keeps its lights in order.
+void LightClusters::FillSlice(uint32_t slice)
+{
+	Slice& target = mSlices[slice];
+	target.assignments.clear();
+
+	for (const uint32_t lightIndex : target.lights)
+	{
+		const ViewLight& light = mViewLights[lightIndex];
+
+#if LIGHT_CLUSTERS_SIMD
+		const __m128 centreX = _mm_set1_ps(light.centre[0]);
+		const __m128 centreY = _mm_set1_ps(light.centre[1]);
+		const __m128 centreZ = _mm_set1_ps(light.centre[2]);
+		const __m128 radiusSquared = _mm_set1_ps(light.radius * light.radius);
+		const __m128 positionX = _mm_set1_ps(light.position[0]);
+		const __m128 positionY = _mm_set1_ps(light.position[1]);
+		const __m128 positionZ = _mm_set1_ps(light.position[2]);
+		const __m128 directionX = _mm_set1_ps(light.direction[0]);
+		const __m128 directionY = _mm_set1_ps(light.direction[1]);
+		const __m128 directionZ = _mm_set1_ps(light.direction[2]);
+		const __m128 cosAngle = _mm_set1_ps(light.cosOuterAngle);
+		const __m128 sinAngle = _mm_set1_ps(light.sinOuterAngle);
+		const __m128 range = _mm_set1_ps(light.range);
+		const __m128 zero = _mm_setzero_ps();
+#endif
+
+		for (uint32_t y = light.minY; y <= light.maxY; y++)
+		{
+			const ClusterBlock* row = &mBlocks[(slice * mClustersY + y) * mBlocksX];
+			for (uint32_t blockX = light.minX / 4; blockX <= light.maxX / 4; blockX++)
+			{
+				const ClusterBlock& block = row[blockX];
+
+#if LIGHT_CLUSTERS_SIMD
+				// The bounding sphere against the boxes, from the distance to each box's nearest point
+				const __m128 dx = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(block.min[0]), centreX), _mm_sub_ps(centreX, _mm_loadu_ps(block.max[0]))), zero);
+				const __m128 dy = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(block.min[1]), centreY), _mm_sub_ps(centreY, _mm_loadu_ps(block.max[1]))), zero);
+				const __m128 dz = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(block.min[2]), centreZ), _mm_sub_ps(centreZ, _mm_loadu_ps(block.max[2]))), zero);
+				const __m128 distanceSquared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+				__m128 hit = _mm_cmple_ps(distanceSquared, radiusSquared);
+
+				// Spot lights' cones against the boxes' bounding spheres: outside if the sphere is
+				// beyond the cone's side, past its cap, or behind its tip
+				if (light.isSpot)
+				{
+					const __m128 vx = _mm_sub_ps(_mm_loadu_ps(block.centre[0]), positionX);
+					const __m128 vy = _mm_sub_ps(_mm_loadu_ps(block.centre[1]), positionY);
+					const __m128 vz = _mm_sub_ps(_mm_loadu_ps(block.centre[2]), positionZ);
+					const __m128 lengthSquared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, vx), _mm_mul_ps(vy, vy)), _mm_mul_ps(vz, vz));
+					const __m128 along = _mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, directionX), _mm_mul_ps(vy, directionY)), _mm_mul_ps(vz, directionZ));
+					const __m128 across = _mm_sqrt_ps(_mm_max_ps(_mm_sub_ps(lengthSquared, _mm_mul_ps(along, along)), zero));
+					const __m128 fromSide = _mm_sub_ps(_mm_mul_ps(cosAngle, across), _mm_mul_ps(along, sinAngle));
+					const __m128 sphereRadius = _mm_loadu_ps(block.radius);
+					hit = _mm_and_ps(hit, _mm_cmple_ps(fromSide, sphereRadius));
+					hit = _mm_and_ps(hit, _mm_cmple_ps(along, _mm_add_ps(sphereRadius, range)));
+					hit = _mm_and_ps(hit, _mm_cmpge_ps(along, _mm_sub_ps(zero, sphereRadius)));
+				}
+				int mask = _mm_movemask_ps(hit);
+#else
+				int mask = 0;
+				for (unsigned int lane = 0; lane < 4; lane++)
+				{
+					float distanceSquared = 0.0f;
+					for (unsigned int axis = 0; axis < 3; axis++)
+					{
+						const float d = (std::max)((std::max)(block.min[axis][lane] - light.centre[axis], light.centre[axis] - block.max[axis][lane]), 0.0f);
+						distanceSquared += d * d;
+					}
+					bool hit = distanceSquared <= light.radius * light.radius;
+
+					if (hit && light.isSpot)
+					{
+						float v[3];
+						for (unsigned int axis = 0; axis < 3; axis++)
+						{
+							v[axis] = block.centre[axis][lane] - light.position[axis];
+						}
+						const float lengthSquared = v[0] * v[0] + v[1] * v[1] + v[2] * v[2];
+						const float along = v[0] * light.direction[0] + v[1] * light.direction[1] + v[2] * light.direction[2];
+						const float across = sqrtf((std::max)(lengthSquared - along * along, 0.0f));
+						const float fromSide = light.cosOuterAngle * across - along * light.sinOuterAngle;
+						const float sphereRadius = block.radius[lane];
+						hit = fromSide <= sphereRadius && along <= sphereRadius + light.range && along >= -sphereRadius;
+					}
+					mask |= hit ? 1 << lane : 0;
+				}
+#endif
+
+				// Padding clusters are inside out, so are never hit
+				for (uint32_t lane = 0; mask != 0; lane++, mask >>= 1)
+				{
+					if ((mask & 1) != 0)
+					{
+						const Assignment assignment = { y * mClustersX + blockX * 4 + lane, lightIndex };
+						target.assignments.push_back(assignment);
+					}
+				}
+			}
+		}
+	}
+
+	// Count each cluster's lights, then place them. The first index is used as each cluster's
+	// cursor while placing, and moved back after.
+	const uint32_t clustersPerSlice = mClustersX * mClustersY;
+	uint32_t* ranges = &mClusterRanges[slice * clustersPerSlice * 2];
+	for (uint32_t cluster = 0; cluster < clustersPerSlice; cluster++)
+	{
+		ranges[cluster * 2 + 1] = 0;
+	}
+	for (const Assignment& assignment : target.assignments)
+	{
+		ranges[assignment.cluster * 2 + 1]++;
+	}
+
+	uint32_t firstIndex = 0;
+	target.maxClusterLightCount = 0;
+	for (uint32_t cluster = 0; cluster < clustersPerSlice; cluster++)
+	{
+		ranges[cluster * 2] = firstIndex;
+		firstIndex += ranges[cluster * 2 + 1];
+		target.maxClusterLightCount = (std::max)(target.maxClusterLightCount, ranges[cluster * 2 + 1]);
+	}
+
+	target.indices.resize(target.assignments.size());
+	for (const Assignment& assignment : target.assignments)
+	{
+		target.indices[ranges[assignment.cluster * 2]++] = assignment.light;
+	}
+	for (uint32_t cluster = 0; cluster < clustersPerSlice; cluster++)
+	{
+		ranges[cluster * 2] -= ranges[cluster * 2 + 1];
+	}
+}
+
+uint32_t LightClusters::GetSlice(float depth) const
+{
+	if (depth <= mNearZ)
+	{
+		return 0;
+	}
+	return ClampCluster(logf(depth) * mSliceScale + mSliceBias, mClustersZ);
+}
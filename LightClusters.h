@@ -0,0 +1,151 @@
+// Clustered light assignment
+// For clustered forward lighting, the view frustum is split into a grid of clusters: tiles of
+// the screen, each cut into slices by depth. Every frame each cluster is given the list of lights
+// that might reach it, so a pixel shader only loops over the few lights in its pixel's cluster
+// rather than all of them.
+//
+// Slices are spaced exponentially in depth, so clusters stay roughly cube shaped from the near
+// plane out. Lights are moved into view space and given the range of clusters their bounds cover
+// on screen, then sorted into the slices they touch. Slices are filled at once over the job
+// system, each testing its lights against a row of clusters four at a time with SSE where it's
+// available: a sphere against each cluster's box for point lights, and for spot lights the cone
+// against the cluster's bounding sphere too.
+//
+// The result is a compact list of light indices ordered by cluster, with each cluster's first
+// index and count, ready to upload as is. Clusters are numbered x first, then y from the top of
+// the screen, then slice from the near plane.
+//
+// Lights are in world space, and the view matrix is 4x4 row-major for row vectors (as
+// DirectXMath uses), looking down +z.
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#if !defined(LIGHT_CLUSTERS_SIMD) && (defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__))
+#define LIGHT_CLUSTERS_SIMD 1
+#endif
+
+class JobSystem;
+
+enum ELightType
+{
+	LightType_Point,
+	LightType_Spot
+};
+
+// Matches the Light struct shaders read
+struct ClusteredLight
+{
+	float position[3];
+	float range;			// Nothing beyond this distance is lit
+	float direction[3];		// Spot lights only, normalised
+	float cosOuterAngle;	// Spot lights only, of the angle from the direction to the cone's edge
+	float colour[3];
+	uint32_t type;			// ELightType
+};
+
+class LightClusters
+{
+public:
+	struct Stats
+	{
+		uint32_t lightCount;
+		uint32_t visibleLightCount;		// Those in front of the camera and on screen
+		uint32_t indexCount;			// Light index list entries, over every cluster
+		uint32_t maxClusterLightCount;	// Most lights in one cluster
+	};
+
+	LightClusters(uint32_t clustersX, uint32_t clustersY, uint32_t clustersZ);
+
+	// Prohibit copying
+	LightClusters(const LightClusters& rhs) = delete;
+	LightClusters& operator=(const LightClusters& rhs) = delete;
+
+	// Sets the frustum the clusters divide, as XMMatrixPerspectiveFovLH takes it, and works out
+	// the clusters' bounds. Must be called before assigning lights.
+	void SetProjection(float fovY, float aspectRatio, float nearZ, float farZ);
+
+	// Builds each cluster's list of lights from the camera's view matrix, splitting the slices
+	// over the job system's workers
+	void Assign(const ClusteredLight* lights, uint32_t count, const float view[16], JobSystem* jobSystem = nullptr);
+
+	// Getters
+	uint32_t GetClustersX() const { return mClustersX; }
+	uint32_t GetClustersY() const { return mClustersY; }
+	uint32_t GetClustersZ() const { return mClustersZ; }
+	uint32_t GetClusterCount() const { return mClustersX * mClustersY * mClustersZ; }
+	const uint32_t* GetClusterRanges() const { return mClusterRanges.data(); }		// First index and count, per cluster
+	const uint32_t* GetLightIndices() const { return mLightIndices.data(); }
+	uint32_t GetLightIndexCount() const { return static_cast<uint32_t>(mLightIndices.size()); }
+	float GetSliceScale() const { return mSliceScale; }		// A view depth's slice is log(depth) * scale + bias
+	float GetSliceBias() const { return mSliceBias; }
+	const Stats& GetStats() const { return mStats; }
+
+private:
+	// Clusters' bounds in view space, for four neighbouring clusters in a row, so they load
+	// straight into SSE registers. Padding clusters past the end of a row are inside out.
+	struct ClusterBlock
+	{
+		float min[3][4];
+		float max[3][4];
+		float centre[3][4];		// Bounding sphere
+		float radius[4];
+	};
+
+	// A light moved into view space, with the clusters it might reach
+	struct ViewLight
+	{
+		float centre[3];		// Bounding sphere
+		float radius;
+		float position[3];
+		float range;
+		float direction[3];
+		float cosOuterAngle;
+		float sinOuterAngle;
+		uint32_t isSpot;
+		uint32_t minX;			// Clusters, inclusive. minX > maxX if the light can't be seen.
+		uint32_t maxX;
+		uint32_t minY;
+		uint32_t maxY;
+		uint32_t minZ;
+		uint32_t maxZ;
+	};
+
+	struct Assignment
+	{
+		uint32_t cluster;		// Within its slice
+		uint32_t light;
+	};
+
+	struct Slice
+	{
+		std::vector<uint32_t> lights;			// View lights touching the slice
+		std::vector<Assignment> assignments;
+		std::vector<uint32_t> indices;			// Light indices, ordered by cluster
+		uint32_t maxClusterLightCount;
+	};
+
+	void UpdateViewLight(const ClusteredLight& light, const float view[16], ViewLight& viewLight) const;
+	void FillSlice(uint32_t slice);
+	uint32_t GetSlice(float depth) const;
+
+	uint32_t mClustersX;
+	uint32_t mClustersY;
+	uint32_t mClustersZ;
+	uint32_t mBlocksX;			// Blocks of four clusters per row
+	float mScaleX;				// The projection's scale of view x and y
+	float mScaleY;
+	float mNearZ;
+	float mFarZ;
+	float mSliceScale;
+	float mSliceBias;
+
+	std::vector<ClusterBlock> mBlocks;			// By row, then slice
+	std::vector<ViewLight> mViewLights;
+	std::vector<Slice> mSlices;
+	std::vector<uint32_t> mClusterRanges;
+	std::vector<uint32_t> mLightIndices;
+	Stats mStats;
+};
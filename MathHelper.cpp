@@ -27,6 +27,20 @@ float MathHelper::AngleFromXY(float x, float y)
 	return theta;
 }
 
+// The ray through a point on screen, in pixels from the top left, from the near plane to the
+// far plane. The direction isn't normalised, so it spans the depth range.
+void MathHelper::ScreenToWorldRay(float x, float y, float width, float height, DirectX::CXMMATRIX inverseViewProj,
+	DirectX::XMVECTOR* origin, DirectX::XMVECTOR* direction)
+{
+	const float ndcX = 2.0f * x / width - 1.0f;
+	const float ndcY = 1.0f - 2.0f * y / height;
+
+	const DirectX::XMVECTOR nearPoint = DirectX::XMVector3TransformCoord(DirectX::XMVectorSet(ndcX, ndcY, 0.0f, 1.0f), inverseViewProj);
+	const DirectX::XMVECTOR farPoint = DirectX::XMVector3TransformCoord(DirectX::XMVectorSet(ndcX, ndcY, 1.0f, 1.0f), inverseViewProj);
+	*origin = nearPoint;
+	*direction = DirectX::XMVectorSubtract(farPoint, nearPoint);
+}
+
 DirectX::XMVECTOR MathHelper::RandUnitVec3()
 {
 	DirectX::XMVECTOR One = DirectX::XMVectorSet(1.0f, 1.0f, 1.0f, 1.0f);
@@ -3,9 +3,11 @@
 
 #pragma once
 
-#include <Windows.h>
 #include <DirectXMath.h>
+#include <cfloat>
+#include <cmath>
 #include <cstdint>
+#include <cstdlib>
 
 class MathHelper
 {
@@ -86,6 +88,11 @@ public:
 		return I;
 	}
 
+	// The ray through a point on screen, in pixels from the top left, from the near plane to the
+	// far plane. The direction isn't normalised, so it spans the depth range.
+	static void ScreenToWorldRay(float x, float y, float width, float height, DirectX::CXMMATRIX inverseViewProj,
+		DirectX::XMVECTOR* origin, DirectX::XMVECTOR* direction);
+
 	static DirectX::XMVECTOR RandUnitVec3();
 	static DirectX::XMVECTOR RandHemishpereUnitVec3(DirectX::XMVECTOR n);
 
@@ -0,0 +1,275 @@
+#include "MicroBench.h"
+#include "AllocationCounter.h"
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+
+const unsigned int BenchState::MaxCounters;
+
+namespace
+{
+	struct RegisteredBench
+	{
+		const char* name;
+		BenchFunction function;
+	};
+
+	// Function static, as benchmarks register themselves from other files' static initialisers
+	std::vector<RegisteredBench>& GetRegistry()
+	{
+		static std::vector<RegisteredBench> registry;
+		return registry;
+	}
+
+	struct RegisteredTest
+	{
+		const char* name;
+		TestFunction function;
+	};
+
+	std::vector<RegisteredTest>& GetTestRegistry()
+	{
+		static std::vector<RegisteredTest> registry;
+		return registry;
+	}
+
+	// Failed checks since the start of the run, which may come from job system workers
+	std::atomic<unsigned int> sCheckFailures(0);
+
+	// What a sample reports besides its time. Fixed size, so keeping it doesn't allocate.
+	struct SampleInfo
+	{
+		uint64_t itemsPerIteration;
+		unsigned int counterCount;
+		BenchCounter counters[BenchState::MaxCounters];
+	};
+
+	// Times one sample of the given size, in nanoseconds
+	int64_t RunSample(BenchFunction function, uint64_t iterations, const IClock& clock, SampleInfo& info)
+	{
+		BenchState state(iterations, &clock);
+		function(state);
+		const int64_t end = clock.Now();
+
+		info.itemsPerIteration = state.itemsPerIteration;
+		info.counterCount = state.GetCounterCount();
+		for (unsigned int i = 0; i < info.counterCount; i++)
+		{
+			info.counters[i] = state.GetCounter(i);
+		}
+		return end - state.GetStartTime();
+	}
+
+	double Median(std::vector<double> values)
+	{
+		std::sort(values.begin(), values.end());
+		const size_t middle = values.size() / 2;
+		return values.size() % 2 != 0 ? values[middle] : (values[middle - 1] + values[middle]) * 0.5;
+	}
+
+	void PrintResult(const BenchResult& result)
+	{
+		printf("%-40s %12.2f ns/op  (min %10.2f, mad %5.1f%%)  %10.3g items/s  %6.2f allocs/op\n",
+			result.name.c_str(), result.nsPerOp, result.minNsPerOp,
+			result.nsPerOp > 0.0 ? 100.0 * result.madNsPerOp / result.nsPerOp : 0.0,
+			result.itemsPerSecond, result.allocationsPerOp);
+		for (const BenchCounter& counter : result.counters)
+		{
+			printf("%-40s %12.6g %s\n", "", counter.value, counter.name);
+		}
+		fflush(stdout);
+	}
+}
+
+// Reports a value with the results, e.g. how much work an optimisation saved. Setting the
+// same name again replaces it. Values from the last sample are the ones reported.
+void BenchState::SetCounter(const char* name, double value)
+{
+	for (unsigned int i = 0; i < mCounterCount; i++)
+	{
+		if (strcmp(mCounters[i].name, name) == 0)
+		{
+			mCounters[i].value = value;
+			return;
+		}
+	}
+
+	if (mCounterCount < MaxCounters)
+	{
+		mCounters[mCounterCount].name = name;
+		mCounters[mCounterCount].value = value;
+		mCounterCount++;
+	}
+}
+
+// Adds a benchmark to the list. Used by MICRO_BENCH, from static initialisers.
+bool RegisterMicroBench(const char* name, BenchFunction function)
+{
+	RegisteredBench bench = { name, function };
+	GetRegistry().push_back(bench);
+	return true;
+}
+
+// Runs every registered benchmark matching the filter, in name order, printing progress to stdout
+std::vector<BenchResult> RunMicroBenches(const BenchSettings& settings)
+{
+	std::vector<RegisteredBench> benches = GetRegistry();
+	std::sort(benches.begin(), benches.end(), [](const RegisteredBench& a, const RegisteredBench& b)
+	{
+		return std::string(a.name) < b.name;
+	});
+
+	SystemClock clock;
+	const unsigned int sampleCount = settings.samples > 0 ? settings.samples : 1;
+
+	std::vector<BenchResult> results;
+	for (const RegisteredBench& bench : benches)
+	{
+		if (!settings.filter.empty() && std::string(bench.name).find(settings.filter) == std::string::npos)
+		{
+			continue;
+		}
+
+		// Double the iterations until a sample is long enough that timer resolution doesn't matter.
+		// This also warms the caches and the branch predictor.
+		SampleInfo info;
+		uint64_t iterations = 1;
+		while (true)
+		{
+			const int64_t time = RunSample(bench.function, iterations, clock, info);
+			if (time >= settings.minSampleTime || iterations >= (1ull << 40))
+			{
+				break;
+			}
+
+			// Jump straight to roughly the right count once the time is measurable
+			const uint64_t estimate = time > 1000 ? static_cast<uint64_t>(iterations * 1.2 * settings.minSampleTime / time) : 0;
+			iterations = (std::max)(iterations * 2, estimate);
+		}
+
+		std::vector<double> nsPerOp(sampleCount);
+		const AllocationCounts startAllocations = GetAllocationCounts();
+		for (unsigned int sample = 0; sample < sampleCount; sample++)
+		{
+			nsPerOp[sample] = static_cast<double>(RunSample(bench.function, iterations, clock, info)) / iterations;
+		}
+		const AllocationCounts endAllocations = GetAllocationCounts();
+
+		BenchResult result;
+		result.name = bench.name;
+		result.iterations = iterations;
+		result.samples = sampleCount;
+		result.nsPerOp = Median(nsPerOp);
+		result.minNsPerOp = *std::min_element(nsPerOp.begin(), nsPerOp.end());
+
+		std::vector<double> deviations(sampleCount);
+		for (unsigned int sample = 0; sample < sampleCount; sample++)
+		{
+			deviations[sample] = fabs(nsPerOp[sample] - result.nsPerOp);
+		}
+		result.madNsPerOp = Median(deviations);
+
+		result.itemsPerSecond = result.nsPerOp > 0.0 ? info.itemsPerIteration * 1e9 / result.nsPerOp : 0.0;
+		result.counters.assign(info.counters, info.counters + info.counterCount);
+
+		// The counts cover the harness's own allocations too, but there are none between samples
+		const double operations = static_cast<double>(iterations) * sampleCount;
+		result.allocationsPerOp = (endAllocations.allocations - startAllocations.allocations) / operations;
+		result.bytesPerOp = (endAllocations.bytes - startAllocations.bytes) / operations;
+
+		PrintResult(result);
+		results.push_back(result);
+	}
+
+	return results;
+}
+
+bool WriteBenchResultsJson(FILE* file, const std::vector<BenchResult>& results)
+{
+	fprintf(file, "{\n  \"benchmarks\": [");
+	for (size_t i = 0; i < results.size(); i++)
+	{
+		const BenchResult& result = results[i];
+		fprintf(file, "%s\n    { \"name\": \"%s\", \"iterations\": %llu, \"samples\": %u, \"ns_per_op\": %.3f, \"min_ns_per_op\": %.3f, "
+			"\"mad_ns_per_op\": %.3f, \"items_per_second\": %.1f, \"allocations_per_op\": %.4f, \"bytes_per_op\": %.2f",
+			i == 0 ? "" : ",", result.name.c_str(), static_cast<unsigned long long>(result.iterations), result.samples,
+			result.nsPerOp, result.minNsPerOp, result.madNsPerOp, result.itemsPerSecond, result.allocationsPerOp, result.bytesPerOp);
+
+		if (!result.counters.empty())
+		{
+			fprintf(file, ", \"counters\": {");
+			for (size_t c = 0; c < result.counters.size(); c++)
+			{
+				fprintf(file, "%s \"%s\": %.6g", c == 0 ? "" : ",", result.counters[c].name, result.counters[c].value);
+			}
+			fprintf(file, " }");
+		}
+		fprintf(file, " }");
+	}
+	fprintf(file, "\n  ]\n}\n");
+	return ferror(file) == 0;
+}
+
+// Adds a test to the list. Used by MICRO_TEST, from static initialisers.
+bool RegisterMicroTest(const char* name, TestFunction function)
+{
+	RegisteredTest test = { name, function };
+	GetTestRegistry().push_back(test);
+	return true;
+}
+
+// Runs every registered test matching the filter, in name order, printing each one's result.
+// Returns how many failed, or -1 if none matched.
+int RunMicroTests(const std::string& filter)
+{
+	std::vector<RegisteredTest> tests = GetTestRegistry();
+	std::sort(tests.begin(), tests.end(), [](const RegisteredTest& a, const RegisteredTest& b)
+	{
+		return std::string(a.name) < b.name;
+	});
+
+	int matched = 0;
+	int failed = 0;
+	for (const RegisteredTest& test : tests)
+	{
+		if (!filter.empty() && std::string(test.name).find(filter) == std::string::npos)
+		{
+			continue;
+		}
+
+		const unsigned int failuresBefore = sCheckFailures.load();
+		test.function();
+		const unsigned int failures = sCheckFailures.load() - failuresBefore;
+
+		if (failures == 0)
+		{
+			printf("%-40s ok\n", test.name);
+		}
+		else
+		{
+			printf("%-40s FAILED (%u checks)\n", test.name, failures);
+			failed++;
+		}
+		fflush(stdout);
+		matched++;
+	}
+
+	return matched > 0 ? failed : -1;
+}
+
+// Called by MICRO_CHECK when a check fails, from any thread
+void ReportCheckFailure(const char* expression, const char* file, int line)
+{
+	fprintf(stderr, "%s(%d): check failed: %s\n", file, line, expression);
+	sCheckFailures++;
+}
+
+// One job system shared by every benchmark that needs workers, so they're only started once
+JobSystem& GetBenchJobSystem()
+{
+	static JobSystem sJobSystem;
+	return sJobSystem;
+}
@@ -0,0 +1,146 @@
+// Microbenchmark harness
+// A benchmark is a function that runs its operation state.iterations times. The harness first
+// finds an iteration count that takes long enough to time reliably, then takes a number of
+// samples at that count. Results are the median time per operation, with the minimum and the
+// median absolute deviation as a measure of noise, plus heap allocations per operation.
+//
+// MICRO_BENCH("Group.Name") { for (uint64_t i = 0; i < state.iterations; i++) { ... } }
+//
+// Tests are registered the same way and run instead of the benchmarks with -test. A failed
+// MICRO_CHECK prints its expression and line, and the test carries on to report any others.
+//
+// MICRO_TEST("Group.Name") { MICRO_CHECK(value == expected); }
+//
+// Only uses the standard library, so builds on any platform the primitives it covers do.
+
+#pragma once
+
+#include "Clock.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+class JobSystem;
+
+// A value reported alongside the timings. Names must outlive the run, e.g. string literals.
+struct BenchCounter
+{
+	const char* name;
+	double value;
+};
+
+class BenchState
+{
+public:
+	static const unsigned int MaxCounters = 4;
+
+	BenchState(uint64_t iterationCount, const IClock* clock) :
+		iterations(iterationCount), mClock(clock), mStart(clock->Now()), mCounterCount(0) {}
+
+	// Call after any setup, so only the loop is timed
+	void ResetTimer() { mStart = mClock->Now(); }
+
+	// Reports a value with the results, e.g. how much work an optimisation saved. Setting the
+	// same name again replaces it. Values from the last sample are the ones reported.
+	void SetCounter(const char* name, double value);
+
+	// Getters
+	int64_t GetStartTime() const { return mStart; }
+	unsigned int GetCounterCount() const { return mCounterCount; }
+	const BenchCounter& GetCounter(unsigned int index) const { return mCounters[index]; }
+
+	// How many times to run the operation
+	const uint64_t iterations;
+
+	// Items handled per operation, for items/s in the results (e.g. points transformed)
+	uint64_t itemsPerIteration = 1;
+
+private:
+	const IClock* mClock;
+	int64_t mStart;
+	BenchCounter mCounters[MaxCounters];
+	unsigned int mCounterCount;
+};
+
+typedef void (*BenchFunction)(BenchState& state);
+
+struct BenchResult
+{
+	std::string name;
+	uint64_t iterations;		// Per sample
+	unsigned int samples;
+	double nsPerOp;				// Median
+	double minNsPerOp;
+	double madNsPerOp;			// Median absolute deviation
+	double itemsPerSecond;		// From the median
+	double allocationsPerOp;
+	double bytesPerOp;
+	std::vector<BenchCounter> counters;
+};
+
+struct BenchSettings
+{
+	unsigned int samples = 15;
+	int64_t minSampleTime = 10 * NanosecondsPerMillisecond;
+	std::string filter;		// Only benchmarks with names containing this are run
+};
+
+// Adds a benchmark to the list. Used by MICRO_BENCH, from static initialisers.
+bool RegisterMicroBench(const char* name, BenchFunction function);
+
+// Runs every registered benchmark matching the filter, in name order, printing progress to stdout
+std::vector<BenchResult> RunMicroBenches(const BenchSettings& settings);
+
+bool WriteBenchResultsJson(FILE* file, const std::vector<BenchResult>& results);
+
+typedef void (*TestFunction)();
+
+// Adds a test to the list. Used by MICRO_TEST, from static initialisers.
+bool RegisterMicroTest(const char* name, TestFunction function);
+
+// Runs every registered test matching the filter, in name order, printing each one's result.
+// Returns how many failed, or -1 if none matched.
+int RunMicroTests(const std::string& filter);
+
+// Called by MICRO_CHECK when a check fails, from any thread
+void ReportCheckFailure(const char* expression, const char* file, int line);
+
+// One job system shared by every benchmark that needs workers, so they're only started once
+JobSystem& GetBenchJobSystem();
+
+// Keeps a value the optimiser would otherwise remove as unused
+template<typename T>
+inline void DoNotOptimize(const T& value)
+{
+#if defined(_MSC_VER)
+	static const void* volatile sSink;
+	sSink = &value;
+	_ReadWriteBarrier();
+#else
+	asm volatile("" : : "r,m"(value) : "memory");
+#endif
+}
+
+#define MICRO_BENCH_CONCAT_INNER(a, b) a##b
+#define MICRO_BENCH_CONCAT(a, b) MICRO_BENCH_CONCAT_INNER(a, b)
+
+#define MICRO_BENCH(name) \
+	static void MICRO_BENCH_CONCAT(MicroBench, __LINE__)(BenchState& state); \
+	static const bool MICRO_BENCH_CONCAT(sMicroBenchRegistered, __LINE__) = \
+		RegisterMicroBench(name, MICRO_BENCH_CONCAT(MicroBench, __LINE__)); \
+	static void MICRO_BENCH_CONCAT(MicroBench, __LINE__)(BenchState& state)
+
+#define MICRO_TEST(name) \
+	static void MICRO_BENCH_CONCAT(MicroTest, __LINE__)(); \
+	static const bool MICRO_BENCH_CONCAT(sMicroTestRegistered, __LINE__) = \
+		RegisterMicroTest(name, MICRO_BENCH_CONCAT(MicroTest, __LINE__)); \
+	static void MICRO_BENCH_CONCAT(MicroTest, __LINE__)()
+
+#define MICRO_CHECK(condition) \
+	do { if (!(condition)) { ReportCheckFailure(#condition, __FILE__, __LINE__); } } while (false)
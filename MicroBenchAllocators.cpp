@@ -0,0 +1,440 @@
+// Allocator, container and queue benchmarks, and the allocators' tests
+
+#include "MicroBench.h"
+#include "AllocationCounter.h"
+#include "Benchmark.h"
+#include "BuddyAllocator.h"
+#include "FencedPool.h"
+#include "FrameArena.h"
+#include "JobSystem.h"
+#include "ReadbackRing.h"
+#include "SlotMap.h"
+#include "TaskGraph.h"
+
+#include <atomic>
+#include <iterator>
+#include <map>
+#include <unordered_map>
+
+namespace
+{
+	const uint64_t BuddyCapacity = 16 * 1024 * 1024;
+	const uint64_t BuddyMinBlockSize = 256;
+	const unsigned int LiveAllocationCount = 256;
+	const unsigned int JobBatchSize = 256;
+	const unsigned int SlotMapSize = 4096;
+
+	const uint64_t StressCapacity = 1024 * 1024;
+	const unsigned int StressSeedCount = 8;
+	const unsigned int StressOperationCount = 20000;
+
+	// Frames to run before steady state, covering every frame shape in each arena of the ring
+	const unsigned int FrameShapeCount = 7;
+	const unsigned int WarmUpFrames = FrameArenas::FrameCount * FrameShapeCount;
+	const unsigned int SteadyFrames = 64;
+
+	// Checks the allocator's accounting against the blocks the test knows are allocated
+	void CheckBuddyStats(const BuddyAllocator& allocator, const std::map<uint64_t, uint64_t>& blocks)
+	{
+		uint64_t allocatedBytes = 0;
+		for (const auto& block : blocks)
+		{
+			allocatedBytes += block.second;
+		}
+
+		const BuddyAllocator::Stats stats = allocator.GetStats();
+		MICRO_CHECK(stats.allocatedBytes == allocatedBytes);
+		MICRO_CHECK(stats.freeBytes == StressCapacity - allocatedBytes);
+		MICRO_CHECK(stats.allocationCount == blocks.size());
+		MICRO_CHECK(stats.largestFreeBlock <= stats.freeBytes);
+	}
+}
+
+// The general purpose heap, for comparison
+MICRO_BENCH("Alloc.NewDelete.64B")
+{
+	for (uint64_t i = 0; i < state.iterations; i++)
+	{
+		char* memory = new char[64];
+		DoNotOptimize(memory);
+		delete[] memory;
+	}
+}
+
+// Allocation and free with nothing else allocated, the best case
+MICRO_BENCH("Alloc.BuddyAllocator.AllocateFree")
+{
+	BuddyAllocator allocator(BuddyCapacity, BuddyMinBlockSize);
+	for (uint64_t i = 0; i < state.iterations; i++)
+	{
+		const uint64_t offset = allocator.Allocate(4096);
+		DoNotOptimize(offset);
+		allocator.Free(offset);
+	}
+}
+
+// Random sizes freed in random order, with a set of allocations kept live to fragment the free lists
+MICRO_BENCH("Alloc.BuddyAllocator.Churn")
+{
+	BuddyAllocator allocator(BuddyCapacity, BuddyMinBlockSize);
+	SeededRandom random(1);
+	std::vector<uint64_t> live(LiveAllocationCount);
+	for (uint64_t& offset : live)
+	{
+		offset = allocator.Allocate(BuddyMinBlockSize << (random.Next() % 8));
+	}
+	state.ResetTimer();
+
+	for (uint64_t i = 0; i < state.iterations; i++)
+	{
+		uint64_t& offset = live[random.Next() % LiveAllocationCount];
+		allocator.Free(offset);
+		offset = allocator.Allocate(BuddyMinBlockSize << (random.Next() % 8));
+	}
+}
+
+// Random sizes allocated and freed in random order from several seeds. Every block must be
+// aligned to its own size and overlap no other, the free bytes must add up, and once everything
+// is freed the buddies must have merged back into the one block the allocator started with.
+MICRO_TEST("Alloc.BuddyAllocator.Stress")
+{
+	for (uint32_t seed = 1; seed <= StressSeedCount; seed++)
+	{
+		BuddyAllocator allocator(StressCapacity, BuddyMinBlockSize);
+		SeededRandom random(seed);
+		std::map<uint64_t, uint64_t> blocks;		// Offset to block size
+		std::vector<uint64_t> offsets;
+
+		for (unsigned int operation = 0; operation < StressOperationCount; operation++)
+		{
+			// Mostly small sizes, not powers of two, with the odd large one
+			const bool allocate = offsets.empty() || random.Next() % 100 < 55;
+			if (allocate)
+			{
+				const uint64_t maxSize = random.Next() % 16 == 0 ? StressCapacity / 4 : 16 * 1024;
+				const uint64_t size = 1 + random.Next() % maxSize;
+				const uint64_t offset = allocator.Allocate(size);
+				if (offset == BuddyAllocator::InvalidOffset)
+				{
+					MICRO_CHECK(!allocator.CanAllocate(size));
+					continue;
+				}
+
+				const uint64_t blockSize = allocator.GetAllocatedBlockSize(offset);
+				MICRO_CHECK(blockSize == allocator.GetBlockSizeFor(size));
+				MICRO_CHECK(blockSize >= size && blockSize >= BuddyMinBlockSize);
+				MICRO_CHECK(offset % blockSize == 0);
+				MICRO_CHECK(offset + blockSize <= StressCapacity);
+
+				// The blocks either side must end before it starts and start after it ends
+				auto next = blocks.lower_bound(offset);
+				MICRO_CHECK(next == blocks.end() || next->first >= offset + blockSize);
+				if (next != blocks.begin())
+				{
+					auto previous = std::prev(next);
+					MICRO_CHECK(previous->first + previous->second <= offset);
+				}
+
+				blocks[offset] = blockSize;
+				offsets.push_back(offset);
+			}
+			else
+			{
+				const size_t index = random.Next() % offsets.size();
+				const uint64_t offset = offsets[index];
+				offsets[index] = offsets.back();
+				offsets.pop_back();
+
+				allocator.Free(offset);
+				blocks.erase(offset);
+				MICRO_CHECK(allocator.GetAllocatedBlockSize(offset) == 0);
+			}
+
+			if (operation % 64 == 0)
+			{
+				CheckBuddyStats(allocator, blocks);
+			}
+		}
+		CheckBuddyStats(allocator, blocks);
+
+		while (!offsets.empty())
+		{
+			const size_t index = random.Next() % offsets.size();
+			allocator.Free(offsets[index]);
+			offsets[index] = offsets.back();
+			offsets.pop_back();
+		}
+
+		const BuddyAllocator::Stats stats = allocator.GetStats();
+		MICRO_CHECK(allocator.IsEmpty());
+		MICRO_CHECK(stats.freeBytes == StressCapacity);
+		MICRO_CHECK(stats.freeBlockCount == 1);
+		MICRO_CHECK(stats.largestFreeBlock == StressCapacity);
+		MICRO_CHECK(stats.fragmentation == 0.0f);
+		MICRO_CHECK(allocator.Allocate(StressCapacity) == 0);
+	}
+}
+
+MICRO_BENCH("Alloc.LinearArena.64B")
+{
+	LinearArena arena;
+	for (uint64_t i = 0; i < state.iterations; i++)
+	{
+		void* memory = arena.Allocate(64);
+		DoNotOptimize(memory);
+		if ((i & 1023) == 1023)
+		{
+			arena.Reset();
+		}
+	}
+}
+
+// A frame's worth of list building, from the arena and from the heap
+MICRO_BENCH("Alloc.ScratchVector.Frame")
+{
+	LinearArena arena;
+	for (uint64_t i = 0; i < state.iterations; i++)
+	{
+		arena.Reset();
+		ScratchVector<uint32_t> list((ArenaAllocator<uint32_t>(&arena)));
+		for (uint32_t item = 0; item < 256; item++)
+		{
+			list.push_back(item);
+		}
+		DoNotOptimize(list.data());
+	}
+}
+
+MICRO_BENCH("Alloc.StdVector.Frame")
+{
+	for (uint64_t i = 0; i < state.iterations; i++)
+	{
+		std::vector<uint32_t> list;
+		for (uint32_t item = 0; item < 256; item++)
+		{
+			list.push_back(item);
+		}
+		DoNotOptimize(list.data());
+	}
+}
+
+// The shape of a frame's CPU work on the frame arenas: a visible object list, a map of resource
+// states like the state tracker's, and a pass list whose passes each have their own lists. The
+// sizes change from frame to frame, but once every shape has been seen no frame allocates.
+MICRO_TEST("Alloc.FrameArenas.NoSteadyAllocations")
+{
+	FrameArenas arenas(0);
+	AllocationCounts start = {};
+	for (unsigned int frame = 0; frame < WarmUpFrames + SteadyFrames; frame++)
+	{
+		if (frame == WarmUpFrames)
+		{
+			start = GetAllocationCounts();
+		}
+
+		arenas.BeginFrame();
+		LinearArena& arena = arenas.GetThreadArena();
+		const unsigned int shape = frame % FrameShapeCount;
+
+		ScratchVector<uint32_t> visible((ArenaAllocator<uint32_t>(&arena)));
+		for (uint32_t object = 0; object < 1000 + shape * 300; object++)
+		{
+			visible.push_back(object);
+		}
+
+		ScratchUnorderedMap<const void*, uint32_t> states((ArenaAllocator<std::pair<const void* const, uint32_t>>(&arena)));
+		for (uintptr_t resource = 1; resource <= 64 + shape * 16; resource++)
+		{
+			states[reinterpret_cast<const void*>(resource * 256)] = static_cast<uint32_t>(resource);
+		}
+
+		ScratchVector<ScratchVector<uint32_t>> passes((ArenaAllocator<ScratchVector<uint32_t>>(&arena)));
+		for (unsigned int pass = 0; pass < 8 + shape; pass++)
+		{
+			passes.emplace_back(ArenaAllocator<uint32_t>(&arena));
+			for (uint32_t resource = 0; resource < 4 + (pass + shape) % 5; resource++)
+			{
+				passes.back().push_back(resource);
+			}
+		}
+
+		DoNotOptimize(visible.data());
+		DoNotOptimize(states.size());
+		DoNotOptimize(passes.data());
+	}
+
+	const AllocationCounts end = GetAllocationCounts();
+	MICRO_CHECK(end.allocations == start.allocations);
+	MICRO_CHECK(end.bytes == start.bytes);
+}
+
+// Handle lookups over a few thousand live values, in random order
+MICRO_BENCH("Container.SlotMap.Get")
+{
+	SlotMap<uint64_t> map;
+	std::vector<SlotMap<uint64_t>::Handle> handles;
+	for (uint64_t value = 0; value < SlotMapSize; value++)
+	{
+		handles.push_back(map.Insert(value));
+	}
+	SeededRandom random(1);
+	state.ResetTimer();
+
+	uint64_t sum = 0;
+	for (uint64_t i = 0; i < state.iterations; i++)
+	{
+		sum += *map.Get(handles[random.Next() % SlotMapSize]);
+	}
+	DoNotOptimize(sum);
+}
+
+// The same lookups through a hash map keyed by ID, for comparison
+MICRO_BENCH("Container.UnorderedMap.Get")
+{
+	std::unordered_map<uint32_t, uint64_t> map;
+	for (uint32_t key = 0; key < SlotMapSize; key++)
+	{
+		map[key * 2654435761u] = key;
+	}
+	SeededRandom random(1);
+	state.ResetTimer();
+
+	uint64_t sum = 0;
+	for (uint64_t i = 0; i < state.iterations; i++)
+	{
+		sum += map.find(static_cast<uint32_t>(random.Next() % SlotMapSize) * 2654435761u)->second;
+	}
+	DoNotOptimize(sum);
+}
+
+// Lookups through handles whose values have all been erased
+MICRO_BENCH("Container.SlotMap.GetStale")
+{
+	SlotMap<uint64_t> map;
+	std::vector<SlotMap<uint64_t>::Handle> handles;
+	for (uint64_t value = 0; value < SlotMapSize; value++)
+	{
+		handles.push_back(map.Insert(value));
+	}
+	map.Clear();
+	SeededRandom random(1);
+	state.ResetTimer();
+
+	uint64_t misses = 0;
+	for (uint64_t i = 0; i < state.iterations; i++)
+	{
+		misses += map.Get(handles[random.Next() % SlotMapSize]) == nullptr;
+	}
+	DoNotOptimize(misses);
+}
+
+// Each iteration erases a random value and inserts a new one, reusing the freed slot
+MICRO_BENCH("Container.SlotMap.InsertErase")
+{
+	SlotMap<uint64_t> map;
+	std::vector<SlotMap<uint64_t>::Handle> handles;
+	for (uint64_t value = 0; value < SlotMapSize; value++)
+	{
+		handles.push_back(map.Insert(value));
+	}
+	SeededRandom random(1);
+	state.ResetTimer();
+
+	for (uint64_t i = 0; i < state.iterations; i++)
+	{
+		SlotMap<uint64_t>::Handle& handle = handles[random.Next() % SlotMapSize];
+		map.Erase(handle);
+		handle = map.Insert(i);
+	}
+	DoNotOptimize(map.Size());
+}
+
+// Each iteration is a frame taking one object and handing it back, with a simulated fence
+// running two frames behind, so objects are recycled rather than created
+MICRO_BENCH("Queue.FencedPool.AcquireRelease")
+{
+	FencedPool<uint64_t> pool;
+	uint64_t created = 0;
+	for (uint64_t i = 0; i < state.iterations; i++)
+	{
+		const uint64_t fenceValue = i + 1;
+		const uint64_t completedFenceValue = fenceValue > 2 ? fenceValue - 2 : 0;
+		const uint64_t object = pool.Acquire(completedFenceValue, [&created]() { return created++; });
+		pool.Release(object, fenceValue);
+	}
+	DoNotOptimize(pool.GetStats().createdCount);
+}
+
+// A capture every frame, read back two frames later, as the frame capture uses the ring
+MICRO_BENCH("Queue.ReadbackRing.Cycle")
+{
+	ReadbackRing ring(3);
+	for (uint64_t i = 0; i < state.iterations; i++)
+	{
+		const uint64_t fenceValue = i + 1;
+		const unsigned int slot = ring.Acquire(fenceValue);
+		if (slot != ReadbackRing::InvalidSlot)
+		{
+			ring.Submit(slot, fenceValue);
+		}
+
+		const uint64_t completedFenceValue = fenceValue > 2 ? fenceValue - 2 : 0;
+		for (unsigned int completed = ring.PopCompleted(completedFenceValue); completed != ReadbackRing::InvalidSlot; completed = ring.PopCompleted(completedFenceValue))
+		{
+			ring.Release(completed);
+		}
+	}
+	DoNotOptimize(ring.GetStats().completedCount);
+}
+
+// Each iteration is one job submitted and run. Batches are waited for so the queue doesn't grow unbounded.
+MICRO_BENCH("Queue.JobSystem.SubmitRun")
+{
+	JobSystem& jobSystem = GetBenchJobSystem();
+	std::atomic<uint64_t> completed(0);
+
+	for (uint64_t i = 0; i < state.iterations; i++)
+	{
+		jobSystem.Submit([&completed]() { completed.fetch_add(1, std::memory_order_relaxed); });
+		if ((i + 1) % JobBatchSize == 0)
+		{
+			jobSystem.WaitIdle();
+		}
+	}
+	jobSystem.WaitIdle();
+	DoNotOptimize(completed.load());
+}
+
+// Each iteration builds and runs a startup-shaped graph: two roots fanning out to four tasks
+// on workers and one on the calling thread, joined by a last task. Measures scheduling overhead.
+MICRO_BENCH("Queue.TaskGraph.Run")
+{
+	JobSystem& jobSystem = GetBenchJobSystem();
+	SystemClock clock;
+	std::atomic<uint64_t> completed(0);
+	auto task = [&completed]() { completed.fetch_add(1, std::memory_order_relaxed); };
+
+	for (uint64_t i = 0; i < state.iterations; i++)
+	{
+		TaskGraph graph;
+		const TaskGraph::TaskId device = graph.AddTask("Device", task);
+		const TaskGraph::TaskId shaders = graph.AddTask("Shaders", task);
+		const TaskGraph::TaskId a = graph.AddTask("A", task, { device });
+		const TaskGraph::TaskId b = graph.AddTask("B", task, { device });
+		const TaskGraph::TaskId c = graph.AddTask("C", task, { device, shaders });
+		const TaskGraph::TaskId d = graph.AddTask("D", task, { shaders });
+		const TaskGraph::TaskId window = graph.AddTask("Window", task, { device }, TaskThread_Main);
+		graph.AddTask("Join", task, { a, b, c, d, window });
+		graph.Run(jobSystem, clock);
+	}
+	DoNotOptimize(completed.load());
+}
+
+MICRO_BENCH("Queue.JobSystem.WaitIdle")
+{
+	JobSystem& jobSystem = GetBenchJobSystem();
+	for (uint64_t i = 0; i < state.iterations; i++)
+	{
+		jobSystem.WaitIdle();
+	}
+}
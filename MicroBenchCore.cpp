@@ -0,0 +1,516 @@
+// Core benchmarks - input, timing, alignment, hashing, compression, frame statistics, the debug HUD and debug drawing,
+// with tests for the frame statistics
+
+#include "MicroBench.h"
+#include "Align.h"
+#include "Benchmark.h"
+#include "Compression.h"
+#include "DebugDraw.h"
+#include "DebugHudPanels.h"
+#include "FixedStepScheduler.h"
+#include "FramePacer.h"
+#include "FrameStats.h"
+#include "Hash.h"
+#include "Input.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+#include "Timer.h"
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+
+namespace
+{
+	const size_t DataSize = 64 * 1024;
+	const uint32_t DebugLineCount = 100000;
+
+	// Repetitive enough to compress, like most asset data
+	void MakeData(std::vector<uint8_t>& data)
+	{
+		SeededRandom random(1);
+		data.resize(DataSize);
+		for (size_t i = 0; i < DataSize; i++)
+		{
+			data[i] = static_cast<uint8_t>((i / 16) % 32 + (random.Next() % 4));
+		}
+	}
+
+	// Reads back everything written to a temporary file
+	std::string ReadAll(FILE* file)
+	{
+		std::string text;
+		rewind(file);
+		char buffer[4096];
+		size_t read;
+		while ((read = fread(buffer, 1, sizeof(buffer), file)) > 0)
+		{
+			text.append(buffer, read);
+		}
+		return text;
+	}
+
+	size_t CountOf(const std::string& text, const char* pattern)
+	{
+		size_t count = 0;
+		const size_t length = strlen(pattern);
+		for (size_t at = text.find(pattern); at != std::string::npos; at = text.find(pattern, at + length))
+		{
+			count++;
+		}
+		return count;
+	}
+}
+
+// A key press and release as it comes through the window procedure, then is read by the app
+MICRO_BENCH("Input.KeyEvents")
+{
+	InitInput();
+	for (uint64_t i = 0; i < state.iterations; i++)
+	{
+		const EKeyCode key = static_cast<EKeyCode>(Key_A + i % 26);
+		KeyDownEvent(key);
+		bool hit = KeyHit(key);
+		KeyDownEvent(key);
+		bool held = KeyHeld(key);
+		KeyUpEvent(key);
+		DoNotOptimize(hit);
+		DoNotOptimize(held);
+	}
+}
+
+MICRO_BENCH("Input.MouseMove")
+{
+	InitInput();
+	for (uint64_t i = 0; i < state.iterations; i++)
+	{
+		MouseMoveEvent(static_cast<int>(i & 1023), static_cast<int>(i >> 10 & 1023));
+		int x = GetMouseX();
+		DoNotOptimize(x);
+	}
+}
+
+MICRO_BENCH("Timing.SystemClock.Now")
+{
+	SystemClock clock;
+	for (uint64_t i = 0; i < state.iterations; i++)
+	{
+		int64_t now = clock.Now();
+		DoNotOptimize(now);
+	}
+}
+
+MICRO_BENCH("Timing.Timer.Tick")
+{
+	Timer timer;
+	timer.Reset();
+	for (uint64_t i = 0; i < state.iterations; i++)
+	{
+		timer.Tick();
+		float deltaTime = timer.GetDeltaTime();
+		DoNotOptimize(deltaTime);
+	}
+}
+
+MICRO_BENCH("Timing.FixedStepScheduler.Advance")
+{
+	FixedStepScheduler scheduler(NanosecondsPerSecond / 60, 4);
+	for (uint64_t i = 0; i < state.iterations; i++)
+	{
+		// Varying frame times around the step time
+		unsigned int steps = scheduler.Advance(12 * NanosecondsPerMillisecond + static_cast<int64_t>(i % 9) * NanosecondsPerMillisecond);
+		float alpha = scheduler.GetAlpha();
+		DoNotOptimize(steps);
+		DoNotOptimize(alpha);
+	}
+}
+
+MICRO_BENCH("Timing.FramePacer.Frame")
+{
+	ManualClock clock;
+	FramePacer pacer(&clock);
+	FramePacerSettings settings;
+	settings.frameLimitHz = 120.0;
+	pacer.SetSettings(settings);
+
+	for (uint64_t i = 0; i < state.iterations; i++)
+	{
+		pacer.BeginFrame();
+		clock.Advance(5 * NanosecondsPerMillisecond);
+		pacer.EndFrame(1);
+	}
+}
+
+// The sort of sizes CalculateConstantBufferByteSize is given
+MICRO_BENCH("Align.ConstantBufferSize")
+{
+	for (uint64_t i = 0; i < state.iterations; i++)
+	{
+		uint32_t size = AlignUp<uint32_t>(static_cast<uint32_t>(i & 0xFFFF), 256);
+		DoNotOptimize(size);
+	}
+}
+
+MICRO_BENCH("Hash.HashBytes.64KB")
+{
+	std::vector<uint8_t> data;
+	MakeData(data);
+	state.itemsPerIteration = DataSize;
+	state.ResetTimer();
+
+	for (uint64_t i = 0; i < state.iterations; i++)
+	{
+		uint64_t hash = HashBytes(data.data(), data.size());
+		DoNotOptimize(hash);
+	}
+}
+
+MICRO_BENCH("Compression.CompressLZ.64KB")
+{
+	std::vector<uint8_t> data;
+	MakeData(data);
+	std::vector<uint8_t> compressed(CompressBound(DataSize));
+	state.itemsPerIteration = DataSize;
+	state.ResetTimer();
+
+	for (uint64_t i = 0; i < state.iterations; i++)
+	{
+		size_t size = CompressLZ(data.data(), data.size(), compressed.data(), compressed.size());
+		DoNotOptimize(size);
+	}
+}
+
+MICRO_BENCH("Compression.DecompressLZ.64KB")
+{
+	std::vector<uint8_t> data;
+	MakeData(data);
+	std::vector<uint8_t> compressed(CompressBound(DataSize));
+	compressed.resize(CompressLZ(data.data(), data.size(), compressed.data(), compressed.size()));
+	state.itemsPerIteration = DataSize;
+	state.ResetTimer();
+
+	for (uint64_t i = 0; i < state.iterations; i++)
+	{
+		bool succeeded = DecompressLZ(compressed.data(), compressed.size(), data.data(), data.size());
+		DoNotOptimize(succeeded);
+	}
+}
+
+MICRO_BENCH("FrameStats.LogHistogram.Record")
+{
+	LogHistogram histogram;
+	SeededRandom random(1);
+	for (uint64_t i = 0; i < state.iterations; i++)
+	{
+		histogram.Record(random.Next() >> 8);
+	}
+	DoNotOptimize(histogram.GetCount());
+}
+
+MICRO_BENCH("FrameStats.Frame")
+{
+	FrameStats stats;
+	for (uint64_t i = 0; i < state.iterations; i++)
+	{
+		const int64_t time = 16 * NanosecondsPerMillisecond + static_cast<int64_t>(i % 1000) * 1000;
+		stats.Record(FrameStat_Cpu, time);
+		stats.Record(FrameStat_Gpu, time / 2);
+		stats.Record(FrameStat_Present, time);
+		stats.EndFrame();
+	}
+	DoNotOptimize(stats.GetFrameCount());
+}
+
+MICRO_BENCH("FrameStats.WindowSummary")
+{
+	FrameStats stats;
+	for (unsigned int frame = 0; frame < 1000; frame++)
+	{
+		stats.Record(FrameStat_Cpu, 16 * NanosecondsPerMillisecond + frame * 1000);
+		stats.EndFrame();
+	}
+	state.ResetTimer();
+
+	for (uint64_t i = 0; i < state.iterations; i++)
+	{
+		FrameStatsSummary summary = stats.GetWindowSummary(FrameStat_Cpu);
+		DoNotOptimize(summary);
+	}
+}
+
+// Percentiles from the histogram against the same ranks in the sorted values. The answer should
+// be the top of the bucket the exact value falls in, so no more than 1/16 above it.
+MICRO_TEST("FrameStats.PercentilesMatchSorted")
+{
+	const double percentiles[] = { 0.0, 1.0, 50.0, 90.0, 99.0, 99.9, 100.0 };
+	const uint32_t sampleCounts[] = { 1, 7, 1000, 100000 };
+
+	SeededRandom random(1);
+	for (uint32_t sampleCount : sampleCounts)
+	{
+		// Frame-time-like values from about 1us to 100ms, spread over many powers of two
+		std::vector<uint64_t> values(sampleCount);
+		LogHistogram histogram;
+		for (uint64_t& value : values)
+		{
+			value = 1000 + (static_cast<uint64_t>(random.Next()) >> (random.Next() % 16)) / 40;
+			histogram.Record(value);
+		}
+		std::sort(values.begin(), values.end());
+		MICRO_CHECK(histogram.GetCount() == sampleCount);
+		MICRO_CHECK(histogram.GetMax() == values.back());
+
+		for (double percentile : percentiles)
+		{
+			const uint64_t rank = (std::max)(static_cast<uint64_t>(percentile / 100.0 * sampleCount + 0.5), static_cast<uint64_t>(1));
+			const uint64_t exact = values[rank - 1];
+			const uint64_t result = histogram.GetValueAtPercentile(percentile);
+			const uint64_t upper = LogHistogram::GetBucketUpperBound(LogHistogram::GetBucketIndex(exact));
+			MICRO_CHECK(result == (std::min)(upper, values.back()));
+			MICRO_CHECK(result >= exact && result - exact <= exact / LogHistogram::SubBucketCount);
+		}
+	}
+
+	// Every value lands in a bucket that contains it, and the buckets don't overlap
+	for (unsigned int bucket = 0; bucket + 1 < LogHistogram::BucketCount; bucket++)
+	{
+		MICRO_CHECK(LogHistogram::GetBucketLowerBound(bucket) <= LogHistogram::GetBucketUpperBound(bucket));
+		MICRO_CHECK(LogHistogram::GetBucketUpperBound(bucket) + 1 == LogHistogram::GetBucketLowerBound(bucket + 1));
+	}
+	for (unsigned int i = 0; i < 10000; i++)
+	{
+		const uint64_t value = static_cast<uint64_t>(random.Next()) << (random.Next() % 32);
+		const unsigned int bucket = LogHistogram::GetBucketIndex(value);
+		MICRO_CHECK(LogHistogram::GetBucketLowerBound(bucket) <= value && value <= LogHistogram::GetBucketUpperBound(bucket));
+	}
+}
+
+// Slow frames drop out of the window once every slice has been reused, but stay in the totals
+MICRO_TEST("FrameStats.WindowEvictsOldSlices")
+{
+	const int64_t slowTime = 100 * NanosecondsPerMillisecond;
+	const int64_t fastTime = NanosecondsPerMillisecond;
+	const unsigned int windowFrames = FrameStats::FramesPerSlice * FrameStats::SliceCount;
+
+	FrameStats stats;
+	for (unsigned int frame = 0; frame < FrameStats::FramesPerSlice; frame++)
+	{
+		stats.Record(FrameStat_Cpu, slowTime);
+		stats.EndFrame();
+	}
+	for (unsigned int frame = FrameStats::FramesPerSlice; frame < windowFrames - 1; frame++)
+	{
+		stats.Record(FrameStat_Cpu, fastTime);
+		stats.EndFrame();
+	}
+
+	// One frame short of the window wrapping, the slow slice is still in it
+	FrameStatsSummary window = stats.GetWindowSummary(FrameStat_Cpu);
+	MICRO_CHECK(window.count == windowFrames - 1);
+	MICRO_CHECK(window.max == 100.0);
+	MICRO_CHECK(window.p99 == 100.0);
+
+	stats.Record(FrameStat_Cpu, fastTime);
+	stats.EndFrame();
+
+	window = stats.GetWindowSummary(FrameStat_Cpu);
+	MICRO_CHECK(window.count == windowFrames - FrameStats::FramesPerSlice);
+	MICRO_CHECK(window.max == 1.0);
+	MICRO_CHECK(window.p50 == 1.0);
+
+	const FrameStatsSummary total = stats.GetTotalSummary(FrameStat_Cpu);
+	MICRO_CHECK(total.count == windowFrames);
+	MICRO_CHECK(total.max == 100.0);
+	MICRO_CHECK(stats.GetFrameCount() == windowFrames);
+	MICRO_CHECK(stats.GetWindowSummary(FrameStat_Gpu).count == 0);
+
+	stats.Reset();
+	MICRO_CHECK(stats.GetFrameCount() == 0);
+	MICRO_CHECK(stats.GetWindowSummary(FrameStat_Cpu).count == 0);
+	MICRO_CHECK(stats.GetTotalSummary(FrameStat_Cpu).count == 0);
+}
+
+// The exported totals for a run with a known CPU time and GPU times in two buckets
+MICRO_TEST("FrameStats.CsvAndJsonOutput")
+{
+	FrameStats stats;
+	for (unsigned int frame = 0; frame < 10; frame++)
+	{
+		stats.Record(FrameStat_Cpu, 16 * NanosecondsPerMillisecond);
+		stats.Record(FrameStat_Gpu, (frame < 5 ? 4 : 8) * NanosecondsPerMillisecond);
+		stats.EndFrame();
+	}
+
+	FILE* file = tmpfile();
+	MICRO_CHECK(file != nullptr);
+	if (file == nullptr)
+	{
+		return;
+	}
+	MICRO_CHECK(stats.WriteCsv(file));
+	const std::string csv = ReadAll(file);
+	fclose(file);
+
+	MICRO_CHECK(csv.find("stat,count,p50_ms,p90_ms,p99_ms,p99.9_ms,max_ms\n") == 0);
+	MICRO_CHECK(CountOf(csv, "cpu,10,16.0000,16.0000,16.0000,16.0000,16.0000\n") == 1);
+	MICRO_CHECK(CountOf(csv, "present,0,0.0000,0.0000,0.0000,0.0000,0.0000\n") == 1);
+	MICRO_CHECK(CountOf(csv, "\nstat,bucket_min_ms,bucket_max_ms,count\n") == 1);
+	MICRO_CHECK(CountOf(csv, ",10\n") == 1);		// CPU bucket
+	MICRO_CHECK(CountOf(csv, ",5\n") == 2);		// GPU buckets
+	MICRO_CHECK(CountOf(csv, "\n") == 1 + NumFrameStats + 2 + 3);
+
+	file = tmpfile();
+	MICRO_CHECK(file != nullptr);
+	if (file == nullptr)
+	{
+		return;
+	}
+	MICRO_CHECK(stats.WriteJson(file));
+	const std::string json = ReadAll(file);
+	fclose(file);
+
+	MICRO_CHECK(json.find("{\n  \"frames\": 10,") == 0);
+	MICRO_CHECK(CountOf(json, "{") == CountOf(json, "}"));
+	MICRO_CHECK(CountOf(json, "[") == CountOf(json, "]"));
+	MICRO_CHECK(CountOf(json, "\"cpu\": {") == 1);
+	MICRO_CHECK(CountOf(json, "\"gpu\": {") == 1);
+	MICRO_CHECK(CountOf(json, "\"present\": {") == 1);
+	MICRO_CHECK(CountOf(json, "\"count\": 10,") == 2);
+	MICRO_CHECK(CountOf(json, "\"p50_ms\": 16.0000") == 1);
+	MICRO_CHECK(CountOf(json, "\"max_ms\": 8.0000") == 1);
+	MICRO_CHECK(CountOf(json, "\"buckets\": []") == 1);		// Present has none
+	MICRO_CHECK(CountOf(json, ", 5]") == 2);
+	MICRO_CHECK(json.back() == '\n' && json[json.size() - 2] == '}');
+}
+
+MICRO_BENCH("Profiler.Zone")
+{
+	for (uint64_t i = 0; i < state.iterations; i++)
+	{
+		PROFILE_ZONE("MicroBench");
+	}
+	ResetProfileZones();
+}
+
+// A whole frame's HUD: the frame stats panel with both graphs full, and the profiler panel
+// with the zones this process has registered (about as many as the app has)
+MICRO_BENCH("Hud.BuildFrame")
+{
+	FrameStats stats;
+	FrameTimeHistory history;
+	for (unsigned int frame = 0; frame < 1000; frame++)
+	{
+		const int64_t time = 16 * NanosecondsPerMillisecond + frame * 1000;
+		stats.Record(FrameStat_Cpu, time);
+		stats.Record(FrameStat_Gpu, time / 2);
+		stats.Record(FrameStat_Present, time);
+		stats.EndFrame();
+		history.Add(static_cast<float>(NanosecondsToMilliseconds(time)), static_cast<float>(NanosecondsToMilliseconds(time / 2)));
+	}
+	{
+		PROFILE_ZONE("Update");
+		PROFILE_ZONE("PopulateCommandList");
+		PROFILE_ZONE("ScenePass");
+		PROFILE_ZONE("Present");
+		PROFILE_ZONE("WaitForGpu");
+		PROFILE_ZONE("DebugHud");
+	}
+	EndProfileFrame();
+
+	DebugHud hud;
+	state.ResetTimer();
+
+	for (uint64_t i = 0; i < state.iterations; i++)
+	{
+		hud.Reset();
+		const float height = AddFrameStatsPanel(hud, 8.0f, 8.0f, stats, history);
+		AddProfilerPanel(hud, 8.0f, 16.0f + height);
+		DoNotOptimize(hud.GetVertices());
+	}
+	ResetProfileZones();
+}
+
+// A frame of lines added from the main thread, then merged into one vertex list as for drawing
+MICRO_BENCH("DebugDraw.Lines.100k")
+{
+	DebugDraw debugDraw(0);
+	std::vector<DebugLineVertex> merged(DebugLineCount * 2);
+	auto addLines = [&debugDraw]()
+	{
+		for (uint32_t line = 0; line < DebugLineCount; line++)
+		{
+			const float a[3] = { static_cast<float>(line), 0.0f, 0.0f };
+			const float b[3] = { static_cast<float>(line), 1.0f, 0.0f };
+			debugDraw.AddLine(a, b, DebugColour(255, 255, 0));
+		}
+	};
+
+	// Grow the list first, as it will have after the first few frames
+	addLines();
+	state.itemsPerIteration = DebugLineCount;
+	state.ResetTimer();
+
+	for (uint64_t i = 0; i < state.iterations; i++)
+	{
+		debugDraw.Reset();
+		addLines();
+		debugDraw.CopyVertices(merged.data());
+		DoNotOptimize(merged.data());
+	}
+}
+
+// The same lines shared out over the workers and the calling thread, each adding to its own list
+MICRO_BENCH("DebugDraw.Lines.100k.Jobs")
+{
+	JobSystem& jobSystem = GetBenchJobSystem();
+	const uint32_t threadCount = jobSystem.GetThreadCount() + 1;
+	const uint32_t linesPerThread = DebugLineCount / threadCount;
+	DebugDraw debugDraw(jobSystem.GetThreadCount());
+	std::vector<DebugLineVertex> merged(DebugLineCount * 2);
+	state.itemsPerIteration = linesPerThread * threadCount;
+
+	auto addLines = [&debugDraw, linesPerThread](uint32_t first)
+	{
+		for (uint32_t line = first; line < first + linesPerThread; line++)
+		{
+			const float a[3] = { static_cast<float>(line), 0.0f, 0.0f };
+			const float b[3] = { static_cast<float>(line), 1.0f, 0.0f };
+			debugDraw.AddLine(a, b, DebugColour(255, 255, 0));
+		}
+	};
+
+	for (uint64_t i = 0; i < state.iterations; i++)
+	{
+		debugDraw.Reset();
+		for (uint32_t thread = 1; thread < threadCount; thread++)
+		{
+			jobSystem.Submit([&addLines, thread, linesPerThread]() { addLines(thread * linesPerThread); });
+		}
+		addLines(0);
+		jobSystem.WaitIdle();
+
+		debugDraw.CopyVertices(merged.data());
+		DoNotOptimize(merged.data());
+	}
+}
+
+// Bounds as they'd be shown for a scene: a box and a sphere per object, 1000 objects
+MICRO_BENCH("DebugDraw.Bounds.1k")
+{
+	DebugDraw debugDraw(0);
+	state.itemsPerIteration = 1000;
+
+	for (uint64_t i = 0; i < state.iterations; i++)
+	{
+		debugDraw.Reset();
+		for (uint32_t object = 0; object < 1000; object++)
+		{
+			const float centre[3] = { static_cast<float>(object % 32), 0.0f, static_cast<float>(object / 32) };
+			const float minimum[3] = { centre[0] - 0.5f, -0.5f, centre[2] - 0.5f };
+			const float maximum[3] = { centre[0] + 0.5f, 0.5f, centre[2] + 0.5f };
+			debugDraw.AddAabb(minimum, maximum, DebugColour(0, 255, 0));
+			debugDraw.AddSphere(centre, 0.7f, DebugColour(0, 128, 255));
+		}
+		DoNotOptimize(debugDraw.GetVertexCount());
+	}
+}
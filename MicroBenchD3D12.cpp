@@ -0,0 +1,447 @@
+// D3D12 bookkeeping tests - resource state tracking and render graph compiling, run without a
+// device. Resources are only ever used as keys, so made up pointers stand in for them.
+
+#include "MicroBench.h"
+#include "AllocationCounter.h"
+#include "Align.h"
+#include "FrameArena.h"
+#include "RenderGraph.h"
+#include "ResourceStateTracker.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace
+{
+	ID3D12Resource* FakeResource(uintptr_t id)
+	{
+		return reinterpret_cast<ID3D12Resource*>(id * 256);
+	}
+
+	bool IsTransition(const D3D12_RESOURCE_BARRIER& barrier, ID3D12Resource* resource, D3D12_RESOURCE_STATES before,
+		D3D12_RESOURCE_STATES after, D3D12_RESOURCE_BARRIER_FLAGS flags = D3D12_RESOURCE_BARRIER_FLAG_NONE)
+	{
+		return barrier.Type == D3D12_RESOURCE_BARRIER_TYPE_TRANSITION && barrier.Flags == flags &&
+			barrier.Transition.pResource == resource && barrier.Transition.StateBefore == before &&
+			barrier.Transition.StateAfter == after;
+	}
+
+	// What GetResourceAllocationInfo gives for simple textures: the texels, in 64KB pages
+	RenderGraph::AllocationInfo GetTextureAllocationInfo(const D3D12_RESOURCE_DESC& desc)
+	{
+		UINT64 texelSize = 4;
+		if (desc.Format == DXGI_FORMAT_R16G16B16A16_FLOAT)
+		{
+			texelSize = 8;
+		}
+
+		const UINT64 alignment = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+		RenderGraph::AllocationInfo info = { AlignUp(desc.Width * desc.Height * texelSize, alignment), alignment };
+		return info;
+	}
+
+	RenderGraph::TextureDesc MakeTextureDesc(UINT width, UINT height, DXGI_FORMAT format, D3D12_RESOURCE_FLAGS flags)
+	{
+		RenderGraph::TextureDesc desc = {};
+		desc.width = width;
+		desc.height = height;
+		desc.format = format;
+		desc.flags = flags;
+		desc.clearValue.Format = format;
+		return desc;
+	}
+
+	void NoExecute(ID3D12GraphicsCommandList*, const RenderGraph&)
+	{
+	}
+
+	// A deferred lighting frame, with a debug view nothing reads and a capture kept for its side
+	// effects. Fills in each texture's handle, and the passes are numbered in the order added.
+	struct TestFrame
+	{
+		RenderGraph::ResourceHandle gbuffer;
+		RenderGraph::ResourceHandle depth;
+		RenderGraph::ResourceHandle lit;
+		RenderGraph::ResourceHandle debugView;
+		RenderGraph::ResourceHandle bloom;
+		RenderGraph::ResourceHandle captured;
+	};
+
+	const UINT FrameWidth = 1920;
+	const UINT FrameHeight = 1080;
+
+	void BuildTestFrame(RenderGraph& graph, bool withCapture, TestFrame& frame)
+	{
+		const RenderGraph::ResourceHandle backBuffer = graph.ImportResource("BackBuffer", FakeResource(1), D3D12_RESOURCE_STATE_PRESENT);
+
+		graph.AddPass("GBuffer", [&frame](RenderGraph::PassBuilder& builder)						// 0
+		{
+			frame.gbuffer = builder.CreateTexture("GBuffer", MakeTextureDesc(FrameWidth, FrameHeight, DXGI_FORMAT_R16G16B16A16_FLOAT, D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET));
+			frame.depth = builder.CreateTexture("Depth", MakeTextureDesc(FrameWidth, FrameHeight, DXGI_FORMAT_D32_FLOAT, D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL));
+			builder.Write(frame.gbuffer, D3D12_RESOURCE_STATE_RENDER_TARGET);
+			builder.Write(frame.depth, D3D12_RESOURCE_STATE_DEPTH_WRITE);
+		}, NoExecute);
+
+		graph.AddPass("Lighting", [&frame](RenderGraph::PassBuilder& builder)						// 1
+		{
+			frame.lit = builder.CreateTexture("Lit", MakeTextureDesc(FrameWidth, FrameHeight, DXGI_FORMAT_R16G16B16A16_FLOAT, D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET));
+			builder.Read(frame.gbuffer, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+			builder.Read(frame.depth, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+			builder.Write(frame.lit, D3D12_RESOURCE_STATE_RENDER_TARGET);
+		}, NoExecute);
+
+		graph.AddPass("DebugView", [&frame](RenderGraph::PassBuilder& builder)						// 2, culled
+		{
+			frame.debugView = builder.CreateTexture("DebugView", MakeTextureDesc(FrameWidth, FrameHeight, DXGI_FORMAT_R8G8B8A8_UNORM, D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET));
+			builder.Read(frame.gbuffer, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+			builder.Write(frame.debugView, D3D12_RESOURCE_STATE_RENDER_TARGET);
+		}, NoExecute);
+
+		graph.AddPass("Bloom", [&frame](RenderGraph::PassBuilder& builder)							// 3
+		{
+			frame.bloom = builder.CreateTexture("Bloom", MakeTextureDesc(FrameWidth / 2, FrameHeight / 2, DXGI_FORMAT_R16G16B16A16_FLOAT, D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET));
+			builder.Read(frame.lit, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+			builder.Write(frame.bloom, D3D12_RESOURCE_STATE_RENDER_TARGET);
+		}, NoExecute);
+
+		graph.AddPass("Composite", [&frame, backBuffer](RenderGraph::PassBuilder& builder)			// 4
+		{
+			builder.Read(frame.lit, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+			builder.Read(frame.bloom, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+			builder.Write(backBuffer, D3D12_RESOURCE_STATE_RENDER_TARGET);
+		}, NoExecute);
+
+		frame.captured = RenderGraph::InvalidResource;
+		if (withCapture)
+		{
+			graph.AddPass("Capture", [&frame](RenderGraph::PassBuilder& builder)					// 5
+			{
+				frame.captured = builder.CreateTexture("Captured", MakeTextureDesc(FrameWidth, FrameHeight, DXGI_FORMAT_R8G8B8A8_UNORM, D3D12_RESOURCE_FLAG_NONE));
+				builder.Read(frame.depth, D3D12_RESOURCE_STATE_COPY_SOURCE);
+				builder.Write(frame.captured, D3D12_RESOURCE_STATE_COPY_DEST);
+				builder.SetSideEffects();
+			}, NoExecute);
+		}
+	}
+
+	// Transients alive at the same time must not share memory, and each must be aligned
+	void CheckPlacement(const RenderGraph& graph, const std::vector<RenderGraph::ResourceHandle>& transients)
+	{
+		for (size_t i = 0; i < transients.size(); i++)
+		{
+			const UINT64 offset = graph.GetTransientOffset(transients[i]);
+			const UINT64 size = graph.GetTransientSize(transients[i]);
+			MICRO_CHECK(offset % D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT == 0);
+			MICRO_CHECK(offset + size <= graph.GetCompileStats().transientHeapSize);
+
+			UINT first;
+			UINT last;
+			MICRO_CHECK(graph.GetTransientLifetime(transients[i], &first, &last));
+			for (size_t j = i + 1; j < transients.size(); j++)
+			{
+				UINT otherFirst;
+				UINT otherLast;
+				MICRO_CHECK(graph.GetTransientLifetime(transients[j], &otherFirst, &otherLast));
+				const UINT64 otherOffset = graph.GetTransientOffset(transients[j]);
+				const UINT64 otherSize = graph.GetTransientSize(transients[j]);
+
+				const bool livesOverlap = first <= otherLast && otherFirst <= last;
+				const bool memoryOverlaps = offset < otherOffset + otherSize && otherOffset < offset + size;
+				MICRO_CHECK(!(livesOverlap && memoryOverlaps));
+
+				// Any transients sharing memory are activated with aliasing barriers every frame
+				if (memoryOverlaps)
+				{
+					MICRO_CHECK(graph.IsTransientAliased(transients[i]) && graph.IsTransientAliased(transients[j]));
+				}
+			}
+		}
+	}
+}
+
+// The first use of a resource in a list is only resolved against its global state at submit
+MICRO_TEST("StateTracker.FirstUseResolvedAtSubmit")
+{
+	ID3D12Resource* texture = FakeResource(1);
+	ID3D12Resource* renderTarget = FakeResource(2);
+	ID3D12Resource* unregistered = FakeResource(3);
+
+	GlobalResourceStates globalStates;
+	globalStates.Register(texture, D3D12_RESOURCE_STATE_COPY_DEST);
+	globalStates.Register(renderTarget, D3D12_RESOURCE_STATE_RENDER_TARGET);
+
+	ResourceStateTracker tracker;
+	tracker.TransitionResource(texture, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	tracker.TransitionResource(renderTarget, D3D12_RESOURCE_STATE_RENDER_TARGET);
+	tracker.TransitionResource(unregistered, D3D12_RESOURCE_STATE_COPY_SOURCE);
+	MICRO_CHECK(tracker.GetQueuedBarriers().empty());
+
+	// Only the texture isn't already where the list needs it
+	std::vector<D3D12_RESOURCE_BARRIER> barriers;
+	MICRO_CHECK(tracker.ResolvePendingBarriers(globalStates, barriers) == 1);
+	MICRO_CHECK(barriers.size() == 1);
+	MICRO_CHECK(!barriers.empty() && IsTransition(barriers[0], texture, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE));
+	MICRO_CHECK(tracker.GetStats().pendingBarriersResolved == 1);
+	MICRO_CHECK(tracker.GetStats().barriersFlushed == 0);
+
+	// Later uses are recorded against the first use's state
+	tracker.TransitionResource(texture, D3D12_RESOURCE_STATE_COPY_DEST);
+	MICRO_CHECK(tracker.GetQueuedBarriers().size() == 1);
+	MICRO_CHECK(IsTransition(tracker.GetQueuedBarriers().back(), texture, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_COPY_DEST));
+}
+
+// Transitions to a state the resource is already in, or a read state it includes, are dropped
+MICRO_TEST("StateTracker.RedundantTransitionsDropped")
+{
+	ID3D12Resource* buffer = FakeResource(1);
+
+	ResourceStateTracker tracker;
+	tracker.TransitionResource(buffer, D3D12_RESOURCE_STATE_GENERIC_READ);
+	tracker.TransitionResource(buffer, D3D12_RESOURCE_STATE_GENERIC_READ);
+	tracker.TransitionResource(buffer, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	tracker.TransitionResource(buffer, D3D12_RESOURCE_STATE_COPY_SOURCE);
+	MICRO_CHECK(tracker.GetQueuedBarriers().empty());
+
+	// COMMON is only satisfied by COMMON, even though every state includes its zero bits
+	tracker.TransitionResource(buffer, D3D12_RESOURCE_STATE_COMMON);
+	tracker.TransitionResource(buffer, D3D12_RESOURCE_STATE_COPY_DEST);
+	tracker.TransitionResource(buffer, D3D12_RESOURCE_STATE_COPY_DEST);
+	MICRO_CHECK(tracker.GetQueuedBarriers().size() == 2);
+
+	const ResourceStateTracker::Stats& stats = tracker.GetStats();
+	MICRO_CHECK(stats.transitionsRequested == 7);
+	MICRO_CHECK(stats.redundantTransitions == 4);
+
+	D3D12_RESOURCE_STATES state;
+	MICRO_CHECK(tracker.GetTrackedState(buffer, &state) && state == D3D12_RESOURCE_STATE_COPY_DEST);
+}
+
+// A split barrier whose begin hasn't been flushed yet has nothing to overlap, so becomes one
+// ordinary transition when it's ended
+MICRO_TEST("StateTracker.UnflushedSplitBarrierFolded")
+{
+	ID3D12Resource* target = FakeResource(1);
+
+	ResourceStateTracker tracker;
+	tracker.TransitionResource(target, D3D12_RESOURCE_STATE_RENDER_TARGET);
+	tracker.BeginTransition(target, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	MICRO_CHECK(tracker.GetQueuedBarriers().size() == 1);
+	MICRO_CHECK(IsTransition(tracker.GetQueuedBarriers().back(), target, D3D12_RESOURCE_STATE_RENDER_TARGET,
+		D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_BARRIER_FLAG_BEGIN_ONLY));
+
+	D3D12_RESOURCE_STATES state;
+	MICRO_CHECK(tracker.GetTrackedState(target, &state) && state == D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+
+	tracker.TransitionResource(target, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	MICRO_CHECK(tracker.GetQueuedBarriers().size() == 1);
+	MICRO_CHECK(IsTransition(tracker.GetQueuedBarriers().back(), target, D3D12_RESOURCE_STATE_RENDER_TARGET,
+		D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE));
+	MICRO_CHECK(tracker.GetStats().splitBarriers == 0);
+
+	// A begin is only started from a known state, so a resource's first use can't have one
+	ID3D12Resource* unused = FakeResource(2);
+	tracker.BeginTransition(unused, D3D12_RESOURCE_STATE_COPY_SOURCE);
+	MICRO_CHECK(tracker.GetQueuedBarriers().size() == 1);
+	MICRO_CHECK(!tracker.GetTrackedState(unused, &state));
+}
+
+// Split barriers still open at the end of the list are ended there, so the list never leaves one
+// running and the resource is committed in the state the GPU moved it to
+MICRO_TEST("StateTracker.OpenSplitBarriersEnded")
+{
+	ID3D12Resource* target = FakeResource(1);
+	ID3D12Resource* buffer = FakeResource(2);
+
+	GlobalResourceStates globalStates;
+	globalStates.Register(target, D3D12_RESOURCE_STATE_RENDER_TARGET);
+	globalStates.Register(buffer, D3D12_RESOURCE_STATE_COPY_DEST);
+
+	ResourceStateTracker tracker;
+	tracker.TransitionResource(target, D3D12_RESOURCE_STATE_RENDER_TARGET);
+	tracker.TransitionResource(buffer, D3D12_RESOURCE_STATE_COPY_DEST);
+	tracker.BeginTransition(target, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	tracker.BeginTransition(buffer, D3D12_RESOURCE_STATE_COPY_SOURCE);
+	tracker.EndSplitBarriers();
+
+	const std::vector<D3D12_RESOURCE_BARRIER>& queued = tracker.GetQueuedBarriers();
+	MICRO_CHECK(queued.size() == 2);
+	for (const auto& barrier : queued)
+	{
+		MICRO_CHECK(barrier.Flags == D3D12_RESOURCE_BARRIER_FLAG_NONE);
+	}
+
+	// Ending again has nothing left to do
+	tracker.EndSplitBarriers();
+	MICRO_CHECK(queued.size() == 2);
+
+	tracker.CommitFinalStates(globalStates);
+	D3D12_RESOURCE_STATES state;
+	MICRO_CHECK(globalStates.GetState(target, &state) && state == D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	MICRO_CHECK(globalStates.GetState(buffer, &state) && state == D3D12_RESOURCE_STATE_COPY_SOURCE);
+}
+
+// Only registered resources have their final states recorded, so a resource the list only
+// assumed a state for leaves nothing behind for a later resource at the same address
+MICRO_TEST("StateTracker.CommitsRegisteredOnly")
+{
+	ID3D12Resource* registered = FakeResource(1);
+	ID3D12Resource* transient = FakeResource(2);
+
+	GlobalResourceStates globalStates;
+	globalStates.Register(registered, D3D12_RESOURCE_STATE_COMMON);
+
+	ResourceStateTracker tracker;
+	tracker.TransitionResource(registered, D3D12_RESOURCE_STATE_COPY_DEST);
+	tracker.TransitionResource(registered, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	tracker.AssumeState(transient, D3D12_RESOURCE_STATE_RENDER_TARGET);
+	tracker.TransitionResource(transient, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	tracker.CommitFinalStates(globalStates);
+
+	D3D12_RESOURCE_STATES state;
+	MICRO_CHECK(globalStates.GetState(registered, &state) && state == D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	MICRO_CHECK(!globalStates.GetState(transient, &state));
+
+	// The next list starts from the committed state
+	tracker.Reset();
+	tracker.TransitionResource(registered, D3D12_RESOURCE_STATE_COPY_DEST);
+	std::vector<D3D12_RESOURCE_BARRIER> barriers;
+	MICRO_CHECK(tracker.ResolvePendingBarriers(globalStates, barriers) == 1);
+	MICRO_CHECK(!barriers.empty() && IsTransition(barriers[0], registered, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_COPY_DEST));
+}
+
+// A frame's tracking on the frame arenas, as the app records it: once the arenas and the
+// tracker's lists have grown to fit, recording and submitting a frame makes no heap allocations
+MICRO_TEST("StateTracker.NoSteadyAllocations")
+{
+	const unsigned int resourceCount = 64;
+	const unsigned int warmUpFrames = 8;
+
+	GlobalResourceStates globalStates;
+	for (uintptr_t id = 1; id <= resourceCount; id++)
+	{
+		globalStates.Register(FakeResource(id), D3D12_RESOURCE_STATE_COMMON);
+	}
+
+	FrameArenas arenas(0);
+	ResourceStateTracker tracker;
+	std::vector<D3D12_RESOURCE_BARRIER> barriers;
+	AllocationCounts start = {};
+	for (unsigned int frame = 0; frame < warmUpFrames + 32; frame++)
+	{
+		if (frame == warmUpFrames)
+		{
+			start = GetAllocationCounts();
+		}
+
+		arenas.BeginFrame();
+		tracker.Reset(&arenas.GetThreadArena());
+		for (uintptr_t id = 1; id <= resourceCount; id++)
+		{
+			tracker.TransitionResource(FakeResource(id), id % 2 ? D3D12_RESOURCE_STATE_RENDER_TARGET : D3D12_RESOURCE_STATE_COPY_DEST);
+			tracker.TransitionResource(FakeResource(id), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+		}
+
+		barriers.clear();
+		tracker.ResolvePendingBarriers(globalStates, barriers);
+		tracker.CommitFinalStates(globalStates);
+	}
+
+	const AllocationCounts end = GetAllocationCounts();
+	MICRO_CHECK(end.allocations == start.allocations);
+	MICRO_CHECK(tracker.GetQueuedBarriers().size() == resourceCount);
+}
+
+// Culling, lifetimes and memory placement of a frame with known lifetimes
+MICRO_TEST("RenderGraph.CompileAliasesTransients")
+{
+	GlobalResourceStates globalStates;
+	RenderGraph graph(&globalStates);
+	TestFrame frame;
+	BuildTestFrame(graph, false, frame);
+	MICRO_CHECK(graph.Compile(GetTextureAllocationInfo));
+
+	// Nothing reads the debug view, so its pass and texture go
+	const RenderGraph::CompileStats& stats = graph.GetCompileStats();
+	MICRO_CHECK(stats.passCount == 5);
+	MICRO_CHECK(stats.culledPassCount == 1);
+	MICRO_CHECK(graph.IsPassCulled(2));
+	MICRO_CHECK(!graph.IsPassCulled(0) && !graph.IsPassCulled(1) && !graph.IsPassCulled(3) && !graph.IsPassCulled(4));
+	MICRO_CHECK(stats.transientCount == 4);
+
+	UINT first;
+	UINT last;
+	MICRO_CHECK(!graph.GetTransientLifetime(frame.debugView, &first, &last));
+	MICRO_CHECK(graph.GetTransientLifetime(frame.gbuffer, &first, &last) && first == 0 && last == 1);
+	MICRO_CHECK(graph.GetTransientLifetime(frame.depth, &first, &last) && first == 0 && last == 1);
+	MICRO_CHECK(graph.GetTransientLifetime(frame.lit, &first, &last) && first == 1 && last == 4);
+	MICRO_CHECK(graph.GetTransientLifetime(frame.bloom, &first, &last) && first == 3 && last == 4);
+
+	const std::vector<RenderGraph::ResourceHandle> transients = { frame.gbuffer, frame.depth, frame.lit, frame.bloom };
+	CheckPlacement(graph, transients);
+
+	// The most ever alive at once is in the lighting pass, and bloom fits in memory freed after it
+	const UINT64 gbufferSize = graph.GetTransientSize(frame.gbuffer);
+	const UINT64 depthSize = graph.GetTransientSize(frame.depth);
+	const UINT64 litSize = graph.GetTransientSize(frame.lit);
+	const UINT64 bloomSize = graph.GetTransientSize(frame.bloom);
+	MICRO_CHECK(stats.unaliasedSize == gbufferSize + depthSize + litSize + bloomSize);
+	MICRO_CHECK(stats.transientHeapSize == AlignUp(gbufferSize + depthSize + litSize, static_cast<UINT64>(D3D12_DEFAULT_MSAA_RESOURCE_PLACEMENT_ALIGNMENT)));
+	MICRO_CHECK(graph.IsTransientAliased(frame.bloom));
+	MICRO_CHECK(!graph.IsTransientAliased(frame.lit));
+}
+
+// Side effects keep a pass that nothing reads from, and extend what it reads
+MICRO_TEST("RenderGraph.SideEffectsKeepPass")
+{
+	GlobalResourceStates globalStates;
+	RenderGraph graph(&globalStates);
+	TestFrame frame;
+	BuildTestFrame(graph, true, frame);
+	MICRO_CHECK(graph.Compile(GetTextureAllocationInfo));
+
+	const RenderGraph::CompileStats& stats = graph.GetCompileStats();
+	MICRO_CHECK(stats.passCount == 6);
+	MICRO_CHECK(stats.culledPassCount == 1);
+	MICRO_CHECK(!graph.IsPassCulled(5));
+	MICRO_CHECK(stats.transientCount == 5);
+
+	UINT first;
+	UINT last;
+	MICRO_CHECK(graph.GetTransientLifetime(frame.depth, &first, &last) && first == 0 && last == 5);
+	MICRO_CHECK(graph.GetTransientLifetime(frame.captured, &first, &last) && first == 5 && last == 5);
+
+	const std::vector<RenderGraph::ResourceHandle> transients = { frame.gbuffer, frame.depth, frame.lit, frame.bloom, frame.captured };
+	CheckPlacement(graph, transients);
+	MICRO_CHECK(stats.transientHeapSize < stats.unaliasedSize);
+}
+
+// The compiled result is reused while the frame's passes stay the same
+MICRO_TEST("RenderGraph.CompileCachedByTopology")
+{
+	GlobalResourceStates globalStates;
+	RenderGraph graph(&globalStates);
+	TestFrame frame;
+
+	BuildTestFrame(graph, false, frame);
+	MICRO_CHECK(graph.Compile(GetTextureAllocationInfo));
+	MICRO_CHECK(!graph.GetCompileStats().cacheHit);
+	const UINT64 bloomOffset = graph.GetTransientOffset(frame.bloom);
+
+	// Imported resources can change from frame to frame without a recompile
+	graph.Reset();
+	BuildTestFrame(graph, false, frame);
+	MICRO_CHECK(!graph.Compile(GetTextureAllocationInfo));
+	MICRO_CHECK(graph.GetCompileStats().cacheHit);
+	MICRO_CHECK(graph.GetTransientOffset(frame.bloom) == bloomOffset);
+
+	graph.Reset();
+	BuildTestFrame(graph, true, frame);
+	MICRO_CHECK(graph.Compile(GetTextureAllocationInfo));
+	MICRO_CHECK(!graph.GetCompileStats().cacheHit);
+	MICRO_CHECK(graph.GetCompileStats().passCount == 6);
+
+	graph.Reset();
+	BuildTestFrame(graph, false, frame);
+	MICRO_CHECK(graph.Compile(GetTextureAllocationInfo));
+	MICRO_CHECK(graph.GetCompileStats().passCount == 5);
+}
@@ -0,0 +1,441 @@
+// File I/O benchmarks - the async file service against blocking reads, and asset archive opening,
+// lookups and reads, with tests for both. The files are written just before they're read, so come
+// from the OS file cache: these time the cost of each read and how well reads overlap, not the disk.
+
+#include "MicroBench.h"
+#include "AssetArchive.h"
+#include "AssetArchiveWriter.h"
+#include "AsyncFileIO.h"
+#include "Benchmark.h"
+
+#include <atomic>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace
+{
+	const unsigned int FileCount = 16;
+	const size_t FileSize = 256 * 1024;
+	const size_t ChunkSize = 64 * 1024;
+
+	const char* const ArchiveName = "microbench_io.pak";
+	const unsigned int ArchiveEntryCount = 64;
+	const size_t ArchiveEntrySize = 64 * 1024;
+
+	FILE* OpenFile(const char* path, const char* mode)
+	{
+		FILE* file = nullptr;
+#if defined(_MSC_VER)
+		fopen_s(&file, path, mode);
+#else
+		file = fopen(path, mode);
+#endif
+		return file;
+	}
+
+	// Files written to the working directory, and deleted again when done with
+	class ScratchFiles
+	{
+	public:
+		ScratchFiles(unsigned int count, size_t size)
+		{
+			std::vector<uint8_t> data(size);
+			for (unsigned int i = 0; i < count; i++)
+			{
+				char name[64];
+				snprintf(name, sizeof(name), "microbench_io_%u.tmp", i);
+				mNames.push_back(name);
+				mPaths.push_back(std::wstring(mNames.back().begin(), mNames.back().end()));
+
+				for (size_t byte = 0; byte < size; byte++)
+				{
+					data[byte] = GetExpectedByte(i, byte);
+				}
+
+				FILE* file = OpenFile(name, "wb");
+				if (file != nullptr)
+				{
+					fwrite(data.data(), 1, data.size(), file);
+					fclose(file);
+				}
+			}
+		}
+
+		~ScratchFiles()
+		{
+			for (const std::string& name : mNames)
+			{
+				remove(name.c_str());
+			}
+		}
+
+		// Prohibit copying
+		ScratchFiles(const ScratchFiles& rhs) = delete;
+		ScratchFiles& operator=(const ScratchFiles& rhs) = delete;
+
+		static uint8_t GetExpectedByte(unsigned int file, size_t offset)
+		{
+			return static_cast<uint8_t>(offset * 7 + file);
+		}
+
+		// Getters
+		const char* GetName(unsigned int index) const { return mNames[index].c_str(); }
+		const std::wstring& GetPath(unsigned int index) const { return mPaths[index]; }
+
+	private:
+		std::vector<std::string> mNames;
+		std::vector<std::wstring> mPaths;
+	};
+
+	// The same steps as ReadDataFromFile: open, find the size, read it all in one call
+	size_t BlockingReadWholeFile(const char* path, std::vector<uint8_t>& data)
+	{
+		FILE* file = OpenFile(path, "rb");
+		if (file == nullptr)
+		{
+			return 0;
+		}
+
+		fseek(file, 0, SEEK_END);
+		const long size = ftell(file);
+		fseek(file, 0, SEEK_SET);
+		data.resize(size > 0 ? static_cast<size_t>(size) : 0);
+		const size_t read = fread(data.data(), 1, data.size(), file);
+		fclose(file);
+		return read;
+	}
+
+	std::wstring GetArchiveEntryPath(unsigned int index)
+	{
+		wchar_t path[64];
+		swprintf(path, sizeof(path) / sizeof(path[0]), L"Textures\\Entry%u.dds", index);
+		return path;
+	}
+
+	// Even entries are repetitive enough to be stored compressed, odd ones are noise so stored as is
+	void MakeArchiveEntry(unsigned int index, std::vector<uint8_t>& data)
+	{
+		SeededRandom random(index + 1);
+		data.resize(ArchiveEntrySize);
+		for (size_t i = 0; i < data.size(); i++)
+		{
+			data[i] = static_cast<uint8_t>(index % 2 ? random.Next() : (i / 16) % 32 + random.Next() % 4);
+		}
+	}
+
+	// An archive written to the working directory, and deleted again when done with
+	class ScratchArchive
+	{
+	public:
+		ScratchArchive()
+		{
+			AssetArchiveWriter writer;
+			std::vector<uint8_t> data;
+			for (unsigned int i = 0; i < ArchiveEntryCount; i++)
+			{
+				MakeArchiveEntry(i, data);
+				writer.AddFile(GetArchiveEntryPath(i), data);
+			}
+
+			std::vector<uint8_t> archive;
+			writer.Build(archive);
+			FILE* file = OpenFile(ArchiveName, "wb");
+			if (file != nullptr)
+			{
+				fwrite(archive.data(), 1, archive.size(), file);
+				fclose(file);
+			}
+
+			const std::string name = ArchiveName;
+			mPath = std::wstring(name.begin(), name.end());
+		}
+
+		~ScratchArchive()
+		{
+			remove(ArchiveName);
+		}
+
+		// Prohibit copying
+		ScratchArchive(const ScratchArchive& rhs) = delete;
+		ScratchArchive& operator=(const ScratchArchive& rhs) = delete;
+
+		// Getters
+		const std::wstring& GetPath() const { return mPath; }
+
+	private:
+		std::wstring mPath;
+	};
+
+	void RunArchiveReadBench(BenchState& state, unsigned int firstEntry)
+	{
+		ScratchArchive scratch;
+		AssetArchive archive;
+		archive.Open(scratch.GetPath());
+		// Every other entry is the same kind, compressed or stored
+		std::vector<const ArchiveEntry*> entries;
+		for (unsigned int index = firstEntry; index < ArchiveEntryCount; index += 2)
+		{
+			entries.push_back(archive.Find(GetArchiveEntryPath(index)));
+		}
+		std::vector<uint8_t> data(ArchiveEntrySize);
+		state.itemsPerIteration = ArchiveEntrySize;
+		state.ResetTimer();
+
+		for (uint64_t i = 0; i < state.iterations; i++)
+		{
+			const ArchiveEntry* entry = entries[i % entries.size()];
+			bool succeeded = entry != nullptr && archive.Read(*entry, data.data(), data.size());
+			DoNotOptimize(succeeded);
+		}
+	}
+
+	bool MatchesFile(const std::vector<uint8_t>& data, unsigned int file, size_t offset)
+	{
+		for (size_t i = 0; i < data.size(); i++)
+		{
+			if (data[i] != ScratchFiles::GetExpectedByte(file, offset + i))
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+}
+
+// The loading path the async service replaces: each file read in turn on the calling thread
+MICRO_BENCH("IO.BlockingRead.WholeFiles")
+{
+	ScratchFiles files(FileCount, FileSize);
+	std::vector<uint8_t> data;
+	state.itemsPerIteration = FileCount;
+	state.ResetTimer();
+
+	for (uint64_t i = 0; i < state.iterations; i++)
+	{
+		size_t bytes = 0;
+		for (unsigned int file = 0; file < FileCount; file++)
+		{
+			bytes += BlockingReadWholeFile(files.GetName(file), data);
+		}
+		DoNotOptimize(bytes);
+	}
+}
+
+MICRO_BENCH("IO.AsyncFileIO.WholeFiles")
+{
+	ScratchFiles files(FileCount, FileSize);
+	AsyncFileIO fileIO(nullptr);
+	std::atomic<uint64_t> bytes(0);
+	state.itemsPerIteration = FileCount;
+	state.ResetTimer();
+
+	for (uint64_t i = 0; i < state.iterations; i++)
+	{
+		for (unsigned int file = 0; file < FileCount; file++)
+		{
+			fileIO.Read(files.GetPath(file), 0, 0, IOPriority_Normal, [&bytes](IOResult& result)
+			{
+				bytes += result.data.size();
+			});
+		}
+		fileIO.WaitIdle();
+	}
+	DoNotOptimize(bytes.load());
+}
+
+// Each file asked for in chunks, which are merged into fewer, larger reads
+MICRO_BENCH("IO.AsyncFileIO.Chunks")
+{
+	ScratchFiles files(FileCount, FileSize);
+	AsyncFileIO fileIO(nullptr);
+	std::atomic<uint64_t> bytes(0);
+	const unsigned int chunksPerFile = static_cast<unsigned int>(FileSize / ChunkSize);
+	state.itemsPerIteration = FileCount * chunksPerFile;
+	state.ResetTimer();
+
+	for (uint64_t i = 0; i < state.iterations; i++)
+	{
+		for (unsigned int file = 0; file < FileCount; file++)
+		{
+			for (unsigned int chunk = 0; chunk < chunksPerFile; chunk++)
+			{
+				fileIO.Read(files.GetPath(file), chunk * ChunkSize, ChunkSize, IOPriority_Normal, [&bytes](IOResult& result)
+				{
+					bytes += result.data.size();
+				});
+			}
+		}
+		fileIO.WaitIdle();
+	}
+	DoNotOptimize(bytes.load());
+
+	const AsyncFileIO::Stats stats = fileIO.GetStats();
+	state.SetCounter("reads/file", static_cast<double>(stats.readsIssued) / (static_cast<double>(state.iterations) * FileCount));
+}
+
+// Whole-file, chunked and failed reads deliver the right data, and the service can be destroyed
+// straight after queueing reads with every callback still called once
+MICRO_TEST("IO.AsyncFileIO.ReadsAndShutdown")
+{
+	const unsigned int fileCount = 4;
+	const unsigned int chunksPerFile = static_cast<unsigned int>(FileSize / ChunkSize);
+	ScratchFiles files(fileCount, FileSize);
+
+	std::mutex mutex;
+	std::vector<IOResult> results;
+	auto keepResult = [&mutex, &results](IOResult& result)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		results.push_back(std::move(result));
+	};
+
+	{
+		// A budget of one chunk, so the whole-file reads have to go one at a time
+		AsyncFileIO fileIO(nullptr, IOBackend_Overlapped, ChunkSize, 4);
+		for (unsigned int file = 0; file < fileCount; file++)
+		{
+			fileIO.Read(files.GetPath(file), 0, 0, IOPriority_Normal, keepResult);
+			for (unsigned int chunk = 0; chunk < chunksPerFile; chunk++)
+			{
+				fileIO.Read(files.GetPath(file), chunk * ChunkSize, ChunkSize, IOPriority_Low, keepResult);
+			}
+		}
+		fileIO.Read(L"microbench_io_missing.tmp", 0, 0, IOPriority_High, keepResult);
+		fileIO.WaitIdle();
+
+		const AsyncFileIO::Stats stats = fileIO.GetStats();
+		MICRO_CHECK(stats.requestsSubmitted == fileCount * (chunksPerFile + 1) + 1);
+		MICRO_CHECK(stats.bytesRead == fileCount * FileSize * 2);
+	}
+
+	MICRO_CHECK(results.size() == fileCount * (chunksPerFile + 1) + 1);
+	unsigned int failed = 0;
+	for (const IOResult& result : results)
+	{
+		if (result.status != IOStatus_Completed)
+		{
+			// Only the missing file fails, and says why
+			MICRO_CHECK(result.status == IOStatus_Failed && result.error != 0);
+			failed++;
+			continue;
+		}
+
+		// Requests were numbered from 1 in order: a whole file then its chunks, for each file
+		const unsigned int index = static_cast<unsigned int>(result.requestId - 1);
+		const unsigned int file = index / (chunksPerFile + 1);
+		const unsigned int chunk = index % (chunksPerFile + 1);
+		MICRO_CHECK(result.data.size() == (chunk == 0 ? FileSize : ChunkSize));
+		MICRO_CHECK(MatchesFile(result.data, file, chunk == 0 ? 0 : (chunk - 1) * ChunkSize));
+	}
+	MICRO_CHECK(failed == 1);
+
+	for (unsigned int run = 0; run < 100; run++)
+	{
+		std::atomic<unsigned int> callbacks(0);
+		{
+			AsyncFileIO fileIO(nullptr, run % 2 ? IOBackend_Overlapped : IOBackend_ThreadPool, ChunkSize * 2, 2);
+			for (unsigned int chunk = 0; chunk < chunksPerFile * 2; chunk++)
+			{
+				fileIO.Read(files.GetPath(chunk % fileCount), (chunk % chunksPerFile) * ChunkSize, ChunkSize, IOPriority_Normal,
+					[&callbacks](IOResult&) { callbacks++; });
+			}
+		}
+		MICRO_CHECK(callbacks == chunksPerFile * 2);
+	}
+}
+
+// Mapping the archive and checking its header, then unmapping it
+MICRO_BENCH("IO.AssetArchive.Open")
+{
+	ScratchArchive scratch;
+	AssetArchive archive;
+	state.ResetTimer();
+
+	for (uint64_t i = 0; i < state.iterations; i++)
+	{
+		bool opened = archive.Open(scratch.GetPath());
+		DoNotOptimize(opened);
+		archive.Close();
+	}
+}
+
+// Lookups by the path callers use, including normalising it
+MICRO_BENCH("IO.AssetArchive.Find")
+{
+	ScratchArchive scratch;
+	AssetArchive archive;
+	archive.Open(scratch.GetPath());
+	std::vector<std::wstring> paths;
+	for (unsigned int index = 0; index < ArchiveEntryCount; index++)
+	{
+		paths.push_back(GetArchiveEntryPath(index));
+	}
+	state.itemsPerIteration = ArchiveEntryCount;
+	state.ResetTimer();
+
+	for (uint64_t i = 0; i < state.iterations; i++)
+	{
+		for (const std::wstring& path : paths)
+		{
+			const ArchiveEntry* entry = archive.Find(path);
+			DoNotOptimize(entry);
+		}
+	}
+}
+
+// Items are bytes, so items/s is the read throughput
+MICRO_BENCH("IO.AssetArchive.Read.Compressed")
+{
+	RunArchiveReadBench(state, 0);
+}
+
+MICRO_BENCH("IO.AssetArchive.Read.Stored")
+{
+	RunArchiveReadBench(state, 1);
+}
+
+// Every entry reads back as written, and a mounted archive is found by full paths under its root
+// however they're spelt
+MICRO_TEST("IO.AssetArchive.ReadAndMount")
+{
+	ScratchArchive scratch;
+	AssetArchive archive;
+	MICRO_CHECK(archive.Open(scratch.GetPath()));
+	MICRO_CHECK(archive.GetEntryCount() == ArchiveEntryCount);
+
+	std::vector<uint8_t> expected;
+	std::vector<uint8_t> data;
+	unsigned int compressed = 0;
+	for (unsigned int index = 0; index < ArchiveEntryCount; index++)
+	{
+		const ArchiveEntry* entry = archive.Find(GetArchiveEntryPath(index));
+		MICRO_CHECK(entry != nullptr);
+		if (entry == nullptr)
+		{
+			continue;
+		}
+
+		MakeArchiveEntry(index, expected);
+		MICRO_CHECK(archive.Read(*entry, data) && data == expected);
+		MICRO_CHECK((archive.GetMappedData(*entry) == nullptr) == ((entry->flags & ArchiveEntry_Compressed) != 0));
+		compressed += (entry->flags & ArchiveEntry_Compressed) != 0 ? 1 : 0;
+	}
+	MICRO_CHECK(compressed == ArchiveEntryCount / 2);
+	MICRO_CHECK(archive.Find(L"Textures/Missing.dds") == nullptr);
+
+	const AssetArchive* mounted = nullptr;
+	MICRO_CHECK(FindMountedAsset(L"Assets/Textures/Entry0.dds", &mounted) == nullptr);
+
+	MountAssetArchive(&archive, L"C:\\Game\\Assets");
+	MICRO_CHECK(FindMountedAsset(L"C:\\Game\\Assets\\Textures\\Entry3.dds", &mounted) == archive.Find(GetArchiveEntryPath(3)));
+	MICRO_CHECK(mounted == &archive);
+	MICRO_CHECK(FindMountedAsset(L"c:/game/assets/textures/ENTRY3.DDS", &mounted) != nullptr);
+	MICRO_CHECK(FindMountedAsset(L"C:\\Game\\Other\\Textures\\Entry3.dds", &mounted) == nullptr);
+	MICRO_CHECK(FindMountedAsset(L"C:\\Game\\AssetsTextures\\Entry3.dds", &mounted) == nullptr);
+	MICRO_CHECK(FindMountedAsset(L"C:\\Game\\Assets\\Textures\\Missing.dds", &mounted) == nullptr);
+
+	MountAssetArchive(nullptr, std::wstring());
+	MICRO_CHECK(FindMountedAsset(L"C:\\Game\\Assets\\Textures\\Entry3.dds", &mounted) == nullptr);
+}
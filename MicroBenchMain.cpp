@@ -0,0 +1,106 @@
+// MicroBench - times the engine's hot path primitives in isolation
+//
+// Usage: MicroBench [-test] [-filter <text>] [-samples <n>] [-mintime <ms>] [-json <path>]
+//   -test		Run the tests instead of the benchmarks, failing if any check fails
+//   -filter	Only run benchmarks (or tests) whose names contain the text
+//   -samples	Samples taken per benchmark (default 15)
+//   -mintime	Minimum time per sample in milliseconds (default 10)
+//   -json		Also write the results as JSON
+//
+// Only uses the standard library (plus DirectXMath for the math benchmarks, and the D3D12 headers
+// but no device for the D3D12 tests), so it also builds on Linux, e.g.
+//   g++ -O2 -std=c++14 -pthread MicroBench*.cpp AllocationCounter.cpp AssetArchive.cpp AssetArchiveWriter.cpp
+//       AsyncFileIO.cpp Benchmark.cpp BlockCompression.cpp BuddyAllocator.cpp Bvh.cpp Compression.cpp
+//       ConstantStore.cpp DebugDraw.cpp DebugFont.cpp DebugHud.cpp DebugHudPanels.cpp DrawKey.cpp DrawPacket.cpp
+//       FixedStepScheduler.cpp FrameArena.cpp FramePacer.cpp FrameStats.cpp Input.cpp JobSystem.cpp
+//       LightClusters.cpp MathHelper.cpp OcclusionCuller.cpp Profiler.cpp QoiCodec.cpp RadixSort.cpp
+//       ReadbackRing.cpp RenderGraph.cpp ResourceStateTracker.cpp TaskGraph.cpp TextureImage.cpp Timer.cpp
+//       -o MicroBench
+// MicroBenchMath.cpp and MathHelper.cpp can be left out where DirectXMath isn't available, and
+// MicroBenchD3D12.cpp, RenderGraph.cpp and ResourceStateTracker.cpp where the D3D12 headers aren't.
+
+#include "MicroBench.h"
+
+#include <cstdlib>
+#include <cstring>
+
+int main(int argc, char* argv[])
+{
+	BenchSettings settings;
+	const char* jsonPath = nullptr;
+	bool runTests = false;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "-test") == 0)
+		{
+			runTests = true;
+		}
+		else if (strcmp(argv[i], "-filter") == 0 && i + 1 < argc)
+		{
+			settings.filter = argv[++i];
+		}
+		else if (strcmp(argv[i], "-samples") == 0 && i + 1 < argc)
+		{
+			settings.samples = static_cast<unsigned int>(atoi(argv[++i]));
+		}
+		else if (strcmp(argv[i], "-mintime") == 0 && i + 1 < argc)
+		{
+			settings.minSampleTime = static_cast<int64_t>(atof(argv[++i]) * NanosecondsPerMillisecond);
+		}
+		else if (strcmp(argv[i], "-json") == 0 && i + 1 < argc)
+		{
+			jsonPath = argv[++i];
+		}
+		else
+		{
+			printf("Usage: MicroBench [-test] [-filter <text>] [-samples <n>] [-mintime <ms>] [-json <path>]\n");
+			return 1;
+		}
+	}
+
+	if (runTests)
+	{
+		const int failed = RunMicroTests(settings.filter);
+		if (failed < 0)
+		{
+			fprintf(stderr, "No tests matched\n");
+			return 1;
+		}
+		if (failed > 0)
+		{
+			fprintf(stderr, "%d tests failed\n", failed);
+			return 1;
+		}
+		return 0;
+	}
+
+	const std::vector<BenchResult> results = RunMicroBenches(settings);
+	if (results.empty())
+	{
+		fprintf(stderr, "No benchmarks matched\n");
+		return 1;
+	}
+
+	if (jsonPath != nullptr)
+	{
+		FILE* file = nullptr;
+#if defined(_MSC_VER)
+		fopen_s(&file, jsonPath, "w");
+#else
+		file = fopen(jsonPath, "w");
+#endif
+		if (file == nullptr || !WriteBenchResultsJson(file, results))
+		{
+			fprintf(stderr, "Failed to write %s\n", jsonPath);
+			if (file != nullptr)
+			{
+				fclose(file);
+			}
+			return 1;
+		}
+		fclose(file);
+	}
+
+	return 0;
+}
@@ -0,0 +1,133 @@
+// Math benchmarks - MathHelper and DirectXMath transforms
+
+#include "MicroBench.h"
+#include "MathHelper.h"
+#include "Benchmark.h"
+
+using namespace DirectX;
+
+namespace
+{
+	const size_t PointCount = 1024;
+
+	void MakePoints(std::vector<XMFLOAT3>& points)
+	{
+		SeededRandom random(1);
+		points.resize(PointCount);
+		for (XMFLOAT3& point : points)
+		{
+			point = XMFLOAT3(random.NextFloat(-10.0f, 10.0f), random.NextFloat(-10.0f, 10.0f), random.NextFloat(-10.0f, 10.0f));
+		}
+	}
+
+	XMMATRIX MakeTransform()
+	{
+		return XMMatrixRotationRollPitchYaw(0.3f, 0.7f, 0.1f) * XMMatrixTranslation(1.0f, 2.0f, 3.0f) *
+			XMMatrixPerspectiveFovLH(XM_PIDIV4, 16.0f / 9.0f, 0.1f, 100.0f);
+	}
+}
+
+// One point at a time, as scalar code would
+MICRO_BENCH("Math.TransformCoord.Scalar")
+{
+	std::vector<XMFLOAT3> points;
+	std::vector<XMFLOAT3> results(PointCount);
+	MakePoints(points);
+	const XMMATRIX transform = MakeTransform();
+	state.itemsPerIteration = PointCount;
+	state.ResetTimer();
+
+	for (uint64_t i = 0; i < state.iterations; i++)
+	{
+		for (size_t p = 0; p < PointCount; p++)
+		{
+			XMStoreFloat3(&results[p], XMVector3TransformCoord(XMLoadFloat3(&points[p]), transform));
+		}
+		DoNotOptimize(results[0]);
+	}
+}
+
+MICRO_BENCH("Math.TransformCoord.Stream")
+{
+	std::vector<XMFLOAT3> points;
+	std::vector<XMFLOAT3> results(PointCount);
+	MakePoints(points);
+	const XMMATRIX transform = MakeTransform();
+	state.itemsPerIteration = PointCount;
+	state.ResetTimer();
+
+	for (uint64_t i = 0; i < state.iterations; i++)
+	{
+		XMVector3TransformCoordStream(results.data(), sizeof(XMFLOAT3), points.data(), sizeof(XMFLOAT3), PointCount, transform);
+		DoNotOptimize(results[0]);
+	}
+}
+
+MICRO_BENCH("Math.MatrixMultiply")
+{
+	XMMATRIX a = MakeTransform();
+	const XMMATRIX b = XMMatrixRotationY(0.01f);
+	for (uint64_t i = 0; i < state.iterations; i++)
+	{
+		a = XMMatrixMultiply(a, b);
+		DoNotOptimize(a);
+	}
+}
+
+MICRO_BENCH("Math.InverseTranspose")
+{
+	const XMMATRIX m = MakeTransform();
+	for (uint64_t i = 0; i < state.iterations; i++)
+	{
+		XMMATRIX result = MathHelper::InverseTranspose(m);
+		DoNotOptimize(result);
+	}
+}
+
+MICRO_BENCH("Math.RandF")
+{
+	srand(1);
+	for (uint64_t i = 0; i < state.iterations; i++)
+	{
+		float value = MathHelper::RandF(-1.0f, 1.0f);
+		DoNotOptimize(value);
+	}
+}
+
+MICRO_BENCH("Math.SeededRandom")
+{
+	SeededRandom random(1);
+	for (uint64_t i = 0; i < state.iterations; i++)
+	{
+		float value = random.NextFloat(-1.0f, 1.0f);
+		DoNotOptimize(value);
+	}
+}
+
+MICRO_BENCH("Math.RandUnitVec3")
+{
+	srand(1);
+	for (uint64_t i = 0; i < state.iterations; i++)
+	{
+		XMVECTOR value = MathHelper::RandUnitVec3();
+		DoNotOptimize(value);
+	}
+}
+
+MICRO_BENCH("Math.AngleFromXY")
+{
+	std::vector<XMFLOAT3> points;
+	MakePoints(points);
+	state.itemsPerIteration = PointCount;
+	state.ResetTimer();
+
+	for (uint64_t i = 0; i < state.iterations; i++)
+	{
+		float sum = 0.0f;
+		for (const XMFLOAT3& point : points)
+		{
+			sum += MathHelper::AngleFromXY(point.x, point.y);
+		}
+		DoNotOptimize(sum);
+	}
+}
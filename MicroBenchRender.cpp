@@ -0,0 +1,429 @@
+// Render benchmarks - draw sorting, state filtering, draw packets, constant uploads and light clustering
+
+#include "MicroBench.h"
+#include "Benchmark.h"
+#include "ConstantStore.h"
+#include "DrawKey.h"
+#include "DrawPacket.h"
+#include "JobSystem.h"
+#include "LightClusters.h"
+#include "RadixSort.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+	const uint32_t SortCount = 64 * 1024;
+	const uint32_t LargeSortCount = 1024 * 1024;
+	const uint32_t DrawCount = 10000;
+
+	const uint32_t MeshCount = 512;
+	const uint32_t MaterialCount = 128;
+	const uint32_t PsoCount = 16;
+
+	// Draws of a scene's meshes in the order they'd come from walking it. Each mesh has its own
+	// material, and each material its own pipeline state, with one material in ten translucent.
+	void MakeDrawKeys(uint32_t count, std::vector<uint64_t>& keys)
+	{
+		SeededRandom random(1);
+		keys.resize(count);
+		for (uint64_t& key : keys)
+		{
+			DrawKeyFields fields;
+			fields.layer = 0;
+			fields.mesh = random.Next() % MeshCount;
+			fields.material = fields.mesh % MaterialCount;
+			fields.pso = fields.material % PsoCount;
+			fields.translucent = fields.material % 10 == 0;
+			fields.depth = QuantizeDrawDepth(random.NextFloat(0.1f, 500.0f), 0.1f, 1000.0f);
+			key = EncodeDrawKey(fields);
+		}
+	}
+
+	const uint32_t PacketConstantCount = 16;
+
+	// A packet for each draw key, with IDs standing in for the objects the key's fields name
+	DrawPacketDesc MakePacketDesc(uint64_t key, const uint32_t* constants)
+	{
+		const DrawKeyFields fields = DecodeDrawKey(key);
+		DrawPacketDesc desc = {};
+		desc.sortKey = key;
+		desc.rootSignature = 1;
+		desc.pipelineState = fields.pso + 1;
+		desc.vertexBuffer.gpuAddress = (fields.mesh + 1) * 0x10000ull;
+		desc.vertexBuffer.sizeInBytes = 0x10000;
+		desc.vertexBuffer.strideInBytes = 28;
+		desc.constantCount = PacketConstantCount;
+		desc.constants = constants;
+		desc.vertexCount = 3;
+		desc.instanceCount = 1;
+		return desc;
+	}
+
+	void RunRadixSortBench(BenchState& state, uint32_t count, JobSystem* jobSystem)
+	{
+		std::vector<uint64_t> unsorted;
+		MakeDrawKeys(count, unsorted);
+		std::vector<uint64_t> keys(count);
+		std::vector<uint32_t> values(count);
+		RadixSorter sorter;
+		state.itemsPerIteration = count;
+		state.ResetTimer();
+
+		// Each iteration sorts the same unsorted keys again
+		for (uint64_t i = 0; i < state.iterations; i++)
+		{
+			memcpy(keys.data(), unsorted.data(), count * sizeof(uint64_t));
+			for (uint32_t v = 0; v < count; v++)
+			{
+				values[v] = v;
+			}
+			sorter.Sort(keys.data(), values.data(), count, jobSystem);
+			DoNotOptimize(keys.data());
+		}
+		state.SetCounter("passes", sorter.GetLastPassCount());
+	}
+}
+
+MICRO_BENCH("Sort.Radix.64k")
+{
+	RunRadixSortBench(state, SortCount, nullptr);
+}
+
+MICRO_BENCH("Sort.Radix.64k.Jobs")
+{
+	RunRadixSortBench(state, SortCount, &GetBenchJobSystem());
+}
+
+MICRO_BENCH("Sort.Radix.1M.Jobs")
+{
+	RunRadixSortBench(state, LargeSortCount, &GetBenchJobSystem());
+}
+
+// The same keys with their indices, through the standard library's sort, for comparison
+MICRO_BENCH("Sort.StdSort.64k")
+{
+	std::vector<uint64_t> unsorted;
+	MakeDrawKeys(SortCount, unsorted);
+	std::vector<std::pair<uint64_t, uint32_t>> items(SortCount);
+	state.itemsPerIteration = SortCount;
+	state.ResetTimer();
+
+	for (uint64_t i = 0; i < state.iterations; i++)
+	{
+		for (uint32_t v = 0; v < SortCount; v++)
+		{
+			items[v] = std::make_pair(unsorted[v], v);
+		}
+		std::sort(items.begin(), items.end());
+		DoNotOptimize(items.data());
+	}
+}
+
+// A frame's draws sorted then run through the state cache, as recording them would. The
+// counters compare the state changes with those of recording in the unsorted order.
+MICRO_BENCH("Draw.SortAndFilter.10k")
+{
+	std::vector<uint64_t> unsorted;
+	MakeDrawKeys(DrawCount, unsorted);
+
+	DrawStateCache cache;
+	for (uint64_t key : unsorted)
+	{
+		cache.Apply(key);
+	}
+	const uint32_t unsortedChanges = cache.GetStateChangeCount();
+
+	std::vector<uint64_t> keys(DrawCount);
+	std::vector<uint32_t> values(DrawCount);
+	RadixSorter sorter;
+	state.itemsPerIteration = DrawCount;
+	state.ResetTimer();
+
+	for (uint64_t i = 0; i < state.iterations; i++)
+	{
+		memcpy(keys.data(), unsorted.data(), DrawCount * sizeof(uint64_t));
+		for (uint32_t v = 0; v < DrawCount; v++)
+		{
+			values[v] = v;
+		}
+		sorter.Sort(keys.data(), values.data(), DrawCount);
+
+		cache.Reset();
+		uint32_t changes = 0;
+		for (uint64_t key : keys)
+		{
+			changes |= cache.Apply(key);
+		}
+		DoNotOptimize(changes);
+	}
+
+	const uint32_t sortedChanges = cache.GetStateChangeCount();
+	state.SetCounter("state changes unsorted", unsortedChanges);
+	state.SetCounter("state changes sorted", sortedChanges);
+	state.SetCounter("state changes saved %", 100.0 * (unsortedChanges - sortedChanges) / unsortedChanges);
+}
+
+// A static scene's draws recorded from scratch each frame, as before draw packets: sorted,
+// filtered through the state cache, then each draw's state and constants given to the sink
+MICRO_BENCH("DrawPackets.Immediate.10k")
+{
+	std::vector<uint64_t> unsorted;
+	MakeDrawKeys(DrawCount, unsorted);
+	std::vector<float> worlds(DrawCount * PacketConstantCount, 1.0f);
+
+	std::vector<uint64_t> keys(DrawCount);
+	std::vector<uint32_t> values(DrawCount);
+	RadixSorter sorter;
+	DrawStateCache cache;
+	NullDrawPacketSink sink;
+	state.itemsPerIteration = DrawCount;
+	state.ResetTimer();
+
+	for (uint64_t i = 0; i < state.iterations; i++)
+	{
+		memcpy(keys.data(), unsorted.data(), DrawCount * sizeof(uint64_t));
+		for (uint32_t v = 0; v < DrawCount; v++)
+		{
+			values[v] = v;
+		}
+		sorter.Sort(keys.data(), values.data(), DrawCount);
+
+		cache.Reset();
+		for (uint32_t d = 0; d < DrawCount; d++)
+		{
+			float constants[PacketConstantCount];
+			memcpy(constants, &worlds[values[d] * PacketConstantCount], sizeof(constants));
+			const DrawPacketDesc desc = MakePacketDesc(keys[d], reinterpret_cast<const uint32_t*>(constants));
+
+			const uint32_t changes = cache.Apply(keys[d]);
+			if (changes & DrawStateChange_Pso)
+			{
+				sink.SetRootSignature(desc.rootSignature);
+				sink.SetPipelineState(desc.pipelineState);
+			}
+			if (changes & DrawStateChange_Mesh)
+			{
+				sink.SetVertexBuffer(desc.vertexBuffer);
+			}
+			sink.SetRootConstants(0, desc.constantCount, desc.constants);
+			sink.Draw(desc.vertexCount, desc.instanceCount, 0, 0);
+		}
+	}
+	state.SetCounter("draws", sink.GetCounts().draws / static_cast<double>(state.iterations));
+}
+
+namespace
+{
+	// Bakes a packet per draw, then each iteration changes changedCount of them and replays the lot
+	void RunPacketReplayBench(BenchState& state, uint32_t changedCount)
+	{
+		std::vector<uint64_t> keys;
+		MakeDrawKeys(DrawCount, keys);
+		std::vector<uint32_t> constants(DrawCount * PacketConstantCount, 0x3F800000);
+
+		DrawPacketList packets;
+		std::vector<DrawPacketList::Handle> handles(DrawCount);
+		for (uint32_t d = 0; d < DrawCount; d++)
+		{
+			handles[d] = packets.Add(MakePacketDesc(keys[d], &constants[d * PacketConstantCount]));
+		}
+
+		NullDrawPacketSink sink;
+		packets.Replay(sink);
+		sink.Reset();
+
+		SeededRandom random(2);
+		DrawPacketList::ReplayStats stats = {};
+		state.itemsPerIteration = DrawCount;
+		state.ResetTimer();
+
+		for (uint64_t i = 0; i < state.iterations; i++)
+		{
+			for (uint32_t c = 0; c < changedCount; c++)
+			{
+				const uint32_t d = random.Next() % DrawCount;
+				constants[d * PacketConstantCount]++;
+				packets.Update(handles[d], MakePacketDesc(keys[d], &constants[d * PacketConstantCount]));
+			}
+			stats = packets.Replay(sink);
+		}
+
+		state.SetCounter("state changes", stats.stateChangeCount);
+		state.SetCounter("packets rebuilt", stats.rebuiltCount);
+		state.SetCounter("buffer KB", packets.GetBufferSize() / 1024.0);
+	}
+}
+
+MICRO_BENCH("DrawPackets.Replay.10k")
+{
+	RunPacketReplayBench(state, 0);
+}
+
+// One draw in a hundred changing each frame
+MICRO_BENCH("DrawPackets.Update1pct.10k")
+{
+	RunPacketReplayBench(state, DrawCount / 100);
+}
+
+namespace
+{
+	const uint32_t ObjectCount = 10000;
+	const uint32_t ObjectConstantSize = 64;		// A world matrix
+
+	// Each iteration sets every object's constants, changing changedCount of them, in runs of
+	// runLength objects, then gathers the dirty ranges as a frame's upload would
+	void RunConstantStoreBench(BenchState& state, uint32_t changedCount, uint32_t runLength)
+	{
+		ConstantStore store(ObjectConstantSize);
+		store.Resize(ObjectCount);
+		std::vector<uint32_t> constants(ObjectCount * ObjectConstantSize / 4, 0x3F800000);
+		for (uint32_t object = 0; object < ObjectCount; object++)
+		{
+			store.Set(object, &constants[object * ObjectConstantSize / 4]);
+		}
+		std::vector<ConstantStore::Range> ranges;
+		store.CollectDirtyRanges(ranges);
+
+		SeededRandom random(3);
+		uint64_t uploadedBytes = 0;
+		state.itemsPerIteration = ObjectCount;
+		state.ResetTimer();
+
+		for (uint64_t i = 0; i < state.iterations; i++)
+		{
+			for (uint32_t c = 0; c < changedCount; c += runLength)
+			{
+				const uint32_t first = random.Next() % (ObjectCount - runLength);
+				for (uint32_t object = first; object < first + runLength; object++)
+				{
+					constants[object * ObjectConstantSize / 4]++;
+				}
+			}
+			for (uint32_t object = 0; object < ObjectCount; object++)
+			{
+				store.Set(object, &constants[object * ObjectConstantSize / 4]);
+			}
+			uploadedBytes += store.CollectDirtyRanges(ranges);
+		}
+
+		state.SetCounter("bytes/frame", static_cast<double>(uploadedBytes) / state.iterations);
+		state.SetCounter("copies (last frame)", static_cast<double>(ranges.size()));
+		state.SetCounter("% of full upload", 100.0 * uploadedBytes / state.iterations / (ObjectCount * ObjectConstantSize));
+	}
+}
+
+// Nothing changes, so nothing is uploaded: the cost is comparing each object's constants
+MICRO_BENCH("ConstantStore.Unchanged.10k")
+{
+	RunConstantStoreBench(state, 0, 1);
+}
+
+MICRO_BENCH("ConstantStore.Scattered1pct.10k")
+{
+	RunConstantStoreBench(state, ObjectCount / 100, 1);
+}
+
+// Changes come in runs, with the gaps inside them merged into one copy per run
+MICRO_BENCH("ConstantStore.Runs10pct.10k")
+{
+	RunConstantStoreBench(state, ObjectCount / 10, 50);
+}
+
+namespace
+{
+	// The stress scenario's 10k lights, seen from a few points along its camera path
+	const char* LightScenario = "stress";
+	const unsigned int LightViewCount = 8;
+
+	// A left-handed view matrix at eye looking at target, as XMMatrixLookAtLH makes it
+	void MakeView(const float eye[3], const float target[3], float view[16])
+	{
+		float forward[3] = { target[0] - eye[0], target[1] - eye[1], target[2] - eye[2] };
+		const float forwardLength = sqrtf(forward[0] * forward[0] + forward[1] * forward[1] + forward[2] * forward[2]);
+		float right[3] = { forward[2], 0.0f, -forward[0] };		// Up is +y
+		const float rightLength = sqrtf(right[0] * right[0] + right[2] * right[2]);
+		for (unsigned int axis = 0; axis < 3; axis++)
+		{
+			forward[axis] /= forwardLength;
+			right[axis] /= rightLength;
+		}
+		const float up[3] =
+		{
+			forward[1] * right[2] - forward[2] * right[1],
+			forward[2] * right[0] - forward[0] * right[2],
+			forward[0] * right[1] - forward[1] * right[0]
+		};
+
+		const float* axes[3] = { right, up, forward };
+		for (unsigned int column = 0; column < 3; column++)
+		{
+			for (unsigned int row = 0; row < 3; row++)
+			{
+				view[row * 4 + column] = axes[column][row];
+			}
+			view[12 + column] = -(axes[column][0] * eye[0] + axes[column][1] * eye[1] + axes[column][2] * eye[2]);
+			view[column * 4 + 3] = 0.0f;
+		}
+		view[15] = 1.0f;
+	}
+
+	void RunLightAssignBench(BenchState& state, JobSystem* jobSystem)
+	{
+		const BenchmarkScenario& scenario = *FindBenchmarkScenario(LightScenario);
+		std::vector<BenchmarkLight> benchmarkLights;
+		GenerateBenchmarkLights(scenario, benchmarkLights);
+		std::vector<ClusteredLight> lights(benchmarkLights.size());
+		for (size_t i = 0; i < lights.size(); i++)
+		{
+			const BenchmarkLight& light = benchmarkLights[i];
+			memcpy(lights[i].position, light.position, sizeof(light.position));
+			lights[i].range = light.range;
+			memcpy(lights[i].direction, light.direction, sizeof(light.direction));
+			lights[i].cosOuterAngle = light.cosOuterAngle;
+			memcpy(lights[i].colour, light.colour, sizeof(light.colour));
+			lights[i].type = light.spot ? LightType_Spot : LightType_Point;
+		}
+
+		float views[LightViewCount][16];
+		const unsigned int totalFrames = scenario.warmupFrames + scenario.frameCount;
+		for (unsigned int view = 0; view < LightViewCount; view++)
+		{
+			const BenchmarkCamera camera = GetBenchmarkCamera(scenario, view * totalFrames / LightViewCount);
+			MakeView(camera.eye, camera.target, views[view]);
+		}
+
+		// As the app's clusters, for a 16:9 window
+		LightClusters clusters(16, 9, 24);
+		clusters.SetProjection(0.785398f, 16.0f / 9.0f, 0.1f, 1000.0f);
+		const uint32_t lightCount = static_cast<uint32_t>(lights.size());
+		uint64_t indexCount = 0;
+		state.itemsPerIteration = lightCount;
+		state.ResetTimer();
+
+		for (uint64_t i = 0; i < state.iterations; i++)
+		{
+			clusters.Assign(lights.data(), lightCount, views[i % LightViewCount], jobSystem);
+			indexCount += clusters.GetLightIndexCount();
+			DoNotOptimize(clusters.GetLightIndices());
+		}
+
+		const LightClusters::Stats& stats = clusters.GetStats();
+		state.SetCounter("% lights in view", 100.0 * stats.visibleLightCount / lightCount);
+		state.SetCounter("indices/frame", static_cast<double>(indexCount) / state.iterations);
+		state.SetCounter("max per cluster", stats.maxClusterLightCount);
+	}
+}
+
+// 10k point and spot lights into 16x9x24 clusters, on one thread then spread over the job system
+MICRO_BENCH("Lights.Assign.10k")
+{
+	RunLightAssignBench(state, nullptr);
+}
+
+MICRO_BENCH("Lights.Assign.10k.Jobs")
+{
+	RunLightAssignBench(state, &GetBenchJobSystem());
+}
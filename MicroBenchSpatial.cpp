@@ -0,0 +1,463 @@
+// Spatial benchmarks - BVH builds, refits and raycasts, and occlusion culling
+
+#include "MicroBench.h"
+#include "Benchmark.h"
+#include "Bvh.h"
+#include "JobSystem.h"
+#include "OcclusionCuller.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+	// A 256x256 height field makes 128k triangles
+	const uint32_t TerrainSize = 256;
+	const uint32_t TerrainTriangleCount = TerrainSize * TerrainSize * 2;
+	const uint32_t RayCount = 4096;
+
+	const uint32_t InstanceCount = 10000;
+	const float SceneExtent = 500.0f;
+
+	// A 48x48 grid of buildings, with props scattered along the streets between them
+	const uint32_t CityBlocks = 48;
+	const uint32_t PropsPerBlock = 4;
+	const float BlockSpacing = 20.0f;
+	const float BuildingHalfWidth = 6.0f;
+	const float OccluderDistance = 150.0f;		// Buildings nearer the camera than this are occluders
+	const uint32_t OcclusionWidth = 256;
+	const uint32_t OcclusionHeight = 144;
+
+	// Rolling hills over a square grid of cells, each split into two triangles
+	void MakeTerrain(uint32_t size, std::vector<float>& positions, std::vector<uint32_t>& indices)
+	{
+		positions.clear();
+		indices.clear();
+		for (uint32_t z = 0; z <= size; z++)
+		{
+			for (uint32_t x = 0; x <= size; x++)
+			{
+				positions.push_back(static_cast<float>(x));
+				positions.push_back(4.0f * sinf(x * 0.1f) * cosf(z * 0.13f) + 2.0f * sinf((x + z) * 0.37f));
+				positions.push_back(static_cast<float>(z));
+			}
+		}
+
+		for (uint32_t z = 0; z < size; z++)
+		{
+			for (uint32_t x = 0; x < size; x++)
+			{
+				const uint32_t corner = z * (size + 1) + x;
+				const uint32_t cell[6] = { corner, corner + size + 1, corner + 1, corner + 1, corner + size + 1, corner + size + 2 };
+				indices.insert(indices.end(), cell, cell + 6);
+			}
+		}
+	}
+
+	// Rays from above the terrain, pointing down at an angle, as a camera looking over it would
+	// cast. Some leave the side without hitting anything.
+	void MakeTerrainRays(uint32_t count, std::vector<BvhRay>& rays)
+	{
+		SeededRandom random(5);
+		rays.resize(count);
+		for (BvhRay& ray : rays)
+		{
+			ray.origin[0] = random.NextFloat(0.0f, static_cast<float>(TerrainSize));
+			ray.origin[1] = random.NextFloat(10.0f, 40.0f);
+			ray.origin[2] = random.NextFloat(0.0f, static_cast<float>(TerrainSize));
+			ray.direction[0] = random.NextFloat(-1.0f, 1.0f);
+			ray.direction[1] = random.NextFloat(-1.0f, -0.05f);
+			ray.direction[2] = random.NextFloat(-1.0f, 1.0f);
+			ray.maxDistance = 1000.0f;
+		}
+	}
+
+	void MakeWorld(float x, float y, float z, float scale, float rotationY, float world[16])
+	{
+		const float c = cosf(rotationY) * scale;
+		const float s = sinf(rotationY) * scale;
+		const float matrix[16] =
+		{
+			c, 0.0f, -s, 0.0f,
+			0.0f, scale, 0.0f, 0.0f,
+			s, 0.0f, c, 0.0f,
+			x, y, z, 1.0f
+		};
+		for (unsigned int i = 0; i < 16; i++)
+		{
+			world[i] = matrix[i];
+		}
+	}
+
+	// A scene of small terrain patches scattered through a cube, with one in four just a box
+	struct InstanceScene
+	{
+		TriangleBvh mesh;
+		SceneBvh scene;
+		std::vector<float> worlds;
+
+		InstanceScene()
+		{
+			std::vector<float> positions;
+			std::vector<uint32_t> indices;
+			MakeTerrain(8, positions, indices);
+			mesh.Build(positions.data(), indices.data(), static_cast<uint32_t>(indices.size() / 3));
+
+			SeededRandom random(6);
+			const BvhBounds box = { { 0.0f, 0.0f, 0.0f }, { 8.0f, 4.0f, 8.0f } };
+			worlds.resize(InstanceCount * 16);
+			for (uint32_t i = 0; i < InstanceCount; i++)
+			{
+				float* world = &worlds[i * 16];
+				MakeWorld(random.NextFloat(-SceneExtent, SceneExtent), random.NextFloat(-SceneExtent, SceneExtent), random.NextFloat(-SceneExtent, SceneExtent),
+					random.NextFloat(0.5f, 2.0f), random.NextFloat(0.0f, 6.28f), world);
+				if (i % 4 == 0)
+				{
+					scene.AddBoxInstance(box, world);
+				}
+				else
+				{
+					scene.AddInstance(&mesh, world);
+				}
+			}
+		}
+	};
+
+	// Rays from the middle of the scene outwards
+	void MakeSceneRays(uint32_t count, std::vector<BvhRay>& rays)
+	{
+		SeededRandom random(7);
+		rays.resize(count);
+		for (BvhRay& ray : rays)
+		{
+			for (unsigned int axis = 0; axis < 3; axis++)
+			{
+				ray.origin[axis] = random.NextFloat(-50.0f, 50.0f);
+				ray.direction[axis] = random.NextFloat(-1.0f, 1.0f);
+			}
+			ray.maxDistance = 10000.0f;
+		}
+	}
+
+	// A unit cube's corners and triangles
+	const float CubePositions[24] =
+	{
+		-1.0f, -1.0f, -1.0f,	1.0f, -1.0f, -1.0f,	-1.0f, 1.0f, -1.0f,	1.0f, 1.0f, -1.0f,
+		-1.0f, -1.0f, 1.0f,		1.0f, -1.0f, 1.0f,	-1.0f, 1.0f, 1.0f,	1.0f, 1.0f, 1.0f
+	};
+	const uint32_t CubeIndices[36] =
+	{
+		0, 2, 3, 0, 3, 1,	4, 5, 7, 4, 7, 6,	0, 1, 5, 0, 5, 4,
+		2, 6, 7, 2, 7, 3,	0, 4, 6, 0, 6, 2,	1, 3, 7, 1, 7, 5
+	};
+	const uint32_t CubeTriangleCount = 12;
+
+	// A left-handed camera at eye looking at target, with D3D's 0-1 depth range, as
+	// XMMatrixLookAtLH * XMMatrixPerspectiveFovLH would make it
+	void MakeViewProj(const float eye[3], const float target[3], float fovY, float aspectRatio, float nearZ, float farZ, float viewProj[16])
+	{
+		float forward[3] = { target[0] - eye[0], target[1] - eye[1], target[2] - eye[2] };
+		const float forwardLength = sqrtf(forward[0] * forward[0] + forward[1] * forward[1] + forward[2] * forward[2]);
+		float right[3] = { forward[2], 0.0f, -forward[0] };		// Up is +y
+		const float rightLength = sqrtf(right[0] * right[0] + right[2] * right[2]);
+		for (unsigned int axis = 0; axis < 3; axis++)
+		{
+			forward[axis] /= forwardLength;
+			right[axis] /= rightLength;
+		}
+		const float up[3] =
+		{
+			forward[1] * right[2] - forward[2] * right[1],
+			forward[2] * right[0] - forward[0] * right[2],
+			forward[0] * right[1] - forward[1] * right[0]
+		};
+
+		const float yScale = 1.0f / tanf(fovY * 0.5f);
+		const float xScale = yScale / aspectRatio;
+		const float zScale = farZ / (farZ - nearZ);
+		const float scale[3] = { xScale, yScale, zScale };
+		const float* axes[3] = { right, up, forward };
+		for (unsigned int row = 0; row < 3; row++)
+		{
+			for (unsigned int column = 0; column < 3; column++)
+			{
+				viewProj[row * 4 + column] = axes[column][row] * scale[column];
+			}
+			viewProj[row * 4 + 3] = forward[row];
+		}
+		for (unsigned int column = 0; column < 3; column++)
+		{
+			const float offset = -(axes[column][0] * eye[0] + axes[column][1] * eye[1] + axes[column][2] * eye[2]);
+			viewProj[12 + column] = offset * scale[column];
+		}
+		viewProj[12 + 3] = -(forward[0] * eye[0] + forward[1] * eye[1] + forward[2] * eye[2]);
+		viewProj[12 + 2] -= nearZ * zScale;
+	}
+
+	// Buildings are boxes of random heights, each of which is both an occluder and an object to
+	// test, and the props are small boxes that are only tested. The camera stands in a street
+	// looking along it, as in a game where most of the city is hidden by the nearest buildings.
+	struct CityScene
+	{
+		std::vector<float> occluderWorlds;		// 16 floats each, scaling the cube to a building
+		std::vector<BvhBounds> boxes;
+		float viewProj[16];
+
+		CityScene()
+		{
+			const float eye[3] = { 3.5f * BlockSpacing, 2.0f, 12.5f * BlockSpacing };
+			const float target[3] = { 8.0f * BlockSpacing, 10.0f, CityBlocks * BlockSpacing };
+			MakeViewProj(eye, target, 0.785f, static_cast<float>(OcclusionWidth) / OcclusionHeight, 0.1f, 2000.0f, viewProj);
+
+			SeededRandom random(8);
+			for (uint32_t z = 0; z < CityBlocks; z++)
+			{
+				for (uint32_t x = 0; x < CityBlocks; x++)
+				{
+					const float centre[3] = { x * BlockSpacing, random.NextFloat(5.0f, 30.0f), z * BlockSpacing };
+					const BvhBounds building =
+					{
+						{ centre[0] - BuildingHalfWidth, 0.0f, centre[2] - BuildingHalfWidth },
+						{ centre[0] + BuildingHalfWidth, 2.0f * centre[1], centre[2] + BuildingHalfWidth }
+					};
+					boxes.push_back(building);
+
+					const float dx = centre[0] - eye[0];
+					const float dz = centre[2] - eye[2];
+					if (dx * dx + dz * dz < OccluderDistance * OccluderDistance)
+					{
+						const float world[16] =
+						{
+							BuildingHalfWidth, 0.0f, 0.0f, 0.0f,
+							0.0f, centre[1], 0.0f, 0.0f,
+							0.0f, 0.0f, BuildingHalfWidth, 0.0f,
+							centre[0], centre[1], centre[2], 1.0f
+						};
+						occluderWorlds.insert(occluderWorlds.end(), world, world + 16);
+					}
+
+					for (uint32_t prop = 0; prop < PropsPerBlock; prop++)
+					{
+						const float propX = centre[0] + random.NextFloat(BuildingHalfWidth + 1.0f, BlockSpacing - BuildingHalfWidth - 1.0f);
+						const float propZ = centre[2] + random.NextFloat(-BuildingHalfWidth, BuildingHalfWidth);
+						const BvhBounds box = { { propX - 0.5f, 0.0f, propZ - 0.5f }, { propX + 0.5f, 1.5f, propZ + 0.5f } };
+						boxes.push_back(box);
+					}
+				}
+			}
+		}
+
+		uint32_t GetOccluderCount() const { return static_cast<uint32_t>(occluderWorlds.size() / 16); }
+		uint32_t GetBoxCount() const { return static_cast<uint32_t>(boxes.size()); }
+
+		void Rasterize(OcclusionCuller& culler, JobSystem* jobSystem) const
+		{
+			culler.BeginFrame(viewProj);
+			for (uint32_t i = 0; i < GetOccluderCount(); i++)
+			{
+				culler.AddOccluder(CubePositions, CubeIndices, CubeTriangleCount, &occluderWorlds[i * 16]);
+			}
+			culler.Rasterize(jobSystem);
+		}
+	};
+
+	// Stats add up over the frame, so the boxes drawn are counted from the last test's flags
+	void SetCullingCounters(BenchState& state, const OcclusionCuller::Stats& stats, const std::vector<uint8_t>& visible)
+	{
+		state.SetCounter("% occluded", 100.0 * stats.occludedCount / stats.testedCount);
+		state.SetCounter("% off screen", 100.0 * stats.outsideCount / stats.testedCount);
+		state.SetCounter("drawn", static_cast<double>(std::count(visible.begin(), visible.end(), 1)));
+	}
+
+	void RunOcclusionRasterizeBench(BenchState& state, JobSystem* jobSystem)
+	{
+		const CityScene city;
+		OcclusionCuller culler(OcclusionWidth, OcclusionHeight);
+		state.itemsPerIteration = city.GetOccluderCount() * CubeTriangleCount;
+		state.ResetTimer();
+
+		for (uint64_t i = 0; i < state.iterations; i++)
+		{
+			city.Rasterize(culler, jobSystem);
+			DoNotOptimize(culler.GetDepth()[0]);
+		}
+		state.SetCounter("triangles drawn", culler.GetStats().rasterizedTriangleCount);
+	}
+
+	void RunTerrainBuildBench(BenchState& state, JobSystem* jobSystem)
+	{
+		std::vector<float> positions;
+		std::vector<uint32_t> indices;
+		MakeTerrain(TerrainSize, positions, indices);
+		TriangleBvh bvh;
+		state.itemsPerIteration = TerrainTriangleCount;
+		state.ResetTimer();
+
+		for (uint64_t i = 0; i < state.iterations; i++)
+		{
+			bvh.Build(positions.data(), indices.data(), TerrainTriangleCount, jobSystem);
+			DoNotOptimize(bvh.GetBounds());
+		}
+
+		const Bvh::Stats stats = bvh.GetBvh().GetStats();
+		state.SetCounter("nodes", stats.nodeCount);
+		state.SetCounter("depth", stats.depth);
+		state.SetCounter("SAH cost", stats.sahCost);
+	}
+
+	template<bool AnyHit>
+	void RunTerrainRaycastBench(BenchState& state)
+	{
+		std::vector<float> positions;
+		std::vector<uint32_t> indices;
+		MakeTerrain(TerrainSize, positions, indices);
+		TriangleBvh bvh;
+		bvh.Build(positions.data(), indices.data(), TerrainTriangleCount);
+		std::vector<BvhRay> rays;
+		MakeTerrainRays(RayCount, rays);
+
+		uint32_t hitCount = 0;
+		state.itemsPerIteration = RayCount;
+		state.ResetTimer();
+
+		for (uint64_t i = 0; i < state.iterations; i++)
+		{
+			hitCount = 0;
+			for (const BvhRay& ray : rays)
+			{
+				BvhHit hit;
+				hitCount += (AnyHit ? bvh.Occluded(ray) : bvh.Intersect(ray, hit)) ? 1 : 0;
+			}
+			DoNotOptimize(hitCount);
+		}
+		state.SetCounter("% hit", 100.0 * hitCount / RayCount);
+	}
+}
+
+// 128k triangles, built on one thread then spread over the job system
+MICRO_BENCH("Bvh.Build.128k")
+{
+	RunTerrainBuildBench(state, nullptr);
+}
+
+MICRO_BENCH("Bvh.Build.128k.Jobs")
+{
+	RunTerrainBuildBench(state, &GetBenchJobSystem());
+}
+
+MICRO_BENCH("Bvh.ClosestHit.128k")
+{
+	RunTerrainRaycastBench<false>(state);
+}
+
+// Shadow and line of sight tests only need to know whether anything is in the way
+MICRO_BENCH("Bvh.AnyHit.128k")
+{
+	RunTerrainRaycastBench<true>(state);
+}
+
+MICRO_BENCH("Bvh.SceneBuild.10k")
+{
+	InstanceScene instances;
+	state.itemsPerIteration = InstanceCount;
+	state.ResetTimer();
+
+	for (uint64_t i = 0; i < state.iterations; i++)
+	{
+		instances.scene.Build();
+		DoNotOptimize(instances.scene.GetBvh().GetBounds());
+	}
+}
+
+// Every instance moves a little each frame, then the tree is refit rather than rebuilt
+MICRO_BENCH("Bvh.SceneRefit.10k")
+{
+	InstanceScene instances;
+	instances.scene.Build();
+	state.itemsPerIteration = InstanceCount;
+	state.ResetTimer();
+
+	for (uint64_t i = 0; i < state.iterations; i++)
+	{
+		const float offset = (i & 1) != 0 ? -0.5f : 0.5f;
+		for (uint32_t instance = 0; instance < InstanceCount; instance++)
+		{
+			float* world = &instances.worlds[instance * 16];
+			world[13] += offset;
+			instances.scene.SetTransform(instance, world);
+		}
+		instances.scene.Refit();
+		DoNotOptimize(instances.scene.GetBvh().GetBounds());
+	}
+}
+
+MICRO_BENCH("Bvh.SceneRaycast.10k")
+{
+	InstanceScene instances;
+	instances.scene.Build();
+	std::vector<BvhRay> rays;
+	MakeSceneRays(RayCount, rays);
+
+	uint32_t hitCount = 0;
+	state.itemsPerIteration = RayCount;
+	state.ResetTimer();
+
+	for (uint64_t i = 0; i < state.iterations; i++)
+	{
+		hitCount = 0;
+		for (const BvhRay& ray : rays)
+		{
+			BvhHit hit;
+			hitCount += instances.scene.Intersect(ray, hit) ? 1 : 0;
+		}
+		DoNotOptimize(hitCount);
+	}
+	state.SetCounter("% hit", 100.0 * hitCount / RayCount);
+}
+
+// The nearest buildings are drawn into the depth buffer, bin by bin
+MICRO_BENCH("Occlusion.Rasterize.City")
+{
+	RunOcclusionRasterizeBench(state, nullptr);
+}
+
+MICRO_BENCH("Occlusion.Rasterize.City.Jobs")
+{
+	RunOcclusionRasterizeBench(state, &GetBenchJobSystem());
+}
+
+MICRO_BENCH("Occlusion.TestBoxes.City")
+{
+	const CityScene city;
+	OcclusionCuller culler(OcclusionWidth, OcclusionHeight);
+	city.Rasterize(culler, nullptr);
+	std::vector<uint8_t> visible(city.GetBoxCount());
+	state.itemsPerIteration = city.GetBoxCount();
+	state.ResetTimer();
+
+	for (uint64_t i = 0; i < state.iterations; i++)
+	{
+		culler.TestBoxes(city.boxes.data(), city.GetBoxCount(), visible.data());
+		DoNotOptimize(visible[0]);
+	}
+	SetCullingCounters(state, culler.GetStats(), visible);
+}
+
+// All of a frame's culling, as the app does it before recording draws
+MICRO_BENCH("Occlusion.Frame.City.Jobs")
+{
+	const CityScene city;
+	OcclusionCuller culler(OcclusionWidth, OcclusionHeight);
+	std::vector<uint8_t> visible(city.GetBoxCount());
+	JobSystem& jobSystem = GetBenchJobSystem();
+	state.itemsPerIteration = city.GetBoxCount();
+	state.ResetTimer();
+
+	for (uint64_t i = 0; i < state.iterations; i++)
+	{
+		city.Rasterize(culler, &jobSystem);
+		culler.TestBoxes(city.boxes.data(), city.GetBoxCount(), visible.data(), &jobSystem);
+		DoNotOptimize(visible[0]);
+	}
+	SetCullingCounters(state, culler.GetStats(), visible);
+}
@@ -0,0 +1,105 @@
+// Texture benchmarks - mip generation, block compression and capture encoding
+
+#include "MicroBench.h"
+#include "BlockCompression.h"
+#include "QoiCodec.h"
+#include "TextureImage.h"
+
+#include <cstring>
+
+namespace
+{
+	const uint32_t ImageSize = 256;
+
+	// Gradients with a little noise, roughly like a photo
+	void MakeImage(TextureImage& image)
+	{
+		image.Resize(ImageSize, ImageSize);
+		uint32_t random = 1;
+		for (size_t i = 0; i < image.rgba.size(); i++)
+		{
+			random = random * 1664525u + 1013904223u;
+			const size_t pixel = i / 4;
+			const uint32_t gradient = static_cast<uint32_t>((pixel % ImageSize + (pixel / ImageSize) * (i % 4)) % 256);
+			image.rgba[i] = static_cast<uint8_t>((gradient + (random >> 29)) & 0xFF);
+		}
+	}
+
+	void RunMipBench(BenchState& state, EMipFilter filter)
+	{
+		TextureImage image;
+		MakeImage(image);
+		std::vector<TextureImage> mips;
+		state.ResetTimer();
+
+		for (uint64_t i = 0; i < state.iterations; i++)
+		{
+			GenerateMipChain(image, filter, true, mips);
+			DoNotOptimize(mips.back().rgba.data());
+		}
+	}
+
+	// Each iteration compresses one block, cycling through the image's blocks
+	void RunEncodeBench(BenchState& state, EBlockFormat format)
+	{
+		TextureImage image;
+		MakeImage(image);
+		const uint32_t blocksPerRow = ImageSize / 4;
+		uint8_t pixels[16 * 4];
+		uint8_t block[16];
+		state.ResetTimer();
+
+		for (uint64_t i = 0; i < state.iterations; i++)
+		{
+			const uint32_t blockIndex = static_cast<uint32_t>(i % (blocksPerRow * blocksPerRow));
+			const uint32_t blockX = blockIndex % blocksPerRow;
+			const uint32_t blockY = blockIndex / blocksPerRow;
+			for (uint32_t y = 0; y < 4; y++)
+			{
+				memcpy(pixels + y * 16, &image.rgba[((blockY * 4 + y) * ImageSize + blockX * 4) * 4], 16);
+			}
+			EncodeBlock(format, pixels, block);
+			DoNotOptimize(block);
+		}
+	}
+}
+
+MICRO_BENCH("Texture.Mips.Box")
+{
+	RunMipBench(state, MipFilter_Box);
+}
+
+MICRO_BENCH("Texture.Mips.Kaiser")
+{
+	RunMipBench(state, MipFilter_Kaiser);
+}
+
+MICRO_BENCH("Texture.Encode.BC1")
+{
+	RunEncodeBench(state, BlockFormat_BC1);
+}
+
+MICRO_BENCH("Texture.Encode.BC5")
+{
+	RunEncodeBench(state, BlockFormat_BC5);
+}
+
+MICRO_BENCH("Texture.Encode.BC7")
+{
+	RunEncodeBench(state, BlockFormat_BC7);
+}
+
+// One image per iteration, as written for each frame capture
+MICRO_BENCH("Texture.Encode.Qoi")
+{
+	TextureImage image;
+	MakeImage(image);
+	std::vector<uint8_t> buffer;
+	state.itemsPerIteration = static_cast<uint64_t>(ImageSize) * ImageSize;
+	state.ResetTimer();
+
+	for (uint64_t i = 0; i < state.iterations; i++)
+	{
+		DoNotOptimize(EncodeQoi(image.rgba.data(), image.width, image.height, image.width * 4, 3, buffer));
+	}
+}
@@ -1,13 +1,87 @@
 #include "Includes.h"
 #include "MyD3D12App.h"
+#include "Input.h"
+#include "Profiler.h"
+#include "TaskGraph.h"
+
+#include <algorithm>
+
+namespace
+{
+	const float CameraNearZ = 0.1f;
+	const float CameraFarZ = 1000.0f;
+
+	// IDs in the scene's draw keys. There's only the one pipeline state and mesh so far.
+	const uint32_t ScenePsoId = 0;
+	const uint32_t TriangleMeshId = 0;
+
+	// The occlusion depth buffer is small, as it's filled on the CPU. Objects whose bounding
+	// spheres are wider than this fraction of their distance are drawn into it.
+	const uint32_t OcclusionBufferWidth = 256;
+	const float MinOccluderSize = 0.1f;
+
+	// Clustered lighting splits the view into 16x9 tiles, each cut into 24 slices by depth.
+	// Without lights the scene is drawn as it always was, fully lit.
+	const uint32_t LightClustersX = 16;
+	const uint32_t LightClustersY = 9;
+	const uint32_t LightClustersZ = 24;
+	const float LitSceneAmbient = 0.2f;
+
+	// Upload memory is defragmented once this fraction of its free space is outside the largest
+	// free block, if there is more than one heap to move allocations between. It's only checked
+	// every so often, so a defragment that can't fit everything elsewhere isn't retried each frame.
+	// F3 forces one.
+	const float UploadDefragThreshold = 0.5f;
+	const UINT UploadDefragCheckInterval = 60;
+
+	// The scene's root parameters
+	const UINT SceneRootParameter_DrawConstants = 0;
+	const UINT SceneRootParameter_PassConstants = 1;
+	const UINT SceneRootParameter_ObjectConstants = 2;
+	const UINT SceneRootParameter_Lights = 3;
+	const UINT SceneRootParameter_ClusterRanges = 4;
+	const UINT SceneRootParameter_LightIndices = 5;
+
+	// The triangle's corners, in its own space, for both drawing and picking
+	void GetTriangleCorners(float aspectRatio, XMFLOAT3 corners[3])
+	{
+		corners[0] = XMFLOAT3(0.0f, 0.25f * aspectRatio, 0.0f);
+		corners[1] = XMFLOAT3(0.25f, -0.25f * aspectRatio, 0.0f);
+		corners[2] = XMFLOAT3(-0.25f, -0.25f * aspectRatio, 0.0f);
+	}
+}
 
 MyD3D12App::MyD3D12App(UINT width, UINT height, std::wstring name) :
 	DXSample(width, height, name),
+	mFrameLatencyWaitable(nullptr),
+	mTearingSupported(false),
 	mFrameIndex(0),
 	mViewport(0.0f, 0.0f, static_cast<float>(width), static_cast<float>(height)),
 	mScissorRect(0, 0, static_cast<LONG>(width), static_cast<LONG>(height)),
-	mRtvDescriptorSize(0)
+	mRtvDescriptorSize(0),
+	mScenePso(PsoCache::InvalidHandle),
+	mSceneReplayStats(),
+	mScenePacketPipeline(nullptr),
+	mScenePacketVertexBuffer(),
+	mRenderGraph(&mResourceStates),
+	mVertexBuffer(GpuMemoryAllocator::InvalidHandle),
+	mTimestampReadback(GpuMemoryAllocator::InvalidHandle),
+	mTimestampFrequency(0),
+	mShowDebugHud(true),
+	mDebugDraw(mJobSystem->GetThreadCount()),
+	mShowBounds(false),
+	mObjectConstants(sizeof(ObjectConstants)),
+	mViewProj(MathHelper::Identity4x4()),
+	mPickedObject(-1),
+	mPickedDistance(0.0f),
+	mOcclusionCuller(OcclusionBufferWidth, OcclusionBufferWidth * height / width),
+	mLightClusters(LightClustersX, LightClustersY, LightClustersZ)
 {
+	for (UINT n = 0; n < FrameCount; n++)
+	{
+		mRenderTargets[n] = ResourceRegistry::InvalidHandle;
+		mFrameFenceValues[n] = 0;
+	}
 }
 
 MyD3D12App::~MyD3D12App()
@@ -16,12 +90,45 @@ MyD3D12App::~MyD3D12App()
 
 void MyD3D12App::OnInit()
 {
-	LoadPipeline();
-	LoadAssets();
+	// Start reading the shader source now so the read overlaps device creation
+	auto shaderSource = std::make_shared<std::promise<IOResult>>();
+	mShaderSource = shaderSource->get_future();
+	ReadAssetAsync(L"shaders.hlsl", IOPriority_High,
+		[shaderSource](IOResult& result) { shaderSource->set_value(std::move(result)); });
+
+	// Startup runs as a graph on the job system, so shader compiling and scene building
+	// overlap device and swap chain creation. The swap chain is made on this thread as
+	// it belongs to the window.
+	ComPtr<IDXGIFactory4> factory;
+	TaskGraph startup;
+	const TaskGraph::TaskId device = startup.AddTask("CreateDevice", [this, &factory]() { CreateDevice(factory); });
+	const TaskGraph::TaskId allocators = startup.AddTask("CreateGpuAllocators", [this]() { CreateGpuAllocators(); }, { device });
+	startup.AddTask("CreateSwapChain", [this, &factory]() { CreateSwapChain(factory); }, { device }, TaskThread_Main);
+	const TaskGraph::TaskId shaders = startup.AddTask("CompileShaders", [this]() { CompileShaders(); });
+	const TaskGraph::TaskId rootSignature = startup.AddTask("CreateRootSignature", [this]() { CreateRootSignature(); }, { device });
+	startup.AddTask("CreatePSO", [this]() { CreatePSO(); }, { shaders, rootSignature, allocators });
+	startup.AddTask("CreateVertexBuffer", [this]() { CreateVertexBuffer(); }, { allocators });
+	startup.AddTask("CreateScene", [this]() { CreateScene(); });
+	startup.AddTask("CreateFence", [this]() { CreateFence(); }, { device });
+	startup.Run(*mJobSystem, mClock);
+
+	OutputDebugStringA("Startup:\n");
+	OutputDebugStringA(startup.FormatReport().c_str());
+
+	// A benchmark's frames must all be the same from the first, so don't start it until the scene can be drawn.
+	// The HUD is left off so it isn't measured, but can still be turned on.
+	if (mBenchmark != nullptr)
+	{
+		mShowDebugHud = false;
+		mPsoCache->Wait(mScenePso);
+	}
+
+	// Wait until assets have been uploaded to the GPU
+	WaitForGpu();
 }
 
-// Load the rendering pipeline dependencies
-void MyD3D12App::LoadPipeline()
+// Create the device and the command queue, along with the DXGI factory the swap chain is made from
+void MyD3D12App::CreateDevice(ComPtr<IDXGIFactory4>& factory)
 {
 	UINT dxgiFactoryFlags = 0;
 
@@ -40,7 +147,6 @@ void MyD3D12App::LoadPipeline()
 #endif
 
 	// Create the DXGI factory - which enables creating DXGI objects (e.g. swap chain)
-	ComPtr<IDXGIFactory4> factory;
 	ThrowIfFailed(CreateDXGIFactory2(dxgiFactoryFlags, IID_PPV_ARGS(&factory)));
 
 	if (mUseWarpDevice)
@@ -75,6 +181,57 @@ void MyD3D12App::LoadPipeline()
 	queueDesc.Type = D3D12_COMMAND_LIST_TYPE_DIRECT; // A command buffer that the GPU can execute
 
 	ThrowIfFailed(mDevice->CreateCommandQueue(&queueDesc, IID_PPV_ARGS(&mCommandQueue)));
+}
+
+// Create the allocators for GPU memory, pipeline states and command lists, and the timestamp queries
+void MyD3D12App::CreateGpuAllocators()
+{
+	mUploadAllocator.reset(new GpuMemoryAllocator(mDevice.Get(), D3D12_HEAP_TYPE_UPLOAD));
+	mReadbackAllocator.reset(new GpuMemoryAllocator(mDevice.Get(), D3D12_HEAP_TYPE_READBACK));
+	mDefaultAllocator.reset(new GpuMemoryAllocator(mDevice.Get(), D3D12_HEAP_TYPE_DEFAULT));
+
+	// Create the timestamp queries used to time the frame on the GPU
+	D3D12_QUERY_HEAP_DESC timestampHeapDesc = {};
+	timestampHeapDesc.Type = D3D12_QUERY_HEAP_TYPE_TIMESTAMP;
+	timestampHeapDesc.Count = 2;
+	ThrowIfFailed(mDevice->CreateQueryHeap(&timestampHeapDesc, IID_PPV_ARGS(&mTimestampHeap)));
+	ThrowIfFailed(mCommandQueue->GetTimestampFrequency(&mTimestampFrequency));
+	mTimestampReadback = mReadbackAllocator->Allocate(FrameCount * timestampHeapDesc.Count * sizeof(UINT64), D3D12_RESOURCE_STATE_COPY_DEST);
+
+	ID3D12Device* device = mDevice.Get();
+	mPsoCache.reset(new PsoCache(mJobSystem.get(), [device](const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc) -> ComPtr<ID3D12PipelineState>
+	{
+		ComPtr<ID3D12PipelineState> pipelineState;
+		if (FAILED(device->CreateGraphicsPipelineState(&desc, IID_PPV_ARGS(&pipelineState))))
+		{
+			return nullptr;
+		}
+		return pipelineState;
+	}));
+
+	mCommandListPool.reset(new CommandListPool(mDevice.Get()));
+	mFrameCapture.reset(new FrameCapture(mDevice.Get(), mReadbackAllocator.get(), mJobSystem.get()));
+
+	mDebugHudRenderer.reset(new DebugHudRenderer(mDevice.Get(), mUploadAllocator.get()));
+	mResourceStates.Register(mDebugHudRenderer->GetAtlas(), D3D12_RESOURCE_STATE_COPY_DEST);
+	mDebugDrawRenderer.reset(new DebugDrawRenderer(mDevice.Get(), mUploadAllocator.get()));
+	mGpuObjectConstants.reset(new GpuConstantStore(mDefaultAllocator.get(), mUploadAllocator.get(), &mResourceStates));
+	mGpuLightClusters.reset(new GpuLightClusters(mUploadAllocator.get()));
+}
+
+// Create the swap chain and the render target views of its buffers
+void MyD3D12App::CreateSwapChain(const ComPtr<IDXGIFactory4>& factory)
+{
+	// Tearing lets frames be presented without waiting for vsync on variable refresh displays
+	ComPtr<IDXGIFactory5> factory5;
+	if (SUCCEEDED(factory.As(&factory5)))
+	{
+		BOOL allowTearing = FALSE;
+		if (SUCCEEDED(factory5->CheckFeatureSupport(DXGI_FEATURE_PRESENT_ALLOW_TEARING, &allowTearing, sizeof(allowTearing))))
+		{
+			mTearingSupported = allowTearing == TRUE;
+		}
+	}
 
 	// Describe and create the swap chain
 	DXGI_SWAP_CHAIN_DESC1 swapChainDesc = {};
@@ -85,6 +242,11 @@ void MyD3D12App::LoadPipeline()
 	swapChainDesc.BufferUsage = DXGI_USAGE_RENDER_TARGET_OUTPUT; // Rendering to the back buffer
 	swapChainDesc.SwapEffect = DXGI_SWAP_EFFECT_FLIP_DISCARD; // discard pixels after presenting
 	swapChainDesc.SampleDesc.Count = 1; // The number of multisamples (single sampling here)
+	swapChainDesc.Flags = DXGI_SWAP_CHAIN_FLAG_FRAME_LATENCY_WAITABLE_OBJECT; // Lets us wait until a new frame can be queued
+	if (mTearingSupported)
+	{
+		swapChainDesc.Flags |= DXGI_SWAP_CHAIN_FLAG_ALLOW_TEARING;
+	}
 
 	ComPtr<IDXGISwapChain1> swapChain;
 	ThrowIfFailed(factory->CreateSwapChainForHwnd(
@@ -101,118 +263,583 @@ void MyD3D12App::LoadPipeline()
 	ThrowIfFailed(swapChain.As(&mSwapChain)); // Check we can use the IDXGISwapChain1 as an IDXGISwapChain3
 	mFrameIndex = mSwapChain->GetCurrentBackBufferIndex(); // Introduced in IDSGISwapChain3
 
+	// Limit how many frames can be queued, and have the frame pacer wait on the swap chain
+	// at the start of each frame so it doesn't block in Present instead
+	ThrowIfFailed(mSwapChain->SetMaximumFrameLatency(mFramePacer.GetSettings().maxFrameLatency));
+	mFrameLatencyWaitable = mSwapChain->GetFrameLatencyWaitableObject();
+	HANDLE frameLatencyWaitable = mFrameLatencyWaitable;
+	mFramePacer.SetLatencyWait([frameLatencyWaitable]()
+	{
+		WaitForSingleObjectEx(frameLatencyWaitable, 1000, TRUE);
+	});
+
 	// Create an rtv descriptor heap then use that to create an RTV for each frame
 	CreateDescriptorHeaps();
 	CreateFrameResouces();
+}
 
-	ThrowIfFailed(mDevice->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&mCommandAllocator)));
+// Create synchronisation objects
+void MyD3D12App::CreateFence()
+{
+	ThrowIfFailed(mDevice->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&mFence)));
+	mFenceValue = 1;
+
+	// Create an event handle to use for frame synchronisation
+	mFenceEvent = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+	if (mFenceEvent == nullptr)
+	{
+		ThrowIfFailed(HRESULT_FROM_WIN32(GetLastError()));
+	}
 }
 
-void MyD3D12App::LoadAssets()
+// Update frame based values
+void MyD3D12App::OnUpdate(const float deltaTime)
 {
-	CreateRootSignature();
-	CreatePSO();
-		
-	// Create the command list
-	ThrowIfFailed(mDevice->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, mCommandAllocator.Get(), mPipelineState.Get(), IID_PPV_ARGS(&mCommandList)));
+	PROFILE_ZONE("Update");
 
-	// Close the command list (the command list is created in the recording state
-	ThrowIfFailed(mCommandList->Close());
+	if (KeyHit(Key_F12) || std::find(mCaptureFrames.begin(), mCaptureFrames.end(), mFrameNumber) != mCaptureFrames.end())
+	{
+		WCHAR path[64];
+		swprintf_s(path, L"capture_%06u.qoi", mFrameNumber);
+		mFrameCapture->Request(path);
+	}
 
-	CreateVertexBuffer();
+	if (KeyHit(Key_F1))
+	{
+		mShowDebugHud = !mShowDebugHud;
+	}
+	if (mShowDebugHud)
+	{
+		BuildDebugHud();
+	}
 
-	// Create synchronisation objects and wait until assets have been uploaded to the GPU
+	if (KeyHit(Key_F3))
 	{
-		ThrowIfFailed(mDevice->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&mFence)));
-		mFenceValue = 1;
+		mUploadAllocator->ScheduleDefragment();
+	}
 
-		// Create an event handle to use for frame synchronisation
-		mFenceEvent = CreateEvent(nullptr, FALSE, FALSE, nullptr);
-		if (mFenceEvent == nullptr)
-		{
-			ThrowIfFailed(HRESULT_FROM_WIN32(GetLastError()));
-		}
+	// Last frame's lines have been drawn, so start again
+	mDebugDraw.Reset();
+	if (KeyHit(Key_F2))
+	{
+		mShowBounds = !mShowBounds;
+	}
+	if (mShowBounds)
+	{
+		AddDebugBounds();
+	}
 
-		// Wait for command list to execute
-		WaitForPreviousFrame();
+	if (KeyHit(Mouse_LButton))
+	{
+		PickObject(static_cast<float>(GetMouseX()), static_cast<float>(GetMouseY()));
+	}
+	if (mPickedObject >= 0)
+	{
+		const XMFLOAT4& bounds = mObjectBounds[mPickedObject];
+		mDebugDraw.AddSphere(&bounds.x, bounds.w, DebugColour(255, 255, 0));
 	}
-}
 
-// Update frame based values
-void MyD3D12App::OnUpdate(const float deltaTime)
-{
+	// The triangle is drawn as it is, with no camera
+	if (mBenchmark == nullptr)
+	{
+		return;
+	}
+
+	// The benchmark camera only depends on the frame number, so every run sees the same frames
+	const BenchmarkCamera camera = GetBenchmarkCamera(*mBenchmark, mBenchmarkFrame);
+	const XMVECTOR eye = XMVectorSet(camera.eye[0], camera.eye[1], camera.eye[2], 1.0f);
+	const XMVECTOR target = XMVectorSet(camera.target[0], camera.target[1], camera.target[2], 1.0f);
+	const XMMATRIX view = XMMatrixLookAtLH(eye, target, XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+	const XMMATRIX proj = XMMatrixPerspectiveFovLH(XM_PIDIV4, mAspectRatio, CameraNearZ, CameraFarZ);
+	XMStoreFloat4x4(&mViewProj, view * proj);
 
+	CullObjects();
+	AssignLights(view);
 }
 
 // Render the scene
 void MyD3D12App::OnRender()
 {
-	// Record all the commands we need to render teh scene into the command list
+	// Record all the commands we need to render teh scene into the command list. Once warmed
+	// up, recording and submitting a frame shouldn't touch the heap.
+	BeginSteadyAllocationCheck();
 	PopulateCommandList();
 
-	// Execute the command list
-	ID3D12CommandList* ppCommandLists[] = { mCommandList.Get() };
-	mCommandQueue->ExecuteCommandLists(_countof(ppCommandLists), ppCommandLists);
+	// Work out which resources need moving into the state the command list expects,
+	// and if any do, run those barriers in a small list ahead of the main one
+	mFixupBarriers.clear();
+	if (mStateTracker.ResolvePendingBarriers(mResourceStates, mFixupBarriers) > 0)
+	{
+		CommandListPool::CommandList fixup = mCommandListPool->Acquire(D3D12_COMMAND_LIST_TYPE_DIRECT, mFence->GetCompletedValue());
+		fixup.list->ResourceBarrier(static_cast<UINT>(mFixupBarriers.size()), mFixupBarriers.data());
+		ThrowIfFailed(fixup.list->Close());
+
+		ID3D12CommandList* ppCommandLists[] = { fixup.list.Get(), mCommandList.list.Get() };
+		mCommandQueue->ExecuteCommandLists(_countof(ppCommandLists), ppCommandLists);
+		mCommandListPool->Release(D3D12_COMMAND_LIST_TYPE_DIRECT, std::move(fixup), mFenceValue);
+	}
+	else
+	{
+		ID3D12CommandList* ppCommandLists[] = { mCommandList.list.Get() };
+		mCommandQueue->ExecuteCommandLists(_countof(ppCommandLists), ppCommandLists);
+	}
+
+	// The lists can be reused once the fence signalled after this frame has passed
+	mCommandListPool->Release(D3D12_COMMAND_LIST_TYPE_DIRECT, std::move(mCommandList), mFenceValue);
+	mCommandList = CommandListPool::CommandList();
+
+	mStateTracker.CommitFinalStates(mResourceStates);
+	EndSteadyAllocationCheck();
 
 	// Present the frame
-	ThrowIfFailed(mSwapChain->Present(1, 0));
+	{
+		PROFILE_ZONE("Present");
+		const UINT presentFlags = mFramePacer.ShouldAllowTearing(mTearingSupported) ? DXGI_PRESENT_ALLOW_TEARING : 0;
+		ThrowIfFailed(mSwapChain->Present(mFramePacer.GetSyncInterval(), presentFlags));
+	}
+
+	// Mark the end of the frame's work, and tell the pacer how many frames the GPU has queued
+	ThrowIfFailed(mCommandQueue->Signal(mFence.Get(), mFenceValue));
+	mFrameFenceValues[mFrameIndex] = mFenceValue;
+	mFenceValue++;
+	mFramePacer.EndFrame(static_cast<unsigned int>(mFrameFenceValues[mFrameIndex] - mFence->GetCompletedValue()));
 
-	WaitForPreviousFrame();
+	MoveToNextFrame();
+
+	// The next back buffer's last frame has finished, so its timestamps are ready
+	const int64_t gpuTime = ReadGpuFrameTime(mFrameIndex);
+	RecordFrameStats(gpuTime);
+	mFrameTimeHistory.Add(static_cast<float>(NanosecondsToMilliseconds(mFramePacer.GetLastFrame().cpuTime)),
+		gpuTime >= 0 ? static_cast<float>(NanosecondsToMilliseconds(gpuTime)) : -1.0f);
 }
 
 void MyD3D12App::OnDestroy()
 {
-	WaitForPreviousFrame();
+	WaitForGpu();
+
+	for (UINT n = 0; n < FrameCount; n++)
+	{
+		mResourceRegistry.Release(mRenderTargets[n]);
+	}
+	mResourceRegistry.ProcessDeferredReleases(mFence->GetCompletedValue());
+
+	char poolReport[256];
+	mCommandListPool->FormatReport(poolReport, sizeof(poolReport));
+	OutputDebugStringA(poolReport);
+
+	// Waits for any captures still being written
+	char captureReport[256];
+	mFrameCapture->FormatReport(captureReport, sizeof(captureReport));
+	mFrameCapture.reset();
+	OutputDebugStringA(captureReport);
+
+	mDebugHudRenderer.reset();
+	mDebugDrawRenderer.reset();
+
+	char constantsReport[128];
+	sprintf_s(constantsReport, "Object constants: %llu bytes uploaded over %u frames\n",
+		mGpuObjectConstants->GetTotalUploadedBytes(), mFrameNumber);
+	OutputDebugStringA(constantsReport);
+	mGpuObjectConstants.reset();
+	mGpuLightClusters.reset();
+
+	WriteFrameStats();
 
 	CloseHandle(mFenceEvent);
+	CloseHandle(mFrameLatencyWaitable);
 }
 
 void MyD3D12App::PopulateCommandList()
 {
-	ThrowIfFailed(mCommandAllocator->Reset());
+	PROFILE_ZONE("PopulateCommandList");
+
+	// A list whose previous use the GPU has finished, already reset
+	mCommandList = mCommandListPool->Acquire(D3D12_COMMAND_LIST_TYPE_DIRECT, mFence->GetCompletedValue());
+	ID3D12GraphicsCommandList* commandList = mCommandList.list.Get();
+
+	// The frame's lists come from this thread's frame arena rather than the heap
+	LinearArena& arena = mFrameArenas->GetThreadArena();
+	mStateTracker.Reset(&arena);
+
+	if (mFrameNumber % UploadDefragCheckInterval == 0)
+	{
+		const GpuMemoryAllocator::Stats uploadStats = mUploadAllocator->GetStats();
+		if (uploadStats.heapCount > 1 && uploadStats.fragmentation > UploadDefragThreshold)
+		{
+			mUploadAllocator->ScheduleDefragment();
+		}
+	}
 
-	ThrowIfFailed(mCommandList->Reset(mCommandAllocator.Get(), mPipelineState.Get()));
+	// Buffers may move if a defragment has been scheduled, so fetch their addresses afterwards.
+	// Moved upload buffers aren't copied, so ones whose contents last across frames are rewritten.
+	mUploadAllocator->RunScheduledDefragment(commandList, mFenceValue, [this](GpuMemoryAllocator::Handle handle, void* data)
+	{
+		if (handle == mVertexBuffer)
+		{
+			WriteVertices(data);
+		}
+		else
+		{
+			mDebugHudRenderer->RewriteUpload(handle, data);
+		}
+	});
+	mVertexBufferView.BufferLocation = mUploadAllocator->GetGpuAddress(mVertexBuffer);
 
-	mCommandList->SetGraphicsRootSignature(mRootSignature.Get());
-	mCommandList->RSSetViewports(1, &mViewport);
-	mCommandList->RSSetScissorRects(1, &mScissorRect);
+	commandList->EndQuery(mTimestampHeap.Get(), D3D12_QUERY_TYPE_TIMESTAMP, 0);
 
-	mCommandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(mRenderTargets[mFrameIndex].Get(), D3D12_RESOURCE_STATE_PRESENT, D3D12_RESOURCE_STATE_RENDER_TARGET));
+	commandList->RSSetViewports(1, &mViewport);
+	commandList->RSSetScissorRects(1, &mScissorRect);
+
+	// Describe the frame as a render graph
+	mRenderGraph.Reset(&arena);
+	mResourceRegistry.MarkUsed(mRenderTargets[mFrameIndex], mFenceValue);
+	const RenderGraph::ResourceHandle backBuffer = mRenderGraph.ImportResource("BackBuffer", mResourceRegistry.Get(mRenderTargets[mFrameIndex]), D3D12_RESOURCE_STATE_PRESENT);
+
+	// Only objects whose constants changed since the last frame are copied up
+	mGpuObjectConstants->Prepare(mObjectConstants, mFenceValue, mFence->GetCompletedValue());
+	const RenderGraph::ResourceHandle objectConstants = mRenderGraph.ImportResource("ObjectConstants", mGpuObjectConstants->GetBuffer(), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+	if (mObjectConstants.GetDirtyCount() > 0)
+	{
+		const UINT64 fenceValue = mFenceValue;
+		mRenderGraph.AddPass("ObjectConstantUpload",
+			[objectConstants](RenderGraph::PassBuilder& builder)
+			{
+				builder.Write(objectConstants, D3D12_RESOURCE_STATE_COPY_DEST);
+			},
+			[this, fenceValue](ID3D12GraphicsCommandList* commandList, const RenderGraph&)
+			{
+				mGpuObjectConstants->RecordUpload(commandList, mObjectConstants, fenceValue, mFence->GetCompletedValue());
+			});
+	}
+
+	mRenderGraph.AddPass("Scene",
+		[backBuffer, objectConstants](RenderGraph::PassBuilder& builder)
+		{
+			builder.Read(objectConstants, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+			builder.Write(backBuffer, D3D12_RESOURCE_STATE_RENDER_TARGET);
+		},
+		[this](ID3D12GraphicsCommandList* commandList, const RenderGraph&)
+		{
+			RecordScenePass(commandList);
+		});
+
+	// Only added on frames being captured. The copy is read once this frame's fence has passed.
+	if (mFrameCapture->HasRequest())
+	{
+		const UINT64 fenceValue = mFenceValue;
+		mRenderGraph.AddPass("Capture",
+			[backBuffer](RenderGraph::PassBuilder& builder)
+			{
+				builder.Read(backBuffer, D3D12_RESOURCE_STATE_COPY_SOURCE);
+				builder.SetSideEffects();
+			},
+			[this, backBuffer, fenceValue](ID3D12GraphicsCommandList* commandList, const RenderGraph& graph)
+			{
+				mFrameCapture->RecordCopy(commandList, graph.GetResource(backBuffer), fenceValue);
+			});
+	}
+
+	// Lines and the HUD are drawn after the capture copy, so captures don't include them
+	if (mDebugDraw.GetVertexCount() > 0)
+	{
+		mRenderGraph.AddPass("DebugDraw",
+			[backBuffer](RenderGraph::PassBuilder& builder)
+			{
+				builder.Write(backBuffer, D3D12_RESOURCE_STATE_RENDER_TARGET);
+			},
+			[this](ID3D12GraphicsCommandList* commandList, const RenderGraph&)
+			{
+				RecordDebugDrawPass(commandList);
+			});
+	}
+
+	// The HUD's atlas is copied up by the first frame that shows it
+	if (mShowDebugHud)
+	{
+		const RenderGraph::ResourceHandle atlas = mRenderGraph.ImportResource("HudAtlas", mDebugHudRenderer->GetAtlas(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+		if (!mDebugHudRenderer->IsAtlasUploaded())
+		{
+			const UINT64 fenceValue = mFenceValue;
+			mRenderGraph.AddPass("HudAtlasUpload",
+				[atlas](RenderGraph::PassBuilder& builder)
+				{
+					builder.Write(atlas, D3D12_RESOURCE_STATE_COPY_DEST);
+				},
+				[this, fenceValue](ID3D12GraphicsCommandList* commandList, const RenderGraph&)
+				{
+					mDebugHudRenderer->RecordAtlasUpload(commandList, fenceValue);
+				});
+		}
+
+		mRenderGraph.AddPass("DebugHud",
+			[atlas, backBuffer](RenderGraph::PassBuilder& builder)
+			{
+				builder.Read(atlas, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+				builder.Write(backBuffer, D3D12_RESOURCE_STATE_RENDER_TARGET);
+			},
+			[this](ID3D12GraphicsCommandList* commandList, const RenderGraph&)
+			{
+				RecordDebugHudPass(commandList);
+			});
+	}
+
+	// Only does any work the first frame, or if the passes change
+	ID3D12Device* device = mDevice.Get();
+	const bool recompiled = mRenderGraph.Compile([device](const D3D12_RESOURCE_DESC& desc)
+	{
+		const D3D12_RESOURCE_ALLOCATION_INFO info = device->GetResourceAllocationInfo(0, 1, &desc);
+		RenderGraph::AllocationInfo allocation = { info.SizeInBytes, info.Alignment };
+		return allocation;
+	});
+
+	if (recompiled)
+	{
+		const RenderGraph::CompileStats& stats = mRenderGraph.GetCompileStats();
+		char message[256];
+		sprintf_s(message, "Render graph compiled: %u passes (%u culled), %u transients, %llu bytes transient memory (%llu without aliasing)\n",
+			stats.passCount, stats.culledPassCount, stats.transientCount, stats.transientHeapSize, stats.unaliasedSize);
+		OutputDebugStringA(message);
+	}
+
+	mRenderGraph.CreateTransientResources(device);
+	mRenderGraph.Execute(commandList, mStateTracker, mFenceValue);
+
+	commandList->EndQuery(mTimestampHeap.Get(), D3D12_QUERY_TYPE_TIMESTAMP, 1);
+	commandList->ResolveQueryData(mTimestampHeap.Get(), D3D12_QUERY_TYPE_TIMESTAMP, 0, 2,
+		mReadbackAllocator->GetResource(mTimestampReadback), mReadbackAllocator->GetOffset(mTimestampReadback) + mFrameIndex * 2 * sizeof(UINT64));
+
+	ThrowIfFailed(commandList->Close());
+}
+
+// Clear the back buffer and draw the scene into it
+void MyD3D12App::RecordScenePass(ID3D12GraphicsCommandList* commandList)
+{
+	PROFILE_ZONE("ScenePass");
 
 	CD3DX12_CPU_DESCRIPTOR_HANDLE rtvHandle(mRtvHeap->GetCPUDescriptorHandleForHeapStart(), mFrameIndex, mRtvDescriptorSize);
-	mCommandList->OMSetRenderTargets(1, &rtvHandle, FALSE, nullptr);
+	commandList->OMSetRenderTargets(1, &rtvHandle, FALSE, nullptr);
 
 	const float clearColour[] = { 0.0f, 0.2f, 0.4f, 1.0f };
-	mCommandList->ClearRenderTargetView(rtvHandle, clearColour, 0, nullptr);
-	mCommandList->IASetPrimitiveTopology(D3D10_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-	mCommandList->IASetVertexBuffers(0, 1, &mVertexBufferView);
-	mCommandList->DrawInstanced(3, 1, 0, 0);
+	commandList->ClearRenderTargetView(rtvHandle, clearColour, 0, nullptr);
+
+	// Skip drawing until the pipeline state has finished compiling
+	ID3D12PipelineState* pipelineState = mPsoCache->Get(mScenePso);
+	if (pipelineState == nullptr)
+	{
+		return;
+	}
+
+	UpdateScenePackets(pipelineState);
+
+	commandList->IASetPrimitiveTopology(D3D10_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 
-	mCommandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(mRenderTargets[mFrameIndex].Get(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PRESENT));
+	mGpuLightClusters->Upload(mLights.data(), static_cast<uint32_t>(mLights.size()), mLightClusters, mFenceValue, mFence->GetCompletedValue());
 
-	ThrowIfFailed(mCommandList->Close());
+	// HLSL matrices are column major
+	SceneConstants sceneConstants;
+	XMStoreFloat4x4(&sceneConstants.viewProj, XMMatrixTranspose(XMLoadFloat4x4(&mViewProj)));
+	sceneConstants.clusterScale = XMFLOAT2(static_cast<float>(LightClustersX) / GetWidth(), static_cast<float>(LightClustersY) / GetHeight());
+	sceneConstants.sliceScale = mLightClusters.GetSliceScale();
+	sceneConstants.sliceBias = mLightClusters.GetSliceBias();
+	sceneConstants.clusterCount = XMUINT3(LightClustersX, LightClustersY, LightClustersZ);
+	sceneConstants.ambient = mLights.empty() ? 1.0f : LitSceneAmbient;
+
+	CommandListPacketSink sink(commandList);
+	sink.SetPassConstants(SceneRootParameter_PassConstants, sizeof(SceneConstants) / 4, &sceneConstants);
+	sink.SetPassShaderResourceView(SceneRootParameter_ObjectConstants, mGpuObjectConstants->GetGpuAddress());
+	sink.SetPassShaderResourceView(SceneRootParameter_Lights, mGpuLightClusters->GetLightsAddress());
+	sink.SetPassShaderResourceView(SceneRootParameter_ClusterRanges, mGpuLightClusters->GetClusterRangesAddress());
+	sink.SetPassShaderResourceView(SceneRootParameter_LightIndices, mGpuLightClusters->GetLightIndicesAddress());
+	mSceneReplayStats = mScenePackets.Replay(sink, mObjectVisible.data());
+}
+
+// Bake a packet for each object that doesn't have one yet. Packets hold the pipeline state and
+// vertex buffer view, so if either has changed (e.g. the vertex buffer was moved by a defragment)
+// every packet is updated too. Otherwise nothing is rebuilt after the first frame that can draw.
+void MyD3D12App::UpdateScenePackets(ID3D12PipelineState* pipelineState)
+{
+	const uint32_t objectCount = static_cast<uint32_t>(mObjectWorlds.size());
+	const bool stateChanged = pipelineState != mScenePacketPipeline ||
+		mVertexBufferView.BufferLocation != mScenePacketVertexBuffer.BufferLocation ||
+		mVertexBufferView.SizeInBytes != mScenePacketVertexBuffer.SizeInBytes ||
+		mVertexBufferView.StrideInBytes != mScenePacketVertexBuffer.StrideInBytes;
+	if (!stateChanged && mObjectPackets.size() == objectCount)
+	{
+		return;
+	}
+
+	PROFILE_ZONE("BuildScenePackets");
+
+	// Packets are replayed in the same order every frame, so the keys leave out depth and only
+	// group draws by state
+	DrawKeyFields fields = {};
+	fields.pso = ScenePsoId;
+	fields.mesh = TriangleMeshId;
+
+	DrawPacketDesc desc = {};
+	desc.sortKey = EncodeDrawKey(fields);
+	desc.rootSignature = CommandListPacketSink::GetId(mRootSignature.Get());
+	desc.pipelineState = CommandListPacketSink::GetId(pipelineState);
+	desc.vertexBuffer = CommandListPacketSink::GetVertexBuffer(mVertexBufferView);
+	desc.rootParameter = SceneRootParameter_DrawConstants;
+	desc.constantCount = 1;
+	desc.vertexCount = 3;
+	desc.instanceCount = 1;
+
+	const uint32_t firstNew = stateChanged ? 0 : static_cast<uint32_t>(mObjectPackets.size());
+	mObjectPackets.reserve(objectCount);
+	for (uint32_t i = firstNew; i < objectCount; i++)
+	{
+		desc.constants = &i;
+		desc.visibilityIndex = i;
+
+		if (i < mObjectPackets.size())
+		{
+			mScenePackets.Update(mObjectPackets[i], desc);
+		}
+		else
+		{
+			mObjectPackets.push_back(mScenePackets.Add(desc));
+		}
+	}
+
+	mScenePacketPipeline = pipelineState;
+	mScenePacketVertexBuffer = mVertexBufferView;
 }
 
-void MyD3D12App::WaitForPreviousFrame()
+// Fill the HUD from the last frame's stats and profile
+void MyD3D12App::BuildDebugHud()
 {
-	// WAITING FOR THE FRAME TO COMPLETE BEFORE CONTINUING IS NOT BEST PRACTICE.
-	// This is code implemented as such for simplicity. The D3D12HelloFrameBuffering
-	// sample illustrates how to use fences for efficient resource usage and to
-	// maximize GPU utilization.
+	PROFILE_ZONE("DebugHud");
+
+	mDebugHud.Reset();
+	const float x = 8.0f;
+	float y = 8.0f;
+	y += AddFrameStatsPanel(mDebugHud, x, y, mFrameStats, mFrameTimeHistory) + 8.0f;
+	y += AddProfilerPanel(mDebugHud, x, y) + 8.0f;
+
+	mDebugHud.AddTextf(x, y, HudColour(255, 255, 255), "Draws %u, hidden %u, state changes %u, packets rebuilt %u",
+		mSceneReplayStats.drawCount, mSceneReplayStats.hiddenCount, mSceneReplayStats.stateChangeCount, mSceneReplayStats.rebuiltCount);
+	y += DebugHud::LineHeight;
+
+	const GpuConstantStore::Stats& constantStats = mGpuObjectConstants->GetLastStats();
+	mDebugHud.AddTextf(x, y, HudColour(255, 255, 255), "Constants uploaded %llu bytes in %u copies",
+		constantStats.uploadedBytes, constantStats.copyCount);
+	y += DebugHud::LineHeight;
+
+	const OcclusionCuller::Stats& occlusionStats = mOcclusionCuller.GetStats();
+	mDebugHud.AddTextf(x, y, HudColour(255, 255, 255), "Occluder triangles %u, objects occluded %u, off screen %u",
+		occlusionStats.rasterizedTriangleCount, occlusionStats.occludedCount, occlusionStats.outsideCount);
+	y += DebugHud::LineHeight;
+
+	const LightClusters::Stats& lightStats = mLightClusters.GetStats();
+	mDebugHud.AddTextf(x, y, HudColour(255, 255, 255), "Lights %u of %u in view, %u in clusters, at most %u in one",
+		lightStats.visibleLightCount, lightStats.lightCount, lightStats.indexCount, lightStats.maxClusterLightCount);
+	y += DebugHud::LineHeight;
+
+	if (mPickedObject >= 0)
+	{
+		mDebugHud.AddTextf(x, y, HudColour(255, 255, 0), "Picked object %d at distance %.2f", mPickedObject, mPickedDistance);
+	}
+	else
+	{
+		mDebugHud.AddText(x, y, HudColour(255, 255, 255), "Click to pick an object");
+	}
+}
+
+// Show each object's bounding sphere, and the world axes at the origin
+void MyD3D12App::AddDebugBounds()
+{
+	PROFILE_ZONE("DebugBounds");
+
+	for (const XMFLOAT4& bounds : mObjectBounds)
+	{
+		mDebugDraw.AddSphere(&bounds.x, bounds.w, DebugColour(0, 255, 128));
+	}
+
+	const float origin[3] = { 0.0f, 0.0f, 0.0f };
+	const float axes[3][3] = { { 1.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f }, { 0.0f, 0.0f, 1.0f } };
+	mDebugDraw.AddLine(origin, axes[0], DebugColour(255, 0, 0));
+	mDebugDraw.AddLine(origin, axes[1], DebugColour(0, 255, 0));
+	mDebugDraw.AddLine(origin, axes[2], DebugColour(0, 0, 255));
+}
 
-	// Signal and increment the fence value.
+// Draw the frame's debug lines over the back buffer
+void MyD3D12App::RecordDebugDrawPass(ID3D12GraphicsCommandList* commandList)
+{
+	PROFILE_ZONE("DebugDrawPass");
+
+	CD3DX12_CPU_DESCRIPTOR_HANDLE rtvHandle(mRtvHeap->GetCPUDescriptorHandleForHeapStart(), mFrameIndex, mRtvDescriptorSize);
+	commandList->OMSetRenderTargets(1, &rtvHandle, FALSE, nullptr);
+
+	mDebugDrawRenderer->Record(commandList, mDebugDraw, mViewProj, mFenceValue, mFence->GetCompletedValue());
+}
+
+// Draw the HUD over the back buffer
+void MyD3D12App::RecordDebugHudPass(ID3D12GraphicsCommandList* commandList)
+{
+	PROFILE_ZONE("DebugHudPass");
+
+	CD3DX12_CPU_DESCRIPTOR_HANDLE rtvHandle(mRtvHeap->GetCPUDescriptorHandleForHeapStart(), mFrameIndex, mRtvDescriptorSize);
+	commandList->OMSetRenderTargets(1, &rtvHandle, FALSE, nullptr);
+
+	mDebugHudRenderer->Record(commandList, mDebugHud, mWidth, mHeight, mFenceValue, mFence->GetCompletedValue());
+}
+
+// Moves on to the next back buffer, waiting only for the GPU to finish the last frame that used
+// it. Up to FrameCount frames can be in flight, fewer if the swap chain's latency wait is lower.
+void MyD3D12App::MoveToNextFrame()
+{
+	mFrameIndex = mSwapChain->GetCurrentBackBufferIndex();
+	WaitForFence(mFrameFenceValues[mFrameIndex]);
+	ReleaseCompleted();
+}
+
+// Waits for the GPU to finish everything submitted so far, e.g. at startup and shutdown
+void MyD3D12App::WaitForGpu()
+{
 	const UINT64 fence = mFenceValue;
 	ThrowIfFailed(mCommandQueue->Signal(mFence.Get(), fence));
 	mFenceValue++;
 
-	// Wait until the previous frame is finished.
-	if (mFence->GetCompletedValue() < fence)
+	WaitForFence(fence);
+	ReleaseCompleted();
+
+	mFrameIndex = mSwapChain->GetCurrentBackBufferIndex();
+}
+
+void MyD3D12App::WaitForFence(UINT64 fenceValue)
+{
+	PROFILE_ZONE("WaitForGpu");
+
+	if (mFence->GetCompletedValue() < fenceValue)
 	{
-		ThrowIfFailed(mFence->SetEventOnCompletion(fence, mFenceEvent));
+		ThrowIfFailed(mFence->SetEventOnCompletion(fenceValue, mFenceEvent));
 		WaitForSingleObject(mFenceEvent, INFINITE);
 	}
+}
 
-	mFrameIndex = mSwapChain->GetCurrentBackBufferIndex();
+// Frees memory and resources whose last use the GPU has finished
+void MyD3D12App::ReleaseCompleted()
+{
+	const UINT64 completedFenceValue = mFence->GetCompletedValue();
+	mUploadAllocator->ReleaseCompleted(completedFenceValue);
+	mResourceRegistry.ProcessDeferredReleases(completedFenceValue);
+	mRenderGraph.ReleaseCompleted(completedFenceValue);
+	mFrameCapture->ProcessCompleted(completedFenceValue);
+}
+
+// Returns the GPU time of the last frame to use a back buffer in nanoseconds, read from its
+// resolved timestamps, or -1 if there isn't one. That frame must have finished on the GPU.
+int64_t MyD3D12App::ReadGpuFrameTime(UINT frameIndex) const
+{
+	const UINT64* timestamps = static_cast<const UINT64*>(mReadbackAllocator->GetCpuAddress(mTimestampReadback)) + frameIndex * 2;
+	if (mTimestampFrequency == 0 || mFrameFenceValues[frameIndex] == 0 || timestamps[1] < timestamps[0])
+	{
+		return -1;
+	}
+
+	return static_cast<int64_t>(static_cast<double>(timestamps[1] - timestamps[0]) * NanosecondsPerSecond / mTimestampFrequency);
 }
 
 // Create desctiptor heaps
@@ -237,20 +864,34 @@ void MyD3D12App::CreateFrameResouces()
 	// Create an RTV for each frame
 	for (UINT n = 0; n < FrameCount; n++)
 	{
-		ThrowIfFailed(mSwapChain->GetBuffer(n, IID_PPV_ARGS(&mRenderTargets[n])));
-		mDevice->CreateRenderTargetView(mRenderTargets[n].Get(), nullptr, rtvHandle);
+		ComPtr<ID3D12Resource> renderTarget;
+		ThrowIfFailed(mSwapChain->GetBuffer(n, IID_PPV_ARGS(&renderTarget)));
+		mDevice->CreateRenderTargetView(renderTarget.Get(), nullptr, rtvHandle);
+		mResourceStates.Register(renderTarget.Get(), D3D12_RESOURCE_STATE_PRESENT);
+		mRenderTargets[n] = mResourceRegistry.Add(renderTarget, L"BackBuffer");
 		rtvHandle.Offset(1, mRtvDescriptorSize);
 	}
 }
 
-// Create an empty root signature
-// A root signature defines what types of resources are bound to the graphics pipeline
+// Create the root signature
+// A root signature defines what types of resources are bound to the graphics pipeline.
+// Here it's root constants and buffer views, with no descriptor tables.
 void MyD3D12App::CreateRootSignature()
 {
+	// The object index per draw, the camera and clusters per pass, every object's constants,
+	// and the lights with the clusters' light lists
+	CD3DX12_ROOT_PARAMETER rootParameters[6];
+	rootParameters[SceneRootParameter_DrawConstants].InitAsConstants(1, 0, 0, D3D12_SHADER_VISIBILITY_VERTEX);
+	rootParameters[SceneRootParameter_PassConstants].InitAsConstants(sizeof(SceneConstants) / 4, 3, 0, D3D12_SHADER_VISIBILITY_ALL);
+	rootParameters[SceneRootParameter_ObjectConstants].InitAsShaderResourceView(1, 0, D3D12_SHADER_VISIBILITY_VERTEX);
+	rootParameters[SceneRootParameter_Lights].InitAsShaderResourceView(2, 0, D3D12_SHADER_VISIBILITY_PIXEL);
+	rootParameters[SceneRootParameter_ClusterRanges].InitAsShaderResourceView(3, 0, D3D12_SHADER_VISIBILITY_PIXEL);
+	rootParameters[SceneRootParameter_LightIndices].InitAsShaderResourceView(4, 0, D3D12_SHADER_VISIBILITY_PIXEL);
+
 	CD3DX12_ROOT_SIGNATURE_DESC rootSignatureDesc;
 	rootSignatureDesc.Init(
-		0, // Num parameters
-		nullptr, // Ptr to root parameter
+		_countof(rootParameters), // Num parameters
+		rootParameters, // Ptr to root parameter
 		0, // Num static samplers
 		nullptr, // Pointer to static samplers desc
 		D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT); // Flags - this one opts the app into using the input assembler
@@ -261,20 +902,35 @@ void MyD3D12App::CreateRootSignature()
 	ThrowIfFailed(mDevice->CreateRootSignature(0, signature->GetBufferPointer(), signature->GetBufferSize(), IID_PPV_ARGS(&mRootSignature)));
 }
 
-// Create the pipeline state (compile and load shaders)
-void MyD3D12App::CreatePSO()
+// Compile the shaders. Doesn't need the device, so can run alongside its creation.
+void MyD3D12App::CompileShaders()
 {
-	ComPtr<ID3DBlob> vertexShader;
-	ComPtr<ID3DBlob> pixelShader;
-
 #if defined(_DEBUG)
 	UINT compileFlags = D3DCOMPILE_DEBUG | D3DCOMPILE_SKIP_OPTIMIZATION;
 #else
 	UINT compileFlags = 0;
 #endif
 
-	ThrowIfFailed(D3DCompileFromFile(L"shaders.hlsl", nullptr, nullptr, "VSMain", "vs_5_0", compileFlags, 0, &vertexShader, nullptr));
-	ThrowIfFailed(D3DCompileFromFile(L"shaders.hlsl", nullptr, nullptr, "PSMain", "ps_5_0", compileFlags, 0, &pixelShader, nullptr));
+	// Wait for the read started in OnInit
+	IOResult shaderSource = mShaderSource.get();
+	if (shaderSource.status != IOStatus_Completed)
+	{
+		// A cancelled read has no error of its own
+		const bool hasError = shaderSource.status == IOStatus_Failed && shaderSource.error != 0;
+		ThrowIfFailed(hasError ? HRESULT_FROM_WIN32(shaderSource.error) : E_ABORT);
+	}
+
+	ThrowIfFailed(D3DCompile(shaderSource.data.data(), shaderSource.data.size(), "shaders.hlsl", nullptr, nullptr, "VSMain", "vs_5_0", compileFlags, 0, &mVertexShader, nullptr));
+	ThrowIfFailed(D3DCompile(shaderSource.data.data(), shaderSource.data.size(), "shaders.hlsl", nullptr, nullptr, "PSMain", "ps_5_0", compileFlags, 0, &mPixelShader, nullptr));
+	ThrowIfFailed(D3DCompile(shaderSource.data.data(), shaderSource.data.size(), "shaders.hlsl", nullptr, nullptr, "HudVSMain", "vs_5_0", compileFlags, 0, &mHudVertexShader, nullptr));
+	ThrowIfFailed(D3DCompile(shaderSource.data.data(), shaderSource.data.size(), "shaders.hlsl", nullptr, nullptr, "HudPSMain", "ps_5_0", compileFlags, 0, &mHudPixelShader, nullptr));
+	ThrowIfFailed(D3DCompile(shaderSource.data.data(), shaderSource.data.size(), "shaders.hlsl", nullptr, nullptr, "DebugLineVSMain", "vs_5_0", compileFlags, 0, &mDebugLineVertexShader, nullptr));
+	ThrowIfFailed(D3DCompile(shaderSource.data.data(), shaderSource.data.size(), "shaders.hlsl", nullptr, nullptr, "DebugLinePSMain", "ps_5_0", compileFlags, 0, &mDebugLinePixelShader, nullptr));
+}
+
+// Create the pipeline state from the compiled shaders
+void MyD3D12App::CreatePSO()
+{
 
 	// Define the vertex input layout
 	D3D12_INPUT_ELEMENT_DESC inputElementDescs[] =
@@ -287,9 +943,10 @@ void MyD3D12App::CreatePSO()
 	D3D12_GRAPHICS_PIPELINE_STATE_DESC psoDesc = {};
 	psoDesc.InputLayout = { inputElementDescs, _countof(inputElementDescs) };
 	psoDesc.pRootSignature = mRootSignature.Get();
-	psoDesc.VS = CD3DX12_SHADER_BYTECODE(vertexShader.Get());
-	psoDesc.PS = CD3DX12_SHADER_BYTECODE(pixelShader.Get());
+	psoDesc.VS = CD3DX12_SHADER_BYTECODE(mVertexShader.Get());
+	psoDesc.PS = CD3DX12_SHADER_BYTECODE(mPixelShader.Get());
 	psoDesc.RasterizerState = CD3DX12_RASTERIZER_DESC(D3D12_DEFAULT);
+	psoDesc.RasterizerState.CullMode = D3D12_CULL_MODE_NONE;	// The benchmark camera sees triangles from both sides
 	psoDesc.BlendState = CD3DX12_BLEND_DESC(D3D12_DEFAULT);
 	psoDesc.DepthStencilState.DepthEnable = FALSE;
 	psoDesc.DepthStencilState.StencilEnable = FALSE;
@@ -299,43 +956,189 @@ void MyD3D12App::CreatePSO()
 	psoDesc.RTVFormats[0] = DXGI_FORMAT_R8G8B8A8_UNORM;
 	psoDesc.SampleDesc.Count = 1;
 
-	ThrowIfFailed(mDevice->CreateGraphicsPipelineState(&psoDesc, IID_PPV_ARGS(&mPipelineState)));
+	// Compiled on a worker thread. The scene isn't drawn until it's ready.
+	mScenePso = mPsoCache->Request(psoDesc);
+
+	mDebugHudRenderer->CreatePipeline(mPsoCache.get(), mHudVertexShader.Get(), mHudPixelShader.Get());
+	mDebugDrawRenderer->CreatePipeline(mPsoCache.get(), mDebugLineVertexShader.Get(), mDebugLinePixelShader.Get());
 }
 
 // Create the vertex buffer (also define geometry)
 void MyD3D12App::CreateVertexBuffer()
 {
-	// Define our geometry
-	Vertex triangleVertices[] =
-	{
-		{ { 0.0f, 0.25f * mAspectRatio, 0.0f }, { 1.0f, 0.0f, 0.0f, 1.0f } },
-		{ { 0.25f, -0.25f * mAspectRatio, 0.0f }, { 0.0f, 1.0f, 0.0f, 1.0f } },
-		{ { -0.25f, -0.25f * mAspectRatio, 0.0f }, { 0.0f, 0.0f, 1.0f, 1.0f } }
-	};
-
-	const UINT vertexBufferSize = sizeof(triangleVertices);
+	const UINT vertexBufferSize = 3 * sizeof(Vertex);
 
 	// Note: using upload heaps to transfer static data like vert buffers is not 
 	// recommended. Every time the GPU needs it, the upload heap will be marshalled 
 	// over. Please read up on Default Heap usage. An upload heap is used here for 
 	// code simplicity and because there are very few verts to actually transfer.
-	ThrowIfFailed(mDevice->CreateCommittedResource(
-		&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
-		D3D12_HEAP_FLAG_NONE,
-		&CD3DX12_RESOURCE_DESC::Buffer(vertexBufferSize),
-		D3D12_RESOURCE_STATE_GENERIC_READ,
-		nullptr,
-		IID_PPV_ARGS(&mVertexBuffer)));
-
-	// Copy the triangle data to the vertex buffer
-	UINT8* pVertexDataBegin;
-	CD3DX12_RANGE readRange(0, 0);
-	ThrowIfFailed(mVertexBuffer->Map(0, &readRange, reinterpret_cast<void**>(&pVertexDataBegin)));
-	memcpy(pVertexDataBegin, triangleVertices, sizeof(triangleVertices));
-	mVertexBuffer->Unmap(0, nullptr);
+	mVertexBuffer = mUploadAllocator->Allocate(vertexBufferSize, D3D12_RESOURCE_STATE_GENERIC_READ);
+
+	// Copy the triangle data to the vertex buffer (upload allocations stay mapped)
+	WriteVertices(mUploadAllocator->GetCpuAddress(mVertexBuffer));
 
 	// Initialise the vertex buffer view
-	mVertexBufferView.BufferLocation = mVertexBuffer->GetGPUVirtualAddress();
+	mVertexBufferView.BufferLocation = mUploadAllocator->GetGpuAddress(mVertexBuffer);
 	mVertexBufferView.StrideInBytes = sizeof(Vertex);
 	mVertexBufferView.SizeInBytes = vertexBufferSize;
 }
+
+// Write the triangle's vertices, when the vertex buffer is created and each time it is moved
+void MyD3D12App::WriteVertices(void* data) const
+{
+	// Define our geometry
+	XMFLOAT3 corners[3];
+	GetTriangleCorners(mAspectRatio, corners);
+	Vertex triangleVertices[] =
+	{
+		{ corners[0], { 1.0f, 0.0f, 0.0f, 1.0f } },
+		{ corners[1], { 0.0f, 1.0f, 0.0f, 1.0f } },
+		{ corners[2], { 0.0f, 0.0f, 1.0f, 1.0f } }
+	};
+
+	memcpy(data, triangleVertices, sizeof(triangleVertices));
+}
+
+// Create the objects in the scene. Their world matrices don't change, so are worked out once here.
+void MyD3D12App::CreateScene()
+{
+	// Encloses the triangle made in CreateVertexBuffer, whose corners are furthest from its origin
+	const float triangleRadius = 0.25f * sqrtf(1.0f + mAspectRatio * mAspectRatio);
+
+	if (mBenchmark == nullptr)
+	{
+		mObjectWorlds.assign(1, MathHelper::Identity4x4());
+		mObjectBounds.assign(1, XMFLOAT4(0.0f, 0.0f, 0.0f, triangleRadius));
+	}
+	else
+	{
+		std::vector<BenchmarkObject> objects;
+		GenerateBenchmarkScene(*mBenchmark, objects);
+
+		mObjectWorlds.resize(objects.size());
+		mObjectBounds.resize(objects.size());
+		for (size_t i = 0; i < objects.size(); i++)
+		{
+			const BenchmarkObject& object = objects[i];
+			const XMMATRIX world = XMMatrixScaling(object.scale, object.scale, object.scale) *
+				XMMatrixRotationY(object.rotationY) *
+				XMMatrixTranslation(object.position[0], object.position[1], object.position[2]);
+			XMStoreFloat4x4(&mObjectWorlds[i], world);
+			mObjectBounds[i] = XMFLOAT4(object.position[0], object.position[1], object.position[2], triangleRadius * object.scale);
+		}
+	}
+
+	// Nothing moves, so the constants are only set here, and uploaded by the first frame.
+	// HLSL matrices are column major.
+	const uint32_t objectCount = static_cast<uint32_t>(mObjectWorlds.size());
+	mObjectConstants.Resize(objectCount);
+	for (uint32_t i = 0; i < objectCount; i++)
+	{
+		ObjectConstants constants;
+		XMStoreFloat4x4(&constants.world, XMMatrixTranspose(XMLoadFloat4x4(&mObjectWorlds[i])));
+		mObjectConstants.Set(i, &constants);
+	}
+
+	// Every object is an instance of the one triangle, so their numbers match the objects'
+	XMFLOAT3 corners[3];
+	GetTriangleCorners(mAspectRatio, corners);
+	const uint32_t cornerIndices[3] = { 0, 1, 2 };
+	mTriangleBvh.Build(&corners[0].x, cornerIndices, 1);
+
+	mSceneBvh.Clear();
+	for (uint32_t i = 0; i < objectCount; i++)
+	{
+		mSceneBvh.AddInstance(&mTriangleBvh, &mObjectWorlds[i]._11);
+	}
+	mSceneBvh.Build();
+
+	mObjectVisible.assign(objectCount, 1);
+
+	mLightClusters.SetProjection(XM_PIDIV4, mAspectRatio, CameraNearZ, CameraFarZ);
+	mLights.clear();
+	if (mBenchmark != nullptr)
+	{
+		std::vector<BenchmarkLight> lights;
+		GenerateBenchmarkLights(*mBenchmark, lights);
+
+		mLights.resize(lights.size());
+		for (size_t i = 0; i < lights.size(); i++)
+		{
+			const BenchmarkLight& light = lights[i];
+			ClusteredLight& clusteredLight = mLights[i];
+			memcpy(clusteredLight.position, light.position, sizeof(light.position));
+			clusteredLight.range = light.range;
+			memcpy(clusteredLight.direction, light.direction, sizeof(light.direction));
+			clusteredLight.cosOuterAngle = light.cosOuterAngle;
+			memcpy(clusteredLight.colour, light.colour, sizeof(light.colour));
+			clusteredLight.type = light.spot ? LightType_Spot : LightType_Point;
+		}
+	}
+}
+
+// Pick the nearest object under a point on screen, as it was drawn last frame
+void MyD3D12App::PickObject(float x, float y)
+{
+	PROFILE_ZONE("Pick");
+
+	XMVECTOR determinant;
+	const XMMATRIX inverseViewProj = XMMatrixInverse(&determinant, XMLoadFloat4x4(&mViewProj));
+	XMVECTOR origin;
+	XMVECTOR direction;
+	MathHelper::ScreenToWorldRay(x, y, static_cast<float>(GetWidth()), static_cast<float>(GetHeight()), inverseViewProj, &origin, &direction);
+
+	// The direction spans the depth range, so hits are at 0-1 from the near to the far plane
+	BvhRay ray;
+	XMStoreFloat3(reinterpret_cast<XMFLOAT3*>(ray.origin), origin);
+	XMStoreFloat3(reinterpret_cast<XMFLOAT3*>(ray.direction), direction);
+	ray.maxDistance = 1.0f;
+
+	BvhHit hit;
+	if (mSceneBvh.Intersect(ray, hit))
+	{
+		mPickedObject = static_cast<int>(hit.instance);
+		mPickedDistance = hit.distance * XMVectorGetX(XMVector3Length(direction));
+	}
+	else
+	{
+		mPickedObject = -1;
+	}
+}
+
+// Rasterize the objects nearest the camera, relative to their size, as occluders, then hide any
+// object whose bounds are behind them
+void MyD3D12App::CullObjects()
+{
+	PROFILE_ZONE("OcclusionCull");
+
+	mOcclusionCuller.BeginFrame(&mViewProj._11);
+
+	XMFLOAT3 corners[3];
+	GetTriangleCorners(mAspectRatio, corners);
+	const uint32_t cornerIndices[3] = { 0, 1, 2 };
+	const XMMATRIX viewProj = XMLoadFloat4x4(&mViewProj);
+	const uint32_t objectCount = static_cast<uint32_t>(mObjectWorlds.size());
+	for (uint32_t i = 0; i < objectCount; i++)
+	{
+		// Clip space w is the distance in front of the camera
+		const XMFLOAT4& bounds = mObjectBounds[i];
+		const float distance = XMVectorGetW(XMVector3Transform(XMLoadFloat4(&bounds), viewProj));
+		if (distance > CameraNearZ && bounds.w > MinOccluderSize * distance)
+		{
+			mOcclusionCuller.AddOccluder(&corners[0].x, cornerIndices, 1, &mObjectWorlds[i]._11);
+		}
+	}
+
+	mOcclusionCuller.Rasterize(mJobSystem.get());
+	mOcclusionCuller.TestBoxes(mSceneBvh.GetWorldBounds(), objectCount, mObjectVisible.data(), mJobSystem.get());
+}
+
+// Give each cluster of the view the lights that reach it, for the scene pass to upload
+void MyD3D12App::AssignLights(const XMMATRIX& view)
+{
+	PROFILE_ZONE("LightAssign");
+
+	XMFLOAT4X4 viewMatrix;
+	XMStoreFloat4x4(&viewMatrix, view);
+	mLightClusters.Assign(mLights.data(), static_cast<uint32_t>(mLights.size()), &viewMatrix._11, mJobSystem.get());
+}
@@ -4,7 +4,28 @@
 #pragma once
 
 #include "DXSample.h"
+#include "Bvh.h"
+#include "CommandListPacketSink.h"
+#include "CommandListPool.h"
+#include "ConstantStore.h"
+#include "DebugDrawRenderer.h"
+#include "DebugHudPanels.h"
+#include "DebugHudRenderer.h"
+#include "DrawKey.h"
+#include "DrawPacket.h"
+#include "FrameCapture.h"
+#include "GpuConstantStore.h"
+#include "GpuLightClusters.h"
+#include "GpuMemoryAllocator.h"
+#include "LightClusters.h"
+#include "OcclusionCuller.h"
+#include "PsoCache.h"
+#include "ResourceRegistry.h"
 #include "MathHelper.h"
+#include "RenderGraph.h"
+#include "ResourceStateTracker.h"
+
+#include <future>
 
 using namespace DirectX;
 using Microsoft::WRL::ComPtr;
@@ -40,42 +61,165 @@ private:
 
 	struct ObjectConstants
 	{
-		XMFLOAT4X4 worldViewProj = MathHelper::Identity4x4();
+		XMFLOAT4X4 world = MathHelper::Identity4x4();
+	};
+
+	struct SceneConstants
+	{
+		XMFLOAT4X4 viewProj = MathHelper::Identity4x4();
+		XMFLOAT2 clusterScale = XMFLOAT2(0.0f, 0.0f);		// Pixels to clusters
+		float sliceScale = 0.0f;
+		float sliceBias = 0.0f;
+		XMUINT3 clusterCount = XMUINT3(1, 1, 1);
+		float ambient = 1.0f;
 	};
 
 	// Pipeline objects
 	CD3DX12_VIEWPORT mViewport;
 	CD3DX12_RECT mScissorRect;
 	ComPtr<IDXGISwapChain3> mSwapChain;
+	HANDLE mFrameLatencyWaitable;
+	bool mTearingSupported;
 	ComPtr<ID3D12Device> mDevice;
-	ComPtr<ID3D12Resource> mRenderTargets[FrameCount];
-	ComPtr<ID3D12CommandAllocator> mCommandAllocator;
+	ResourceRegistry::Handle mRenderTargets[FrameCount];
 	ComPtr<ID3D12CommandQueue> mCommandQueue;
 	ComPtr<ID3D12RootSignature> mRootSignature;
 	ComPtr<ID3D12DescriptorHeap> mRtvHeap; // RTV = Render Target View
-	ComPtr<ID3D12PipelineState> mPipelineState;
-	ComPtr<ID3D12GraphicsCommandList> mCommandList;
 	UINT mRtvDescriptorSize;
 
+	// Command lists come from a pool, and go back to it once submitted. The frame's list is
+	// kept here while it's recorded.
+	std::unique_ptr<CommandListPool> mCommandListPool;
+	CommandListPool::CommandList mCommandList;
+
+	// GPU resources are owned by the registry and referred to by handle. Released ones are
+	// destroyed once the GPU has finished with them.
+	ResourceRegistry mResourceRegistry;
+
+	// Pipeline states are compiled in the background, draws are skipped until they're ready
+	std::unique_ptr<PsoCache> mPsoCache;
+	PsoCache::Handle mScenePso;
+
+	// Scene draws are baked into packets once their pipeline state is ready, and replayed each
+	// frame. Packets only pick the object's constants, so don't change when the object does.
+	DrawPacketList mScenePackets;
+	std::vector<DrawPacketList::Handle> mObjectPackets;
+	DrawPacketList::ReplayStats mSceneReplayStats;
+	ID3D12PipelineState* mScenePacketPipeline;				// What the packets were built with
+	D3D12_VERTEX_BUFFER_VIEW mScenePacketVertexBuffer;
+
+	// Resource state tracking. The fixup list runs ahead of the main list when resources
+	// need moving into the state the main list first uses them in.
+	GlobalResourceStates mResourceStates;
+	ResourceStateTracker mStateTracker;
+	std::vector<D3D12_RESOURCE_BARRIER> mFixupBarriers;
+
+	// The passes making up the frame, rebuilt every frame but only recompiled when they change
+	RenderGraph mRenderGraph;
+
+	// Buffers are sub-allocated from large upload and readback heaps, and placed in default heaps.
+	// The default heap allocator isn't defragmented, as its buffers' states are tracked by resource.
+	std::unique_ptr<GpuMemoryAllocator> mUploadAllocator;
+	std::unique_ptr<GpuMemoryAllocator> mReadbackAllocator;
+	std::unique_ptr<GpuMemoryAllocator> mDefaultAllocator;
+
+	// Back buffer captures (F12, or -capture <frame>), read back and written in the background
+	std::unique_ptr<FrameCapture> mFrameCapture;
+
+	// Frame time and profiler overlay (F1), built each update and drawn over the frame in one call
+	std::unique_ptr<DebugHudRenderer> mDebugHudRenderer;
+	DebugHud mDebugHud;
+	FrameTimeHistory mFrameTimeHistory;
+	bool mShowDebugHud;
+
+	// World space lines (F2 shows object bounds), added from any thread during the update and
+	// drawn in one call
+	DebugDraw mDebugDraw;
+	std::unique_ptr<DebugDrawRenderer> mDebugDrawRenderer;
+	bool mShowBounds;
+
+	// Objects' constants, copied to the GPU only for objects whose constants have changed
+	ConstantStore mObjectConstants;
+	std::unique_ptr<GpuConstantStore> mGpuObjectConstants;
+
+	// Timestamps at the start and end of the frame's command list, for the GPU frame time. Each
+	// back buffer's frames resolve theirs to their own part of the readback buffer.
+	ComPtr<ID3D12QueryHeap> mTimestampHeap;
+	GpuMemoryAllocator::Handle mTimestampReadback;
+	UINT64 mTimestampFrequency;
+
 	// App resources
-	ComPtr<ID3D12Resource> mVertexBuffer;
+	GpuMemoryAllocator::Handle mVertexBuffer;
 	D3D12_VERTEX_BUFFER_VIEW mVertexBufferView;
 
-	// Synchronisation objects
+	// The scene: a single triangle, or the benchmark's generated scene
+	std::vector<XMFLOAT4X4> mObjectWorlds;
+	std::vector<XMFLOAT4> mObjectBounds;	// World space bounding spheres: centre, then radius
+	XMFLOAT4X4 mViewProj;
+
+	// Clicking picks the nearest object under the mouse by raycasting against the scene
+	TriangleBvh mTriangleBvh;
+	SceneBvh mSceneBvh;
+	int mPickedObject;						// -1 for none
+	float mPickedDistance;
+
+	// Objects hidden behind the largest ones on screen aren't drawn. Flags are 1 for objects
+	// that might be seen, and index the objects' draw packets.
+	OcclusionCuller mOcclusionCuller;
+	std::vector<uint8_t> mObjectVisible;
+
+	// The benchmark's lights, assigned to clusters of the view each update for clustered
+	// forward lighting, then uploaded with the clusters' light lists for the scene pass
+	std::vector<ClusteredLight> mLights;
+	LightClusters mLightClusters;
+	std::unique_ptr<GpuLightClusters> mGpuLightClusters;
+
+	// Shader source, read in the background while the pipeline is created, and the compiled shaders
+	std::future<IOResult> mShaderSource;
+	ComPtr<ID3DBlob> mVertexShader;
+	ComPtr<ID3DBlob> mPixelShader;
+	ComPtr<ID3DBlob> mHudVertexShader;
+	ComPtr<ID3DBlob> mHudPixelShader;
+	ComPtr<ID3DBlob> mDebugLineVertexShader;
+	ComPtr<ID3DBlob> mDebugLinePixelShader;
+
+	// Synchronisation objects. mFenceValue is the value signalled after the frame being recorded,
+	// and mFrameFenceValues the value signalled after the last frame to use each back buffer.
 	UINT mFrameIndex;
 	HANDLE mFenceEvent;
 	ComPtr<ID3D12Fence> mFence;
 	UINT64 mFenceValue;
+	UINT64 mFrameFenceValues[FrameCount];
+
+	// Startup tasks, run as a graph from OnInit
+	void CreateDevice(ComPtr<IDXGIFactory4>& factory);
+	void CreateGpuAllocators();
+	void CreateSwapChain(const ComPtr<IDXGIFactory4>& factory);
+	void CreateFence();
 
-	void LoadPipeline();
-	void LoadAssets();
 	void PopulateCommandList();
-	void WaitForPreviousFrame();
+	void UpdateScenePackets(ID3D12PipelineState* pipelineState);
+	void RecordScenePass(ID3D12GraphicsCommandList* commandList);
+	void BuildDebugHud();
+	void RecordDebugHudPass(ID3D12GraphicsCommandList* commandList);
+	void AddDebugBounds();
+	void PickObject(float x, float y);
+	void CullObjects();
+	void AssignLights(const XMMATRIX& view);
+	void RecordDebugDrawPass(ID3D12GraphicsCommandList* commandList);
+	void MoveToNextFrame();
+	void WaitForGpu();
+	void WaitForFence(UINT64 fenceValue);
+	void ReleaseCompleted();
+	int64_t ReadGpuFrameTime(UINT frameIndex) const;
 
 	void CreateDescriptorHeaps();
 	void CreateFrameResouces();
 	void CreateRootSignature();
+	void CompileShaders();
 	void CreatePSO();
 	void CreateVertexBuffer();
+	void WriteVertices(void* data) const;
+	void CreateScene();
 };
 
@@ -0,0 +1,42 @@
+// Wide paths for the narrow file APIs outside Windows
+// The engine passes paths around as std::wstring for the Win32 APIs. Elsewhere the file APIs
+// take UTF-8, and wchar_t holds whole code points (UTF-32), so the conversion is direct.
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+inline std::string ToNativePath(const std::wstring& path)
+{
+	std::string result;
+	result.reserve(path.size());
+
+	for (wchar_t c : path)
+	{
+		const uint32_t code = static_cast<uint32_t>(c);
+		if (code < 0x80)
+		{
+			result += static_cast<char>(code);
+		}
+		else if (code < 0x800)
+		{
+			result += static_cast<char>(0xC0 | (code >> 6));
+			result += static_cast<char>(0x80 | (code & 0x3F));
+		}
+		else if (code < 0x10000)
+		{
+			result += static_cast<char>(0xE0 | (code >> 12));
+			result += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+			result += static_cast<char>(0x80 | (code & 0x3F));
+		}
+		else
+		{
+			result += static_cast<char>(0xF0 | ((code >> 18) & 0x07));
+			result += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+			result += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+			result += static_cast<char>(0x80 | (code & 0x3F));
+		}
+	}
+	return result;
+}
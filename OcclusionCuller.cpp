@@ -0,0 +1,411 @@
+#include "OcclusionCuller.h"
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+#if OCCLUSION_SIMD
+#include <emmintrin.h>
+#endif
+
+const uint32_t OcclusionCuller::BinWidth;
+const uint32_t OcclusionCuller::BinHeight;
+
+namespace
+{
+	// Boxes are tested in batches of this many per task
+	const uint32_t BoxesPerTask = 256;
+
+	// The hierarchy level tested is the first where a box covers at most this many texels across
+	const uint32_t MaxTestTexels = 4;
+
+	// result = a * b, for 4x4 row-major matrices
+	void Multiply(const float a[16], const float b[16], float result[16])
+	{
+		for (unsigned int row = 0; row < 4; row++)
+		{
+			for (unsigned int column = 0; column < 4; column++)
+			{
+				result[row * 4 + column] = a[row * 4] * b[column] + a[row * 4 + 1] * b[4 + column] +
+					a[row * 4 + 2] * b[8 + column] + a[row * 4 + 3] * b[12 + column];
+			}
+		}
+	}
+
+	// [x y z 1] * m
+	void TransformPoint(const float m[16], const float* point, float clip[4])
+	{
+		for (unsigned int column = 0; column < 4; column++)
+		{
+			clip[column] = point[0] * m[column] + point[1] * m[4 + column] + point[2] * m[8 + column] + m[12 + column];
+		}
+	}
+
+	void AddStats(OcclusionCuller::Stats& total, const OcclusionCuller::Stats& stats)
+	{
+		total.testedCount += stats.testedCount;
+		total.outsideCount += stats.outsideCount;
+		total.occludedCount += stats.occludedCount;
+	}
+}
+
+// The depth buffer is rounded up to whole bins
+OcclusionCuller::OcclusionCuller(uint32_t width, uint32_t height) :
+	mBinsX((std::max)((width + BinWidth - 1) / BinWidth, 1u)),
+	mBinsY((std::max)((height + BinHeight - 1) / BinHeight, 1u)),
+	mStats()
+{
+	mWidth = mBinsX * BinWidth;
+	mHeight = mBinsY * BinHeight;
+	mBinTriangles.resize(mBinsX * mBinsY);
+
+	// Each level is half the size of the one below, rounded up, down to a single texel
+	Level level = { mWidth, mHeight };
+	mLevelSizes.push_back(level);
+	while (level.width > 1 || level.height > 1)
+	{
+		level.width = (level.width + 1) / 2;
+		level.height = (level.height + 1) / 2;
+		mLevelSizes.push_back(level);
+	}
+
+	mLevels.resize(mLevelSizes.size());
+	for (size_t i = 0; i < mLevels.size(); i++)
+	{
+		mLevels[i].assign(static_cast<size_t>(mLevelSizes[i].width) * mLevelSizes[i].height, 1.0f);
+	}
+
+	memset(mViewProj, 0, sizeof(mViewProj));
+}
+
+// Clears the occluders and depth buffer for a new view
+void OcclusionCuller::BeginFrame(const float viewProj[16])
+{
+	memcpy(mViewProj, viewProj, sizeof(mViewProj));
+	mTriangles.clear();
+	for (std::vector<uint32_t>& triangles : mBinTriangles)
+	{
+		triangles.clear();
+	}
+	mStats = Stats();
+}
+
+// Positions are 3 floats per vertex and indices 3 per triangle, placed in the world by world
+void OcclusionCuller::AddOccluder(const float* positions, const uint32_t* indices, uint32_t triangleCount, const float world[16])
+{
+	float worldViewProj[16];
+	Multiply(world, mViewProj, worldViewProj);
+	mStats.occluderTriangleCount += triangleCount;
+
+	for (uint32_t t = 0; t < triangleCount; t++)
+	{
+		// To pixels, with y down. Anything in front of the near plane leaves the triangle out.
+		float x[3];
+		float y[3];
+		float z[3];
+		bool inFront = false;
+		for (unsigned int corner = 0; corner < 3; corner++)
+		{
+			float clip[4];
+			TransformPoint(worldViewProj, &positions[indices[t * 3 + corner] * 3], clip);
+			if (clip[2] < 0.0f || clip[3] <= 0.0f)
+			{
+				inFront = true;
+				break;
+			}
+
+			const float inverseW = 1.0f / clip[3];
+			x[corner] = (clip[0] * inverseW * 0.5f + 0.5f) * mWidth;
+			y[corner] = (0.5f - clip[1] * inverseW * 0.5f) * mHeight;
+			z[corner] = clip[2] * inverseW;
+		}
+		if (inFront)
+		{
+			continue;
+		}
+
+		// Both sides are drawn, with the corners put in the order the edge tests expect
+		float area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+		if (area == 0.0f)
+		{
+			continue;
+		}
+		if (area < 0.0f)
+		{
+			std::swap(x[1], x[2]);
+			std::swap(y[1], y[2]);
+			std::swap(z[1], z[2]);
+			area = -area;
+		}
+
+		// Pixels are covered if their centres are inside
+		Triangle triangle;
+		triangle.minX = (std::max)(static_cast<int32_t>(std::ceil((std::min)((std::min)(x[0], x[1]), x[2]) - 0.5f)), 0);
+		triangle.minY = (std::max)(static_cast<int32_t>(std::ceil((std::min)((std::min)(y[0], y[1]), y[2]) - 0.5f)), 0);
+		triangle.maxX = (std::min)(static_cast<int32_t>(std::floor((std::max)((std::max)(x[0], x[1]), x[2]) - 0.5f)), static_cast<int32_t>(mWidth) - 1);
+		triangle.maxY = (std::min)(static_cast<int32_t>(std::floor((std::max)((std::max)(y[0], y[1]), y[2]) - 0.5f)), static_cast<int32_t>(mHeight) - 1);
+		if (triangle.minX > triangle.maxX || triangle.minY > triangle.maxY)
+		{
+			continue;
+		}
+
+		// Depth after projection is linear over the screen
+		for (unsigned int corner = 0; corner < 3; corner++)
+		{
+			triangle.x[corner] = x[corner];
+			triangle.y[corner] = y[corner];
+		}
+		triangle.depthDx = ((z[1] - z[0]) * (y[2] - y[0]) - (z[2] - z[0]) * (y[1] - y[0])) / area;
+		triangle.depthDy = ((x[1] - x[0]) * (z[2] - z[0]) - (x[2] - x[0]) * (z[1] - z[0])) / area;
+		triangle.depth = z[0] - triangle.depthDx * x[0] - triangle.depthDy * y[0];
+
+		const uint32_t index = static_cast<uint32_t>(mTriangles.size());
+		mTriangles.push_back(triangle);
+		for (uint32_t binY = triangle.minY / BinHeight; binY <= triangle.maxY / BinHeight; binY++)
+		{
+			for (uint32_t binX = triangle.minX / BinWidth; binX <= triangle.maxX / BinWidth; binX++)
+			{
+				mBinTriangles[binY * mBinsX + binX].push_back(index);
+			}
+		}
+	}
+}
+
+// Rasterizes the occluders a bin at a time over the job system's workers, then builds the
+// depth hierarchy. Boxes can be tested once it's done.
+void OcclusionCuller::Rasterize(JobSystem* jobSystem)
+{
+	mStats.rasterizedTriangleCount = static_cast<uint32_t>(mTriangles.size());
+	RunTasks(jobSystem, mBinsX * mBinsY, [this](unsigned int bin)
+	{
+		RasterizeBin(bin);
+	});
+	BuildHierarchy();
+}
+
+// Clears the bin, then keeps the nearest depth of its triangles at each pixel
+void OcclusionCuller::RasterizeBin(uint32_t bin)
+{
+	const int32_t binMinX = static_cast<int32_t>((bin % mBinsX) * BinWidth);
+	const int32_t binMinY = static_cast<int32_t>((bin / mBinsX) * BinHeight);
+	const int32_t binMaxX = binMinX + static_cast<int32_t>(BinWidth) - 1;
+	const int32_t binMaxY = binMinY + static_cast<int32_t>(BinHeight) - 1;
+
+	float* depth = mLevels[0].data();
+	for (int32_t y = binMinY; y <= binMaxY; y++)
+	{
+		std::fill(depth + y * mWidth + binMinX, depth + y * mWidth + binMaxX + 1, 1.0f);
+	}
+
+	for (uint32_t index : mBinTriangles[bin])
+	{
+		const Triangle& triangle = mTriangles[index];
+
+		// Edge functions, positive inside: e = a * x + b * y + c for each edge in turn
+		float a[3];
+		float b[3];
+		float c[3];
+		for (unsigned int edge = 0; edge < 3; edge++)
+		{
+			const unsigned int next = (edge + 1) % 3;
+			a[edge] = triangle.y[edge] - triangle.y[next];
+			b[edge] = triangle.x[next] - triangle.x[edge];
+			c[edge] = triangle.x[edge] * triangle.y[next] - triangle.x[next] * triangle.y[edge];
+		}
+
+		// Rows are filled in blocks of four pixels. Bins are a whole number of blocks wide.
+		const int32_t minX = (std::max)(triangle.minX, binMinX) & ~3;
+		const int32_t maxX = (std::min)(triangle.maxX, binMaxX);
+		const int32_t minY = (std::max)(triangle.minY, binMinY);
+		const int32_t maxY = (std::min)(triangle.maxY, binMaxY);
+
+#if OCCLUSION_SIMD
+		const __m128 a0 = _mm_set1_ps(a[0]);
+		const __m128 a1 = _mm_set1_ps(a[1]);
+		const __m128 a2 = _mm_set1_ps(a[2]);
+		const __m128 depthDx = _mm_set1_ps(triangle.depthDx);
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 pixelOffsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+		for (int32_t y = minY; y <= maxY; y++)
+		{
+			const float centreY = y + 0.5f;
+			const __m128 rowE0 = _mm_set1_ps(b[0] * centreY + c[0]);
+			const __m128 rowE1 = _mm_set1_ps(b[1] * centreY + c[1]);
+			const __m128 rowE2 = _mm_set1_ps(b[2] * centreY + c[2]);
+			const __m128 rowDepth = _mm_set1_ps(triangle.depth + triangle.depthDy * centreY);
+			float* row = depth + y * mWidth;
+			for (int32_t x = minX; x <= maxX; x += 4)
+			{
+				const __m128 centreX = _mm_add_ps(_mm_set1_ps(static_cast<float>(x)), pixelOffsets);
+				const __m128 e0 = _mm_add_ps(_mm_mul_ps(a0, centreX), rowE0);
+				const __m128 e1 = _mm_add_ps(_mm_mul_ps(a1, centreX), rowE1);
+				const __m128 e2 = _mm_add_ps(_mm_mul_ps(a2, centreX), rowE2);
+				const __m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(e0, zero), _mm_cmpge_ps(e1, zero)), _mm_cmpge_ps(e2, zero));
+				if (_mm_movemask_ps(inside) == 0)
+				{
+					continue;
+				}
+
+				const __m128 pixelDepth = _mm_add_ps(_mm_mul_ps(depthDx, centreX), rowDepth);
+				const __m128 current = _mm_loadu_ps(row + x);
+				const __m128 nearest = _mm_min_ps(current, pixelDepth);
+				_mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, nearest), _mm_andnot_ps(inside, current)));
+			}
+		}
+#else
+		for (int32_t y = minY; y <= maxY; y++)
+		{
+			const float centreY = y + 0.5f;
+			float* row = depth + y * mWidth;
+			for (int32_t x = minX; x <= maxX; x++)
+			{
+				const float centreX = x + 0.5f;
+				if (a[0] * centreX + b[0] * centreY + c[0] >= 0.0f &&
+					a[1] * centreX + b[1] * centreY + c[1] >= 0.0f &&
+					a[2] * centreX + b[2] * centreY + c[2] >= 0.0f)
+				{
+					const float pixelDepth = triangle.depth + triangle.depthDx * centreX + triangle.depthDy * centreY;
+					row[x] = (std::min)(row[x], pixelDepth);
+				}
+			}
+		}
+#endif
+	}
+}
+
+// Each texel is the furthest of the 2x2 below it. Texels on odd edges have fewer below them.
+void OcclusionCuller::BuildHierarchy()
+{
+	for (size_t level = 1; level < mLevels.size(); level++)
+	{
+		const Level& below = mLevelSizes[level - 1];
+		const Level& size = mLevelSizes[level];
+		const float* source = mLevels[level - 1].data();
+		float* destination = mLevels[level].data();
+		for (uint32_t y = 0; y < size.height; y++)
+		{
+			const uint32_t y0 = y * 2;
+			const uint32_t y1 = (std::min)(y0 + 1, below.height - 1);
+			for (uint32_t x = 0; x < size.width; x++)
+			{
+				const uint32_t x0 = x * 2;
+				const uint32_t x1 = (std::min)(x0 + 1, below.width - 1);
+				destination[y * size.width + x] = (std::max)(
+					(std::max)(source[y0 * below.width + x0], source[y0 * below.width + x1]),
+					(std::max)(source[y1 * below.width + x0], source[y1 * below.width + x1]));
+			}
+		}
+	}
+}
+
+// Whether any of a world space box might be visible
+bool OcclusionCuller::IsVisible(const BvhBounds& box) const
+{
+	return TestBox(box) == BoxResult_Visible;
+}
+
+// Sets visible[i] to 1 for each box that might be visible and 0 for the rest, splitting the
+// boxes over the job system's workers
+void OcclusionCuller::TestBoxes(const BvhBounds* boxes, uint32_t count, uint8_t* visible, JobSystem* jobSystem)
+{
+	const uint32_t taskCount = (count + BoxesPerTask - 1) / BoxesPerTask;
+	mTaskStats.assign(taskCount, Stats());
+	RunTasks(jobSystem, taskCount, [this, boxes, count, visible](unsigned int task)
+	{
+		Stats& stats = mTaskStats[task];
+		const uint32_t end = (std::min)((task + 1) * BoxesPerTask, count);
+		for (uint32_t i = task * BoxesPerTask; i < end; i++)
+		{
+			const EBoxResult result = TestBox(boxes[i]);
+			visible[i] = result == BoxResult_Visible ? 1 : 0;
+			stats.testedCount++;
+			stats.outsideCount += result == BoxResult_Outside ? 1 : 0;
+			stats.occludedCount += result == BoxResult_Occluded ? 1 : 0;
+		}
+	});
+
+	for (const Stats& stats : mTaskStats)
+	{
+		AddStats(mStats, stats);
+	}
+}
+
+OcclusionCuller::EBoxResult OcclusionCuller::TestBox(const BvhBounds& box) const
+{
+	// The box's extent on screen and its nearest depth, from its corners
+	float minX = FLT_MAX;
+	float minY = FLT_MAX;
+	float maxX = -FLT_MAX;
+	float maxY = -FLT_MAX;
+	float nearest = FLT_MAX;
+	unsigned int inFrontCount = 0;
+	unsigned int beyondCount = 0;
+	for (unsigned int corner = 0; corner < 8; corner++)
+	{
+		const float point[3] =
+		{
+			(corner & 1) != 0 ? box.max[0] : box.min[0],
+			(corner & 2) != 0 ? box.max[1] : box.min[1],
+			(corner & 4) != 0 ? box.max[2] : box.min[2]
+		};
+		float clip[4];
+		TransformPoint(mViewProj, point, clip);
+		if (clip[2] < 0.0f || clip[3] <= 0.0f)
+		{
+			inFrontCount++;
+			continue;
+		}
+		beyondCount += clip[2] > clip[3] ? 1 : 0;
+
+		const float inverseW = 1.0f / clip[3];
+		const float x = (clip[0] * inverseW * 0.5f + 0.5f) * mWidth;
+		const float y = (0.5f - clip[1] * inverseW * 0.5f) * mHeight;
+		minX = (std::min)(minX, x);
+		maxX = (std::max)(maxX, x);
+		minY = (std::min)(minY, y);
+		maxY = (std::max)(maxY, y);
+		nearest = (std::min)(nearest, clip[2] * inverseW);
+	}
+
+	// Boxes wholly in front of the near plane or beyond the far plane can't be seen, and boxes
+	// crossing the near plane can't be tested
+	if (inFrontCount == 8 || beyondCount == 8)
+	{
+		return BoxResult_Outside;
+	}
+	if (inFrontCount > 0)
+	{
+		return BoxResult_Visible;
+	}
+	if (maxX < 0.0f || maxY < 0.0f || minX >= mWidth || minY >= mHeight)
+	{
+		return BoxResult_Outside;
+	}
+
+	// Every pixel the box touches, at the first level it's small enough at
+	const uint32_t x0 = static_cast<uint32_t>((std::max)(minX, 0.0f));
+	const uint32_t y0 = static_cast<uint32_t>((std::max)(minY, 0.0f));
+	const uint32_t x1 = static_cast<uint32_t>((std::min)(maxX, mWidth - 1.0f));
+	const uint32_t y1 = static_cast<uint32_t>((std::min)(maxY, mHeight - 1.0f));
+	size_t level = 0;
+	while (level + 1 < mLevels.size() && ((x1 >> level) - (x0 >> level) >= MaxTestTexels || (y1 >> level) - (y0 >> level) >= MaxTestTexels))
+	{
+		level++;
+	}
+
+	const uint32_t levelWidth = mLevelSizes[level].width;
+	const float* texels = mLevels[level].data();
+	for (uint32_t y = y0 >> level; y <= y1 >> level; y++)
+	{
+		for (uint32_t x = x0 >> level; x <= x1 >> level; x++)
+		{
+			if (texels[y * levelWidth + x] >= nearest)
+			{
+				return BoxResult_Visible;
+			}
+		}
+	}
+	return BoxResult_Occluded;
+}
@@ -0,0 +1,122 @@
+// Occlusion culling
+// Hides objects behind others on the CPU, before their draws are recorded. A few chosen occluders,
+// large and near the camera, are rasterized into a small depth buffer, and each object's bounding
+// box is tested against it: if the box's nearest point is further away than everything already
+// drawn over the pixels it covers, the object can't be seen.
+//
+// Occluder triangles are first transformed and sorted into bins, rectangles of the screen, which
+// are then rasterized at once over the job system, so no two threads write the same pixels. Pixels
+// are filled four at a time with SSE where it's available. Triangles crossing the near plane are
+// left out rather than clipped, which only loses some occlusion. Like the GPU's, coverage is
+// sampled at pixel centres, so an object only seen through a gap narrower than a pixel may be hidden.
+//
+// Boxes are tested against a hierarchy of the depth buffer, each level holding the furthest depth
+// of 2x2 texels of the one below, at the level where the box covers at most 4x4 texels. Boxes
+// crossing the near plane are always visible; boxes entirely off screen never are.
+//
+// Matrices are 4x4 row-major for row vectors (as DirectXMath uses), with D3D's 0-1 depth range.
+
+#pragma once
+
+#include "Bvh.h"
+
+#include <cstdint>
+#include <vector>
+
+#if !defined(OCCLUSION_SIMD) && (defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__))
+#define OCCLUSION_SIMD 1
+#endif
+
+class JobSystem;
+
+class OcclusionCuller
+{
+public:
+	static const uint32_t BinWidth = 64;
+	static const uint32_t BinHeight = 32;
+
+	// Totals since BeginFrame
+	struct Stats
+	{
+		uint32_t occluderTriangleCount;
+		uint32_t rasterizedTriangleCount;	// Those left after dropping any off screen, edge on or crossing the near plane
+		uint32_t testedCount;
+		uint32_t outsideCount;				// Off screen
+		uint32_t occludedCount;
+	};
+
+	// The depth buffer is rounded up to whole bins
+	OcclusionCuller(uint32_t width, uint32_t height);
+
+	// Prohibit copying
+	OcclusionCuller(const OcclusionCuller& rhs) = delete;
+	OcclusionCuller& operator=(const OcclusionCuller& rhs) = delete;
+
+	// Clears the occluders and depth buffer for a new view
+	void BeginFrame(const float viewProj[16]);
+
+	// Positions are 3 floats per vertex and indices 3 per triangle, placed in the world by world
+	void AddOccluder(const float* positions, const uint32_t* indices, uint32_t triangleCount, const float world[16]);
+
+	// Rasterizes the occluders a bin at a time over the job system's workers, then builds the
+	// depth hierarchy. Boxes can be tested once it's done.
+	void Rasterize(JobSystem* jobSystem = nullptr);
+
+	// Whether any of a world space box might be visible
+	bool IsVisible(const BvhBounds& box) const;
+
+	// Sets visible[i] to 1 for each box that might be visible and 0 for the rest, splitting the
+	// boxes over the job system's workers
+	void TestBoxes(const BvhBounds* boxes, uint32_t count, uint8_t* visible, JobSystem* jobSystem = nullptr);
+
+	// Getters
+	uint32_t GetWidth() const { return mWidth; }
+	uint32_t GetHeight() const { return mHeight; }
+	const float* GetDepth() const { return mLevels[0].data(); }		// Row by row, 1 is far
+	const Stats& GetStats() const { return mStats; }
+
+private:
+	enum EBoxResult
+	{
+		BoxResult_Visible,
+		BoxResult_Outside,
+		BoxResult_Occluded
+	};
+
+	// A triangle in pixels, with its depth as a plane over the screen
+	struct Triangle
+	{
+		float x[3];
+		float y[3];
+		float depth;		// At pixel (0, 0)
+		float depthDx;
+		float depthDy;
+		int32_t minX;		// Pixels it may cover, inclusive
+		int32_t minY;
+		int32_t maxX;
+		int32_t maxY;
+	};
+
+	struct Level
+	{
+		uint32_t width;
+		uint32_t height;
+	};
+
+	void RasterizeBin(uint32_t bin);
+	void BuildHierarchy();
+	EBoxResult TestBox(const BvhBounds& box) const;
+
+	uint32_t mWidth;
+	uint32_t mHeight;
+	uint32_t mBinsX;
+	uint32_t mBinsY;
+	float mViewProj[16];
+
+	std::vector<Triangle> mTriangles;
+	std::vector<std::vector<uint32_t>> mBinTriangles;
+	std::vector<Level> mLevelSizes;
+	std::vector<std::vector<float>> mLevels;		// The depth buffer, then each level of the hierarchy
+	std::vector<Stats> mTaskStats;
+	Stats mStats;
+};
@@ -0,0 +1,94 @@
+#include "Profiler.h"
+
+#include <cstring>
+#include <mutex>
+
+SystemClock ProfileScope::sClock;
+
+namespace
+{
+	ProfileZoneStats gZones[MaxProfileZones];
+	std::atomic<unsigned int> gZoneCount(0);
+	std::mutex gRegisterMutex;
+}
+
+// Returns the zone with the given name, adding it if it's new. Returns null when the table is full.
+ProfileZoneStats* RegisterProfileZone(const char* name)
+{
+	std::lock_guard<std::mutex> lock(gRegisterMutex);
+
+	// The same name can be used in more than one place
+	const unsigned int count = gZoneCount.load();
+	for (unsigned int i = 0; i < count; i++)
+	{
+		if (strcmp(gZones[i].name, name) == 0)
+		{
+			return &gZones[i];
+		}
+	}
+
+	if (count == MaxProfileZones)
+	{
+		return nullptr;
+	}
+
+	ProfileZoneStats& zone = gZones[count];
+	zone.name = name;
+	zone.frameTime = 0;
+	zone.frameCalls = 0;
+	zone.lastFrameTime = 0;
+	zone.frameTimes.Clear();
+	zone.totalCalls = 0;
+	zone.totalTime = 0;
+
+	// Published after it's set up, so EndProfileFrame never sees a half made zone
+	gZoneCount.store(count + 1);
+	return &zone;
+}
+
+// Records each zone's time for the frame and starts the next
+void EndProfileFrame()
+{
+	const unsigned int count = gZoneCount.load();
+	for (unsigned int i = 0; i < count; i++)
+	{
+		ProfileZoneStats& zone = gZones[i];
+		const int64_t frameTime = zone.frameTime.exchange(0, std::memory_order_relaxed);
+		const uint32_t frameCalls = zone.frameCalls.exchange(0, std::memory_order_relaxed);
+		zone.lastFrameTime = frameTime;
+
+		// Zones that didn't run this frame aren't counted
+		if (frameCalls > 0)
+		{
+			zone.frameTimes.Record(static_cast<uint64_t>(frameTime));
+			zone.totalCalls += frameCalls;
+			zone.totalTime += frameTime;
+		}
+	}
+}
+
+// Clears all the zones' recorded times
+void ResetProfileZones()
+{
+	const unsigned int count = gZoneCount.load();
+	for (unsigned int i = 0; i < count; i++)
+	{
+		ProfileZoneStats& zone = gZones[i];
+		zone.frameTime = 0;
+		zone.frameCalls = 0;
+		zone.lastFrameTime = 0;
+		zone.frameTimes.Clear();
+		zone.totalCalls = 0;
+		zone.totalTime = 0;
+	}
+}
+
+unsigned int GetProfileZoneCount()
+{
+	return gZoneCount.load();
+}
+
+const ProfileZoneStats* GetProfileZone(unsigned int index)
+{
+	return index < gZoneCount.load() ? &gZones[index] : nullptr;
+}
@@ -0,0 +1,80 @@
+// CPU profiler zones
+// PROFILE_ZONE("Name") times the rest of the enclosing scope. Each zone's time is summed over
+// the frame (zones can run more than once a frame, and on any thread), then EndProfileFrame
+// records each zone's frame total into a histogram.
+//
+// Zones live in a fixed table, so recording never allocates.
+
+#pragma once
+
+#include "Clock.h"
+#include "FrameStats.h"
+
+#include <atomic>
+#include <cstdint>
+
+struct ProfileZoneStats
+{
+	const char* name;
+
+	// This frame so far
+	std::atomic<int64_t> frameTime;
+	std::atomic<uint32_t> frameCalls;
+
+	// Total for the last frame ended, 0 if the zone didn't run, e.g. for live display
+	int64_t lastFrameTime;
+
+	// Frame totals, over all frames since the last reset
+	LogHistogram frameTimes;
+	uint64_t totalCalls;
+	int64_t totalTime;
+};
+
+static const unsigned int MaxProfileZones = 64;
+
+// Returns the zone with the given name, adding it if it's new. Returns null when the table is full.
+ProfileZoneStats* RegisterProfileZone(const char* name);
+
+// Records each zone's time for the frame and starts the next
+void EndProfileFrame();
+
+// Clears all the zones' recorded times
+void ResetProfileZones();
+
+// Getters
+unsigned int GetProfileZoneCount();
+const ProfileZoneStats* GetProfileZone(unsigned int index);
+
+// Times a scope, adding it to a zone
+class ProfileScope
+{
+public:
+	explicit ProfileScope(ProfileZoneStats* zone) : mZone(zone), mStart(mZone ? sClock.Now() : 0) {}
+
+	~ProfileScope()
+	{
+		if (mZone)
+		{
+			mZone->frameTime.fetch_add(sClock.Now() - mStart, std::memory_order_relaxed);
+			mZone->frameCalls.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+
+	// Prohibit copying
+	ProfileScope(const ProfileScope& rhs) = delete;
+	ProfileScope& operator=(const ProfileScope& rhs) = delete;
+
+private:
+	static SystemClock sClock;
+
+	ProfileZoneStats* mZone;
+	int64_t mStart;
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+
+// Times the rest of the enclosing scope. The zone is looked up once, the first time it's reached.
+#define PROFILE_ZONE(name) \
+	static ProfileZoneStats* PROFILE_CONCAT(sProfileZone, __LINE__) = RegisterProfileZone(name); \
+	ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(PROFILE_CONCAT(sProfileZone, __LINE__))
@@ -0,0 +1,341 @@
+#include "Includes.h"
+#include "PsoCache.h"
+#include "Hash.h"
+
+#include <cstring>
+
+const PsoCache::Handle PsoCache::InvalidHandle;
+
+namespace
+{
+	uint64_t HashShader(const D3D12_SHADER_BYTECODE& shader, uint64_t hash)
+	{
+		hash = HashValue(shader.BytecodeLength, hash);
+		return shader.pShaderBytecode ? HashBytes(shader.pShaderBytecode, shader.BytecodeLength, hash) : hash;
+	}
+
+	uint64_t HashString(const char* string, uint64_t hash)
+	{
+		// Include the terminator so adjacent strings can't run together
+		return string ? HashBytes(string, strlen(string) + 1, hash) : HashValue('\0', hash);
+	}
+
+	// The blend and depth stencil descs contain padding, so are hashed field by field
+	uint64_t HashBlend(const D3D12_BLEND_DESC& blend, uint64_t hash)
+	{
+		hash = HashValue(blend.AlphaToCoverageEnable, hash);
+		hash = HashValue(blend.IndependentBlendEnable, hash);
+		for (const D3D12_RENDER_TARGET_BLEND_DESC& target : blend.RenderTarget)
+		{
+			hash = HashValue(target.BlendEnable, hash);
+			hash = HashValue(target.LogicOpEnable, hash);
+			hash = HashValue(target.SrcBlend, hash);
+			hash = HashValue(target.DestBlend, hash);
+			hash = HashValue(target.BlendOp, hash);
+			hash = HashValue(target.SrcBlendAlpha, hash);
+			hash = HashValue(target.DestBlendAlpha, hash);
+			hash = HashValue(target.BlendOpAlpha, hash);
+			hash = HashValue(target.LogicOp, hash);
+			hash = HashValue(target.RenderTargetWriteMask, hash);
+		}
+		return hash;
+	}
+
+	uint64_t HashDepthStencil(const D3D12_DEPTH_STENCIL_DESC& depthStencil, uint64_t hash)
+	{
+		hash = HashValue(depthStencil.DepthEnable, hash);
+		hash = HashValue(depthStencil.DepthWriteMask, hash);
+		hash = HashValue(depthStencil.DepthFunc, hash);
+		hash = HashValue(depthStencil.StencilEnable, hash);
+		hash = HashValue(depthStencil.StencilReadMask, hash);
+		hash = HashValue(depthStencil.StencilWriteMask, hash);
+		hash = HashValue(depthStencil.FrontFace, hash);
+		hash = HashValue(depthStencil.BackFace, hash);
+		return hash;
+	}
+}
+
+// At most maxConcurrentCompiles run at once, leaving workers free for other jobs
+PsoCache::PsoCache(JobSystem* jobSystem, CompileFunc compile, UINT maxConcurrentCompiles) :
+	mJobSystem(jobSystem),
+	mCompile(compile),
+	mMaxConcurrentCompiles(maxConcurrentCompiles > 0 ? maxConcurrentCompiles : 1),
+	mCompiling(0),
+	mShuttingDown(false),
+	mStats()
+{
+}
+
+// Destructor - drops queued requests and waits for running compiles
+PsoCache::~PsoCache()
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+	mShuttingDown = true;
+	mQueue.clear();
+	mCompileFinished.wait(lock, [this] { return mCompiling == 0; });
+}
+
+// Returns the handle for a description, queueing a compile if it hasn't been seen before.
+// The description and everything it points to is copied, so it needn't outlive the call.
+PsoCache::Handle PsoCache::Request(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc)
+{
+	const uint64_t hash = HashDesc(desc);
+
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mStats.requests++;
+
+		// With a 64-bit hash over the whole description, a matching hash is treated as a match
+		auto it = mHandles.find(hash);
+		if (it != mHandles.end())
+		{
+			mStats.deduplicated++;
+			return it->second;
+		}
+	}
+
+	// Copy outside the lock, as it can mean copying a lot of shader bytecode
+	std::unique_ptr<Entry> entry(new Entry());
+	entry->hash = hash;
+	entry->status = PsoStatus_Pending;
+	CopyDesc(desc, entry->stored);
+
+	Handle handle;
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+
+		// Another thread may have requested the same description in the meantime
+		auto it = mHandles.find(hash);
+		if (it != mHandles.end())
+		{
+			mStats.deduplicated++;
+			return it->second;
+		}
+
+		handle = static_cast<Handle>(mEntries.size());
+		mEntries.push_back(std::move(entry));
+		mHandles[hash] = handle;
+		mQueue.push_back(handle);
+		StartQueuedCompiles();
+	}
+
+	return handle;
+}
+
+// Returns null until the pipeline state is ready
+ID3D12PipelineState* PsoCache::Get(Handle handle) const
+{
+	const Entry* entry;
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		if (handle >= mEntries.size())
+		{
+			return nullptr;
+		}
+		entry = mEntries[handle].get();
+	}
+
+	// The pipeline state is written before the status, so it's safe to read once ready
+	return entry->status.load(std::memory_order_acquire) == PsoStatus_Ready ? entry->pipelineState.Get() : nullptr;
+}
+
+EPsoStatus PsoCache::GetStatus(Handle handle) const
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	if (handle >= mEntries.size())
+	{
+		return PsoStatus_Failed;
+	}
+	return static_cast<EPsoStatus>(mEntries[handle]->status.load(std::memory_order_acquire));
+}
+
+// Blocks until the pipeline state has compiled or failed
+void PsoCache::Wait(Handle handle)
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+	if (handle >= mEntries.size())
+	{
+		return;
+	}
+
+	const Entry* entry = mEntries[handle].get();
+	mCompileFinished.wait(lock, [entry] { return entry->status.load() != PsoStatus_Pending; });
+}
+
+PsoCache::Stats PsoCache::GetStats() const
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	Stats stats = mStats;
+	stats.queued = static_cast<UINT>(mQueue.size());
+	stats.compiling = mCompiling;
+	return stats;
+}
+
+// Hash of everything that affects the compiled pipeline state
+uint64_t PsoCache::HashDesc(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc)
+{
+	// The root signature is compared by object, as it's already been created
+	uint64_t hash = HashValue(desc.pRootSignature);
+	hash = HashShader(desc.VS, hash);
+	hash = HashShader(desc.PS, hash);
+	hash = HashShader(desc.DS, hash);
+	hash = HashShader(desc.HS, hash);
+	hash = HashShader(desc.GS, hash);
+
+	hash = HashValue(desc.StreamOutput.NumEntries, hash);
+	for (UINT i = 0; i < desc.StreamOutput.NumEntries; i++)
+	{
+		const D3D12_SO_DECLARATION_ENTRY& entry = desc.StreamOutput.pSODeclaration[i];
+		hash = HashValue(entry.Stream, hash);
+		hash = HashString(entry.SemanticName, hash);
+		hash = HashValue(entry.SemanticIndex, hash);
+		hash = HashValue(entry.StartComponent, hash);
+		hash = HashValue(entry.ComponentCount, hash);
+		hash = HashValue(entry.OutputSlot, hash);
+	}
+	hash = HashValue(desc.StreamOutput.NumStrides, hash);
+	for (UINT i = 0; i < desc.StreamOutput.NumStrides; i++)
+	{
+		hash = HashValue(desc.StreamOutput.pBufferStrides[i], hash);
+	}
+	hash = HashValue(desc.StreamOutput.RasterizedStream, hash);
+
+	hash = HashBlend(desc.BlendState, hash);
+	hash = HashValue(desc.SampleMask, hash);
+	hash = HashValue(desc.RasterizerState, hash);
+	hash = HashDepthStencil(desc.DepthStencilState, hash);
+
+	hash = HashValue(desc.InputLayout.NumElements, hash);
+	for (UINT i = 0; i < desc.InputLayout.NumElements; i++)
+	{
+		const D3D12_INPUT_ELEMENT_DESC& element = desc.InputLayout.pInputElementDescs[i];
+		hash = HashString(element.SemanticName, hash);
+		hash = HashValue(element.SemanticIndex, hash);
+		hash = HashValue(element.Format, hash);
+		hash = HashValue(element.InputSlot, hash);
+		hash = HashValue(element.AlignedByteOffset, hash);
+		hash = HashValue(element.InputSlotClass, hash);
+		hash = HashValue(element.InstanceDataStepRate, hash);
+	}
+
+	hash = HashValue(desc.IBStripCutValue, hash);
+	hash = HashValue(desc.PrimitiveTopologyType, hash);
+	hash = HashValue(desc.NumRenderTargets, hash);
+	for (UINT i = 0; i < desc.NumRenderTargets; i++)
+	{
+		hash = HashValue(desc.RTVFormats[i], hash);
+	}
+	hash = HashValue(desc.DSVFormat, hash);
+	hash = HashValue(desc.SampleDesc, hash);
+	hash = HashValue(desc.NodeMask, hash);
+	hash = HashValue(desc.CachedPSO.CachedBlobSizeInBytes, hash);
+	if (desc.CachedPSO.pCachedBlob)
+	{
+		hash = HashBytes(desc.CachedPSO.pCachedBlob, desc.CachedPSO.CachedBlobSizeInBytes, hash);
+	}
+	hash = HashValue(desc.Flags, hash);
+	return hash;
+}
+
+void PsoCache::CopyDesc(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc, StoredDesc& stored)
+{
+	stored.desc = desc;
+	stored.rootSignature = desc.pRootSignature;
+
+	D3D12_SHADER_BYTECODE* shaders[] = { &stored.desc.VS, &stored.desc.PS, &stored.desc.DS, &stored.desc.HS, &stored.desc.GS };
+	for (UINT i = 0; i < _countof(shaders); i++)
+	{
+		if (shaders[i]->pShaderBytecode)
+		{
+			const uint8_t* bytecode = static_cast<const uint8_t*>(shaders[i]->pShaderBytecode);
+			stored.shaders[i].assign(bytecode, bytecode + shaders[i]->BytecodeLength);
+			shaders[i]->pShaderBytecode = stored.shaders[i].data();
+		}
+	}
+
+	// Semantic names are copied first so their addresses don't change while being pointed to
+	const UINT inputCount = desc.InputLayout.NumElements;
+	const UINT streamOutCount = desc.StreamOutput.NumEntries;
+	stored.semanticNames.reserve(inputCount + streamOutCount);
+	for (UINT i = 0; i < inputCount; i++)
+	{
+		stored.semanticNames.push_back(desc.InputLayout.pInputElementDescs[i].SemanticName);
+	}
+	for (UINT i = 0; i < streamOutCount; i++)
+	{
+		const char* name = desc.StreamOutput.pSODeclaration[i].SemanticName;
+		stored.semanticNames.push_back(name ? name : "");
+	}
+
+	stored.inputElements.assign(desc.InputLayout.pInputElementDescs, desc.InputLayout.pInputElementDescs + inputCount);
+	for (UINT i = 0; i < inputCount; i++)
+	{
+		stored.inputElements[i].SemanticName = stored.semanticNames[i].c_str();
+	}
+	stored.desc.InputLayout.pInputElementDescs = stored.inputElements.data();
+
+	stored.streamOutEntries.assign(desc.StreamOutput.pSODeclaration, desc.StreamOutput.pSODeclaration + streamOutCount);
+	for (UINT i = 0; i < streamOutCount; i++)
+	{
+		// Null names mark gaps in the output, so keep them null
+		if (desc.StreamOutput.pSODeclaration[i].SemanticName)
+		{
+			stored.streamOutEntries[i].SemanticName = stored.semanticNames[inputCount + i].c_str();
+		}
+	}
+	stored.desc.StreamOutput.pSODeclaration = stored.streamOutEntries.data();
+
+	stored.streamOutStrides.assign(desc.StreamOutput.pBufferStrides, desc.StreamOutput.pBufferStrides + desc.StreamOutput.NumStrides);
+	stored.desc.StreamOutput.pBufferStrides = stored.streamOutStrides.data();
+
+	if (desc.CachedPSO.pCachedBlob)
+	{
+		const uint8_t* blob = static_cast<const uint8_t*>(desc.CachedPSO.pCachedBlob);
+		stored.cachedPso.assign(blob, blob + desc.CachedPSO.CachedBlobSizeInBytes);
+		stored.desc.CachedPSO.pCachedBlob = stored.cachedPso.data();
+	}
+}
+
+// Submits queued compiles while there are free compile slots. Must be called with mMutex locked.
+void PsoCache::StartQueuedCompiles()
+{
+	while (!mShuttingDown && !mQueue.empty() && mCompiling < mMaxConcurrentCompiles)
+	{
+		const Handle handle = mQueue.front();
+		mQueue.pop_front();
+		mCompiling++;
+
+		mJobSystem->Submit([this, handle]() { Compile(handle); });
+	}
+}
+
+// Runs on a worker thread
+void PsoCache::Compile(Handle handle)
+{
+	Entry* entry;
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		entry = mEntries[handle].get();
+	}
+
+	entry->pipelineState = mCompile(entry->stored.desc);
+	const bool succeeded = entry->pipelineState != nullptr;
+
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		entry->status.store(succeeded ? PsoStatus_Ready : PsoStatus_Failed, std::memory_order_release);
+		if (succeeded)
+		{
+			mStats.compiled++;
+		}
+		else
+		{
+			mStats.failed++;
+		}
+		mCompiling--;
+		StartQueuedCompiles();
+
+		// Notified under the lock, as the destructor may be waiting to destroy the cache
+		mCompileFinished.notify_all();
+	}
+}
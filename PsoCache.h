@@ -0,0 +1,115 @@
+// Pipeline state cache
+// Graphics pipeline states are requested by description and compiled on the job system.
+// Each description is hashed in full (following its pointers, so shaders are hashed by their
+// bytecode), and requests for a description already seen return the existing handle.
+// Draws poll the handle and skip or fall back until the pipeline state is ready.
+//
+// Compiling goes through a callback, so the hashing and queueing can be used without a device.
+
+#pragma once
+
+#include "DXSampleHelper.h"
+#include "JobSystem.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+enum EPsoStatus
+{
+	PsoStatus_Pending,
+	PsoStatus_Ready,
+	PsoStatus_Failed
+};
+
+class PsoCache
+{
+public:
+	typedef UINT Handle;
+	static const Handle InvalidHandle = 0xFFFFFFFF;
+
+	// Returns null if the pipeline state couldn't be created. Called on worker threads.
+	typedef std::function<ComPtr<ID3D12PipelineState>(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc)> CompileFunc;
+
+	struct Stats
+	{
+		UINT requests;
+		UINT deduplicated;	// Requests that matched an earlier description
+		UINT compiled;
+		UINT failed;
+		UINT queued;		// Waiting for a compile slot
+		UINT compiling;
+	};
+
+	// At most maxConcurrentCompiles run at once, leaving workers free for other jobs
+	PsoCache(JobSystem* jobSystem, CompileFunc compile, UINT maxConcurrentCompiles = 2);
+
+	// Prohibit copying
+	PsoCache(const PsoCache& rhs) = delete;
+	PsoCache& operator=(const PsoCache& rhs) = delete;
+
+	// Destructor - drops queued requests and waits for running compiles
+	~PsoCache();
+
+	// Returns the handle for a description, queueing a compile if it hasn't been seen before.
+	// The description and everything it points to is copied, so it needn't outlive the call.
+	Handle Request(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc);
+
+	// Returns null until the pipeline state is ready
+	ID3D12PipelineState* Get(Handle handle) const;
+	EPsoStatus GetStatus(Handle handle) const;
+
+	// Blocks until the pipeline state has compiled or failed
+	void Wait(Handle handle);
+
+	Stats GetStats() const;
+
+	// Hash of everything that affects the compiled pipeline state
+	static uint64_t HashDesc(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc);
+
+private:
+	// A pipeline state description along with copies of everything it points to
+	struct StoredDesc
+	{
+		D3D12_GRAPHICS_PIPELINE_STATE_DESC desc;
+		ComPtr<ID3D12RootSignature> rootSignature;
+		std::vector<uint8_t> shaders[5];
+		std::vector<D3D12_INPUT_ELEMENT_DESC> inputElements;
+		std::vector<D3D12_SO_DECLARATION_ENTRY> streamOutEntries;
+		std::vector<UINT> streamOutStrides;
+		std::vector<std::string> semanticNames;
+		std::vector<uint8_t> cachedPso;
+	};
+
+	struct Entry
+	{
+		uint64_t hash;
+		StoredDesc stored;
+		std::atomic<int> status;
+		ComPtr<ID3D12PipelineState> pipelineState;
+	};
+
+	static void CopyDesc(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc, StoredDesc& stored);
+	void StartQueuedCompiles();
+	void Compile(Handle handle);
+
+	JobSystem* mJobSystem;
+	CompileFunc mCompile;
+	UINT mMaxConcurrentCompiles;
+
+	mutable std::mutex mMutex;
+	std::condition_variable mCompileFinished;
+	std::deque<std::unique_ptr<Entry>> mEntries;
+	std::unordered_map<uint64_t, Handle> mHandles;
+	std::deque<Handle> mQueue;
+	UINT mCompiling;
+	bool mShuttingDown;
+	Stats mStats;
+};
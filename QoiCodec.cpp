@@ -0,0 +1,276 @@
+#include "QoiCodec.h"
+
+#include <cstring>
+
+namespace
+{
+	const uint8_t QoiMagic[4] = { 'q', 'o', 'i', 'f' };
+	const size_t QoiHeaderSize = 14;
+	const uint8_t QoiEndMarker[8] = { 0, 0, 0, 0, 0, 0, 0, 1 };
+
+	const uint8_t QoiOp_Index = 0x00;	// 00xxxxxx
+	const uint8_t QoiOp_Diff = 0x40;	// 01xxxxxx
+	const uint8_t QoiOp_Luma = 0x80;	// 10xxxxxx
+	const uint8_t QoiOp_Run = 0xC0;		// 11xxxxxx
+	const uint8_t QoiOp_Rgb = 0xFE;
+	const uint8_t QoiOp_Rgba = 0xFF;
+	const uint8_t QoiOpMask = 0xC0;
+
+	const int QoiMaxRun = 62;			// Run lengths 63 and 64 would clash with the RGB and RGBA ops
+
+	// Images bigger than this are refused when decoding, to stop bad headers asking for huge buffers
+	const uint64_t QoiMaxPixels = 400000000;
+
+	struct QoiPixel
+	{
+		uint8_t r, g, b, a;
+
+		bool operator==(const QoiPixel& rhs) const
+		{
+			return r == rhs.r && g == rhs.g && b == rhs.b && a == rhs.a;
+		}
+	};
+
+	inline unsigned int QoiHash(const QoiPixel& pixel)
+	{
+		return (pixel.r * 3 + pixel.g * 5 + pixel.b * 7 + pixel.a * 11) % 64;
+	}
+
+	inline void WriteBigEndian(uint8_t* out, uint32_t value)
+	{
+		out[0] = static_cast<uint8_t>(value >> 24);
+		out[1] = static_cast<uint8_t>(value >> 16);
+		out[2] = static_cast<uint8_t>(value >> 8);
+		out[3] = static_cast<uint8_t>(value);
+	}
+
+	inline uint32_t ReadBigEndian(const uint8_t* in)
+	{
+		return (static_cast<uint32_t>(in[0]) << 24) | (static_cast<uint32_t>(in[1]) << 16) |
+			(static_cast<uint32_t>(in[2]) << 8) | in[3];
+	}
+}
+
+// Largest encoded size for an image
+size_t GetQoiMaxSize(uint32_t width, uint32_t height, unsigned int channels)
+{
+	// Every pixel can need a full colour op: a tag byte plus the channels
+	return QoiHeaderSize + static_cast<size_t>(width) * height * (channels + 1) + sizeof(QoiEndMarker);
+}
+
+// Encodes RGBA8 pixels, rowPitch bytes apart. With 3 channels alpha is ignored and stored as
+// opaque. The buffer is grown if it's too small but never shrunk, so one buffer can be reused
+// for every image. Returns the number of bytes written to the start of the buffer.
+size_t EncodeQoi(const uint8_t* pixels, uint32_t width, uint32_t height, size_t rowPitch, unsigned int channels, std::vector<uint8_t>& buffer)
+{
+	const size_t maxSize = GetQoiMaxSize(width, height, channels);
+	if (buffer.size() < maxSize)
+	{
+		buffer.resize(maxSize);
+	}
+
+	uint8_t* out = buffer.data();
+	memcpy(out, QoiMagic, sizeof(QoiMagic));
+	WriteBigEndian(out + 4, width);
+	WriteBigEndian(out + 8, height);
+	out[12] = static_cast<uint8_t>(channels);
+	out[13] = 0;	// sRGB with linear alpha
+	out += QoiHeaderSize;
+
+	QoiPixel index[64];
+	memset(index, 0, sizeof(index));
+	QoiPixel previous = { 0, 0, 0, 255 };
+	int run = 0;
+	const uint8_t alphaMask = channels == 4 ? 0x00 : 0xFF;
+
+	for (uint32_t y = 0; y < height; y++)
+	{
+		const uint8_t* row = pixels + y * rowPitch;
+		for (uint32_t x = 0; x < width; x++)
+		{
+			const uint8_t* source = row + x * 4;
+			const QoiPixel pixel = { source[0], source[1], source[2], static_cast<uint8_t>(source[3] | alphaMask) };
+
+			if (pixel == previous)
+			{
+				run++;
+				if (run == QoiMaxRun)
+				{
+					*out++ = static_cast<uint8_t>(QoiOp_Run | (run - 1));
+					run = 0;
+				}
+				continue;
+			}
+
+			if (run > 0)
+			{
+				*out++ = static_cast<uint8_t>(QoiOp_Run | (run - 1));
+				run = 0;
+			}
+
+			const unsigned int hash = QoiHash(pixel);
+			if (index[hash] == pixel)
+			{
+				*out++ = static_cast<uint8_t>(QoiOp_Index | hash);
+			}
+			else
+			{
+				index[hash] = pixel;
+
+				if (pixel.a == previous.a)
+				{
+					// Differences wrap, as the decoder adds them modulo 256
+					const int dr = static_cast<int8_t>(pixel.r - previous.r);
+					const int dg = static_cast<int8_t>(pixel.g - previous.g);
+					const int db = static_cast<int8_t>(pixel.b - previous.b);
+					const int drg = dr - dg;
+					const int dbg = db - dg;
+
+					if (dr >= -2 && dr <= 1 && dg >= -2 && dg <= 1 && db >= -2 && db <= 1)
+					{
+						*out++ = static_cast<uint8_t>(QoiOp_Diff | ((dr + 2) << 4) | ((dg + 2) << 2) | (db + 2));
+					}
+					else if (dg >= -32 && dg <= 31 && drg >= -8 && drg <= 7 && dbg >= -8 && dbg <= 7)
+					{
+						*out++ = static_cast<uint8_t>(QoiOp_Luma | (dg + 32));
+						*out++ = static_cast<uint8_t>(((drg + 8) << 4) | (dbg + 8));
+					}
+					else
+					{
+						*out++ = QoiOp_Rgb;
+						*out++ = pixel.r;
+						*out++ = pixel.g;
+						*out++ = pixel.b;
+					}
+				}
+				else
+				{
+					*out++ = QoiOp_Rgba;
+					*out++ = pixel.r;
+					*out++ = pixel.g;
+					*out++ = pixel.b;
+					*out++ = pixel.a;
+				}
+			}
+
+			previous = pixel;
+		}
+	}
+
+	if (run > 0)
+	{
+		*out++ = static_cast<uint8_t>(QoiOp_Run | (run - 1));
+	}
+
+	memcpy(out, QoiEndMarker, sizeof(QoiEndMarker));
+	out += sizeof(QoiEndMarker);
+
+	return static_cast<size_t>(out - buffer.data());
+}
+
+// Decodes to tightly packed RGBA8. Returns false if the data isn't a valid QOI image.
+bool DecodeQoi(const uint8_t* data, size_t size, uint32_t& width, uint32_t& height, std::vector<uint8_t>& rgba)
+{
+	if (size < QoiHeaderSize + sizeof(QoiEndMarker) || memcmp(data, QoiMagic, sizeof(QoiMagic)) != 0)
+	{
+		return false;
+	}
+
+	width = ReadBigEndian(data + 4);
+	height = ReadBigEndian(data + 8);
+	const unsigned int channels = data[12];
+	const uint64_t pixelCount = static_cast<uint64_t>(width) * height;
+	if (width == 0 || height == 0 || (channels != 3 && channels != 4) || data[13] > 1 || pixelCount > QoiMaxPixels)
+	{
+		return false;
+	}
+
+	rgba.resize(static_cast<size_t>(pixelCount) * 4);
+
+	QoiPixel index[64];
+	memset(index, 0, sizeof(index));
+	QoiPixel pixel = { 0, 0, 0, 255 };
+	int run = 0;
+
+	// Ops are never split by the end marker, so stopping short of it is enough bounds checking
+	// for the op's first byte. Multi-byte ops check the rest.
+	const uint8_t* in = data + QoiHeaderSize;
+	const uint8_t* end = data + size - sizeof(QoiEndMarker);
+	uint8_t* out = rgba.data();
+
+	for (uint64_t i = 0; i < pixelCount; i++)
+	{
+		if (run > 0)
+		{
+			run--;
+		}
+		else
+		{
+			if (in >= end)
+			{
+				return false;
+			}
+
+			const uint8_t op = *in++;
+			if (op == QoiOp_Rgb)
+			{
+				if (end - in < 3)
+				{
+					return false;
+				}
+				pixel.r = in[0];
+				pixel.g = in[1];
+				pixel.b = in[2];
+				in += 3;
+			}
+			else if (op == QoiOp_Rgba)
+			{
+				if (end - in < 4)
+				{
+					return false;
+				}
+				pixel.r = in[0];
+				pixel.g = in[1];
+				pixel.b = in[2];
+				pixel.a = in[3];
+				in += 4;
+			}
+			else if ((op & QoiOpMask) == QoiOp_Index)
+			{
+				pixel = index[op & 0x3F];
+			}
+			else if ((op & QoiOpMask) == QoiOp_Diff)
+			{
+				pixel.r = static_cast<uint8_t>(pixel.r + ((op >> 4) & 3) - 2);
+				pixel.g = static_cast<uint8_t>(pixel.g + ((op >> 2) & 3) - 2);
+				pixel.b = static_cast<uint8_t>(pixel.b + (op & 3) - 2);
+			}
+			else if ((op & QoiOpMask) == QoiOp_Luma)
+			{
+				if (in >= end)
+				{
+					return false;
+				}
+				const int dg = (op & 0x3F) - 32;
+				const uint8_t differences = *in++;
+				pixel.r = static_cast<uint8_t>(pixel.r + dg - 8 + (differences >> 4));
+				pixel.g = static_cast<uint8_t>(pixel.g + dg);
+				pixel.b = static_cast<uint8_t>(pixel.b + dg - 8 + (differences & 0x0F));
+			}
+			else
+			{
+				run = op & 0x3F;
+			}
+
+			index[QoiHash(pixel)] = pixel;
+		}
+
+		out[0] = pixel.r;
+		out[1] = pixel.g;
+		out[2] = pixel.b;
+		out[3] = pixel.a;
+		out += 4;
+	}
+
+	return true;
+}
@@ -0,0 +1,22 @@
+// QOI image encoding ("Quite OK Image" format, qoiformat.org)
+// Lossless, and simple enough to encode at several hundred megabytes a second on one core,
+// which makes it a good fit for frame captures that are written while the app keeps running.
+// Pixels are coded as runs, references to a 64 entry table of recently seen colours, or small
+// differences from the previous pixel, falling back to the full colour.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Largest encoded size for an image
+size_t GetQoiMaxSize(uint32_t width, uint32_t height, unsigned int channels);
+
+// Encodes RGBA8 pixels, rowPitch bytes apart. With 3 channels alpha is ignored and stored as
+// opaque. The buffer is grown if it's too small but never shrunk, so one buffer can be reused
+// for every image. Returns the number of bytes written to the start of the buffer.
+size_t EncodeQoi(const uint8_t* pixels, uint32_t width, uint32_t height, size_t rowPitch, unsigned int channels, std::vector<uint8_t>& buffer);
+
+// Decodes to tightly packed RGBA8. Returns false if the data isn't a valid QOI image.
+bool DecodeQoi(const uint8_t* data, size_t size, uint32_t& width, uint32_t& height, std::vector<uint8_t>& rgba);
@@ -0,0 +1,155 @@
+#include "RadixSort.h"
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <cstring>
+
+const unsigned int RadixSorter::DigitBits;
+const unsigned int RadixSorter::DigitCount;
+const unsigned int RadixSorter::PassCount;
+const size_t RadixSorter::MinParallelCount;
+
+RadixSorter::RadixSorter() :
+	mLastPassCount(0)
+{
+}
+
+// Sorts the keys in ascending order, moving the values with them. Keys that are equal keep
+// their order. The job system's workers help if there is one and there are enough keys.
+void RadixSorter::Sort(uint64_t* keys, uint32_t* values, size_t count, JobSystem* jobSystem)
+{
+	mLastPassCount = 0;
+	if (count < 2)
+	{
+		return;
+	}
+
+	if (mKeyScratch.size() < count)
+	{
+		mKeyScratch.resize(count);
+		mValueScratch.resize(count);
+	}
+
+	const unsigned int chunkCount = jobSystem != nullptr && count >= MinParallelCount ? jobSystem->GetThreadCount() + 1 : 1;
+	const size_t chunkSize = (count + chunkCount - 1) / chunkCount;
+
+	// On one thread, every pass's digits are counted in a single read of the keys up front, as
+	// the counts don't depend on the order. Chunks' contents change with each pass, so when the
+	// sort is split, each pass counts its own.
+	const bool countUpFront = chunkCount == 1;
+	mCounts.resize(static_cast<size_t>(countUpFront ? PassCount : chunkCount) * DigitCount);
+	if (countUpFront)
+	{
+		CountAllDigits(keys, count, mCounts.data());
+	}
+
+	// Bits that differ between keys. Passes over bytes where they all match would leave the
+	// keys where they are, so are skipped.
+	uint64_t differing = 0;
+	for (size_t i = 1; i < count; i++)
+	{
+		differing |= keys[i] ^ keys[0];
+	}
+
+	uint64_t* sourceKeys = keys;
+	uint32_t* sourceValues = values;
+	uint64_t* destinationKeys = mKeyScratch.data();
+	uint32_t* destinationValues = mValueScratch.data();
+
+	for (unsigned int pass = 0; pass < PassCount; pass++)
+	{
+		const unsigned int shift = pass * DigitBits;
+		if (((differing >> shift) & (DigitCount - 1)) == 0)
+		{
+			continue;
+		}
+
+		// Count each chunk's digits
+		uint32_t* counts = mCounts.data();
+		if (countUpFront)
+		{
+			counts += pass * DigitCount;
+		}
+		else
+		{
+			RunTasks(jobSystem, chunkCount, [sourceKeys, count, chunkSize, shift, counts](unsigned int chunk)
+			{
+				const size_t begin = chunk * chunkSize;
+				const size_t end = (std::min)(begin + chunkSize, count);
+				CountDigits(sourceKeys, (std::min)(begin, end), end, shift, counts + chunk * DigitCount);
+			});
+		}
+
+		// Turn the counts into where each chunk's first key with each digit goes: digits in
+		// order, and within a digit, chunks in order
+		uint32_t offset = 0;
+		for (unsigned int digit = 0; digit < DigitCount; digit++)
+		{
+			for (unsigned int chunk = 0; chunk < chunkCount; chunk++)
+			{
+				const uint32_t digitCount = counts[chunk * DigitCount + digit];
+				counts[chunk * DigitCount + digit] = offset;
+				offset += digitCount;
+			}
+		}
+
+		// Move the keys
+		RunTasks(chunkCount > 1 ? jobSystem : nullptr, chunkCount,
+			[sourceKeys, sourceValues, destinationKeys, destinationValues, count, chunkSize, shift, counts](unsigned int chunk)
+		{
+			const size_t begin = chunk * chunkSize;
+			const size_t end = (std::min)(begin + chunkSize, count);
+			Scatter(sourceKeys, sourceValues, (std::min)(begin, end), end, shift, counts + chunk * DigitCount, destinationKeys, destinationValues);
+		});
+
+		std::swap(sourceKeys, destinationKeys);
+		std::swap(sourceValues, destinationValues);
+		mLastPassCount++;
+	}
+
+	// An odd number of passes leaves the result in the scratch buffers
+	if (sourceKeys != keys)
+	{
+		memcpy(keys, sourceKeys, count * sizeof(uint64_t));
+		memcpy(values, sourceValues, count * sizeof(uint32_t));
+	}
+}
+
+// Counts the digits for every pass at once. counts is [pass * DigitCount + digit].
+void RadixSorter::CountAllDigits(const uint64_t* keys, size_t count, uint32_t* counts)
+{
+	memset(counts, 0, PassCount * DigitCount * sizeof(uint32_t));
+	for (size_t i = 0; i < count; i++)
+	{
+		const uint64_t key = keys[i];
+		for (unsigned int pass = 0; pass < PassCount; pass++)
+		{
+			counts[pass * DigitCount + ((key >> (pass * DigitBits)) & (DigitCount - 1))]++;
+		}
+	}
+}
+
+void RadixSorter::CountDigits(const uint64_t* keys, size_t begin, size_t end, unsigned int shift, uint32_t* counts)
+{
+	memset(counts, 0, DigitCount * sizeof(uint32_t));
+	for (size_t i = begin; i < end; i++)
+	{
+		counts[(keys[i] >> shift) & (DigitCount - 1)]++;
+	}
+}
+
+void RadixSorter::Scatter(const uint64_t* keys, const uint32_t* values, size_t begin, size_t end, unsigned int shift,
+	const uint32_t* offsets, uint64_t* outKeys, uint32_t* outValues)
+{
+	// A local copy, which the compiler knows the output can't overwrite
+	uint32_t next[DigitCount];
+	memcpy(next, offsets, sizeof(next));
+
+	for (size_t i = begin; i < end; i++)
+	{
+		const uint64_t key = keys[i];
+		const uint32_t destination = next[(key >> shift) & (DigitCount - 1)]++;
+		outKeys[destination] = key;
+		outValues[destination] = values[i];
+	}
+}
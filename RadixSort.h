@@ -0,0 +1,55 @@
+// Radix sort
+// Sorts 64-bit keys with a 32-bit value each (e.g. draw sort keys and draw indices), least
+// significant byte first. Each pass counts the keys' digits, works out where each digit's
+// keys start, then moves every key there, so the sort is stable and takes linear time.
+//
+// Passes are skipped where every key has the same digit, which for draw keys is usually the
+// case for the high bytes. With a job system and enough keys, each pass's counting and moving
+// are split over the workers: the keys are cut into one chunk per thread, each chunk's digits
+// are counted separately, and the offsets are laid out so each chunk moves its keys to its own
+// part of each digit's range, keeping the sort stable.
+//
+// The scratch buffers are kept between sorts, so once they've grown to fit, sorting doesn't allocate.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class JobSystem;
+
+class RadixSorter
+{
+public:
+	static const unsigned int DigitBits = 8;
+	static const unsigned int DigitCount = 1 << DigitBits;
+	static const unsigned int PassCount = 64 / DigitBits;
+
+	// Below this many keys, sorts are run on the calling thread alone
+	static const size_t MinParallelCount = 16 * 1024;
+
+	RadixSorter();
+
+	// Prohibit copying
+	RadixSorter(const RadixSorter& rhs) = delete;
+	RadixSorter& operator=(const RadixSorter& rhs) = delete;
+
+	// Sorts the keys in ascending order, moving the values with them. Keys that are equal keep
+	// their order. The job system's workers help if there is one and there are enough keys.
+	void Sort(uint64_t* keys, uint32_t* values, size_t count, JobSystem* jobSystem = nullptr);
+
+	// Passes that moved keys in the last sort, out of PassCount
+	unsigned int GetLastPassCount() const { return mLastPassCount; }
+
+private:
+	static void CountAllDigits(const uint64_t* keys, size_t count, uint32_t* counts);
+	static void CountDigits(const uint64_t* keys, size_t begin, size_t end, unsigned int shift, uint32_t* counts);
+	static void Scatter(const uint64_t* keys, const uint32_t* values, size_t begin, size_t end, unsigned int shift,
+		const uint32_t* offsets, uint64_t* outKeys, uint32_t* outValues);
+
+	std::vector<uint64_t> mKeyScratch;
+	std::vector<uint32_t> mValueScratch;
+	std::vector<uint32_t> mCounts;	// [chunk * DigitCount + digit], or [pass * DigitCount + digit] on one thread
+	unsigned int mLastPassCount;
+};
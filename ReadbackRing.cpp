@@ -0,0 +1,122 @@
+#include "ReadbackRing.h"
+
+#include <cassert>
+
+const unsigned int ReadbackRing::InvalidSlot;
+
+ReadbackRing::ReadbackRing(unsigned int slotCount) :
+	mAcquiredCount(0),
+	mDroppedCount(0),
+	mCompletedCount(0)
+{
+	Slot slot = { SlotState_Free, 0, 0 };
+	mSlots.assign(slotCount, slot);
+}
+
+// Claims a free slot for a copy about to be recorded, with a tag to identify it later
+// (e.g. the frame number). Returns InvalidSlot if none are free.
+unsigned int ReadbackRing::Acquire(uint64_t tag)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	for (unsigned int i = 0; i < mSlots.size(); i++)
+	{
+		if (mSlots[i].state == SlotState_Free)
+		{
+			mSlots[i].state = SlotState_Recording;
+			mSlots[i].tag = tag;
+			mAcquiredCount++;
+			return i;
+		}
+	}
+
+	mDroppedCount++;
+	return InvalidSlot;
+}
+
+// The copy into the slot has been submitted, and is done once the fence reaches fenceValue
+void ReadbackRing::Submit(unsigned int slot, uint64_t fenceValue)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	assert(mSlots[slot].state == SlotState_Recording);
+	mSlots[slot].state = SlotState_InFlight;
+	mSlots[slot].fenceValue = fenceValue;
+	mSubmitted.push_back(slot);
+}
+
+// Returns the oldest submitted slot whose fence has completed, which is then being read
+// by the CPU, or InvalidSlot if there isn't one. Call until it returns InvalidSlot.
+unsigned int ReadbackRing::PopCompleted(uint64_t completedFenceValue)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	if (mSubmitted.empty() || mSlots[mSubmitted.front()].fenceValue > completedFenceValue)
+	{
+		return InvalidSlot;
+	}
+
+	const unsigned int slot = mSubmitted.front();
+	mSubmitted.pop_front();
+	mSlots[slot].state = SlotState_Reading;
+	mCompletedCount++;
+	return slot;
+}
+
+// The CPU has finished reading the slot, so it can be reused
+void ReadbackRing::Release(unsigned int slot)
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+
+		assert(mSlots[slot].state == SlotState_Reading);
+		mSlots[slot].state = SlotState_Free;
+	}
+
+	mReadReleased.notify_all();
+}
+
+// Blocks until every slot being read has been released
+void ReadbackRing::WaitForReads()
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+	mReadReleased.wait(lock, [this]()
+	{
+		for (const Slot& slot : mSlots)
+		{
+			if (slot.state == SlotState_Reading)
+			{
+				return false;
+			}
+		}
+		return true;
+	});
+}
+
+uint64_t ReadbackRing::GetTag(unsigned int slot) const
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	return mSlots[slot].tag;
+}
+
+ReadbackRing::Stats ReadbackRing::GetStats() const
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	Stats stats = {};
+	stats.acquiredCount = mAcquiredCount;
+	stats.droppedCount = mDroppedCount;
+	stats.completedCount = mCompletedCount;
+	for (const Slot& slot : mSlots)
+	{
+		if (slot.state == SlotState_InFlight)
+		{
+			stats.inFlightCount++;
+		}
+		else if (slot.state == SlotState_Reading)
+		{
+			stats.readingCount++;
+		}
+	}
+	return stats;
+}
@@ -0,0 +1,86 @@
+// Readback ring
+// Bookkeeping for a fixed ring of readback buffers, so GPU results can be brought back to the
+// CPU without waiting on the GPU. A slot is claimed when a copy into its buffer is recorded,
+// tagged with the fence value of the submission, and handed to the CPU once that fence has
+// completed, usually a few frames later. The CPU hands it back when it has finished reading.
+// If every slot is busy the copy is dropped rather than waiting for one to free up.
+//
+// Only deals in fence values and slot indices, so it can be driven by a simulated fence.
+// Reads can finish on any thread.
+
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+class ReadbackRing
+{
+public:
+	static const unsigned int InvalidSlot = 0xFFFFFFFF;
+
+	struct Stats
+	{
+		uint64_t acquiredCount;		// Copies given a slot
+		uint64_t droppedCount;		// Copies refused as every slot was busy
+		uint64_t completedCount;	// Copies handed to the CPU
+		unsigned int inFlightCount;	// Slots waiting on the GPU
+		unsigned int readingCount;	// Slots the CPU is still reading
+	};
+
+	explicit ReadbackRing(unsigned int slotCount);
+
+	// Prohibit copying
+	ReadbackRing(const ReadbackRing& rhs) = delete;
+	ReadbackRing& operator=(const ReadbackRing& rhs) = delete;
+
+	// Claims a free slot for a copy about to be recorded, with a tag to identify it later
+	// (e.g. the frame number). Returns InvalidSlot if none are free.
+	unsigned int Acquire(uint64_t tag);
+
+	// The copy into the slot has been submitted, and is done once the fence reaches fenceValue
+	void Submit(unsigned int slot, uint64_t fenceValue);
+
+	// Returns the oldest submitted slot whose fence has completed, which is then being read
+	// by the CPU, or InvalidSlot if there isn't one. Call until it returns InvalidSlot.
+	unsigned int PopCompleted(uint64_t completedFenceValue);
+
+	// The CPU has finished reading the slot, so it can be reused
+	void Release(unsigned int slot);
+
+	// Blocks until every slot being read has been released
+	void WaitForReads();
+
+	// Getters
+	unsigned int GetSlotCount() const { return static_cast<unsigned int>(mSlots.size()); }
+	uint64_t GetTag(unsigned int slot) const;
+	Stats GetStats() const;
+
+private:
+	enum ESlotState
+	{
+		SlotState_Free,
+		SlotState_Recording,	// Acquired, not yet submitted
+		SlotState_InFlight,
+		SlotState_Reading
+	};
+
+	struct Slot
+	{
+		ESlotState state;
+		uint64_t tag;
+		uint64_t fenceValue;
+	};
+
+	std::vector<Slot> mSlots;
+	std::deque<unsigned int> mSubmitted;	// In submission order, so fences complete front first
+
+	mutable std::mutex mMutex;
+	std::condition_variable mReadReleased;
+
+	uint64_t mAcquiredCount;
+	uint64_t mDroppedCount;
+	uint64_t mCompletedCount;
+};
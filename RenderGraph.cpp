@@ -0,0 +1,575 @@
+#include "RenderGraph.h"
+#include "Align.h"
+#include "Hash.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+	// Placed resources share one heap, which is aligned for the largest (MSAA) resources
+	const UINT64 TransientHeapAlignment = D3D12_DEFAULT_MSAA_RESOURCE_PLACEMENT_ALIGNMENT;
+
+	bool LifetimesOverlap(UINT firstA, UINT lastA, UINT firstB, UINT lastB)
+	{
+		return firstA <= lastB && firstB <= lastA;
+	}
+
+	bool MemoryOverlaps(UINT64 offsetA, UINT64 sizeA, UINT64 offsetB, UINT64 sizeB)
+	{
+		return offsetA < offsetB + sizeB && offsetB < offsetA + sizeA;
+	}
+
+	bool IsRenderTargetOrDepth(D3D12_RESOURCE_FLAGS flags)
+	{
+		return (flags & (D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET | D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL)) != 0;
+	}
+}
+
+const RenderGraph::ResourceHandle RenderGraph::InvalidResource;
+
+RenderGraph::ResourceHandle RenderGraph::PassBuilder::CreateTexture(const char* name, const TextureDesc& desc)
+{
+	Resource resource = {};
+	resource.name = name;
+	resource.imported = false;
+	resource.importedResource = nullptr;
+	resource.finalState = D3D12_RESOURCE_STATE_COMMON;
+	resource.desc = desc;
+
+	mGraph->mResources.push_back(resource);
+	return static_cast<ResourceHandle>(mGraph->mResources.size() - 1);
+}
+
+void RenderGraph::PassBuilder::Read(ResourceHandle resource, D3D12_RESOURCE_STATES state)
+{
+	mGraph->mPasses[mPassIndex].accesses.push_back({ resource, state, false });
+}
+
+void RenderGraph::PassBuilder::Write(ResourceHandle resource, D3D12_RESOURCE_STATES state)
+{
+	mGraph->mPasses[mPassIndex].accesses.push_back({ resource, state, true });
+}
+
+// Passes with side effects (e.g. readbacks) are never culled
+void RenderGraph::PassBuilder::SetSideEffects()
+{
+	mGraph->mPasses[mPassIndex].sideEffects = true;
+}
+
+// Transient resources are registered with the global states for as long as they exist
+RenderGraph::RenderGraph(GlobalResourceStates* resourceStates) :
+	mResourceStates(resourceStates),
+	mArena(nullptr),
+	mCompiledHash(0),
+	mHasCompiled(false),
+	mTransientResourcesCreated(false),
+	mStats(),
+	mLastFenceValue(0)
+{
+}
+
+// The GPU must have finished with the transient resources
+RenderGraph::~RenderGraph()
+{
+	for (const auto& transient : mTransients)
+	{
+		if (transient.resource)
+		{
+			mResourceStates->Unregister(transient.resource.Get());
+		}
+	}
+	ReleaseCompleted(UINT64_MAX);
+}
+
+// Clears the passes ready to build the next frame's graph. The compiled result is kept.
+// The frame's pass lists are allocated from the arena if one is given.
+void RenderGraph::Reset(LinearArena* arena)
+{
+	mPasses.clear();
+	mResources.clear();
+	mArena = arena;
+}
+
+// Brings an externally owned resource into the graph
+RenderGraph::ResourceHandle RenderGraph::ImportResource(const char* name, ID3D12Resource* resource, D3D12_RESOURCE_STATES finalState)
+{
+	Resource imported = {};
+	imported.name = name;
+	imported.imported = true;
+	imported.importedResource = resource;
+	imported.finalState = finalState;
+
+	mResources.push_back(imported);
+	return static_cast<ResourceHandle>(mResources.size() - 1);
+}
+
+void RenderGraph::AddPass(const char* name, SetupFunc setup, ExecuteFunc execute)
+{
+	Pass pass = { name, std::move(execute), ScratchVector<Access>(ArenaAllocator<Access>(mArena)), false };
+	mPasses.push_back(std::move(pass));
+
+	PassBuilder builder(this, static_cast<UINT>(mPasses.size() - 1));
+	setup(builder);
+}
+
+// Culls, orders and lays out the graph. Returns true if it had to be recompiled.
+bool RenderGraph::Compile(const AllocationInfoFunc& getAllocationInfo)
+{
+	const UINT64 hash = HashTopology();
+	if (mHasCompiled && hash == mCompiledHash)
+	{
+		mStats.cacheHit = true;
+		return false;
+	}
+
+	// Anything created for the previous layout is released once the GPU has finished with it
+	RetireTransientResources();
+
+	CullPasses();
+	ComputeLifetimes();
+
+	for (auto& transient : mTransients)
+	{
+		transient.allocation = getAllocationInfo(transient.desc);
+	}
+
+	AssignHeapOffsets();
+
+	mCompiledHash = hash;
+	mHasCompiled = true;
+	mStats.cacheHit = false;
+	return true;
+}
+
+// Creates the transient heap and placed resources for the compiled graph, if they've changed
+void RenderGraph::CreateTransientResources(ID3D12Device* device)
+{
+	if (mTransientResourcesCreated || mTransients.empty())
+	{
+		return;
+	}
+
+	// Resource heap tier 1 hardware can't mix render targets with other textures in one heap
+	bool anyRenderTargets = false;
+	bool anyOtherTextures = false;
+	for (const auto& transient : mTransients)
+	{
+		const bool renderTarget = IsRenderTargetOrDepth(transient.desc.Flags);
+		anyRenderTargets |= renderTarget;
+		anyOtherTextures |= !renderTarget;
+	}
+
+	D3D12_HEAP_FLAGS heapFlags = D3D12_HEAP_FLAG_ALLOW_ALL_BUFFERS_AND_TEXTURES;
+	if (!anyOtherTextures)
+	{
+		heapFlags = D3D12_HEAP_FLAG_ALLOW_ONLY_RT_DS_TEXTURES;
+	}
+	else if (!anyRenderTargets)
+	{
+		heapFlags = D3D12_HEAP_FLAG_ALLOW_ONLY_NON_RT_DS_TEXTURES;
+	}
+
+	CD3DX12_HEAP_DESC heapDesc(mStats.transientHeapSize, D3D12_HEAP_TYPE_DEFAULT, TransientHeapAlignment, heapFlags);
+	ThrowIfFailed(device->CreateHeap(&heapDesc, IID_PPV_ARGS(&mTransientHeap)));
+	NAME_D3D12_OBJECT(mTransientHeap);
+
+	for (auto& transient : mTransients)
+	{
+		if (transient.desc.Flags & D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL)
+		{
+			transient.state = D3D12_RESOURCE_STATE_DEPTH_WRITE;
+		}
+		else if (transient.desc.Flags & D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET)
+		{
+			transient.state = D3D12_RESOURCE_STATE_RENDER_TARGET;
+		}
+		else
+		{
+			transient.state = D3D12_RESOURCE_STATE_COMMON;
+		}
+
+		ThrowIfFailed(device->CreatePlacedResource(
+			mTransientHeap.Get(),
+			transient.offset,
+			&transient.desc,
+			transient.state,
+			transient.hasClearValue ? &transient.clearValue : nullptr,
+			IID_PPV_ARGS(&transient.resource)));
+		mResourceStates->Register(transient.resource.Get(), transient.state);
+	}
+
+	mTransientResourcesCreated = true;
+}
+
+// Records all the surviving passes, with barriers worked out from their declared accesses, for
+// the frame that signals fenceValue once it's done
+void RenderGraph::Execute(ID3D12GraphicsCommandList* commandList, ResourceStateTracker& stateTracker, UINT64 fenceValue)
+{
+	mLastFenceValue = fenceValue;
+
+	for (UINT passIndex = 0; passIndex < mPasses.size(); passIndex++)
+	{
+		if (mPassCulled[passIndex])
+		{
+			continue;
+		}
+
+		const Pass& pass = mPasses[passIndex];
+
+		// Transients starting their lifetime here pick up in the state they were left in.
+		// Ones sharing memory with any other transient, whether earlier this frame or later
+		// last frame, need an aliasing barrier first, and their contents are undefined.
+		for (const auto& transient : mTransients)
+		{
+			if (transient.firstPass == passIndex)
+			{
+				stateTracker.AssumeState(transient.resource.Get(), transient.state);
+				if (transient.aliased)
+				{
+					stateTracker.AliasingBarrier(nullptr, transient.resource.Get());
+				}
+			}
+		}
+
+		for (const auto& access : pass.accesses)
+		{
+			stateTracker.TransitionResource(GetResource(access.resource), access.state);
+		}
+		stateTracker.FlushBarriers(commandList);
+
+		// Render targets and depth buffers must be initialised after activation, so ones the pass
+		// starts by writing are discarded in case it only draws over part of them
+		for (const auto& transient : mTransients)
+		{
+			if (transient.firstPass == passIndex && transient.aliased && IsRenderTargetOrDepth(transient.desc.Flags))
+			{
+				D3D12_RESOURCE_STATES state;
+				if (stateTracker.GetTrackedState(transient.resource.Get(), &state) &&
+					(state == D3D12_RESOURCE_STATE_RENDER_TARGET || state == D3D12_RESOURCE_STATE_DEPTH_WRITE))
+				{
+					commandList->DiscardResource(transient.resource.Get(), nullptr);
+				}
+			}
+		}
+
+		pass.execute(commandList, *this);
+
+		for (auto& transient : mTransients)
+		{
+			if (transient.lastPass == passIndex)
+			{
+				stateTracker.GetTrackedState(transient.resource.Get(), &transient.state);
+			}
+		}
+	}
+
+	// Leave imported resources how their owners expect them
+	for (const auto& resource : mResources)
+	{
+		if (resource.imported)
+		{
+			stateTracker.TransitionResource(resource.importedResource, resource.finalState);
+		}
+	}
+	stateTracker.EndSplitBarriers();
+	stateTracker.FlushBarriers(commandList);
+}
+
+// Releases transient resources left over from earlier layouts once the GPU has passed their
+// last frame's fence value
+void RenderGraph::ReleaseCompleted(UINT64 completedFenceValue)
+{
+	GlobalResourceStates* resourceStates = mResourceStates;
+	mPendingReleases.erase(std::remove_if(mPendingReleases.begin(), mPendingReleases.end(),
+		[completedFenceValue, resourceStates](const PendingRelease& release)
+		{
+			if (release.fenceValue > completedFenceValue)
+			{
+				return false;
+			}
+
+			// Unregistered first, so a resource created later at the same address doesn't pick up its state
+			if (release.resource)
+			{
+				resourceStates->Unregister(release.resource.Get());
+			}
+			return true;
+		}),
+		mPendingReleases.end());
+}
+
+ID3D12Resource* RenderGraph::GetResource(ResourceHandle handle) const
+{
+	if (handle >= mResources.size())
+	{
+		return nullptr;
+	}
+
+	if (mResources[handle].imported)
+	{
+		return mResources[handle].importedResource;
+	}
+
+	const UINT index = handle < mTransientIndex.size() ? mTransientIndex[handle] : InvalidResource;
+	return index != InvalidResource ? mTransients[index].resource.Get() : nullptr;
+}
+
+bool RenderGraph::IsPassCulled(UINT passIndex) const
+{
+	return passIndex >= mPassCulled.size() || mPassCulled[passIndex];
+}
+
+// Offset in the transient heap
+UINT64 RenderGraph::GetTransientOffset(ResourceHandle handle) const
+{
+	const UINT index = handle < mTransientIndex.size() ? mTransientIndex[handle] : InvalidResource;
+	return index != InvalidResource ? mTransients[index].offset : 0;
+}
+
+UINT64 RenderGraph::GetTransientSize(ResourceHandle handle) const
+{
+	const UINT index = handle < mTransientIndex.size() ? mTransientIndex[handle] : InvalidResource;
+	return index != InvalidResource ? mTransients[index].allocation.size : 0;
+}
+
+// First and last surviving pass using a transient. False if it isn't used.
+bool RenderGraph::GetTransientLifetime(ResourceHandle handle, UINT* firstPass, UINT* lastPass) const
+{
+	const UINT index = handle < mTransientIndex.size() ? mTransientIndex[handle] : InvalidResource;
+	if (index == InvalidResource)
+	{
+		return false;
+	}
+
+	*firstPass = mTransients[index].firstPass;
+	*lastPass = mTransients[index].lastPass;
+	return true;
+}
+
+// Whether a transient shares memory with another, so is activated with an aliasing barrier
+bool RenderGraph::IsTransientAliased(ResourceHandle handle) const
+{
+	const UINT index = handle < mTransientIndex.size() ? mTransientIndex[handle] : InvalidResource;
+	return index != InvalidResource && mTransients[index].aliased;
+}
+
+// Hashes everything that affects the compiled result. Imported resource pointers are left out
+// as they change every frame (e.g. the current back buffer) without changing the layout.
+UINT64 RenderGraph::HashTopology() const
+{
+	UINT64 hash = HashValue(mPasses.size());
+
+	for (const auto& pass : mPasses)
+	{
+		hash = HashBytes(pass.name, strlen(pass.name), hash);
+		hash = HashValue(pass.sideEffects, hash);
+
+		for (const auto& access : pass.accesses)
+		{
+			hash = HashValue(access.resource, hash);
+			hash = HashValue(access.state, hash);
+			hash = HashValue(access.write, hash);
+		}
+	}
+
+	for (const auto& resource : mResources)
+	{
+		hash = HashValue(resource.imported, hash);
+		hash = HashValue(resource.finalState, hash);
+		hash = HashValue(resource.desc.width, hash);
+		hash = HashValue(resource.desc.height, hash);
+		hash = HashValue(resource.desc.format, hash);
+		hash = HashValue(resource.desc.flags, hash);
+		hash = HashValue(resource.desc.clearValue.Color, hash);
+	}
+
+	return hash;
+}
+
+// Walks the passes backwards from the outputs. A pass survives if it has side effects or writes
+// something a later surviving pass (or an output) needs, and then everything it reads is needed.
+void RenderGraph::CullPasses()
+{
+	std::vector<bool> needed(mResources.size(), false);
+	for (size_t i = 0; i < mResources.size(); i++)
+	{
+		needed[i] = mResources[i].imported;
+	}
+
+	mPassCulled.assign(mPasses.size(), true);
+	mStats.passCount = static_cast<UINT>(mPasses.size());
+	mStats.culledPassCount = 0;
+
+	for (size_t passIndex = mPasses.size(); passIndex-- > 0;)
+	{
+		const Pass& pass = mPasses[passIndex];
+
+		bool live = pass.sideEffects;
+		for (const auto& access : pass.accesses)
+		{
+			live |= access.write && needed[access.resource];
+		}
+
+		if (!live)
+		{
+			mStats.culledPassCount++;
+			continue;
+		}
+
+		mPassCulled[passIndex] = false;
+		for (const auto& access : pass.accesses)
+		{
+			if (!access.write)
+			{
+				needed[access.resource] = true;
+			}
+		}
+	}
+}
+
+// Works out the first and last surviving pass that uses each transient resource.
+// Transients only used by culled passes are dropped entirely.
+void RenderGraph::ComputeLifetimes()
+{
+	mTransients.clear();
+	mTransientIndex.assign(mResources.size(), InvalidResource);
+
+	for (UINT passIndex = 0; passIndex < mPasses.size(); passIndex++)
+	{
+		if (mPassCulled[passIndex])
+		{
+			continue;
+		}
+
+		for (const auto& access : mPasses[passIndex].accesses)
+		{
+			const Resource& resource = mResources[access.resource];
+			if (resource.imported)
+			{
+				continue;
+			}
+
+			UINT& index = mTransientIndex[access.resource];
+			if (index == InvalidResource)
+			{
+				Transient transient = {};
+				transient.handle = access.resource;
+				transient.desc = CD3DX12_RESOURCE_DESC::Tex2D(resource.desc.format, resource.desc.width, resource.desc.height,
+					1, 1, 1, 0, resource.desc.flags);
+				transient.clearValue = resource.desc.clearValue;
+				transient.hasClearValue = IsRenderTargetOrDepth(resource.desc.flags);
+				transient.firstPass = passIndex;
+				transient.state = D3D12_RESOURCE_STATE_COMMON;
+
+				index = static_cast<UINT>(mTransients.size());
+				mTransients.push_back(transient);
+			}
+
+			mTransients[index].lastPass = passIndex;
+		}
+	}
+
+	mStats.transientCount = static_cast<UINT>(mTransients.size());
+}
+
+// Places the transients in the heap, largest first. Each goes in the lowest gap that doesn't
+// overlap a resource whose lifetime overlaps its own, so resources alive at different times
+// share memory.
+void RenderGraph::AssignHeapOffsets()
+{
+	std::vector<UINT> order(mTransients.size());
+	for (UINT i = 0; i < order.size(); i++)
+	{
+		order[i] = i;
+	}
+
+	std::sort(order.begin(), order.end(), [this](UINT a, UINT b)
+	{
+		return mTransients[a].allocation.size > mTransients[b].allocation.size;
+	});
+
+	std::vector<UINT> placed;
+	std::vector<std::pair<UINT64, UINT64>> occupied;
+	mStats.transientHeapSize = 0;
+	mStats.unaliasedSize = 0;
+
+	for (UINT index : order)
+	{
+		Transient& transient = mTransients[index];
+		const UINT64 size = transient.allocation.size;
+		const UINT64 alignment = transient.allocation.alignment > 0 ? transient.allocation.alignment : D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+
+		// Memory ranges in use while this resource is alive
+		occupied.clear();
+		for (UINT other : placed)
+		{
+			const Transient& otherTransient = mTransients[other];
+			if (LifetimesOverlap(transient.firstPass, transient.lastPass, otherTransient.firstPass, otherTransient.lastPass))
+			{
+				occupied.emplace_back(otherTransient.offset, otherTransient.offset + otherTransient.allocation.size);
+			}
+		}
+		std::sort(occupied.begin(), occupied.end());
+
+		UINT64 offset = 0;
+		for (const auto& range : occupied)
+		{
+			if (AlignUp(offset, alignment) + size <= range.first)
+			{
+				break;
+			}
+			offset = (std::max)(offset, range.second);
+		}
+
+		transient.offset = AlignUp(offset, alignment);
+		placed.push_back(index);
+
+		mStats.transientHeapSize = (std::max)(mStats.transientHeapSize, transient.offset + size);
+		mStats.unaliasedSize += AlignUp(size, alignment);
+	}
+
+	mStats.transientHeapSize = AlignUp(mStats.transientHeapSize, TransientHeapAlignment);
+
+	// Anything sharing memory with another transient needs an aliasing barrier at its first use.
+	// Not just those after an earlier one this frame: the memory is used again every frame, so
+	// the first of them follows the last one from the frame before.
+	for (UINT i = 0; i < mTransients.size(); i++)
+	{
+		Transient& transient = mTransients[i];
+		transient.aliased = false;
+		for (UINT j = 0; j < mTransients.size(); j++)
+		{
+			const Transient& other = mTransients[j];
+			if (j != i && MemoryOverlaps(transient.offset, transient.allocation.size, other.offset, other.allocation.size))
+			{
+				transient.aliased = true;
+				break;
+			}
+		}
+	}
+}
+
+// Hands the transient heap and placed resources to the pending releases, to go once the GPU
+// has finished the last frame that used them
+void RenderGraph::RetireTransientResources()
+{
+	for (auto& transient : mTransients)
+	{
+		if (transient.resource)
+		{
+			PendingRelease release = { mLastFenceValue, transient.resource, nullptr };
+			mPendingReleases.push_back(release);
+			transient.resource.Reset();
+		}
+	}
+
+	if (mTransientHeap)
+	{
+		PendingRelease heapRelease = { mLastFenceValue, nullptr, mTransientHeap };
+		mPendingReleases.push_back(heapRelease);
+		mTransientHeap.Reset();
+	}
+
+	mTransientResourcesCreated = false;
+}
@@ -0,0 +1,195 @@
+// Render graph (frame graph)
+// Each frame, passes are added along with the resources they read and write. Compiling the
+// graph culls passes whose results are never used, works out each transient resource's
+// lifetime, and places transient resources with non-overlapping lifetimes in the same heap
+// memory. Barriers are derived from the declared accesses when the graph is executed.
+//
+// Compiling doesn't need a device (sizes come from a callback), and the compiled result is
+// reused for as long as the graph's topology stays the same from frame to frame. When it
+// changes, the old transient resources are kept until the GPU has finished the last frame
+// that used them.
+//
+// Transients are reused every frame, so one sharing memory with any other is activated with an
+// aliasing barrier at its first use each frame, and its contents are undefined until then.
+
+#pragma once
+
+#include "DXSampleHelper.h"
+#include "FrameArena.h"
+#include "ResourceStateTracker.h"
+
+#include <functional>
+#include <vector>
+
+class RenderGraph
+{
+public:
+	typedef UINT ResourceHandle;
+	static const ResourceHandle InvalidResource = 0xFFFFFFFF;
+
+	struct TextureDesc
+	{
+		UINT width;
+		UINT height;
+		DXGI_FORMAT format;
+		D3D12_RESOURCE_FLAGS flags;
+		D3D12_CLEAR_VALUE clearValue;	// Used when the flags allow a render target or depth stencil
+	};
+
+	// Heap space needed for a transient resource
+	struct AllocationInfo
+	{
+		UINT64 size;
+		UINT64 alignment;
+	};
+	typedef std::function<AllocationInfo(const D3D12_RESOURCE_DESC& desc)> AllocationInfoFunc;
+
+	// Passed to a pass's setup function to declare what the pass uses
+	class PassBuilder
+	{
+	public:
+		ResourceHandle CreateTexture(const char* name, const TextureDesc& desc);
+		void Read(ResourceHandle resource, D3D12_RESOURCE_STATES state);
+		void Write(ResourceHandle resource, D3D12_RESOURCE_STATES state);
+
+		// Passes with side effects (e.g. readbacks) are never culled
+		void SetSideEffects();
+
+	private:
+		friend class RenderGraph;
+		PassBuilder(RenderGraph* graph, UINT passIndex) : mGraph(graph), mPassIndex(passIndex) {}
+
+		RenderGraph* mGraph;
+		UINT mPassIndex;
+	};
+
+	typedef std::function<void(PassBuilder& builder)> SetupFunc;
+	typedef std::function<void(ID3D12GraphicsCommandList* commandList, const RenderGraph& graph)> ExecuteFunc;
+
+	// Results of the last compile
+	struct CompileStats
+	{
+		UINT passCount;
+		UINT culledPassCount;
+		UINT transientCount;
+		UINT64 transientHeapSize;	// Peak transient memory, with aliasing
+		UINT64 unaliasedSize;		// What the transients would need without aliasing
+		bool cacheHit;
+	};
+
+	// Transient resources are registered with the global states for as long as they exist
+	explicit RenderGraph(GlobalResourceStates* resourceStates);
+	~RenderGraph();
+
+	// Prohibit copying
+	RenderGraph(const RenderGraph& rhs) = delete;
+	RenderGraph& operator=(const RenderGraph& rhs) = delete;
+
+	// Clears the passes ready to build the next frame's graph. The compiled result is kept.
+	// The frame's pass lists are allocated from the arena if one is given, which must last
+	// until the next reset.
+	void Reset(LinearArena* arena = nullptr);
+
+	// Brings an externally owned resource into the graph. It is left in finalState after execution.
+	// Imported resources are outputs, so passes writing to them are never culled.
+	ResourceHandle ImportResource(const char* name, ID3D12Resource* resource, D3D12_RESOURCE_STATES finalState);
+
+	// Pass and resource names aren't copied, so must last until the next reset (e.g. string literals)
+	void AddPass(const char* name, SetupFunc setup, ExecuteFunc execute);
+
+	// Culls, orders and lays out the graph. Returns true if it had to be recompiled,
+	// false if the previous frame's result was reused.
+	bool Compile(const AllocationInfoFunc& getAllocationInfo);
+
+	// Creates the transient heap and placed resources for the compiled graph, if they've changed
+	void CreateTransientResources(ID3D12Device* device);
+
+	// Records all the surviving passes, for the frame that signals fenceValue once it's done
+	void Execute(ID3D12GraphicsCommandList* commandList, ResourceStateTracker& stateTracker, UINT64 fenceValue);
+
+	// Releases transient resources left over from earlier layouts once the GPU has passed their
+	// last frame's fence value
+	void ReleaseCompleted(UINT64 completedFenceValue);
+
+	// Getters
+	ID3D12Resource* GetResource(ResourceHandle handle) const;
+	const CompileStats& GetCompileStats() const { return mStats; }
+	bool IsPassCulled(UINT passIndex) const;
+	UINT64 GetTransientOffset(ResourceHandle handle) const;	// Offset in the transient heap
+	UINT64 GetTransientSize(ResourceHandle handle) const;
+	bool GetTransientLifetime(ResourceHandle handle, UINT* firstPass, UINT* lastPass) const;	// False if it isn't used
+	bool IsTransientAliased(ResourceHandle handle) const;
+
+private:
+	struct Access
+	{
+		ResourceHandle resource;
+		D3D12_RESOURCE_STATES state;
+		bool write;
+	};
+
+	struct Pass
+	{
+		const char* name;
+		ExecuteFunc execute;
+		ScratchVector<Access> accesses;
+		bool sideEffects;
+	};
+
+	struct Resource
+	{
+		const char* name;
+		bool imported;
+		ID3D12Resource* importedResource;
+		D3D12_RESOURCE_STATES finalState;
+		TextureDesc desc;
+	};
+
+	// Per transient resource result of compiling, kept between frames
+	struct Transient
+	{
+		ResourceHandle handle;
+		D3D12_RESOURCE_DESC desc;
+		D3D12_CLEAR_VALUE clearValue;
+		bool hasClearValue;
+		AllocationInfo allocation;
+		UINT64 offset;
+		UINT firstPass;
+		UINT lastPass;
+		bool aliased;	// Shares memory with another transient, so needs activating each frame
+		ComPtr<ID3D12Resource> resource;
+		D3D12_RESOURCE_STATES state;	// State it was left in last frame
+	};
+
+	// Transient memory from an earlier layout, kept until the GPU has finished with it
+	struct PendingRelease
+	{
+		UINT64 fenceValue;
+		ComPtr<ID3D12Resource> resource;
+		ComPtr<ID3D12Heap> heap;
+	};
+
+	UINT64 HashTopology() const;
+	void CullPasses();
+	void ComputeLifetimes();
+	void AssignHeapOffsets();
+	void RetireTransientResources();
+
+	GlobalResourceStates* mResourceStates;
+	std::vector<Pass> mPasses;
+	std::vector<Resource> mResources;
+	LinearArena* mArena;
+
+	// Compiled result
+	UINT64 mCompiledHash;
+	bool mHasCompiled;
+	std::vector<bool> mPassCulled;
+	std::vector<Transient> mTransients;
+	std::vector<UINT> mTransientIndex;	// Resource handle -> index into mTransients
+	bool mTransientResourcesCreated;
+	ComPtr<ID3D12Heap> mTransientHeap;
+	CompileStats mStats;
+
+	UINT64 mLastFenceValue;		// Of the last frame executed
+	std::vector<PendingRelease> mPendingReleases;
+};
@@ -0,0 +1,91 @@
+#include "ResourceRegistry.h"
+
+#include <algorithm>
+
+const ResourceRegistry::Handle ResourceRegistry::InvalidHandle;
+
+ResourceRegistry::ResourceRegistry() :
+	mReleasedCount(0),
+	mStaleLookups(0)
+{
+}
+
+// Destroys everything, pending or not. The GPU must be idle.
+ResourceRegistry::~ResourceRegistry()
+{
+}
+
+// Takes ownership of the resource. The name is set on it for debugging, if given.
+ResourceRegistry::Handle ResourceRegistry::Add(ComPtr<ID3D12Resource> resource, LPCWSTR name)
+{
+	if (name != nullptr)
+	{
+		SetName(resource.Get(), name);
+	}
+
+	Entry entry;
+	entry.resource = std::move(resource);
+	entry.lastUsedFence = 0;
+	return mEntries.Insert(std::move(entry));
+}
+
+// Returns null for stale handles. The pointer isn't AddRef'd.
+ID3D12Resource* ResourceRegistry::Get(Handle handle) const
+{
+	const Entry* entry = mEntries.Get(handle);
+	if (entry == nullptr)
+	{
+		mStaleLookups++;
+		return nullptr;
+	}
+	return entry->resource.Get();
+}
+
+// Records that a command list submitted with the given fence value uses the resource
+void ResourceRegistry::MarkUsed(Handle handle, UINT64 fenceValue)
+{
+	Entry* entry = mEntries.Get(handle);
+	if (entry == nullptr)
+	{
+		mStaleLookups++;
+		return;
+	}
+	entry->lastUsedFence = (std::max)(entry->lastUsedFence, fenceValue);
+}
+
+// Invalidates the handle. The resource is destroyed once the GPU has finished with it.
+void ResourceRegistry::Release(Handle handle)
+{
+	Entry* entry = mEntries.Get(handle);
+	if (entry == nullptr)
+	{
+		mStaleLookups++;
+		return;
+	}
+
+	PendingRelease pending = { std::move(entry->resource), entry->lastUsedFence };
+	mPendingReleases.push_back(std::move(pending));
+	mEntries.Erase(handle);
+}
+
+// Destroys released resources whose last use the GPU has finished. Returns how many.
+UINT ResourceRegistry::ProcessDeferredReleases(UINT64 completedFenceValue)
+{
+	const auto firstReleased = std::remove_if(mPendingReleases.begin(), mPendingReleases.end(),
+		[completedFenceValue](const PendingRelease& pending) { return pending.fenceValue <= completedFenceValue; });
+
+	const UINT count = static_cast<UINT>(mPendingReleases.end() - firstReleased);
+	mPendingReleases.erase(firstReleased, mPendingReleases.end());
+	mReleasedCount += count;
+	return count;
+}
+
+ResourceRegistry::Stats ResourceRegistry::GetStats() const
+{
+	Stats stats;
+	stats.liveCount = static_cast<UINT>(mEntries.Size());
+	stats.pendingReleaseCount = static_cast<UINT>(mPendingReleases.size());
+	stats.releasedCount = mReleasedCount;
+	stats.staleLookups = mStaleLookups;
+	return stats;
+}
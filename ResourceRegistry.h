@@ -0,0 +1,78 @@
+// Resource registry
+// GPU resources are owned here and referred to elsewhere by 32-bit generational handles, so
+// passing one around costs no reference counting and a destroyed resource's handle is caught
+// as stale instead of reaching freed memory. Lookups are an index and a generation check
+// into densely packed entries.
+//
+// Releasing a handle invalidates it straight away, but the resource itself is only destroyed
+// once the fence has passed the last value it was marked as used at.
+//
+// Not thread safe - used from the thread recording and submitting the frame.
+
+#pragma once
+
+#include "DXSampleHelper.h"
+#include "SlotMap.h"
+
+#include <vector>
+
+class ResourceRegistry
+{
+private:
+	struct Entry
+	{
+		ComPtr<ID3D12Resource> resource;
+		UINT64 lastUsedFence;
+	};
+
+public:
+	typedef SlotMap<Entry>::Handle Handle;
+	static const Handle InvalidHandle = SlotMap<Entry>::InvalidHandle;
+
+	struct Stats
+	{
+		UINT liveCount;
+		UINT pendingReleaseCount;	// Released, waiting for the GPU
+		UINT64 releasedCount;		// Destroyed so far
+		UINT64 staleLookups;		// Lookups through handles that were no longer valid
+	};
+
+	ResourceRegistry();
+
+	// Prohibit copying
+	ResourceRegistry(const ResourceRegistry& rhs) = delete;
+	ResourceRegistry& operator=(const ResourceRegistry& rhs) = delete;
+
+	// Destroys everything, pending or not. The GPU must be idle.
+	~ResourceRegistry();
+
+	// Takes ownership of the resource. The name is set on it for debugging, if given.
+	Handle Add(ComPtr<ID3D12Resource> resource, LPCWSTR name = nullptr);
+
+	// Returns null for stale handles. The pointer isn't AddRef'd.
+	ID3D12Resource* Get(Handle handle) const;
+	bool IsValid(Handle handle) const { return mEntries.Contains(handle); }
+
+	// Records that a command list submitted with the given fence value uses the resource
+	void MarkUsed(Handle handle, UINT64 fenceValue);
+
+	// Invalidates the handle. The resource is destroyed once the GPU has finished with it.
+	void Release(Handle handle);
+
+	// Destroys released resources whose last use the GPU has finished. Returns how many.
+	UINT ProcessDeferredReleases(UINT64 completedFenceValue);
+
+	Stats GetStats() const;
+
+private:
+	struct PendingRelease
+	{
+		ComPtr<ID3D12Resource> resource;
+		UINT64 fenceValue;
+	};
+
+	SlotMap<Entry> mEntries;
+	std::vector<PendingRelease> mPendingReleases;
+	UINT64 mReleasedCount;
+	mutable UINT64 mStaleLookups;
+};
@@ -0,0 +1,247 @@
+#include "ResourceStateTracker.h"
+
+#include <cassert>
+
+namespace
+{
+	// A resource already in a combined read state (e.g. GENERIC_READ) doesn't need a
+	// transition to any read state it includes. Write states can't be combined with
+	// other states, so this only ever matches exactly for them.
+	bool IsStateSatisfied(D3D12_RESOURCE_STATES current, D3D12_RESOURCE_STATES requested)
+	{
+		if (requested == D3D12_RESOURCE_STATE_COMMON)
+		{
+			return current == D3D12_RESOURCE_STATE_COMMON;
+		}
+		return (current & requested) == requested;
+	}
+}
+
+void GlobalResourceStates::Register(ID3D12Resource* resource, D3D12_RESOURCE_STATES state)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	mStates[resource] = state;
+}
+
+void GlobalResourceStates::Unregister(ID3D12Resource* resource)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	mStates.erase(resource);
+}
+
+// Returns false if the resource isn't registered
+bool GlobalResourceStates::GetState(ID3D12Resource* resource, D3D12_RESOURCE_STATES* state) const
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	auto it = mStates.find(resource);
+	if (it == mStates.end())
+	{
+		return false;
+	}
+
+	*state = it->second;
+	return true;
+}
+
+ResourceStateTracker::ResourceStateTracker() :
+	mStats()
+{
+}
+
+// Request a resource be in a state for the commands that follow
+void ResourceStateTracker::TransitionResource(ID3D12Resource* resource, D3D12_RESOURCE_STATES state)
+{
+	mStats.transitionsRequested++;
+
+	auto it = mResources.find(resource);
+	if (it == mResources.end())
+	{
+		// First use in this list - the state it is coming from isn't known until submit
+		mPending.emplace_back(resource, state);
+		mResources[resource] = { state, false, D3D12_RESOURCE_STATE_COMMON };
+		return;
+	}
+
+	TrackedResource& tracked = it->second;
+	if (tracked.beginIssued)
+	{
+		EndSplitBarrier(resource, tracked);
+	}
+
+	if (IsStateSatisfied(tracked.state, state))
+	{
+		mStats.redundantTransitions++;
+		return;
+	}
+
+	mBarriers.push_back(CD3DX12_RESOURCE_BARRIER::Transition(resource, tracked.state, state));
+	tracked.state = state;
+}
+
+// Start a transition early so the GPU can overlap it with other work
+void ResourceStateTracker::BeginTransition(ID3D12Resource* resource, D3D12_RESOURCE_STATES state)
+{
+	auto it = mResources.find(resource);
+	if (it == mResources.end())
+	{
+		return;
+	}
+
+	TrackedResource& tracked = it->second;
+	if (tracked.beginIssued || IsStateSatisfied(tracked.state, state))
+	{
+		return;
+	}
+
+	mBarriers.push_back(CD3DX12_RESOURCE_BARRIER::Transition(resource, tracked.state, state,
+		D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES, D3D12_RESOURCE_BARRIER_FLAG_BEGIN_ONLY));
+
+	tracked.beginIssued = true;
+	tracked.splitState = state;
+}
+
+// Ends every split barrier still open, so none is left running past the end of the list
+void ResourceStateTracker::EndSplitBarriers()
+{
+	for (auto& resource : mResources)
+	{
+		if (resource.second.beginIssued)
+		{
+			EndSplitBarrier(resource.first, resource.second);
+		}
+	}
+}
+
+// Tell the tracker what state a resource is in without a barrier
+void ResourceStateTracker::AssumeState(ID3D12Resource* resource, D3D12_RESOURCE_STATES state)
+{
+	mResources[resource] = { state, false, D3D12_RESOURCE_STATE_COMMON };
+}
+
+// Returns false if the resource hasn't been used in this list
+bool ResourceStateTracker::GetTrackedState(ID3D12Resource* resource, D3D12_RESOURCE_STATES* state) const
+{
+	auto it = mResources.find(resource);
+	if (it == mResources.end())
+	{
+		return false;
+	}
+
+	*state = it->second.beginIssued ? it->second.splitState : it->second.state;
+	return true;
+}
+
+// Queue an aliasing barrier for placed resources sharing heap memory
+void ResourceStateTracker::AliasingBarrier(ID3D12Resource* before, ID3D12Resource* after)
+{
+	mBarriers.push_back(CD3DX12_RESOURCE_BARRIER::Aliasing(before, after));
+}
+
+// Issue all the collected barriers in one call
+void ResourceStateTracker::FlushBarriers(ID3D12GraphicsCommandList* commandList)
+{
+	if (mBarriers.empty())
+	{
+		return;
+	}
+
+	commandList->ResourceBarrier(static_cast<UINT>(mBarriers.size()), mBarriers.data());
+
+	mStats.barriersFlushed += static_cast<UINT>(mBarriers.size());
+	mStats.flushes++;
+	mBarriers.clear();
+}
+
+// Works out the barriers needed to move resources from their global state into the state
+// this list first used them in
+UINT ResourceStateTracker::ResolvePendingBarriers(const GlobalResourceStates& globalStates, std::vector<D3D12_RESOURCE_BARRIER>& barriers)
+{
+	UINT added = 0;
+
+	std::lock_guard<std::mutex> lock(globalStates.mMutex);
+	for (const auto& pending : mPending)
+	{
+		auto it = globalStates.mStates.find(pending.first);
+
+		// Unregistered resources are assumed to already be in the right state. This has to be
+		// an exact match, as barriers later in the list were recorded from the pending state.
+		if (it == globalStates.mStates.end() || it->second == pending.second)
+		{
+			continue;
+		}
+
+		barriers.push_back(CD3DX12_RESOURCE_BARRIER::Transition(pending.first, it->second, pending.second));
+		added++;
+	}
+
+	mStats.pendingBarriersResolved += added;
+	return added;
+}
+
+// After submitting, records the state each registered resource was left in as its global state.
+// Unregistered resources are left out, so nothing is recorded for a resource that may be released
+// and its address reused.
+void ResourceStateTracker::CommitFinalStates(GlobalResourceStates& globalStates)
+{
+	std::lock_guard<std::mutex> lock(globalStates.mMutex);
+	for (const auto& resource : mResources)
+	{
+		// The GPU has started moving the resource to the split state, so that is the state it
+		// ends up in even if the end was missed
+		assert(!resource.second.beginIssued && "Split barrier begun but not ended before submit");
+		const D3D12_RESOURCE_STATES state = resource.second.beginIssued ? resource.second.splitState : resource.second.state;
+
+		auto it = globalStates.mStates.find(resource.first);
+		if (it != globalStates.mStates.end())
+		{
+			it->second = state;
+		}
+	}
+}
+
+// Queues the end of a resource's split barrier, or folds it into one transition if the begin
+// hasn't been flushed yet
+void ResourceStateTracker::EndSplitBarrier(ID3D12Resource* resource, TrackedResource& tracked)
+{
+	tracked.beginIssued = false;
+
+	// If the begin hasn't been flushed yet there's nothing to overlap with, so turn it
+	// into a normal transition rather than adding the end
+	bool merged = false;
+	for (auto& barrier : mBarriers)
+	{
+		if (barrier.Type == D3D12_RESOURCE_BARRIER_TYPE_TRANSITION &&
+			barrier.Transition.pResource == resource &&
+			barrier.Flags == D3D12_RESOURCE_BARRIER_FLAG_BEGIN_ONLY)
+		{
+			barrier.Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
+			merged = true;
+			break;
+		}
+	}
+
+	if (!merged)
+	{
+		mBarriers.push_back(CD3DX12_RESOURCE_BARRIER::Transition(resource, tracked.state, tracked.splitState,
+			D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES, D3D12_RESOURCE_BARRIER_FLAG_END_ONLY));
+		mStats.splitBarriers++;
+	}
+
+	tracked.state = tracked.splitState;
+}
+
+// Clear everything ready to record a new command list. The list's tracking is allocated from
+// the arena if one is given, which must last until the next reset.
+void ResourceStateTracker::Reset(LinearArena* arena)
+{
+	mPending.clear();
+	mBarriers.clear();
+
+	// Rebound to the new arena. The old map is released through its own arena, which is still alive.
+	mResources = ScratchUnorderedMap<ID3D12Resource*, TrackedResource>(ArenaAllocator<std::pair<ID3D12Resource* const, TrackedResource>>(arena));
+}
+
+void ResourceStateTracker::ResetStats()
+{
+	mStats = Stats();
+}
@@ -0,0 +1,118 @@
+// Resource state tracking
+// Each command list gets a ResourceStateTracker that records the state of every resource
+// it touches. Transitions are collected and issued as one batched ResourceBarrier call,
+// transitions to the state a resource is already in are dropped, and the state a resource
+// must be in before the list runs is only resolved against the global state at submit time.
+//
+// The trackers never call into the resources themselves (they are only used as keys), so the
+// state resolution can run without a device.
+
+#pragma once
+
+#include "Includes.h"
+#include "FrameArena.h"
+
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+// The state every resource is in between command lists, shared by all trackers
+class GlobalResourceStates
+{
+public:
+	// Resources must be registered with the state they are created in before being tracked
+	void Register(ID3D12Resource* resource, D3D12_RESOURCE_STATES state);
+	void Unregister(ID3D12Resource* resource);
+
+	// Returns false if the resource isn't registered
+	bool GetState(ID3D12Resource* resource, D3D12_RESOURCE_STATES* state) const;
+
+private:
+	friend class ResourceStateTracker;
+
+	mutable std::mutex mMutex;
+	std::unordered_map<ID3D12Resource*, D3D12_RESOURCE_STATES> mStates;
+};
+
+class ResourceStateTracker
+{
+public:
+	struct Stats
+	{
+		UINT transitionsRequested;
+		UINT redundantTransitions;	// Dropped as the resource was already in the state
+		UINT barriersFlushed;		// Issued by FlushBarriers
+		UINT pendingBarriersResolved;	// Added at submit to bring resources from their global state
+		UINT flushes;				// ResourceBarrier calls made
+		UINT splitBarriers;			// Transitions issued as begin/end pairs
+	};
+
+	ResourceStateTracker();
+
+	// Prohibit copying
+	ResourceStateTracker(const ResourceStateTracker& rhs) = delete;
+	ResourceStateTracker& operator=(const ResourceStateTracker& rhs) = delete;
+
+	// Request a resource be in a state for the commands that follow
+	void TransitionResource(ID3D12Resource* resource, D3D12_RESOURCE_STATES state);
+
+	// Start a transition early so the GPU can overlap it with other work. The transition
+	// completes at the next TransitionResource call for this resource. If the resource's
+	// current state isn't known yet this does nothing and the later call does the full transition.
+	void BeginTransition(ID3D12Resource* resource, D3D12_RESOURCE_STATES state);
+
+	// Queue the end of every split barrier still open. A list mustn't be submitted with one open,
+	// so this needs to run, and its barriers be flushed, before the list is closed.
+	void EndSplitBarriers();
+
+	// Tell the tracker what state a resource is in without a barrier, for resources whose state
+	// the caller already knows (e.g. placed resources being reactivated after aliasing)
+	void AssumeState(ID3D12Resource* resource, D3D12_RESOURCE_STATES state);
+
+	// Returns false if the resource hasn't been used in this list
+	bool GetTrackedState(ID3D12Resource* resource, D3D12_RESOURCE_STATES* state) const;
+
+	// Queue an aliasing barrier for placed resources sharing heap memory. A null before
+	// resource means any resource that used the memory.
+	void AliasingBarrier(ID3D12Resource* before, ID3D12Resource* after);
+
+	// Issue all the collected barriers in one call
+	void FlushBarriers(ID3D12GraphicsCommandList* commandList);
+
+	// At submit time, works out the barriers needed to move resources from their global state
+	// into the state this list first used them in. These must run before the list.
+	// Returns the number of barriers added.
+	UINT ResolvePendingBarriers(const GlobalResourceStates& globalStates, std::vector<D3D12_RESOURCE_BARRIER>& barriers);
+
+	// After submitting, records the state each registered resource was left in as its global
+	// state. Unregistered resources are left out, so nothing is recorded for a resource that may
+	// be released and its address reused (e.g. one only brought in with AssumeState). Asserts if
+	// a split barrier was left open; a resource with one is recorded in its split state.
+	void CommitFinalStates(GlobalResourceStates& globalStates);
+
+	// Clear everything ready to record a new command list. Stats are kept. The list's tracking
+	// is allocated from the arena if one is given, which must last until the next reset.
+	void Reset(LinearArena* arena = nullptr);
+
+	// Getters
+	const std::vector<D3D12_RESOURCE_BARRIER>& GetQueuedBarriers() const { return mBarriers; }
+	const Stats& GetStats() const { return mStats; }
+	void ResetStats();
+
+private:
+	struct TrackedResource
+	{
+		D3D12_RESOURCE_STATES state;		// State after the commands recorded so far
+		bool beginIssued;					// A split barrier to splitState has been started
+		D3D12_RESOURCE_STATES splitState;
+	};
+
+	void EndSplitBarrier(ID3D12Resource* resource, TrackedResource& tracked);
+
+	// First state each resource is used in, needed before the list runs
+	std::vector<std::pair<ID3D12Resource*, D3D12_RESOURCE_STATES>> mPending;
+	ScratchUnorderedMap<ID3D12Resource*, TrackedResource> mResources;
+
+	std::vector<D3D12_RESOURCE_BARRIER> mBarriers;
+	Stats mStats;
+};
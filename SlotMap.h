@@ -0,0 +1,219 @@
+// Generational slot map
+// Values are kept packed together in a dense array, so iterating them is a linear walk.
+// They are referred to by 32-bit handles: the low bits index a slot, which holds where the
+// value currently is in the dense array, and the high bits hold the slot's generation.
+// Erasing a value moves the last value into its place and bumps the slot's generation, so
+// any handles still referring to it are detected as stale rather than finding something else.
+//
+// Freed slots are reused oldest first, which spreads reuse over the generations. A slot that
+// runs out of generations is retired rather than wrapping round.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+template<typename T>
+class SlotMap
+{
+public:
+	typedef uint32_t Handle;
+	static const Handle InvalidHandle = 0xFFFFFFFF;
+
+	static const unsigned int IndexBits = 20;
+	static const uint32_t MaxSize = (1u << IndexBits) - 1;		// The top index is left for InvalidHandle
+	static const uint32_t MaxGeneration = (1u << (32 - IndexBits)) - 1;
+
+	SlotMap() : mFreeHead(NoSlot), mFreeTail(NoSlot), mRetiredSlots(0) {}
+
+	// Returns InvalidHandle if the map is full
+	Handle Insert(const T& value) { return Emplace(value); }
+	Handle Insert(T&& value) { return Emplace(std::move(value)); }
+
+	template<typename... Args>
+	Handle Emplace(Args&&... args)
+	{
+		const uint32_t slotIndex = AcquireSlot();
+		if (slotIndex == NoSlot)
+		{
+			return InvalidHandle;
+		}
+
+		Slot& slot = mSlots[slotIndex];
+		slot.denseIndex = static_cast<uint32_t>(mValues.size());
+		mValues.emplace_back(std::forward<Args>(args)...);
+		mDenseToSlot.push_back(slotIndex);
+		return MakeHandle(slotIndex, slot.generation);
+	}
+
+	// Returns false if the handle was stale
+	bool Erase(Handle handle)
+	{
+		const uint32_t slotIndex = FindSlot(handle);
+		if (slotIndex == NoSlot)
+		{
+			return false;
+		}
+
+		// Keep the values packed by moving the last one into the hole
+		Slot& slot = mSlots[slotIndex];
+		const uint32_t lastDense = static_cast<uint32_t>(mValues.size() - 1);
+		if (slot.denseIndex != lastDense)
+		{
+			mValues[slot.denseIndex] = std::move(mValues[lastDense]);
+			mDenseToSlot[slot.denseIndex] = mDenseToSlot[lastDense];
+			mSlots[mDenseToSlot[lastDense]].denseIndex = slot.denseIndex;
+		}
+		mValues.pop_back();
+		mDenseToSlot.pop_back();
+
+		ReleaseSlot(slotIndex);
+		return true;
+	}
+
+	// Returns null if the handle is stale
+	T* Get(Handle handle)
+	{
+		const uint32_t slotIndex = FindSlot(handle);
+		return slotIndex != NoSlot ? &mValues[mSlots[slotIndex].denseIndex] : nullptr;
+	}
+
+	const T* Get(Handle handle) const
+	{
+		const uint32_t slotIndex = FindSlot(handle);
+		return slotIndex != NoSlot ? &mValues[mSlots[slotIndex].denseIndex] : nullptr;
+	}
+
+	bool Contains(Handle handle) const { return FindSlot(handle) != NoSlot; }
+
+	// Erases everything. Every handle given out so far becomes stale.
+	void Clear()
+	{
+		while (!mDenseToSlot.empty())
+		{
+			const uint32_t slotIndex = mDenseToSlot.back();
+			mValues.pop_back();
+			mDenseToSlot.pop_back();
+			ReleaseSlot(slotIndex);
+		}
+	}
+
+	void Reserve(size_t count)
+	{
+		mSlots.reserve(count);
+		mValues.reserve(count);
+		mDenseToSlot.reserve(count);
+	}
+
+	// Getters
+	size_t Size() const { return mValues.size(); }
+	bool Empty() const { return mValues.empty(); }
+	uint32_t GetRetiredSlotCount() const { return mRetiredSlots; }
+
+	// The dense values, in no particular order. Erasing changes the order.
+	T* begin() { return mValues.data(); }
+	T* end() { return mValues.data() + mValues.size(); }
+	const T* begin() const { return mValues.data(); }
+	const T* end() const { return mValues.data() + mValues.size(); }
+
+	// Handle of the value at a position in the dense array
+	Handle GetHandleAt(size_t denseIndex) const
+	{
+		const uint32_t slotIndex = mDenseToSlot[denseIndex];
+		return MakeHandle(slotIndex, mSlots[slotIndex].generation);
+	}
+
+	static uint32_t GetIndex(Handle handle) { return handle & MaxSize; }
+	static uint32_t GetGeneration(Handle handle) { return handle >> IndexBits; }
+
+private:
+	static const uint32_t NoSlot = 0xFFFFFFFF;
+
+	struct Slot
+	{
+		uint32_t denseIndex;	// NoSlot while free
+		uint32_t generation;
+		uint32_t nextFree;
+	};
+
+	static Handle MakeHandle(uint32_t slotIndex, uint32_t generation)
+	{
+		return (generation << IndexBits) | slotIndex;
+	}
+
+	// Returns the handle's slot, or NoSlot if the handle is stale
+	uint32_t FindSlot(Handle handle) const
+	{
+		const uint32_t slotIndex = GetIndex(handle);
+		if (slotIndex >= mSlots.size())
+		{
+			return NoSlot;
+		}
+
+		const Slot& slot = mSlots[slotIndex];
+		return slot.generation == GetGeneration(handle) && slot.denseIndex != NoSlot ? slotIndex : NoSlot;
+	}
+
+	uint32_t AcquireSlot()
+	{
+		if (mFreeHead != NoSlot)
+		{
+			const uint32_t slotIndex = mFreeHead;
+			mFreeHead = mSlots[slotIndex].nextFree;
+			if (mFreeHead == NoSlot)
+			{
+				mFreeTail = NoSlot;
+			}
+			return slotIndex;
+		}
+
+		if (mSlots.size() >= MaxSize)
+		{
+			return NoSlot;
+		}
+
+		Slot slot = { NoSlot, 0, NoSlot };
+		mSlots.push_back(slot);
+		return static_cast<uint32_t>(mSlots.size() - 1);
+	}
+
+	void ReleaseSlot(uint32_t slotIndex)
+	{
+		Slot& slot = mSlots[slotIndex];
+		slot.denseIndex = NoSlot;
+		slot.nextFree = NoSlot;
+
+		if (slot.generation == MaxGeneration)
+		{
+			mRetiredSlots++;
+			return;
+		}
+		slot.generation++;
+
+		// Added at the tail, so the slot freed longest ago is reused first
+		if (mFreeTail != NoSlot)
+		{
+			mSlots[mFreeTail].nextFree = slotIndex;
+		}
+		else
+		{
+			mFreeHead = slotIndex;
+		}
+		mFreeTail = slotIndex;
+	}
+
+	std::vector<Slot> mSlots;
+	std::vector<T> mValues;
+	std::vector<uint32_t> mDenseToSlot;
+	uint32_t mFreeHead;
+	uint32_t mFreeTail;
+	uint32_t mRetiredSlots;
+};
+
+template<typename T> const typename SlotMap<T>::Handle SlotMap<T>::InvalidHandle;
+template<typename T> const unsigned int SlotMap<T>::IndexBits;
+template<typename T> const uint32_t SlotMap<T>::MaxSize;
+template<typename T> const uint32_t SlotMap<T>::MaxGeneration;
+template<typename T> const uint32_t SlotMap<T>::NoSlot;
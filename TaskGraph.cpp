@@ -0,0 +1,250 @@
+#include "TaskGraph.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+
+TaskGraph::TaskGraph() :
+	mTotalTime(0),
+	mJobSystem(nullptr),
+	mClock(nullptr),
+	mStartTime(0),
+	mRemaining(0)
+{
+}
+
+// Dependencies must have been added already, so the graph can't have cycles.
+// The name must outlive the graph.
+TaskGraph::TaskId TaskGraph::AddTask(const char* name, Task task, std::initializer_list<TaskId> dependencies, ETaskThread thread)
+{
+	const TaskId id = static_cast<TaskId>(mNodes.size());
+
+	Node node;
+	node.name = name;
+	node.task = std::move(task);
+	node.thread = thread;
+	for (TaskId dependency : dependencies)
+	{
+		assert(dependency < id && "Tasks can only depend on tasks added before them");
+		node.dependencies.push_back(dependency);
+		mNodes[dependency].dependents.push_back(id);
+	}
+	mNodes.push_back(std::move(node));
+	return id;
+}
+
+// Runs every task and blocks until they're done. Main thread tasks are run from here while
+// waiting. If a task throws, the tasks depending on it are skipped, the rest finish, then
+// the first exception is rethrown.
+void TaskGraph::Run(JobSystem& jobSystem, const IClock& clock)
+{
+	mJobSystem = &jobSystem;
+	mClock = &clock;
+	mException = nullptr;
+
+	const size_t count = mNodes.size();
+	mTimings.assign(count, TaskTiming());
+	mWaitingOn.resize(count);
+	mFailed.assign(count, false);
+	mMainThreadQueue.clear();
+
+	std::unique_lock<std::mutex> lock(mMutex);
+	mRemaining = static_cast<unsigned int>(count);
+	mStartTime = clock.Now();
+	for (TaskId id = 0; id < count; id++)
+	{
+		mTimings[id].name = mNodes[id].name;
+		mWaitingOn[id] = static_cast<unsigned int>(mNodes[id].dependencies.size());
+	}
+	for (TaskId id = 0; id < count; id++)
+	{
+		if (mWaitingOn[id] == 0)
+		{
+			Dispatch(id);
+		}
+	}
+
+	// Run main thread tasks as they become ready, until everything has finished
+	while (mRemaining > 0)
+	{
+		if (mMainThreadQueue.empty())
+		{
+			mChanged.wait(lock);
+			continue;
+		}
+
+		const TaskId id = mMainThreadQueue.front();
+		mMainThreadQueue.erase(mMainThreadQueue.begin());
+		lock.unlock();
+		Execute(id);
+		lock.lock();
+	}
+
+	mTotalTime = clock.Now() - mStartTime;
+	lock.unlock();
+
+	FindCriticalPath();
+
+	if (mException)
+	{
+		std::rethrow_exception(mException);
+	}
+}
+
+// Hands a task whose dependencies have finished to the thread it runs on. Called with the lock held.
+void TaskGraph::Dispatch(TaskId id)
+{
+	mTimings[id].readyTime = mClock->Now() - mStartTime;
+
+	if (mNodes[id].thread == TaskThread_Main)
+	{
+		mMainThreadQueue.push_back(id);
+		mChanged.notify_all();
+	}
+	else
+	{
+		mJobSystem->Submit([this, id]() { Execute(id); });
+	}
+}
+
+// Runs a task (unless something it depends on failed), then dispatches the tasks waiting on it
+void TaskGraph::Execute(TaskId id)
+{
+	bool failed;
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		failed = mFailed[id];
+	}
+
+	TaskTiming& timing = mTimings[id];
+	timing.start = mClock->Now() - mStartTime;
+	if (!failed)
+	{
+		timing.ran = true;
+		try
+		{
+			mNodes[id].task();
+		}
+		catch (...)
+		{
+			timing.threw = true;
+
+			std::lock_guard<std::mutex> lock(mMutex);
+			if (!mException)
+			{
+				mException = std::current_exception();
+			}
+			failed = true;
+		}
+	}
+	timing.end = mClock->Now() - mStartTime;
+
+	std::lock_guard<std::mutex> lock(mMutex);
+	for (TaskId dependent : mNodes[id].dependents)
+	{
+		if (failed)
+		{
+			mFailed[dependent] = true;
+		}
+		if (--mWaitingOn[dependent] == 0)
+		{
+			Dispatch(dependent);
+		}
+	}
+
+	mRemaining--;
+	if (mRemaining == 0)
+	{
+		mChanged.notify_all();
+	}
+}
+
+// Walks back from the last task to finish, each time to the dependency that finished last
+void TaskGraph::FindCriticalPath()
+{
+	if (mNodes.empty())
+	{
+		return;
+	}
+
+	TaskId id = 0;
+	for (TaskId i = 1; i < mNodes.size(); i++)
+	{
+		if (mTimings[i].end > mTimings[id].end)
+		{
+			id = i;
+		}
+	}
+
+	while (true)
+	{
+		mTimings[id].onCriticalPath = true;
+
+		const std::vector<TaskId>& dependencies = mNodes[id].dependencies;
+		if (dependencies.empty())
+		{
+			break;
+		}
+
+		id = *std::max_element(dependencies.begin(), dependencies.end(),
+			[this](TaskId a, TaskId b) { return mTimings[a].end < mTimings[b].end; });
+	}
+}
+
+// Sum of the critical path's task times
+int64_t TaskGraph::GetCriticalPathTime() const
+{
+	int64_t time = 0;
+	for (const TaskTiming& timing : mTimings)
+	{
+		if (timing.onCriticalPath)
+		{
+			time += timing.end - timing.start;
+		}
+	}
+	return time;
+}
+
+// Sum of every task's time, as if run one after another
+int64_t TaskGraph::GetSerialTime() const
+{
+	int64_t time = 0;
+	for (const TaskTiming& timing : mTimings)
+	{
+		time += timing.end - timing.start;
+	}
+	return time;
+}
+
+// One line per task in start order, marking the critical path, plus totals.
+// Queued is the time between a task's dependencies finishing and it starting.
+std::string TaskGraph::FormatReport() const
+{
+	std::vector<const TaskTiming*> ordered;
+	for (const TaskTiming& timing : mTimings)
+	{
+		ordered.push_back(&timing);
+	}
+	std::stable_sort(ordered.begin(), ordered.end(),
+		[](const TaskTiming* a, const TaskTiming* b) { return a->start < b->start; });
+
+	std::string report;
+	char line[256];
+	for (const TaskTiming* timing : ordered)
+	{
+		snprintf(line, sizeof(line), "%c %-24s start %8.2f ms  took %8.2f ms  queued %6.2f ms%s\n",
+			timing->onCriticalPath ? '*' : ' ', timing->name,
+			NanosecondsToMilliseconds(timing->start),
+			NanosecondsToMilliseconds(timing->end - timing->start),
+			NanosecondsToMilliseconds(timing->start - timing->readyTime),
+			timing->threw ? "  (threw)" : timing->ran ? "" : "  (skipped)");
+		report += line;
+	}
+
+	snprintf(line, sizeof(line), "Total %.2f ms, critical path (*) %.2f ms, %.2f ms if run serially\n",
+		NanosecondsToMilliseconds(mTotalTime),
+		NanosecondsToMilliseconds(GetCriticalPathTime()),
+		NanosecondsToMilliseconds(GetSerialTime()));
+	report += line;
+	return report;
+}
@@ -0,0 +1,104 @@
+// Task graph
+// Runs a set of tasks with dependencies between them on the job system. A task starts as soon
+// as everything it depends on has finished, so independent chains run side by side. Tasks can
+// be pinned to the thread running the graph, for work that has to happen there (anything
+// touching the window, say).
+//
+// Each task's start and end are recorded, and the critical path - the chain of dependencies
+// that decided when the last task finished - is worked out afterwards. Shortening any other
+// task won't make the graph finish sooner.
+//
+// Used once at startup, so simplicity wins over scheduling overhead.
+
+#pragma once
+
+#include "Clock.h"
+#include "JobSystem.h"
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <initializer_list>
+#include <mutex>
+#include <string>
+#include <vector>
+
+enum ETaskThread
+{
+	TaskThread_Any,		// On a job system worker
+	TaskThread_Main		// On the thread calling Run
+};
+
+class TaskGraph
+{
+public:
+	typedef unsigned int TaskId;
+	typedef std::function<void()> Task;
+
+	struct TaskTiming
+	{
+		const char* name;
+		int64_t start;			// Nanoseconds from the start of the run
+		int64_t end;
+		int64_t readyTime;		// When the last of its dependencies finished
+		bool onCriticalPath;
+		bool ran;				// False if skipped as something it depends on threw
+		bool threw;
+	};
+
+	TaskGraph();
+
+	// Prohibit copying
+	TaskGraph(const TaskGraph& rhs) = delete;
+	TaskGraph& operator=(const TaskGraph& rhs) = delete;
+
+	// Dependencies must have been added already, so the graph can't have cycles.
+	// The name must outlive the graph.
+	TaskId AddTask(const char* name, Task task, std::initializer_list<TaskId> dependencies = {}, ETaskThread thread = TaskThread_Any);
+
+	// Runs every task and blocks until they're done. Main thread tasks are run from here while
+	// waiting. If a task throws, the tasks depending on it are skipped, the rest finish, then
+	// the first exception is rethrown.
+	void Run(JobSystem& jobSystem, const IClock& clock);
+
+	// Getters, valid after Run
+	const std::vector<TaskTiming>& GetTimings() const { return mTimings; }
+	int64_t GetTotalTime() const { return mTotalTime; }
+	int64_t GetCriticalPathTime() const;	// Sum of the critical path's task times
+	int64_t GetSerialTime() const;			// Sum of every task's time, as if run one after another
+
+	// One line per task in start order, marking the critical path, plus totals
+	std::string FormatReport() const;
+
+private:
+	struct Node
+	{
+		const char* name;
+		Task task;
+		ETaskThread thread;
+		std::vector<TaskId> dependencies;
+		std::vector<TaskId> dependents;
+	};
+
+	void Dispatch(TaskId id);
+	void Execute(TaskId id);
+	void FindCriticalPath();
+
+	std::vector<Node> mNodes;
+	std::vector<TaskTiming> mTimings;
+	int64_t mTotalTime;
+
+	// Run state, shared with the workers
+	JobSystem* mJobSystem;
+	const IClock* mClock;
+	int64_t mStartTime;
+	std::mutex mMutex;
+	std::condition_variable mChanged;
+	std::vector<unsigned int> mWaitingOn;	// Unfinished dependencies per task
+	std::vector<TaskId> mMainThreadQueue;
+	std::vector<bool> mFailed;				// Threw, or depends on a task that did
+	unsigned int mRemaining;
+	std::exception_ptr mException;
+};
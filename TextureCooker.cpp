@@ -0,0 +1,361 @@
+// TextureCooker - builds a mip chain for a texture and writes it block compressed as a DDS file
+//
+// Usage: TextureCooker <input.tga> <output.dds> [-format bc1|bc5|bc7] [-filter box|kaiser] [-linear] [-nomips] [-stats]
+//        TextureCooker -benchmark [size]
+//   -format	Block format (default bc7). bc5 keeps red and green, for normal maps.
+//   -filter	Mip filter (default kaiser)
+//   -linear	The texture isn't colour, so filter it as is rather than in linear light.
+//				Always the case for bc5.
+//   -nomips	Only write the top level
+//   -stats		Print each level's PSNR against the uncompressed level
+//   -benchmark	Cook a generated size x size image (default 1024) with every format and filter,
+//				printing throughput and quality
+//
+// Only uses the standard library, so also builds on Linux, e.g.
+//   g++ -O2 -std=c++14 -pthread TextureCooker.cpp TextureImage.cpp BlockCompression.cpp JobSystem.cpp -o TextureCooker
+
+#include "BlockCompression.h"
+#include "Clock.h"
+#include "DdsFormat.h"
+#include "JobSystem.h"
+#include "TextureImage.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace
+{
+	const uint32_t DefaultBenchmarkSize = 1024;
+
+	struct CookSettings
+	{
+		EBlockFormat format;
+		EMipFilter filter;
+		bool srgb;
+		bool mips;
+	};
+
+	struct CookedLevel
+	{
+		uint32_t width;
+		uint32_t height;
+		std::vector<uint8_t> blocks;
+		double psnr;
+	};
+
+	struct CookTimes
+	{
+		int64_t mipTime;
+		int64_t compressTime;
+	};
+
+	FILE* OpenFile(const char* path, const char* mode)
+	{
+		FILE* file = nullptr;
+#if defined(_MSC_VER)
+		fopen_s(&file, path, mode);
+#else
+		file = fopen(path, mode);
+#endif
+		return file;
+	}
+
+	bool ReadWholeFile(const char* path, std::vector<uint8_t>& data)
+	{
+		FILE* file = OpenFile(path, "rb");
+		if (file == nullptr)
+		{
+			return false;
+		}
+
+		fseek(file, 0, SEEK_END);
+		const long size = ftell(file);
+		fseek(file, 0, SEEK_SET);
+		data.resize(size > 0 ? static_cast<size_t>(size) : 0);
+		const bool success = size >= 0 && fread(data.data(), 1, data.size(), file) == data.size();
+		fclose(file);
+		return success;
+	}
+
+	uint32_t GetDxgiFormat(EBlockFormat format, bool srgb)
+	{
+		switch (format)
+		{
+		case BlockFormat_BC1:
+			return srgb ? DdsDxgiFormat_BC1_UNorm_sRGB : DdsDxgiFormat_BC1_UNorm;
+		case BlockFormat_BC5:
+			return DdsDxgiFormat_BC5_UNorm;
+		default:
+			return srgb ? DdsDxgiFormat_BC7_UNorm_sRGB : DdsDxgiFormat_BC7_UNorm;
+		}
+	}
+
+	// Builds the mip chain and compresses every level, measuring each level's quality if asked
+	void Cook(const TextureImage& image, const CookSettings& settings, JobSystem& jobSystem, bool measure, std::vector<CookedLevel>& levels, CookTimes& times)
+	{
+		SystemClock clock;
+		const int64_t start = clock.Now();
+
+		std::vector<TextureImage> mips;
+		if (settings.mips)
+		{
+			GenerateMipChain(image, settings.filter, settings.srgb, mips);
+		}
+		else
+		{
+			mips.push_back(image);
+		}
+		const int64_t mipsDone = clock.Now();
+
+		levels.resize(mips.size());
+		for (size_t i = 0; i < mips.size(); i++)
+		{
+			levels[i].width = mips[i].width;
+			levels[i].height = mips[i].height;
+			CompressImage(mips[i], settings.format, &jobSystem, levels[i].blocks);
+		}
+		const int64_t compressDone = clock.Now();
+
+		times.mipTime = mipsDone - start;
+		times.compressTime = compressDone - mipsDone;
+
+		for (size_t i = 0; i < mips.size() && measure; i++)
+		{
+			TextureImage decoded;
+			DecompressImage(levels[i].blocks.data(), levels[i].width, levels[i].height, settings.format, decoded);
+			levels[i].psnr = ComputePsnr(mips[i], decoded, GetBlockChannelCount(settings.format));
+		}
+	}
+
+	bool WriteDds(const char* path, const CookSettings& settings, const std::vector<CookedLevel>& levels)
+	{
+		DdsHeader header = {};
+		header.size = sizeof(DdsHeader);
+		header.flags = DdsHeader_Caps | DdsHeader_Height | DdsHeader_Width | DdsHeader_PixelFormat | DdsHeader_LinearSize;
+		header.height = levels[0].height;
+		header.width = levels[0].width;
+		header.pitchOrLinearSize = static_cast<uint32_t>(levels[0].blocks.size());
+		header.mipMapCount = static_cast<uint32_t>(levels.size());
+		header.pixelFormat.size = sizeof(DdsPixelFormat);
+		header.pixelFormat.flags = DdsPixelFormat_FourCC;
+		header.pixelFormat.fourCC = DdsFourCC_Dx10;
+		header.caps = DdsCaps_Texture;
+		if (levels.size() > 1)
+		{
+			header.flags |= DdsHeader_MipMapCount;
+			header.caps |= DdsCaps_Complex | DdsCaps_MipMap;
+		}
+
+		DdsHeaderDx10 headerDx10 = {};
+		headerDx10.dxgiFormat = GetDxgiFormat(settings.format, settings.srgb);
+		headerDx10.resourceDimension = DdsResourceDimension_Texture2D;
+		headerDx10.arraySize = 1;
+
+		FILE* file = OpenFile(path, "wb");
+		if (file == nullptr)
+		{
+			return false;
+		}
+
+		bool success = fwrite(&DdsMagic, sizeof(DdsMagic), 1, file) == 1 &&
+			fwrite(&header, sizeof(header), 1, file) == 1 &&
+			fwrite(&headerDx10, sizeof(headerDx10), 1, file) == 1;
+		for (const CookedLevel& level : levels)
+		{
+			success = success && fwrite(level.blocks.data(), 1, level.blocks.size(), file) == level.blocks.size();
+		}
+		return fclose(file) == 0 && success;
+	}
+
+	// Smooth gradients, hard edges and noise, so every part of the encoders gets exercised
+	void GenerateTestImage(uint32_t size, TextureImage& image)
+	{
+		image.Resize(size, size);
+		uint32_t random = 1;
+		for (uint32_t y = 0; y < size; y++)
+		{
+			for (uint32_t x = 0; x < size; x++)
+			{
+				random = random * 1664525u + 1013904223u;
+				const int noise = static_cast<int>((random >> 24) % 16) - 8;
+				const bool checker = ((x / 64) + (y / 64)) % 2 == 0;
+				uint8_t* pixel = &image.rgba[(static_cast<size_t>(y) * size + x) * 4];
+				pixel[0] = static_cast<uint8_t>((std::min)((std::max)(static_cast<int>(x * 255 / size) + noise, 0), 255));
+				pixel[1] = static_cast<uint8_t>(y * 255 / size);
+				pixel[2] = checker ? 200 : 40;
+				pixel[3] = static_cast<uint8_t>(((x + y) * 255) / (2 * size));
+			}
+		}
+	}
+
+	int RunBenchmark(uint32_t size, JobSystem& jobSystem)
+	{
+		TextureImage image;
+		GenerateTestImage(size, image);
+
+		const char* formatNames[] = { "BC1", "BC5", "BC7" };
+		const char* filterNames[] = { "box", "kaiser" };
+		const double megapixels = static_cast<double>(size) * size / 1e6;
+
+		printf("%ux%u, %u worker threads\n", size, size, jobSystem.GetThreadCount());
+		printf("%-6s %-7s %10s %14s %10s\n", "Format", "Filter", "Mips (ms)", "Compress MP/s", "PSNR (dB)");
+		for (int format = BlockFormat_BC1; format <= BlockFormat_BC7; format++)
+		{
+			for (int filter = MipFilter_Box; filter <= MipFilter_Kaiser; filter++)
+			{
+				CookSettings settings;
+				settings.format = static_cast<EBlockFormat>(format);
+				settings.filter = static_cast<EMipFilter>(filter);
+				settings.srgb = settings.format != BlockFormat_BC5;
+				settings.mips = true;
+
+				std::vector<CookedLevel> levels;
+				CookTimes times;
+				Cook(image, settings, jobSystem, true, levels, times);
+
+				// Throughput over the whole chain, which is a third bigger than the top level
+				printf("%-6s %-7s %10.2f %14.1f %10.2f\n", formatNames[format], filterNames[filter],
+					NanosecondsToMilliseconds(times.mipTime),
+					megapixels * 4.0 / 3.0 / NanosecondsToSeconds(times.compressTime),
+					levels[0].psnr);
+			}
+		}
+		return 0;
+	}
+
+	void PrintUsage()
+	{
+		printf("Usage: TextureCooker <input.tga> <output.dds> [-format bc1|bc5|bc7] [-filter box|kaiser] [-linear] [-nomips] [-stats]\n");
+		printf("       TextureCooker -benchmark [size]\n");
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	JobSystem jobSystem;
+
+	if (argc >= 2 && strcmp(argv[1], "-benchmark") == 0)
+	{
+		const int size = argc >= 3 ? atoi(argv[2]) : static_cast<int>(DefaultBenchmarkSize);
+		if (size < 4)
+		{
+			PrintUsage();
+			return 1;
+		}
+		return RunBenchmark(static_cast<uint32_t>(size), jobSystem);
+	}
+
+	if (argc < 3)
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	CookSettings settings;
+	settings.format = BlockFormat_BC7;
+	settings.filter = MipFilter_Kaiser;
+	settings.srgb = true;
+	settings.mips = true;
+	bool printStats = false;
+
+	for (int i = 3; i < argc; i++)
+	{
+		if (strcmp(argv[i], "-format") == 0 && i + 1 < argc)
+		{
+			const char* name = argv[++i];
+			if (strcmp(name, "bc1") == 0)
+			{
+				settings.format = BlockFormat_BC1;
+			}
+			else if (strcmp(name, "bc5") == 0)
+			{
+				settings.format = BlockFormat_BC5;
+			}
+			else if (strcmp(name, "bc7") == 0)
+			{
+				settings.format = BlockFormat_BC7;
+			}
+			else
+			{
+				PrintUsage();
+				return 1;
+			}
+		}
+		else if (strcmp(argv[i], "-filter") == 0 && i + 1 < argc)
+		{
+			const char* name = argv[++i];
+			if (strcmp(name, "box") == 0)
+			{
+				settings.filter = MipFilter_Box;
+			}
+			else if (strcmp(name, "kaiser") == 0)
+			{
+				settings.filter = MipFilter_Kaiser;
+			}
+			else
+			{
+				PrintUsage();
+				return 1;
+			}
+		}
+		else if (strcmp(argv[i], "-linear") == 0)
+		{
+			settings.srgb = false;
+		}
+		else if (strcmp(argv[i], "-nomips") == 0)
+		{
+			settings.mips = false;
+		}
+		else if (strcmp(argv[i], "-stats") == 0)
+		{
+			printStats = true;
+		}
+		else
+		{
+			PrintUsage();
+			return 1;
+		}
+	}
+
+	// Normal maps aren't colour
+	if (settings.format == BlockFormat_BC5)
+	{
+		settings.srgb = false;
+	}
+
+	std::vector<uint8_t> data;
+	TextureImage image;
+	if (!ReadWholeFile(argv[1], data) || !LoadTga(data.data(), data.size(), image))
+	{
+		fprintf(stderr, "Failed to read %s\n", argv[1]);
+		return 1;
+	}
+
+	std::vector<CookedLevel> levels;
+	CookTimes times;
+	Cook(image, settings, jobSystem, printStats, levels, times);
+
+	if (!WriteDds(argv[2], settings, levels))
+	{
+		fprintf(stderr, "Failed to write %s\n", argv[2]);
+		return 1;
+	}
+
+	size_t compressedBytes = 0;
+	for (const CookedLevel& level : levels)
+	{
+		compressedBytes += level.blocks.size();
+		if (printStats)
+		{
+			printf("  %5ux%-5u PSNR %.2f dB\n", level.width, level.height, level.psnr);
+		}
+	}
+
+	printf("Cooked %ux%u, %zu levels, %zu bytes (mips %.2f ms, compression %.2f ms)\n",
+		image.width, image.height, levels.size(), compressedBytes,
+		NanosecondsToMilliseconds(times.mipTime), NanosecondsToMilliseconds(times.compressTime));
+
+	return 0;
+}
@@ -0,0 +1,402 @@
+#include "TextureImage.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if TEXTURE_SIMD
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+	// Linear to sRGB goes through a table this size. Fine enough that only values right on the
+	// boundary between two sRGB codes can round the other way.
+	const unsigned int LinearTableSize = 16384;
+
+	// Kaiser filter taps, in source pixels. Each output pixel is centred between the middle two.
+	const unsigned int KaiserTaps = 8;
+	const float KaiserRadius = 2.0f;	// In output pixels
+	const float KaiserBeta = 4.0f;
+
+	struct SrgbTables
+	{
+		float toLinear[256];
+		uint8_t fromLinear[LinearTableSize + 1];
+
+		SrgbTables()
+		{
+			for (unsigned int i = 0; i < 256; i++)
+			{
+				const float srgb = i / 255.0f;
+				toLinear[i] = srgb <= 0.04045f ? srgb / 12.92f : std::pow((srgb + 0.055f) / 1.055f, 2.4f);
+			}
+
+			for (unsigned int i = 0; i <= LinearTableSize; i++)
+			{
+				const float linear = static_cast<float>(i) / LinearTableSize;
+				const float srgb = linear <= 0.0031308f ? linear * 12.92f : 1.055f * std::pow(linear, 1.0f / 2.4f) - 0.055f;
+				fromLinear[i] = static_cast<uint8_t>((std::min)((std::max)(srgb, 0.0f), 1.0f) * 255.0f + 0.5f);
+			}
+		}
+	};
+
+	const SrgbTables& GetSrgbTables()
+	{
+		static const SrgbTables sTables;
+		return sTables;
+	}
+
+	// Linear RGBA floats, 4 per pixel
+	struct FloatImage
+	{
+		uint32_t width;
+		uint32_t height;
+		std::vector<float> pixels;
+
+		void Resize(uint32_t newWidth, uint32_t newHeight)
+		{
+			width = newWidth;
+			height = newHeight;
+			pixels.resize(static_cast<size_t>(width) * height * 4);
+		}
+
+		float* Row(uint32_t y) { return &pixels[static_cast<size_t>(y) * width * 4]; }
+		const float* Row(uint32_t y) const { return &pixels[static_cast<size_t>(y) * width * 4]; }
+	};
+
+	// One RGBA pixel in a register
+#if TEXTURE_SIMD
+	typedef __m128 Pixel;
+
+	inline Pixel LoadPixel(const float* p) { return _mm_loadu_ps(p); }
+	inline void StorePixel(float* p, Pixel v) { _mm_storeu_ps(p, v); }
+	inline Pixel ZeroPixel() { return _mm_setzero_ps(); }
+	inline Pixel AddPixels(Pixel a, Pixel b) { return _mm_add_ps(a, b); }
+	inline Pixel ScalePixel(Pixel a, float scale) { return _mm_mul_ps(a, _mm_set1_ps(scale)); }
+#else
+	struct Pixel
+	{
+		float v[4];
+	};
+
+	inline Pixel LoadPixel(const float* p) { Pixel r = { { p[0], p[1], p[2], p[3] } }; return r; }
+	inline void StorePixel(float* p, Pixel v) { p[0] = v.v[0]; p[1] = v.v[1]; p[2] = v.v[2]; p[3] = v.v[3]; }
+	inline Pixel ZeroPixel() { Pixel r = { { 0.0f, 0.0f, 0.0f, 0.0f } }; return r; }
+	inline Pixel AddPixels(Pixel a, Pixel b) { Pixel r = { { a.v[0] + b.v[0], a.v[1] + b.v[1], a.v[2] + b.v[2], a.v[3] + b.v[3] } }; return r; }
+	inline Pixel ScalePixel(Pixel a, float s) { Pixel r = { { a.v[0] * s, a.v[1] * s, a.v[2] * s, a.v[3] * s } }; return r; }
+#endif
+
+	void ToFloatImage(const TextureImage& image, bool srgb, FloatImage& result)
+	{
+		const SrgbTables& tables = GetSrgbTables();
+		result.Resize(image.width, image.height);
+
+		const size_t count = static_cast<size_t>(image.width) * image.height * 4;
+		for (size_t i = 0; i < count; i++)
+		{
+			const bool colour = (i & 3) != 3;
+			result.pixels[i] = srgb && colour ? tables.toLinear[image.rgba[i]] : image.rgba[i] / 255.0f;
+		}
+	}
+
+	void ToTextureImage(const FloatImage& image, bool srgb, TextureImage& result)
+	{
+		const SrgbTables& tables = GetSrgbTables();
+		result.Resize(image.width, image.height);
+
+		// The Kaiser filter's negative lobes can overshoot
+		const size_t count = static_cast<size_t>(image.width) * image.height * 4;
+		for (size_t i = 0; i < count; i++)
+		{
+			const float value = (std::min)((std::max)(image.pixels[i], 0.0f), 1.0f);
+			const bool colour = (i & 3) != 3;
+			result.rgba[i] = srgb && colour ?
+				tables.fromLinear[static_cast<unsigned int>(value * LinearTableSize + 0.5f)] :
+				static_cast<uint8_t>(value * 255.0f + 0.5f);
+		}
+	}
+
+	void DownsampleBox(const FloatImage& source, FloatImage& result)
+	{
+		result.Resize((std::max)(source.width / 2, 1u), (std::max)(source.height / 2, 1u));
+
+		for (uint32_t y = 0; y < result.height; y++)
+		{
+			const float* row0 = source.Row((std::min)(y * 2, source.height - 1));
+			const float* row1 = source.Row((std::min)(y * 2 + 1, source.height - 1));
+			float* output = result.Row(y);
+
+			for (uint32_t x = 0; x < result.width; x++)
+			{
+				const size_t x0 = static_cast<size_t>((std::min)(x * 2, source.width - 1)) * 4;
+				const size_t x1 = static_cast<size_t>((std::min)(x * 2 + 1, source.width - 1)) * 4;
+				const Pixel sum = AddPixels(AddPixels(LoadPixel(row0 + x0), LoadPixel(row0 + x1)),
+					AddPixels(LoadPixel(row1 + x0), LoadPixel(row1 + x1)));
+				StorePixel(output + x * 4, ScalePixel(sum, 0.25f));
+			}
+		}
+	}
+
+	// Zeroth order modified Bessel function of the first kind, for the Kaiser window
+	double BesselI0(double x)
+	{
+		double sum = 1.0;
+		double term = 1.0;
+		for (int k = 1; k < 32; k++)
+		{
+			term *= (x / (2.0 * k)) * (x / (2.0 * k));
+			sum += term;
+			if (term < sum * 1e-12)
+			{
+				break;
+			}
+		}
+		return sum;
+	}
+
+	// Weights for each tap, the same for every output pixel when halving
+	void ComputeKaiserWeights(float weights[KaiserTaps])
+	{
+		const double pi = 3.14159265358979323846;
+		double total = 0.0;
+		double raw[KaiserTaps];
+		for (unsigned int k = 0; k < KaiserTaps; k++)
+		{
+			// Distance from the output pixel's centre, in output pixels
+			const double t = (static_cast<double>(k) - (KaiserTaps / 2 - 0.5)) * 0.5;
+			const double sinc = t == 0.0 ? 1.0 : std::sin(pi * t) / (pi * t);
+			const double r = t / KaiserRadius;
+			const double window = r * r < 1.0 ? BesselI0(KaiserBeta * std::sqrt(1.0 - r * r)) / BesselI0(KaiserBeta) : 0.0;
+			raw[k] = sinc * window;
+			total += raw[k];
+		}
+
+		for (unsigned int k = 0; k < KaiserTaps; k++)
+		{
+			weights[k] = static_cast<float>(raw[k] / total);
+		}
+	}
+
+	// Separable, so done as a horizontal then a vertical pass. Edges are clamped.
+	void DownsampleKaiser(const FloatImage& source, FloatImage& result)
+	{
+		float weights[KaiserTaps];
+		ComputeKaiserWeights(weights);
+		const int firstTap = -static_cast<int>(KaiserTaps / 2 - 1);
+
+		FloatImage horizontal;
+		horizontal.Resize((std::max)(source.width / 2, 1u), source.height);
+		for (uint32_t y = 0; y < source.height; y++)
+		{
+			const float* input = source.Row(y);
+			float* output = horizontal.Row(y);
+			for (uint32_t x = 0; x < horizontal.width; x++)
+			{
+				Pixel sum = ZeroPixel();
+				for (unsigned int k = 0; k < KaiserTaps; k++)
+				{
+					const int sx = (std::min)((std::max)(static_cast<int>(x * 2) + firstTap + static_cast<int>(k), 0), static_cast<int>(source.width) - 1);
+					sum = AddPixels(sum, ScalePixel(LoadPixel(input + static_cast<size_t>(sx) * 4), weights[k]));
+				}
+				StorePixel(output + x * 4, sum);
+			}
+		}
+
+		result.Resize(horizontal.width, (std::max)(source.height / 2, 1u));
+		for (uint32_t y = 0; y < result.height; y++)
+		{
+			const float* rows[KaiserTaps];
+			for (unsigned int k = 0; k < KaiserTaps; k++)
+			{
+				const int sy = (std::min)((std::max)(static_cast<int>(y * 2) + firstTap + static_cast<int>(k), 0), static_cast<int>(horizontal.height) - 1);
+				rows[k] = horizontal.Row(static_cast<uint32_t>(sy));
+			}
+
+			float* output = result.Row(y);
+			for (uint32_t x = 0; x < result.width; x++)
+			{
+				Pixel sum = ZeroPixel();
+				for (unsigned int k = 0; k < KaiserTaps; k++)
+				{
+					sum = AddPixels(sum, ScalePixel(LoadPixel(rows[k] + x * 4), weights[k]));
+				}
+				StorePixel(output + x * 4, sum);
+			}
+		}
+	}
+
+	inline uint16_t ReadUint16(const uint8_t* p)
+	{
+		return static_cast<uint16_t>(p[0] | (p[1] << 8));
+	}
+}
+
+// Reads an uncompressed or RLE compressed TGA (8-bit grey, 24 or 32-bit colour).
+// Returns false if the data isn't a TGA it can read.
+bool LoadTga(const uint8_t* data, size_t size, TextureImage& image)
+{
+	const size_t headerSize = 18;
+	if (size < headerSize)
+	{
+		return false;
+	}
+
+	const uint8_t idLength = data[0];
+	const uint8_t colourMapType = data[1];
+	const uint8_t imageType = data[2];
+	const uint16_t width = ReadUint16(data + 12);
+	const uint16_t height = ReadUint16(data + 14);
+	const uint8_t bitsPerPixel = data[16];
+	const uint8_t descriptor = data[17];
+
+	// 2 and 10 are true colour, 3 and 11 greyscale, the higher ones RLE compressed
+	const bool rle = imageType == 10 || imageType == 11;
+	const bool grey = imageType == 3 || imageType == 11;
+	if (colourMapType != 0 || width == 0 || height == 0 ||
+		!(imageType == 2 || imageType == 3 || imageType == 10 || imageType == 11) ||
+		(grey ? bitsPerPixel != 8 : bitsPerPixel != 24 && bitsPerPixel != 32))
+	{
+		return false;
+	}
+
+	const unsigned int bytesPerPixel = bitsPerPixel / 8;
+	const size_t pixelCount = static_cast<size_t>(width) * height;
+	size_t position = headerSize + idLength;
+
+	// Unpack to BGR(A) or grey in file order
+	std::vector<uint8_t> pixels(pixelCount * bytesPerPixel);
+	if (!rle)
+	{
+		if (size - (std::min)(size, position) < pixels.size())
+		{
+			return false;
+		}
+		std::copy(data + position, data + position + pixels.size(), pixels.begin());
+	}
+	else
+	{
+		size_t written = 0;
+		while (written < pixels.size())
+		{
+			if (position >= size)
+			{
+				return false;
+			}
+
+			const uint8_t packet = data[position++];
+			const size_t count = (packet & 0x7F) + 1;
+			const bool repeat = (packet & 0x80) != 0;
+			const size_t bytes = count * bytesPerPixel;
+			const size_t needed = repeat ? bytesPerPixel : bytes;
+			if (size - position < needed || pixels.size() - written < bytes)
+			{
+				return false;
+			}
+
+			for (size_t i = 0; i < count; i++)
+			{
+				const uint8_t* source = data + position + (repeat ? 0 : i * bytesPerPixel);
+				std::copy(source, source + bytesPerPixel, pixels.begin() + written);
+				written += bytesPerPixel;
+			}
+			position += needed;
+		}
+	}
+
+	// Rows are bottom to top unless the descriptor says otherwise
+	const bool topToBottom = (descriptor & 0x20) != 0;
+	const bool rightToLeft = (descriptor & 0x10) != 0;
+
+	image.Resize(width, height);
+	for (uint32_t y = 0; y < height; y++)
+	{
+		const uint32_t sourceY = topToBottom ? y : height - 1 - y;
+		for (uint32_t x = 0; x < width; x++)
+		{
+			const uint32_t sourceX = rightToLeft ? width - 1 - x : x;
+			const uint8_t* source = &pixels[(static_cast<size_t>(sourceY) * width + sourceX) * bytesPerPixel];
+			uint8_t* destination = &image.rgba[(static_cast<size_t>(y) * width + x) * 4];
+			if (grey)
+			{
+				destination[0] = destination[1] = destination[2] = source[0];
+				destination[3] = 255;
+			}
+			else
+			{
+				destination[0] = source[2];
+				destination[1] = source[1];
+				destination[2] = source[0];
+				destination[3] = bytesPerPixel == 4 ? source[3] : 255;
+			}
+		}
+	}
+
+	return true;
+}
+
+// Builds the mips below the given image, down to 1x1. mips[0] is a copy of the image.
+// Alpha is always filtered as linear. Non power of two sizes round down at each level.
+void GenerateMipChain(const TextureImage& image, EMipFilter filter, bool srgb, std::vector<TextureImage>& mips)
+{
+	mips.clear();
+	mips.push_back(image);
+
+	FloatImage current;
+	FloatImage next;
+	ToFloatImage(image, srgb, current);
+
+	while (current.width > 1 || current.height > 1)
+	{
+		if (filter == MipFilter_Kaiser)
+		{
+			DownsampleKaiser(current, next);
+		}
+		else
+		{
+			DownsampleBox(current, next);
+		}
+
+		mips.push_back(TextureImage());
+		ToTextureImage(next, srgb, mips.back());
+		std::swap(current, next);
+	}
+}
+
+// Peak signal to noise ratio in dB over the first channelCount channels. 99 if they're identical.
+double ComputePsnr(const TextureImage& a, const TextureImage& b, unsigned int channelCount)
+{
+	if (a.width != b.width || a.height != b.height || channelCount == 0)
+	{
+		return 0.0;
+	}
+
+	const size_t pixelCount = static_cast<size_t>(a.width) * a.height;
+	uint64_t squaredError = 0;
+	for (size_t i = 0; i < pixelCount; i++)
+	{
+		for (unsigned int c = 0; c < channelCount; c++)
+		{
+			const int difference = static_cast<int>(a.rgba[i * 4 + c]) - static_cast<int>(b.rgba[i * 4 + c]);
+			squaredError += static_cast<uint64_t>(difference * difference);
+		}
+	}
+
+	if (squaredError == 0)
+	{
+		return 99.0;
+	}
+
+	const double meanSquaredError = static_cast<double>(squaredError) / (static_cast<double>(pixelCount) * channelCount);
+	return 10.0 * std::log10(255.0 * 255.0 / meanSquaredError);
+}
+
+float SrgbToLinear(uint8_t value)
+{
+	return GetSrgbTables().toLinear[value];
+}
+
+uint8_t LinearToSrgb(float value)
+{
+	value = (std::min)((std::max)(value, 0.0f), 1.0f);
+	return GetSrgbTables().fromLinear[static_cast<unsigned int>(value * LinearTableSize + 0.5f)];
+}
@@ -0,0 +1,53 @@
+// Texture images for the texture cooker
+// Images are 8-bit RGBA. Mip chains are filtered in linear light: sRGB images are converted
+// to linear floats, downsampled, and converted back, so dark and bright areas average the way
+// they look rather than darkening. Each level is made from the previous level's floats, so
+// rounding doesn't build up down the chain. The filters work on a whole RGBA pixel at once
+// with SSE where it's available.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#if !defined(TEXTURE_SIMD) && (defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__))
+#define TEXTURE_SIMD 1
+#endif
+
+struct TextureImage
+{
+	uint32_t width;
+	uint32_t height;
+	std::vector<uint8_t> rgba;	// Rows top to bottom, 4 bytes per pixel
+
+	TextureImage() : width(0), height(0) {}
+
+	void Resize(uint32_t newWidth, uint32_t newHeight)
+	{
+		width = newWidth;
+		height = newHeight;
+		rgba.assign(static_cast<size_t>(width) * height * 4, 0);
+	}
+};
+
+enum EMipFilter
+{
+	MipFilter_Box,		// Averages each 2x2 block. Fast, but a little blurry and prone to aliasing.
+	MipFilter_Kaiser	// Kaiser windowed sinc over 8x8 pixels. Sharper, with less aliasing.
+};
+
+// Reads an uncompressed or RLE compressed TGA (8-bit grey, 24 or 32-bit colour).
+// Returns false if the data isn't a TGA it can read.
+bool LoadTga(const uint8_t* data, size_t size, TextureImage& image);
+
+// Builds the mips below the given image, down to 1x1. mips[0] is a copy of the image.
+// Alpha is always filtered as linear. Non power of two sizes round down at each level.
+void GenerateMipChain(const TextureImage& image, EMipFilter filter, bool srgb, std::vector<TextureImage>& mips);
+
+// Peak signal to noise ratio in dB over the first channelCount channels. 99 if they're identical.
+double ComputePsnr(const TextureImage& a, const TextureImage& b, unsigned int channelCount);
+
+// sRGB conversions
+float SrgbToLinear(uint8_t value);
+uint8_t LinearToSrgb(float value);
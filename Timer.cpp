@@ -1,9 +1,9 @@
 #include "Timer.h"
 
 // Defualt constructor
-Timer::Timer() :
-	mSecondsPerCount(0.0),
-	mDeltaTime(-1.0),
+Timer::Timer(IClock* clock) :
+	mClock(clock ? clock : &mSystemClock),
+	mDeltaTime(0),
 	mBaseTime(0),
 	mPausedTime(0),
 	mStopTime(0),
@@ -11,42 +11,46 @@ Timer::Timer() :
 	mCurrTime(0),
 	mIsStopped(false)
 {
-	// Calculate the seconds per count using the frequency of the performance timer
-	__int64 countsPerSec;
-	QueryPerformanceFrequency((LARGE_INTEGER*)&countsPerSec);
-	mSecondsPerCount = 1.0 / (double)countsPerSec;
+	Reset();
 }
 
 // Returns total time elapsed since Reset() was called.
 // Does not include any time when the timer is stopped.
-float Timer::GetTotalTime() const
+double Timer::GetTotalTime() const
+{
+	return NanosecondsToSeconds(GetTotalTimeNanoseconds());
+}
+
+// Returns the time between frames
+float Timer::GetDeltaTime() const
+{
+	return static_cast<float>(NanosecondsToSeconds(mDeltaTime));
+}
+
+int64_t Timer::GetTotalTimeNanoseconds() const
 {
 	// Do not want to include any paused time - so subtract this from the count
 	if (mIsStopped)
 	{
-		return static_cast<float>((mStopTime - mBaseTime - mPausedTime) * mSecondsPerCount);
+		return mStopTime - mBaseTime - mPausedTime;
 	}
 	else
 	{
-		return static_cast<float>((mCurrTime - mBaseTime - mPausedTime) * mSecondsPerCount);
+		return mCurrTime - mBaseTime - mPausedTime;
 	}
 }
 
-// Returns the time between frames
-float Timer::GetDeltaTime() const
-{
-	return static_cast<float>(mDeltaTime);
-}
-
 // Resets the timer
 void Timer::Reset()
 {
-	__int64 currentTime;
-	QueryPerformanceCounter((LARGE_INTEGER*)&currentTime);
+	const int64_t currentTime = mClock->Now();
 
 	mBaseTime = currentTime;
 	mPrevTime = currentTime;
+	mCurrTime = currentTime;
+	mPausedTime = 0;
 	mStopTime = 0;
+	mDeltaTime = 0;
 	mIsStopped = false;
 }
 
@@ -54,8 +58,7 @@ void Timer::Reset()
 // Does nothing if called when the timer is not stopped
 void Timer::Start()
 {
-	__int64 startTime;
-	QueryPerformanceCounter((LARGE_INTEGER*)&startTime);
+	const int64_t startTime = mClock->Now();
 
 	if (mIsStopped)
 	{
@@ -74,10 +77,7 @@ void Timer::Stop()
 {
 	if (!mIsStopped)
 	{
-		__int64 currentTime;
-		QueryPerformanceCounter((LARGE_INTEGER*)&currentTime);
-
-		mStopTime = currentTime;
+		mStopTime = mClock->Now();
 		mIsStopped = true;
 	}
 }
@@ -87,25 +87,21 @@ void Timer::Tick()
 {
 	if (mIsStopped)
 	{
-		mDeltaTime = 0.0;
+		mDeltaTime = 0;
 		return;
 	}
 
-	__int64 currentTime;
-	QueryPerformanceCounter((LARGE_INTEGER*)&currentTime);
-	mCurrTime = currentTime;
+	mCurrTime = mClock->Now();
 
 	// Time difference between this frame and the previous.
-	mDeltaTime = (mCurrTime - mPrevTime) * mSecondsPerCount;
+	mDeltaTime = mCurrTime - mPrevTime;
 
 	// Prepare for next frame.
 	mPrevTime = mCurrTime;
 
 	// Force nonnegative
-	if (mDeltaTime < 0.0)
+	if (mDeltaTime < 0)
 	{
-		mDeltaTime = 0.0;
+		mDeltaTime = 0;
 	}
 }
-
-
@@ -1,19 +1,29 @@
 // Timer class - needed for frame stats
 // Based on Frank Luna's code from 3D Game programming with DirectX 12 pp. 131-139
+// Times are kept as integer nanoseconds from an IClock, so they don't lose precision over
+// long run times. Only converted to seconds when asked for.
 
 #pragma once
 
-#include <Windows.h>
+#include "Clock.h"
+
+#include <cstdint>
 
 class Timer
 {
 public:
-	// Constructors
-	Timer();
+	// Constructors - a null clock uses the system clock
+	explicit Timer(IClock* clock = nullptr);
+
+	// Prohibit copying, as it may point at its own clock
+	Timer(const Timer& rhs) = delete;
+	Timer& operator=(const Timer& rhs) = delete;
 
 	// Getters
-	float GetTotalTime() const; // in Seconds
+	double GetTotalTime() const; // in Seconds
 	float GetDeltaTime() const; // in Seconds
+	int64_t GetTotalTimeNanoseconds() const;
+	int64_t GetDeltaTimeNanoseconds() const { return mDeltaTime; }
 
 	// Timer control functions
 	void Reset();	// Call before message loop
@@ -22,16 +32,18 @@ public:
 	void Tick();	// Call every frame
 
 private:
-	// Frequency and time between frames
-	double mSecondsPerCount;
-	double mDeltaTime;
-
-	// Large integers used for precision
-	__int64 mBaseTime;
-	__int64 mPausedTime;
-	__int64 mStopTime;
-	__int64 mPrevTime;
-	__int64 mCurrTime;
+	SystemClock mSystemClock;
+	IClock* mClock;
+
+	// Time between frames
+	int64_t mDeltaTime;
+
+	// Clock times, in nanoseconds
+	int64_t mBaseTime;
+	int64_t mPausedTime;
+	int64_t mStopTime;
+	int64_t mPrevTime;
+	int64_t mCurrTime;
 
 	// To store the timer's state
 	bool mIsStopped;
@@ -15,6 +15,12 @@ int Win32Application::Run(DXSample* pSample, HINSTANCE hInstance, int nCmdShow)
 	pSample->ParseCommandLineArgs(argv, argCount);
 	LocalFree(argv);
 
+	// Bad arguments (e.g. an unknown benchmark scenario) have already been reported
+	if (pSample->GetExitCode() != 0)
+	{
+		return pSample->GetExitCode();
+	}
+
 	// Initialise the window class
 	WNDCLASSEX wcex = { 0 };
 	wcex.cbSize = sizeof(WNDCLASSEX);
@@ -52,7 +58,7 @@ int Win32Application::Run(DXSample* pSample, HINSTANCE hInstance, int nCmdShow)
 
 	// Start our timer here
 	Timer timer;
-	timer.Start();
+	timer.Reset();
 
 	// Main sample loop
 	MSG msg = {};
@@ -67,9 +73,12 @@ int Win32Application::Run(DXSample* pSample, HINSTANCE hInstance, int nCmdShow)
 		}
 		else // When no windows messages left to process then render & update our scene
 		{
-			// Update frame time
-			float frameTime = timer.GetDeltaTime();
-			pSample->OnUpdate(frameTime);
+			// Wait until it's time to start the frame
+			pSample->OnBeginFrame();
+
+			// Update frame time, then the simulation and frame
+			timer.Tick();
+			pSample->UpdateFrame(timer.GetDeltaTimeNanoseconds());
 
 			// Draw scene
 			pSample->OnRender();
@@ -106,7 +115,8 @@ LRESULT CALLBACK Win32Application::WndProc(HWND hWnd, UINT msg, WPARAM wParam, L
 	// Deal with window being closed
 	case WM_DESTROY:
 	{
-		PostQuitMessage(0);
+		// The exit code is returned from Run
+		PostQuitMessage(pSample ? pSample->GetExitCode() : 0);
 		return 0;
 	}
 	// Deal with window painting - where updating/rendering is done
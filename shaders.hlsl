@@ -1,25 +1,162 @@
 // Based on code by Microsoft
 // https://github.com/microsoft/DirectX-Graphics-Samples/blob/master/Samples/Desktop/D3D12HelloWorld/src/HelloTriangle/shaders.hlsl
 
+// Every object's constants, uploaded only when they change
+struct ObjectConstants
+{
+    float4x4 world;
+};
+StructuredBuffer<ObjectConstants> gObjectConstants : register(t1);
+
+// Set per draw as a root constant, picking the object's constants
+cbuffer DrawConstants : register(b0)
+{
+    uint gObjectIndex;
+};
+
+// Set once per pass as root constants, so objects' constants don't change with the camera
+cbuffer SceneConstants : register(b3)
+{
+    float4x4 gViewProj;
+    float2 gClusterScale;       // Pixels to clusters
+    float gSliceScale;          // A view depth's slice is log(depth) * scale + bias
+    float gSliceBias;
+    uint3 gClusterCount;
+    float gAmbient;
+};
+
+// Clustered lighting. The view is split into clusters, tiles of the screen cut into slices by
+// depth, and each has a list of the lights that reach it, rebuilt on the CPU every frame.
+#define LIGHT_TYPE_SPOT 1
+
+struct Light
+{
+    float3 position;
+    float range;
+    float3 direction;
+    float cosOuterAngle;
+    float3 colour;
+    uint type;
+};
+StructuredBuffer<Light> gLights : register(t2);
+StructuredBuffer<uint2> gClusterLights : register(t3);     // First index and count
+StructuredBuffer<uint> gLightIndices : register(t4);
+
 struct PSInput
 {
     float4 position : SV_POSITION;
     float4 color : COLOR;
 };
 
+struct ScenePSInput
+{
+    float4 position : SV_POSITION;
+    float4 color : COLOR;
+    float3 worldPosition : TEXCOORD0;
+    float viewDepth : TEXCOORD1;
+};
+
 // Simple Vertex shader
-PSInput VSMain(float4 position : POSITION, float4 color : COLOR)
+ScenePSInput VSMain(float4 position : POSITION, float4 color : COLOR)
 {
-    PSInput result;
+    ScenePSInput result;
     
-    result.position = position;
+    float4 worldPosition = mul(position, gObjectConstants[gObjectIndex].world);
+    result.position = mul(worldPosition, gViewProj);
     result.color = color;
+    result.worldPosition = worldPosition.xyz;
+    result.viewDepth = result.position.w;
     
     return result;
 }
 
-// Simple pixel shader
-float4 PSMain(PSInput input) : SV_TARGET
+// Lights the vertex colour with the lights in the pixel's cluster
+float4 PSMain(ScenePSInput input) : SV_TARGET
+{
+    // Triangles are flat, so their normal comes from how the position changes across the screen
+    float3 normal = normalize(cross(ddy(input.worldPosition), ddx(input.worldPosition)));
+
+    uint3 cluster;
+    cluster.xy = min(uint2(input.position.xy * gClusterScale), gClusterCount.xy - 1);
+    cluster.z = uint(clamp(log(input.viewDepth) * gSliceScale + gSliceBias, 0.0f, gClusterCount.z - 1));
+    uint2 lights = gClusterLights[(cluster.z * gClusterCount.y + cluster.y) * gClusterCount.x + cluster.x];
+
+    float3 lighting = gAmbient;
+    for (uint i = 0; i < lights.y; i++)
+    {
+        Light light = gLights[gLightIndices[lights.x + i]];
+        float3 toLight = light.position - input.worldPosition;
+        float lightDistance = length(toLight);
+        toLight /= lightDistance;
+
+        float attenuation = saturate(1.0f - lightDistance / light.range);
+        attenuation *= attenuation;
+        if (light.type == LIGHT_TYPE_SPOT)
+        {
+            attenuation *= smoothstep(light.cosOuterAngle, lerp(light.cosOuterAngle, 1.0f, 0.2f), dot(-toLight, light.direction));
+        }
+
+        // Triangles are lit from both sides
+        lighting += light.colour * attenuation * abs(dot(normal, toLight));
+    }
+
+    return float4(input.color.rgb * lighting, input.color.a);
+}
+
+// Debug HUD
+// Positions are in pixels, mapped to clip space by the root constants. The font atlas holds
+// each glyph's coverage, which scales the colour's alpha.
+cbuffer HudConstants : register(b1)
+{
+    float2 gHudScale;
+    float2 gHudOffset;
+};
+
+Texture2D gFontAtlas : register(t0);
+SamplerState gPointSampler : register(s0);
+
+struct HudPSInput
+{
+    float4 position : SV_POSITION;
+    float2 uv : TEXCOORD;
+    float4 color : COLOR;
+};
+
+HudPSInput HudVSMain(float2 position : POSITION, float2 uv : TEXCOORD, float4 color : COLOR)
+{
+    HudPSInput result;
+
+    result.position = float4(position * gHudScale + gHudOffset, 0.0f, 1.0f);
+    result.uv = uv;
+    result.color = color;
+
+    return result;
+}
+
+float4 HudPSMain(HudPSInput input) : SV_TARGET
+{
+    float4 color = input.color;
+    color.a *= gFontAtlas.Sample(gPointSampler, input.uv).r;
+    return color;
+}
+
+// Debug lines, in world space
+cbuffer DebugDrawConstants : register(b2)
+{
+    float4x4 gDebugViewProj;
+};
+
+PSInput DebugLineVSMain(float3 position : POSITION, float4 color : COLOR)
+{
+    PSInput result;
+
+    result.position = mul(float4(position, 1.0f), gDebugViewProj);
+    result.color = color;
+
+    return result;
+}
+
+float4 DebugLinePSMain(PSInput input) : SV_TARGET
 {
     return input.color;
 }